@@ -0,0 +1,154 @@
+/************************************************************************
+ * File: accessorbenchmark.cpp                                          *
+ * Project: AIPS                                                        *
+ * Description: Cost of the element accessors of CTypedData             *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+/**
+ * Measures how long it takes to write every voxel of a TImage through the
+ * access operators and iterators, compared to a loop over the raw array
+ * returned by getArray(). Each accessor is measured for an image which never
+ * was shared and for an image which was the source of a copy-on-write copy
+ * (see CTypedData::clone()) that has been destroyed again. The access
+ * operators don't check for shared data, so all columns should show about
+ * the same time.
+ *
+ * Usage: accessorbenchmark [edge length of the test volume] [repetitions]
+ */
+
+// Standard includes
+#include <cstdlib>  // atoi()
+#include <iomanip>  // setw()
+#include <iostream>
+#include <memory>   // auto_ptr
+
+// Boost includes
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+// AIPS includes
+#include <aipsnumeric.h>
+
+using namespace std;
+using namespace boost;
+using namespace aips;
+
+/** \returns wall clock time in seconds */
+static double now()
+{
+	static const posix_time::ptime start = posix_time::microsec_clock::universal_time();
+	return ( posix_time::microsec_clock::universal_time() - start ).total_microseconds() * 1.0e-6;
+}
+
+/// Sum of all voxels, printed so the compiler can't drop the loops
+static unsigned long ulChecksum = 0;
+
+/** Adds all voxels of the image to ulChecksum */
+static void addToChecksum( const TImage& anImage )
+{
+	const TImage::TDataType* dataPtr = &anImage[0];
+	for( size_t i = 0; i < anImage.getArraySize(); ++i )
+		ulChecksum += dataPtr[i];
+}
+
+/** Writes all voxels through a pointer to the data array */
+static void writeArray( TImage& anImage, const unsigned int uiRound )
+{
+	TImage::TDataType* dataPtr = anImage.getArray();
+	const size_t arraySize = anImage.getArraySize();
+	for( size_t i = 0; i < arraySize; ++i )
+		dataPtr[i] = static_cast<TImage::TDataType>( i + uiRound );
+}
+
+/** Writes all voxels through operator[] */
+static void writeIndex( TImage& anImage, const unsigned int uiRound )
+{
+	anImage.detach();
+	const size_t arraySize = anImage.getArraySize();
+	for( size_t i = 0; i < arraySize; ++i )
+		anImage[i] = static_cast<TImage::TDataType>( i + uiRound );
+}
+
+/** Writes all voxels through operator()( x, y, z ) */
+static void writeCoordinates( TImage& anImage, const unsigned int uiRound )
+{
+	anImage.detach();
+	const size_t extentX = anImage.getExtent( 0 );
+	const size_t extentY = anImage.getExtent( 1 );
+	const size_t extentZ = anImage.getExtent( 2 );
+	for( size_t z = 0; z < extentZ; ++z )
+		for( size_t y = 0; y < extentY; ++y )
+			for( size_t x = 0; x < extentX; ++x )
+				anImage( x, y, z ) = static_cast<TImage::TDataType>( x + y + z + uiRound );
+}
+
+/** Writes all voxels through an iterator */
+static void writeIterator( TImage& anImage, const unsigned int uiRound )
+{
+	size_t i = 0;
+	const TImage::iterator endIt = anImage.end();
+	for( TImage::iterator it = anImage.begin(); it != endIt; ++it, ++i )
+		*it = static_cast<TImage::TDataType>( i + uiRound );
+}
+
+/**
+ * \param writeFunction function writing all voxels of the image
+ * \param edgeLength edge length of the cubic test volume
+ * \param uiRepetitions number of times the image is written
+ * \param bShared if true, the image was the source of a copy-on-write copy
+ * \returns nanoseconds per voxel
+ */
+static double measure( void (*writeFunction)( TImage&, const unsigned int ), const size_t edgeLength,
+	const unsigned int uiRepetitions, const bool bShared )
+{
+	TImage theImage( 3, std::vector<size_t>( 3, edgeLength ) );
+	if ( bShared )
+	{
+		auto_ptr<CDataSet> copyPtr( theImage.clone() );
+	}
+	writeFunction( theImage, 0 );
+	const double startTime = now();
+	for( unsigned int i = 1; i <= uiRepetitions; ++i )
+		writeFunction( theImage, i );
+	const double elapsedTime = now() - startTime;
+	addToChecksum( theImage );
+	return elapsedTime * 1.0e9 / ( static_cast<double>( theImage.getArraySize() ) * uiRepetitions );
+}
+
+int main( int argc, char* argv[] )
+{
+	size_t edgeLength = 256;
+	unsigned int uiRepetitions = 10;
+	if ( argc > 1 )
+		edgeLength = static_cast<size_t>( atoi( argv[1] ) );
+	if ( argc > 2 )
+		uiRepetitions = static_cast<unsigned int>( atoi( argv[2] ) );
+	if ( edgeLength == 0 || uiRepetitions == 0 )
+	{
+		cerr << "Usage: " << argv[0] << " [edge length] [repetitions]" << endl;
+		return EXIT_FAILURE;
+	}
+	cout << "Volume " << edgeLength << "^3, " << uiRepetitions << " repetitions, nanoseconds per voxel write"
+		<< endl << endl;
+	cout << setw( 12 ) << "image" << setw( 12 ) << "getArray()" << setw( 12 ) << "operator[]"
+		<< setw( 12 ) << "operator()" << setw( 12 ) << "iterator" << endl;
+	for( int i = 0; i < 2; ++i )
+	{
+		const bool bShared = ( i == 1 );
+		cout << setw( 12 ) << ( bShared ? "was shared" : "own" ) << fixed << setprecision( 3 )
+			<< setw( 12 ) << measure( &writeArray, edgeLength, uiRepetitions, bShared )
+			<< setw( 12 ) << measure( &writeIndex, edgeLength, uiRepetitions, bShared )
+			<< setw( 12 ) << measure( &writeCoordinates, edgeLength, uiRepetitions, bShared )
+			<< setw( 12 ) << measure( &writeIterator, edgeLength, uiRepetitions, bShared ) << endl;
+	}
+	cout << endl << "Checksum " << ulChecksum << endl;
+	return EXIT_SUCCESS;
+}
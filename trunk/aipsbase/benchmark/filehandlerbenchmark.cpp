@@ -0,0 +1,187 @@
+/************************************************************************
+ * File: filehandlerbenchmark.cpp                                       *
+ * Project: AIPS                                                        *
+ * Description: Throughput benchmark for CBinaryFileHandler             *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+/**
+ * Measures how fast CBinaryFileHandler converts raw voxel data of every
+ * supported EDataType into datasets and back. The data is held in memory,
+ * so the numbers show the CPU cost of loading and saving, not the disk speed.
+ *
+ * Usage: filehandlerbenchmark [edge length of the test volume] [repetitions]
+ */
+
+// Standard includes
+#include <cstdlib>  // atoi()
+#include <iomanip>  // setw()
+#include <iostream>
+#include <sstream>
+
+// Boost includes
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+// AIPS includes
+#include <cbinaryfilehandler.h>
+
+using namespace std;
+using namespace boost;
+using namespace aips;
+
+/**
+ * Gives the benchmark access to the protected loading and saving methods
+ */
+class CBenchmarkHandler : public CBinaryFileHandler
+{
+public:
+	CBenchmarkHandler() throw()
+		: CBinaryFileHandler( "CBenchmarkHandler", "0.1", "CBinaryFileHandler" )
+	{
+	}
+	virtual TDataFile load( const std::string& ) const throw( FileException )
+	{
+		return TDataFile();
+	}
+	virtual void save( const std::string&, const TDataFile& ) const throw( FileException )
+	{
+	}
+	/// Runs load and save benchmarks for all voxel types
+	void run( const size_t edgeLength, const unsigned int uiRepetitions ) const throw( CException );
+private:
+	/// Runs load and save benchmarks for one voxel type and one byte order
+	void runType( const std::string& sTypeName, const EDataType theVoxelType,
+		const bool bFileEndianess, const size_t edgeLength, const unsigned int uiRepetitions ) const
+		throw( CException );
+};
+
+/** \returns wall clock time in seconds */
+static double now()
+{
+	static const posix_time::ptime start = posix_time::microsec_clock::universal_time();
+	return ( posix_time::microsec_clock::universal_time() - start ).total_microseconds() * 1.0e-6;
+}
+
+/**
+ * \param edgeLength edge length of the cubic test volume
+ * \param uiRepetitions number of loads and saves per voxel type
+ */
+void CBenchmarkHandler::run( const size_t edgeLength, const unsigned int uiRepetitions ) const
+	throw( CException )
+{
+	cout << "Volume " << edgeLength << "^3, " << uiRepetitions << " repetitions, throughput in MB/s of file data"
+		<< endl << endl;
+	cout << setw( 10 ) << "type" << setw( 8 ) << "order" << setw( 10 ) << "dataset"
+		<< setw( 12 ) << "load" << setw( 12 ) << "save" << endl;
+	const bool orderArr[2] = { false, true };
+	for( int i = 0; i < 2; ++i )
+	{
+		runType( "DInt8", DInt8, orderArr[i], edgeLength, uiRepetitions );
+		runType( "DInt16", DInt16, orderArr[i], edgeLength, uiRepetitions );
+		runType( "DInt32", DInt32, orderArr[i], edgeLength, uiRepetitions );
+		runType( "DUInt8", DUInt8, orderArr[i], edgeLength, uiRepetitions );
+		runType( "DUInt16", DUInt16, orderArr[i], edgeLength, uiRepetitions );
+		runType( "DUInt32", DUInt32, orderArr[i], edgeLength, uiRepetitions );
+		runType( "DFloat16", DFloat16, orderArr[i], edgeLength, uiRepetitions );
+		runType( "DFloat32", DFloat32, orderArr[i], edgeLength, uiRepetitions );
+	}
+}
+
+/**
+ * Integer types are loaded into a TImage, floating point types into a TField
+ * (like the ANALYZE handler does).
+ * \param sTypeName name of the voxel type for the output
+ * \param theVoxelType voxel type of the file data
+ * \param bFileEndianess true if the file data is big endian
+ * \param edgeLength edge length of the cubic test volume
+ * \param uiRepetitions number of loads and saves
+ */
+void CBenchmarkHandler::runType( const std::string& sTypeName, const EDataType theVoxelType,
+	const bool bFileEndianess, const size_t edgeLength, const unsigned int uiRepetitions ) const
+	throw( CException )
+{
+	const bool bFloat = ( theVoxelType == DFloat16 || theVoxelType == DFloat32 );
+	std::vector<size_t> extentVec( 3, edgeLength );
+	TDataSetPtr dataSPtr;
+	if ( bFloat )
+	{
+		TFieldPtr fieldSPtr( new TField( 3, extentVec ) );
+		for( size_t i = 0; i < fieldSPtr->getArraySize(); ++i )
+			(*fieldSPtr)[i] = static_cast<TFloatType>( i % 251 ) * 0.5;
+		dataSPtr = fieldSPtr;
+	}
+	else
+	{
+		TImagePtr imageSPtr( new TImage( 3, extentVec ) );
+		for( size_t i = 0; i < imageSPtr->getArraySize(); ++i )
+			(*imageSPtr)[i] = static_cast<TImage::TDataType>( i % 127 );
+		dataSPtr = imageSPtr;
+	}
+
+	// Create the file data once, then measure saving and loading
+	ostringstream theOutput;
+	saveData( dataSPtr, theOutput, theVoxelType, bFileEndianess );
+	const string sFileData = theOutput.str();
+	const double megaBytes = sFileData.size() / ( 1024.0 * 1024.0 );
+
+	double startTime = now();
+	for( unsigned int i = 0; i < uiRepetitions; ++i )
+	{
+		ostringstream theFile;
+		saveData( dataSPtr, theFile, theVoxelType, bFileEndianess );
+	}
+	const double saveTime = now() - startTime;
+
+	double loadTime = 0.0;
+	for( unsigned int i = 0; i < uiRepetitions; ++i )
+	{
+		istringstream theFile( sFileData );
+		TDataSetPtr targetSPtr;
+		if ( bFloat )
+			targetSPtr.reset( new TField( 3, extentVec ) );
+		else
+			targetSPtr.reset( new TImage( 3, extentVec ) );
+		startTime = now();
+		loadData( targetSPtr, theFile, theVoxelType, bFileEndianess );
+		loadTime += now() - startTime;
+	}
+
+	cout << setw( 10 ) << sTypeName << setw( 8 ) << ( bFileEndianess ? "big" : "little" )
+		<< setw( 10 ) << ( bFloat ? "TField" : "TImage" ) << fixed << setprecision( 1 )
+		<< setw( 12 ) << megaBytes * uiRepetitions / loadTime
+		<< setw( 12 ) << megaBytes * uiRepetitions / saveTime << endl;
+}
+
+int main( int argc, char* argv[] )
+{
+	size_t edgeLength = 256;
+	unsigned int uiRepetitions = 5;
+	if ( argc > 1 )
+		edgeLength = static_cast<size_t>( atoi( argv[1] ) );
+	if ( argc > 2 )
+		uiRepetitions = static_cast<unsigned int>( atoi( argv[2] ) );
+	if ( edgeLength == 0 || uiRepetitions == 0 )
+	{
+		cerr << "Usage: " << argv[0] << " [edge length] [repetitions]" << endl;
+		return EXIT_FAILURE;
+	}
+	try
+	{
+		CBenchmarkHandler theHandler;
+		theHandler.run( edgeLength, uiRepetitions );
+	}
+	catch( CException& e )
+	{
+		cerr << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
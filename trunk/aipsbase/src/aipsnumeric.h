@@ -34,6 +34,7 @@
  *                    floating point type                               *
  *        2005-11-15 Moved vector class definitions to aipsvectordefs.h *
  *        2006-05-23 Added missing implementation of round<>()          *
+ *        2026-10-17 Added swapEndianess() for whole arrays             *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -47,6 +48,7 @@
 // Standard library includes
 #include <cmath>    // floor(), sqrt()
 #include <complex>  // complex<>
+#include <cstring>  // memcpy()
 
 // AIPS includes
 #include "ctypeddata.h"
@@ -136,6 +138,10 @@ const TVector3D VEC_ZERO3D; ///< Zero vector for three dimensions
 /// Swaps the bytes of a data type from little to big endian and vice versa
 template<typename T> inline void swapEndianess( T& value ) 
 	throw();
+
+/// Swaps the bytes of all elements of an array of scalar values
+template<typename T> inline void swapEndianess( T* valueArr, const size_t numberOfValues )
+	throw();
 	
 #ifndef __GLIBCPP__
 /// Templated version of abs ( compute absolute value )
@@ -23,6 +23,55 @@ template<typename T> inline void swapEndianess( T& value ) throw()
   std::reverse( itBegin, itEnd );
 }
 
+/**
+ * The bytes are reordered with shifts on unsigned integers of the same size,
+ * which the compiler can translate into vector instructions.
+ * \param valueArr array of data to swap (will be overwritten)
+ * \param numberOfValues number of array elements
+ */
+template<typename T> inline void swapEndianess( T* valueArr, const size_t numberOfValues ) throw()
+{
+	unsigned char* bytePtr = reinterpret_cast<unsigned char*>( valueArr );
+	switch( sizeof( T ) )
+	{
+		case 1:
+			break;
+		case 2:
+			for( size_t i = 0; i < numberOfValues; ++i, bytePtr += 2 )
+			{
+				boost::uint16_t v;
+				memcpy( &v, bytePtr, 2 );
+				v = static_cast<boost::uint16_t>( ( v >> 8 ) | ( v << 8 ) );
+				memcpy( bytePtr, &v, 2 );
+			}
+			break;
+		case 4:
+			for( size_t i = 0; i < numberOfValues; ++i, bytePtr += 4 )
+			{
+				boost::uint32_t v;
+				memcpy( &v, bytePtr, 4 );
+				v = ( v >> 24 ) | ( ( v >> 8 ) & 0x0000FF00U ) | ( ( v << 8 ) & 0x00FF0000U ) | ( v << 24 );
+				memcpy( bytePtr, &v, 4 );
+			}
+			break;
+		case 8:
+			for( size_t i = 0; i < numberOfValues; ++i, bytePtr += 8 )
+			{
+				boost::uint32_t lo, hi;
+				memcpy( &lo, bytePtr, 4 );
+				memcpy( &hi, bytePtr + 4, 4 );
+				lo = ( lo >> 24 ) | ( ( lo >> 8 ) & 0x0000FF00U ) | ( ( lo << 8 ) & 0x00FF0000U ) | ( lo << 24 );
+				hi = ( hi >> 24 ) | ( ( hi >> 8 ) & 0x0000FF00U ) | ( ( hi << 8 ) & 0x00FF0000U ) | ( hi << 24 );
+				memcpy( bytePtr, &hi, 4 );
+				memcpy( bytePtr + 4, &lo, 4 );
+			}
+			break;
+		default:
+			for( size_t i = 0; i < numberOfValues; ++i )
+				swapEndianess( valueArr[i] );
+	}
+}
+
 /**
  * Specialization of the function template for TVector2D type
  * \param value data to swap (will be overwritten)
@@ -0,0 +1,59 @@
+/************************************************************************
+ * File: aipsparallel.h                                                 *
+ * Project: AIPS                                                        *
+ * Description: Data parallel loops for filters                         *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Version: 0.1                                                         *
+ * Status : Beta                                                        *
+ * Created: 2026-10-17                                                  *
+ * Changed: 2026-10-17 Ranges run on the shared thread pool              *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#ifndef AIPSPARALLEL_H
+#define AIPSPARALLEL_H
+
+// Standard includes
+#include <algorithm> // std::min
+
+// Boost includes
+#include <boost/bind.hpp>
+
+// AIPS includes
+#include "cpipelineitem.h"
+#include "cthreadpool.h"
+
+namespace aips {
+
+/**
+ * Splits the items [0, itemCount) into one contiguous range per thread and calls
+ * the given method of the worker for each range. The number of ranges is
+ * CPipelineItem::getNumberOfThreads(). The calling thread processes ranges itself
+ * and is only helped by threads of the global CThreadPool which are not busy with
+ * other pipeline items, so nested calls never exceed the configured thread count.
+ * The method must be safe to be called concurrently for disjoint ranges.
+ * \param theWorker object holding the data of the loop
+ * \param rangePtr method processing the items [first argument, second argument)
+ * \param itemCount number of items (e.g. slices)
+ */
+template<typename TWorker> void parallelFor( const TWorker& theWorker,
+	void ( TWorker::*rangePtr )( const size_t, const size_t ) const, const size_t itemCount ) throw()
+{
+	const size_t threadCount = std::min<size_t>( CPipelineItem::getNumberOfThreads(), itemCount );
+	if ( threadCount <= 1 )
+	{
+		( theWorker.*rangePtr )( 0, itemCount );
+		return;
+	}
+	getThreadPool().runRanges( boost::bind( rangePtr, &theWorker, _1, _2 ), itemCount, threadCount );
+}
+
+}
+
+#endif
@@ -14,6 +14,7 @@
  ************************************************************************/
 
 #include "cbinaryfilehandler.h"
+#include <algorithm>
 
 using namespace std;
 using namespace boost;
@@ -42,165 +43,237 @@ CBinaryFileHandler::~CBinaryFileHandler() throw()
  * Other methods *
  *****************/
 
+/** Number of file voxels converted at once by loadSpecificType() and saveSpecificType() */
+static const size_t BINARY_SLAB_VOXELS = 65536;
+
+/**
+ * \param theFile input stream
+ * \param targetPtr destination buffer
+ * \param numberOfBytes number of bytes to read
+ * \throws FileException if the stream ends too early
+ */
+static void readBlock( istream& theFile, char* targetPtr, const size_t numberOfBytes )
+	throw( FileException )
+{
+	theFile.read( targetPtr, numberOfBytes );
+	if ( theFile.gcount() != static_cast<streamsize>( numberOfBytes ) )
+	{
+		ostringstream os;
+		os << "Image data seems to be corrupted. Image not loaded." << " Loaded "
+			<< theFile.gcount() << " bytes, but should be " << numberOfBytes << " bytes";
+		throw ( FileException( SERROR( os.str().c_str() ), CException::RECOVER, ERR_FILEACCESS ) );
+	}
+}
+
 /**
+ * \param theFile output stream
+ * \param sourcePtr source buffer
+ * \param numberOfBytes number of bytes to write
+ * \throws FileException on any write error
+ */
+static void writeBlock( ostream& theFile, const char* sourcePtr, const size_t numberOfBytes )
+	throw( FileException )
+{
+	theFile.write( sourcePtr, numberOfBytes );
+	if ( !theFile.good() ) // something went wrong
+	{
+		throw ( FileException( SERROR(
+			"Error occured on saving file. Image not saved..." ),
+			CException::RECOVER, ERR_FILEACCESS ) );
+	}
+}
+
+/**
+ * Computes minimum and maximum of the whole data array in one pass and sets the
+ * data range accordingly.
+ * \param theDataSPtr the dataset
+ */
+template<typename SetType>
+static void computeDataRange( shared_ptr<SetType> theDataSPtr ) throw()
+{
+	typedef typename SetType::TDataType TValue;
+	const SetType& theData = *theDataSPtr;
+	const size_t arraySize = theData.getArraySize();
+	if ( arraySize == 0 )
+		return;
+	const TValue* dataPtr = &theData[0];
+	TValue theMinimum = dataPtr[0];
+	TValue theMaximum = dataPtr[0];
+	for( size_t i = 1; i < arraySize; ++i )
+	{
+		theMinimum = std::min( theMinimum, dataPtr[i] );
+		theMaximum = std::max( theMaximum, dataPtr[i] );
+	}
+	theDataSPtr->setDataRange( theMinimum, theMaximum );
+}
+
+/**
+ * If DataType equals the data type of the set, the whole file is read straight into
+ * the data array. Otherwise the file is read in slabs of BINARY_SLAB_VOXELS voxels
+ * which are converted at once. The data range is computed afterwards.
  * \param theTargetDataSPtr pointer to target dataset
  * \param theFile input stream (file needs to be already opened)
  * \param bFileEndianess true == data is big endian, false == little endian (intel)
- * \param theVoxelSize size of one voxel (in bytes)
+ * \param theVoxelSize size of one voxel (in bytes). Ignored, sizeof( DataType ) is used.
  * \throws FileException on any file error 
  */
 template<typename SetType, typename DataType> 
 void CBinaryFileHandler::loadSpecificType( shared_ptr<SetType> theTargetDataSPtr, istream& theFile,
-	const bool bFileEndianess, const size_t theVoxelSize ) const throw( FileException )
+	const bool bFileEndianess, const size_t /*theVoxelSize*/ ) const throw( FileException )
 {
 FBEGIN;
-	std::vector<unsigned char> scanline;
-  size_t scanlineSize = theTargetDataSPtr->getExtent(0) * theVoxelSize;
-  scanline.resize( scanlineSize );
-	typename SetType::iterator it = theTargetDataSPtr->begin();
-	typename SetType::iterator end = theTargetDataSPtr->end();
-	theTargetDataSPtr->setMaximum( numeric_limits<typename SetType::TDataType>::min() );
-	theTargetDataSPtr->setMinimum( numeric_limits<typename SetType::TDataType>::max() );
+	typedef typename SetType::TDataType TValue;
 DBG1( "Loading into dataset with dimensions " << theTargetDataSPtr->getExtent(0) << " x " 
 	<< theTargetDataSPtr->getExtent(1) << " x " << theTargetDataSPtr->getExtent(2) );
-	
-	while( it != end )
+	const size_t arraySize = theTargetDataSPtr->getArraySize();
+	if ( arraySize == 0 )
+		return;
+	TValue* targetPtr = theTargetDataSPtr->getArray();
+	if ( is_same<TValue, DataType>::value )
 	{
-		theFile.read( (char*)( &( scanline[0] ) ), scanlineSize );
-    if ( theFile.gcount() != static_cast<long>( scanlineSize ) )
-    {
-			ostringstream os;
-     	os << "Image data seems to be corrupted. Image not loaded." << " Loaded "
-				<< theFile.gcount() << " bytes, but should be " << scanlineSize << " bytes";
-      throw ( FileException( SERROR( os.str().c_str() ), CException::RECOVER, ERR_FILEACCESS ) );
-    }
-		size_t scanlineIndex = 0;
-		while( scanlineIndex < scanline.size() )
+		readBlock( theFile, reinterpret_cast<char*>( targetPtr ), arraySize * sizeof( DataType ) );
+		if ( bFileEndianess )
+			swapEndianess( targetPtr, arraySize );
+	}
+	else
+	{
+		std::vector<DataType> slab( std::min( arraySize, BINARY_SLAB_VOXELS ) );
+		for( size_t slabStart = 0; slabStart < arraySize; slabStart += slab.size() )
 		{
-			if ( it == end )
-			{
-				ostringstream os;
-   	  	os << "Image data seems to be corrupted. Image not loaded." << " Loaded "
-					<< theFile.gcount() << " bytes, but should be " << scanlineSize << " bytes";
-	      throw ( FileException( SERROR( os.str().c_str() ), CException::RECOVER, ERR_FILEACCESS ) );
-			}
-			DataType value;
-			memcpy( &value, &scanline[scanlineIndex], sizeof( DataType ) );
-			if ( bFileEndianess ) 
-				swapEndianess( value );
-			*it = static_cast<typename SetType::TDataType>( value ); 
-			scanlineIndex += sizeof( DataType );
-			theTargetDataSPtr->adjustDataRange( *it );
-			++it;
+			const size_t slabSize = std::min( slab.size(), arraySize - slabStart );
+			readBlock( theFile, reinterpret_cast<char*>( &slab[0] ), slabSize * sizeof( DataType ) );
+			if ( bFileEndianess )
+				swapEndianess( &slab[0], slabSize );
+			TValue* slabTargetPtr = targetPtr + slabStart;
+			for( size_t i = 0; i < slabSize; ++i )
+				slabTargetPtr[i] = static_cast<TValue>( slab[i] );
 		}
 	}
+	computeDataRange( theTargetDataSPtr );
 FEND;	
 }
 
 /**
+ * If DataType equals the data type of the set and no byte swapping is needed, the
+ * data array is written straight to the file. Otherwise it is converted and written in
+ * slabs of BINARY_SLAB_VOXELS voxels.
  * \param theSourceDataSPtr pointer to source dataset
  * \param theFile output stream (file needs to be already opened)
  * \param bFileEndianess true == data is big endian, false == little endian (intel)
- * \param theVoxelSize size of one voxel (in bytes)
+ * \param theVoxelSize size of one voxel (in bytes). Ignored, sizeof( DataType ) is used.
  * \throws FileException on any file error 
  */
 template<typename SetType, typename DataType> 
 void CBinaryFileHandler::saveSpecificType( shared_ptr<SetType> theSourceDataSPtr, ostream& theFile,
-	const bool bFileEndianess, const size_t theVoxelSize ) const throw( FileException )
+	const bool bFileEndianess, const size_t /*theVoxelSize*/ ) const throw( FileException )
 {
 FBEGIN;	
-	std::vector<unsigned char> scanline;	
-  size_t scanlineSize = theSourceDataSPtr->getExtent(0) * theVoxelSize;
-  scanline.resize( scanlineSize );
   typedef typename SetType::TDataType SetDataType;
-	typename SetType::iterator it = theSourceDataSPtr->begin();
-	typename SetType::iterator end = theSourceDataSPtr->end();
 DBG1( "Saving dataset with dimensions " << theSourceDataSPtr->getExtent(0) << " x " 
 	<< theSourceDataSPtr->getExtent(1) << " x " << theSourceDataSPtr->getExtent(2) );
-	while( it != end )
-	{					
-		size_t scanlineIndex = 0;
-		while( scanlineIndex < scanline.size() && it != end )
+	const SetType& theSource = *theSourceDataSPtr;
+	const size_t arraySize = theSource.getArraySize();
+	if ( arraySize == 0 )
+		return;
+	const SetDataType* sourcePtr = &theSource[0];
+	if ( is_same<SetDataType, DataType>::value && !bFileEndianess )
+	{
+		writeBlock( theFile, reinterpret_cast<const char*>( sourcePtr ), arraySize * sizeof( DataType ) );
+	}
+	else
+	{
+		std::vector<DataType> slab( std::min( arraySize, BINARY_SLAB_VOXELS ) );
+		for( size_t slabStart = 0; slabStart < arraySize; slabStart += slab.size() )
 		{
-			DataType value;
-			value = static_cast<DataType>( *it );
-			if ( bFileEndianess ) 
-				swapEndianess( value );
-			memcpy( &scanline[scanlineIndex], &value, sizeof( DataType ) );
-			scanlineIndex += sizeof( DataType );
-			++it;		
+			const size_t slabSize = std::min( slab.size(), arraySize - slabStart );
+			const SetDataType* slabSourcePtr = sourcePtr + slabStart;
+			for( size_t i = 0; i < slabSize; ++i )
+				slab[i] = static_cast<DataType>( slabSourcePtr[i] );
+			if ( bFileEndianess )
+				swapEndianess( &slab[0], slabSize );
+			writeBlock( theFile, reinterpret_cast<const char*>( &slab[0] ), slabSize * sizeof( DataType ) );
 		}
-		theFile.write( (char*)( &( scanline[0] ) ), scanlineSize );
-    if ( !theFile.good() ) // something went wrong
-    {
-      throw ( FileException( SERROR(
-        "Error occured on saving file. Image not saved..." ), 
-        CException::RECOVER, ERR_FILEACCESS ) );
-    }		
 	}
 FEND;	
 }
 
+/**
+ * \param sFilename name of the data file
+ * \param extentVec extents of the new dataset
+ * \param fileOffset position of the first voxel in the file (in bytes)
+ * \param bComputeRange if true, the data range of the new dataset is computed.
+ *   This reads the whole file once, but never copies it.
+ * \returns the new dataset or an empty pointer if the file cannot be mapped
+ */
+template<typename SetType>
+shared_ptr<SetType> CBinaryFileHandler::mapSpecificType( const std::string& sFilename,
+	const std::vector<size_t>& extentVec, const size_t fileOffset, const bool bComputeRange ) const throw()
+{
+	typedef typename SetType::TDataType TValue;
+	size_t arraySize = 1;
+	for( size_t i = 0; i < extentVec.size(); ++i )
+		arraySize *= extentVec[i];
+	if ( arraySize == 0 || fileOffset % sizeof( TValue ) != 0 )
+		return shared_ptr<SetType>();
+	shared_ptr<CMappedFile> mappedFileSPtr;
+	try
+	{
+		mappedFileSPtr.reset( new CMappedFile( sFilename ) );
+	}
+	catch( FileException& e )
+	{
+		alog << LWARN << "Could not map data file: " << e.what() << endl;
+		return shared_ptr<SetType>();
+	}
+	// Let the stream loader report truncated files
+	if ( mappedFileSPtr->getSize() < fileOffset + arraySize * sizeof( TValue ) )
+		return shared_ptr<SetType>();
+	shared_ptr<CDataBlock<TValue> > blockSPtr(
+		new CDataBlock<TValue>( mappedFileSPtr, fileOffset, arraySize ) );
+	shared_ptr<SetType> targetSPtr( new SetType( extentVec.size(), extentVec, 1, blockSPtr ) );
+	if ( bComputeRange )
+		computeDataRange( targetSPtr );
+	else if ( numeric_limits<TValue>::is_integer )
+		targetSPtr->setDataRange( numeric_limits<TValue>::min(), numeric_limits<TValue>::max() );
+	else
+		targetSPtr->setDataRange( -numeric_limits<TValue>::max(), numeric_limits<TValue>::max() );
+DBG1( "Mapped " << sFilename << " with " << arraySize << " voxels" );
+	return targetSPtr;
+}
 
 /**
  * Template specialization for 3D vector fields
  * \param theTargetDataSPtr pointer to source dataset
  * \param theFile output stream (file needs to be already opened)
  * \param bFileEndianess true == data is big endian, false == little endian (intel)
- * \param theVoxelSize size of one voxel (in bytes)
+ * \param theVoxelSize size of one voxel (in bytes). Ignored, sizeof( TVector3D ) is used.
  * \throws FileException on any file error 
  */
 template<>
-void CBinaryFileHandler::loadSpecificType<TField3D, TFloatType>( TField3DPtr theTargetDataSPtr, 		istream& theFile,	const bool bFileEndianess, const size_t theVoxelSize ) 
+void CBinaryFileHandler::loadSpecificType<TField3D, TFloatType>( TField3DPtr theTargetDataSPtr, 		istream& theFile,	const bool bFileEndianess, const size_t /*theVoxelSize*/ ) 
 	const throw( FileException )
 {
 FBEGIN;
-	std::vector<unsigned char> scanline;
-  size_t scanlineSize = theTargetDataSPtr->getExtent(0) * sizeof( TVector3D );
-  scanline.resize( scanlineSize );
-	TField3D::iterator it = theTargetDataSPtr->begin();
-	TField3D::iterator end = theTargetDataSPtr->end();
 	TVector3D One( 1.0, 1.0, 1.0 );
 	theTargetDataSPtr->setMaximum( VEC_ZERO3D );
 	theTargetDataSPtr->setMinimum( One );
 DBG( "Loading into dataset with dimensions " << theTargetDataSPtr->getExtent(0) << " x " 
 	<< theTargetDataSPtr->getExtent(1) << " x " << theTargetDataSPtr->getExtent(2) );
-	
-	while( it != end )
-	{
-		theFile.read( (char*)( &( scanline[0] ) ), scanlineSize );
-    if ( theFile.gcount() != static_cast<long>( scanlineSize ) )
-    {
-			ostringstream os;
-     	os << "Image data seems to be corrupted. Image not loaded." << " Loaded "
-				<< theFile.gcount() << " bytes, should be " << scanlineSize;
-      throw ( FileException( SERROR( os.str().c_str() ), CException::RECOVER, ERR_FILEACCESS ) );
-    }
-		size_t scanlineIndex = 0;
-		while( scanlineIndex < scanline.size() )
-		{
-			if ( it == end )
-			{
-				ostringstream os;
-   	  	os << "Image data seems to be corrupted. Image not loaded." << " Loaded "
-					<< theFile.gcount() << " bytes, should be " << scanlineSize;
-	      throw ( FileException( SERROR( os.str().c_str() ), CException::RECOVER, ERR_FILEACCESS ) );
-			}
-			TVector3D value;
-			memcpy( &(*it), &scanline[scanlineIndex], sizeof( TVector3D ) );
-			if ( bFileEndianess ) 
-				swapEndianess( *it );
-			scanlineIndex += sizeof( TVector3D );
-			++it;
-		}
-	}
+	const size_t arraySize = theTargetDataSPtr->getArraySize();
+	if ( arraySize == 0 )
+		return;
+	TVector3D* targetPtr = theTargetDataSPtr->getArray();
+	readBlock( theFile, reinterpret_cast<char*>( targetPtr ), arraySize * sizeof( TVector3D ) );
+	if ( bFileEndianess ) 
+		for( size_t i = 0; i < arraySize; ++i )
+			swapEndianess( targetPtr[i] );
 FEND;	
 }
 
 template<>
 void CBinaryFileHandler::saveSpecificType<TField3D, TFloatType>
 	( TField3DPtr theSourceDataSPtr, ostream& theFile, const bool bFileEndianess, 
-	const size_t theVoxelSize ) const throw( FileException )
+	const size_t /*theVoxelSize*/ ) const throw( FileException )
 {
 FBEGIN;
 	std::vector<unsigned char> scanline;
@@ -216,7 +289,7 @@ DBG1( "Saving dataset with dimensions " << theSourceDataSPtr->getExtent(0) << "
 		size_t scanlineIndex = 0;
 		while( scanlineIndex < scanline.size() && it != end )
 		{
-			TVector3D& value =  *it;
+			TVector3D value = *it;
 			if ( bFileEndianess ) 
 				swapEndianess( value );
 			memcpy( &scanline[scanlineIndex], &value, sizeof( TVector3D ) );
@@ -337,6 +410,224 @@ DBG( "Reading into dataset with dimensions " << theTargetDataAPtr->getExtent(0)
 FEND;
 }
 
+/**
+ * The dataset is created without reading the file: Its data block refers to a
+ * private (copy-on-write) memory mapping of the file, and pages are read from
+ * disk when they are accessed for the first time. This is only possible if the
+ * voxels in the file are stored exactly like in the dataset loadData() would
+ * create, i.e. 16 bit integers (signed or unsigned) for TImage and floating point
+ * values of the size of TFloatType for TField, in native byte order.
+ * \param sFilename name of the (uncompressed) data file
+ * \param extentVec extents of the new dataset
+ * \param theVoxelType type of a voxel
+ * \param bFileEndianess true data is big endian, false if it is little endian (intel)
+ * \param fileOffset position of the first voxel in the file (in bytes)
+ * \param bComputeRange if true, the data range of the new dataset is computed.
+ *   This reads the whole file, so pass false and set the range from the header
+ *   if possible. Otherwise the range is set to the limits of the voxel type.
+ * \returns the new dataset (TImage or TField) or an empty pointer if the file cannot
+ *   be mapped. In the latter case, use loadData() instead.
+ */
+TDataSetPtr CBinaryFileHandler::mapData( const std::string& sFilename, const std::vector<size_t>& extentVec,
+	const EDataType theVoxelType, const bool bFileEndianess, const size_t fileOffset,
+	const bool bComputeRange ) const throw()
+{
+	// loadData() swaps the bytes of big endian files
+	if ( bFileEndianess )
+		return TDataSetPtr();
+	switch( theVoxelType )
+	{
+		case DInt16:
+		case DUInt16: // loadData() casts unsigned to signed values, which keeps the bit pattern
+			return mapSpecificType<TImage>( sFilename, extentVec, fileOffset, bComputeRange );
+		case DFloat16:
+			if ( sizeof( TFloatType ) == sizeof( float ) )
+				return mapSpecificType<TField>( sFilename, extentVec, fileOffset, bComputeRange );
+			break;
+		case DFloat32:
+			if ( sizeof( TFloatType ) == sizeof( double ) )
+				return mapSpecificType<TField>( sFilename, extentVec, fileOffset, bComputeRange );
+			break;
+		default:
+			break;
+	}
+	return TDataSetPtr();
+}
+
+/**
+ * \param extentVec extents of the complete dataset
+ * \param regionOriginVec first voxel of the region
+ * \param regionExtentVec extents of the region
+ * \returns true if the region lies inside the dataset and covers all but its last
+ *   dimension completely, i.e. if it is stored without gaps in a binary file
+ */
+bool CBinaryFileHandler::isSlab( const std::vector<size_t>& extentVec,
+	const std::vector<size_t>& regionOriginVec, const std::vector<size_t>& regionExtentVec ) throw()
+{
+	if ( extentVec.empty() || regionOriginVec.size() != extentVec.size()
+		|| regionExtentVec.size() != extentVec.size() )
+		return false;
+	const size_t lastDimension = extentVec.size() - 1;
+	for( size_t i = 0; i < lastDimension; ++i )
+		if ( regionOriginVec[i] != 0 || regionExtentVec[i] != extentVec[i] )
+			return false;
+	return regionExtentVec[lastDimension] > 0
+		&& regionOriginVec[lastDimension] + regionExtentVec[lastDimension] <= extentVec[lastDimension];
+}
+
+/**
+ * \param theDataSPtr the slab dataset (single channel)
+ * \param theVoxelSize size of a scalar voxel in the file (in bytes)
+ * \param extentVec extents of the complete dataset
+ * \returns the number of bytes of one slice along the last dimension in the file
+ * \throws NullException if the dataset has more than one channel
+ */
+static size_t fileSliceSize( TDataSetPtr theDataSPtr, const size_t theVoxelSize,
+	const std::vector<size_t>& extentVec ) throw( NullException )
+{
+	// Channels are stored one after another, so a slab of several channels is not contiguous
+	if ( theDataSPtr->getDataDimension() != 1 )
+		throw ( NullException( SERROR( "Regions can only be transferred for single channel datasets" ),
+			CException::RECOVER, ERR_UNKNOWNTYPE ) );
+	// Vector fields are always transferred as TVector3D by loadData() and saveData()
+	size_t sliceSize = theVoxelSize;
+	if ( checkType<TField3D>( theDataSPtr ) )
+		sliceSize = sizeof( TVector3D );
+	for( size_t i = 0; i + 1 < extentVec.size(); ++i )
+		sliceSize *= extentVec[i];
+	return sliceSize;
+}
+
+/**
+ * The file holds the voxels of the complete dataset in file orientation. flipVec
+ * gives the axes along which the file orientation is reversed with respect to the
+ * dataset. Only the bytes of the slab are read.
+ * \param theTargetDataSPtr dataset holding the slab. Its extents define the slab size
+ * \param theFile input stream
+ * \param theVoxelType type of a voxel in the file
+ * \param bFileEndianess true data is big endian, false if it is little endian (intel)
+ * \param extentVec extents of the complete dataset (all but the last one must equal those of the slab)
+ * \param slabStart position of the slab along the last dimension of the dataset
+ * \param flipVec flipVec[i] is true if axis i is reversed in the file
+ * \param dataOffset position of the first voxel in the file (in bytes)
+ * \throws FileException on any file error
+ * \throws NullException if the type of theTargetDataSPtr isn't supported or it has several channels
+ */
+void CBinaryFileHandler::loadSlab( TDataSetPtr theTargetDataSPtr, istream& theFile,
+	const EDataType theVoxelType, const bool bFileEndianess, const std::vector<size_t>& extentVec,
+	const size_t slabStart, const std::vector<bool>& flipVec, const size_t dataOffset ) const
+	throw( FileException, NullException )
+{
+	if ( !theTargetDataSPtr )
+		throw ( NullException( SERROR( "Target data pointer is not allocated" ), CException::RECOVER, ERR_CALLERNULL ) );
+	const size_t lastDimension = extentVec.size() - 1;
+	const size_t slabExtent = theTargetDataSPtr->getExtent( lastDimension );
+	const size_t sliceSize = fileSliceSize( theTargetDataSPtr,
+		( theVoxelType == DFloat64 ) ? sizeof( long double ) : theVoxelType % 10, extentVec );
+	size_t fileSlabStart = slabStart;
+	if ( lastDimension < flipVec.size() && flipVec[lastDimension] )
+		fileSlabStart = extentVec[lastDimension] - slabStart - slabExtent;
+	theFile.seekg( dataOffset + fileSlabStart * sliceSize, ios::beg );
+	if ( !theFile.good() )
+		throw ( FileException( SERROR( "Could not seek to the requested region" ), CException::RECOVER, ERR_FILEACCESS ) );
+	loadData( theTargetDataSPtr, theFile, theVoxelType, bFileEndianess );
+	flipAxes( theTargetDataSPtr, flipVec );
+}
+
+/**
+ * Counterpart of loadSlab(). The file must exist and should already have the
+ * size of the complete dataset.
+ * \param theSourceDataSPtr dataset holding the slab
+ * \param theFile output stream
+ * \param theVoxelType type of a voxel in the file
+ * \param bFileEndianess true data is big endian, false if it is little endian (intel)
+ * \param extentVec extents of the complete dataset (all but the last one must equal those of the slab)
+ * \param slabStart position of the slab along the last dimension of the dataset
+ * \param flipVec flipVec[i] is true if axis i is reversed in the file
+ * \param dataOffset position of the first voxel in the file (in bytes)
+ * \throws FileException on any file error
+ * \throws NullException if the type of theSourceDataSPtr isn't supported or it has several channels
+ */
+void CBinaryFileHandler::saveSlab( TDataSetPtr theSourceDataSPtr, ostream& theFile,
+	const EDataType theVoxelType, const bool bFileEndianess, const std::vector<size_t>& extentVec,
+	const size_t slabStart, const std::vector<bool>& flipVec, const size_t dataOffset ) const
+	throw( FileException, NullException )
+{
+	if ( !theSourceDataSPtr )
+		throw ( NullException( SERROR( "Source data pointer is not allocated" ), CException::RECOVER, ERR_CALLERNULL ) );
+	const size_t lastDimension = extentVec.size() - 1;
+	const size_t slabExtent = theSourceDataSPtr->getExtent( lastDimension );
+	const size_t sliceSize = fileSliceSize( theSourceDataSPtr,
+		( theVoxelType == DFloat64 ) ? sizeof( long double ) : theVoxelType % 10, extentVec );
+	size_t fileSlabStart = slabStart;
+	if ( lastDimension < flipVec.size() && flipVec[lastDimension] )
+		fileSlabStart = extentVec[lastDimension] - slabStart - slabExtent;
+	// The slab is flipped in a copy-on-write copy, so the caller's data stays unchanged
+	TDataSetPtr theFileSlabSPtr = theSourceDataSPtr;
+	if ( std::find( flipVec.begin(), flipVec.end(), true ) != flipVec.end() )
+	{
+		theFileSlabSPtr.reset( theSourceDataSPtr->clone() );
+		flipAxes( theFileSlabSPtr, flipVec );
+	}
+	theFile.seekp( dataOffset + fileSlabStart * sliceSize, ios::beg );
+	if ( !theFile.good() )
+		throw ( FileException( SERROR( "Could not seek to the requested region" ), CException::RECOVER, ERR_FILEACCESS ) );
+	saveData( theFileSlabSPtr, theFile, theVoxelType, bFileEndianess );
+}
+
+/**
+ * Reverses the voxel order along each axis of a dataset
+ * \param theData the dataset
+ * \param flipVec flipVec[i] is true if axis i should be reversed
+ */
+template<typename SetType>
+static void flipTypedAxes( SetType& theData, const std::vector<bool>& flipVec ) throw()
+{
+	typedef typename SetType::TDataType TValue;
+	const size_t arraySize = theData.getArraySize();
+	if ( arraySize == 0 )
+		return;
+	TValue* dataPtr = theData.getArray();
+	for( unsigned short usAxis = 0; usAxis < flipVec.size() && usAxis < theData.getDimension(); ++usAxis )
+	{
+		if ( !flipVec[usAxis] )
+			continue;
+		const size_t stride = theData.getStride( usAxis );
+		const size_t extent = theData.getExtent( usAxis );
+		// Channels are stored one after another, so they are flipped as further blocks
+		for( size_t blockStart = 0; blockStart < arraySize; blockStart += stride * extent )
+			for( size_t i = 0; i < extent / 2; ++i )
+				std::swap_ranges( dataPtr + blockStart + i * stride, dataPtr + blockStart + ( i + 1 ) * stride,
+					dataPtr + blockStart + ( extent - 1 - i ) * stride );
+	}
+}
+
+/**
+ * \param theDataSPtr the dataset (TImage, TSmallImage, TField, TField2D or TField3D)
+ * \param flipVec flipVec[i] is true if axis i should be reversed
+ * \throws NullException if the type of theDataSPtr isn't supported
+ */
+void CBinaryFileHandler::flipAxes( TDataSetPtr theDataSPtr, const std::vector<bool>& flipVec )
+	throw( NullException )
+{
+	if ( !theDataSPtr )
+		throw ( NullException( SERROR( "Data pointer is not allocated" ), CException::RECOVER, ERR_CALLERNULL ) );
+	if ( std::find( flipVec.begin(), flipVec.end(), true ) == flipVec.end() )
+		return;
+	if ( checkType<TImage>( theDataSPtr ) )
+		flipTypedAxes( *static_pointer_cast<TImage>( theDataSPtr ), flipVec );
+	else if ( checkType<TSmallImage>( theDataSPtr ) )
+		flipTypedAxes( *static_pointer_cast<TSmallImage>( theDataSPtr ), flipVec );
+	else if ( checkType<TField>( theDataSPtr ) )
+		flipTypedAxes( *static_pointer_cast<TField>( theDataSPtr ), flipVec );
+	else if ( checkType<TField2D>( theDataSPtr ) )
+		flipTypedAxes( *static_pointer_cast<TField2D>( theDataSPtr ), flipVec );
+	else if ( checkType<TField3D>( theDataSPtr ) )
+		flipTypedAxes( *static_pointer_cast<TField3D>( theDataSPtr ), flipVec );
+	else
+		throw ( NullException( SERROR( "Could not determine dataset type" ), CException::RECOVER, ERR_UNKNOWNTYPE ) );
+}
+
 /**
  * \param theSourceDataAPtr pointer to source dataset
  * \param theFile output stream (file needs to be already open)
@@ -352,9 +643,6 @@ void CBinaryFileHandler::saveData( TDataSetPtr theSourceDataAPtr, ostream& theFi
 		throw ( NullException( SERROR( "Source data pointer is not allocated" ), CException::RECOVER, ERR_CALLERNULL ) );
 
 	size_t theVoxelSize = theVoxelType % 10;
-  std::vector<unsigned char> scanline;
-  size_t scanlineSize = theSourceDataAPtr->getExtent(0) * theVoxelSize;
-  scanline.resize( scanlineSize );
   if ( checkType<TField>( theSourceDataAPtr ) )
   {
   	TFieldPtr fieldAPtr = static_pointer_cast<TField>( theSourceDataAPtr );
@@ -22,6 +22,9 @@
  *                    and saving of different data types                *
  *        2005-04-04 Updated documentation and nomenclature             *
  *        2005-07-12 Added support for reading and writing vector fields*
+ *        2026-10-17 Added mapData() for memory mapped loading          *
+ *                   Data is converted in bulk instead of per voxel     *
+ *                   Added loadSlab() and saveSlab() for region access  *
  * TODO: Better vector field handling                                   *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
@@ -33,6 +36,12 @@
 #ifndef CBINARYFILEHANDLER_H
 #define CBINARYFILEHANDLER_H
 
+// Standard includes
+#include <limits>
+
+// Boost includes
+#include <boost/type_traits/is_same.hpp>
+
 // AIPS includes
 #include "aipstypelist.h"
 #include "cfilehandler.h"
@@ -70,6 +79,28 @@ protected:
   virtual void saveData( TDataSetPtr theSourceDataSPtr, std::ostream& theFile,
     const EDataType theVoxelType, const bool bFileEndianess )	const 
 		throw( FileException, NullException ); 
+  /// Maps the data of an uncompressed file into a new dataset (if possible)
+  TDataSetPtr mapData( const std::string& sFilename, const std::vector<size_t>& extentVec,
+    const EDataType theVoxelType, const bool bFileEndianess, const size_t fileOffset = 0,
+    const bool bComputeRange = true ) const
+    throw();
+  /// Returns true if a region covers all but the last dimension of a dataset completely
+  static bool isSlab( const std::vector<size_t>& extentVec, const std::vector<size_t>& regionOriginVec,
+    const std::vector<size_t>& regionExtentVec )
+    throw();
+  /// Loads a slab (along the last dimension) of a dataset from a binary file
+  void loadSlab( TDataSetPtr theTargetDataSPtr, std::istream& theFile, const EDataType theVoxelType,
+    const bool bFileEndianess, const std::vector<size_t>& extentVec, const size_t slabStart,
+    const std::vector<bool>& flipVec, const size_t dataOffset = 0 ) const
+    throw( FileException, NullException );
+  /// Saves a slab (along the last dimension) of a dataset into a binary file
+  void saveSlab( TDataSetPtr theSourceDataSPtr, std::ostream& theFile, const EDataType theVoxelType,
+    const bool bFileEndianess, const std::vector<size_t>& extentVec, const size_t slabStart,
+    const std::vector<bool>& flipVec, const size_t dataOffset = 0 ) const
+    throw( FileException, NullException );
+  /// Reverses the order of the voxels of a dataset along the given axes
+  static void flipAxes( TDataSetPtr theDataSPtr, const std::vector<bool>& flipVec )
+    throw( NullException );
 private:
 /* Other methods */
 	/// Internal member function template to actually load data of a specific type
@@ -82,6 +113,11 @@ private:
 	void saveSpecificType( boost::shared_ptr<SetType> theSourceDataSPtr, std::ostream& theFile,
 		const bool bFileEndianess, const size_t theVoxelSize ) const
 		throw( FileException );
+	/// Internal member function template to map data of a specific type
+	template<typename SetType>
+	boost::shared_ptr<SetType> mapSpecificType( const std::string& sFilename,
+		const std::vector<size_t>& extentVec, const size_t fileOffset, const bool bComputeRange ) const
+		throw();
 };
 
 }
@@ -0,0 +1,361 @@
+/************************************************************************
+ * File: cbitmask.cpp                                                   *
+ * Project: AIPS                                                        *
+ * Description: Bit packed binary volumes and their morphology          *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#include "cbitmask.h"
+
+// Standard includes
+#include <sstream>
+
+// AIPS includes
+#include "aipsparallel.h"
+
+using namespace std;
+using namespace aips;
+
+namespace
+{
+
+typedef CBitMask::TWord TWord;
+const size_t bitsPerWord = CBitMask::bitsPerWord;
+
+/// Mask of the valid bits in the last word of a row
+TWord lastWordMask( const size_t width )
+{
+	const size_t usedBits = width % bitsPerWord;
+	return ( usedBits == 0 ) ? ~TWord( 0 ) : ( TWord( 1 ) << usedBits ) - 1;
+}
+
+/// Number of bits set in a word
+size_t countBits( TWord word )
+{
+	word = word - ( ( word >> 1 ) & 0x5555555555555555ULL );
+	word = ( word & 0x3333333333333333ULL ) + ( ( word >> 2 ) & 0x3333333333333333ULL );
+	word = ( word + ( word >> 4 ) ) & 0x0f0f0f0f0f0f0f0fULL;
+	return static_cast<size_t>( ( word * 0x0101010101010101ULL ) >> 56 );
+}
+
+/// Bit n of the result is bit n + shift of the source, zeros are shifted in
+void shiftDown( const TWord* sourcePtr, TWord* targetPtr, const size_t wordCount, const size_t shift )
+{
+	const size_t wordShift = shift / bitsPerWord;
+	const size_t bitShift = shift % bitsPerWord;
+	for( size_t w = 0; w < wordCount; ++w )
+	{
+		const size_t low = w + wordShift;
+		TWord word = ( low < wordCount ) ? ( sourcePtr[low] >> bitShift ) : 0;
+		if ( bitShift > 0 && low + 1 < wordCount )
+			word |= sourcePtr[low + 1] << ( bitsPerWord - bitShift );
+		targetPtr[w] = word;
+	}
+}
+
+/// Bit n of the result is bit n - shift of the source, zeros are shifted in
+void shiftUp( const TWord* sourcePtr, TWord* targetPtr, const size_t wordCount, const size_t shift )
+{
+	const size_t wordShift = shift / bitsPerWord;
+	const size_t bitShift = shift % bitsPerWord;
+	for( size_t w = wordCount; w-- > 0; )
+	{
+		TWord word = ( w >= wordShift ) ? ( sourcePtr[w - wordShift] << bitShift ) : 0;
+		if ( bitShift > 0 && w >= wordShift + 1 )
+			word |= sourcePtr[w - wordShift - 1] >> ( bitsPerWord - bitShift );
+		targetPtr[w] = word;
+	}
+}
+
+/**
+ * Dilation of rows along x, shared by all workers. Every bit is ORed with the
+ * radius bits behind it and, separately, with the radius bits before it. Both
+ * half windows are built by shifts of 1, 2, 4, ... bits.
+ */
+struct SRowDilation
+{
+	TWord* dataPtr;
+	size_t wordsPerRow;
+	size_t width;
+	size_t radius;
+
+	void range( const size_t first, const size_t last ) const
+	{
+		const size_t halfWindow = std::min( radius, width - 1 ) + 1;
+		vector<TWord> forwardVec( wordsPerRow );
+		vector<TWord> backwardVec( wordsPerRow );
+		vector<TWord> shiftVec( wordsPerRow );
+		for( size_t row = first; row < last; ++row )
+		{
+			TWord* rowPtr = dataPtr + row * wordsPerRow;
+			std::copy( rowPtr, rowPtr + wordsPerRow, forwardVec.begin() );
+			std::copy( rowPtr, rowPtr + wordsPerRow, backwardVec.begin() );
+			size_t covered = 1;
+			while( covered < halfWindow )
+			{
+				const size_t shift = std::min( covered, halfWindow - covered );
+				shiftDown( &forwardVec[0], &shiftVec[0], wordsPerRow, shift );
+				for( size_t w = 0; w < wordsPerRow; ++w )
+					forwardVec[w] |= shiftVec[w];
+				shiftUp( &backwardVec[0], &shiftVec[0], wordsPerRow, shift );
+				for( size_t w = 0; w < wordsPerRow; ++w )
+					backwardVec[w] |= shiftVec[w];
+				covered += shift;
+			}
+			for( size_t w = 0; w < wordsPerRow; ++w )
+				rowPtr[w] = forwardVec[w] | backwardVec[w];
+			rowPtr[wordsPerRow - 1] &= lastWordMask( width );
+		}
+	}
+};
+
+/**
+ * Running OR of interleaved lines of words after van Herk and Gil-Werman.
+ * Word l of sample n is found at dataPtr[n * stride + l].
+ */
+void orLines( TWord* dataPtr, const size_t count, const size_t stride, const size_t width,
+	const size_t radius )
+{
+	const size_t r = std::min( radius, count - 1 );
+	if ( r == 0 )
+		return;
+	const size_t windowSize = 2 * r + 1;
+	const size_t paddedCount = ( ( count + 2 * r + windowSize - 1 ) / windowSize ) * windowSize;
+	vector<TWord> prefixVec( paddedCount * width, 0 );
+	for( size_t n = r; n < count + r; ++n )
+		std::copy( dataPtr + ( n - r ) * stride, dataPtr + ( n - r ) * stride + width, &prefixVec[n * width] );
+	vector<TWord> suffixVec( prefixVec );
+	for( size_t n = 1; n < paddedCount; ++n )
+	{
+		if ( n % windowSize == 0 )
+			continue;
+		TWord* prefixPtr = &prefixVec[n * width];
+		for( size_t l = 0; l < width; ++l )
+			prefixPtr[l] |= prefixPtr[l - width];
+	}
+	for( size_t n = paddedCount - 1; n-- > 0; )
+	{
+		if ( ( n + 1 ) % windowSize == 0 )
+			continue;
+		TWord* suffixPtr = &suffixVec[n * width];
+		for( size_t l = 0; l < width; ++l )
+			suffixPtr[l] |= suffixPtr[l + width];
+	}
+	for( size_t n = 0; n < count; ++n )
+	{
+		const TWord* suffixPtr = &suffixVec[n * width];
+		const TWord* prefixPtr = &prefixVec[( n + 2 * r ) * width];
+		TWord* linePtr = dataPtr + n * stride;
+		for( size_t l = 0; l < width; ++l )
+			linePtr[l] = suffixPtr[l] | prefixPtr[l];
+	}
+}
+
+/**
+ * Dilation along y or z, shared by all workers. Lines along y are processed
+ * slice by slice, lines along z row by row.
+ */
+struct SLineDilation
+{
+	TWord* dataPtr;
+	size_t wordsPerRow;
+	size_t extentArr[3];
+	size_t radius;
+	unsigned short usAxis;
+
+	void range( const size_t first, const size_t last ) const
+	{
+		const size_t sliceWords = wordsPerRow * extentArr[1];
+		for( size_t item = first; item < last; ++item )
+		{
+			if ( usAxis == 1 )
+				orLines( dataPtr + item * sliceWords, extentArr[1], wordsPerRow, wordsPerRow, radius );
+			else
+				orLines( dataPtr + item * wordsPerRow, extentArr[2], sliceWords, wordsPerRow, radius );
+		}
+	}
+};
+
+}
+
+/*************
+ * Structors *
+ *************/
+
+/** \param extentVec extents of the mask. Missing dimensions are set to 1 */
+CBitMask::CBitMask( const std::vector<size_t>& extentVec ) throw( std::bad_alloc )
+	: CBase( "CBitMask", CBITMASK_VERSION, "CBase" )
+{
+	for( unsigned short i = 0; i < 3; ++i )
+		extentArr[i] = ( i < extentVec.size() ) ? extentVec[i] : 1;
+	wordsPerRow = ( extentArr[0] + bitsPerWord - 1 ) / bitsPerWord;
+	wordBlock.reset( wordsPerRow * extentArr[1] * extentArr[2], true );
+}
+
+/** \param aMask mask to copy */
+CBitMask::CBitMask( const CBitMask& aMask ) throw( std::bad_alloc )
+	: CBase( "CBitMask", CBITMASK_VERSION, "CBase" ), wordsPerRow( aMask.wordsPerRow ),
+	wordBlock( aMask.wordBlock )
+{
+	for( unsigned short i = 0; i < 3; ++i )
+		extentArr[i] = aMask.extentArr[i];
+}
+
+CBitMask::~CBitMask() throw()
+{
+}
+
+/*************
+ * Operators *
+ *************/
+
+/** \param aMask mask to copy */
+CBitMask& CBitMask::operator=( const CBitMask& aMask ) throw( std::bad_alloc )
+{
+	if ( &aMask == this )
+		return *this;
+	for( unsigned short i = 0; i < 3; ++i )
+		extentArr[i] = aMask.extentArr[i];
+	wordsPerRow = aMask.wordsPerRow;
+	wordBlock = aMask.wordBlock;
+	return *this;
+}
+
+/*************
+ * Accessors *
+ *************/
+
+/**
+ * \param usIndex dimension (0..2)
+ * \returns the extent of this dimension
+ */
+size_t CBitMask::getExtent( const unsigned short usIndex ) const throw()
+{
+	return extentArr[usIndex];
+}
+
+/** \returns the number of words of a row */
+size_t CBitMask::getWordsPerRow() const throw()
+{
+	return wordsPerRow;
+}
+
+/**
+ * \param y row
+ * \param z slice
+ * \returns the first word of the row
+ */
+CBitMask::TWord* CBitMask::getRow( const size_t y, const size_t z ) throw()
+{
+	return wordBlock.getData() + ( z * extentArr[1] + y ) * wordsPerRow;
+}
+
+/**
+ * \param y row
+ * \param z slice
+ * \returns the first word of the row
+ */
+const CBitMask::TWord* CBitMask::getRow( const size_t y, const size_t z ) const throw()
+{
+	return wordBlock.getData() + ( z * extentArr[1] + y ) * wordsPerRow;
+}
+
+/** \returns true if the voxel is set */
+bool CBitMask::get( const size_t x, const size_t y, const size_t z ) const throw()
+{
+	return ( getRow( y, z )[x / bitsPerWord] >> ( x % bitsPerWord ) ) & 1;
+}
+
+/** \param bValue new value of the voxel */
+void CBitMask::set( const size_t x, const size_t y, const size_t z, const bool bValue ) throw()
+{
+	TWord& word = getRow( y, z )[x / bitsPerWord];
+	const TWord bit = TWord( 1 ) << ( x % bitsPerWord );
+	word = bValue ? ( word | bit ) : ( word & ~bit );
+}
+
+/*****************
+ * Other methods *
+ *****************/
+
+/** \returns the number of voxels set */
+size_t CBitMask::count() const throw()
+{
+	const TWord* wordPtr = wordBlock.getData();
+	const size_t wordCount = wordsPerRow * extentArr[1] * extentArr[2];
+	size_t voxelCount = 0;
+	for( size_t w = 0; w < wordCount; ++w )
+		voxelCount += countBits( wordPtr[w] );
+	return voxelCount;
+}
+
+void CBitMask::invert() throw()
+{
+	TWord* wordPtr = wordBlock.getData();
+	const size_t rowCount = extentArr[1] * extentArr[2];
+	const TWord lastMask = lastWordMask( extentArr[0] );
+	for( size_t row = 0; row < rowCount; ++row, wordPtr += wordsPerRow )
+	{
+		for( size_t w = 0; w < wordsPerRow; ++w )
+			wordPtr[w] = ~wordPtr[w];
+		wordPtr[wordsPerRow - 1] &= lastMask;
+	}
+}
+
+/**
+ * A voxel is set if any voxel within the box around it is set.
+ * \param radiusArr radius of the box along x, y and z
+ */
+void CBitMask::dilate( const size_t* radiusArr ) throw()
+{
+	TWord* dataPtr = wordBlock.getData();
+	if ( radiusArr[0] > 0 && extentArr[0] > 1 )
+	{
+		SRowDilation theDilation;
+		theDilation.dataPtr = dataPtr;
+		theDilation.wordsPerRow = wordsPerRow;
+		theDilation.width = extentArr[0];
+		theDilation.radius = radiusArr[0];
+		parallelFor( theDilation, &SRowDilation::range, extentArr[1] * extentArr[2] );
+	}
+	SLineDilation theDilation;
+	theDilation.dataPtr = dataPtr;
+	theDilation.wordsPerRow = wordsPerRow;
+	for( unsigned short i = 0; i < 3; ++i )
+		theDilation.extentArr[i] = extentArr[i];
+	for( unsigned short usAxis = 1; usAxis < 3; ++usAxis )
+	{
+		if ( radiusArr[usAxis] == 0 || extentArr[usAxis] < 2 )
+			continue;
+		theDilation.radius = radiusArr[usAxis];
+		theDilation.usAxis = usAxis;
+		parallelFor( theDilation, &SLineDilation::range, ( usAxis == 1 ) ? extentArr[2] : extentArr[1] );
+	}
+}
+
+/**
+ * A voxel stays set if all voxels within the box around it are set.
+ * \param radiusArr radius of the box along x, y and z
+ */
+void CBitMask::erode( const size_t* radiusArr ) throw()
+{
+	invert();
+	dilate( radiusArr );
+	invert();
+}
+
+const std::string CBitMask::dump() const throw()
+{
+	std::ostringstream os;
+	os << "extentArr " << extentArr[0] << " " << extentArr[1] << " " << extentArr[2]
+		<< " wordsPerRow " << wordsPerRow << "\n";
+	return CBase::dump() + os.str();
+}
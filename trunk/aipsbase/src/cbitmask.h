@@ -0,0 +1,129 @@
+/************************************************************************
+ * File: cbitmask.h                                                     *
+ * Project: AIPS                                                        *
+ * Description: Bit packed binary volumes and their morphology          *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Version: 0.1                                                         *
+ * Status : Beta                                                        *
+ * Created: 2026-10-17                                                  *
+ * Changed:                                                             *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#ifndef CBITMASK_H
+#define CBITMASK_H
+
+#define CBITMASK_VERSION "0.1"
+
+// Standard includes
+#include <algorithm> // std::min
+#include <string>
+#include <vector>
+
+// Boost includes
+#include <boost/cstdint.hpp>
+
+// AIPS includes
+#include "cbase.h"
+#include "cdatablock.h"
+
+namespace aips {
+
+/**
+ * \brief A binary volume storing 64 voxels per machine word.
+ *
+ * Every row along x starts at a new word, bit x % 64 of word x / 64 holds
+ * voxel x. Bits behind the end of a row are always 0. Missing dimensions
+ * have an extent of 1.
+ *
+ * Erosion and dilation use box shaped elements with a radius for each
+ * axis. Along y and z whole words are combined by a running OR after van
+ * Herk and Gil-Werman, whose cost does not depend on the radius. Along x the
+ * rows are shifted and ORed with doubling shift widths, i.e. about
+ * 2 * log2( radius + 1 ) operations per word. Voxels outside the volume are
+ * ignored, so dilation treats them as 0 and erosion as 1. All passes are
+ * distributed over CPipelineItem::getNumberOfThreads() threads.
+ */
+class CBitMask : public CBase
+{
+private:
+	/// Standard constructor
+	CBitMask();
+public:
+	/// Type of a word of bits
+	typedef boost::uint64_t TWord;
+	/// Number of voxels per word
+	static const size_t bitsPerWord = 64;
+/* Structors */
+	/// Constructor for an empty mask
+	explicit CBitMask( const std::vector<size_t>& extentVec )
+		throw( std::bad_alloc );
+	/// Copy constructor
+	CBitMask( const CBitMask& aMask )
+		throw( std::bad_alloc );
+	/// Destructor
+	virtual ~CBitMask()
+		throw();
+/* Operators */
+	/// Assignment operator
+	CBitMask& operator=( const CBitMask& aMask )
+		throw( std::bad_alloc );
+/* Accessors */
+	/// Returns the extent of the given dimension (0..2)
+	size_t getExtent( const unsigned short usIndex ) const
+		throw();
+	/// Returns the number of words of a row
+	size_t getWordsPerRow() const
+		throw();
+	/// Returns the first word of a row
+	TWord* getRow( const size_t y, const size_t z )
+		throw();
+	/// Returns the first word of a row
+	const TWord* getRow( const size_t y, const size_t z ) const
+		throw();
+	/// Returns a voxel
+	bool get( const size_t x, const size_t y, const size_t z ) const
+		throw();
+	/// Sets a voxel
+	void set( const size_t x, const size_t y, const size_t z, const bool bValue )
+		throw();
+/* Other methods */
+	/// Sets all voxels whose value is not 0
+	template<typename TValue> void fromArray( const TValue* dataPtr )
+		throw();
+	/// Writes the mask into an array
+	template<typename TValue> void toArray( TValue* dataPtr, const TValue falseValue,
+		const TValue trueValue ) const
+		throw();
+	/// Returns the number of voxels set
+	size_t count() const
+		throw();
+	/// Inverts all voxels
+	void invert()
+		throw();
+	/// Dilates the mask with a box
+	void dilate( const size_t* radiusArr )
+		throw();
+	/// Erodes the mask with a box
+	void erode( const size_t* radiusArr )
+		throw();
+	/// Reimplemented from CBase
+	virtual const std::string dump() const
+		throw();
+private:
+	size_t extentArr[3];         ///< Mask extents
+	size_t wordsPerRow;          ///< Number of words of a row
+	CDataBlock<TWord> wordBlock; ///< All rows, x running fastest
+};
+
+#include "cbitmask.tpp"
+
+}
+
+#endif
@@ -0,0 +1,58 @@
+/************************************************************************
+ * File: cbitmask.tpp                                                   *
+ * Project: AIPS                                                        *
+ * Description: Bit packed binary volumes and their morphology          *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+/**
+ * \param dataPtr array of getExtent(0) * getExtent(1) * getExtent(2) voxels, x running fastest
+ */
+template<typename TValue> void CBitMask::fromArray( const TValue* dataPtr ) throw()
+{
+	for( size_t z = 0; z < extentArr[2]; ++z )
+		for( size_t y = 0; y < extentArr[1]; ++y )
+		{
+			TWord* rowPtr = getRow( y, z );
+			for( size_t w = 0; w < wordsPerRow; ++w )
+			{
+				const size_t bitCount = std::min( bitsPerWord, extentArr[0] - w * bitsPerWord );
+				TWord word = 0;
+				for( size_t b = 0; b < bitCount; ++b )
+					word |= static_cast<TWord>( dataPtr[b] != TValue( 0 ) ) << b;
+				rowPtr[w] = word;
+				dataPtr += bitCount;
+			}
+		}
+}
+
+/**
+ * \param dataPtr array of getExtent(0) * getExtent(1) * getExtent(2) voxels, x running fastest
+ * \param falseValue value for voxels not set
+ * \param trueValue value for voxels set
+ */
+template<typename TValue> void CBitMask::toArray( TValue* dataPtr, const TValue falseValue,
+	const TValue trueValue ) const throw()
+{
+	for( size_t z = 0; z < extentArr[2]; ++z )
+		for( size_t y = 0; y < extentArr[1]; ++y )
+		{
+			const TWord* rowPtr = getRow( y, z );
+			for( size_t w = 0; w < wordsPerRow; ++w )
+			{
+				const size_t bitCount = std::min( bitsPerWord, extentArr[0] - w * bitsPerWord );
+				const TWord word = rowPtr[w];
+				for( size_t b = 0; b < bitCount; ++b )
+					dataPtr[b] = ( ( word >> b ) & 1 ) ? trueValue : falseValue;
+				dataPtr += bitCount;
+			}
+		}
+}
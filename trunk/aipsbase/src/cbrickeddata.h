@@ -0,0 +1,195 @@
+/************************************************************************
+ * File: cbrickeddata.h                                                 *
+ * Project: AIPS                                                        *
+ * Description: Brick (tiled) memory layout for 3D stencil operations   *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Version: 0.1                                                         *
+ * Status : Beta                                                        *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#ifndef CBRICKEDDATA_H
+#define CBRICKEDDATA_H
+
+#define CBRICKEDDATA_VERSION "0.1"
+
+// Standard includes
+#include <algorithm> // std::copy, std::fill, std::min
+#include <cstddef>  // ptrdiff_t
+#include <sstream>
+#include <vector>
+
+// AIPS includes
+#include "cbase.h"
+#include "cdatablock.h"
+#include "ctypeddata.h"
+
+namespace aips {
+
+/**
+ * \brief A working copy of a 3D dataset stored in cubic bricks.
+ *
+ * The volume is divided into bricks with an edge length of 2^usBrickShift
+ * voxels (8 or 16 are sensible choices). Each brick is stored contiguously,
+ * so a 3x3x3 neighbourhood of a voxel touches at most eight bricks instead
+ * of nine widely separated lines of the linear layout. This keeps stencil
+ * operations on large volumes inside the cache.
+ *
+ * The extents are padded to whole bricks. The padding voxels are never
+ * visited by the iterator and never returned by getNeighbourhood(), which
+ * replicates the border voxels instead. Each channel is stored in its own
+ * set of bricks.
+ *
+ * CBrickedData is no CDataSet. Filters convert their input with the
+ * constructor (or fromLinear()), do their work and convert the result back
+ * with toLinear(). Datasets with less than three dimensions are treated as
+ * volumes with a z extent of 1.
+ */
+template<typename TValue>
+class CBrickedData : public CBase
+{
+private:
+	/// Standard constructor
+	CBrickedData();
+public:
+	typedef TValue TDataType;
+	class iterator;
+	friend class iterator;
+/* Structors */
+	/// Constructor for an empty volume
+	CBrickedData( const std::vector<size_t>& extentVec_, const size_t dataDimensionSize_ = 1,
+		const unsigned short usBrickShift_ = 3 ) throw( std::bad_alloc );
+	/// Constructor. Copies the contents of the given dataset
+	explicit CBrickedData( const CTypedData<TValue>& aDataSet, const unsigned short usBrickShift_ = 3 )
+		throw( std::bad_alloc );
+	/// Copy constructor
+	CBrickedData( const CBrickedData<TValue>& aBrickedData )
+		throw( std::bad_alloc );
+	/// Destructor
+	virtual ~CBrickedData()
+		throw();
+/* Operators */
+	/// Assignment operator
+	CBrickedData<TValue>& operator=( const CBrickedData<TValue>& aBrickedData )
+		throw( std::bad_alloc );
+	/// Sets all voxels to the given value
+	CBrickedData<TValue>& operator=( const TValue theValue )
+		throw();
+	/// Access operator without range checking
+	inline TValue& operator()( const size_t x, const size_t y, const size_t z, const size_t c = 0 )
+		throw();
+	/// Constant access operator without range checking
+	inline const TValue& operator()( const size_t x, const size_t y, const size_t z,
+		const size_t c = 0 ) const throw();
+/* Accessors */
+	/// Returns the extent of the given dimension (0..2)
+	inline size_t getExtent( const unsigned short usIndex ) const
+		throw();
+	/// Returns the number of channels
+	inline size_t getDataDimension() const
+		throw();
+	/// Returns the edge length of a brick
+	inline size_t getBrickEdge() const
+		throw();
+	/// Returns the number of bricks along the given dimension (0..2)
+	inline size_t getBrickCount( const unsigned short usIndex ) const
+		throw();
+/* Other methods */
+	/// Copies the contents of a linear dataset into the bricks
+	void fromLinear( const CTypedData<TValue>& aDataSet )
+		throw();
+	/// Copies the contents of the bricks into a linear dataset
+	void toLinear( CTypedData<TValue>& aDataSet ) const
+		throw();
+	/// Reads the 3x3x3 neighbourhood of a voxel
+	inline void getNeighbourhood( const size_t x, const size_t y, const size_t z, const size_t c,
+		TValue* neighbourArr ) const throw();
+	/// Returns an iterator to the first voxel of the first channel
+	iterator begin()
+		throw();
+	/// Returns an iterator behind the last voxel of the last channel
+	iterator end()
+		throw();
+	/// Produces an information string about the actual object.
+	virtual const std::string dump() const
+		throw();
+private:
+	/// Computes the brick geometry from the extents and allocates the bricks
+	void allocate()
+		throw( std::bad_alloc );
+	/// Returns the storage index of a voxel
+	inline size_t index( const size_t x, const size_t y, const size_t z, const size_t c ) const
+		throw();
+	/// Reads the neighbourhood of a voxel that is not at a brick border
+	inline void getInnerNeighbourhood( const TValue* centerPtr, TValue* neighbourArr ) const
+		throw();
+	size_t extentArr[3];           ///< Volume extents
+	size_t dataDimensionSize;      ///< Number of channels
+	unsigned short usBrickShift;   ///< Binary logarithm of the brick edge length
+	size_t brickMask;              ///< Brick edge length - 1
+	size_t brickCountArr[3];       ///< Number of bricks along each dimension
+	size_t brickSize;              ///< Number of voxels in a brick
+	size_t channelSize;            ///< Number of voxels (including padding) of one channel
+	CDataBlock<TValue> dataBlock;  ///< Brick storage
+public:
+	/**
+	 * \brief Visits all voxels in storage order, i.e. brick by brick.
+	 *
+	 * Padding voxels are skipped. The position of the current voxel can be
+	 * queried with getPos().
+	 */
+	class iterator
+	{
+	public:
+		/// Constructor
+		iterator( CBrickedData<TValue>* parentPtr_, TValue* positionPtr_ )
+			throw();
+		/// Dereference operator
+		inline TValue& operator*() const
+			throw();
+		/// Prefix increment
+		inline iterator& operator++()
+			throw();
+		/// Equality
+		inline bool operator==( const iterator& anIterator ) const
+			throw();
+		/// Inequality
+		inline bool operator!=( const iterator& anIterator ) const
+			throw();
+		/// Returns the position of the current voxel
+		inline void getPos( size_t& x, size_t& y, size_t& z ) const
+			throw();
+		/// Returns the channel of the current voxel
+		inline size_t getChannel() const
+			throw();
+		/// Returns the running number of the current brick (counting all channels)
+		inline size_t getBrick() const
+			throw();
+		/// Reads the 3x3x3 neighbourhood of the current voxel
+		inline void getNeighbourhood( TValue* neighbourArr ) const
+			throw();
+	private:
+		/// Moves to the next voxel, including padding voxels
+		inline void step()
+			throw();
+		CBrickedData<TValue>* parentPtr; ///< Iterated volume
+		TValue* positionPtr;             ///< Current voxel
+		size_t innerArr[3];              ///< Position inside the current brick
+		size_t brickArr[3];              ///< Position of the current brick
+		size_t brick;                    ///< Running number of the current brick
+		size_t channel;                  ///< Current channel
+	};
+};
+
+#include "cbrickeddata.tpp"
+
+}
+
+#endif
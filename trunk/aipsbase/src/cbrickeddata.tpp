@@ -0,0 +1,441 @@
+/************************************************************************
+ * File: cbrickeddata.tpp                                               *
+ * Project: AIPS                                                        *
+ * Description: Brick (tiled) memory layout for 3D stencil operations   *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+/*************
+ * Structors *
+ *************/
+
+/**
+ * All voxels are initialised to zero.
+ * \param extentVec_ extents of the volume. Missing dimensions are set to 1
+ * \param dataDimensionSize_ number of channels
+ * \param usBrickShift_ binary logarithm of the brick edge length
+ */
+template<typename TValue>
+CBrickedData<TValue>::CBrickedData( const std::vector<size_t>& extentVec_,
+	const size_t dataDimensionSize_, const unsigned short usBrickShift_ ) throw( std::bad_alloc )
+	: CBase( "CBrickedData", CBRICKEDDATA_VERSION, "CBase" ), dataDimensionSize( dataDimensionSize_ ),
+	usBrickShift( usBrickShift_ )
+{
+	for( unsigned short i = 0; i < 3; ++i )
+		extentArr[i] = ( i < extentVec_.size() ? extentVec_[i] : 1 );
+	allocate();
+}
+
+/**
+ * \param aDataSet dataset to copy
+ * \param usBrickShift_ binary logarithm of the brick edge length
+ */
+template<typename TValue>
+CBrickedData<TValue>::CBrickedData( const CTypedData<TValue>& aDataSet,
+	const unsigned short usBrickShift_ ) throw( std::bad_alloc )
+	: CBase( "CBrickedData", CBRICKEDDATA_VERSION, "CBase" ),
+	dataDimensionSize( aDataSet.getDataDimension() ), usBrickShift( usBrickShift_ )
+{
+	for( unsigned short i = 0; i < 3; ++i )
+		extentArr[i] = ( i < aDataSet.getDimension() ? aDataSet.getExtent( i ) : 1 );
+	allocate();
+	fromLinear( aDataSet );
+}
+
+/** \param aBrickedData volume to copy */
+template<typename TValue>
+CBrickedData<TValue>::CBrickedData( const CBrickedData<TValue>& aBrickedData ) throw( std::bad_alloc )
+	: CBase( "CBrickedData", CBRICKEDDATA_VERSION, "CBase" ),
+	dataDimensionSize( aBrickedData.dataDimensionSize ), usBrickShift( aBrickedData.usBrickShift ),
+	brickMask( aBrickedData.brickMask ), brickSize( aBrickedData.brickSize ),
+	channelSize( aBrickedData.channelSize ), dataBlock( aBrickedData.dataBlock )
+{
+	for( unsigned short i = 0; i < 3; ++i )
+	{
+		extentArr[i] = aBrickedData.extentArr[i];
+		brickCountArr[i] = aBrickedData.brickCountArr[i];
+	}
+}
+
+template<typename TValue>
+CBrickedData<TValue>::~CBrickedData() throw()
+{
+}
+
+/*************
+ * Operators *
+ *************/
+
+/** \param aBrickedData volume to copy */
+template<typename TValue>
+CBrickedData<TValue>& CBrickedData<TValue>::operator=( const CBrickedData<TValue>& aBrickedData )
+	throw( std::bad_alloc )
+{
+	if ( &aBrickedData == this )
+		return *this;
+	dataDimensionSize = aBrickedData.dataDimensionSize;
+	usBrickShift = aBrickedData.usBrickShift;
+	brickMask = aBrickedData.brickMask;
+	brickSize = aBrickedData.brickSize;
+	channelSize = aBrickedData.channelSize;
+	for( unsigned short i = 0; i < 3; ++i )
+	{
+		extentArr[i] = aBrickedData.extentArr[i];
+		brickCountArr[i] = aBrickedData.brickCountArr[i];
+	}
+	dataBlock = aBrickedData.dataBlock;
+	return *this;
+}
+
+/** \param theValue new value of all voxels */
+template<typename TValue>
+CBrickedData<TValue>& CBrickedData<TValue>::operator=( const TValue theValue ) throw()
+{
+	std::fill( dataBlock.getData(), dataBlock.getData() + dataBlock.getSize(), theValue );
+	return *this;
+}
+
+/**
+ * \param x x coordinate
+ * \param y y coordinate
+ * \param z z coordinate
+ * \param c channel
+ */
+template<typename TValue> inline
+TValue& CBrickedData<TValue>::operator()( const size_t x, const size_t y, const size_t z,
+	const size_t c ) throw()
+{
+	return dataBlock[index( x, y, z, c )];
+}
+
+/**
+ * \param x x coordinate
+ * \param y y coordinate
+ * \param z z coordinate
+ * \param c channel
+ */
+template<typename TValue> inline
+const TValue& CBrickedData<TValue>::operator()( const size_t x, const size_t y, const size_t z,
+	const size_t c ) const throw()
+{
+	return dataBlock[index( x, y, z, c )];
+}
+
+/*************
+ * Accessors *
+ *************/
+
+/** \param usIndex dimension (0..2) */
+template<typename TValue> inline
+size_t CBrickedData<TValue>::getExtent( const unsigned short usIndex ) const throw()
+{
+	return extentArr[usIndex];
+}
+
+template<typename TValue> inline
+size_t CBrickedData<TValue>::getDataDimension() const throw()
+{
+	return dataDimensionSize;
+}
+
+template<typename TValue> inline
+size_t CBrickedData<TValue>::getBrickEdge() const throw()
+{
+	return brickMask + 1;
+}
+
+/** \param usIndex dimension (0..2) */
+template<typename TValue> inline
+size_t CBrickedData<TValue>::getBrickCount( const unsigned short usIndex ) const throw()
+{
+	return brickCountArr[usIndex];
+}
+
+/*****************
+ * Other methods *
+ *****************/
+
+/**
+ * The dataset must have the extents and channel count of this volume.
+ * Each image line is copied in runs of one brick edge.
+ * \param aDataSet dataset to copy
+ */
+template<typename TValue>
+void CBrickedData<TValue>::fromLinear( const CTypedData<TValue>& aDataSet ) throw()
+{
+	const size_t planeSize = extentArr[0] * extentArr[1] * extentArr[2];
+	if ( planeSize == 0 )
+		return;
+	for( size_t c = 0; c < dataDimensionSize; ++c )
+		for( size_t z = 0; z < extentArr[2]; ++z )
+			for( size_t y = 0; y < extentArr[1]; ++y )
+			{
+				const TValue* sourcePtr = &aDataSet[c * planeSize + ( z * extentArr[1] + y ) * extentArr[0]];
+				for( size_t x = 0; x < extentArr[0]; x += brickMask + 1 )
+				{
+					const size_t runLength = std::min( brickMask + 1, extentArr[0] - x );
+					std::copy( sourcePtr, sourcePtr + runLength, &dataBlock[index( x, y, z, c )] );
+					sourcePtr += runLength;
+				}
+			}
+}
+
+/**
+ * The dataset must have the extents and channel count of this volume.
+ * Its data range is left untouched.
+ * \param aDataSet target dataset
+ */
+template<typename TValue>
+void CBrickedData<TValue>::toLinear( CTypedData<TValue>& aDataSet ) const throw()
+{
+	const size_t planeSize = extentArr[0] * extentArr[1] * extentArr[2];
+	if ( planeSize == 0 )
+		return;
+	for( size_t c = 0; c < dataDimensionSize; ++c )
+	{
+		TValue* targetPtr = aDataSet.getArray( static_cast<unsigned short>( c ) );
+		for( size_t z = 0; z < extentArr[2]; ++z )
+			for( size_t y = 0; y < extentArr[1]; ++y )
+				for( size_t x = 0; x < extentArr[0]; x += brickMask + 1 )
+				{
+					const size_t runLength = std::min( brickMask + 1, extentArr[0] - x );
+					const TValue* sourcePtr = &dataBlock[index( x, y, z, c )];
+					targetPtr = std::copy( sourcePtr, sourcePtr + runLength, targetPtr );
+				}
+	}
+}
+
+/**
+ * The values are stored in the order neighbourArr[(dz+1)*9 + (dy+1)*3 + (dx+1)]
+ * for offsets dx, dy, dz in {-1, 0, 1}. Neighbours outside the volume are
+ * replaced by the nearest border voxel.
+ * \param x x coordinate
+ * \param y y coordinate
+ * \param z z coordinate
+ * \param c channel
+ * \param neighbourArr array of at least 27 elements receiving the neighbourhood
+ */
+template<typename TValue> inline
+void CBrickedData<TValue>::getNeighbourhood( const size_t x, const size_t y, const size_t z,
+	const size_t c, TValue* neighbourArr ) const throw()
+{
+	// ( v & brickMask ) - 1 wraps around for voxels at the lower brick border
+	if ( ( x & brickMask ) - 1 < brickMask - 1 && ( y & brickMask ) - 1 < brickMask - 1
+		&& ( z & brickMask ) - 1 < brickMask - 1 && x + 1 < extentArr[0] && y + 1 < extentArr[1]
+		&& z + 1 < extentArr[2] )
+	{
+		getInnerNeighbourhood( &dataBlock[index( x, y, z, c )], neighbourArr );
+		return;
+	}
+	const size_t xArr[3] = { ( x > 0 ? x - 1 : 0 ), x, ( x + 1 < extentArr[0] ? x + 1 : x ) };
+	const size_t yArr[3] = { ( y > 0 ? y - 1 : 0 ), y, ( y + 1 < extentArr[1] ? y + 1 : y ) };
+	const size_t zArr[3] = { ( z > 0 ? z - 1 : 0 ), z, ( z + 1 < extentArr[2] ? z + 1 : z ) };
+	for( unsigned short k = 0; k < 3; ++k )
+		for( unsigned short j = 0; j < 3; ++j )
+			for( unsigned short i = 0; i < 3; ++i )
+				*neighbourArr++ = dataBlock[index( xArr[i], yArr[j], zArr[k], c )];
+}
+
+template<typename TValue>
+typename CBrickedData<TValue>::iterator CBrickedData<TValue>::begin() throw()
+{
+	return iterator( this, dataBlock.getData() );
+}
+
+template<typename TValue>
+typename CBrickedData<TValue>::iterator CBrickedData<TValue>::end() throw()
+{
+	return iterator( this, dataBlock.getData() + dataDimensionSize * channelSize );
+}
+
+template<typename TValue>
+const std::string CBrickedData<TValue>::dump() const throw()
+{
+	std::ostringstream os;
+	os << "extents " << extentArr[0] << " " << extentArr[1] << " " << extentArr[2]
+		<< " dataDimensionSize " << dataDimensionSize << " brick edge " << brickMask + 1
+		<< " bricks " << brickCountArr[0] << " " << brickCountArr[1] << " " << brickCountArr[2] << "\n";
+	return CBase::dump() + os.str();
+}
+
+template<typename TValue>
+void CBrickedData<TValue>::allocate() throw( std::bad_alloc )
+{
+	brickMask = ( static_cast<size_t>( 1 ) << usBrickShift ) - 1;
+	brickSize = static_cast<size_t>( 1 ) << ( 3 * usBrickShift );
+	channelSize = brickSize;
+	for( unsigned short i = 0; i < 3; ++i )
+	{
+		brickCountArr[i] = ( extentArr[i] + brickMask ) >> usBrickShift;
+		channelSize *= brickCountArr[i];
+	}
+	dataBlock.reset( dataDimensionSize * channelSize );
+}
+
+/**
+ * \param x x coordinate
+ * \param y y coordinate
+ * \param z z coordinate
+ * \param c channel
+ */
+template<typename TValue> inline
+size_t CBrickedData<TValue>::index( const size_t x, const size_t y, const size_t z,
+	const size_t c ) const throw()
+{
+	const size_t theBrick = ( ( z >> usBrickShift ) * brickCountArr[1] + ( y >> usBrickShift ) )
+		* brickCountArr[0] + ( x >> usBrickShift );
+	const size_t theOffset = ( ( ( ( z & brickMask ) << usBrickShift ) | ( y & brickMask ) ) << usBrickShift )
+		| ( x & brickMask );
+	return c * channelSize + theBrick * brickSize + theOffset;
+}
+
+/**
+ * \param centerPtr the center voxel. All its neighbours must lie in the same brick
+ * \param neighbourArr array of at least 27 elements receiving the neighbourhood
+ */
+template<typename TValue> inline
+void CBrickedData<TValue>::getInnerNeighbourhood( const TValue* centerPtr, TValue* neighbourArr ) const
+	throw()
+{
+	const ptrdiff_t lineStride = static_cast<ptrdiff_t>( brickMask + 1 );
+	const ptrdiff_t sliceStride = lineStride * lineStride;
+	for( ptrdiff_t dz = -sliceStride; dz <= sliceStride; dz += sliceStride )
+		for( ptrdiff_t dy = -lineStride; dy <= lineStride; dy += lineStride )
+		{
+			const TValue* linePtr = centerPtr + dz + dy;
+			*neighbourArr++ = linePtr[-1];
+			*neighbourArr++ = linePtr[0];
+			*neighbourArr++ = linePtr[1];
+		}
+}
+
+/************
+ * Iterator *
+ ************/
+
+/**
+ * \param parentPtr_ iterated volume
+ * \param positionPtr_ initial position. Must be the first or the end position of the storage
+ */
+template<typename TValue>
+CBrickedData<TValue>::iterator::iterator( CBrickedData<TValue>* parentPtr_, TValue* positionPtr_ )
+	throw() : parentPtr( parentPtr_ ), positionPtr( positionPtr_ ), brick( 0 ), channel( 0 )
+{
+	for( unsigned short i = 0; i < 3; ++i )
+	{
+		innerArr[i] = 0;
+		brickArr[i] = 0;
+	}
+}
+
+template<typename TValue> inline
+TValue& CBrickedData<TValue>::iterator::operator*() const throw()
+{
+	return *positionPtr;
+}
+
+template<typename TValue> inline
+typename CBrickedData<TValue>::iterator& CBrickedData<TValue>::iterator::operator++() throw()
+{
+	const TValue* endPtr = parentPtr->dataBlock.getData()
+		+ parentPtr->dataDimensionSize * parentPtr->channelSize;
+	const unsigned short usShift = parentPtr->usBrickShift;
+	do
+		step();
+	while( positionPtr != endPtr && ( ( brickArr[0] << usShift ) + innerArr[0] >= parentPtr->extentArr[0]
+		|| ( brickArr[1] << usShift ) + innerArr[1] >= parentPtr->extentArr[1]
+		|| ( brickArr[2] << usShift ) + innerArr[2] >= parentPtr->extentArr[2] ) );
+	return *this;
+}
+
+/** \param anIterator iterator to compare with */
+template<typename TValue> inline
+bool CBrickedData<TValue>::iterator::operator==( const iterator& anIterator ) const throw()
+{
+	return positionPtr == anIterator.positionPtr;
+}
+
+/** \param anIterator iterator to compare with */
+template<typename TValue> inline
+bool CBrickedData<TValue>::iterator::operator!=( const iterator& anIterator ) const throw()
+{
+	return positionPtr != anIterator.positionPtr;
+}
+
+/**
+ * \param x returns the x coordinate
+ * \param y returns the y coordinate
+ * \param z returns the z coordinate
+ */
+template<typename TValue> inline
+void CBrickedData<TValue>::iterator::getPos( size_t& x, size_t& y, size_t& z ) const throw()
+{
+	x = ( brickArr[0] << parentPtr->usBrickShift ) + innerArr[0];
+	y = ( brickArr[1] << parentPtr->usBrickShift ) + innerArr[1];
+	z = ( brickArr[2] << parentPtr->usBrickShift ) + innerArr[2];
+}
+
+template<typename TValue> inline
+size_t CBrickedData<TValue>::iterator::getChannel() const throw()
+{
+	return channel;
+}
+
+template<typename TValue> inline
+size_t CBrickedData<TValue>::iterator::getBrick() const throw()
+{
+	return brick;
+}
+
+/**
+ * See CBrickedData::getNeighbourhood() for the order of the values.
+ * \param neighbourArr array of at least 27 elements receiving the neighbourhood
+ */
+template<typename TValue> inline
+void CBrickedData<TValue>::iterator::getNeighbourhood( TValue* neighbourArr ) const throw()
+{
+	const size_t brickMask = parentPtr->brickMask;
+	size_t x, y, z;
+	getPos( x, y, z );
+	if ( innerArr[0] - 1 < brickMask - 1 && innerArr[1] - 1 < brickMask - 1
+		&& innerArr[2] - 1 < brickMask - 1 && x + 1 < parentPtr->extentArr[0]
+		&& y + 1 < parentPtr->extentArr[1] && z + 1 < parentPtr->extentArr[2] )
+		parentPtr->getInnerNeighbourhood( positionPtr, neighbourArr );
+	else
+		parentPtr->getNeighbourhood( x, y, z, channel, neighbourArr );
+}
+
+template<typename TValue> inline
+void CBrickedData<TValue>::iterator::step() throw()
+{
+	const size_t brickMask = parentPtr->brickMask;
+	++positionPtr;
+	if ( ++innerArr[0] <= brickMask )
+		return;
+	innerArr[0] = 0;
+	if ( ++innerArr[1] <= brickMask )
+		return;
+	innerArr[1] = 0;
+	if ( ++innerArr[2] <= brickMask )
+		return;
+	innerArr[2] = 0;
+	++brick;
+	if ( ++brickArr[0] < parentPtr->brickCountArr[0] )
+		return;
+	brickArr[0] = 0;
+	if ( ++brickArr[1] < parentPtr->brickCountArr[1] )
+		return;
+	brickArr[1] = 0;
+	if ( ++brickArr[2] < parentPtr->brickCountArr[2] )
+		return;
+	brickArr[2] = 0;
+	++channel;
+}
@@ -0,0 +1,111 @@
+/************************************************************************
+ * File: ccomponentplanes.h                                             *
+ * Project: AIPS                                                        *
+ * Description: Structure of arrays layout for vector field filters     *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Version: 0.1                                                         *
+ * Status : Beta                                                        *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#ifndef CCOMPONENTPLANES_H
+#define CCOMPONENTPLANES_H
+
+#define CCOMPONENTPLANES_VERSION "0.1"
+
+// Standard includes
+#include <algorithm> // std::swap
+#include <sstream>
+#include <vector>
+
+// AIPS includes
+#include "cbase.h"
+#include "cdatablock.h"
+#include "ctypeddata.h"
+
+namespace aips {
+
+/**
+ * \brief A working copy of a vector field with one plane per vector component.
+ *
+ * TField2D and TField3D store whole vectors next to each other. Stencils
+ * working on one component at a time then read memory with a stride of the
+ * vector size. CComponentPlanes stores each component in its own contiguous
+ * array of doubles instead, so the inner loops of a filter run over plain
+ * arrays that the compiler can vectorise.
+ *
+ * CComponentPlanes is no CDataSet. Filters convert their input with the
+ * constructor (or fromField()), do their work and convert the result back
+ * with toField(). Missing dimensions have an extent of 1.
+ *
+ * \param TVector vector type of the field (e.g. TVector3D)
+ * \param D number of vector components
+ */
+template<typename TVector, unsigned short D>
+class CComponentPlanes : public CBase
+{
+private:
+	/// Standard constructor
+	CComponentPlanes();
+public:
+/* Structors */
+	/// Constructor for uninitialised planes
+	explicit CComponentPlanes( const std::vector<size_t>& extentVec_ )
+		throw( std::bad_alloc );
+	/// Constructor. Copies the components of the given field
+	explicit CComponentPlanes( const CTypedData<TVector>& aField )
+		throw( std::bad_alloc );
+	/// Copy constructor
+	CComponentPlanes( const CComponentPlanes<TVector, D>& somePlanes )
+		throw( std::bad_alloc );
+	/// Destructor
+	virtual ~CComponentPlanes()
+		throw();
+/* Operators */
+	/// Assignment operator
+	CComponentPlanes<TVector, D>& operator=( const CComponentPlanes<TVector, D>& somePlanes )
+		throw( std::bad_alloc );
+/* Accessors */
+	/// Returns the extent of the given dimension (0..2)
+	inline size_t getExtent( const unsigned short usIndex ) const
+		throw();
+	/// Returns the number of elements of one plane
+	inline size_t getPlaneSize() const
+		throw();
+	/// Returns the plane of the given component
+	inline double* getPlane( const unsigned short usComponent )
+		throw();
+	/// Returns the plane of the given component
+	inline const double* getPlane( const unsigned short usComponent ) const
+		throw();
+/* Other methods */
+	/// Copies the components of a field into the planes
+	void fromField( const CTypedData<TVector>& aField )
+		throw();
+	/// Copies the planes into a field
+	void toField( CTypedData<TVector>& aField ) const
+		throw();
+	/// Swaps the contents with other planes of the same extents
+	void swap( CComponentPlanes<TVector, D>& somePlanes )
+		throw();
+	/// Produces an information string about the actual object.
+	virtual const std::string dump() const
+		throw();
+private:
+	size_t extentArr[3];          ///< Field extents
+	size_t planeSize;             ///< Number of elements of one plane
+	CDataBlock<double> dataBlock; ///< All planes, one after another
+};
+
+#include "ccomponentplanes.tpp"
+
+}
+
+#endif
@@ -0,0 +1,168 @@
+/************************************************************************
+ * File: ccomponentplanes.tpp                                           *
+ * Project: AIPS                                                        *
+ * Description: Structure of arrays layout for vector field filters     *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+/*************
+ * Structors *
+ *************/
+
+/** \param extentVec_ extents of the field. Missing dimensions are set to 1 */
+template<typename TVector, unsigned short D>
+CComponentPlanes<TVector, D>::CComponentPlanes( const std::vector<size_t>& extentVec_ )
+	throw( std::bad_alloc ) : CBase( "CComponentPlanes", CCOMPONENTPLANES_VERSION, "CBase" )
+{
+	planeSize = 1;
+	for( unsigned short i = 0; i < 3; ++i )
+	{
+		extentArr[i] = ( i < extentVec_.size() ? extentVec_[i] : 1 );
+		planeSize *= extentArr[i];
+	}
+	dataBlock.reset( D * planeSize, false );
+}
+
+/** \param aField field to copy */
+template<typename TVector, unsigned short D>
+CComponentPlanes<TVector, D>::CComponentPlanes( const CTypedData<TVector>& aField )
+	throw( std::bad_alloc ) : CBase( "CComponentPlanes", CCOMPONENTPLANES_VERSION, "CBase" )
+{
+	planeSize = 1;
+	for( unsigned short i = 0; i < 3; ++i )
+	{
+		extentArr[i] = ( i < aField.getDimension() ? aField.getExtent( i ) : 1 );
+		planeSize *= extentArr[i];
+	}
+	dataBlock.reset( D * planeSize, false );
+	fromField( aField );
+}
+
+/** \param somePlanes planes to copy */
+template<typename TVector, unsigned short D>
+CComponentPlanes<TVector, D>::CComponentPlanes( const CComponentPlanes<TVector, D>& somePlanes )
+	throw( std::bad_alloc ) : CBase( "CComponentPlanes", CCOMPONENTPLANES_VERSION, "CBase" ),
+	planeSize( somePlanes.planeSize ), dataBlock( somePlanes.dataBlock )
+{
+	for( unsigned short i = 0; i < 3; ++i )
+		extentArr[i] = somePlanes.extentArr[i];
+}
+
+template<typename TVector, unsigned short D>
+CComponentPlanes<TVector, D>::~CComponentPlanes() throw()
+{
+}
+
+/*************
+ * Operators *
+ *************/
+
+/** \param somePlanes planes to copy */
+template<typename TVector, unsigned short D>
+CComponentPlanes<TVector, D>& CComponentPlanes<TVector, D>::operator=(
+	const CComponentPlanes<TVector, D>& somePlanes ) throw( std::bad_alloc )
+{
+	if ( &somePlanes == this )
+		return *this;
+	for( unsigned short i = 0; i < 3; ++i )
+		extentArr[i] = somePlanes.extentArr[i];
+	planeSize = somePlanes.planeSize;
+	dataBlock = somePlanes.dataBlock;
+	return *this;
+}
+
+/*************
+ * Accessors *
+ *************/
+
+/** \param usIndex dimension (0..2) */
+template<typename TVector, unsigned short D> inline
+size_t CComponentPlanes<TVector, D>::getExtent( const unsigned short usIndex ) const throw()
+{
+	return extentArr[usIndex];
+}
+
+template<typename TVector, unsigned short D> inline
+size_t CComponentPlanes<TVector, D>::getPlaneSize() const throw()
+{
+	return planeSize;
+}
+
+/** \param usComponent vector component (0..D-1) */
+template<typename TVector, unsigned short D> inline
+double* CComponentPlanes<TVector, D>::getPlane( const unsigned short usComponent ) throw()
+{
+	return dataBlock.getData() + usComponent * planeSize;
+}
+
+/** \param usComponent vector component (0..D-1) */
+template<typename TVector, unsigned short D> inline
+const double* CComponentPlanes<TVector, D>::getPlane( const unsigned short usComponent ) const throw()
+{
+	return dataBlock.getData() + usComponent * planeSize;
+}
+
+/*****************
+ * Other methods *
+ *****************/
+
+/**
+ * The field must have the extents of the planes.
+ * \param aField field to copy
+ */
+template<typename TVector, unsigned short D>
+void CComponentPlanes<TVector, D>::fromField( const CTypedData<TVector>& aField ) throw()
+{
+	double* planePtrArr[D];
+	for( unsigned short c = 0; c < D; ++c )
+		planePtrArr[c] = getPlane( c );
+	for( size_t i = 0; i < planeSize; ++i )
+	{
+		const TVector& theVector = aField[i];
+		for( unsigned short c = 0; c < D; ++c )
+			planePtrArr[c][i] = theVector[c];
+	}
+}
+
+/**
+ * The field must have the extents of the planes. Its data range is left untouched.
+ * \param aField target field
+ */
+template<typename TVector, unsigned short D>
+void CComponentPlanes<TVector, D>::toField( CTypedData<TVector>& aField ) const throw()
+{
+	const double* planePtrArr[D];
+	for( unsigned short c = 0; c < D; ++c )
+		planePtrArr[c] = getPlane( c );
+	TVector* fieldArr = aField.getArray();
+	for( size_t i = 0; i < planeSize; ++i )
+		for( unsigned short c = 0; c < D; ++c )
+			fieldArr[i][c] = planePtrArr[c][i];
+}
+
+/** \param somePlanes planes to swap contents with */
+template<typename TVector, unsigned short D>
+void CComponentPlanes<TVector, D>::swap( CComponentPlanes<TVector, D>& somePlanes ) throw()
+{
+	for( unsigned short i = 0; i < 3; ++i )
+		std::swap( extentArr[i], somePlanes.extentArr[i] );
+	std::swap( planeSize, somePlanes.planeSize );
+	dataBlock.swap( somePlanes.dataBlock );
+}
+
+template<typename TVector, unsigned short D>
+const std::string CComponentPlanes<TVector, D>::dump() const throw()
+{
+	std::ostringstream os;
+	os << "extents " << extentArr[0] << " " << extentArr[1] << " " << extentArr[2]
+		<< " components " << D << " planeSize " << planeSize << "\n";
+	return CBase::dump() + os.str();
+}
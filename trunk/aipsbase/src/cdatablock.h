@@ -0,0 +1,134 @@
+/************************************************************************
+ * File: cdatablock.h                                                   *
+ * Project: AIPS                                                        *
+ * Description: Pooled and aligned element storage for CTypedData       *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Version: 0.1                                                         *
+ * Status : Beta                                                        *
+ * Created: 2026-10-17                                                  *
+ * Changed: 2026-10-17 Blocks may refer to a memory mapped file         *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#ifndef CDATABLOCK_H
+#define CDATABLOCK_H
+
+// Standard includes
+#include <algorithm> // std::swap
+#include <cstring>   // memset, memcpy
+#include <memory>    // std::uninitialized_copy
+
+// Boost includes
+#include <boost/shared_ptr.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_pod.hpp>
+
+// AIPS includes
+#include "cdatapool.h"
+#include "cmappedfile.h"
+
+namespace aips {
+
+/**
+ * \brief A contiguous array of elements allocated from the global CDataPool.
+ *
+ * The array start is aligned to DATAPOOL_ALIGNMENT bytes. For plain old data
+ * types the elements may be left uninitialised, which avoids touching the
+ * memory twice if it will be overwritten anyway. Elements of all other types
+ * (e.g. std::string) are always default constructed.
+ *
+ * Alternatively, a block of a plain old data type may refer to a part of a
+ * CMappedFile. The file stays mapped as long as the block exists. Such blocks
+ * are only aligned to the size of TValue.
+ */
+template<typename TValue>
+class CDataBlock
+{
+public:
+/* Structors */
+	/// Constructor for an empty block
+	CDataBlock()
+		throw();
+	/// Constructor
+	explicit CDataBlock( const size_t theSize_, const bool bInitialise = true )
+		throw( std::bad_alloc );
+	/// Constructor for a block inside a memory mapped file
+	CDataBlock( boost::shared_ptr<CMappedFile> aMappedFileSPtr, const size_t fileOffset,
+		const size_t theSize_ ) throw();
+	/// Copy constructor
+	CDataBlock( const CDataBlock<TValue>& aBlock )
+		throw( std::bad_alloc );
+	/// Destructor
+	~CDataBlock()
+		throw();
+/* Operators */
+	/// Assignment operator (copies all elements)
+	CDataBlock<TValue>& operator=( const CDataBlock<TValue>& aBlock )
+		throw( std::bad_alloc );
+	/// Element access without range checking
+	TValue& operator[]( const size_t index )
+		throw();
+	/// Constant element access without range checking
+	const TValue& operator[]( const size_t index ) const
+		throw();
+/* Accessors */
+	/// Returns a pointer to the first element
+	TValue* getData()
+		throw();
+	/// Returns a constant pointer to the first element
+	const TValue* getData() const
+		throw();
+	/// Returns the number of elements
+	size_t getSize() const
+		throw();
+	/// Returns true if the block refers to a memory mapped file
+	bool isMapped() const
+		throw();
+/* Other methods */
+	/// Replaces the contents by a new block of the given size
+	void reset( const size_t theSize_ = 0, const bool bInitialise = true )
+		throw( std::bad_alloc );
+	/// Swaps the contents with another block
+	void swap( CDataBlock<TValue>& aBlock )
+		throw();
+private:
+	/// Allocates and (optionally) initialises the element array
+	void allocate( const size_t theSize_, const bool bInitialise )
+		throw( std::bad_alloc );
+	/// Destroys all elements and gives the memory back to the pool
+	void deallocate()
+		throw();
+	/// Copies the elements of plain old data types bytewise
+	void assign( const CDataBlock<TValue>& aBlock, boost::true_type )
+		throw( std::bad_alloc );
+	/// Copies the elements of other types one by one
+	void assign( const CDataBlock<TValue>& aBlock, boost::false_type )
+		throw( std::bad_alloc );
+	/// Zeroes elements of plain old data types if requested
+	void construct( const bool bInitialise, boost::true_type )
+		throw();
+	/// Default constructs elements of other types
+	void construct( const bool bInitialise, boost::false_type )
+		throw();
+	/// Nothing to do for plain old data types
+	void destroy( boost::true_type )
+		throw();
+	/// Calls the destructor of each element
+	void destroy( boost::false_type )
+		throw();
+	TValue* dataPtr; ///< First element
+	size_t theSize;  ///< Number of elements
+	boost::shared_ptr<CMappedFile> mappedFileSPtr; ///< Mapped file holding the elements (if any)
+};
+
+#include "cdatablock.tpp"
+
+}
+
+#endif
@@ -0,0 +1,256 @@
+/************************************************************************
+ * File: cdatablock.tpp                                                 *
+ * Project: AIPS                                                        *
+ * Description: Pooled and aligned element storage for CTypedData       *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+/*************
+ * Structors *
+ *************/
+
+template<typename TValue> inline
+CDataBlock<TValue>::CDataBlock() throw()
+	: dataPtr( NULL ), theSize( 0 )
+{
+}
+
+/**
+ * \param theSize_ number of elements
+ * \param bInitialise if false, elements of plain old data types are left uninitialised.
+ *   Otherwise they are set to zero.
+ */
+template<typename TValue> inline
+CDataBlock<TValue>::CDataBlock( const size_t theSize_, const bool bInitialise )
+	throw( std::bad_alloc ) : dataPtr( NULL ), theSize( 0 )
+{
+	allocate( theSize_, bInitialise );
+}
+
+/**
+ * The caller has to ensure that the file holds at least theSize_ elements
+ * behind fileOffset and that fileOffset is a multiple of sizeof( TValue ).
+ * TValue must be a plain old data type.
+ * \param aMappedFileSPtr the mapped file
+ * \param fileOffset offset of the first element in the file (in bytes)
+ * \param theSize_ number of elements
+ */
+template<typename TValue> inline
+CDataBlock<TValue>::CDataBlock( boost::shared_ptr<CMappedFile> aMappedFileSPtr,
+	const size_t fileOffset, const size_t theSize_ ) throw()
+	: dataPtr( reinterpret_cast<TValue*>( aMappedFileSPtr->getData() + fileOffset ) ),
+	theSize( theSize_ ), mappedFileSPtr( aMappedFileSPtr )
+{
+}
+
+/**
+ * The copy is always allocated from the data pool.
+ * \param aBlock block to copy
+ */
+template<typename TValue> inline
+CDataBlock<TValue>::CDataBlock( const CDataBlock<TValue>& aBlock )
+	throw( std::bad_alloc ) : dataPtr( NULL ), theSize( 0 )
+{
+	(*this) = aBlock;
+}
+
+template<typename TValue> inline
+CDataBlock<TValue>::~CDataBlock() throw()
+{
+	deallocate();
+}
+
+/*************
+ * Operators *
+ *************/
+
+/**
+ * The old memory block is reused if the sizes of both blocks are equal.
+ * \param aBlock block to copy
+ */
+template<typename TValue> inline
+CDataBlock<TValue>& CDataBlock<TValue>::operator=( const CDataBlock<TValue>& aBlock )
+	throw( std::bad_alloc )
+{
+	if ( &aBlock == this )
+		return *this;
+	assign( aBlock, boost::is_pod<TValue>() );
+	return *this;
+}
+
+/** \param index element index */
+template<typename TValue> inline
+TValue& CDataBlock<TValue>::operator[]( const size_t index ) throw()
+{
+	return dataPtr[index];
+}
+
+/** \param index element index */
+template<typename TValue> inline
+const TValue& CDataBlock<TValue>::operator[]( const size_t index ) const throw()
+{
+	return dataPtr[index];
+}
+
+/*************
+ * Accessors *
+ *************/
+
+/** \returns pointer to the first element */
+template<typename TValue> inline
+TValue* CDataBlock<TValue>::getData() throw()
+{
+	return dataPtr;
+}
+
+/** \returns constant pointer to the first element */
+template<typename TValue> inline
+const TValue* CDataBlock<TValue>::getData() const throw()
+{
+	return dataPtr;
+}
+
+/** \returns number of elements */
+template<typename TValue> inline
+size_t CDataBlock<TValue>::getSize() const throw()
+{
+	return theSize;
+}
+
+/** \returns true if the elements are stored in a memory mapped file */
+template<typename TValue> inline
+bool CDataBlock<TValue>::isMapped() const throw()
+{
+	return mappedFileSPtr.get() != NULL;
+}
+
+/*****************
+ * Other methods *
+ *****************/
+
+/**
+ * \param theSize_ new number of elements
+ * \param bInitialise if false, elements of plain old data types are left uninitialised
+ */
+template<typename TValue> inline
+void CDataBlock<TValue>::reset( const size_t theSize_, const bool bInitialise )
+	throw( std::bad_alloc )
+{
+	deallocate();
+	allocate( theSize_, bInitialise );
+}
+
+/** \param aBlock block to swap contents with */
+template<typename TValue> inline
+void CDataBlock<TValue>::swap( CDataBlock<TValue>& aBlock ) throw()
+{
+	std::swap( dataPtr, aBlock.dataPtr );
+	std::swap( theSize, aBlock.theSize );
+	mappedFileSPtr.swap( aBlock.mappedFileSPtr );
+}
+
+/**
+ * \param theSize_ number of elements
+ * \param bInitialise if false, elements of plain old data types are left uninitialised
+ */
+template<typename TValue> inline
+void CDataBlock<TValue>::allocate( const size_t theSize_, const bool bInitialise )
+	throw( std::bad_alloc )
+{
+	if ( theSize_ == 0 )
+		return;
+	dataPtr = static_cast<TValue*>( getDataPool().allocate( theSize_ * sizeof( TValue ) ) );
+	theSize = theSize_;
+	construct( bInitialise, boost::is_pod<TValue>() );
+}
+
+template<typename TValue> inline
+void CDataBlock<TValue>::deallocate() throw()
+{
+	if ( dataPtr == NULL )
+		return;
+	if ( mappedFileSPtr )
+	{
+		mappedFileSPtr.reset();
+		dataPtr = NULL;
+		theSize = 0;
+		return;
+	}
+	destroy( boost::is_pod<TValue>() );
+	getDataPool().release( dataPtr, theSize * sizeof( TValue ) );
+	dataPtr = NULL;
+	theSize = 0;
+}
+
+/**
+ * Copies a block of a plain old data type bytewise.
+ * \param aBlock block to copy
+ */
+template<typename TValue> inline
+void CDataBlock<TValue>::assign( const CDataBlock<TValue>& aBlock, boost::true_type )
+	throw( std::bad_alloc )
+{
+	if ( theSize != aBlock.theSize )
+		reset( aBlock.theSize, false );
+	if ( theSize > 0 )
+		memcpy( dataPtr, aBlock.dataPtr, theSize * sizeof( TValue ) );
+}
+
+/**
+ * Copies a block element by element. The old elements are assigned to if the
+ * sizes are equal, otherwise new elements are copy constructed.
+ * \param aBlock block to copy
+ */
+template<typename TValue> inline
+void CDataBlock<TValue>::assign( const CDataBlock<TValue>& aBlock, boost::false_type )
+	throw( std::bad_alloc )
+{
+	if ( theSize == aBlock.theSize )
+	{
+		std::copy( aBlock.dataPtr, aBlock.dataPtr + theSize, dataPtr );
+		return;
+	}
+	deallocate();
+	if ( aBlock.theSize > 0 )
+	{
+		dataPtr = static_cast<TValue*>( getDataPool().allocate( aBlock.theSize * sizeof( TValue ) ) );
+		std::uninitialized_copy( aBlock.dataPtr, aBlock.dataPtr + aBlock.theSize, dataPtr );
+		theSize = aBlock.theSize;
+	}
+}
+
+/** \param bInitialise if false, the elements are left uninitialised */
+template<typename TValue> inline
+void CDataBlock<TValue>::construct( const bool bInitialise, boost::true_type ) throw()
+{
+	if ( bInitialise )
+		memset( dataPtr, 0, theSize * sizeof( TValue ) );
+}
+
+/** Elements of other types are always default constructed */
+template<typename TValue> inline
+void CDataBlock<TValue>::construct( const bool, boost::false_type ) throw()
+{
+	for( size_t i = 0; i < theSize; ++i )
+		new( dataPtr + i ) TValue();
+}
+
+template<typename TValue> inline
+void CDataBlock<TValue>::destroy( boost::true_type ) throw()
+{
+}
+
+template<typename TValue> inline
+void CDataBlock<TValue>::destroy( boost::false_type ) throw()
+{
+	for( size_t i = 0; i < theSize; ++i )
+		dataPtr[i].~TValue();
+}
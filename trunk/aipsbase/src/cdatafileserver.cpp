@@ -178,6 +178,72 @@ void CDataFileServer::saveDataSet( const string& sFilename, const TDataFile& the
   	throw( anException );
 }
 
+/**
+ * \param sFilename Name of the file
+ * \returns the extents of the dataset in the file
+ * \throws FileException if no handler supports the file or the file cannot be read
+ */
+vector<size_t> CDataFileServer::loadExtents( const string& sFilename ) const
+  throw( FileException )
+{
+  return findHandler( sFilename )->loadExtents( sFilename );
+}
+
+/**
+ * Handlers of uncompressed binary formats only read the requested part of the
+ * file, all other handlers load the whole dataset (see CFileHandler::loadRegion()).
+ * \param sFilename Name of the file
+ * \param regionOriginVec first voxel of the region
+ * \param regionExtentVec extents of the region
+ * \returns a new dataset holding the region
+ * \throws FileException if no handler supports the file or the region cannot be loaded
+ */
+TDataSetPtr CDataFileServer::loadRegion( const string& sFilename, const vector<size_t>& regionOriginVec,
+  const vector<size_t>& regionExtentVec ) const throw( FileException )
+{
+  return findHandler( sFilename )->loadRegion( sFilename, regionOriginVec, regionExtentVec );
+}
+
+/**
+ * \param sFilename Name of the file
+ * \returns true if the handler of the file supports beginRegionSave() and saveRegion()
+ */
+bool CDataFileServer::supportsRegionSave( const string& sFilename ) const throw()
+{
+  try
+  {
+    return findHandler( sFilename )->supportsRegionSave();
+  }
+  catch ( FileException& )
+  {
+    return false;
+  }
+}
+
+/**
+ * \param sFilename Name of the file
+ * \param theData Pair of one region of the dataset and (optional) header information
+ * \param extentVec extents of the complete dataset
+ * \throws FileException if no handler supports the file or the files cannot be created
+ */
+void CDataFileServer::beginRegionSave( const string& sFilename, const TDataFile& theData,
+  const vector<size_t>& extentVec ) const throw( FileException )
+{
+  findHandler( sFilename )->beginRegionSave( sFilename, theData, extentVec );
+}
+
+/**
+ * \param sFilename Name of the file
+ * \param aRegionPtr the region
+ * \param regionOriginVec position of the first voxel of the region in the complete dataset
+ * \throws FileException on any file error
+ */
+void CDataFileServer::saveRegion( const string& sFilename, TDataSetPtr aRegionPtr,
+  const vector<size_t>& regionOriginVec ) const throw( FileException )
+{
+  findHandler( sFilename )->saveRegion( sFilename, aRegionPtr, regionOriginVec );
+}
+
 /**
  * \return file mask
  */
@@ -224,3 +290,19 @@ unsigned int CDataFileServer::getNumberOfRegisteredHandlers() throw()
 {
 	return fileHandlerSPtrVec.size();
 }
+
+/**
+ * \param sFilename Name of the file
+ * \returns the first registered handler which supports the file
+ * \throws FileException if the file name has no extension or no handler supports it
+ */
+boost::shared_ptr<CFileHandler> CDataFileServer::findHandler( const string& sFilename ) const
+  throw( FileException )
+{
+  if ( sFilename.find( ".", 1 ) == string::npos )
+    throw ( FileException( SERROR( "No file extension specified" ), CException::RECOVER, ERR_ILLEGALFILENAME ) );
+  for ( THandlerVec::const_iterator it = fileHandlerSPtrVec.begin(); it != fileHandlerSPtrVec.end(); ++it )
+    if( (*it)->supports( sFilename ) )
+      return *it;
+  throw( FileException( SERROR("No appropiate file handler found"), CException::RECOVER ) );
+}
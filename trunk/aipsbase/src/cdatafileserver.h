@@ -27,6 +27,7 @@
  *        2005-08-01 Updated documentation                              *
  *                   Minor code improvements                            *
  *        2005-11-21 Updated documentation                              *
+ *        2026-10-17 Added loading and saving of regions                *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -100,6 +101,24 @@ public:
   /// Saves a data set. The correct file handler will be determined automatically
   void saveDataSet( const std::string& sFilename, const TDataFile& theData ) const
     throw( FileException, NullException );
+  /// Returns the extents of the dataset in a file without loading it (if possible)
+  std::vector<size_t> loadExtents( const std::string& sFilename ) const
+    throw( FileException );
+  /// Loads a region of the dataset in a file
+  TDataSetPtr loadRegion( const std::string& sFilename, const std::vector<size_t>& regionOriginVec,
+    const std::vector<size_t>& regionExtentVec ) const
+    throw( FileException );
+  /// Returns true if datasets can be saved region by region in the given file format
+  bool supportsRegionSave( const std::string& sFilename ) const
+    throw();
+  /// Creates the files for a dataset which is saved region by region
+  void beginRegionSave( const std::string& sFilename, const TDataFile& theData,
+    const std::vector<size_t>& extentVec ) const
+    throw( FileException );
+  /// Saves a region of a dataset into the files created by beginRegionSave()
+  void saveRegion( const std::string& sFilename, TDataSetPtr aRegionPtr,
+    const std::vector<size_t>& regionOriginVec ) const
+    throw( FileException );
   /// Returns a string containing a file mask for all supported file types
   const std::string supportedFileTypes() const
     throw();
@@ -114,6 +133,9 @@ public:
     throw();
   //@}
 private:
+	/// Returns the first handler supporting the given file
+	boost::shared_ptr<CFileHandler> findHandler( const std::string& sFilename ) const
+		throw( FileException );
 	/// Vector of all registered file handlers 
 	static std::vector<boost::shared_ptr<CFileHandler> > fileHandlerSPtrVec; 
 };
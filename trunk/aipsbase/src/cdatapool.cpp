@@ -0,0 +1,309 @@
+/************************************************************************
+ * File: cdatapool.cpp                                                  *
+ * Project: AIPS                                                        *
+ * Description: A pool of aligned memory blocks for dataset storage     *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#include "cdatapool.h"
+
+// Standard includes
+#include <cstdlib>
+#include <sstream>
+#ifdef WIN32
+#include <malloc.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace aips;
+
+namespace
+{
+
+/// Returns the size of the physical memory in bytes, 0 if it is unknown
+size_t physicalMemory()
+{
+#ifdef WIN32
+	MEMORYSTATUSEX theStatus;
+	theStatus.dwLength = sizeof( theStatus );
+	if ( GlobalMemoryStatusEx( &theStatus ) )
+		return static_cast<size_t>( theStatus.ullTotalPhys );
+#elif defined( _SC_PHYS_PAGES ) && defined( _SC_PAGESIZE )
+	const long lPages = sysconf( _SC_PHYS_PAGES );
+	const long lPageSize = sysconf( _SC_PAGESIZE );
+	if ( lPages > 0 && lPageSize > 0 )
+		return static_cast<size_t>( lPages ) * static_cast<size_t>( lPageSize );
+#endif
+	return 0;
+}
+
+/// Returns the default limit of the pool: an eighth of the physical memory, at least 256 MB
+size_t defaultMaximumCachedBytes()
+{
+	const size_t minimumBytes = static_cast<size_t>( 1 ) << 28;
+	const size_t theBytes = physicalMemory() / 8;
+	return ( theBytes > minimumBytes ) ? theBytes : minimumBytes;
+}
+
+}
+
+/*************
+ * Structors *
+ *************/
+
+/**
+ * By default, up to an eighth of the physical memory is kept for reuse, but at
+ * least 256 MB (one 512^3 volume of 16 bit voxels). The environment variable
+ * AIPS_DATA_POOL overrides this limit (in megabytes).
+ */
+CDataPool::CDataPool() throw()
+	: CBase( "CDataPool", CDATAPOOL_VERSION, "CBase" ), cachedBytes( 0 ),
+	maxCachedBytes( defaultMaximumCachedBytes() ), reusedBytes( 0 )
+{
+	const char* sLimit = getenv( "AIPS_DATA_POOL" );
+	if ( sLimit != NULL && *sLimit != '\0' )
+		maxCachedBytes = static_cast<size_t>( strtoul( sLimit, NULL, 10 ) ) << 20;
+}
+
+CDataPool::~CDataPool() throw()
+{
+	clear();
+}
+
+/*************
+ * Accessors *
+ *************/
+
+/** \returns the number of bytes kept in the free lists */
+size_t CDataPool::getCachedBytes() const throw()
+{
+	boost::mutex::scoped_lock lock( poolMutex );
+	return cachedBytes;
+}
+
+/** \returns the number of bytes allocate() took from the free lists so far */
+size_t CDataPool::getReusedBytes() const throw()
+{
+	boost::mutex::scoped_lock lock( poolMutex );
+	return reusedBytes;
+}
+
+/** \returns the maximum number of bytes kept in the free lists */
+size_t CDataPool::getMaximumCachedBytes() const throw()
+{
+	boost::mutex::scoped_lock lock( poolMutex );
+	return maxCachedBytes;
+}
+
+/************
+ * Mutators *
+ ************/
+
+/**
+ * Cached blocks exceeding the new limit are freed at once.
+ * \param maxCachedBytes_ new maximum number of bytes kept in the free lists
+ */
+void CDataPool::setMaximumCachedBytes( const size_t maxCachedBytes_ ) throw()
+{
+	boost::mutex::scoped_lock lock( poolMutex );
+	maxCachedBytes = maxCachedBytes_;
+	shrinkTo( maxCachedBytes );
+}
+
+/*****************
+ * Other methods *
+ *****************/
+
+/**
+ * The contents of the returned block are undefined.
+ * \param blockSize requested size in bytes
+ * \returns pointer to a block aligned to DATAPOOL_ALIGNMENT bytes
+ * \throws std::bad_alloc if no memory is available
+ */
+void* CDataPool::allocate( const size_t blockSize ) throw( std::bad_alloc )
+{
+	size_t theClass = sizeClass( blockSize );
+	{
+		boost::mutex::scoped_lock lock( poolMutex );
+		requestedClassesSet.insert( theClass );
+		TFreeListMap::iterator it = freeListMap.find( theClass );
+		if ( it != freeListMap.end() && !it->second.empty() )
+		{
+			void* blockPtr = it->second.back();
+			it->second.pop_back();
+			cachedBytes -= theClass;
+			reusedBytes += theClass;
+			return blockPtr;
+		}
+	}
+	try
+	{
+		return alignedAlloc( theClass );
+	}
+	catch( std::bad_alloc& )
+	{
+		// Give all cached blocks back to the system and try again
+		clear();
+		return alignedAlloc( theClass );
+	}
+}
+
+/**
+ * \param blockPtr block to release. Must have been allocated by allocate()
+ * \param blockSize the size that was given to allocate()
+ */
+void CDataPool::release( void* blockPtr, const size_t blockSize ) throw()
+{
+	if ( blockPtr == NULL )
+		return;
+	size_t theClass = sizeClass( blockSize );
+	{
+		boost::mutex::scoped_lock lock( poolMutex );
+		if ( cachedBytes + theClass <= maxCachedBytes )
+		{
+			freeListMap[theClass].push_back( blockPtr );
+			cachedBytes += theClass;
+			return;
+		}
+	}
+	alignedFree( blockPtr );
+}
+
+void CDataPool::clear() throw()
+{
+	boost::mutex::scoped_lock lock( poolMutex );
+	shrinkTo( 0 );
+}
+
+/**
+ * Called by CPipelineItem after each pipeline run. Blocks of size classes the
+ * run did not allocate are left over from earlier runs with other extents or
+ * data types and are unlikely to be reused.
+ */
+void CDataPool::trim() throw()
+{
+	boost::mutex::scoped_lock lock( poolMutex );
+	TFreeListMap::iterator it = freeListMap.begin();
+	while( it != freeListMap.end() )
+	{
+		if ( requestedClassesSet.find( it->first ) != requestedClassesSet.end() )
+		{
+			++it;
+			continue;
+		}
+		for( std::vector<void*>::iterator blockIt = it->second.begin(); blockIt != it->second.end(); ++blockIt )
+			alignedFree( *blockIt );
+		cachedBytes -= it->first * it->second.size();
+		freeListMap.erase( it++ );
+	}
+	requestedClassesSet.clear();
+}
+
+const std::string CDataPool::dump() const throw()
+{
+	boost::mutex::scoped_lock lock( poolMutex );
+	std::ostringstream os;
+	os << "cachedBytes " << cachedBytes << " maxCachedBytes " << maxCachedBytes
+		<< " reusedBytes " << reusedBytes << "\n";
+	for( TFreeListMap::const_iterator it = freeListMap.begin(); it != freeListMap.end(); ++it )
+		os << "- class " << it->first << " : " << it->second.size() << " blocks\n";
+	return CBase::dump() + os.str();
+}
+
+/*******************
+ * Private methods *
+ *******************/
+
+/**
+ * Blocks are rounded up to a multiple of 1/8th of the next lower power of two,
+ * so each size class wastes at most 12.5% of the requested memory.
+ * \param blockSize requested size in bytes
+ * \returns size of the block that will actually be allocated
+ */
+size_t CDataPool::sizeClass( const size_t blockSize ) throw()
+{
+	if ( blockSize <= DATAPOOL_ALIGNMENT )
+		return DATAPOOL_ALIGNMENT;
+	size_t highestBit = 1;
+	while( ( highestBit << 1 ) <= blockSize )
+		highestBit <<= 1;
+	size_t step = highestBit >> 3;
+	if ( step < DATAPOOL_ALIGNMENT )
+		step = DATAPOOL_ALIGNMENT;
+	return ( ( blockSize + step - 1 ) / step ) * step;
+}
+
+/**
+ * \param blockSize size in bytes
+ * \throws std::bad_alloc if no memory is available
+ */
+void* CDataPool::alignedAlloc( const size_t blockSize ) throw( std::bad_alloc )
+{
+	void* blockPtr = NULL;
+#ifdef WIN32
+	blockPtr = _aligned_malloc( blockSize, DATAPOOL_ALIGNMENT );
+#else
+	if ( posix_memalign( &blockPtr, DATAPOOL_ALIGNMENT, blockSize ) != 0 )
+		blockPtr = NULL;
+#endif
+	if ( blockPtr == NULL )
+		throw std::bad_alloc();
+	return blockPtr;
+}
+
+/** \param blockPtr block to free */
+void CDataPool::alignedFree( void* blockPtr ) throw()
+{
+#ifdef WIN32
+	_aligned_free( blockPtr );
+#else
+	free( blockPtr );
+#endif
+}
+
+/**
+ * Frees the largest blocks first, since they are the most expensive to keep.
+ * \param maxBytes number of bytes which may stay in the free lists
+ */
+void CDataPool::shrinkTo( const size_t maxBytes ) throw()
+{
+	while( cachedBytes > maxBytes && !freeListMap.empty() )
+	{
+		TFreeListMap::iterator it = freeListMap.end();
+		--it;
+		while( !it->second.empty() && cachedBytes > maxBytes )
+		{
+			alignedFree( it->second.back() );
+			it->second.pop_back();
+			cachedBytes -= it->first;
+		}
+		if ( it->second.empty() )
+			freeListMap.erase( it );
+	}
+}
+
+/*************************
+ * Global pool instance *
+ *************************/
+
+namespace aips {
+
+/** \returns the global data pool */
+CDataPool& getDataPool() throw()
+{
+	static CDataPool theDataPool;
+	return theDataPool;
+}
+
+}
@@ -0,0 +1,132 @@
+/************************************************************************
+ * File: cdatapool.h                                                    *
+ * Project: AIPS                                                        *
+ * Description: A pool of aligned memory blocks for dataset storage     *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Version: 0.1                                                         *
+ * Status : Beta                                                        *
+ * Created: 2026-10-17                                                  *
+ * Changed: 2026-10-17 RAM based limit, AIPS_DATA_POOL and trim()       *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#ifndef CDATAPOOL_H
+#define CDATAPOOL_H
+
+#define CDATAPOOL_VERSION "0.1"
+
+// Standard includes
+#include <map>
+#include <new> // std::bad_alloc
+#include <set>
+#include <vector>
+
+// Boost includes
+#include <boost/thread/mutex.hpp>
+
+// AIPS includes
+#include "cbase.h"
+
+namespace aips {
+
+/**
+ * \brief A pool of aligned memory blocks used as storage of CTypedData.
+ *
+ * Released blocks are not returned to the operating system but kept in
+ * free lists, sorted by size classes. Each size class wastes at most
+ * 1/8th of the requested size. A new request of the same size class (e.g.
+ * the output of a filter on the next pipeline run) gets the old block back
+ * without any page faults. All blocks are aligned to DATAPOOL_ALIGNMENT
+ * bytes. The pool is thread safe.
+ *
+ * By default, the pool keeps up to an eighth of the physical memory, but at
+ * least 256 MB. If the environment variable AIPS_DATA_POOL is set, it gives
+ * the limit in megabytes instead (0 disables the pool). After each pipeline run, trim() frees the blocks of all size
+ * classes the run did not request, so the pool only holds memory that the
+ * next run of the same pipeline can reuse.
+ *
+ * Use getDataPool() to retrieve the global instance.
+ */
+class CDataPool : public CBase
+{
+private:
+	/// Copy constructor
+	CDataPool( const CDataPool& );
+	/// Assignment operator
+	CDataPool& operator=( const CDataPool& );
+public:
+/* Structors */
+	/// Constructor
+	CDataPool()
+		throw();
+	/// Destructor
+	virtual ~CDataPool()
+		throw();
+/* Accessors */
+	/// Returns the number of bytes kept in the free lists
+	size_t getCachedBytes() const
+		throw();
+	/// Returns the maximum number of bytes kept in the free lists
+	size_t getMaximumCachedBytes() const
+		throw();
+	/// Returns the number of bytes handed out again from the free lists
+	size_t getReusedBytes() const
+		throw();
+/* Mutators */
+	/// Sets the maximum number of bytes kept in the free lists
+	void setMaximumCachedBytes( const size_t maxCachedBytes_ )
+		throw();
+/* Other methods */
+	/// Allocates an aligned memory block of at least the given size
+	void* allocate( const size_t blockSize )
+		throw( std::bad_alloc );
+	/// Returns a memory block to the pool
+	void release( void* blockPtr, const size_t blockSize )
+		throw();
+	/// Frees all cached memory blocks
+	void clear()
+		throw();
+	/// Frees the blocks of all size classes not requested since the last call
+	void trim()
+		throw();
+	/// Reimplemented from CBase
+	virtual const std::string dump() const
+		throw();
+private:
+	/// Computes the size class of a requested block size
+	static size_t sizeClass( const size_t blockSize )
+		throw();
+	/// Allocates a new aligned block from the operating system
+	static void* alignedAlloc( const size_t blockSize )
+		throw( std::bad_alloc );
+	/// Frees a block allocated by alignedAlloc()
+	static void alignedFree( void* blockPtr )
+		throw();
+	/// Frees cached blocks until at most maxBytes are left. poolMutex must be locked
+	void shrinkTo( const size_t maxBytes )
+		throw();
+	typedef std::map<size_t, std::vector<void*> > TFreeListMap;
+	TFreeListMap freeListMap; ///< Free blocks for each size class
+	size_t cachedBytes;       ///< Number of bytes in all free lists
+	size_t maxCachedBytes;    ///< Upper bound for cachedBytes
+	size_t reusedBytes;       ///< Bytes allocate() took from the free lists
+	std::set<size_t> requestedClassesSet; ///< Size classes requested since the last trim()
+	mutable boost::mutex poolMutex; ///< Guards all members above
+};
+
+/// Alignment of all blocks allocated by CDataPool (one cache line)
+const size_t DATAPOOL_ALIGNMENT = 64;
+
+/// Returns the global data pool
+CDataPool& getDataPool()
+	throw();
+
+}
+
+#endif
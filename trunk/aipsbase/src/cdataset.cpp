@@ -378,3 +378,42 @@ const string CDataSet::dump() const throw()
 
   return CBase::dump() + os.str();
 }
+
+/**
+ * The base class doesn't know anything about its data. Reimplement this in derived classes.
+ * \returns the size of the data in bytes
+ */
+size_t CDataSet::getDataSize() const throw()
+{
+  return 0;
+}
+
+/**
+ * The base class doesn't know how to copy data. Reimplement this in derived classes.
+ * \param regionOriginVec first voxel of the region
+ * \param regionExtentVec extents of the region
+ * \returns a new data set holding the region or NULL if the region can't be copied
+ */
+CDataSet* CDataSet::cloneRegion( const std::vector<size_t>&, const std::vector<size_t>& ) const throw()
+{
+  return NULL;
+}
+
+/**
+ * The base class doesn't know how to copy data. Reimplement this in derived classes.
+ * \param aRegion data set to copy
+ * \param regionOriginVec position of the first voxel of aRegion in this data set
+ * \returns true if the data was copied
+ */
+bool CDataSet::insertRegion( const CDataSet&, const std::vector<size_t>& ) throw()
+{
+  return false;
+}
+
+/**
+ * The base class never shares its data. Reimplement this in derived classes
+ * which share data with their copies.
+ */
+void CDataSet::detach() throw()
+{
+}
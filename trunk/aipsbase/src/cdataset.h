@@ -32,6 +32,10 @@
  *        2005-11-20 Update documentation                               *
  *                   Added verbose output                               *
  *        2006-05-17 Added convenicence method getSize()                *
+ *        2026-10-17 Added pure virtual method clone()                  *
+ *                   Added cloneRegion() and insertRegion()             *
+ *                   Added virtual method getDataSize()                 *
+ *                   Added virtual method detach()                      *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -141,6 +145,9 @@ public:
   /// Get the number of elements in the data set
   size_t getSize() const
     throw();
+  /// Returns the size of the data in bytes
+  virtual size_t getDataSize() const
+    throw();
   //@}
 /** \name Mutators */
   //@{
@@ -174,6 +181,18 @@ public:
   /// Reimplemented from CBase
   virtual const std::string dump() const
     throw();
+  /// Returns a new copy of the data set. Pure virtual method.
+  virtual CDataSet* clone() const
+    throw() =0;
+  /// Returns a new copy of a part of the data set
+  virtual CDataSet* cloneRegion( const std::vector<size_t>& regionOriginVec,
+    const std::vector<size_t>& regionExtentVec ) const throw();
+  /// Copies a data set into a part of this data set
+  virtual bool insertRegion( const CDataSet& aRegion, const std::vector<size_t>& regionOriginVec )
+    throw();
+  /// Gives the data set an own copy of its data if it shares it with another one
+  virtual void detach()
+    throw();
   //@}
 protected:
   unsigned short usDimension;            ///< Dimension of the data set
@@ -74,6 +74,21 @@ CDataSetRegion::~CDataSetRegion() throw()
   if ( isVerbose() )
     alog << LINFO << "Deleting instance " << static_cast<void*>( this ) << " of CDataSetRegion" << endl;
 }
+
+/*************
+ * Operators *
+ *************/
+
+/**
+ * \param aNewRegion CDataSetRegion instance to copy
+ * \returns reference to this region
+ */
+CDataSetRegion& CDataSetRegion::operator=( const CDataSetRegion& aNewRegion ) throw()
+{
+	extentsVec = aNewRegion.extentsVec;
+	originVec = aNewRegion.originVec;
+	return *this;
+}
 	
 /*****************
  * Other methods *
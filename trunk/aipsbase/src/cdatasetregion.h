@@ -11,6 +11,8 @@
  * Changed: 2004-12-22 Moved inline members to cdatasetregion.tpp       *
  *          2005-11-21 Added documentation.                             *
  *                     Added missing exception handling                 *
+ *          2026-10-17 Accessors are now const. Added operator= and     *
+ *                      getDimension()                                  *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -55,19 +57,28 @@ public:
   ~CDataSetRegion() 
 		throw();
   //@}
+/** \name Operators */
+  //@{
+	/// Assignment operator
+	CDataSetRegion& operator=( const CDataSetRegion& aNewRegion )
+		throw();
+  //@}
 /** \name Accessors */
   //@{
   /// Get origin position
-  size_t getOrigin( unsigned short usOriginIndex ) 
+  size_t getOrigin( unsigned short usOriginIndex ) const
     throw( OutOfRangeException );
   /// \overload
-  std::vector<size_t> getOrigin() 
+  std::vector<size_t> getOrigin() const
     throw();
   /// Get region extents
-  size_t getExtent( unsigned short usExtentIndex ) 
+  size_t getExtent( unsigned short usExtentIndex ) const
     throw( OutOfRangeException );
   /// \overload
-  std::vector<size_t> getExtents() 
+  std::vector<size_t> getExtents() const
+    throw();
+  /// Get region dimension
+  unsigned short getDimension() const
     throw();
   //@}
 /** \name Other methods */
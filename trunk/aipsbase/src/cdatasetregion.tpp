@@ -18,7 +18,7 @@
  * \returns Position of origin for the given index
  * \throws OutOfRangeException if given index is out of range
  */
-inline size_t CDataSetRegion::getOrigin( unsigned short usOriginIndex ) throw( OutOfRangeException )
+inline size_t CDataSetRegion::getOrigin( unsigned short usOriginIndex ) const throw( OutOfRangeException )
 { 
 	if ( usOriginIndex > originVec.size() ) 
 		throw( OutOfRangeException( SERROR("dimensionSize too big"), CException::RECOVER, ERR_BADDIMENSION ) );
@@ -31,7 +31,7 @@ inline size_t CDataSetRegion::getOrigin( unsigned short usOriginIndex ) throw( O
  * \returns Region extent for the given index
  * \throws OutOfRangeException if given index is out of range
  */ 
-inline size_t CDataSetRegion::getExtent( unsigned short usExtentIndex ) throw( OutOfRangeException )
+inline size_t CDataSetRegion::getExtent( unsigned short usExtentIndex ) const throw( OutOfRangeException )
 { 
 	if ( usExtentIndex > extentsVec.size() ) 
 		throw( OutOfRangeException( SERROR("dimensionSize too big"), CException::RECOVER, ERR_BADDIMENSION ) );
@@ -40,13 +40,19 @@ inline size_t CDataSetRegion::getExtent( unsigned short usExtentIndex ) throw( O
 }		
 	
 /** \returns Position of region origin */
-inline std::vector<size_t> CDataSetRegion::getOrigin() throw()
+inline std::vector<size_t> CDataSetRegion::getOrigin() const throw()
 { 
 	return originVec; 
 }
 
 /** \returns Region extents */	
-inline std::vector<size_t> CDataSetRegion::getExtents() throw() 
+inline std::vector<size_t> CDataSetRegion::getExtents() const throw() 
 { 
 	return extentsVec; 
 }
+
+/** \returns Number of region dimensions */
+inline unsigned short CDataSetRegion::getDimension() const throw()
+{
+	return static_cast<unsigned short>( extentsVec.size() );
+}
@@ -0,0 +1,251 @@
+/************************************************************************
+ * File: cdistancetransform.cpp                                         *
+ * Project: AIPS                                                        *
+ * Description: Exact euclidean distance transform                      *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#include "cdistancetransform.h"
+
+// Standard includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+// AIPS includes
+#include "aipsparallel.h"
+#include "cdatablock.h"
+
+using namespace std;
+using namespace aips;
+
+namespace
+{
+
+const double infinity = numeric_limits<double>::infinity();
+
+/**
+ * Lower envelope of the parabolas ( x - q )^2 + f(q) along one line. Samples
+ * with an infinite f are skipped; if all are infinite the line stays infinite.
+ * \param fArr squared distances of the line, replaced by the result
+ * \param count number of samples
+ * \param dSpacing distance of two samples
+ * \param vertexArr work array of count elements
+ * \param boundaryArr work array of count + 1 elements
+ * \param resultArr work array of count elements
+ */
+void lowerEnvelope( double* fArr, const size_t count, const double dSpacing, size_t* vertexArr,
+	double* boundaryArr, double* resultArr )
+{
+	size_t k = 0;
+	bool bEmpty = true;
+	for( size_t q = 0; q < count; ++q )
+	{
+		if ( fArr[q] == infinity )
+			continue;
+		const double dPosition = q * dSpacing;
+		if ( bEmpty )
+		{
+			vertexArr[0] = q;
+			boundaryArr[0] = -infinity;
+			boundaryArr[1] = infinity;
+			bEmpty = false;
+			continue;
+		}
+		double dIntersection;
+		while( true )
+		{
+			const double dVertexPosition = vertexArr[k] * dSpacing;
+			dIntersection = ( ( fArr[q] + dPosition * dPosition )
+				- ( fArr[vertexArr[k]] + dVertexPosition * dVertexPosition ) )
+				/ ( 2.0 * ( dPosition - dVertexPosition ) );
+			if ( dIntersection > boundaryArr[k] || k == 0 )
+				break;
+			--k;
+		}
+		++k;
+		vertexArr[k] = q;
+		boundaryArr[k] = dIntersection;
+		boundaryArr[k + 1] = infinity;
+	}
+	if ( bEmpty )
+		return;
+	k = 0;
+	for( size_t q = 0; q < count; ++q )
+	{
+		const double dPosition = q * dSpacing;
+		while( boundaryArr[k + 1] < dPosition )
+			++k;
+		const double dOffset = dPosition - vertexArr[k] * dSpacing;
+		resultArr[q] = dOffset * dOffset + fArr[vertexArr[k]];
+	}
+	std::copy( resultArr, resultArr + count, fArr );
+}
+
+/**
+ * Distance transform along one axis, shared by all workers. Lines along x
+ * are processed in place, lines along y and z are copied into a buffer.
+ */
+struct SAxisTransform
+{
+	double* dataPtr;
+	size_t extentArr[3];
+	double dSpacing;
+	unsigned short usAxis;
+
+	/// Number of work items: rows for the x axis, slices for y, rows for z
+	size_t itemCount() const
+	{
+		if ( usAxis == 0 )
+			return extentArr[1] * extentArr[2];
+		return ( usAxis == 1 ) ? extentArr[2] : extentArr[1];
+	}
+	void range( const size_t first, const size_t last ) const
+	{
+		const size_t count = extentArr[usAxis];
+		const size_t stride = ( usAxis == 0 ) ? 1 : ( usAxis == 1 ) ? extentArr[0] : extentArr[0] * extentArr[1];
+		vector<double> lineVec( count );
+		vector<double> resultVec( count );
+		vector<double> boundaryVec( count + 1 );
+		vector<size_t> vertexVec( count );
+		for( size_t item = first; item < last; ++item )
+		{
+			if ( usAxis == 0 )
+			{
+				lowerEnvelope( dataPtr + item * count, count, dSpacing, &vertexVec[0], &boundaryVec[0],
+					&resultVec[0] );
+				continue;
+			}
+			// All lines starting in the actual slice (y axis) or row (z axis)
+			double* firstPtr = dataPtr + ( ( usAxis == 1 ) ? item * extentArr[0] * extentArr[1] : item * extentArr[0] );
+			for( size_t x = 0; x < extentArr[0]; ++x )
+			{
+				double* linePtr = firstPtr + x;
+				for( size_t n = 0; n < count; ++n )
+					lineVec[n] = linePtr[n * stride];
+				lowerEnvelope( &lineVec[0], count, dSpacing, &vertexVec[0], &boundaryVec[0], &resultVec[0] );
+				for( size_t n = 0; n < count; ++n )
+					linePtr[n * stride] = lineVec[n];
+			}
+		}
+	}
+};
+
+}
+
+/*************
+ * Structors *
+ *************/
+
+/**
+ * \param extentVec extents of the masks (1 to 3 dimensions)
+ * \param spacingVec voxel spacing, missing entries are taken as 1.0
+ */
+CDistanceTransform::CDistanceTransform( const std::vector<size_t>& extentVec,
+	const std::vector<double>& spacingVec ) throw()
+	: CBase( "CDistanceTransform", CDISTANCETRANSFORM_VERSION, "CBase" )
+{
+	for( unsigned short i = 0; i < 3; ++i )
+	{
+		extentArr[i] = ( i < extentVec.size() ) ? extentVec[i] : 1;
+		spacingArr[i] = ( i < spacingVec.size() && spacingVec[i] > 0.0 ) ? spacingVec[i] : 1.0;
+	}
+}
+
+CDistanceTransform::~CDistanceTransform() throw()
+{
+}
+
+/*************
+ * Accessors *
+ *************/
+
+/** \returns the number of voxels of the masks */
+size_t CDistanceTransform::getSize() const throw()
+{
+	return extentArr[0] * extentArr[1] * extentArr[2];
+}
+
+/*****************
+ * Other methods *
+ *****************/
+
+/**
+ * \param maskPtr mask, voxels other than 0 have the distance 0
+ * \param squaredDistancePtr array of getSize() elements for the result
+ */
+void CDistanceTransform::computeSquared( const unsigned char* maskPtr, double* squaredDistancePtr ) const
+	throw()
+{
+	const size_t voxelCount = getSize();
+	for( size_t i = 0; i < voxelCount; ++i )
+		squaredDistancePtr[i] = ( maskPtr[i] != 0 ) ? 0.0 : infinity;
+	SAxisTransform theTransform;
+	theTransform.dataPtr = squaredDistancePtr;
+	for( unsigned short i = 0; i < 3; ++i )
+		theTransform.extentArr[i] = extentArr[i];
+	for( unsigned short usAxis = 0; usAxis < 3; ++usAxis )
+	{
+		if ( extentArr[usAxis] < 2 && usAxis > 0 )
+			continue;
+		theTransform.usAxis = usAxis;
+		theTransform.dSpacing = spacingArr[usAxis];
+		parallelFor( theTransform, &SAxisTransform::range, theTransform.itemCount() );
+	}
+}
+
+/**
+ * The distances are appended in voxel order. If the second mask is empty,
+ * the appended distances are infinite.
+ * \param fromMaskPtr voxels to compute the distances for
+ * \param toMaskPtr voxels to measure the distances to
+ * \param distanceVec vector to append the distances to
+ */
+void CDistanceTransform::collectDistances( const unsigned char* fromMaskPtr, const unsigned char* toMaskPtr,
+	std::vector<double>& distanceVec ) const throw()
+{
+	const size_t voxelCount = getSize();
+	CDataBlock<double> distanceBlock( voxelCount, false );
+	computeSquared( toMaskPtr, distanceBlock.getData() );
+	const double* squaredDistanceArr = distanceBlock.getData();
+	for( size_t i = 0; i < voxelCount; ++i )
+		if ( fromMaskPtr[i] != 0 )
+			distanceVec.push_back( sqrt( squaredDistanceArr[i] ) );
+}
+
+/**
+ * Values between the ranks are interpolated linearly.
+ * \param valueVec values (copied, since they are partially sorted)
+ * \param dPercent percentile in [0, 100]; 100 gives the maximum, 50 the median
+ * \returns the percentile or 0 if no values are given
+ */
+double CDistanceTransform::percentile( std::vector<double> valueVec, const double dPercent ) throw()
+{
+	if ( valueVec.empty() )
+		return 0.0;
+	const double dRank = std::max( 0.0, std::min( 100.0, dPercent ) ) * 0.01 * ( valueVec.size() - 1 );
+	const size_t lowerRank = static_cast<size_t>( floor( dRank ) );
+	std::nth_element( valueVec.begin(), valueVec.begin() + lowerRank, valueVec.end() );
+	const double dLower = valueVec[lowerRank];
+	if ( lowerRank + 1 >= valueVec.size() )
+		return dLower;
+	const double dUpper = *std::min_element( valueVec.begin() + lowerRank + 1, valueVec.end() );
+	return dLower + ( dRank - lowerRank ) * ( dUpper - dLower );
+}
+
+const std::string CDistanceTransform::dump() const throw()
+{
+	std::ostringstream os;
+	os << "extentArr " << extentArr[0] << " " << extentArr[1] << " " << extentArr[2]
+		<< " spacingArr " << spacingArr[0] << " " << spacingArr[1] << " " << spacingArr[2] << "\n";
+	return CBase::dump() + os.str();
+}
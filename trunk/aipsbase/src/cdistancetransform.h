@@ -0,0 +1,88 @@
+/************************************************************************
+ * File: cdistancetransform.h                                           *
+ * Project: AIPS                                                        *
+ * Description: Exact euclidean distance transform                      *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Version: 0.1                                                         *
+ * Status : Beta                                                        *
+ * Created: 2026-10-17                                                  *
+ * Changed:                                                             *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#ifndef CDISTANCETRANSFORM_H
+#define CDISTANCETRANSFORM_H
+
+#define CDISTANCETRANSFORM_VERSION "0.1"
+
+// Standard includes
+#include <string>
+#include <vector>
+
+// AIPS includes
+#include "cbase.h"
+
+namespace aips {
+
+/**
+ * \brief Exact euclidean distance transform of binary masks.
+ *
+ * For every voxel the squared euclidean distance to the nearest voxel of a
+ * mask is computed in linear time by the separable algorithm of Felzenszwalb
+ * and Huttenlocher (Theory of Computing 8, 2012). Each axis is processed by
+ * taking the lower envelope of parabolas along all lines, the lines are
+ * distributed over CPipelineItem::getNumberOfThreads() threads.
+ *
+ * The voxel spacing is taken into account, so distances of anisotropic data
+ * sets are given in physical units (see CDataSet::getBaseElementDimensions()).
+ * Voxels with no mask voxel at all get the distance
+ * std::numeric_limits<double>::infinity().
+ *
+ * Masks are arrays of unsigned char with x running fastest, every value
+ * other than 0 belongs to the mask.
+ */
+class CDistanceTransform : public CBase
+{
+private:
+	/// Standard constructor
+	CDistanceTransform();
+public:
+/* Structors */
+	/// Constructor
+	CDistanceTransform( const std::vector<size_t>& extentVec, const std::vector<double>& spacingVec )
+		throw();
+	/// Destructor
+	virtual ~CDistanceTransform()
+		throw();
+/* Accessors */
+	/// Returns the number of voxels
+	size_t getSize() const
+		throw();
+/* Other methods */
+	/// Computes the squared distances to the nearest mask voxel
+	void computeSquared( const unsigned char* maskPtr, double* squaredDistancePtr ) const
+		throw();
+	/// Appends the distances from all voxels of one mask to the nearest voxel of another mask
+	void collectDistances( const unsigned char* fromMaskPtr, const unsigned char* toMaskPtr,
+		std::vector<double>& distanceVec ) const
+		throw();
+	/// Returns a percentile of some values
+	static double percentile( std::vector<double> valueVec, const double dPercent )
+		throw();
+	/// Reimplemented from CBase
+	virtual const std::string dump() const
+		throw();
+private:
+	size_t extentArr[3];  ///< Extents, missing dimensions are 1
+	double spacingArr[3]; ///< Voxel spacing, missing dimensions are 1.0
+};
+
+}
+
+#endif
@@ -63,6 +63,85 @@ bool CFileHandler::supports( const string& sFilename ) const throw()
   return false;
 }
 
+/**
+ * The default implementation loads the whole dataset. Reimplement this if the
+ * extents can be read from the file header.
+ * \param sFilename Filename of file to load
+ * \returns the extents of the dataset
+ * \throws FileException if the file cannot be loaded
+ */
+std::vector<size_t> CFileHandler::loadExtents( const std::string& sFilename ) const
+  throw( FileException )
+{
+  TDataSetPtr theDataPtr = load( sFilename ).first;
+  if ( !theDataPtr )
+    throw( FileException( SERROR( "No dataset loaded" ), CException::RECOVER, ERR_FILEACCESS ) );
+  // CDataSet::getExtents() also holds the data dimension
+  std::vector<size_t> extentVec = theDataPtr->getExtents();
+  extentVec.resize( theDataPtr->getDimension() );
+  return extentVec;
+}
+
+/**
+ * The default implementation loads the whole dataset and copies the region.
+ * Reimplement this if the handler can read parts of a file.
+ * \param sFilename Filename of file to load
+ * \param regionOriginVec first voxel of the region
+ * \param regionExtentVec extents of the region
+ * \returns a dataset holding the region
+ * \throws FileException if the file cannot be loaded or the region exceeds the dataset
+ */
+TDataSetPtr CFileHandler::loadRegion( const std::string& sFilename,
+  const std::vector<size_t>& regionOriginVec, const std::vector<size_t>& regionExtentVec ) const
+  throw( FileException )
+{
+  TDataSetPtr theDataPtr = load( sFilename ).first;
+  if ( !theDataPtr )
+    throw( FileException( SERROR( "No dataset loaded" ), CException::RECOVER, ERR_FILEACCESS ) );
+  TDataSetPtr theRegionPtr( theDataPtr->cloneRegion( regionOriginVec, regionExtentVec ) );
+  if ( !theRegionPtr )
+    throw( FileException( SERROR( "Region exceeds the dataset" ), CException::RECOVER, ERR_BADCOORDS ) );
+  return theRegionPtr;
+}
+
+/**
+ * \returns true if beginRegionSave() and saveRegion() are implemented. The default
+ *   implementation returns false.
+ */
+bool CFileHandler::supportsRegionSave() const throw()
+{
+  return false;
+}
+
+/**
+ * Reimplement this together with saveRegion() and supportsRegionSave().
+ * \param sFilename Filename of file to save to
+ * \param theData Pair of one region of the dataset (which defines the voxel type)
+ *   and (in most cases optional) header information
+ * \param extentVec extents of the complete dataset
+ * \throws FileException if the files cannot be created. The default implementation
+ *   always throws
+ */
+void CFileHandler::beginRegionSave( const std::string&, const TDataFile&,
+  const std::vector<size_t>& ) const throw( FileException )
+{
+  throw( FileException( SERROR( "File format cannot be saved region by region" ),
+    CException::RECOVER, ERR_FILEFORMATUNSUPPORTED ) );
+}
+
+/**
+ * \param sFilename Filename of file to save to
+ * \param aRegionPtr the region
+ * \param regionOriginVec position of the first voxel of the region in the complete dataset
+ * \throws FileException on any file error. The default implementation always throws
+ */
+void CFileHandler::saveRegion( const std::string&, TDataSetPtr, const std::vector<size_t>& ) const
+  throw( FileException )
+{
+  throw( FileException( SERROR( "File format cannot be saved region by region" ),
+    CException::RECOVER, ERR_FILEFORMATUNSUPPORTED ) );
+}
+
 /**
  * \return file mask
  */
@@ -25,6 +25,7 @@
  *                   Provided class information constructor             *
  *        2004-11-23 Class now uses boost::shared_ptr                   *
  *        2004-11-25 Updated getDataType() to accept more variations    *
+ *        2026-10-17 Added loading and saving of regions                *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -83,6 +84,24 @@ public:
    */
   virtual void save( const std::string& sFilename, const TDataFile& theData ) const
     throw( FileException ) = 0;
+  /// Returns the extents of the dataset in the given file
+  virtual std::vector<size_t> loadExtents( const std::string& sFilename ) const
+    throw( FileException );
+  /// Loads a region of the dataset in the given file
+  virtual TDataSetPtr loadRegion( const std::string& sFilename,
+    const std::vector<size_t>& regionOriginVec, const std::vector<size_t>& regionExtentVec ) const
+    throw( FileException );
+  /// Returns true if the handler can save a dataset region by region
+  virtual bool supportsRegionSave() const
+    throw();
+  /// Creates the files for a dataset which is saved region by region
+  virtual void beginRegionSave( const std::string& sFilename, const TDataFile& theData,
+    const std::vector<size_t>& extentVec ) const
+    throw( FileException );
+  /// Saves a region of a dataset into the files created by beginRegionSave()
+  virtual void saveRegion( const std::string& sFilename, TDataSetPtr aRegionPtr,
+    const std::vector<size_t>& regionOriginVec ) const
+    throw( FileException );
   /// Returns true if the filehandler supports the format of the given extension
   bool supports( const std::string& sFilename ) const
     throw();
@@ -0,0 +1,121 @@
+/************************************************************************
+ * File: cflatmorphology.h                                              *
+ * Project: AIPS                                                        *
+ * Description: Grey value morphology with flat box and line elements   *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Version: 0.1                                                         *
+ * Status : Beta                                                        *
+ * Created: 2026-10-17                                                  *
+ * Changed:                                                             *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#ifndef CFLATMORPHOLOGY_H
+#define CFLATMORPHOLOGY_H
+
+#define CFLATMORPHOLOGY_VERSION "0.1"
+
+// Standard includes
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// AIPS includes
+#include "aipsparallel.h"
+#include "cbase.h"
+
+namespace aips {
+
+/**
+ * \brief Erosion and dilation with flat box shaped structuring elements.
+ *
+ * A box element is separable, so the data set is filtered by a running
+ * minimum or maximum along each axis in turn. Each line is processed by the
+ * algorithm of van Herk (Pattern Recognition Letters 13, 1992) and Gil and
+ * Werman (IEEE PAMI 15, 1993): the line is split into blocks of the window
+ * size, and every window is combined from a suffix and a prefix extremum of
+ * two neighbouring blocks. This needs about three comparisons per sample for
+ * any radius. A radius of 0 leaves an axis untouched, so line elements are
+ * boxes with only one radius greater than 0.
+ *
+ * Voxels outside the data set are ignored, i.e. the border is neither
+ * eroded nor dilated from outside. Data sets are passed as arrays with x
+ * running fastest and missing dimensions having an extent of 1. The lines
+ * of an axis are distributed over CPipelineItem::getNumberOfThreads()
+ * threads.
+ *
+ * \param TValue scalar voxel type
+ */
+template<typename TValue>
+class CFlatMorphology : public CBase
+{
+private:
+	/// Standard constructor
+	CFlatMorphology();
+public:
+/* Structors */
+	/// Constructor
+	explicit CFlatMorphology( const std::vector<size_t>& radiusVec )
+		throw();
+	/// Destructor
+	virtual ~CFlatMorphology()
+		throw();
+/* Accessors */
+	/// Returns the radius of the element along the given axis
+	size_t getRadius( const unsigned short usAxis ) const
+		throw();
+/* Other methods */
+	/// Filters interleaved lines in place
+	static void filterLines( TValue* dataPtr, const size_t count, const size_t stride,
+		const size_t width, const size_t radius, const bool bDilate )
+		throw();
+	/// Filters a data set along one axis
+	void filterAxis( TValue* dataPtr, const size_t* extentArr, const unsigned short usAxis,
+		const bool bDilate ) const
+		throw();
+	/// Erodes a data set
+	void erode( TValue* dataPtr, const size_t* extentArr ) const
+		throw();
+	/// Dilates a data set
+	void dilate( TValue* dataPtr, const size_t* extentArr ) const
+		throw();
+	/// Reimplemented from CBase
+	virtual const std::string dump() const
+		throw();
+private:
+	/// Running extremum of interleaved lines
+	template<bool bDilate> static void runningExtremum( TValue* dataPtr, const size_t count,
+		const size_t stride, const size_t width, const size_t radius )
+		throw();
+	/**
+	 * Filtering of a data set along one axis, shared by all workers. Lines
+	 * along x are filtered one by one, lines along y slice by slice and lines
+	 * along z row by row.
+	 */
+	struct SAxisFilter
+	{
+		TValue* dataPtr;
+		size_t extentArr[3];
+		size_t radius;
+		unsigned short usAxis;
+		bool bDilate;
+		/// Number of work items: lines along x, slices or rows
+		size_t itemCount() const;
+		void range( const size_t first, const size_t last ) const;
+	};
+	size_t radiusArr[3]; ///< Radius of the element along each axis
+};
+
+#include "cflatmorphology.tpp"
+
+}
+
+#endif
@@ -0,0 +1,209 @@
+/************************************************************************
+ * File: cflatmorphology.tpp                                            *
+ * Project: AIPS                                                        *
+ * Description: Grey value morphology with flat box and line elements   *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+/*************
+ * Structors *
+ *************/
+
+/** \param radiusVec radius of the element along x, y and z. Missing entries are 0 */
+template<typename TValue>
+CFlatMorphology<TValue>::CFlatMorphology( const std::vector<size_t>& radiusVec ) throw()
+	: CBase( "CFlatMorphology", CFLATMORPHOLOGY_VERSION, "CBase" )
+{
+	for( unsigned short i = 0; i < 3; ++i )
+		radiusArr[i] = ( i < radiusVec.size() ) ? radiusVec[i] : 0;
+}
+
+template<typename TValue>
+CFlatMorphology<TValue>::~CFlatMorphology() throw()
+{
+}
+
+/*************
+ * Accessors *
+ *************/
+
+/**
+ * \param usAxis axis (0..2)
+ * \returns the radius along this axis
+ */
+template<typename TValue>
+size_t CFlatMorphology<TValue>::getRadius( const unsigned short usAxis ) const throw()
+{
+	return radiusArr[usAxis];
+}
+
+/*****************
+ * Other methods *
+ *****************/
+
+/**
+ * Sample n of line l is found at dataPtr[n * stride + l].
+ * \param dataPtr first sample of the first line
+ * \param count number of samples per line
+ * \param stride distance of two samples of a line
+ * \param width number of lines, stored next to each other
+ * \param radius half window size, the window covers 2 * radius + 1 samples
+ * \param bDilate compute the running maximum instead of the minimum
+ */
+template<typename TValue>
+void CFlatMorphology<TValue>::filterLines( TValue* dataPtr, const size_t count, const size_t stride,
+	const size_t width, const size_t radius, const bool bDilate ) throw()
+{
+	if ( bDilate )
+		runningExtremum<true>( dataPtr, count, stride, width, radius );
+	else
+		runningExtremum<false>( dataPtr, count, stride, width, radius );
+}
+
+/**
+ * \param dataPtr data set, filtered in place
+ * \param extentArr extents of the three dimensions
+ * \param usAxis axis to filter along (0..2)
+ * \param bDilate compute the running maximum instead of the minimum
+ */
+template<typename TValue>
+void CFlatMorphology<TValue>::filterAxis( TValue* dataPtr, const size_t* extentArr,
+	const unsigned short usAxis, const bool bDilate ) const throw()
+{
+	if ( radiusArr[usAxis] == 0 || extentArr[usAxis] < 2 )
+		return;
+	SAxisFilter theFilter;
+	theFilter.dataPtr = dataPtr;
+	for( unsigned short i = 0; i < 3; ++i )
+		theFilter.extentArr[i] = extentArr[i];
+	theFilter.radius = radiusArr[usAxis];
+	theFilter.usAxis = usAxis;
+	theFilter.bDilate = bDilate;
+	parallelFor( theFilter, &SAxisFilter::range, theFilter.itemCount() );
+}
+
+/**
+ * \param dataPtr data set, eroded in place
+ * \param extentArr extents of the three dimensions
+ */
+template<typename TValue>
+void CFlatMorphology<TValue>::erode( TValue* dataPtr, const size_t* extentArr ) const throw()
+{
+	for( unsigned short usAxis = 0; usAxis < 3; ++usAxis )
+		filterAxis( dataPtr, extentArr, usAxis, false );
+}
+
+/**
+ * \param dataPtr data set, dilated in place
+ * \param extentArr extents of the three dimensions
+ */
+template<typename TValue>
+void CFlatMorphology<TValue>::dilate( TValue* dataPtr, const size_t* extentArr ) const throw()
+{
+	for( unsigned short usAxis = 0; usAxis < 3; ++usAxis )
+		filterAxis( dataPtr, extentArr, usAxis, true );
+}
+
+template<typename TValue>
+const std::string CFlatMorphology<TValue>::dump() const throw()
+{
+	std::ostringstream os;
+	os << "radiusArr " << radiusArr[0] << " " << radiusArr[1] << " " << radiusArr[2] << "\n";
+	return CBase::dump() + os.str();
+}
+
+/*******************
+ * Private methods *
+ *******************/
+
+/**
+ * The line is padded with radius neutral samples on both sides and split into
+ * blocks of 2 * radius + 1 samples. The window starting at padded sample n
+ * is the extremum of the suffix of its first block starting at n and the
+ * prefix of the next block ending at n + 2 * radius.
+ */
+template<typename TValue> template<bool bDilate>
+void CFlatMorphology<TValue>::runningExtremum( TValue* dataPtr, const size_t count,
+	const size_t stride, const size_t width, const size_t radius ) throw()
+{
+	// Windows larger than the line do not change the result
+	const size_t r = std::min( radius, count - 1 );
+	if ( r == 0 )
+		return;
+	const TValue neutral = bDilate
+		? ( std::numeric_limits<TValue>::is_integer ? std::numeric_limits<TValue>::min()
+			: -std::numeric_limits<TValue>::max() )
+		: std::numeric_limits<TValue>::max();
+	const size_t windowSize = 2 * r + 1;
+	const size_t paddedCount = ( ( count + 2 * r + windowSize - 1 ) / windowSize ) * windowSize;
+	std::vector<TValue> prefixVec( paddedCount * width );
+	std::vector<TValue> suffixVec( paddedCount * width );
+	// Padded sample n is input sample n - r
+	for( size_t n = 0; n < paddedCount; ++n )
+	{
+		TValue* prefixPtr = &prefixVec[n * width];
+		if ( n < r || n >= count + r )
+			std::fill( prefixPtr, prefixPtr + width, neutral );
+		else
+			std::copy( dataPtr + ( n - r ) * stride, dataPtr + ( n - r ) * stride + width, prefixPtr );
+	}
+	std::copy( prefixVec.begin(), prefixVec.end(), suffixVec.begin() );
+	for( size_t n = 1; n < paddedCount; ++n )
+	{
+		if ( n % windowSize == 0 )
+			continue;
+		TValue* prefixPtr = &prefixVec[n * width];
+		const TValue* previousPtr = prefixPtr - width;
+		for( size_t l = 0; l < width; ++l )
+			prefixPtr[l] = bDilate ? std::max( prefixPtr[l], previousPtr[l] ) : std::min( prefixPtr[l], previousPtr[l] );
+	}
+	for( size_t n = paddedCount - 1; n-- > 0; )
+	{
+		if ( ( n + 1 ) % windowSize == 0 )
+			continue;
+		TValue* suffixPtr = &suffixVec[n * width];
+		const TValue* nextPtr = suffixPtr + width;
+		for( size_t l = 0; l < width; ++l )
+			suffixPtr[l] = bDilate ? std::max( suffixPtr[l], nextPtr[l] ) : std::min( suffixPtr[l], nextPtr[l] );
+	}
+	for( size_t n = 0; n < count; ++n )
+	{
+		const TValue* suffixPtr = &suffixVec[n * width];
+		const TValue* prefixPtr = &prefixVec[( n + 2 * r ) * width];
+		TValue* linePtr = dataPtr + n * stride;
+		for( size_t l = 0; l < width; ++l )
+			linePtr[l] = bDilate ? std::max( suffixPtr[l], prefixPtr[l] ) : std::min( suffixPtr[l], prefixPtr[l] );
+	}
+}
+
+template<typename TValue>
+size_t CFlatMorphology<TValue>::SAxisFilter::itemCount() const
+{
+	if ( usAxis == 0 )
+		return extentArr[1] * extentArr[2];
+	return ( usAxis == 1 ) ? extentArr[2] : extentArr[1];
+}
+
+template<typename TValue>
+void CFlatMorphology<TValue>::SAxisFilter::range( const size_t first, const size_t last ) const
+{
+	const size_t width = extentArr[0];
+	const size_t sliceSize = extentArr[0] * extentArr[1];
+	for( size_t item = first; item < last; ++item )
+	{
+		if ( usAxis == 0 )
+			filterLines( dataPtr + item * width, width, 1, 1, radius, bDilate );
+		else if ( usAxis == 1 )
+			filterLines( dataPtr + item * sliceSize, extentArr[1], width, width, radius, bDilate );
+		else
+			filterLines( dataPtr + item * width, extentArr[2], sliceSize, width, radius, bDilate );
+	}
+}
@@ -0,0 +1,121 @@
+/************************************************************************
+ * File: cmappedfile.cpp                                                *
+ * Project: AIPS                                                        *
+ * Description: A file mapped into memory with copy-on-write semantics  *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#include "cmappedfile.h"
+
+// Standard includes
+#include <sstream>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace aips;
+
+/*************
+ * Structors *
+ *************/
+
+/**
+ * \param sFilename name of the file to map
+ * \throws FileException if the file cannot be opened or mapped
+ */
+CMappedFile::CMappedFile( const std::string& sFilename ) throw( FileException )
+	: CBase( "CMappedFile", CMAPPEDFILE_VERSION, "CBase" ), mappingPtr( NULL ), mappingSize( 0 )
+{
+#ifdef WIN32
+	fileHandle = CreateFileA( sFilename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( fileHandle == INVALID_HANDLE_VALUE )
+		throw( FileException( SERROR( "Could not open file" ), CException::RECOVER, ERR_FILENOTFOUND ) );
+	LARGE_INTEGER fileSize;
+	if ( !GetFileSizeEx( fileHandle, &fileSize ) || fileSize.QuadPart == 0 )
+	{
+		CloseHandle( fileHandle );
+		throw( FileException( SERROR( "Could not determine file size" ), CException::RECOVER, ERR_FILEACCESS ) );
+	}
+	mappingSize = static_cast<size_t>( fileSize.QuadPart );
+	mappingHandle = CreateFileMappingA( fileHandle, NULL, PAGE_WRITECOPY, 0, 0, NULL );
+	if ( mappingHandle != NULL )
+		mappingPtr = static_cast<char*>( MapViewOfFile( mappingHandle, FILE_MAP_COPY, 0, 0, 0 ) );
+	if ( mappingPtr == NULL )
+	{
+		if ( mappingHandle != NULL )
+			CloseHandle( mappingHandle );
+		CloseHandle( fileHandle );
+		throw( FileException( SERROR( "Could not map file" ), CException::RECOVER, ERR_FILEACCESS ) );
+	}
+#else
+	int fileDescriptor = open( sFilename.c_str(), O_RDONLY );
+	if ( fileDescriptor < 0 )
+		throw( FileException( SERROR( "Could not open file" ), CException::RECOVER, ERR_FILENOTFOUND ) );
+	struct stat fileStatus;
+	if ( fstat( fileDescriptor, &fileStatus ) != 0 || fileStatus.st_size == 0 )
+	{
+		close( fileDescriptor );
+		throw( FileException( SERROR( "Could not determine file size" ), CException::RECOVER, ERR_FILEACCESS ) );
+	}
+	mappingSize = static_cast<size_t>( fileStatus.st_size );
+	void* regionPtr = mmap( NULL, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileDescriptor, 0 );
+	// The mapping stays valid after the descriptor is closed
+	close( fileDescriptor );
+	if ( regionPtr == MAP_FAILED )
+		throw( FileException( SERROR( "Could not map file" ), CException::RECOVER, ERR_FILEACCESS ) );
+	mappingPtr = static_cast<char*>( regionPtr );
+#endif
+}
+
+CMappedFile::~CMappedFile() throw()
+{
+#ifdef WIN32
+	UnmapViewOfFile( mappingPtr );
+	CloseHandle( mappingHandle );
+	CloseHandle( fileHandle );
+#else
+	munmap( mappingPtr, mappingSize );
+#endif
+}
+
+/*************
+ * Accessors *
+ *************/
+
+/** \returns a pointer to the first byte of the file */
+char* CMappedFile::getData() const throw()
+{
+	return mappingPtr;
+}
+
+/** \returns the size of the file in bytes */
+size_t CMappedFile::getSize() const throw()
+{
+	return mappingSize;
+}
+
+/*****************
+ * Other methods *
+ *****************/
+
+const std::string CMappedFile::dump() const throw()
+{
+	std::ostringstream os;
+	os << "mappingPtr " << static_cast<void*>( mappingPtr ) << " mappingSize " << mappingSize << "\n";
+	return CBase::dump() + os.str();
+}
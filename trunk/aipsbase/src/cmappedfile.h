@@ -0,0 +1,74 @@
+/************************************************************************
+ * File: cmappedfile.h                                                  *
+ * Project: AIPS                                                        *
+ * Description: A file mapped into memory with copy-on-write semantics  *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Version: 0.1                                                         *
+ * Status : Beta                                                        *
+ * Created: 2026-10-17                                                  *
+ * Changed:                                                             *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#ifndef CMAPPEDFILE_H
+#define CMAPPEDFILE_H
+
+#define CMAPPEDFILE_VERSION "0.1"
+
+// AIPS includes
+#include "cbase.h"
+#include "cexception.h"
+
+namespace aips {
+
+/**
+ * \brief A whole file mapped into the address space of the process.
+ *
+ * The mapping is private (copy-on-write): The contents may be modified,
+ * but modifications are never written back to the file. Pages are only
+ * read from disk when they are accessed for the first time.
+ */
+class CMappedFile : public CBase
+{
+private:
+	/// Copy constructor
+	CMappedFile( const CMappedFile& );
+	/// Assignment operator
+	CMappedFile& operator=( const CMappedFile& );
+public:
+/* Structors */
+	/// Constructor
+	explicit CMappedFile( const std::string& sFilename )
+		throw( FileException );
+	/// Destructor
+	virtual ~CMappedFile()
+		throw();
+/* Accessors */
+	/// Returns a pointer to the first byte of the file
+	char* getData() const
+		throw();
+	/// Returns the size of the file in bytes
+	size_t getSize() const
+		throw();
+/* Other methods */
+	/// Reimplemented from CBase
+	virtual const std::string dump() const
+		throw();
+private:
+	char* mappingPtr;   ///< Start of the mapped memory region
+	size_t mappingSize; ///< Size of the mapped memory region
+#ifdef WIN32
+	void* fileHandle;    ///< Handle of the opened file
+	void* mappingHandle; ///< Handle of the file mapping object
+#endif
+};
+
+}
+
+#endif
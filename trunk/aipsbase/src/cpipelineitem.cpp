@@ -14,13 +14,53 @@
  ************************************************************************/
  
 #include "cpipelineitem.h"
+#include "cdatapool.h"
+#include "cprofiler.h"
+#include "cresultcache.h"
+#include "cthreadpool.h"
+
+// Boost includes
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/bind.hpp>
 
 using namespace aips;
 using namespace std;
 using namespace boost;
 
+/**
+ * Scheduling state of one pipeline run. An item becomes ready as soon as all
+ * of its upstream items are executed. The outputs of an item are released
+ * (if not cached) after all of its downstream items are executed.
+ */
+struct CPipelineItem::SRunState
+{
+	SRunState() : ulRemaining( 0 ), uiWorkers( 0 ), uiMaxWorkers( 0 ) {}
+	/// Number of upstream connections of each item which are not executed yet
+	map<CPipelineItem*, unsigned int> pendingInputsMap;
+	/// Number of downstream connections of each item which are not executed yet
+	map<CPipelineItem*, unsigned int> pendingConsumersMap;
+	/// Downstream items of each item (one entry per connection)
+	map<CPipelineItem*, vector<CPipelineItem*> > consumersMap;
+	/// Upstream items of each item (one entry per connection)
+	map<CPipelineItem*, vector<CPipelineItem*> > producersMap;
+	deque<CPipelineItem*> readyQueue;     ///< Ready items which may run on any thread
+	deque<CPipelineItem*> mainReadyQueue; ///< Ready items which must run on the calling thread
+	unsigned long ulRemaining;            ///< Number of items not executed yet
+	unsigned int uiWorkers;               ///< Number of pool threads working on this run
+	unsigned int uiMaxWorkers;            ///< Maximum number of pool threads for this run
+	boost::mutex theMutex;                ///< Guards all members above
+	boost::condition_variable readyCondition; ///< Signaled each time an item was executed
+};
+
 set<CPipelineItem*> CPipelineItem::allItemsSet;
-priority_queue<CPipelineItem*, std::vector<CPipelineItem*>, CPipelineItem::itemCompareFunctor> CPipelineItem::itemsPriQueue;
+unsigned int CPipelineItem::uiNoOfThreads = 0;
+
+/// Last generation stamp given to the outputs of an item which is not memoised
+static unsigned long ulLastGeneration = 0;
+/// Guards ulLastGeneration
+static boost::mutex generationMutex;
 
 /********************************
  * CPipelineItem::CParameterMap *
@@ -89,16 +129,6 @@ void CPipelineItem::CParameterMap::initString( const std::string& sParamName,
 	setString( sParamName+"_Default", sParamDef );
 }			
 
-/**********************
- * itemCompareFunctor *
- **********************/
-		
-bool CPipelineItem::itemCompareFunctor::operator() ( CPipelineItem* a, CPipelineItem* b ) throw()
-{
-	if ( a->iDepth < b->iDepth ) return true;
-	return false;
-}
-	
 /*****************
  * CPipelineItem *
  *****************/
@@ -129,13 +159,15 @@ CPipelineItem::CPipelineItem( unsigned long ulID_, unsigned short usFIn_,
 		const string &sClassVersion_, const string &sDerivedFrom_ ) throw()
   : CSubject( sClassName_, sClassVersion_, sDerivedFrom_ ),
   sModuleID(""), sDocumentation("No documentation available"), bModuleReady( false ), ownTimeStamp ( 0 ), bCacheOutputs( true ),iDepth( -1 ), ulID( ulID_ ), usFanIn( usFIn_ ), usFanOut( usFOut_ ), connectionsPtrVec( usFanIn ),
-	connectionsTimeStampsVec( usFanIn ), bRecompute( false )
+	connectionsTimeStampsVec( usFanIn ), bRecompute( false ), bMainThreadOnly( false ), bStreamable( false ),
+	bMemoise( false )
 {
   inputsVec.resize( usFanIn );
   for( int i = 0; i < usFanIn; i++ )
   {
     inputsVec[i].portData.reset();
     inputsVec[i].portType = IOPoint;
+    inputsVec[i].bExclusive = false;
     connectionsTimeStampsVec[i] = 0;
   }
   outputsVec.resize( usFanOut );
@@ -273,11 +305,54 @@ void CPipelineItem::deleteOldOutput( unsigned short usPortNumber ) throw( OutOfR
   setOutput( TDataSetPtr(), usPortNumber );
 }
 
+/**
+ * Use this instead of getInput() if the module wants to modify its input, e.g. to
+ * compute its output in place. If this module is the only reader of the
+ * output of an upstream item which doesn't cache its outputs, the input dataset
+ * itself is handed over and removed from the upstream item. Otherwise a copy
+ * is returned. For CTypedData, this is a copy-on-write copy (see
+ * CTypedData::clone()). The returned data set is detached from any data block
+ * it shares, so its access operators may be used for writing right away, also
+ * by several threads.
+ * \param usInputNumber requested input port
+ * \returns a dataset which may be modified freely or an empty pointer if the port
+ *   holds no data
+ */
+TDataSetPtr CPipelineItem::takeInput( unsigned short usInputNumber ) throw( OutOfRangeException )
+{
+	TDataSetPtr inputPtr = getInput( usInputNumber );
+	if ( !inputPtr )
+		return inputPtr;
+	if ( inputsVec[usInputNumber].bExclusive )
+	{
+		inputsVec[usInputNumber].bExclusive = false;
+		if ( TPipelineItemPtr tmpPtr = connectionsPtrVec[usInputNumber].outputItem.lock() )
+		{
+			SOPort& upstreamPort = tmpPtr->outputsVec[connectionsPtrVec[usInputNumber].outputPort];
+			if ( upstreamPort.portData == inputPtr )
+			{
+				upstreamPort.portData.reset();
+				// The result cache may still refer to its data block
+				inputPtr->detach();
+				return inputPtr;
+			}
+		}
+	}
+	TDataSetPtr copyPtr( inputPtr->clone() );
+	copyPtr->detach();
+	return copyPtr;
+}
+
 /*******************
  * private members *
  *******************/
 
-void CPipelineItem::execute() throw()
+/**
+ * \param bReleaseInputs if true, the outputs of all upstream items will be cleared
+ *   (if they are not cached) after execution. The scheduler passes false here and
+ *   releases the outputs itself as soon as all consumers are finished.
+ */
+void CPipelineItem::execute( bool bReleaseInputs ) throw()
 {
 DBG1( "+++ CPipelineItem::execute" << sName );
 	bool bUpdate = false;
@@ -295,6 +370,18 @@ DBG1( "+++ CPipelineItem::execute" << sName );
 	else
 		bUpdate = true;
 DS("Upd: " << bUpdate);
+	CProfiler& theProfiler = getProfiler();
+	const bool bProfile = theProfiler.isEnabled();
+	CProfiler::SRecord theRecord;
+	if ( bProfile )
+	{
+		theRecord.sModuleName = sName;
+		theRecord.sClassName = getClassName();
+		theRecord.ulID = ulID;
+		theRecord.outcome = CProfiler::Skipped;
+		theRecord.dStartTime = theProfiler.getWallClock();
+		theRecord.dCPUTime = CProfiler::getThreadCPUTime();
+	}
 	// We need to update
 	if ( bUpdate )
 	{
@@ -305,16 +392,70 @@ DS( "Updating " << ulID << " ... " );
 			{
 				connectionsTimeStampsVec[i] = tmpPtr->ownTimeStamp;
 				setInput( tmpPtr->getOutput( connectionsPtrVec[i].outputPort ), i );				
+				if ( TDataSetPtr inputPtr = getInput( i ) )
+					theRecord.voxels += inputPtr->getSize() / std::max<size_t>( inputPtr->getDataDimension(), 1 );
 			}
 		}
-		this->apply();
+		string sResultKey = computeResultKey();
+		CResultCache::TResultVec resultVec;
+		if ( !sResultKey.empty() && getResultCache().lookup( sResultKey, resultVec )
+			&& resultVec.size() == outputsVec.size() )
+		{
+DS( "Taking results of " << ulID << " from the cache" );
+			for( unsigned int i = 0; i < outputsVec.size(); ++i )
+				if ( resultVec[i] )
+					outputsVec[i].portData.reset( resultVec[i]->clone() );
+			bModuleReady = true;
+			theRecord.outcome = CProfiler::CacheHit;
+		}
+		else
+		{
+			this->apply();
+			theRecord.outcome = CProfiler::Computed;
+			for( unsigned int i = 0; bProfile && i < outputsVec.size(); ++i )
+				if ( outputsVec[i].portData )
+				{
+					theRecord.outputBytes += outputsVec[i].portData->getDataSize();
+					// Sources process the voxels they produce
+					if ( usFanIn == 0 )
+						theRecord.voxels += outputsVec[i].portData->getSize()
+							/ std::max<size_t>( outputsVec[i].portData->getDataDimension(), 1 );
+				}
+			// The cache and the outputs are copy-on-write copies of each other, so
+			// downstream items may modify (or take over) the outputs without
+			// changing the cached results
+			if ( !sResultKey.empty() && bModuleReady )
+			{
+				resultVec.resize( outputsVec.size() );
+				for( unsigned int i = 0; i < outputsVec.size(); ++i )
+					if ( outputsVec[i].portData )
+						resultVec[i].reset( outputsVec[i].portData->clone() );
+				getResultCache().store( sResultKey, resultVec );
+			}
+		}
+		// Outputs which are not memoised get a new generation stamp instead of a key,
+		// so downstream items need not hash their contents
+		if ( sResultKey.empty() )
+		{
+			boost::mutex::scoped_lock lock( generationMutex );
+			ostringstream os;
+			os << "@" << ++ulLastGeneration;
+			sResultKey = os.str();
+		}
+		for( unsigned int i = 0; i < outputsVec.size(); ++i )
+		{
+			ostringstream os;
+			os << sResultKey << "." << i;
+			outputsVec[i].sResultKey = os.str();
+		}
 		for( unsigned int i = 0; i < connectionsPtrVec.size(); ++i )
 		{
 			if ( TPipelineItemPtr tmpPtr = connectionsPtrVec[i].outputItem.lock() )
 			{
-				tmpPtr->clearCache();
-				cerr << "<" << inputsVec[i].portData.use_count() << ">" << endl;
+				if ( bReleaseInputs )
+					tmpPtr->clearCache();
 				inputsVec[i].portData.reset();
+				inputsVec[i].bExclusive = false;
 			}
 		}		
 		iDepth = -1;
@@ -326,30 +467,161 @@ DS( "done" );
 	{
 DS( "No update needed: " << ulID );
 		iDepth = -1;
+		for( unsigned int i = 0; i < inputsVec.size(); ++i )
+			inputsVec[i].bExclusive = false;
+	}
+	if ( bProfile )
+	{
+		theRecord.dWallTime = theProfiler.getWallClock() - theRecord.dStartTime;
+		theRecord.dCPUTime = CProfiler::getThreadCPUTime() - theRecord.dCPUTime;
+		theProfiler.addRecord( theRecord );
 	}
 DS( "--- CPipelineItem::execute " << sName );
 }
  
+/**
+ * Builds the dependency graph of all items marked by update() and executes it.
+ * Each item is started as soon as all of its upstream items are finished, so
+ * independent branches of the pipeline are processed concurrently. The calling
+ * thread takes part in the computation and is the only one executing items
+ * which are restricted to it (see executeInMainThread()). The other items run
+ * on threads of the global CThreadPool, which parallelFor() uses as well. A
+ * pool thread only works for the run while there are ready items, so filters
+ * of a single running branch may use the threads of the idle ones. Finally,
+ * the data pool frees the memory blocks the run did not need (see
+ * CDataPool::trim()).
+ */
 void CPipelineItem::iterate() throw()
 {
 DBG1( "+++ CPipelineItem::iterate " );
+	if ( getProfiler().isEnabled() )
+		getProfiler().beginRun();
+	boost::shared_ptr<SRunState> statePtr( new SRunState );
+	SRunState& theState = *statePtr;
 	for( set<CPipelineItem*>::iterator it = allItemsSet.begin(); it != allItemsSet.end(); ++it )
-	{			
-		if ( (*it)->iDepth != -1 )
-		{
+	{
+		if ( (*it)->iDepth == -1 )
+			continue;
 DS( (*it)->ulID << " : " << (*it)->iDepth );
-			itemsPriQueue.push( (*it) );
+		theState.pendingInputsMap[*it];
+		theState.pendingConsumersMap[*it];
+		++theState.ulRemaining;
+	}
+	// Build graph edges from the input connections
+	for( map<CPipelineItem*, unsigned int>::iterator it = theState.pendingInputsMap.begin();
+		it != theState.pendingInputsMap.end(); ++it )
+	{
+		CPipelineItem* itemPtr = it->first;
+		for( unsigned int i = 0; i < itemPtr->connectionsPtrVec.size(); ++i )
+		{
+			TPipelineItemPtr tmpPtr = itemPtr->connectionsPtrVec[i].outputItem.lock();
+			if ( !tmpPtr || theState.pendingInputsMap.find( tmpPtr.get() ) == theState.pendingInputsMap.end() )
+				continue;
+			++( it->second );
+			++theState.pendingConsumersMap[tmpPtr.get()];
+			theState.consumersMap[tmpPtr.get()].push_back( itemPtr );
+			theState.producersMap[itemPtr].push_back( tmpPtr.get() );
+		}
+	}
+	// Uncached outputs with a single consumer may be handed over to it (see takeInput())
+	for( map<CPipelineItem*, unsigned int>::iterator it = theState.pendingInputsMap.begin();
+		it != theState.pendingInputsMap.end(); ++it )
+	{
+		CPipelineItem* itemPtr = it->first;
+		for( unsigned int i = 0; i < itemPtr->connectionsPtrVec.size(); ++i )
+		{
+			TPipelineItemPtr tmpPtr = itemPtr->connectionsPtrVec[i].outputItem.lock();
+			itemPtr->inputsVec[i].bExclusive = tmpPtr && !tmpPtr->bCacheOutputs
+				&& theState.consumersMap[tmpPtr.get()].size() == 1;
 		}
-	}	
-	while( !itemsPriQueue.empty() )
+	}
+	for( map<CPipelineItem*, unsigned int>::iterator it = theState.pendingInputsMap.begin();
+		it != theState.pendingInputsMap.end(); ++it )
 	{
-		itemsPriQueue.top()->execute();
-		itemsPriQueue.pop();
+		if ( it->second > 0 )
+			continue;
+		if ( it->first->isExecutedInMainThread() )
+			theState.mainReadyQueue.push_back( it->first );
+		else
+			theState.readyQueue.push_back( it->first );
 	}
 	allItemsSet.clear();
+
+	theState.uiMaxWorkers = getNumberOfThreads() - 1;
+	if ( theState.uiMaxWorkers > theState.ulRemaining )
+		theState.uiMaxWorkers = theState.ulRemaining;
+	{
+		boost::mutex::scoped_lock lock( theState.theMutex );
+		theState.uiWorkers = getThreadPool().start( boost::bind( &CPipelineItem::runWorker, statePtr, false ),
+			std::min<unsigned int>( theState.uiMaxWorkers, theState.readyQueue.size() ) );
+	}
+	runWorker( statePtr, true );
+	getDataPool().trim();
 DS( "--- CPipelineItem::iterate " );
 }
 
+/**
+ * Fetches ready items from the queues of the given run and executes them. The
+ * thread which called update() returns after all items of the run are finished.
+ * Pool threads return as soon as no item is ready and hand the thread back to
+ * the pool. Further pool threads are requested whenever more items become
+ * ready than threads are working on the run.
+ * \param aStatePtr shared state of the actual pipeline run
+ * \param bMainThread true if this is the thread which called update()
+ */
+void CPipelineItem::runWorker( boost::shared_ptr<SRunState> aStatePtr, bool bMainThread ) throw()
+{
+	boost::mutex::scoped_lock lock( aStatePtr->theMutex );
+	while( aStatePtr->ulRemaining > 0 )
+	{
+		CPipelineItem* itemPtr = NULL;
+		if ( bMainThread && !aStatePtr->mainReadyQueue.empty() )
+		{
+			itemPtr = aStatePtr->mainReadyQueue.front();
+			aStatePtr->mainReadyQueue.pop_front();
+		}
+		else if ( !aStatePtr->readyQueue.empty() )
+		{
+			itemPtr = aStatePtr->readyQueue.front();
+			aStatePtr->readyQueue.pop_front();
+		}
+		if ( itemPtr == NULL )
+		{
+			if ( !bMainThread )
+				break;
+			aStatePtr->readyCondition.wait( lock );
+			continue;
+		}
+		lock.unlock();
+		itemPtr->execute( false );
+		lock.lock();
+
+		--aStatePtr->ulRemaining;
+		vector<CPipelineItem*>& consumersVec = aStatePtr->consumersMap[itemPtr];
+		for( vector<CPipelineItem*>::iterator it = consumersVec.begin(); it != consumersVec.end(); ++it )
+		{
+			if ( --aStatePtr->pendingInputsMap[*it] > 0 )
+				continue;
+			if ( (*it)->isExecutedInMainThread() )
+				aStatePtr->mainReadyQueue.push_back( *it );
+			else
+				aStatePtr->readyQueue.push_back( *it );
+		}
+		// Release upstream outputs once their last consumer is done
+		vector<CPipelineItem*>& producersVec = aStatePtr->producersMap[itemPtr];
+		for( vector<CPipelineItem*>::iterator it = producersVec.begin(); it != producersVec.end(); ++it )
+			if ( --aStatePtr->pendingConsumersMap[*it] == 0 )
+				(*it)->clearCache();
+		if ( aStatePtr->uiWorkers < aStatePtr->uiMaxWorkers
+			&& aStatePtr->uiWorkers < aStatePtr->readyQueue.size() )
+			aStatePtr->uiWorkers += getThreadPool().start( boost::bind( &CPipelineItem::runWorker, aStatePtr, false ),
+				std::min<unsigned int>( aStatePtr->uiMaxWorkers, aStatePtr->readyQueue.size() ) - aStatePtr->uiWorkers );
+		aStatePtr->readyCondition.notify_all();
+	}
+	if ( !bMainThread )
+		--aStatePtr->uiWorkers;
+}
+
 /**
  * \param anInputPtr Pipeline item to connect to
  * \param uiLocalPort number of local input port
@@ -400,6 +672,282 @@ void CPipelineItem::cacheOutput( bool bCacheOutputs_ ) throw()
 	bCacheOutputs = bCacheOutputs_;
 }
 
+/**
+ * Modules which access GUI elements from within apply() must be restricted to the
+ * main thread. Modules owning a dialog window are always restricted.
+ * \returns true if the module is only executed by the thread that called update()
+ */
+bool CPipelineItem::isExecutedInMainThread() const throw()
+{
+	return bMainThreadOnly || ( itemDialog && itemDialog->hasDialog() );
+}
+
+/** \param bMainThreadOnly_ true == module is only executed by the thread that called update() */
+void CPipelineItem::executeInMainThread( bool bMainThreadOnly_ ) throw()
+{
+	bMainThreadOnly = bMainThreadOnly_;
+}
+
+/** \returns true if the results of the module are kept in the result cache */
+bool CPipelineItem::isMemoised() const throw()
+{
+	return bMemoise;
+}
+
+/**
+ * Memoisation is disabled by default. Enable it for expensive modules whose
+ * parameters are changed back and forth interactively. A memoised output stays
+ * in memory after the pipeline run, and downstream items that modify it copy
+ * it once instead of taking it over. Modules whose results do not only depend
+ * on their parameters and inputs (e.g. random numbers or external state) must
+ * never be memoised.
+ * \param bMemoise_ true == results may be taken from the global CResultCache
+ */
+void CPipelineItem::memoiseResults( bool bMemoise_ ) throw()
+{
+	bMemoise = bMemoise_;
+}
+
+/**
+ * Reimplement this in modules whose results depend on the parameters in a way
+ * that memoiseResults() cannot express, e.g. a random seed which is taken from
+ * the clock for some parameter values. The results of a module are only cached
+ * if this returns true.
+ * \returns true if the outputs only depend on the parameters and inputs
+ */
+bool CPipelineItem::isDeterministic() const throw()
+{
+	return true;
+}
+
+/**
+ * \param uiNoOfThreads_ maximum number of threads used to execute a pipeline.
+ *   1 executes all items serially, 0 uses one thread per processor core.
+ */
+void CPipelineItem::setNumberOfThreads( unsigned int uiNoOfThreads_ ) throw()
+{
+	uiNoOfThreads = uiNoOfThreads_;
+}
+
+/** \returns the maximum number of threads used to execute a pipeline */
+unsigned int CPipelineItem::getNumberOfThreads() throw()
+{
+	if ( uiNoOfThreads > 0 )
+		return uiNoOfThreads;
+	unsigned int uiCores = boost::thread::hardware_concurrency();
+	return ( uiCores > 0 ) ? uiCores : 1;
+}
+
+/**
+ * Streaming items compute their outputs from regions of their inputs
+ * (see computeRegion()). For targets this means that they accept their inputs
+ * region by region (see updateStreamed()). Reimplement this if only some
+ * parameter settings allow streaming.
+ * \returns true if the item can process its data region by region
+ */
+bool CPipelineItem::isStreamable() const throw()
+{
+	return bStreamable;
+}
+
+/**
+ * The default implementation enlarges the output region by getStreamingMargin()
+ * voxels in each dimension and clips it to the input extents. Reimplement
+ * this if the item needs a different region, e.g. if it changes the extents
+ * of its data.
+ * \param usInputNumber input port
+ * \param anOutputRegion requested region of the outputs
+ * \param inputExtentVec extents of the complete input
+ * \returns the input region needed to compute anOutputRegion
+ */
+CDataSetRegion CPipelineItem::getRequiredInputRegion( unsigned short,
+	const CDataSetRegion& anOutputRegion, const std::vector<size_t>& inputExtentVec ) const throw()
+{
+	const size_t margin = getStreamingMargin();
+	std::vector<size_t> originVec( anOutputRegion.getOrigin() );
+	std::vector<size_t> extentVec( anOutputRegion.getExtents() );
+	for( unsigned short i = 0; i < originVec.size() && i < inputExtentVec.size(); ++i )
+	{
+		const size_t regionEnd = std::min( originVec[i] + extentVec[i] + margin, inputExtentVec[i] );
+		originVec[i] = ( originVec[i] > margin ) ? originVec[i] - margin : 0;
+		extentVec[i] = regionEnd - originVec[i];
+	}
+	return CDataSetRegion( extentVec, originVec );
+}
+
+/**
+ * Streaming items assume that their outputs have the extents of their first
+ * input and ask their upstream item. All other items are updated. Sources
+ * may reimplement this to determine the extents without loading their data.
+ * \param usOutputNumber output port
+ * \returns the extents of the output or an empty vector if there is no output
+ */
+std::vector<size_t> CPipelineItem::getOutputExtents( unsigned short usOutputNumber ) throw()
+{
+	if ( isStreamable() && usFanIn > 0 )
+	{
+		if ( TPipelineItemPtr tmpPtr = connectionsPtrVec[0].outputItem.lock() )
+			return tmpPtr->getOutputExtents( connectionsPtrVec[0].outputPort );
+	}
+	std::vector<size_t> extentVec;
+	if ( usOutputNumber >= usFanOut )
+		return extentVec;
+	update();
+	if ( TDataSetPtr outputPtr = outputsVec[usOutputNumber].portData )
+		for( unsigned short i = 0; i < outputPtr->getDimension(); ++i )
+			extentVec.push_back( outputPtr->getExtent( i ) );
+	return extentVec;
+}
+
+/**
+ * Streaming items fetch the required regions of their inputs (see
+ * getRequiredInputRegion()), call apply() on them and cut the requested region
+ * out of the result. The outputs aren't kept, so peak memory only depends on
+ * the region size. All other items are updated normally and the region is
+ * copied from their complete output. Sources may reimplement this to read
+ * only the region (see CDataFileServer::loadRegion()).
+ * \param anOutputRegion requested region
+ * \param usOutputNumber output port
+ * \returns a new data set holding the region or an empty pointer if it couldn't be computed
+ */
+TDataSetPtr CPipelineItem::computeRegion( const CDataSetRegion& anOutputRegion,
+	unsigned short usOutputNumber ) throw()
+{
+	if ( usOutputNumber >= usFanOut )
+		return TDataSetPtr();
+	if ( !isStreamable() || usFanIn == 0 )
+	{
+		update();
+		TDataSetPtr outputPtr = outputsVec[usOutputNumber].portData;
+		if ( !outputPtr )
+			return outputPtr;
+		return TDataSetPtr( outputPtr->cloneRegion( anOutputRegion.getOrigin(), anOutputRegion.getExtents() ) );
+	}
+DBG1( "+++ CPipelineItem::computeRegion " << sName );
+	// The input regions are only held here, inputsVec just refers to them
+	vector<TDataSetPtr> inputRegionsVec( usFanIn );
+	vector<size_t> inputOriginVec;
+	for( unsigned int i = 0; i < connectionsPtrVec.size(); ++i )
+	{
+		TPipelineItemPtr tmpPtr = connectionsPtrVec[i].outputItem.lock();
+		if ( !tmpPtr )
+			continue;
+		const unsigned int uiPort = connectionsPtrVec[i].outputPort;
+		CDataSetRegion inputRegion = getRequiredInputRegion( i, anOutputRegion,
+			tmpPtr->getOutputExtents( uiPort ) );
+		if ( i == 0 )
+			inputOriginVec = inputRegion.getOrigin();
+		inputRegionsVec[i] = tmpPtr->computeRegion( inputRegion, uiPort );
+		setInput( inputRegionsVec[i], i );
+	}
+	TDataSetPtr outputPtr;
+	if ( inputRegionsVec[0] )
+	{
+		this->apply();
+		outputPtr = outputsVec[usOutputNumber].portData;
+	}
+	// A later update() must not take the partial outputs for complete ones
+	for( unsigned int i = 0; i < outputsVec.size(); ++i )
+		outputsVec[i].portData.reset();
+	for( unsigned int i = 0; i < inputsVec.size(); ++i )
+	{
+		inputsVec[i].portData.reset();
+		inputsVec[i].bExclusive = false;
+	}
+	bRecompute = true;
+	if ( !outputPtr )
+		return outputPtr;
+	// Cut off the margin
+	vector<size_t> offsetVec( anOutputRegion.getOrigin() );
+	bool bCut = false;
+	for( unsigned short i = 0; i < offsetVec.size(); ++i )
+	{
+		offsetVec[i] -= inputOriginVec[i];
+		if ( offsetVec[i] != 0 || anOutputRegion.getExtent( i ) != outputPtr->getExtent( i ) )
+			bCut = true;
+	}
+DS( "--- CPipelineItem::computeRegion " << sName );
+	if ( !bCut )
+		return outputPtr;
+	return TDataSetPtr( outputPtr->cloneRegion( offsetVec, anOutputRegion.getExtents() ) );
+}
+
+/**
+ * The first input is divided into slabs of slabSize voxels along its last
+ * dimension. For each slab, the corresponding regions of all inputs are
+ * computed (see computeRegion()) and applyRegion() is called. Items which
+ * are not streamable are updated normally.
+ * \param slabSize thickness of each slab
+ */
+void CPipelineItem::updateStreamed( const size_t slabSize ) throw()
+{
+	TPipelineItemPtr firstPtr;
+	if ( usFanIn > 0 )
+		firstPtr = connectionsPtrVec[0].outputItem.lock();
+	if ( !isStreamable() || slabSize == 0 || !firstPtr )
+	{
+		update();
+		return;
+	}
+DBG1( "+++ CPipelineItem::updateStreamed " << sName );
+	const vector<size_t> extentVec = firstPtr->getOutputExtents( connectionsPtrVec[0].outputPort );
+	if ( extentVec.empty() )
+		return;
+	const unsigned short usSlabDimension = extentVec.size() - 1;
+	vector<size_t> originVec( extentVec.size(), 0 );
+	vector<size_t> slabExtentVec( extentVec );
+	for( size_t slabStart = 0; slabStart < extentVec[usSlabDimension]; slabStart += slabSize )
+	{
+		originVec[usSlabDimension] = slabStart;
+		slabExtentVec[usSlabDimension] = std::min( slabSize, extentVec[usSlabDimension] - slabStart );
+		CDataSetRegion theRegion( slabExtentVec, originVec );
+		vector<TDataSetPtr> inputRegionsVec( usFanIn );
+		for( unsigned int i = 0; i < connectionsPtrVec.size(); ++i )
+			if ( TPipelineItemPtr tmpPtr = connectionsPtrVec[i].outputItem.lock() )
+			{
+				inputRegionsVec[i] = tmpPtr->computeRegion( theRegion, connectionsPtrVec[i].outputPort );
+				setInput( inputRegionsVec[i], i );
+			}
+		applyRegion( theRegion, extentVec );
+		for( unsigned int i = 0; i < inputsVec.size(); ++i )
+			inputsVec[i].portData.reset();
+	}
+DS( "--- CPipelineItem::updateStreamed " << sName );
+}
+
+/**
+ * Filters should call this in their constructor if apply() computes correct
+ * results on regions of the inputs (i.e. if it doesn't depend on global
+ * properties of the data) and reimplement getStreamingMargin(). Targets call
+ * this if they reimplement applyRegion().
+ * \param bStreamable_ true == item can process its data region by region
+ */
+void CPipelineItem::enableStreaming( bool bStreamable_ ) throw()
+{
+	bStreamable = bStreamable_;
+}
+
+/**
+ * Used by the default implementation of getRequiredInputRegion(). This is the
+ * kernel radius for simple neighbourhood filters.
+ * \returns the number of additional voxels needed on each side of an output region
+ */
+size_t CPipelineItem::getStreamingMargin() const throw()
+{
+	return 0;
+}
+
+/**
+ * Reimplement this in streamable targets. The input ports hold the data of the
+ * given region while this method is called. Regions are passed in ascending
+ * order, beginning at the origin.
+ * \param aRegion region of the complete input which is processed
+ * \param extentVec extents of the complete input
+ */
+void CPipelineItem::applyRegion( const CDataSetRegion&, const std::vector<size_t>& ) throw()
+{
+}
+
 void CPipelineItem::clearCache() throw()
 {
 	if ( !bCacheOutputs )
@@ -410,6 +958,57 @@ void CPipelineItem::clearCache() throw()
 		}
 }
 
+/**
+ * The key consists of the class name and version, the module ID, all parameters and
+ * one key per input. The key of an input is the result key of the upstream output
+ * if the upstream item is memoised itself, otherwise the generation stamp of the
+ * upstream output (which changes each time the upstream item is executed) or, for
+ * outputs set outside of execute(), a hash of the input contents. Sources, targets,
+ * items with their own dialog window (which might depend on apply() being called),
+ * items which are not deterministic (see isDeterministic()) and items with inputs
+ * that cannot be hashed are never memoised.
+ * Keys which depend on generation stamps start with '@' and are only valid while
+ * the program runs (see CResultCache).
+ * \returns the key, an empty string if the results must not be cached
+ */
+string CPipelineItem::computeResultKey() throw()
+{
+	if ( !bMemoise || usFanIn == 0 || usFanOut == 0 || ( itemDialog && itemDialog->hasDialog() )
+		|| !isDeterministic() || !getResultCache().isEnabled() )
+		return "";
+	ostringstream os;
+	os << getClassName() << " " << getClassVersion() << " " << sModuleID << "\n";
+	vector<string> keyVec = parameters.getKeyList();
+	for( vector<string>::const_iterator it = keyVec.begin(); it != keyVec.end(); ++it )
+		os << *it << "=" << parameters.getString( *it ) << "\n";
+	bool bHasInput = false;
+	bool bVolatile = false;
+	for( unsigned int i = 0; i < connectionsPtrVec.size(); ++i )
+	{
+		TPipelineItemPtr tmpPtr = connectionsPtrVec[i].outputItem.lock();
+		TDataSetPtr inputPtr = getInput( i );
+		if ( !tmpPtr || !inputPtr )
+			os << "-\n";
+		else if ( !tmpPtr->outputsVec[connectionsPtrVec[i].outputPort].sResultKey.empty() )
+		{
+			const string& sInputKey = tmpPtr->outputsVec[connectionsPtrVec[i].outputPort].sResultKey;
+			os << sInputKey << "\n";
+			bVolatile = bVolatile || sInputKey[0] == '@';
+		}
+		else
+		{
+			string sHash = CResultCache::hashDataSet( *inputPtr );
+			if ( sHash.empty() )
+				return "";
+			os << sHash << "\n";
+		}
+		bHasInput = bHasInput || inputPtr;
+	}
+	if ( !bHasInput )
+		return "";
+	return ( bVolatile ? "@" : "" ) + getClassName() + "-" + CResultCache::hashString( os.str() );
+}
+
 /** \returns the module Dialog */
 boost::shared_ptr<CModuleDialog> CPipelineItem::getModuleDialog() const
 	throw()
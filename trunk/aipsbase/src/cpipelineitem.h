@@ -42,6 +42,14 @@
  *        2006-06-03 Made deleteOldOutput() public                      *
  *                   Made checkInput<>() only outputting debug info     *
  *                    instead of warnings.                              *
+ *        2026-10-17 Replaced the depth priority queue by a dependency  *
+ *                    graph scheduler running on a worker pool          *
+ *                   Added takeInput() for in-place processing          *
+ *                   Added region based streaming (computeRegion(),     *
+ *                    updateStreamed())                                 *
+ *                   Added opt-in memoisation of results (CResultCache) *
+ *                   Added profiling of module executions (CProfiler)   *
+ *                   Workers now share the global CThreadPool           *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -62,6 +70,7 @@
 //#include "ctypeddata.h"
 #include "ctypedmap.h"
 #include "cmoduledialog.h"
+#include "cdatasetregion.h"
 
 #ifdef BENCHMARK
 #include <boost/timer.hpp>
@@ -165,11 +174,13 @@ protected:
   {
     EIOTypes portType;      ///< Port io type
     boost::weak_ptr<CDataSet> portData;     ///< Data on port
+    bool bExclusive;        ///< Are we the only reader of an uncached upstream output?
   };
   struct SOPort
   {
     EIOTypes portType;      ///< Port io type
     TDataSetPtr portData;     ///< Data on port
+    std::string sResultKey;   ///< Result cache key or generation stamp of the data on port
   };
   /** Connection structure */
   struct SConnection
@@ -300,6 +311,33 @@ public:
 	template<typename U, typename T> bool checkInput( T inputPtr, unsigned short usMinDim = 0, unsigned short usMaxDim = 0, unsigned short usMinDataDim = 0, unsigned short usMaxDataDim = 0) throw();
 	bool isOutputCached() const throw();
 	void cacheOutput( bool bCacheOutputs_ = true ) throw();
+	/// Returns true if the module must be executed by the thread that called update()
+	bool isExecutedInMainThread() const throw();
+	/// Restricts execution of the module to the thread that called update()
+	void executeInMainThread( bool bMainThreadOnly_ = true ) throw();
+	/// Sets the maximum number of threads used to execute a pipeline (0 == number of cores)
+	static void setNumberOfThreads( unsigned int uiNoOfThreads_ ) throw();
+	/// Returns the maximum number of threads used to execute a pipeline
+	static unsigned int getNumberOfThreads() throw();
+	/// Returns true if the results of the module are kept in the result cache
+	bool isMemoised() const throw();
+	/// Enables or disables the result cache for this module
+	void memoiseResults( bool bMemoise_ = true ) throw();
+	/// Returns true if the outputs only depend on the parameters and inputs
+	virtual bool isDeterministic() const throw();
+/* Streaming */
+	/// Returns true if the item can process its data region by region
+	virtual bool isStreamable() const throw();
+	/// Returns the region of an input which is needed to compute the given output region
+	virtual CDataSetRegion getRequiredInputRegion( unsigned short usInputNumber,
+		const CDataSetRegion& anOutputRegion, const std::vector<size_t>& inputExtentVec ) const throw();
+	/// Returns the extents of an output, computing as little of the pipeline as possible
+	virtual std::vector<size_t> getOutputExtents( unsigned short usOutputNumber = 0 ) throw();
+	/// Computes a region of an output
+	virtual TDataSetPtr computeRegion( const CDataSetRegion& anOutputRegion, unsigned short usOutputNumber = 0 )
+		throw();
+	/// Processes the inputs slab by slab (see applyRegion())
+	void updateStreamed( const size_t slabSize ) throw();
 /* Dialog member functions */
 	/// Returns the module Dialog
   boost::shared_ptr<CModuleDialog> getModuleDialog() const
@@ -311,6 +349,15 @@ public:
   void deleteOldOutput( unsigned short usOutputNumber = 0 )
     throw( OutOfRangeException );
 protected:
+  /// Returns the input dataset for modification (e.g. to be used as output)
+  TDataSetPtr takeInput( unsigned short usInputNumber = 0 )
+    throw( OutOfRangeException );
+	/// Declares if the item can process its data region by region
+	void enableStreaming( bool bStreamable_ = true ) throw();
+	/// Returns the number of voxels around an output region which are needed to compute it
+	virtual size_t getStreamingMargin() const throw();
+	/// Processes one region of the inputs. Called by updateStreamed()
+	virtual void applyRegion( const CDataSetRegion& aRegion, const std::vector<size_t>& extentVec ) throw();
   std::vector<SIPort> inputsVec;     	 ///< Input dataset
   std::vector<SOPort> outputsVec; 			 ///< Output dataset
   CParameterMap parameters; 					 ///< Array of parameter names
@@ -330,24 +377,26 @@ private:
   std::vector<unsigned long> connectionsTimeStampsVec; ///< Time stamps of all connections
   boost::shared_ptr<CModuleDialog> itemDialog;  ///< Item dialog
 	bool bRecompute; ///< Do we enforce a recomputation of all outputs?
+	bool bMainThreadOnly; ///< Must the module be executed by the thread that called update()?
+	bool bStreamable; ///< Can the module process its data region by region?
+	bool bMemoise; ///< May the results be taken from the result cache?
 
-  struct itemCompareFunctor ///< Functor to compare two pipeline items
-	{
-		bool operator() ( CPipelineItem* a, CPipelineItem* b ) throw();
-	};
+	struct SRunState; ///< Shared scheduling state of one pipeline run
 
 	static std::set<CPipelineItem*> allItemsSet; ///< All items of the pipeline we're actually working on
-
-	static std::priority_queue<CPipelineItem*, std::vector<CPipelineItem*>, itemCompareFunctor>
-		itemsPriQueue; ///< Priority queue to execute all pipeline items in correct order
+	static unsigned int uiNoOfThreads; ///< Maximum number of threads per pipeline run (0 == number of cores)
 private:
 	/// Actually execute the pipeline item
-  void execute() throw();
+  void execute( bool bReleaseInputs = true ) throw();
   /// Clear all outputs
   void clearCache() throw();
+  /// Computes the result cache key of the actual parameters and inputs
+  std::string computeResultKey() throw();
   // Static members
   /// Iterate through pipeline hierarchy
   static void iterate() throw();
+  /// Worker loop executing all items that are ready
+  static void runWorker( boost::shared_ptr<SRunState> aStatePtr, bool bMainThread ) throw();
 };
 
 #include "cpipelineiteminlines.tpp"
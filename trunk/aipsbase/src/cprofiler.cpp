@@ -0,0 +1,319 @@
+/************************************************************************
+ * File: cprofiler.cpp                                                  *
+ * Project: AIPS                                                        *
+ * Description: Per-module profiling of pipeline runs                   *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#include "cprofiler.h"
+
+// Standard includes
+#include <algorithm>
+#include <cstdlib> // std::getenv
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+using namespace aips;
+
+namespace
+{
+
+/// Names of the outcomes as used in traces and summaries
+const char* outcomeNameArr[] = { "computed", "cache hit", "skipped" };
+
+/// Returns the string enclosed in quotes with all JSON special characters escaped
+string jsonString( const string& sValue )
+{
+	ostringstream os;
+	os << '"';
+	for( string::const_iterator it = sValue.begin(); it != sValue.end(); ++it )
+	{
+		if ( *it == '"' || *it == '\\' )
+			os << '\\' << *it;
+		else if ( static_cast<unsigned char>( *it ) < 0x20 )
+			os << "\\u" << hex << setw( 4 ) << setfill( '0' ) << static_cast<int>( *it ) << dec;
+		else
+			os << *it;
+	}
+	os << '"';
+	return os.str();
+}
+
+/// Accumulated records of one module
+struct SModuleSummary
+{
+	string sModuleName;
+	string sClassName;
+	unsigned long ulExecutions[3]; ///< Number of executions for each outcome
+	double dWallTime;
+	double dCPUTime;
+	size_t outputBytes;
+	size_t voxels;
+	SModuleSummary() : dWallTime( 0.0 ), dCPUTime( 0.0 ), outputBytes( 0 ), voxels( 0 )
+	{
+		ulExecutions[0] = ulExecutions[1] = ulExecutions[2] = 0;
+	}
+	/// Sorts the modules by decreasing wall time
+	bool operator<( const SModuleSummary& aSummary ) const
+	{
+		return dWallTime > aSummary.dWallTime;
+	}
+};
+
+}
+
+/*************
+ * Structors *
+ *************/
+
+CProfiler::CProfiler() throw()
+	: CBase( "CProfiler", CPROFILER_VERSION, "CBase" ), ulRun( 0 ), bEnabled( false ),
+	startTime( boost::posix_time::microsec_clock::universal_time() )
+{
+	const char* sFileName = getenv( "AIPS_PROFILE" );
+	if ( sFileName != NULL && *sFileName != '\0' )
+	{
+		sTraceFileName = sFileName;
+		bEnabled = true;
+	}
+}
+
+/**
+ * Writes the trace file if AIPS_PROFILE was set
+ */
+CProfiler::~CProfiler() throw()
+{
+	if ( !sTraceFileName.empty() )
+		writeTrace( sTraceFileName );
+}
+
+/*************
+ * Accessors *
+ *************/
+
+/** \returns true if module executions are recorded */
+bool CProfiler::isEnabled() const throw()
+{
+	boost::mutex::scoped_lock lock( profilerMutex );
+	return bEnabled;
+}
+
+/** \returns the number of the actual pipeline run */
+unsigned long CProfiler::getRunNumber() const throw()
+{
+	boost::mutex::scoped_lock lock( profilerMutex );
+	return ulRun;
+}
+
+/** \returns a copy of all records in the order they were added */
+std::vector<CProfiler::SRecord> CProfiler::getRecords() const throw()
+{
+	boost::mutex::scoped_lock lock( profilerMutex );
+	return recordVec;
+}
+
+/** \returns the seconds passed since the profiler was created */
+double CProfiler::getWallClock() const throw()
+{
+	return ( boost::posix_time::microsec_clock::universal_time() - startTime ).total_microseconds() * 1.0e-6;
+}
+
+/**
+ * On systems without per thread CPU clocks this returns the CPU time of the whole process.
+ * \returns the CPU time used by the calling thread in seconds
+ */
+double CProfiler::getThreadCPUTime() throw()
+{
+#if defined( CLOCK_THREAD_CPUTIME_ID )
+	timespec theTime;
+	if ( clock_gettime( CLOCK_THREAD_CPUTIME_ID, &theTime ) == 0 )
+		return theTime.tv_sec + theTime.tv_nsec * 1.0e-9;
+#endif
+	return static_cast<double>( clock() ) / CLOCKS_PER_SEC;
+}
+
+/************
+ * Mutators *
+ ************/
+
+/** \param bEnabled_ true if module executions should be recorded */
+void CProfiler::setEnabled( const bool bEnabled_ ) throw()
+{
+	boost::mutex::scoped_lock lock( profilerMutex );
+	bEnabled = bEnabled_;
+}
+
+/*****************
+ * Other methods *
+ *****************/
+
+/** \returns the number of the new run */
+unsigned long CProfiler::beginRun() throw()
+{
+	boost::mutex::scoped_lock lock( profilerMutex );
+	return ++ulRun;
+}
+
+/**
+ * The run number and the thread number of the record are set by this method.
+ * \param aRecord record to add
+ */
+void CProfiler::addRecord( const SRecord& aRecord ) throw()
+{
+	boost::mutex::scoped_lock lock( profilerMutex );
+	recordVec.push_back( aRecord );
+	recordVec.back().ulRun = ulRun;
+	std::map<boost::thread::id, unsigned int>::iterator it = threadMap.find( boost::this_thread::get_id() );
+	if ( it == threadMap.end() )
+	{
+		unsigned int uiThread = threadMap.size();
+		threadMap[boost::this_thread::get_id()] = uiThread;
+		recordVec.back().uiThread = uiThread;
+	}
+	else
+		recordVec.back().uiThread = it->second;
+}
+
+void CProfiler::clear() throw()
+{
+	boost::mutex::scoped_lock lock( profilerMutex );
+	recordVec.clear();
+	ulRun = 0;
+}
+
+/**
+ * Each computed module and each cache hit becomes a complete event, skipped
+ * modules become instant events. Times are given in microseconds. All other
+ * values of the records are added as event arguments.
+ * \param sFileName name of the file
+ * \returns true if the file was written
+ */
+bool CProfiler::writeTrace( const std::string& sFileName ) const throw()
+{
+	std::vector<SRecord> theRecordVec = getRecords();
+	unsigned int uiNoOfThreads;
+	{
+		boost::mutex::scoped_lock lock( profilerMutex );
+		uiNoOfThreads = threadMap.size();
+	}
+	std::ofstream theFile( sFileName.c_str() );
+	if ( !theFile.is_open() )
+		return false;
+	theFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	for( unsigned int i = 0; i < uiNoOfThreads; ++i )
+		theFile << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << i
+			<< ",\"args\":{\"name\":\"Pipeline thread " << i << "\"}},\n";
+	theFile << fixed << setprecision( 3 );
+	for( std::vector<SRecord>::const_iterator it = theRecordVec.begin(); it != theRecordVec.end(); ++it )
+	{
+		theFile << "{\"name\":" << jsonString( it->sModuleName ) << ",\"cat\":\""
+			<< outcomeNameArr[it->outcome] << "\",\"pid\":0,\"tid\":" << it->uiThread
+			<< ",\"ts\":" << it->dStartTime * 1.0e6;
+		if ( it->outcome == Skipped )
+			theFile << ",\"ph\":\"i\",\"s\":\"t\"";
+		else
+			theFile << ",\"ph\":\"X\",\"dur\":" << it->dWallTime * 1.0e6;
+		theFile << ",\"args\":{\"class\":" << jsonString( it->sClassName ) << ",\"id\":" << it->ulID
+			<< ",\"run\":" << it->ulRun << ",\"cpu_us\":" << it->dCPUTime * 1.0e6
+			<< ",\"output_bytes\":" << it->outputBytes << ",\"voxels\":" << it->voxels
+			<< ",\"outcome\":\"" << outcomeNameArr[it->outcome] << "\"}}";
+		if ( it + 1 != theRecordVec.end() )
+			theFile << ",";
+		theFile << "\n";
+	}
+	theFile << "]}\n";
+	return !theFile.fail();
+}
+
+/**
+ * The table has one line per module, sorted by decreasing wall time, and a line
+ * with the totals of all modules.
+ * \param os stream to write to
+ */
+void CProfiler::writeSummary( std::ostream& os ) const throw()
+{
+	std::vector<SRecord> theRecordVec = getRecords();
+	std::map<unsigned long, SModuleSummary> summaryMap;
+	SModuleSummary theTotal;
+	theTotal.sModuleName = "Total";
+	for( std::vector<SRecord>::const_iterator it = theRecordVec.begin(); it != theRecordVec.end(); ++it )
+	{
+		SModuleSummary& theSummary = summaryMap[it->ulID];
+		theSummary.sModuleName = it->sModuleName;
+		theSummary.sClassName = it->sClassName;
+		SModuleSummary* summaryPtrArr[2] = { &theSummary, &theTotal };
+		for( int i = 0; i < 2; ++i )
+		{
+			++summaryPtrArr[i]->ulExecutions[it->outcome];
+			summaryPtrArr[i]->dWallTime += it->dWallTime;
+			summaryPtrArr[i]->dCPUTime += it->dCPUTime;
+			summaryPtrArr[i]->outputBytes += it->outputBytes;
+			summaryPtrArr[i]->voxels += it->voxels;
+		}
+	}
+	std::vector<SModuleSummary> summaryVec;
+	for( std::map<unsigned long, SModuleSummary>::const_iterator it = summaryMap.begin();
+		it != summaryMap.end(); ++it )
+		summaryVec.push_back( it->second );
+	std::sort( summaryVec.begin(), summaryVec.end() );
+	summaryVec.push_back( theTotal );
+
+	std::ios::fmtflags oldFlags = os.flags();
+	os << left << setw( 24 ) << "Module" << setw( 20 ) << "Class" << right
+		<< setw( 9 ) << "Computed" << setw( 6 ) << "Hits" << setw( 7 ) << "Skips"
+		<< setw( 12 ) << "Wall [ms]" << setw( 12 ) << "Mean [ms]" << setw( 12 ) << "CPU [ms]"
+		<< setw( 11 ) << "Out [MB]" << setw( 12 ) << "MVoxels" << "\n";
+	os << fixed << setprecision( 2 );
+	for( std::vector<SModuleSummary>::const_iterator it = summaryVec.begin(); it != summaryVec.end(); ++it )
+	{
+		unsigned long ulTimed = it->ulExecutions[Computed] + it->ulExecutions[CacheHit];
+		os << left << setw( 24 ) << it->sModuleName.substr( 0, 23 ) << setw( 20 )
+			<< it->sClassName.substr( 0, 19 ) << right
+			<< setw( 9 ) << it->ulExecutions[Computed] << setw( 6 ) << it->ulExecutions[CacheHit]
+			<< setw( 7 ) << it->ulExecutions[Skipped]
+			<< setw( 12 ) << it->dWallTime * 1.0e3
+			<< setw( 12 ) << ( ulTimed > 0 ? it->dWallTime * 1.0e3 / ulTimed : 0.0 )
+			<< setw( 12 ) << it->dCPUTime * 1.0e3
+			<< setw( 11 ) << it->outputBytes / 1048576.0
+			<< setw( 12 ) << it->voxels * 1.0e-6 << "\n";
+	}
+	os.flags( oldFlags );
+}
+
+const std::string CProfiler::dump() const throw()
+{
+	std::ostringstream os;
+	{
+		boost::mutex::scoped_lock lock( profilerMutex );
+		os << "bEnabled " << bEnabled << " ulRun " << ulRun << " records " << recordVec.size()
+			<< " threads " << threadMap.size() << " sTraceFileName \"" << sTraceFileName << "\"\n";
+	}
+	writeSummary( os );
+	return CBase::dump() + os.str();
+}
+
+/*****************************
+ * Global profiler instance *
+ *****************************/
+
+namespace aips {
+
+/** \returns the global profiler */
+CProfiler& getProfiler() throw()
+{
+	static CProfiler theProfiler;
+	return theProfiler;
+}
+
+}
@@ -0,0 +1,152 @@
+/************************************************************************
+ * File: cprofiler.h                                                    *
+ * Project: AIPS                                                        *
+ * Description: Per-module profiling of pipeline runs                   *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Version: 0.1                                                         *
+ * Status : Beta                                                        *
+ * Created: 2026-10-17                                                  *
+ * Changed:                                                             *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#ifndef CPROFILER_H
+#define CPROFILER_H
+
+#define CPROFILER_VERSION "0.1"
+
+// Standard includes
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Boost includes
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+// AIPS includes
+#include "cbase.h"
+
+namespace aips {
+
+/**
+ * \brief Records the execution of pipeline items.
+ *
+ * If the profiler is enabled, CPipelineItem::execute() adds one record per
+ * module and pipeline run. A record holds the wall and CPU time of the
+ * module, the bytes of its newly computed outputs, the number of voxels it
+ * processed and whether it was computed, taken from the result cache or
+ * skipped because its inputs did not change.
+ *
+ * The records can be exported as a Chrome trace (load the file in
+ * chrome://tracing or Perfetto) with writeTrace() and summarised per module
+ * with writeSummary().
+ *
+ * The profiler is disabled by default. If the environment variable
+ * AIPS_PROFILE is set, it is enabled on startup and the trace is written to
+ * the file named by AIPS_PROFILE when the program ends.
+ *
+ * The profiler is thread safe. Use getProfiler() to retrieve the global
+ * instance.
+ */
+class CProfiler : public CBase
+{
+private:
+	/// Copy constructor
+	CProfiler( const CProfiler& );
+	/// Assignment operator
+	CProfiler& operator=( const CProfiler& );
+public:
+	/// What happened to a module during a run
+	enum EOutcome { Computed = 0, ///< apply() was called
+		CacheHit, ///< The outputs were taken from the result cache
+		Skipped ///< The inputs did not change, the old outputs were kept
+	};
+	/// Profile of one module execution
+	struct SRecord
+	{
+		std::string sModuleName;  ///< Module name
+		std::string sClassName;   ///< Class of the module
+		unsigned long ulID;       ///< Processing ID of the module
+		unsigned long ulRun;      ///< Pipeline run (see beginRun())
+		unsigned int uiThread;    ///< Running number of the executing thread
+		double dStartTime;        ///< Start of the execution in seconds (see getWallClock())
+		double dWallTime;         ///< Wall time in seconds
+		double dCPUTime;          ///< CPU time of the executing thread in seconds
+		size_t outputBytes;       ///< Size of the newly computed outputs
+		size_t voxels;            ///< Number of processed voxels
+		EOutcome outcome;         ///< What happened to the module
+		SRecord() : ulID( 0 ), ulRun( 0 ), uiThread( 0 ), dStartTime( 0.0 ), dWallTime( 0.0 ),
+			dCPUTime( 0.0 ), outputBytes( 0 ), voxels( 0 ), outcome( Computed ) {}
+	};
+/* Structors */
+	/// Constructor
+	CProfiler()
+		throw();
+	/// Destructor
+	virtual ~CProfiler()
+		throw();
+/* Accessors */
+	/// Returns true if module executions are recorded
+	bool isEnabled() const
+		throw();
+	/// Returns the number of the actual pipeline run
+	unsigned long getRunNumber() const
+		throw();
+	/// Returns a copy of all records
+	std::vector<SRecord> getRecords() const
+		throw();
+	/// Returns the seconds passed since the profiler was created
+	double getWallClock() const
+		throw();
+	/// Returns the CPU time used by the calling thread in seconds
+	static double getThreadCPUTime()
+		throw();
+/* Mutators */
+	/// Enables or disables recording
+	void setEnabled( const bool bEnabled_ )
+		throw();
+/* Other methods */
+	/// Starts a new pipeline run
+	unsigned long beginRun()
+		throw();
+	/// Adds a record for the calling thread and the actual run
+	void addRecord( const SRecord& aRecord )
+		throw();
+	/// Deletes all records
+	void clear()
+		throw();
+	/// Writes all records as Chrome trace (JSON) file
+	bool writeTrace( const std::string& sFileName ) const
+		throw();
+	/// Writes a table of the accumulated records of each module
+	void writeSummary( std::ostream& os ) const
+		throw();
+	/// Reimplemented from CBase
+	virtual const std::string dump() const
+		throw();
+private:
+	std::vector<SRecord> recordVec;   ///< All records
+	std::map<boost::thread::id, unsigned int> threadMap; ///< Running numbers of all threads
+	unsigned long ulRun;              ///< Actual pipeline run
+	bool bEnabled;                    ///< Are executions recorded?
+	std::string sTraceFileName;       ///< Trace file written by the destructor (AIPS_PROFILE)
+	boost::posix_time::ptime startTime; ///< Creation time of the profiler
+	mutable boost::mutex profilerMutex; ///< Guards all members above
+};
+
+/// Returns the global profiler
+CProfiler& getProfiler()
+	throw();
+
+}
+
+#endif
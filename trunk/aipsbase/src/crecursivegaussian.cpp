@@ -0,0 +1,301 @@
+/************************************************************************
+ * File: crecursivegaussian.cpp                                         *
+ * Project: AIPS                                                        *
+ * Description: Recursive gaussian smoothing and derivatives            *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#include "crecursivegaussian.h"
+
+// Standard includes
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+// AIPS includes
+#include "aipsparallel.h"
+
+using namespace std;
+using namespace aips;
+
+namespace
+{
+
+/// Number of lines up to which smoothLines() keeps its buffers on the stack
+const size_t stackLines = 16;
+
+/**
+ * Smoothing of a data set along one axis, shared by all workers.
+ * Lines along x are filtered one by one. Lines along y are filtered slice by
+ * slice and lines along z row by row, all lines of a slice or row at once.
+ */
+struct SAxisSmoothing
+{
+	const CRecursiveGaussian* filterPtr;
+	double* dataPtr;
+	size_t extentArr[3];
+	unsigned short usAxis;
+
+	/// Number of work items: lines along x, slices or rows
+	size_t itemCount() const
+	{
+		if ( usAxis == 0 )
+			return extentArr[1] * extentArr[2];
+		return ( usAxis == 1 ) ? extentArr[2] : extentArr[1];
+	}
+	void range( const size_t first, const size_t last ) const
+	{
+		const size_t width = extentArr[0];
+		const size_t sliceSize = extentArr[0] * extentArr[1];
+		for( size_t item = first; item < last; ++item )
+		{
+			if ( usAxis == 0 )
+				filterPtr->smoothLines( dataPtr + item * width, width, 1 );
+			else if ( usAxis == 1 )
+				filterPtr->smoothLines( dataPtr + item * sliceSize, extentArr[1], width, width );
+			else
+				filterPtr->smoothLines( dataPtr + item * width, extentArr[2], sliceSize, width );
+		}
+	}
+};
+
+/**
+ * Central differences along one axis, shared by all workers.
+ * A worker processes a range of rows.
+ */
+struct SAxisDifferences
+{
+	const double* inputPtr;
+	double* outputPtr;
+	size_t extentArr[3];
+	unsigned short usAxis;
+
+	/// Number of rows
+	size_t itemCount() const
+	{
+		return extentArr[1] * extentArr[2];
+	}
+	void range( const size_t first, const size_t last ) const
+	{
+		const size_t width = extentArr[0];
+		for( size_t row = first; row < last; ++row )
+		{
+			const double* rowPtr = inputPtr + row * width;
+			double* outputRowPtr = outputPtr + row * width;
+			if ( usAxis == 0 )
+			{
+				if ( width == 1 )
+				{
+					outputRowPtr[0] = 0.0;
+					continue;
+				}
+				outputRowPtr[0] = 0.5 * ( rowPtr[1] - rowPtr[0] );
+				for( size_t x = 1; x < width - 1; ++x )
+					outputRowPtr[x] = 0.5 * ( rowPtr[x + 1] - rowPtr[x - 1] );
+				outputRowPtr[width - 1] = 0.5 * ( rowPtr[width - 1] - rowPtr[width - 2] );
+				continue;
+			}
+			// Rows before and after the actual one, borders are repeated
+			const size_t position = ( usAxis == 1 ) ? row % extentArr[1] : row / extentArr[1];
+			const size_t stride = ( usAxis == 1 ) ? width : width * extentArr[1];
+			const double* previousPtr = ( position > 0 ) ? rowPtr - stride : rowPtr;
+			const double* nextPtr = ( position + 1 < extentArr[usAxis] ) ? rowPtr + stride : rowPtr;
+			for( size_t x = 0; x < width; ++x )
+				outputRowPtr[x] = 0.5 * ( nextPtr[x] - previousPtr[x] );
+		}
+	}
+};
+
+}
+
+/*************
+ * Structors *
+ *************/
+
+/**
+ * Computes the filter coefficients (Young and van Vliet, eq. 11 and 8c) and
+ * the initial state of the anticausal pass. The latter is obtained by feeding
+ * a unit deviation from the steady state through the causal tail and the
+ * anticausal pass until it has decayed. This gives the same matrix as the
+ * closed form of Triggs and Sdika.
+ * \param dSigma_ standard deviation in voxels, values below 0.5 are raised to 0.5
+ */
+CRecursiveGaussian::CRecursiveGaussian( const double dSigma_ ) throw()
+	: CBase( "CRecursiveGaussian", CRECURSIVEGAUSSIAN_VERSION, "CBase" ), dSigma( std::max( 0.5, dSigma_ ) )
+{
+	const double q = ( dSigma >= 2.5 ) ? 0.98711 * dSigma - 0.96330
+		: 3.97156 - 4.14554 * sqrt( 1.0 - 0.26891 * dSigma );
+	const double q2 = q * q;
+	const double q3 = q2 * q;
+	const double b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+	dFeedbackArr[0] = ( 2.44413 * q + 2.85619 * q2 + 1.26661 * q3 ) / b0;
+	dFeedbackArr[1] = -( 1.4281 * q2 + 1.26661 * q3 ) / b0;
+	dFeedbackArr[2] = ( 0.422205 * q3 ) / b0;
+	dGain = 1.0 - dFeedbackArr[0] - dFeedbackArr[1] - dFeedbackArr[2];
+
+	// Index 3 is the first sample behind the line, indices 0..2 its last three samples
+	const size_t tailLength = static_cast<size_t>( 40.0 * dSigma ) + 100;
+	vector<double> causalVec( tailLength + 3 );
+	vector<double> anticausalVec( tailLength + 6 );
+	for( unsigned short j = 0; j < 3; ++j )
+	{
+		std::fill( causalVec.begin(), causalVec.end(), 0.0 );
+		std::fill( anticausalVec.begin(), anticausalVec.end(), 0.0 );
+		causalVec[2 - j] = 1.0;
+		for( size_t n = 3; n < causalVec.size(); ++n )
+			causalVec[n] = dFeedbackArr[0] * causalVec[n - 1] + dFeedbackArr[1] * causalVec[n - 2]
+				+ dFeedbackArr[2] * causalVec[n - 3];
+		for( size_t n = causalVec.size(); n-- > 3; )
+			anticausalVec[n] = dGain * causalVec[n] + dFeedbackArr[0] * anticausalVec[n + 1]
+				+ dFeedbackArr[1] * anticausalVec[n + 2] + dFeedbackArr[2] * anticausalVec[n + 3];
+		for( unsigned short m = 0; m < 3; ++m )
+			dBoundaryArr[m][j] = anticausalVec[3 + m];
+	}
+}
+
+CRecursiveGaussian::~CRecursiveGaussian() throw()
+{
+}
+
+/*************
+ * Accessors *
+ *************/
+
+/** \returns the standard deviation in voxels */
+double CRecursiveGaussian::getSigma() const throw()
+{
+	return dSigma;
+}
+
+/*****************
+ * Other methods *
+ *****************/
+
+/**
+ * Sample n of line j is stored at dataPtr[n * stride + j]. Filtering several
+ * interleaved lines at once gives contiguous inner loops for lines along y or z.
+ * \param dataPtr first sample of the first line
+ * \param count number of samples per line
+ * \param stride distance between two samples of a line
+ * \param width number of lines
+ */
+void CRecursiveGaussian::smoothLines( double* dataPtr, const size_t count, const size_t stride,
+	const size_t width ) const throw()
+{
+	if ( count == 0 || width == 0 )
+		return;
+	// Buffers: first and last input sample and three anticausal samples behind the line
+	double bufferArr[5 * stackLines];
+	vector<double> bufferVec;
+	double* bufferPtr = bufferArr;
+	if ( width > stackLines )
+	{
+		bufferVec.resize( 5 * width );
+		bufferPtr = &bufferVec[0];
+	}
+	double* firstPtr = bufferPtr;
+	double* lastPtr = bufferPtr + width;
+	double* tailPtrArr[3] = { bufferPtr + 2 * width, bufferPtr + 3 * width, bufferPtr + 4 * width };
+	std::copy( dataPtr, dataPtr + width, firstPtr );
+	std::copy( dataPtr + ( count - 1 ) * stride, dataPtr + ( count - 1 ) * stride + width, lastPtr );
+
+	// Causal pass, starting in the steady state of the first sample
+	for( size_t n = 0; n < count; ++n )
+	{
+		double* rowPtr = dataPtr + n * stride;
+		const double* p1 = ( n >= 1 ) ? rowPtr - stride : firstPtr;
+		const double* p2 = ( n >= 2 ) ? rowPtr - 2 * stride : firstPtr;
+		const double* p3 = ( n >= 3 ) ? rowPtr - 3 * stride : firstPtr;
+		for( size_t j = 0; j < width; ++j )
+			rowPtr[j] = dGain * rowPtr[j] + dFeedbackArr[0] * p1[j] + dFeedbackArr[1] * p2[j]
+				+ dFeedbackArr[2] * p3[j];
+	}
+
+	// Anticausal state behind the line from the deviations of the last causal outputs
+	const double* causalPtrArr[3];
+	for( unsigned short i = 0; i < 3; ++i )
+		causalPtrArr[i] = ( count > i ) ? dataPtr + ( count - 1 - i ) * stride : firstPtr;
+	for( unsigned short m = 0; m < 3; ++m )
+		for( size_t j = 0; j < width; ++j )
+			tailPtrArr[m][j] = lastPtr[j] + dBoundaryArr[m][0] * ( causalPtrArr[0][j] - lastPtr[j] )
+				+ dBoundaryArr[m][1] * ( causalPtrArr[1][j] - lastPtr[j] )
+				+ dBoundaryArr[m][2] * ( causalPtrArr[2][j] - lastPtr[j] );
+
+	// Anticausal pass
+	for( size_t n = count; n-- > 0; )
+	{
+		double* rowPtr = dataPtr + n * stride;
+		const double* p1 = ( n + 1 < count ) ? rowPtr + stride : tailPtrArr[n + 1 - count];
+		const double* p2 = ( n + 2 < count ) ? rowPtr + 2 * stride : tailPtrArr[n + 2 - count];
+		const double* p3 = ( n + 3 < count ) ? rowPtr + 3 * stride : tailPtrArr[n + 3 - count];
+		for( size_t j = 0; j < width; ++j )
+			rowPtr[j] = dGain * rowPtr[j] + dFeedbackArr[0] * p1[j] + dFeedbackArr[1] * p2[j]
+				+ dFeedbackArr[2] * p3[j];
+	}
+}
+
+/**
+ * \param dataPtr data set, smoothed in place
+ * \param extentArr extents of the three dimensions
+ * \param usAxis axis to smooth along (0..2)
+ */
+void CRecursiveGaussian::smoothAxis( double* dataPtr, const size_t* extentArr,
+	const unsigned short usAxis ) const throw()
+{
+	SAxisSmoothing theSmoothing;
+	theSmoothing.filterPtr = this;
+	theSmoothing.dataPtr = dataPtr;
+	for( unsigned short i = 0; i < 3; ++i )
+		theSmoothing.extentArr[i] = extentArr[i];
+	theSmoothing.usAxis = usAxis;
+	parallelFor( theSmoothing, &SAxisSmoothing::range, theSmoothing.itemCount() );
+}
+
+/**
+ * Axes with an extent of 1 are skipped.
+ * \param dataPtr data set, smoothed in place
+ * \param extentArr extents of the three dimensions
+ */
+void CRecursiveGaussian::smooth( double* dataPtr, const size_t* extentArr ) const throw()
+{
+	for( unsigned short usAxis = 0; usAxis < 3; ++usAxis )
+		if ( extentArr[usAxis] > 1 )
+			smoothAxis( dataPtr, extentArr, usAxis );
+}
+
+/**
+ * Computes ( u[n+1] - u[n-1] ) / 2, border samples are repeated. Applied to
+ * smoothed data this gives the gaussian derivative.
+ * \param inputPtr data set
+ * \param outputPtr array for the differences, must not overlap the input
+ * \param extentArr extents of the three dimensions
+ * \param usAxis axis to differentiate along (0..2)
+ */
+void CRecursiveGaussian::differentiateAxis( const double* inputPtr, double* outputPtr,
+	const size_t* extentArr, const unsigned short usAxis ) throw()
+{
+	SAxisDifferences theDifferences;
+	theDifferences.inputPtr = inputPtr;
+	theDifferences.outputPtr = outputPtr;
+	for( unsigned short i = 0; i < 3; ++i )
+		theDifferences.extentArr[i] = extentArr[i];
+	theDifferences.usAxis = usAxis;
+	parallelFor( theDifferences, &SAxisDifferences::range, theDifferences.itemCount() );
+}
+
+const std::string CRecursiveGaussian::dump() const throw()
+{
+	std::ostringstream os;
+	os << "dSigma " << dSigma << " dGain " << dGain << " dFeedbackArr " << dFeedbackArr[0] << " "
+		<< dFeedbackArr[1] << " " << dFeedbackArr[2] << "\n";
+	return CBase::dump() + os.str();
+}
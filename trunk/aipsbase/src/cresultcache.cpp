@@ -0,0 +1,564 @@
+/************************************************************************
+ * File: cresultcache.cpp                                               *
+ * Project: AIPS                                                        *
+ * Description: A memoisation cache for the results of pipeline items   *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#include "cresultcache.h"
+
+// Standard includes
+#include <cstdio> // std::rename, std::remove
+#include <cstdlib> // std::getenv
+#include <cstring> // std::memcpy
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <typeinfo>
+
+// Boost includes
+#include <boost/cstdint.hpp>
+
+// AIPS includes
+#include "aipstypelist.h"
+
+using namespace std;
+using namespace aips;
+
+namespace
+{
+
+/// Magic string at the beginning of each disk cache file
+const char RESULTFILE_MAGIC[] = "AIPSRESULT1\n";
+
+/// Multiplier of the hash function (64 bit golden ratio)
+const boost::uint64_t HASH_MULTIPLIER =
+	( static_cast<boost::uint64_t>( 0x9E3779B9 ) << 32 ) | 0x7F4A7C15;
+
+/// Mixes one 64 bit word into a hash value
+inline boost::uint64_t hashMix( boost::uint64_t hashValue, const boost::uint64_t theWord )
+{
+	hashValue ^= theWord;
+	hashValue *= HASH_MULTIPLIER;
+	return hashValue ^ ( hashValue >> 32 );
+}
+
+/**
+ * Hashes a memory block. Four independent lanes are used, so the multiplications
+ * of consecutive words do not wait for each other.
+ */
+boost::uint64_t hashBytes( boost::uint64_t hashValue, const void* blockPtr, const size_t blockSize )
+{
+	const char* bytePtr = static_cast<const char*>( blockPtr );
+	boost::uint64_t laneArr[4] = { hashValue, hashValue + 1, hashValue + 2, hashValue + 3 };
+	size_t i = 0;
+	for( ; i + 32 <= blockSize; i += 32 )
+	{
+		boost::uint64_t wordArr[4];
+		memcpy( wordArr, bytePtr + i, 32 );
+		laneArr[0] = hashMix( laneArr[0], wordArr[0] );
+		laneArr[1] = hashMix( laneArr[1], wordArr[1] );
+		laneArr[2] = hashMix( laneArr[2], wordArr[2] );
+		laneArr[3] = hashMix( laneArr[3], wordArr[3] );
+	}
+	boost::uint64_t tailWord = 0;
+	memcpy( &tailWord, bytePtr + i, blockSize - i > 8 ? 8 : blockSize - i );
+	for( size_t j = i + 8; j < blockSize; j += 8 )
+	{
+		laneArr[0] = hashMix( laneArr[0], tailWord );
+		tailWord = 0;
+		memcpy( &tailWord, bytePtr + j, blockSize - j > 8 ? 8 : blockSize - j );
+	}
+	hashValue = hashMix( laneArr[0], tailWord );
+	hashValue = hashMix( hashValue, laneArr[1] );
+	hashValue = hashMix( hashValue, laneArr[2] );
+	hashValue = hashMix( hashValue, laneArr[3] );
+	return hashMix( hashValue, blockSize );
+}
+
+template<typename T> inline void writeRaw( ostream& os, const T& theValue )
+{
+	os.write( reinterpret_cast<const char*>( &theValue ), sizeof( T ) );
+}
+
+template<typename T> inline void readRaw( istream& is, T& theValue )
+{
+	is.read( reinterpret_cast<char*>( &theValue ), sizeof( T ) );
+}
+
+/// Reads the data range of a dataset
+template<typename TValue> inline void readRange( istream& is, CTypedData<TValue>& aDataSet )
+{
+	CDataRange<TValue, SDataTraits<TValue>::isScalar> theRange = aDataSet.getDataRange();
+	readRaw( is, theRange );
+	aDataSet.setDataRange( theRange );
+}
+
+/// Dataset types which can be hashed and written to disk
+typedef TypeList<TImage, TypeList<TSmallImage, TypeList<TField, TypeList<TField2D,
+	TypeList<TField3D, TypeList<TComplexImage, NullType> > > > > > cacheableTL;
+
+/**
+ * Dispatches the typed operations of the cache to the types of cacheableTL.
+ * Types are identified by their position in the list.
+ */
+template<typename TList> struct SCacheable;
+
+template<> struct SCacheable<NullType>
+{
+	static int indexOf( const CDataSet&, const int )
+	{
+		return -1;
+	}
+	static const void* data( const CDataSet&, const int, size_t& )
+	{
+		return NULL;
+	}
+	static void writeRange( ostream&, const CDataSet&, const int )
+	{
+	}
+	static CDataSet* read( istream&, const int, const unsigned short, const vector<size_t>&,
+		const size_t )
+	{
+		return NULL;
+	}
+};
+
+template<typename Head, typename Tail> struct SCacheable< TypeList<Head, Tail> >
+{
+	static int indexOf( const CDataSet& aDataSet, const int iIndex = 0 )
+	{
+		if ( typeid( aDataSet ) == typeid( Head ) )
+			return iIndex;
+		return SCacheable<Tail>::indexOf( aDataSet, iIndex + 1 );
+	}
+	/// Returns the data array (without detaching shared data) and its size in bytes
+	static const void* data( const CDataSet& aDataSet, const int iIndex, size_t& dataSize )
+	{
+		if ( iIndex != 0 )
+			return SCacheable<Tail>::data( aDataSet, iIndex - 1, dataSize );
+		const Head& theData = static_cast<const Head&>( aDataSet );
+		dataSize = theData.getDataSize();
+		if ( dataSize == 0 )
+			return NULL;
+		return &theData[0];
+	}
+	static void writeRange( ostream& os, const CDataSet& aDataSet, const int iIndex )
+	{
+		if ( iIndex != 0 )
+			SCacheable<Tail>::writeRange( os, aDataSet, iIndex - 1 );
+		else
+			writeRaw( os, static_cast<const Head&>( aDataSet ).getDataRange() );
+	}
+	/// Creates a dataset of the given type and reads its data range and contents
+	static CDataSet* read( istream& is, const int iIndex, const unsigned short usDimension,
+		const vector<size_t>& extentVec, const size_t dataDimension )
+	{
+		if ( iIndex != 0 )
+			return SCacheable<Tail>::read( is, iIndex - 1, usDimension, extentVec, dataDimension );
+		Head* dataPtr = new Head( usDimension, extentVec, dataDimension, Head::DataInitNone );
+		readRange( is, *dataPtr );
+		if ( dataPtr->getDataSize() > 0 )
+			is.read( reinterpret_cast<char*>( &( *dataPtr )[0] ), dataPtr->getDataSize() );
+		return dataPtr;
+	}
+};
+
+}
+
+/*************
+ * Structors *
+ *************/
+
+/**
+ * By default, up to 256 MB of results are kept in memory. The disk cache is
+ * disabled unless the environment variable AIPS_RESULT_CACHE names a directory.
+ */
+CResultCache::CResultCache() throw()
+	: CBase( "CResultCache", CRESULTCACHE_VERSION, "CBase" ), cachedBytes( 0 ),
+	maxCachedBytes( static_cast<size_t>( 1 ) << 28 ), bEnabled( true )
+{
+	const char* sDirectory = getenv( "AIPS_RESULT_CACHE" );
+	if ( sDirectory != NULL )
+		sDiskCacheDirectory = sDirectory;
+}
+
+CResultCache::~CResultCache() throw()
+{
+}
+
+/*************
+ * Accessors *
+ *************/
+
+/** \returns true if results are stored and looked up */
+bool CResultCache::isEnabled() const throw()
+{
+	boost::mutex::scoped_lock lock( cacheMutex );
+	return bEnabled;
+}
+
+/** \returns the number of bytes held by the memory cache */
+size_t CResultCache::getCachedBytes() const throw()
+{
+	boost::mutex::scoped_lock lock( cacheMutex );
+	return cachedBytes;
+}
+
+/** \returns the maximum number of bytes held by the memory cache */
+size_t CResultCache::getMaximumCachedBytes() const throw()
+{
+	boost::mutex::scoped_lock lock( cacheMutex );
+	return maxCachedBytes;
+}
+
+/** \returns the directory of the disk cache, an empty string if it is disabled */
+const std::string CResultCache::getDiskCacheDirectory() const throw()
+{
+	boost::mutex::scoped_lock lock( cacheMutex );
+	return sDiskCacheDirectory;
+}
+
+/************
+ * Mutators *
+ ************/
+
+/**
+ * Disabling the cache also drops all results held in memory.
+ * \param bEnabled_ true if results should be stored and looked up
+ */
+void CResultCache::setEnabled( const bool bEnabled_ ) throw()
+{
+	if ( !bEnabled_ )
+		clear();
+	boost::mutex::scoped_lock lock( cacheMutex );
+	bEnabled = bEnabled_;
+}
+
+/**
+ * Entries are evicted with the next call of store().
+ * \param maxCachedBytes_ new maximum number of bytes held by the memory cache
+ */
+void CResultCache::setMaximumCachedBytes( const size_t maxCachedBytes_ ) throw()
+{
+	boost::mutex::scoped_lock lock( cacheMutex );
+	maxCachedBytes = maxCachedBytes_;
+}
+
+/**
+ * The directory must exist and be writable.
+ * \param sDiskCacheDirectory_ directory of the disk cache. An empty string disables it
+ */
+void CResultCache::setDiskCacheDirectory( const std::string& sDiskCacheDirectory_ ) throw()
+{
+	boost::mutex::scoped_lock lock( cacheMutex );
+	sDiskCacheDirectory = sDiskCacheDirectory_;
+}
+
+/*****************
+ * Other methods *
+ *****************/
+
+/**
+ * The memory cache is searched first, then the disk cache.
+ * \param sKey key of the results
+ * \param resultVec receives the cached results. They must not be modified
+ * \returns true if the results were found
+ */
+bool CResultCache::lookup( const std::string& sKey, TResultVec& resultVec ) throw()
+{
+	std::string sFileName;
+	{
+		boost::mutex::scoped_lock lock( cacheMutex );
+		if ( !bEnabled )
+			return false;
+		TEntryMap::iterator it = entryMap.find( sKey );
+		if ( it != entryMap.end() )
+		{
+			lruList.splice( lruList.begin(), lruList, it->second.lruIt );
+			resultVec = it->second.resultVec;
+			return true;
+		}
+		if ( sDiskCacheDirectory.empty() || sKey.find( '@' ) == 0 )
+			return false;
+		sFileName = fileName( sKey );
+	}
+	TResultVec fileVec;
+	if ( !readFile( sFileName, fileVec ) )
+		return false;
+	insert( sKey, fileVec );
+	resultVec = fileVec;
+	return true;
+}
+
+/**
+ * The cache keeps the given datasets. They must not be modified afterwards,
+ * so store clones of datasets which are still in use.
+ * \param sKey key of the results
+ * \param resultVec results to store. Null pointers are allowed
+ */
+void CResultCache::store( const std::string& sKey, const TResultVec& resultVec ) throw()
+{
+	std::string sFileName;
+	{
+		boost::mutex::scoped_lock lock( cacheMutex );
+		if ( !bEnabled )
+			return;
+		if ( !sDiskCacheDirectory.empty() && sKey.find( '@' ) != 0 )
+			sFileName = fileName( sKey );
+	}
+	insert( sKey, resultVec );
+	if ( !sFileName.empty() )
+		writeFile( sFileName, resultVec );
+}
+
+void CResultCache::clear() throw()
+{
+	boost::mutex::scoped_lock lock( cacheMutex );
+	entryMap.clear();
+	lruList.clear();
+	cachedBytes = 0;
+}
+
+const std::string CResultCache::dump() const throw()
+{
+	boost::mutex::scoped_lock lock( cacheMutex );
+	std::ostringstream os;
+	os << "bEnabled " << bEnabled << " cachedBytes " << cachedBytes << " maxCachedBytes "
+		<< maxCachedBytes << " sDiskCacheDirectory \"" << sDiskCacheDirectory << "\"\n";
+	for( std::list<std::string>::const_iterator it = lruList.begin(); it != lruList.end(); ++it )
+		os << "- " << *it << " : " << entryMap.find( *it )->second.entryBytes << " bytes\n";
+	return CBase::dump() + os.str();
+}
+
+/**
+ * \param sValue string to hash
+ * \returns 16 digit hexadecimal hash value
+ */
+std::string CResultCache::hashString( const std::string& sValue ) throw()
+{
+	std::ostringstream os;
+	os << hex << setw( 16 ) << setfill( '0' ) << hashBytes( 0, sValue.data(), sValue.size() );
+	return os.str();
+}
+
+/**
+ * The hash covers the dataset type, the extents, the base element dimensions, the
+ * origin and the contents. Shared data is not detached.
+ * \param aDataSet dataset to hash
+ * \returns 16 digit hexadecimal hash value, an empty string if the type is not supported
+ */
+std::string CResultCache::hashDataSet( const CDataSet& aDataSet ) throw()
+{
+	int iIndex = SCacheable<cacheableTL>::indexOf( aDataSet );
+	if ( iIndex < 0 )
+		return "";
+	std::vector<boost::uint64_t> headerVec;
+	headerVec.push_back( iIndex );
+	headerVec.push_back( aDataSet.getDimension() );
+	headerVec.push_back( aDataSet.getDataDimension() );
+	std::vector<double> baseElementVec = aDataSet.getBaseElementDimensions();
+	std::vector<double> originVec = aDataSet.getOrigin();
+	for( unsigned short i = 0; i < aDataSet.getDimension(); ++i )
+	{
+		boost::uint64_t theWord;
+		headerVec.push_back( aDataSet.getExtent( i ) );
+		memcpy( &theWord, &baseElementVec[i], sizeof( double ) );
+		headerVec.push_back( theWord );
+		memcpy( &theWord, &originVec[i], sizeof( double ) );
+		headerVec.push_back( theWord );
+	}
+	size_t dataSize = 0;
+	const void* dataPtr = SCacheable<cacheableTL>::data( aDataSet, iIndex, dataSize );
+	boost::uint64_t hashValue = hashBytes( 0, &headerVec[0], headerVec.size() * sizeof( boost::uint64_t ) );
+	if ( dataPtr != NULL )
+		hashValue = hashBytes( hashValue, dataPtr, dataSize );
+	std::ostringstream os;
+	os << hex << setw( 16 ) << setfill( '0' ) << hashValue;
+	return os.str();
+}
+
+/*******************
+ * Private methods *
+ *******************/
+
+/**
+ * Results larger than the whole cache are not kept in memory.
+ * \param sKey key of the results
+ * \param resultVec results to store
+ */
+void CResultCache::insert( const std::string& sKey, const TResultVec& resultVec ) throw()
+{
+	size_t entryBytes = 0;
+	for( TResultVec::const_iterator it = resultVec.begin(); it != resultVec.end(); ++it )
+		if ( *it )
+			entryBytes += ( *it )->getDataSize();
+	boost::mutex::scoped_lock lock( cacheMutex );
+	TEntryMap::iterator it = entryMap.find( sKey );
+	if ( it != entryMap.end() )
+	{
+		cachedBytes -= it->second.entryBytes;
+		lruList.erase( it->second.lruIt );
+		entryMap.erase( it );
+	}
+	if ( entryBytes > maxCachedBytes )
+		return;
+	while( cachedBytes + entryBytes > maxCachedBytes && !lruList.empty() )
+	{
+		TEntryMap::iterator oldIt = entryMap.find( lruList.back() );
+		cachedBytes -= oldIt->second.entryBytes;
+		entryMap.erase( oldIt );
+		lruList.pop_back();
+	}
+	lruList.push_front( sKey );
+	SEntry& theEntry = entryMap[sKey];
+	theEntry.resultVec = resultVec;
+	theEntry.entryBytes = entryBytes;
+	theEntry.lruIt = lruList.begin();
+	cachedBytes += entryBytes;
+}
+
+/**
+ * \param sKey key of the results
+ * \returns path of the disk cache file
+ */
+const std::string CResultCache::fileName( const std::string& sKey ) const throw()
+{
+	return sDiskCacheDirectory + "/" + sKey + ".result";
+}
+
+/**
+ * The file is written under a temporary name and renamed afterwards, so
+ * concurrent readers never see incomplete files. Results containing datasets
+ * of unsupported types are not written.
+ * \param sFileName name of the file
+ * \param resultVec results to write
+ * \returns true if the file was written
+ */
+bool CResultCache::writeFile( const std::string& sFileName, const TResultVec& resultVec ) throw()
+{
+	for( TResultVec::const_iterator it = resultVec.begin(); it != resultVec.end(); ++it )
+		if ( *it && SCacheable<cacheableTL>::indexOf( **it ) < 0 )
+			return false;
+	std::ostringstream tmpName;
+	tmpName << sFileName << ".tmp" << reinterpret_cast<size_t>( &resultVec );
+	std::ofstream theFile( tmpName.str().c_str(), ios::out | ios::binary | ios::trunc );
+	if ( !theFile.is_open() )
+	{
+		alog << LWARN << "Could not write result cache file " << tmpName.str() << endl;
+		return false;
+	}
+	theFile.write( RESULTFILE_MAGIC, sizeof( RESULTFILE_MAGIC ) - 1 );
+	writeRaw( theFile, static_cast<boost::uint32_t>( resultVec.size() ) );
+	for( TResultVec::const_iterator it = resultVec.begin(); it != resultVec.end(); ++it )
+	{
+		if ( !*it )
+		{
+			writeRaw( theFile, static_cast<boost::int32_t>( -1 ) );
+			continue;
+		}
+		const CDataSet& aDataSet = **it;
+		int iIndex = SCacheable<cacheableTL>::indexOf( aDataSet );
+		writeRaw( theFile, static_cast<boost::int32_t>( iIndex ) );
+		writeRaw( theFile, static_cast<boost::uint16_t>( aDataSet.getDimension() ) );
+		writeRaw( theFile, static_cast<boost::uint64_t>( aDataSet.getDataDimension() ) );
+		std::vector<double> baseElementVec = aDataSet.getBaseElementDimensions();
+		std::vector<double> originVec = aDataSet.getOrigin();
+		for( unsigned short i = 0; i < aDataSet.getDimension(); ++i )
+		{
+			writeRaw( theFile, static_cast<boost::uint64_t>( aDataSet.getExtent( i ) ) );
+			writeRaw( theFile, baseElementVec[i] );
+			writeRaw( theFile, originVec[i] );
+		}
+		SCacheable<cacheableTL>::writeRange( theFile, aDataSet, iIndex );
+		size_t dataSize = 0;
+		const void* dataPtr = SCacheable<cacheableTL>::data( aDataSet, iIndex, dataSize );
+		if ( dataPtr != NULL )
+			theFile.write( static_cast<const char*>( dataPtr ), dataSize );
+	}
+	theFile.close();
+	if ( theFile.fail() || std::rename( tmpName.str().c_str(), sFileName.c_str() ) != 0 )
+	{
+		alog << LWARN << "Could not write result cache file " << sFileName << endl;
+		std::remove( tmpName.str().c_str() );
+		return false;
+	}
+	return true;
+}
+
+/**
+ * \param sFileName name of the file
+ * \param resultVec receives the results
+ * \returns true if the file exists and could be read
+ */
+bool CResultCache::readFile( const std::string& sFileName, TResultVec& resultVec ) throw()
+{
+	std::ifstream theFile( sFileName.c_str(), ios::in | ios::binary );
+	if ( !theFile.is_open() )
+		return false;
+	char magicArr[sizeof( RESULTFILE_MAGIC ) - 1];
+	theFile.read( magicArr, sizeof( magicArr ) );
+	if ( !theFile || memcmp( magicArr, RESULTFILE_MAGIC, sizeof( magicArr ) ) != 0 )
+		return false;
+	boost::uint32_t uiNoOfResults = 0;
+	readRaw( theFile, uiNoOfResults );
+	resultVec.clear();
+	for( boost::uint32_t r = 0; r < uiNoOfResults && theFile; ++r )
+	{
+		boost::int32_t iIndex;
+		readRaw( theFile, iIndex );
+		if ( iIndex < 0 )
+		{
+			resultVec.push_back( TDataSetPtr() );
+			continue;
+		}
+		boost::uint16_t usDimension = 0;
+		boost::uint64_t dataDimension = 0;
+		readRaw( theFile, usDimension );
+		readRaw( theFile, dataDimension );
+		if ( !theFile || usDimension == 0 || iIndex >= static_cast<boost::int32_t>( Length<cacheableTL>::value ) )
+			return false;
+		std::vector<size_t> extentVec( usDimension );
+		std::vector<double> baseElementVec( usDimension );
+		std::vector<double> originVec( usDimension );
+		for( unsigned short i = 0; i < usDimension; ++i )
+		{
+			boost::uint64_t theExtent;
+			readRaw( theFile, theExtent );
+			extentVec[i] = theExtent;
+			readRaw( theFile, baseElementVec[i] );
+			readRaw( theFile, originVec[i] );
+		}
+		if ( !theFile )
+			return false;
+		TDataSetPtr dataPtr( SCacheable<cacheableTL>::read( theFile, iIndex, usDimension, extentVec,
+			dataDimension ) );
+		dataPtr->setBaseElementDimensions( baseElementVec );
+		dataPtr->setOrigin( originVec );
+		resultVec.push_back( dataPtr );
+	}
+	return theFile && resultVec.size() == uiNoOfResults;
+}
+
+/***************************
+ * Global cache instance *
+ ***************************/
+
+namespace aips {
+
+/** \returns the global result cache */
+CResultCache& getResultCache() throw()
+{
+	static CResultCache theResultCache;
+	return theResultCache;
+}
+
+}
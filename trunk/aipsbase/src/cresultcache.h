@@ -0,0 +1,159 @@
+/************************************************************************
+ * File: cresultcache.h                                                 *
+ * Project: AIPS                                                        *
+ * Description: A memoisation cache for the results of pipeline items   *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Version: 0.1                                                         *
+ * Status : Beta                                                        *
+ * Created: 2026-10-17                                                  *
+ * Changed:                                                             *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#ifndef CRESULTCACHE_H
+#define CRESULTCACHE_H
+
+#define CRESULTCACHE_VERSION "0.1"
+
+// Standard includes
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+// Boost includes
+#include <boost/thread/mutex.hpp>
+
+// AIPS includes
+#include "cbase.h"
+#include "aipsnumeric.h" // TDataSetPtr
+
+namespace aips {
+
+/**
+ * \brief Keeps the outputs of recently executed pipeline items.
+ *
+ * Results are stored under a key which is built by CPipelineItem from the
+ * module class, the module ID, all parameter values and the keys (or
+ * generation stamps) of the inputs. If a parameter is toggled back to an
+ * earlier value, the module's outputs are taken from the cache instead
+ * of calling apply() again.
+ *
+ * The cache holds the datasets it is given, so they must not be modified
+ * after they were stored or looked up. CPipelineItem therefore stores and
+ * hands out copy-on-write clones (see CDataSet::clone()) of the outputs of
+ * memoised modules (see CPipelineItem::memoiseResults()). Entries are dropped in least
+ * recently used order if the cache grows above getMaximumCachedBytes().
+ * If a disk cache directory is set, every stored result is also written
+ * to a file in this directory. Lookups that miss the memory cache then
+ * try to read the file, so results survive the eviction and even the end
+ * of the program. Files in the directory are never deleted by the cache.
+ * Keys starting with '@' depend on the state of the running program and
+ * are only kept in memory. Only the dataset types TImage, TSmallImage,
+ * TField, TField2D, TField3D and TComplexImage can be hashed and written
+ * to disk.
+ *
+ * The cache is thread safe. Use getResultCache() to retrieve the global
+ * instance.
+ */
+class CResultCache : public CBase
+{
+private:
+	/// Copy constructor
+	CResultCache( const CResultCache& );
+	/// Assignment operator
+	CResultCache& operator=( const CResultCache& );
+public:
+	typedef std::vector<TDataSetPtr> TResultVec;
+/* Structors */
+	/// Constructor
+	CResultCache()
+		throw();
+	/// Destructor
+	virtual ~CResultCache()
+		throw();
+/* Accessors */
+	/// Returns true if results are stored and looked up at all
+	bool isEnabled() const
+		throw();
+	/// Returns the number of bytes held by the memory cache
+	size_t getCachedBytes() const
+		throw();
+	/// Returns the maximum number of bytes held by the memory cache
+	size_t getMaximumCachedBytes() const
+		throw();
+	/// Returns the directory of the disk cache
+	const std::string getDiskCacheDirectory() const
+		throw();
+/* Mutators */
+	/// Enables or disables the cache
+	void setEnabled( const bool bEnabled_ )
+		throw();
+	/// Sets the maximum number of bytes held by the memory cache
+	void setMaximumCachedBytes( const size_t maxCachedBytes_ )
+		throw();
+	/// Sets the directory of the disk cache (empty string disables it)
+	void setDiskCacheDirectory( const std::string& sDiskCacheDirectory_ )
+		throw();
+/* Other methods */
+	/// Looks up the results stored under the given key
+	bool lookup( const std::string& sKey, TResultVec& resultVec )
+		throw();
+	/// Stores results under the given key
+	void store( const std::string& sKey, const TResultVec& resultVec )
+		throw();
+	/// Drops all results from the memory cache
+	void clear()
+		throw();
+	/// Reimplemented from CBase
+	virtual const std::string dump() const
+		throw();
+	/// Returns a hash of the given string as hexadecimal number
+	static std::string hashString( const std::string& sValue )
+		throw();
+	/// Returns a hash of type, geometry and contents of a dataset
+	static std::string hashDataSet( const CDataSet& aDataSet )
+		throw();
+private:
+	/// Memory cache entry
+	struct SEntry
+	{
+		TResultVec resultVec; ///< Cached datasets
+		size_t entryBytes;    ///< Memory occupied by the datasets
+		std::list<std::string>::iterator lruIt; ///< Position in lruList
+	};
+	typedef std::map<std::string, SEntry> TEntryMap;
+	/// Puts results into the memory cache and evicts old entries
+	void insert( const std::string& sKey, const TResultVec& resultVec )
+		throw();
+	/// Returns the name of the disk cache file of a key
+	const std::string fileName( const std::string& sKey ) const
+		throw();
+	/// Writes results to the disk cache
+	static bool writeFile( const std::string& sFileName, const TResultVec& resultVec )
+		throw();
+	/// Reads results from the disk cache
+	static bool readFile( const std::string& sFileName, TResultVec& resultVec )
+		throw();
+	TEntryMap entryMap;                ///< Cached results by key
+	std::list<std::string> lruList;    ///< Keys, most recently used first
+	size_t cachedBytes;                ///< Memory occupied by all entries
+	size_t maxCachedBytes;             ///< Upper bound for cachedBytes
+	std::string sDiskCacheDirectory;   ///< Directory of the disk cache
+	bool bEnabled;                     ///< Are results stored and looked up?
+	mutable boost::mutex cacheMutex;   ///< Guards all members above
+};
+
+/// Returns the global result cache
+CResultCache& getResultCache()
+	throw();
+
+}
+
+#endif
@@ -0,0 +1,125 @@
+/************************************************************************
+ * File: cscanlinefill.h                                                *
+ * Project: AIPS                                                        *
+ * Description: Span based region growing from many seeds               *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Version: 0.1                                                         *
+ * Status : Beta                                                        *
+ * Created: 2026-10-17                                                  *
+ * Changed:                                                             *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#ifndef CSCANLINEFILL_H
+#define CSCANLINEFILL_H
+
+#define CSCANLINEFILL_VERSION "0.1"
+
+// Standard includes
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Boost includes
+#include <boost/scoped_array.hpp>
+#include <boost/thread/mutex.hpp>
+
+// AIPS includes
+#include "aipsparallel.h"
+#include "cbase.h"
+#include "cbitmask.h"
+
+namespace aips {
+
+/**
+ * \brief Region growing with scanline spans.
+ *
+ * Two 6-neighbours belong to the same region if their values differ by at
+ * most the threshold. Instead of single voxels, the fill handles spans:
+ * maximal runs along x that are filled at once. Only the span ends are
+ * stored, and the neighbouring rows above, below, in front and behind a
+ * span are scanned for the seeds of new spans.
+ *
+ * Many seeds are grown at the same time, distributed over
+ * CPipelineItem::getNumberOfThreads() threads. All of them share one
+ * CBitMask of visited voxels. A row of the mask is only read and written
+ * while one of a few row locks is held, so every voxel is claimed by
+ * exactly one thread; a single thread skips the locks. Since the criterion
+ * is symmetric, the union of the regions does not depend on the order in
+ * which the spans are processed.
+ *
+ * \param TValue scalar voxel type
+ */
+template<typename TValue>
+class CScanlineFill : public CBase
+{
+private:
+	/// Standard constructor
+	CScanlineFill();
+public:
+/* Structors */
+	/// Constructor
+	CScanlineFill( const TValue* dataPtr_, const std::vector<size_t>& extentVec,
+		const double dThreshold_ )
+		throw();
+	/// Destructor
+	virtual ~CScanlineFill()
+		throw();
+/* Other methods */
+	/// Grows the regions of all seeds into the mask
+	void fill( const std::vector<size_t>& seedVec, CBitMask& visited ) const
+		throw();
+	/// Reimplemented from CBase
+	virtual const std::string dump() const
+		throw();
+private:
+	/// A run of filled voxels along x
+	struct SSpan
+	{
+		size_t x0; ///< First voxel
+		size_t x1; ///< Last voxel
+		size_t y;
+		size_t z;
+	};
+	/// Growing of a range of seeds, shared by all workers
+	struct SSeedWorker
+	{
+		const CScanlineFill* fillPtr;
+		const std::vector<size_t>* seedVecPtr;
+		CBitMask* visitedPtr;
+		boost::mutex* lockArr;
+		bool bConcurrent;
+		void range( const size_t first, const size_t last ) const;
+	};
+	/// Returns true if two neighbouring values belong to the same region
+	bool accepts( const TValue a, const TValue b ) const
+		throw();
+	/// Returns the first value of a row
+	const TValue* getRow( const size_t y, const size_t z ) const
+		throw();
+	/// Fills the span through an unvisited voxel
+	SSpan fillSpan( const size_t x, const size_t y, const size_t z, CBitMask& visited ) const
+		throw();
+	/// Starts new spans in a neighbouring row of a span
+	void scanRow( const SSpan& aSpan, const size_t y, const size_t z, CBitMask& visited,
+		std::vector<SSpan>& spanVec ) const
+		throw();
+	/// Number of row locks
+	static const size_t lockCount = 64;
+	const TValue* dataPtr;  ///< Voxel values, x running fastest
+	size_t extentArr[3];    ///< Extents, 1 for missing dimensions
+	double dThreshold;      ///< Largest difference of neighbours within a region
+};
+
+#include "cscanlinefill.tpp"
+
+}
+
+#endif
@@ -0,0 +1,198 @@
+/************************************************************************
+ * File: cscanlinefill.tpp                                              *
+ * Project: AIPS                                                        *
+ * Description: Span based region growing from many seeds               *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+/*************
+ * Structors *
+ *************/
+
+/**
+ * \param dataPtr_ voxel values with x running fastest. The array must outlive the fill
+ * \param extentVec extents of the data. Missing dimensions are set to 1
+ * \param dThreshold_ largest difference of two neighbours within a region
+ */
+template<typename TValue>
+CScanlineFill<TValue>::CScanlineFill( const TValue* dataPtr_, const std::vector<size_t>& extentVec,
+	const double dThreshold_ ) throw()
+	: CBase( "CScanlineFill", CSCANLINEFILL_VERSION, "CBase" ), dataPtr( dataPtr_ ),
+	dThreshold( dThreshold_ )
+{
+	for( unsigned short i = 0; i < 3; ++i )
+		extentArr[i] = ( i < extentVec.size() ) ? extentVec[i] : 1;
+}
+
+template<typename TValue>
+CScanlineFill<TValue>::~CScanlineFill() throw()
+{
+}
+
+/*****************
+ * Other methods *
+ *****************/
+
+/**
+ * Seeds which are already set in the mask are skipped, so the mask may
+ * also be used to block voxels from growing.
+ * \param seedVec linear indices of the seed voxels
+ * \param visited mask of the data extents. Receives the grown regions
+ */
+template<typename TValue>
+void CScanlineFill<TValue>::fill( const std::vector<size_t>& seedVec, CBitMask& visited ) const throw()
+{
+	if ( seedVec.empty() )
+		return;
+	boost::scoped_array<boost::mutex> lockArr( new boost::mutex[lockCount] );
+	SSeedWorker theWorker;
+	theWorker.fillPtr = this;
+	theWorker.seedVecPtr = &seedVec;
+	theWorker.visitedPtr = &visited;
+	theWorker.lockArr = lockArr.get();
+	// A single worker does not need the row locks
+	theWorker.bConcurrent = std::min<size_t>( CPipelineItem::getNumberOfThreads(), seedVec.size() ) > 1;
+	parallelFor( theWorker, &SSeedWorker::range, seedVec.size() );
+}
+
+template<typename TValue>
+const std::string CScanlineFill<TValue>::dump() const throw()
+{
+	std::ostringstream os;
+	os << "extentArr " << extentArr[0] << " " << extentArr[1] << " " << extentArr[2]
+		<< "\ndThreshold " << dThreshold << "\n";
+	return CBase::dump() + os.str();
+}
+
+/*******************
+ * Private methods *
+ *******************/
+
+template<typename TValue>
+inline bool CScanlineFill<TValue>::accepts( const TValue a, const TValue b ) const throw()
+{
+	return std::fabs( static_cast<double>( a ) - static_cast<double>( b ) ) <= dThreshold;
+}
+
+template<typename TValue>
+inline const TValue* CScanlineFill<TValue>::getRow( const size_t y, const size_t z ) const throw()
+{
+	return dataPtr + ( z * extentArr[1] + y ) * extentArr[0];
+}
+
+/**
+ * The caller must hold the lock of the row.
+ * \param x unvisited voxel of the span
+ * \param y row of the span
+ * \param z slice of the span
+ * \param visited mask of visited voxels
+ * \returns the new span
+ */
+template<typename TValue>
+typename CScanlineFill<TValue>::SSpan CScanlineFill<TValue>::fillSpan( const size_t x, const size_t y,
+	const size_t z, CBitMask& visited ) const throw()
+{
+	const size_t bitsPerWord = CBitMask::bitsPerWord;
+	const TValue* rowPtr = getRow( y, z );
+	CBitMask::TWord* bitPtr = visited.getRow( y, z );
+	SSpan aSpan;
+	aSpan.y = y;
+	aSpan.z = z;
+	aSpan.x0 = aSpan.x1 = x;
+	while( aSpan.x0 > 0 && !( ( bitPtr[( aSpan.x0 - 1 ) / bitsPerWord] >> ( ( aSpan.x0 - 1 ) % bitsPerWord ) ) & 1 )
+		&& accepts( rowPtr[aSpan.x0 - 1], rowPtr[aSpan.x0] ) )
+		--aSpan.x0;
+	while( aSpan.x1 + 1 < extentArr[0]
+		&& !( ( bitPtr[( aSpan.x1 + 1 ) / bitsPerWord] >> ( ( aSpan.x1 + 1 ) % bitsPerWord ) ) & 1 )
+		&& accepts( rowPtr[aSpan.x1 + 1], rowPtr[aSpan.x1] ) )
+		++aSpan.x1;
+	for( size_t i = aSpan.x0; i <= aSpan.x1; ++i )
+		bitPtr[i / bitsPerWord] |= CBitMask::TWord( 1 ) << ( i % bitsPerWord );
+	return aSpan;
+}
+
+/**
+ * Every unvisited voxel next to the span that is accepted starts a new span.
+ * The caller must hold the lock of the row.
+ * \param aSpan span whose neighbours are scanned
+ * \param y neighbouring row
+ * \param z slice of the neighbouring row
+ * \param visited mask of visited voxels
+ * \param spanVec stack receiving the new spans
+ */
+template<typename TValue>
+void CScanlineFill<TValue>::scanRow( const SSpan& aSpan, const size_t y, const size_t z,
+	CBitMask& visited, std::vector<SSpan>& spanVec ) const throw()
+{
+	const size_t bitsPerWord = CBitMask::bitsPerWord;
+	const TValue* fromPtr = getRow( aSpan.y, aSpan.z );
+	const TValue* toPtr = getRow( y, z );
+	const CBitMask::TWord* bitPtr = visited.getRow( y, z );
+	size_t x = aSpan.x0;
+	while( x <= aSpan.x1 )
+	{
+		// Skip words which are completely visited
+		if ( x % bitsPerWord == 0 && bitPtr[x / bitsPerWord] == ~CBitMask::TWord( 0 ) )
+		{
+			x += bitsPerWord;
+			continue;
+		}
+		if ( !( ( bitPtr[x / bitsPerWord] >> ( x % bitsPerWord ) ) & 1 ) && accepts( fromPtr[x], toPtr[x] ) )
+		{
+			spanVec.push_back( fillSpan( x, y, z, visited ) );
+			x = spanVec.back().x1 + 1;
+		}
+		else
+			++x;
+	}
+}
+
+template<typename TValue>
+void CScanlineFill<TValue>::SSeedWorker::range( const size_t first, const size_t last ) const
+{
+	const size_t* extentArr = fillPtr->extentArr;
+	CBitMask& visited = *visitedPtr;
+	std::vector<SSpan> spanVec;
+	for( size_t s = first; s < last; ++s )
+	{
+		const size_t index = ( *seedVecPtr )[s];
+		const size_t x = index % extentArr[0];
+		const size_t y = ( index / extentArr[0] ) % extentArr[1];
+		const size_t z = index / ( extentArr[0] * extentArr[1] );
+		{
+			boost::mutex::scoped_lock lock( lockArr[( z * extentArr[1] + y ) % lockCount], boost::defer_lock );
+			if ( bConcurrent )
+				lock.lock();
+			if ( visited.get( x, y, z ) )
+				continue;
+			spanVec.push_back( fillPtr->fillSpan( x, y, z, visited ) );
+		}
+		while( !spanVec.empty() )
+		{
+			const SSpan aSpan = spanVec.back();
+			spanVec.pop_back();
+			// Rows above and below, then the rows in the neighbouring slices
+			const size_t rowArr[4][2] = { { aSpan.y - 1, aSpan.z }, { aSpan.y + 1, aSpan.z },
+				{ aSpan.y, aSpan.z - 1 }, { aSpan.y, aSpan.z + 1 } };
+			for( unsigned short i = 0; i < 4; ++i )
+			{
+				// Unsigned wrap around makes rows before the first one invalid as well
+				if ( rowArr[i][0] >= extentArr[1] || rowArr[i][1] >= extentArr[2] )
+					continue;
+				boost::mutex::scoped_lock lock( lockArr[( rowArr[i][1] * extentArr[1] + rowArr[i][0] )
+					% lockCount], boost::defer_lock );
+				if ( bConcurrent )
+					lock.lock();
+				fillPtr->scanRow( aSpan, rowArr[i][0], rowArr[i][1], visited, spanVec );
+			}
+		}
+	}
+}
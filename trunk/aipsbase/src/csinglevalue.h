@@ -24,6 +24,8 @@
  *                      cdataset.h csinglevalue.h and ctypeddata.h      *
  *          2004-04-26 Added method swap()                              *
  *          2004-04-28 Updated documentation                            *
+ *          2026-10-17 Added method clone()                             *
+ *                     Added method getDataSize()                       *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -96,6 +98,12 @@ public:
 /* Other Methods */
   /// Produces an information string about the actual object.
   virtual const std::string dump() const
+    throw();
+  /// Reimplemented from CDataSet
+  virtual CDataSet* clone() const
+    throw();
+  /// Reimplemented from CDataSet
+  virtual size_t getDataSize() const
     throw();
 	/// Swaps the data with another data set of the same type
 	void swap( CSingleValue<valueType>& aDataSet ) 
@@ -155,6 +155,18 @@ template<typename valueType> const std::string CSingleValue<valueType>::dump() c
   return CDataSet::dump() + "valueVec size: " + boost::lexical_cast<std::string>( valueVec.size() ) + "\n";
 }
 
+/** \returns a new copy of the single value */
+template<typename valueType> CDataSet* CSingleValue<valueType>::clone() const throw()
+{
+  return new CSingleValue<valueType>( *this );
+}
+
+/** \returns the size of the data in bytes */
+template<typename valueType> size_t CSingleValue<valueType>::getDataSize() const throw()
+{
+  return valueVec.size() * sizeof( valueType );
+}
+
 /**
  * \param aDataSet the other data set
  */
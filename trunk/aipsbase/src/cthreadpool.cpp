@@ -0,0 +1,201 @@
+/************************************************************************
+ * File: cthreadpool.cpp                                                *
+ * Project: AIPS                                                        *
+ * Description: Persistent worker threads shared by the pipeline        *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#include "cthreadpool.h"
+#include "cpipelineitem.h"
+
+// Standard includes
+#include <sstream>
+
+// Boost includes
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+using namespace std;
+using namespace aips;
+
+namespace
+{
+
+/// Shared state of one call of CThreadPool::runRanges()
+struct SRangeState
+{
+	SRangeState( const boost::function<void ( const size_t, const size_t )>& rangeFunction_,
+		const size_t itemCount_, const size_t rangeCount_ )
+		: rangeFunction( rangeFunction_ ), itemCount( itemCount_ ), rangeCount( rangeCount_ ),
+		nextRange( 0 ), finishedRanges( 0 ) {}
+	boost::function<void ( const size_t, const size_t )> rangeFunction;
+	size_t itemCount;
+	size_t rangeCount;
+	size_t nextRange;       ///< First range not taken by a thread yet
+	size_t finishedRanges;  ///< Number of completed ranges
+	boost::mutex theMutex;  ///< Guards nextRange and finishedRanges
+	boost::condition_variable finishedCondition; ///< Signaled when the last range is completed
+};
+
+/**
+ * Processes ranges until all of them are taken. Threads which are started too
+ * late to get a range return at once.
+ */
+void processRanges( boost::shared_ptr<SRangeState> aStatePtr )
+{
+	boost::mutex::scoped_lock lock( aStatePtr->theMutex );
+	while( aStatePtr->nextRange < aStatePtr->rangeCount )
+	{
+		const size_t i = aStatePtr->nextRange++;
+		lock.unlock();
+		aStatePtr->rangeFunction( i * aStatePtr->itemCount / aStatePtr->rangeCount,
+			( i + 1 ) * aStatePtr->itemCount / aStatePtr->rangeCount );
+		lock.lock();
+		if ( ++aStatePtr->finishedRanges == aStatePtr->rangeCount )
+			aStatePtr->finishedCondition.notify_all();
+	}
+}
+
+}
+
+/*************
+ * Structors *
+ *************/
+
+CThreadPool::CThreadPool() throw()
+	: CBase( "CThreadPool", CTHREADPOOL_VERSION, "CBase" ), uiThreads( 0 ), uiBusy( 0 ), bStop( false )
+{
+}
+
+/**
+ * Waits until all started tasks are finished and ends the worker threads
+ */
+CThreadPool::~CThreadPool() throw()
+{
+	{
+		boost::mutex::scoped_lock lock( poolMutex );
+		bStop = true;
+	}
+	taskCondition.notify_all();
+	threadsGroup.join_all();
+}
+
+/*****************
+ * Other methods *
+ *****************/
+
+/**
+ * Hands the task to up to uiCount threads, but never lets the number of
+ * running tasks exceed CPipelineItem::getNumberOfThreads() - 1. Missing
+ * threads are created.
+ * \param aTask function to run
+ * \param uiCount number of threads which should run the task
+ * \returns the number of threads that will run the task
+ */
+unsigned int CThreadPool::start( const boost::function<void ()>& aTask, const unsigned int uiCount )
+	throw()
+{
+	const unsigned int uiLimit = CPipelineItem::getNumberOfThreads() - 1;
+	unsigned int uiStarted = 0;
+	{
+		boost::mutex::scoped_lock lock( poolMutex );
+		if ( bStop )
+			return 0;
+		while( uiStarted < uiCount && uiBusy < uiLimit )
+		{
+			taskQueue.push_back( aTask );
+			++uiBusy;
+			++uiStarted;
+			// Each busy task owns a thread, so we only need a new one if all are busy
+			if ( uiThreads < uiBusy )
+			{
+				threadsGroup.create_thread( boost::bind( &CThreadPool::runThread, this ) );
+				++uiThreads;
+			}
+		}
+	}
+	if ( uiStarted == 1 )
+		taskCondition.notify_one();
+	else if ( uiStarted > 1 )
+		taskCondition.notify_all();
+	return uiStarted;
+}
+
+/**
+ * Splits [0, itemCount) into rangeCount consecutive ranges and calls the range
+ * function once for each of them. The calling thread processes ranges itself
+ * and is helped by as many free threads as are available, so the call also
+ * completes if all threads of the pool are busy. Returns after all ranges are
+ * processed.
+ * \param rangeFunction function processing the items [first argument, second argument)
+ * \param itemCount number of items
+ * \param rangeCount number of ranges
+ */
+void CThreadPool::runRanges( const boost::function<void ( const size_t, const size_t )>& rangeFunction,
+	const size_t itemCount, const size_t rangeCount ) throw()
+{
+	if ( rangeCount == 0 )
+		return;
+	boost::shared_ptr<SRangeState> statePtr( new SRangeState( rangeFunction, itemCount, rangeCount ) );
+	start( boost::bind( &processRanges, statePtr ), static_cast<unsigned int>( rangeCount - 1 ) );
+	processRanges( statePtr );
+	boost::mutex::scoped_lock lock( statePtr->theMutex );
+	while( statePtr->finishedRanges < statePtr->rangeCount )
+		statePtr->finishedCondition.wait( lock );
+}
+
+/** Reimplemented from CBase */
+const std::string CThreadPool::dump() const throw()
+{
+	std::ostringstream os;
+	{
+		boost::mutex::scoped_lock lock( poolMutex );
+		os << "uiThreads " << uiThreads << " uiBusy " << uiBusy << " queued " << taskQueue.size()
+			<< " bStop " << bStop << "\n";
+	}
+	return CBase::dump() + os.str();
+}
+
+/**
+ * Runs queued tasks until the pool is destroyed
+ */
+void CThreadPool::runThread() throw()
+{
+	boost::mutex::scoped_lock lock( poolMutex );
+	while( true )
+	{
+		while( taskQueue.empty() && !bStop )
+			taskCondition.wait( lock );
+		if ( taskQueue.empty() )
+			return;
+		boost::function<void ()> aTask = taskQueue.front();
+		taskQueue.pop_front();
+		lock.unlock();
+		aTask();
+		lock.lock();
+		--uiBusy;
+	}
+}
+
+/*******************************
+ * Global thread pool instance *
+ *******************************/
+
+namespace aips {
+
+/** \returns the global thread pool */
+CThreadPool& getThreadPool() throw()
+{
+	static CThreadPool theThreadPool;
+	return theThreadPool;
+}
+
+}
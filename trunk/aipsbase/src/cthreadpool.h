@@ -0,0 +1,99 @@
+/************************************************************************
+ * File: cthreadpool.h                                                  *
+ * Project: AIPS                                                        *
+ * Description: Persistent worker threads shared by the pipeline        *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Version: 0.1                                                         *
+ * Status : Beta                                                        *
+ * Created: 2026-10-17                                                  *
+ * Changed:                                                             *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#ifndef CTHREADPOOL_H
+#define CTHREADPOOL_H
+
+#define CTHREADPOOL_VERSION "0.1"
+
+// Standard includes
+#include <deque>
+
+// Boost includes
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+// AIPS includes
+#include "cbase.h"
+
+namespace aips {
+
+/**
+ * \brief Worker threads shared by the pipeline scheduler and parallelFor().
+ *
+ * The threads are created on demand and live until the program ends. The
+ * pool never runs more than CPipelineItem::getNumberOfThreads() - 1 tasks at
+ * a time, so together with the thread that called update() a pipeline run
+ * never uses more threads than configured, no matter whether they execute
+ * independent branches or the slices of a single filter.
+ *
+ * Tasks are never queued behind busy threads. start() only hands a task to
+ * as many threads as are free and tells the caller how many it got, so
+ * callers must be able to complete their work on their own.
+ *
+ * The pool is thread safe. Use getThreadPool() to retrieve the global
+ * instance.
+ */
+class CThreadPool : public CBase
+{
+private:
+	/// Copy constructor
+	CThreadPool( const CThreadPool& );
+	/// Assignment operator
+	CThreadPool& operator=( const CThreadPool& );
+public:
+/* Structors */
+	/// Constructor
+	CThreadPool()
+		throw();
+	/// Destructor
+	virtual ~CThreadPool()
+		throw();
+/* Other methods */
+	/// Runs the task on up to uiCount free threads
+	unsigned int start( const boost::function<void ()>& aTask, const unsigned int uiCount = 1 )
+		throw();
+	/// Calls the range function for rangeCount consecutive ranges of [0, itemCount)
+	void runRanges( const boost::function<void ( const size_t, const size_t )>& rangeFunction,
+		const size_t itemCount, const size_t rangeCount )
+		throw();
+	/// Reimplemented from CBase
+	virtual const std::string dump() const
+		throw();
+private:
+	/// Loop of each worker thread
+	void runThread()
+		throw();
+	std::deque<boost::function<void ()> > taskQueue; ///< Tasks not picked up by a thread yet
+	boost::thread_group threadsGroup;  ///< All worker threads
+	unsigned int uiThreads;            ///< Number of worker threads
+	unsigned int uiBusy;               ///< Number of queued and running tasks
+	bool bStop;                        ///< Set by the destructor to end all threads
+	mutable boost::mutex poolMutex;    ///< Guards all members above
+	boost::condition_variable taskCondition; ///< Signaled each time a task was queued
+};
+
+/// Returns the global thread pool
+CThreadPool& getThreadPool()
+	throw();
+
+}
+
+#endif
@@ -42,6 +42,19 @@
  *          2006-05-18 Added convenience access methods accepting       *
  *                      TPoint2D and TPoint3D input (get,set,op[])      *
  *                     Corrected return error of set(...) method        *
+ *          2026-10-17 Data is now stored in a pooled and aligned       *
+ *                      CDataBlock instead of a std::vector             *
+ *                     Added EDataInit parameter to the constructors    *
+ *                     Added copy-on-write sharing of the data block    *
+ *                      (share(), clone(), detach())                    *
+ *                     Added constructor for existing data blocks       *
+ *                     Coordinates and indices are now of type size_t   *
+ *                     Strides are computed once per extent change      *
+ *                      (getStride())                                   *
+ *                     Added cloneRegion() and insertRegion()           *
+ *                     getDataSize() is now virtual                     *
+ *                     share() marks both data sets as shared           *
+ *                     The access operators no longer call detach()     *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -57,8 +70,12 @@
 // Standard includes
 #include <algorithm> // std::swap
 
+// Boost includes
+#include <boost/shared_ptr.hpp>
+
 // AIPS includes
 #include "cdataset.h"
+#include "cdatablock.h"
 #include <aipsnumbertraits.h>
 #include <cdatarange.h>
 
@@ -66,6 +83,17 @@ namespace aips {
 
 /**
  * A dataset representing a multidimensional array of a specific type
+ *
+ * The copy constructor and operator= always copy the whole data array. Use
+ * share() or clone() to get a copy-on-write copy instead. Such a copy refers
+ * to the data block of its source until detach() is called, either directly
+ * or by getArray(), set(), begin(), end() or moveTo(), and only then copies
+ * the block. The source is marked as shared as well, so it also copies the
+ * block on its next detach() if a copy still refers to it.
+ *
+ * The non-const access operators () and [] never detach to stay as cheap as
+ * a plain array access. Detach a data set which may be shared once before
+ * writing to it through them. CPipelineItem::takeInput() already does so.
  */
 template<typename TValue>
 class CTypedData : public CDataSet
@@ -73,21 +101,31 @@ class CTypedData : public CDataSet
 private:
 	/// Standard constructor
 	CTypedData();
+	/// Constructor for copy-on-write copies (used by clone())
+	CTypedData( const CTypedData<TValue>& aDataSet, const bool bShareData ) throw();
 public:
  	typedef TValue TDataType;
  	typedef SDataTraits<TValue> TTraitType;
 
 	/// Enumeration types
 	enum EDataAlign { DataAlignFront = 0, DataAlignCenter, DataAlignBack };
+	/// Initialisation of newly allocated data
+	enum EDataInit { DataInitZero = 0, ///< Set all elements to zero
+		DataInitNone ///< Leave elements uninitialised (if TValue is a plain old data type)
+	};
 /* Structors */
   /// Constructor
   CTypedData( const unsigned short usDimension_, const size_t* extendArr_,
-    const size_t dataDimensionSize_ = 1) throw();
+    const size_t dataDimensionSize_ = 1, const EDataInit initialisation = DataInitZero ) throw();
   /// Constructor
   CTypedData( const unsigned short usDimension_, const std::vector<size_t> extendVec_,
-    const size_t dataDimensionSize_ = 1) throw();
+    const size_t dataDimensionSize_ = 1, const EDataInit initialisation = DataInitZero ) throw();
   /// Constructor
-  CTypedData( const size_t extent_, const size_t dataDimensionSize_ = 1) throw();
+  CTypedData( const size_t extent_, const size_t dataDimensionSize_ = 1,
+		const EDataInit initialisation = DataInitZero ) throw();
+  /// Constructor for an existing data block (e.g. a memory mapped file)
+  CTypedData( const unsigned short usDimension_, const std::vector<size_t> extendVec_,
+    const size_t dataDimensionSize_, boost::shared_ptr<CDataBlock<TValue> > aDataBlockSPtr ) throw();
   /// Copy constructor
   CTypedData( const CTypedData<TValue>& otherDataSet )
     throw();
@@ -106,8 +144,8 @@ public:
   virtual const std::type_info& getType() const
     throw();
   /// Constant access operator with range checking
-  inline const TValue& get( const unsigned short usX, const unsigned short usY, const unsigned short usZ,
-    const unsigned short usW ) const throw(OutOfRangeException);
+  inline const TValue& get( const size_t x, const size_t y, const size_t z,
+    const size_t w ) const throw(OutOfRangeException);
   /// Constant access operator with range checking
   inline const TValue& get( const TPoint2D aPosition )
     const throw(OutOfRangeException);
@@ -119,15 +157,21 @@ public:
     throw( OutOfRangeException );
   /// Returns a void handle to the data array
   virtual void* getVoidArray() throw();
+  /// Returns true if the data array is shared with another data set
+  inline bool isShared() const
+    throw();
   /// Returns the size of the internal Array (no. of elements)
-  inline unsigned long getArraySize() const
+  inline size_t getArraySize() const
     throw();
-	/// Returns the size of the data block (in bytes)
-	inline unsigned long getDataSize() const
+	/// Returns the size of the data block (in bytes). Reimplemented from CDataSet
+	inline virtual size_t getDataSize() const
+		throw();
+	/// Returns the distance between neighbouring elements along a dimension
+	inline size_t getStride( const unsigned short usIndex ) const
 		throw();
 /* Mutators */
   /// Access operator with range checking and automatic min/max assignment
-  inline void set( const unsigned short usX, const unsigned short usY, const unsigned short usZ, const unsigned short usW,
+  inline void set( const size_t x, const size_t y, const size_t z, const size_t w,
     const TValue newValue ) throw(OutOfRangeException);
   /// Access operator with range checking and automatic min/max assignment
   inline void set( const TPoint2D aPosition, const TValue newValue )
@@ -166,38 +210,38 @@ public:
 		throw();
 /* Access operators */
   /// Access operator without range checking (1D)
-  inline TValue& operator()( const unsigned short usX )
+  inline TValue& operator()( const size_t x )
     throw();
   /// Access operator without range checking (2D)
-  inline TValue& operator()( const unsigned short usX, const unsigned short usY )
+  inline TValue& operator()( const size_t x, const size_t y )
     throw();
   /// Access operator without range checking (3D)
-  inline TValue& operator()( const unsigned short usX, const unsigned short usY, const unsigned short usZ )
+  inline TValue& operator()( const size_t x, const size_t y, const size_t z )
     throw();
   /// Access operator without range checking (4D)
-  inline TValue& operator()( const unsigned short usX, const unsigned short usY, const unsigned short usZ,
-    const unsigned short usW ) throw();
+  inline TValue& operator()( const size_t x, const size_t y, const size_t z,
+    const size_t w ) throw();
   /// Constant access operator without range checking (1D)
-  inline const TValue& operator()( const unsigned short usX ) const
+  inline const TValue& operator()( const size_t x ) const
     throw();
   /// Constant access operator without range checking (2D)
-  inline const TValue& operator()( const unsigned short usX, const unsigned short usY ) const
+  inline const TValue& operator()( const size_t x, const size_t y ) const
     throw();
   /// Constant access operator without range checking (3D)
-  inline const TValue& operator()( const unsigned short usX, const unsigned short usY, const unsigned short usZ )
+  inline const TValue& operator()( const size_t x, const size_t y, const size_t z )
     const throw();
   /// Constant access operator without range checking (4D)
-  inline const TValue& operator()( const unsigned short usX, const unsigned short usY,
-    const unsigned short usZ, const unsigned short usW ) const
+  inline const TValue& operator()( const size_t x, const size_t y,
+    const size_t z, const size_t w ) const
     throw();
 	/// Operator[] for C-Style array access to the dataset
-  TValue& operator[]( const unsigned long ulIndex ) throw();
+  TValue& operator[]( const size_t index ) throw();
   /// Operator[] for C-Style array access to the dataset using a discrete vector parameter
   TValue& operator[]( const TPoint2D aPosition ) throw();
   /// Operator[] for C-Style array access to the dataset using a discrete vector parameter
   TValue& operator[]( const TPoint3D aPosition ) throw();
   /// Const access operator[] for C-Style array access to the dataset
-  const TValue& operator[]( const unsigned long ulIndex ) const throw();
+  const TValue& operator[]( const size_t index ) const throw();
   /// Const access operator[] for C-Style array access to the dataset using a discrete vector parameter
   const TValue& operator[]( const TPoint2D aPosition ) const throw();
   /// Const access operator[] for C-Style array access to the dataset using a discrete vector parameter
@@ -353,44 +397,41 @@ public:
 		}
 		/**
 		 * Moves the iterator relative to its actual position
-		 * \param sX steps to move in X direction
+		 * \param dX steps to move in X direction
 		 */
-		void moveRel( const short sX ) throw()
+		void moveRel( const ptrdiff_t dX ) throw()
 		{
-			positionPtr += sX;
+			positionPtr += dX;
 		}
 		/**
 		 * Moves the iterator relative to its actual position
-		 * \param sX steps to move in X direction
-		 * \param sY steps to move in Y direction
+		 * \param dX steps to move in X direction
+		 * \param dY steps to move in Y direction
 		 */
-		void moveRel( const short sX, const short sY ) throw()
+		void moveRel( const ptrdiff_t dX, const ptrdiff_t dY ) throw()
 		{
-			positionPtr += sX + parentPtr->getExtent(0) * sY;
+			positionPtr += dX + stride( 1 ) * dY;
 		}
 		/**
 		 * Moves the iterator relative to its actual position
-		 * \param sX steps to move in X direction
-		 * \param sY steps to move in Y direction
-		 * \param sZ steps to move in Z direction
+		 * \param dX steps to move in X direction
+		 * \param dY steps to move in Y direction
+		 * \param dZ steps to move in Z direction
 		 */
-		void moveRel( const short sX, const short sY,	const short sZ ) throw()
+		void moveRel( const ptrdiff_t dX, const ptrdiff_t dY, const ptrdiff_t dZ ) throw()
 		{
-			positionPtr += sX + parentPtr->getExtent(0) * sY
-				+ parentPtr->getExtent(0) * parentPtr->getExtent(1) * sZ;
+			positionPtr += dX + stride( 1 ) * dY + stride( 2 ) * dZ;
 		}
 		/**
 		 * Moves the iterator relative to its actual position
-		 * \param sX steps to move in X direction
-		 * \param sY steps to move in Y direction
-		 * \param sZ steps to move in Z direction
-		 * \param sW steps to move in W direction
+		 * \param dX steps to move in X direction
+		 * \param dY steps to move in Y direction
+		 * \param dZ steps to move in Z direction
+		 * \param dW steps to move in W direction
 		 */
-		void moveRel( const short sX, const short sY,	const short sZ, const short sW ) throw()
+		void moveRel( const ptrdiff_t dX, const ptrdiff_t dY, const ptrdiff_t dZ, const ptrdiff_t dW ) throw()
 		{
-			positionPtr += sX + parentPtr->getExtent(0) * sY
-				+ parentPtr->getExtent(0) * parentPtr->getExtent(1) * sZ
-				+ parentPtr->getExtent(0) * parentPtr->getExtent(1) * parentPtr->getExtent(2) * sW;
+			positionPtr += dX + stride( 1 ) * dY + stride( 2 ) * dZ + stride( 3 ) * dW;
 		}
     /**
      * Moves the iterator relative to its actual position
@@ -398,7 +439,7 @@ public:
      */
     void moveRel( const TPoint2D aPosition ) throw()
     {
-      positionPtr += aPosition[0] + parentPtr->getExtent(0) * aPosition[1];
+      positionPtr += aPosition[0] + stride( 1 ) * aPosition[1];
     }
     /**
      * Moves the iterator relative to its actual position
@@ -406,62 +447,97 @@ public:
      */
     void moveRel( const TPoint3D aPosition ) throw()
     {
-      positionPtr += aPosition[0] + parentPtr->getExtent(0) * aPosition[1]
-        + parentPtr->getExtent(0) * parentPtr->getExtent(1) * aPosition[2];
+      positionPtr += aPosition[0] + stride( 1 ) * aPosition[1] + stride( 2 ) * aPosition[2];
     }
 		/**
 		 * Returns the actual iterator position in image coordinates
-		 * \param usX X position
+		 * \param x X position
+		 */
+		void getPos( size_t& x ) const throw()
+		{
+			x = index();
+		}
+		/**
+		 * Returns the actual iterator position in image coordinates
+		 * \param x X position
+		 * \param y Y position
 		 */
-		void getPos( unsigned short& usX ) const throw()
+		void getPos( size_t& x, size_t& y ) const throw()
 		{
-			usX = ( positionPtr - parentPtr->begin().pos );
+			const size_t theIndex = index();
+			y = theIndex / stride( 1 );
+			x = theIndex - y * stride( 1 );
 		}
 		/**
 		 * Returns the actual iterator position in image coordinates
+		 * \param x X position
+		 * \param y Y position
+		 * \param z Z position
+		 */
+		void getPos( size_t& x, size_t& y, size_t& z ) const throw()
+		{
+			size_t theIndex = index();
+			z = theIndex / stride( 2 );
+			theIndex -= z * stride( 2 );
+			y = theIndex / stride( 1 );
+			x = theIndex - y * stride( 1 );
+		}
+		/**
+		 * Returns the actual iterator position in image coordinates
+		 * \param x X position
+		 * \param y Y position
+		 * \param z Z position
+		 * \param w W position
+		 */
+		void getPos( size_t& x, size_t& y, size_t& z, size_t& w ) const throw()
+		{
+			size_t theIndex = index();
+			w = theIndex / stride( 3 );
+			theIndex -= w * stride( 3 );
+			z = theIndex / stride( 2 );
+			theIndex -= z * stride( 2 );
+			y = theIndex / stride( 1 );
+			x = theIndex - y * stride( 1 );
+		}
+		/**
+		 * Returns the actual iterator position in image coordinates. Only use this
+		 * for datasets with extents below 65536.
 		 * \param usX X position
 		 * \param usY Y position
 		 */
 		void getPos( unsigned short& usX, unsigned short& usY ) const throw()
 		{
-			ptrdiff_t diff = ( positionPtr - parentPtr->begin().positionPtr );
-			usY = diff / parentPtr->getExtent(0);
-			usX = diff % parentPtr->getExtent(0);
+			size_t x, y;
+			getPos( x, y );
+			usX = x; usY = y;
 		}
 		/**
-		 * Returns the actual iterator position in image coordinates
+		 * Returns the actual iterator position in image coordinates. Only use this
+		 * for datasets with extents below 65536.
 		 * \param usX X position
 		 * \param usY Y position
 		 * \param usZ Z position
 		 */
 		void getPos( unsigned short& usX, unsigned short& usY, unsigned short& usZ ) const throw()
 		{
-			ptrdiff_t diff = ( positionPtr - parentPtr->begin().positionPtr );
-			usZ = diff / ( parentPtr->getExtent(0) * parentPtr->getExtent(1) );
-			usY = ( diff % ( parentPtr->getExtent(0) * parentPtr->getExtent(1) ) )
-				/ ( parentPtr->getExtent(0) );
-			usX = diff - ( parentPtr->getExtent(0) * parentPtr->getExtent(1) * usZ )
-				- ( parentPtr->getExtent(0) * usY );
+			size_t x, y, z;
+			getPos( x, y, z );
+			usX = x; usY = y; usZ = z;
 		}
 		/**
-		 * Returns the actual iterator position in image coordinates
+		 * Returns the actual iterator position in image coordinates. Only use this
+		 * for datasets with extents below 65536.
 		 * \param usX X position
 		 * \param usY Y position
 		 * \param usZ Z position
 		 * \param usW W position
 		 */
-		void getPos( unsigned short& usX, unsigned short& usY, unsigned short& usZ, unsigned short& usW ) const throw()
-		{
-			ptrdiff_t diff = ( positionPtr - parentPtr->begin().positionPtr );
-			usW = diff / ( parentPtr->getExtent(0) * parentPtr->getExtent(1) * parentPtr->getExtent(2) );
-			usZ = ( diff % ( parentPtr->getExtent(0) * parentPtr->getExtent(1) * parentPtr->getExtent(2) ) )
-				/ ( parentPtr->getExtent(0) * parentPtr->getExtent(1) ) ;
-			usY = ( diff - ( parentPtr->getExtent(0) * parentPtr->getExtent(1) * parentPtr->getExtent(2)
-				* usW )	- ( parentPtr->getExtent(0) * parentPtr->getExtent(1) * usZ ) )
-				/ parentPtr->getExtent(0);
-			usX = diff - ( parentPtr->getExtent(0) * parentPtr->getExtent(1) * parentPtr->getExtent(2)
-				* usW )	- ( parentPtr->getExtent(0) * parentPtr->getExtent(1) * usZ )
-				- ( parentPtr->getExtent(0) * usY );
+		void getPos( unsigned short& usX, unsigned short& usY, unsigned short& usZ, unsigned short& usW ) 
+			const throw()
+		{
+			size_t x, y, z, w;
+			getPos( x, y, z, w );
+			usX = x; usY = y; usZ = z; usW = w;
 		}
     /**
      * Returns the actual iterator position in image coordinates
@@ -469,9 +545,9 @@ public:
      */
     void getPos( TPoint2D& aPosition ) const throw()
     {
-      ptrdiff_t diff = ( positionPtr - parentPtr->begin().positionPtr );
-      aPosition[1] = diff / parentPtr->getExtent(0);
-      aPosition[0] = diff % parentPtr->getExtent(0);
+      size_t x, y;
+      getPos( x, y );
+      aPosition[0] = x; aPosition[1] = y;
     }
     /**
      * Returns the actual iterator position in image coordinates
@@ -479,12 +555,9 @@ public:
      */
     void getPos( TPoint3D& aPosition ) const throw()
     {
-      ptrdiff_t diff = ( positionPtr - parentPtr->begin().positionPtr );
-      aPosition[2] = diff / ( parentPtr->getExtent(0) * parentPtr->getExtent(1) );
-      aPosition[1] = ( diff % ( parentPtr->getExtent(0) * parentPtr->getExtent(1) ) )
-        / ( parentPtr->getExtent(0) );
-      aPosition[0] = diff - ( parentPtr->getExtent(0) * parentPtr->getExtent(1) * aPosition[2] )
-        - ( parentPtr->getExtent(0) * aPosition[1] );
+      size_t x, y, z;
+      getPos( x, y, z );
+      aPosition[0] = x; aPosition[1] = y; aPosition[2] = z;
     }
 		/**
 		 * Returns a pointer to the iterator parent data structure
@@ -495,12 +568,23 @@ public:
 			return parentPtr;
 		}
 /// Move the TypedDataIterator forward by an specific amount
-	TypedDataIterator<T,U> operator+( ptrdiff_t amount ){ TypedDataIterator<T,U> t; t += amount; return t; }
+	TypedDataIterator<T,U> operator+( ptrdiff_t amount ){ TypedDataIterator<T,U> t( *this ); t += amount; return t; }
 
 /// Move the TypedDataIterator backward by an specific amount
-	TypedDataIterator<T,U> operator-( ptrdiff_t amount ){ TypedDataIterator<T,U> t; t -= amount; return t; }
+	TypedDataIterator<T,U> operator-( ptrdiff_t amount ){ TypedDataIterator<T,U> t( *this ); t -= amount; return t; }
 
 	private:
+		/** \returns the stride of the parent data set in the given dimension */
+		ptrdiff_t stride( const unsigned short usIndex ) const throw()
+		{
+			return static_cast<ptrdiff_t>( parentPtr->getStride( usIndex ) );
+		}
+		/** \returns the array index of the actual position */
+		size_t index() const throw()
+		{
+			const CTypedData<T>& theParent = *parentPtr;
+			return static_cast<size_t>( positionPtr - &theParent[0] );
+		}
 		U positionPtr; 					///< Pointer to actual position
 		CTypedData<T>* parentPtr; ///< Pointer to parent CTypedData
 	};
@@ -520,29 +604,59 @@ public:
   /// Returns reverse_iterator for end of array
   reverse_iterator rend() throw();
 	/// Returns an iterator to the given position
-	iterator moveTo( const unsigned short usX ) throw();
+	iterator moveTo( const size_t x ) throw();
 	/// Returns an iterator to the given position
-	iterator moveTo( const unsigned short usX, const unsigned short usY ) throw();
+	iterator moveTo( const size_t x, const size_t y ) throw();
 	/// Returns an iterator to the given position
-	iterator moveTo( const unsigned short usX, const unsigned short usY, const unsigned short usZ ) throw();
+	iterator moveTo( const size_t x, const size_t y, const size_t z ) throw();
 	/// Returns an iterator to the given position
-	iterator moveTo( const unsigned short usX, const unsigned short usY, const unsigned short usZ, const unsigned short usW ) throw();
+	iterator moveTo( const size_t x, const size_t y, const size_t z, const size_t w ) throw();
 
 /* Other Methods */
   /// Reimplemented from CDataSet
   virtual const std::string dump() const
+    throw();
+  /// Reimplemented from CDataSet. Returns a copy-on-write copy
+  virtual CDataSet* clone() const
+    throw();
+  /// Reimplemented from CDataSet
+  virtual CDataSet* cloneRegion( const std::vector<size_t>& regionOriginVec,
+    const std::vector<size_t>& regionExtentVec ) const throw();
+  /// Reimplemented from CDataSet
+  virtual bool insertRegion( const CDataSet& aRegion, const std::vector<size_t>& regionOriginVec )
     throw();
 	/// Swaps the data with another data set of the same type
 	void swap( CTypedData<TValue>& aDataSet )
 		throw();
+	/// Makes this data set a copy-on-write copy of the given one
+	void share( const CTypedData<TValue>& aDataSet )
+		throw();
+	/// Reimplemented from CDataSet. Gives the data set an own data block if it is shared
+	virtual void detach()
+		throw();
 	CDataRange<TValue,SDataTraits<TValue>::isScalar> getDataRange() const { return theDataRange; }
 	void setDataRange( const CDataRange<TValue,SDataTraits<TValue>::isScalar>& aDataRange)
 	{
 		theDataRange = aDataRange;
 	}
 private:
+	/// Copies a shared data block
+	void copyOnWrite()
+		throw();
+	/// Recomputes strideArr from the extents
+	inline void updateStrides()
+		throw();
+	/// Checks if a region lies completely inside the data set
+	bool isRegionValid( const std::vector<size_t>& regionOriginVec,
+		const std::vector<size_t>& regionExtentVec ) const throw();
+	/// Copies a box of voxels between two data sets of the same dimension
+	static void copyRegion( const CTypedData<TValue>& source, const std::vector<size_t>& sourceOriginVec,
+		CTypedData<TValue>& target, const std::vector<size_t>& targetOriginVec,
+		const std::vector<size_t>& regionExtentVec ) throw();
   size_t arraySize;               ///< Size of the data array (no. of elements)
-  std::vector<TValue> dataVec; ///< The data array
+  size_t strideArr[4];            ///< Index distance of neighbouring elements in each dimension
+  boost::shared_ptr<CDataBlock<TValue> > dataBlockSPtr; ///< The data array
+  mutable bool bShared; ///< Might dataBlockSPtr be shared with another data set?
   CDataRange<TValue, SDataTraits<TValue>::isScalar> theDataRange;
 };
 
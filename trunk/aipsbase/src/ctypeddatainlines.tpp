@@ -21,21 +21,23 @@
  * \param usDimension_ Dimension of data field
  * \param extentArr_ Extends of field dimensions
  * \param dataDimensionSize_ Dimension of each field entry (for nonscalar fields)
+ * \param initialisation DataInitNone leaves the elements uninitialised. Use this for
+ *   datasets which will be completely overwritten anyway.
  */
 template<typename TValue>
 CTypedData<TValue>::CTypedData( const unsigned short usDimension_,
   const size_t* extentArr_,
-  const size_t dataDimensionSize_ ) throw() 
+  const size_t dataDimensionSize_, const EDataInit initialisation ) throw() 
 	: CDataSet( usDimension_, extentArr_, dataDimensionSize_,
-   "CTypedData", CTYPEDDATA_VERSION, "CDataSet" )
+   "CTypedData", CTYPEDDATA_VERSION, "CDataSet" ), bShared( false )
 {
-	// Compute array size and resize internal vector
+	// Compute array size and allocate internal array
   arraySize = 1;
   for ( unsigned short i = 0; i < usDimension; i++ )
     arraySize *= extentVec[i];
   arraySize *= dataDimensionSize;
-  dataVec.resize( arraySize );
-  memset( &dataVec[0], 0, arraySize * sizeof( TValue ) );
+  dataBlockSPtr.reset( new CDataBlock<TValue>( arraySize, initialisation == DataInitZero ) );
+  updateStrides();
   setDataRange( TTraitType::ZERO(), TTraitType::ONE() );
 }
 
@@ -43,21 +45,23 @@ CTypedData<TValue>::CTypedData( const unsigned short usDimension_,
  * \param usDimension_ Dimension of data field
  * \param extentVec_ Extends of field dimensions
  * \param dataDimensionSize_ Dimension of each field entry (for nonscalar fields)
+ * \param initialisation DataInitNone leaves the elements uninitialised. Use this for
+ *   datasets which will be completely overwritten anyway.
  */
 template<typename TValue>
 CTypedData<TValue>::CTypedData( const unsigned short usDimension_,
   const std::vector<size_t> extentVec_,
-  const size_t dataDimensionSize_ ) throw()
+  const size_t dataDimensionSize_, const EDataInit initialisation ) throw()
   : CDataSet( usDimension_, extentVec_, dataDimensionSize_, "CTypedData",
-    CTYPEDDATA_VERSION, "CDataSet" )
+    CTYPEDDATA_VERSION, "CDataSet" ), bShared( false )
 {
-	// Compute array size and resize internal vector
+	// Compute array size and allocate internal array
   arraySize = 1;
   for ( unsigned short i = 0; i < usDimension; i++ )
     arraySize *= extentVec[i];
   arraySize *= dataDimensionSize;
-  dataVec.resize( arraySize );
-  memset( &dataVec[0], 0, arraySize * sizeof( TValue ) );
+  dataBlockSPtr.reset( new CDataBlock<TValue>( arraySize, initialisation == DataInitZero ) );
+  updateStrides();
   setDataRange( TTraitType::ZERO(), TTraitType::ONE() );
 }
 
@@ -65,16 +69,38 @@ CTypedData<TValue>::CTypedData( const unsigned short usDimension_,
  * Convienience constructor for one-dimensional data fields
  * \param extent_ extent of field dimension
  * \param dataDimensionSize_ Dimension of each field entry (for nonscalar fields)
+ * \param initialisation DataInitNone leaves the elements uninitialised
  */
 template<typename TValue>
-CTypedData<TValue>::CTypedData( const size_t extent_, const size_t dataDimensionSize_ ) throw()
+CTypedData<TValue>::CTypedData( const size_t extent_, const size_t dataDimensionSize_,
+	const EDataInit initialisation ) throw()
 	: CDataSet( extent_, dataDimensionSize_, "CTypedData", CTYPEDDATA_VERSION,
-	"CDataSet" )
+	"CDataSet" ), bShared( false )
 {
 	arraySize = extent_;
 	arraySize *= dataDimensionSize;
-  dataVec.resize( arraySize );
-  memset( &dataVec[0], 0, arraySize * sizeof( TValue ) );
+  dataBlockSPtr.reset( new CDataBlock<TValue>( arraySize, initialisation == DataInitZero ) );
+  updateStrides();
+  setDataRange( TTraitType::ZERO(), TTraitType::ONE() );
+}
+
+/**
+ * The data set takes over the given block, which must hold exactly as many elements
+ * as given by the extents and data dimension.
+ * \param usDimension_ Dimension of data field
+ * \param extentVec_ Extends of field dimensions
+ * \param dataDimensionSize_ Dimension of each field entry (for nonscalar fields)
+ * \param aDataBlockSPtr the data block
+ */
+template<typename TValue>
+CTypedData<TValue>::CTypedData( const unsigned short usDimension_,
+  const std::vector<size_t> extentVec_, const size_t dataDimensionSize_,
+  boost::shared_ptr<CDataBlock<TValue> > aDataBlockSPtr ) throw()
+  : CDataSet( usDimension_, extentVec_, dataDimensionSize_, "CTypedData",
+    CTYPEDDATA_VERSION, "CDataSet" ), dataBlockSPtr( aDataBlockSPtr ), bShared( false )
+{
+  arraySize = dataBlockSPtr->getSize();
+  updateStrides();
   setDataRange( TTraitType::ZERO(), TTraitType::ONE() );
 }
 
@@ -84,18 +110,38 @@ CTypedData<TValue>::CTypedData( const size_t extent_, const size_t dataDimension
 template<typename TValue>
 CTypedData<TValue>::CTypedData ( const CTypedData<TValue>& aDataSet ) throw()
   : CDataSet( aDataSet.usDimension, aDataSet.extentVec, aDataSet.dataDimensionSize, 
-		"CTypedData", CTYPEDDATA_VERSION, "CDataSet" )
+		"CTypedData", CTYPEDDATA_VERSION, "CDataSet" ), bShared( false )
 {
   arraySize = aDataSet.arraySize;
-  dataVec.resize( arraySize );
-  dataVec = aDataSet.dataVec;
+  dataBlockSPtr.reset( new CDataBlock<TValue>( *aDataSet.dataBlockSPtr ) );
   theDataRange = aDataSet.theDataRange;
+  updateStrides();
+}
+
+/**
+ * \param aDataSet Object to copy
+ * \param bShareData if true, the new object shares the data block of aDataSet
+ *   (see share()). Otherwise the data is copied.
+ */
+template<typename TValue>
+CTypedData<TValue>::CTypedData ( const CTypedData<TValue>& aDataSet, const bool bShareData ) throw()
+  : CDataSet( aDataSet.usDimension, aDataSet.extentVec, aDataSet.dataDimensionSize,
+		"CTypedData", CTYPEDDATA_VERSION, "CDataSet" ), bShared( false )
+{
+	if ( bShareData )
+		share( aDataSet );
+	else
+	{
+		arraySize = aDataSet.arraySize;
+		dataBlockSPtr.reset( new CDataBlock<TValue>( *aDataSet.dataBlockSPtr ) );
+		theDataRange = aDataSet.theDataRange;
+		updateStrides();
+	}
 }
 
 template<typename TValue>
 CTypedData<TValue>::~CTypedData() throw()
 {
-  dataVec.clear();
 }
 
 /*************
@@ -116,8 +162,13 @@ CTypedData<TValue>& CTypedData<TValue>::operator=
   extentVec = aDataSet.extentVec;
   theDataRange = aDataSet.theDataRange;
   arraySize = aDataSet.arraySize;
-  dataVec.resize( arraySize );
-  dataVec.assign( aDataSet.dataVec.begin(), aDataSet.dataVec.end() );  
+  updateStrides();
+  // Never overwrite a block that is shared with another data set
+  if ( bShared )
+    dataBlockSPtr.reset( new CDataBlock<TValue>( *aDataSet.dataBlockSPtr ) );
+  else
+    (*dataBlockSPtr) = (*aDataSet.dataBlockSPtr);
+  bShared = false;
   return *this;  
 }
 
@@ -129,10 +180,10 @@ template<typename TValue> inline
 CTypedData<TValue>& CTypedData<TValue>::operator=
   ( const TValue newDefault ) throw()
 {
-  for ( unsigned long i = 0; i < arraySize; i++ )
-  {
-    dataVec[i] = newDefault;
-  }  
+  if ( bShared )
+    dataBlockSPtr.reset( new CDataBlock<TValue>( arraySize, false ) );
+  bShared = false;
+  std::fill( dataBlockSPtr->getData(), dataBlockSPtr->getData() + arraySize, newDefault );
   return *this;
 }
 
@@ -149,20 +200,19 @@ const std::type_info& CTypedData<TValue>::getType() const throw()
 
 /**
  * Get operator. This operator is slow but does range checking.
- * \param usX x-coordinate of element
- * \param usY y-coordinate of element
- * \param usZ z-coordinate of element
- * \param usW w-coordinate of element
+ * \param x x-coordinate of element
+ * \param y y-coordinate of element
+ * \param z z-coordinate of element
+ * \param w w-coordinate of element
  * \returns value of the indexed element
  */
 template<typename TValue> inline
-const TValue& CTypedData<TValue>::get( const unsigned short usX, const unsigned short usY, const unsigned short usZ,
-	const unsigned short usW ) const throw(OutOfRangeException)
+const TValue& CTypedData<TValue>::get( const size_t x, const size_t y, const size_t z,
+	const size_t w ) const throw(OutOfRangeException)
 {
-  if ( usX > extentVec[0] || usY > extentVec[1] || usZ > extentVec[2] || usW > extentVec[3] )
+  if ( x > extentVec[0] || y > extentVec[1] || z > extentVec[2] || w > extentVec[3] )
     throw( OutOfRangeException( SERROR( "Index out of range"), CException::RECOVER, ERR_BADCOORDS ) );
-  return dataVec[usX + usY * extentVec[0] + usZ * extentVec[0] * extentVec[1]
-    + usW * extentVec[0] * extentVec[1] * extentVec[2]];
+  return (*dataBlockSPtr)[x + y * strideArr[1] + z * strideArr[2] + w * strideArr[3]];
 }
 
 /**
@@ -179,7 +229,7 @@ const TValue& CTypedData<TValue>::get( const TPoint2D aPosition )
   else if ( ( this->getDimension < 2 && aPosition[1] != 0 )
     || aPosition[1] < 0 || aPosition[1] > extentVec[1] )
     throw( OutOfRangeException( SERROR( "Index out of range"), CException::RECOVER, ERR_BADCOORDS ) );
-  return dataVec[aPosition[0] + aPosition[1] * extentVec[0]];
+  return (*dataBlockSPtr)[aPosition[0] + aPosition[1] * strideArr[1]];
 }
 
 /**
@@ -199,7 +249,7 @@ const TValue& CTypedData<TValue>::get( const TPoint3D aPosition )
   else if ( ( this->getDimension < 3 && aPosition[2] != 0 )
     || aPosition[2] < 0 || aPosition[2] > extentVec[2] )
     throw( OutOfRangeException( SERROR( "Index out of range"), CException::RECOVER, ERR_BADCOORDS ) );
-  return dataVec[aPosition[0] + aPosition[1] * extentVec[0] + aPosition[2] * extentVec[0] * extentVec[1]];
+  return (*dataBlockSPtr)[aPosition[0] + aPosition[1] * strideArr[1] + aPosition[2] * strideArr[2]];
 }
 
 /**
@@ -212,30 +262,54 @@ TValue* CTypedData<TValue>::getArray( unsigned short usChannel ) throw( OutOfRan
   if ( usChannel >= dataDimensionSize )
     throw( OutOfRangeException( SERROR("Data dimension out of range"),
       CException::RECOVER, ERR_BADDIMENSION ) );
-  return &(dataVec[arraySize / dataDimensionSize * usChannel]);
+  detach();
+  return dataBlockSPtr->getData() + arraySize / dataDimensionSize * usChannel;
 }
 
 /** \returns a void handle to the data array */
 template<typename TValue> inline
 void* CTypedData<TValue>::getVoidArray() throw()
 {
-  return static_cast<void*>( &( dataVec[0] ) );
+  detach();
+  return static_cast<void*>( dataBlockSPtr->getData() );
+}
+
+/**
+ * \returns true if the data block is shared with another data set, i.e. the
+ *   next non-const access will copy it
+ */
+template<typename TValue> inline
+bool CTypedData<TValue>::isShared() const throw()
+{
+  return bShared && !dataBlockSPtr.unique();
 }
 
 /** \returns the size of the internal Array (no. of elements) */
 template<typename TValue> inline
-unsigned long CTypedData<TValue>::getArraySize() const throw()
+size_t CTypedData<TValue>::getArraySize() const throw()
 {
   return arraySize;
 }
 
 /** \returns the size of the data block (in bytes) */
 template<typename TValue> inline
-unsigned long CTypedData<TValue>::getDataSize() const throw()
+size_t CTypedData<TValue>::getDataSize() const throw()
 {
 	return arraySize * sizeof( TValue );
 }
 
+/**
+ * The index of the element ( x, y, z, w ) in the data array is
+ * x + y * getStride( 1 ) + z * getStride( 2 ) + w * getStride( 3 ).
+ * \param usIndex dimension ( 0 to 3 )
+ * \returns the distance between two neighbouring elements along the given dimension
+ */
+template<typename TValue> inline
+size_t CTypedData<TValue>::getStride( const unsigned short usIndex ) const throw()
+{
+	return strideArr[usIndex];
+}
+
 /************
  * Mutators *
  ************/
@@ -243,20 +317,20 @@ unsigned long CTypedData<TValue>::getDataSize() const throw()
 /**
  * Set operator. This operator is slow but does range checking and will
  * assign new minimum and maximum values for the field automatically.
- * \param usX x-coordinate of element
- * \param usY y-coordinate of element
- * \param usZ z-coordinate of element
- * \param usW w-coordinate of element
+ * \param x x-coordinate of element
+ * \param y y-coordinate of element
+ * \param z z-coordinate of element
+ * \param w w-coordinate of element
  * \param newValue value of the indexed element
  */
 template<typename TValue> inline
-void CTypedData<TValue>::set( const unsigned short usX, const unsigned short usY, const unsigned short usZ,
-	const unsigned short usW, const TValue newValue ) throw(OutOfRangeException)
+void CTypedData<TValue>::set( const size_t x, const size_t y, const size_t z,
+	const size_t w, const TValue newValue ) throw(OutOfRangeException)
 {
-  if ( usX > extentVec[0] || usY > extentVec[1] || usZ > extentVec[2] || usW > extentVec[3] )
+  if ( x > extentVec[0] || y > extentVec[1] || z > extentVec[2] || w > extentVec[3] )
     throw( OutOfRangeException( SERROR( "Index out of range"), CException::RECOVER, ERR_BADCOORDS ) );
-  dataVec[usX + usY * extentVec[0] + usZ * extentVec[0] * extentVec[1]
-    + usW * extentVec[0] * extentVec[1] * extentVec[2]] = newValue;
+  detach();
+  (*dataBlockSPtr)[x + y * strideArr[1] + z * strideArr[2] + w * strideArr[3]] = newValue;
   theDataRange.updateRange( newValue );
 }
 
@@ -275,7 +349,8 @@ void CTypedData<TValue>::set( const TPoint2D aPosition, const TValue newValue )
   else if ( ( this->getDimension < 2 && aPosition[1] != 0 )
     || aPosition[1] < 0 || aPosition[1] > extentVec[1] )
     throw( OutOfRangeException( SERROR( "Index out of range"), CException::RECOVER, ERR_BADCOORDS ) );
-  dataVec[aPosition[0] + aPosition[1] * extentVec[0]] = newValue;
+  detach();
+  (*dataBlockSPtr)[aPosition[0] + aPosition[1] * strideArr[1]] = newValue;
   theDataRange.updateRange( newValue );
 }
 
@@ -292,7 +367,8 @@ void CTypedData<TValue>::set( const TPoint3D aPosition, const TValue newValue )
   else if ( ( this->getDimension < 3 && aPosition[2] != 0 )
     || aPosition[2] < 0 || aPosition[2] > extentVec[2] )
     throw( OutOfRangeException( SERROR( "Index out of range"), CException::RECOVER, ERR_BADCOORDS ) );
-  dataVec[aPosition[0] + aPosition[1] * extentVec[0] + aPosition[2] * extentVec[0] * extentVec[1]]
+  detach();
+  (*dataBlockSPtr)[aPosition[0] + aPosition[1] * strideArr[1] + aPosition[2] * strideArr[2]]
     = newValue;
   theDataRange.updateRange( newValue );
 }
@@ -331,77 +407,63 @@ void CTypedData<TValue>::adjustDataRange( const TValue theValue ) throw()
 }
 
 /**
+ * Elements which lie inside the old and the new extents are kept, all new elements
+ * are set to zero.
  * \param extentArr_ Array of new dataset extents
- * \param alignment Alignment of old data in the new dataset
+ * \param alignment Alignment of old data in the new dataset (not used yet)
  */
 template<typename TValue> inline
 void CTypedData<TValue>::resize( const size_t* extentArr_, const EDataAlign
 	alignment ) throw()
 {
-	size_t newArraySize = 1;
-  for ( unsigned short i = 0; i < usDimension; i++ )
-    newArraySize *= extentArr_[i];
-  newArraySize *= dataDimensionSize;	
-  std::vector<TValue> newDataVec( arraySize );
-	size_t maxExtent[usDimension];
-	for( size_t dims = 0; dims < dataDimensionSize; ++dims )
-	{
-		for ( unsigned short d = 0; d < usDimension; d++ )	
-		{
-			maxExtent[d] = std::min( extentArr_[d], extentVec[d] );
-		}
-		unsigned short maxW = 1;		
-		if ( usDimension > 3 ) maxW = maxExtent[3];
-		unsigned short maxZ = 1;		
-		if ( usDimension > 2 ) maxW = maxExtent[2];
-		unsigned short maxY = 1;		
-		if ( usDimension > 1 ) maxW = maxExtent[1];
-		unsigned short maxX = maxExtent[0];		
-		for( unsigned short w = 0; w < maxW; ++w )
-		 for( unsigned short z = 0; z < maxZ; ++z )
-		  for( unsigned short y = 0; y < maxY; ++y )
-		   for( unsigned short x = 0; x < maxX; ++x )
-			   newDataVec[ x + maxX * y + ( maxX * maxY ) * z + ( maxX * maxY * maxZ ) * w] 
-				 	= dataVec[ x + maxX * y + ( maxX * maxY ) * z + ( maxX * maxY * maxZ ) * w];
-	}
-	dataVec = newDataVec;
+	std::vector<size_t> newExtentVec( extentArr_, extentArr_ + usDimension );
+	resize( newExtentVec, alignment );
 }
 
 /**
+ * Elements which lie inside the old and the new extents are kept, all new elements
+ * are set to zero.
  * \param extentVec_ Vector of new dataset extents
- * \param alignment Alignment of old data in the new dataset
+ * \param alignment Alignment of old data in the new dataset (not used yet)
  */
 template<typename TValue> inline
 void CTypedData<TValue>::resize( const std::vector<size_t> extentVec_,
 	const EDataAlign alignment )	throw()
 {
+	size_t oldExtent[4] = { 1, 1, 1, 1 };
+	size_t newExtent[4] = { 1, 1, 1, 1 };
 	size_t newArraySize = 1;
   for ( unsigned short i = 0; i < usDimension; i++ )
-    newArraySize *= extentVec_[i];
-  newArraySize *= dataDimensionSize;	
-  std::vector<TValue> newDataVec( arraySize );
-	size_t maxExtent[usDimension];
-	for( size_t dims = 0; dims < dataDimensionSize; ++dims )
 	{
-		for ( unsigned short d = 0; d < usDimension; d++ )	
-		{
-			maxExtent[d] = std::min( extentVec_[d], extentVec[d] );
-		}
-		unsigned short maxW = 1;		
-		if ( usDimension > 3 ) maxW = maxExtent[3];
-		unsigned short maxZ = 1;		
-		if ( usDimension > 2 ) maxW = maxExtent[2];
-		unsigned short maxY = 1;		
-		if ( usDimension > 1 ) maxW = maxExtent[1];
-		unsigned short maxX = maxExtent[0];		
-		for( unsigned short w = 0; w < maxW; ++w )
-		 for( unsigned short z = 0; z < maxZ; ++z )
-		  for( unsigned short y = 0; y < maxY; ++y )
-		   for( unsigned short x = 0; x < maxX; ++x )
-			   newDataVec[ x + maxX * y + ( maxX * maxY ) * z + ( maxX * maxY * maxZ ) * w] 
-				 	= dataVec[ x + maxX * y + ( maxX * maxY ) * z + ( maxX * maxY * maxZ ) * w];
+		oldExtent[i] = extentVec[i];
+		newExtent[i] = extentVec_[i];
+    newArraySize *= extentVec_[i];
 	}
-	dataVec = newDataVec;
+  newArraySize *= dataDimensionSize;
+	boost::shared_ptr<CDataBlock<TValue> > newDataBlockSPtr( new CDataBlock<TValue>( newArraySize ) );
+	size_t maxX = std::min( oldExtent[0], newExtent[0] );
+	size_t maxY = std::min( oldExtent[1], newExtent[1] );
+	size_t maxZ = std::min( oldExtent[2], newExtent[2] );
+	size_t maxW = std::min( oldExtent[3], newExtent[3] );
+	size_t oldChannelSize = oldExtent[0] * oldExtent[1] * oldExtent[2] * oldExtent[3];
+	size_t newChannelSize = newExtent[0] * newExtent[1] * newExtent[2] * newExtent[3];
+	for( size_t c = 0; c < dataDimensionSize; ++c )
+		for( size_t w = 0; w < maxW; ++w )
+		 for( size_t z = 0; z < maxZ; ++z )
+		  for( size_t y = 0; y < maxY; ++y )
+			{
+				const TValue* srcPtr = dataBlockSPtr->getData() + c * oldChannelSize
+					+ oldExtent[0] * ( y + oldExtent[1] * ( z + oldExtent[2] * w ) );
+				TValue* dstPtr = newDataBlockSPtr->getData() + c * newChannelSize
+					+ newExtent[0] * ( y + newExtent[1] * ( z + newExtent[2] * w ) );
+				std::copy( srcPtr, srcPtr + maxX, dstPtr );
+			}
+	dataBlockSPtr.swap( newDataBlockSPtr );
+	bShared = false;
+	for ( unsigned short i = 0; i < usDimension; i++ )
+		extentVec[i] = extentVec_[i];
+	arraySize = newArraySize;
+	updateStrides();
 }
 	
 /**
@@ -412,11 +474,19 @@ void CTypedData<TValue>::increaseDataDimension( const size_t addToDataDimension
 {
 	if ( addToDataDimension == 0 ) 
 		return;
-	unsigned long dimensionSize = 1;
+	size_t dimensionSize = 1;
 	for( unsigned int i = 0; i < usDimension; ++i )
 		dimensionSize *= getExtent( i );
 	dataDimensionSize += addToDataDimension;
-	dataVec.resize( dimensionSize * dataDimensionSize );
+	extentVec[usDimension] = dataDimensionSize;
+	boost::shared_ptr<CDataBlock<TValue> > newDataBlockSPtr(
+		new CDataBlock<TValue>( dimensionSize * dataDimensionSize ) );
+	std::copy( dataBlockSPtr->getData(), dataBlockSPtr->getData() + arraySize,
+		newDataBlockSPtr->getData() );
+	dataBlockSPtr.swap( newDataBlockSPtr );
+	bShared = false;
+	arraySize = dimensionSize * dataDimensionSize;
+	updateStrides();
 }
 
 /**
@@ -425,23 +495,21 @@ void CTypedData<TValue>::increaseDataDimension( const size_t addToDataDimension
 template<typename TValue> inline
 void CTypedData<TValue>::decreaseDataDimension( const size_t subFromDataDimension ) throw()
 {
-	typedef typename std::vector<TValue>::iterator localIterator;
-	
 	if ( subFromDataDimension == 0 ) 
 		return;
-	unsigned long dimensionSize = 1;
+	size_t dimensionSize = 1;
 	for( unsigned int i = 0; i < usDimension; ++i )
 		dimensionSize *= getExtent( i );
 	dataDimensionSize -= subFromDataDimension;	
-	std::vector<TValue> newDataVec( dimensionSize * dataDimensionSize );
-	localIterator newIt = newDataVec.begin();
-	localIterator oldIt = dataVec.begin();
-	while( newIt != newDataVec.end() )
-	{
-		*newIt = *oldIt;
-		++newIt; ++oldIt;
-	}
-	dataVec = newDataVec;
+	extentVec[usDimension] = dataDimensionSize;
+	boost::shared_ptr<CDataBlock<TValue> > newDataBlockSPtr(
+		new CDataBlock<TValue>( dimensionSize * dataDimensionSize, false ) );
+	std::copy( dataBlockSPtr->getData(), dataBlockSPtr->getData() + newDataBlockSPtr->getSize(),
+		newDataBlockSPtr->getData() );
+	dataBlockSPtr.swap( newDataBlockSPtr );
+	bShared = false;
+	arraySize = dimensionSize * dataDimensionSize;
+	updateStrides();
 }
 
 /********************
@@ -450,153 +518,151 @@ void CTypedData<TValue>::decreaseDataDimension( const size_t subFromDataDimensio
 
 /**
  * Access operator for 1D-fields. No range checking is done.
- * \param usX index of element
+ * \param x index of element
  * \returns a reference to the indexed element
  */
 template<typename TValue> inline
-TValue& CTypedData<TValue>::operator()( const unsigned short usX ) throw()
+TValue& CTypedData<TValue>::operator()( const size_t x ) throw()
 {
-  return dataVec[usX];
+  return (*dataBlockSPtr)[x];
 }
 
 /**
  * Access operator for 2D-fields. No range checking is done.
- * \param usX x-coordinate of element
- * \param usY y-coordinate of element
+ * \param x x-coordinate of element
+ * \param y y-coordinate of element
  * \returns a reference to the indexed element
  */
 template<typename TValue> inline
-TValue& CTypedData<TValue>::operator()( const unsigned short usX, const unsigned short usY ) throw()
+TValue& CTypedData<TValue>::operator()( const size_t x, const size_t y ) throw()
 {
-  return dataVec[usX + usY * extentVec[0]];
+  return (*dataBlockSPtr)[x + y * strideArr[1]];
 }
 
 /**
  * Access operator for 3D-fields. No range checking is done.
- * \param usX x-coordinate of element
- * \param usY y-coordinate of element
- * \param usZ z-coordinate of element
+ * \param x x-coordinate of element
+ * \param y y-coordinate of element
+ * \param z z-coordinate of element
  * \returns a reference to the indexed element
  */
 template<typename TValue> inline
-TValue& CTypedData<TValue>::operator()( const unsigned short usX, const unsigned short usY,
-	const unsigned short usZ ) throw()
+TValue& CTypedData<TValue>::operator()( const size_t x, const size_t y,
+	const size_t z ) throw()
 {
-  return dataVec[usX + usY * extentVec[0] + usZ * extentVec[0] * extentVec[1]];
+  return (*dataBlockSPtr)[x + y * strideArr[1] + z * strideArr[2]];
 }
 
 /**
  * Access operator for 4D-fields. No range checking is done.
- * \param usX x-coordinate of element
- * \param usY y-coordinate of element
- * \param usZ z-coordinate of element
- * \param usW w-coordinate of element
+ * \param x x-coordinate of element
+ * \param y y-coordinate of element
+ * \param z z-coordinate of element
+ * \param w w-coordinate of element
  * \returns a reference to the indexed element
  */
 template<typename TValue> inline
-TValue& CTypedData<TValue>::operator()( const unsigned short usX, const unsigned short usY,
-	const unsigned short usZ, const unsigned short usW ) throw()
+TValue& CTypedData<TValue>::operator()( const size_t x, const size_t y,
+	const size_t z, const size_t w ) throw()
 {
-  return dataVec[usX + usY * extentVec[0] + usZ * extentVec[0] * extentVec[1]
-    + usW * extentVec[0] * extentVec[1] * extentVec[2]];
+  return (*dataBlockSPtr)[x + y * strideArr[1] + z * strideArr[2] + w * strideArr[3]];
 }
 
 /**
  * Access operator for 1D-fields. No range checking is done. Constant version.
- * \param usX x-coordinate of element
+ * \param x x-coordinate of element
  * \returns a reference to the indexed element
  */
 template<typename TValue> inline
-const TValue& CTypedData<TValue>::operator()( const unsigned short usX ) const throw()
+const TValue& CTypedData<TValue>::operator()( const size_t x ) const throw()
 {
-  return dataVec[usX];
+  return (*dataBlockSPtr)[x];
 }
 
 /**
  * Access operator for 2D-fields. No range checking is done. Constant version.
- * \param usX x-coordinate of element
- * \param usY y-coordinate of element
+ * \param x x-coordinate of element
+ * \param y y-coordinate of element
  * \returns a reference to the indexed element
  */
 template<typename TValue> inline
-const TValue& CTypedData<TValue>::operator()( const unsigned short usX, const unsigned short usY )
+const TValue& CTypedData<TValue>::operator()( const size_t x, const size_t y )
 	const throw()
 {
-  return dataVec[usX + usY * extentVec[0]];
+  return (*dataBlockSPtr)[x + y * strideArr[1]];
 }
 
 /**
  * Access operator for 3D-fields. No range checking is done. Constant version.
- * \param usX x-coordinate of element
- * \param usY y-coordinate of element
- * \param usZ z-coordinate of element
+ * \param x x-coordinate of element
+ * \param y y-coordinate of element
+ * \param z z-coordinate of element
  * \returns a reference to the indexed element
  */
 template<typename TValue> inline
-const TValue& CTypedData<TValue>::operator()( const unsigned short usX, const unsigned short usY,
-	const unsigned short usZ ) const throw()
+const TValue& CTypedData<TValue>::operator()( const size_t x, const size_t y,
+	const size_t z ) const throw()
 {
-  return dataVec[usX + usY * extentVec[0] + usZ * extentVec[0] * extentVec[1]];
+  return (*dataBlockSPtr)[x + y * strideArr[1] + z * strideArr[2]];
 }
 
 /**
  * Access operator for 4D-fields. No range checking is done. Constant version.
- * \param usX x-coordinate of element
- * \param usY y-coordinate of element
- * \param usZ z-coordinate of element
- * \param usW w-coordinate of element
+ * \param x x-coordinate of element
+ * \param y y-coordinate of element
+ * \param z z-coordinate of element
+ * \param w w-coordinate of element
  * \returns a reference to the indexed element
  */
 template<typename TValue> inline
-const TValue& CTypedData<TValue>::operator()( const unsigned short usX, const unsigned short usY,
-	const unsigned short usZ, const unsigned short usW ) const throw()
+const TValue& CTypedData<TValue>::operator()( const size_t x, const size_t y,
+	const size_t z, const size_t w ) const throw()
 {
-  return dataVec[usX + usY * extentVec[0] + usZ * extentVec[0] * extentVec[1]
-    + usW * extentVec[0] * extentVec[1] * extentVec[2]];
+  return (*dataBlockSPtr)[x + y * strideArr[1] + z * strideArr[2] + w * strideArr[3]];
 }
 
-/** \param ulIndex index to retrieve */
+/** \param index index to retrieve */
 template<typename TValue> inline
-TValue& CTypedData<TValue>::operator[]( const unsigned long ulIndex ) throw()
+TValue& CTypedData<TValue>::operator[]( const size_t index ) throw()
 {
-	return dataVec[ ulIndex ];
+	return (*dataBlockSPtr)[ index ];
 }
 
 /** \param aPosition spatial coordinates of element to retrieve */
 template<typename TValue> inline
 TValue& CTypedData<TValue>::operator[]( const TPoint2D aPosition ) throw()
 {
-  return dataVec[ aPosition[0] + aPosition[1] * extentVec[0] ];
+  return (*dataBlockSPtr)[ aPosition[0] + aPosition[1] * strideArr[1] ];
 }
   
 /** \param aPosition spatial coordinates of element to retrieve */
 template<typename TValue> inline
 TValue& CTypedData<TValue>::operator[]( const TPoint3D aPosition ) throw()
 {
-  return dataVec[ aPosition[0] + aPosition[1] * extentVec[0]
-    + aPosition[2] * extentVec[0] * extentVec[1] ];
+  return (*dataBlockSPtr)[ aPosition[0] + aPosition[1] * strideArr[1]
+    + aPosition[2] * strideArr[2] ];
 }
 
-/** \param ulIndex index to retrieve */
+/** \param index index to retrieve */
 template<typename TValue> inline
-const TValue& CTypedData<TValue>::operator[]( const unsigned long ulIndex ) const throw()
+const TValue& CTypedData<TValue>::operator[]( const size_t index ) const throw()
 {
-	return dataVec[ ulIndex ];
+	return (*dataBlockSPtr)[ index ];
 }		
 
 /** \param aPosition spatial coordinates of element to retrieve */
 template<typename TValue> inline
 const TValue& CTypedData<TValue>::operator[]( const TPoint2D aPosition ) const throw()
 {
-  return dataVec[ aPosition[0] + aPosition[1] * extentVec[0] ];
+  return (*dataBlockSPtr)[ aPosition[0] + aPosition[1] * strideArr[1] ];
 }   
 
 /** \param aPosition spatial coordinates of element to retrieve */
 template<typename TValue> inline
 const TValue& CTypedData<TValue>::operator[]( const TPoint3D aPosition ) const throw()
 {
-  return dataVec[ aPosition[0] + aPosition[1] * extentVec[0]
-    + aPosition[2] * extentVec[0] * extentVec[1] ];
+  return (*dataBlockSPtr)[ aPosition[0] + aPosition[1] * strideArr[1]
+    + aPosition[2] * strideArr[2] ];
 }   
 
 /*****************
@@ -606,11 +672,69 @@ const TValue& CTypedData<TValue>::operator[]( const TPoint3D aPosition ) const t
 template<typename TValue> const std::string CTypedData<TValue>::dump() const throw()
 {
   std::ostringstream os;
-  os << "ulArraySize: " << arraySize << " dataVec ptr : " << &dataVec 
-    << std::endl;
+  os << "ulArraySize: " << arraySize << " data ptr : " << dataBlockSPtr->getData() 
+    << " shared : " << isShared() << std::endl;
   return CDataSet::dump() + os.str();
 }
 
+/**
+ * The copy shares the data block of this data set until it is modified.
+ * \returns a new copy-on-write copy of the data set
+ */
+template<typename TValue> CDataSet* CTypedData<TValue>::clone() const throw()
+{
+  return new CTypedData<TValue>( *this, true );
+}
+
+/**
+ * The region keeps the data range and base element dimensions of this data set.
+ * Its origin is moved to the first voxel of the region.
+ * \param regionOriginVec first voxel of the region
+ * \param regionExtentVec extents of the region
+ * \returns a new data set holding the region or NULL if the region exceeds the data set
+ */
+template<typename TValue> CDataSet* CTypedData<TValue>::cloneRegion(
+  const std::vector<size_t>& regionOriginVec, const std::vector<size_t>& regionExtentVec ) const throw()
+{
+  if ( !isRegionValid( regionOriginVec, regionExtentVec ) )
+    return NULL;
+  CTypedData<TValue>* regionPtr = new CTypedData<TValue>( usDimension, regionExtentVec,
+    dataDimensionSize, DataInitNone );
+  regionPtr->theDataRange = theDataRange;
+  for( unsigned short i = 0; i < usDimension; ++i )
+  {
+    regionPtr->baseElementDimensionsVec[i] = baseElementDimensionsVec[i];
+    regionPtr->originVec[i] = originVec[i] + regionOriginVec[i] * baseElementDimensionsVec[i];
+  }
+  copyRegion( *this, regionOriginVec, *regionPtr, std::vector<size_t>( usDimension, 0 ),
+    regionExtentVec );
+  return regionPtr;
+}
+
+/**
+ * aRegion must be a CTypedData<TValue> with the dimension and data dimension of this
+ * data set. The data range is left untouched.
+ * \param aRegion data set to copy
+ * \param regionOriginVec position of the first voxel of aRegion in this data set
+ * \returns true if the data was copied
+ */
+template<typename TValue> bool CTypedData<TValue>::insertRegion( const CDataSet& aRegion,
+  const std::vector<size_t>& regionOriginVec ) throw()
+{
+  const CTypedData<TValue>* regionPtr = dynamic_cast<const CTypedData<TValue>*>( &aRegion );
+  if ( regionPtr == NULL || regionPtr->usDimension != usDimension
+    || regionPtr->dataDimensionSize != dataDimensionSize )
+    return false;
+  std::vector<size_t> regionExtentVec( usDimension );
+  for( unsigned short i = 0; i < usDimension; ++i )
+    regionExtentVec[i] = regionPtr->extentVec[i];
+  if ( !isRegionValid( regionOriginVec, regionExtentVec ) )
+    return false;
+  copyRegion( *regionPtr, std::vector<size_t>( usDimension, 0 ), *this, regionOriginVec,
+    regionExtentVec );
+  return true;
+}
+
 /**
  * \param aDataSet the other data set
  */
@@ -621,10 +745,133 @@ void CTypedData<TValue>::swap( CTypedData<TValue>& aDataSet ) throw()
 // 	std::swap( theMaximum, aDataSet.theMaximum );
 	std::swap( theDataRange, aDataSet.theDataRange );
 	std::swap( arraySize, aDataSet.arraySize );
-	dataVec.swap( aDataSet.dataVec );
+	dataBlockSPtr.swap( aDataSet.dataBlockSPtr );
+	std::swap( bShared, aDataSet.bShared );
 	std::swap( usDimension, aDataSet.usDimension );
   extentVec.swap( aDataSet.extentVec ); 
   std::swap( dataDimensionSize, aDataSet.dataDimensionSize );
+  std::swap_ranges( strideArr, strideArr + 4, aDataSet.strideArr );
+}
+
+/**
+ * After this call, the data set has the same extents and values as aDataSet, but
+ * no data is copied until the first non-const access to one of both data sets.
+ * aDataSet is marked as shared too, so writing to it never changes this data set.
+ * \param aDataSet the data set to share the data block with
+ */
+template<typename TValue>
+void CTypedData<TValue>::share( const CTypedData<TValue>& aDataSet ) throw()
+{
+	if ( &aDataSet == this )
+		return;
+	usDimension = aDataSet.usDimension;
+	dataDimensionSize = aDataSet.dataDimensionSize;
+	extentVec = aDataSet.extentVec;
+	baseElementDimensionsVec = aDataSet.baseElementDimensionsVec;
+	originVec = aDataSet.originVec;
+	theDataRange = aDataSet.theDataRange;
+	arraySize = aDataSet.arraySize;
+	std::copy( aDataSet.strideArr, aDataSet.strideArr + 4, strideArr );
+	dataBlockSPtr = aDataSet.dataBlockSPtr;
+	bShared = true;
+	aDataSet.bShared = true;
+}
+
+/**
+ * Call this once before writing to the data array through the access operators
+ * or through pointers obtained from const methods. getArray(), getVoidArray(),
+ * set(), begin(), end() and moveTo() call this automatically.
+ * The call isn't thread safe, so detach a data set before several threads
+ * write to it. The shared flag is cleared as soon as the data block isn't
+ * shared anymore, so later calls only test the flag.
+ */
+template<typename TValue> inline
+void CTypedData<TValue>::detach() throw()
+{
+	if ( bShared )
+		copyOnWrite();
+}
+
+/*******************
+ * Private methods *
+ *******************/
+
+/**
+ * \param regionOriginVec first voxel of the region
+ * \param regionExtentVec extents of the region
+ * \returns true if the region is not empty and lies inside the data set
+ */
+template<typename TValue>
+bool CTypedData<TValue>::isRegionValid( const std::vector<size_t>& regionOriginVec,
+	const std::vector<size_t>& regionExtentVec ) const throw()
+{
+	if ( usDimension > 4 || arraySize == 0 || regionOriginVec.size() != usDimension
+		|| regionExtentVec.size() != usDimension )
+		return false;
+	for( unsigned short i = 0; i < usDimension; ++i )
+		if ( regionExtentVec[i] == 0 || regionOriginVec[i] + regionExtentVec[i] > extentVec[i] )
+			return false;
+	return true;
+}
+
+/**
+ * Both data sets must have the same dimension and data dimension. The region is
+ * copied line by line for all channels.
+ * \param source data set to copy from
+ * \param sourceOriginVec first voxel of the region in source
+ * \param target data set to copy to
+ * \param targetOriginVec first voxel of the region in target
+ * \param regionExtentVec extents of the region
+ */
+template<typename TValue>
+void CTypedData<TValue>::copyRegion( const CTypedData<TValue>& source,
+	const std::vector<size_t>& sourceOriginVec, CTypedData<TValue>& target,
+	const std::vector<size_t>& targetOriginVec, const std::vector<size_t>& regionExtentVec ) throw()
+{
+	size_t linesPerChannel = 1;
+	for( unsigned short d = 1; d < source.usDimension; ++d )
+		linesPerChannel *= regionExtentVec[d];
+	const size_t sourceChannelSize = source.arraySize / source.dataDimensionSize;
+	const size_t targetChannelSize = target.arraySize / target.dataDimensionSize;
+	target.detach();
+	const TValue* sourcePtr = source.dataBlockSPtr->getData();
+	TValue* targetPtr = target.dataBlockSPtr->getData();
+	for( size_t c = 0; c < source.dataDimensionSize; ++c )
+		for( size_t line = 0; line < linesPerChannel; ++line )
+		{
+			size_t sourceIndex = c * sourceChannelSize + sourceOriginVec[0];
+			size_t targetIndex = c * targetChannelSize + targetOriginVec[0];
+			size_t remainder = line;
+			for( unsigned short d = 1; d < source.usDimension; ++d )
+			{
+				const size_t position = remainder % regionExtentVec[d];
+				remainder /= regionExtentVec[d];
+				sourceIndex += ( sourceOriginVec[d] + position ) * source.strideArr[d];
+				targetIndex += ( targetOriginVec[d] + position ) * target.strideArr[d];
+			}
+			std::copy( sourcePtr + sourceIndex, sourcePtr + sourceIndex + regionExtentVec[0],
+				targetPtr + targetIndex );
+		}
+}
+
+/**
+ * Recomputes the strides from the extents. Needs to be called whenever
+ * the extents change.
+ */
+template<typename TValue> inline
+void CTypedData<TValue>::updateStrides() throw()
+{
+	strideArr[0] = 1;
+	for( unsigned short i = 1; i < 4; ++i )
+		strideArr[i] = strideArr[i - 1] * ( i - 1u < extentVec.size() ? extentVec[i - 1] : 1 );
+}
+
+template<typename TValue>
+void CTypedData<TValue>::copyOnWrite() throw()
+{
+	if ( !dataBlockSPtr.unique() )
+		dataBlockSPtr.reset( new CDataBlock<TValue>( *dataBlockSPtr ) );
+	bShared = false;
 }
 
 /*********************************
@@ -639,14 +886,16 @@ void CTypedData<TValue>::swap( CTypedData<TValue>& aDataSet ) throw()
 template<typename TValue> inline
 typename CTypedData<TValue>::iterator CTypedData<TValue>::begin() throw()
 {
-  return ( iterator( &dataVec[0], this ) );
+  detach();
+  return ( iterator( dataBlockSPtr->getData(), this ) );
 }
 
 /** \returns iterator for end of array */
 template<typename TValue> inline
 typename CTypedData<TValue>::iterator CTypedData<TValue>::end() throw()
 {
-  return ( iterator( &dataVec[0]+arraySize, this ) );
+  detach();
+  return ( iterator( dataBlockSPtr->getData() + arraySize, this ) );
 }
 
 /** \returns reverse iterator for begin of array */
@@ -665,51 +914,54 @@ typename CTypedData<TValue>::reverse_iterator CTypedData<TValue>::rend() throw()
 
 /** 
  * \returns an iterator to the given position 
- * \param usX position in 1D - dataset
+ * \param x position in 1D - dataset
  */
 template<typename TValue> inline
-typename CTypedData<TValue>::iterator CTypedData<TValue>::moveTo( const unsigned short usX ) throw()
+typename CTypedData<TValue>::iterator CTypedData<TValue>::moveTo( const size_t x ) throw()
 {
-	return iterator( &dataVec[usX], this );
+	detach();
+	return iterator( &(*dataBlockSPtr)[x], this );
 }
 	
 /** 
  * \returns an iterator to the given position 
- * \param usX position in 1D - dataset
- * \param usY position in 1D - dataset
+ * \param x position in 1D - dataset
+ * \param y position in 1D - dataset
  */
 template<typename TValue> inline
-typename CTypedData<TValue>::iterator CTypedData<TValue>::moveTo( const unsigned short usX,
-	const unsigned short usY ) throw()
+typename CTypedData<TValue>::iterator CTypedData<TValue>::moveTo( const size_t x,
+	const size_t y ) throw()
 {
-	return iterator( &dataVec[usX+usY*extentVec[0]], this );
+	detach();
+	return iterator( &(*dataBlockSPtr)[x + y * strideArr[1]], this );
 }
 	
 /** 
  * \returns an iterator to the given position 
- * \param usX position in 1D - dataset
- * \param usY position in 1D - dataset
- * \param usZ position in 1D - dataset
+ * \param x position in 1D - dataset
+ * \param y position in 1D - dataset
+ * \param z position in 1D - dataset
  */
 template<typename TValue> inline
-typename CTypedData<TValue>::iterator CTypedData<TValue>::moveTo( const unsigned short usX,
-	const unsigned short usY,	const unsigned short usZ ) throw()
+typename CTypedData<TValue>::iterator CTypedData<TValue>::moveTo( const size_t x,
+	const size_t y,	const size_t z ) throw()
 {
-	return iterator( &dataVec[usX+usY*extentVec[0]+usZ*extentVec[0]*extentVec[1]], this );
+	detach();
+	return iterator( &(*dataBlockSPtr)[x + y * strideArr[1] + z * strideArr[2]], this );
 }
 	
 /** 
  * \returns an iterator to the given position 
- * \param usX position in 1D - dataset
- * \param usY position in 1D - dataset
- * \param usZ position in 1D - dataset
- * \param usW position in 1D - dataset
+ * \param x position in 1D - dataset
+ * \param y position in 1D - dataset
+ * \param z position in 1D - dataset
+ * \param w position in 1D - dataset
  */
 template<typename TValue> inline
-typename CTypedData<TValue>::iterator CTypedData<TValue>::moveTo( const unsigned short usX,
-	const unsigned short usY,	const unsigned short usZ, const unsigned short usW ) throw()
+typename CTypedData<TValue>::iterator CTypedData<TValue>::moveTo( const size_t x,
+	const size_t y,	const size_t z, const size_t w ) throw()
 {
-	return iterator( &dataVec[usX+usY*extentVec[0]+usZ*extentVec[0]*extentVec[1]
-		+usW*extentVec[0]*extentVec[1]*extentVec[2]], this );
+	detach();
+	return iterator( &(*dataBlockSPtr)[x + y * strideArr[1] + z * strideArr[2] + w * strideArr[3]], this );
 }
 
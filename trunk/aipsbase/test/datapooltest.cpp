@@ -0,0 +1,135 @@
+/************************************************************************
+ * File: datapooltest.cpp                                               *
+ * Project: AIPS                                                        *
+ * Description: Checks that pipeline reruns reuse pooled data blocks    *
+ *                                                                      *
+ * Author: Hendrik Belitz (hbelitz@users.berlios.de)                    *
+ *                                                                      *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+/**
+ * Runs a source -> filter -> target pipeline with 512x512x64 volumes of 16 bit
+ * voxels twice. The second run must take its large outputs from the blocks the
+ * first run released to the CDataPool instead of allocating new ones.
+ *
+ * Usage: datapooltest (returns 0 on success)
+ */
+
+// Standard includes
+#include <cstdlib>
+#include <iostream>
+
+// AIPS includes
+#include <cdatapool.h>
+#include <csource.h>
+#include <cfilter.h>
+#include <ctarget.h>
+
+using namespace std;
+using namespace boost;
+using namespace aips;
+
+namespace
+{
+
+const size_t extentArr[] = { 512, 512, 64 };
+
+/// Creates a volume with a ramp
+class CRampSource : public CSource
+{
+public:
+	CRampSource( unsigned long ulID = 0 ) throw() : CSource( ulID ) {}
+	NEW_INSTANCE( CRampSource );
+	virtual void apply() throw()
+	{
+		TImagePtr outputPtr( new TImage( 3, extentArr ) );
+		for( size_t i = 0; i < outputPtr->getArraySize(); ++i )
+			( *outputPtr )[i] = static_cast<short>( i % 1000 );
+		setOutput( outputPtr );
+	}
+};
+
+/// Adds one to each voxel, writing a new volume
+class CIncrementFilter : public CFilter
+{
+public:
+	CIncrementFilter( unsigned long ulID = 0 ) throw() : CFilter( ulID ) {}
+	NEW_INSTANCE( CIncrementFilter );
+	virtual void apply() throw()
+	{
+		TImagePtr inputPtr = static_pointer_cast<TImage>( getInput() );
+		if ( !inputPtr )
+			return;
+		TImagePtr outputPtr( new TImage( 3, extentArr, 1, TImage::DataInitNone ) );
+		for( size_t i = 0; i < inputPtr->getArraySize(); ++i )
+			( *outputPtr )[i] = ( *inputPtr )[i] + 1;
+		setOutput( outputPtr );
+	}
+};
+
+/// Checks the result without keeping it
+class CCheckTarget : public CTarget
+{
+public:
+	bool bCorrect;
+	CCheckTarget( unsigned long ulID = 0 ) throw() : CTarget( ulID ), bCorrect( false ) {}
+	~CCheckTarget() throw() {}
+	NEW_INSTANCE( CCheckTarget );
+	virtual void apply() throw()
+	{
+		TImagePtr inputPtr = static_pointer_cast<TImage>( getInput() );
+		bCorrect = inputPtr && inputPtr->getArraySize() == extentArr[0] * extentArr[1] * extentArr[2];
+		for( size_t i = 0; bCorrect && i < inputPtr->getArraySize(); ++i )
+			bCorrect = ( ( *inputPtr )[i] == static_cast<short>( i % 1000 + 1 ) );
+	}
+};
+
+}
+
+int main()
+{
+	const size_t outputBytes = extentArr[0] * extentArr[1] * extentArr[2] * sizeof( short );
+	if ( getDataPool().getMaximumCachedBytes() < outputBytes )
+	{
+		cerr << "The data pool limit of " << getDataPool().getMaximumCachedBytes()
+			<< " bytes cannot hold a single output of " << outputBytes << " bytes" << endl;
+		return EXIT_FAILURE;
+	}
+	shared_ptr<CRampSource> sourcePtr( new CRampSource( 1 ) );
+	shared_ptr<CIncrementFilter> filterPtr( new CIncrementFilter( 2 ) );
+	shared_ptr<CCheckTarget> targetPtr( new CCheckTarget( 3 ) );
+	filterPtr->addConnection( sourcePtr );
+	targetPtr->addConnection( filterPtr );
+
+	targetPtr->update();
+	if ( !targetPtr->bCorrect )
+	{
+		cerr << "First run computed wrong results" << endl;
+		return EXIT_FAILURE;
+	}
+	const size_t firstRunBytes = getDataPool().getReusedBytes();
+
+	sourcePtr->forceRecomputation();
+	targetPtr->bCorrect = false;
+	targetPtr->update();
+	if ( !targetPtr->bCorrect )
+	{
+		cerr << "Second run computed wrong results" << endl;
+		return EXIT_FAILURE;
+	}
+	const size_t secondRunBytes = getDataPool().getReusedBytes() - firstRunBytes;
+	cout << "Second run took " << secondRunBytes << " bytes from the data pool" << endl;
+	if ( secondRunBytes < outputBytes )
+	{
+		cerr << "The outputs of the second run were not taken from the data pool" << endl
+			<< getDataPool().dump();
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -75,15 +75,40 @@ TDataFile CAnalyzeHandler::load( const std::string& sFilename ) const
       	CException::RECOVER, ERR_FILEACCESS ) );
   }
 	EDataType dataType = this->getDataType( aHeader->getVoxelType() );
+	
+	// Uncompressed files in native layout are mapped instead of read if they
+	// are already in AIPS orientation. Flipping or rotating a mapped file would
+	// copy every voxel, so the stream loader is used for all other orientations.
+	// Integer images take their data range from glmin/glmax if the header sets
+	// it. Otherwise the range is computed in one pass over the mapping.
+	const bool bFloatData = ( dataType == DFloat32 || dataType == DFloat16 );
+	const unsigned long ulOrientation = aHeader->getUnsignedLong( "Orientation" );
+	bool bAIPSOrientation;
+	if ( bFloatData )
+		bAIPSOrientation = ( ulOrientation == 0 || ulOrientation > 5 );
+	else
+		bAIPSOrientation = ( ulOrientation == 3 || ulOrientation > 5 );
+	const bool bHeaderRange = !bFloatData
+		&& aHeader->getLong( "MaxIntensity" ) > aHeader->getLong( "MinIntensity" );
+	TDataSetPtr mappedSetPtr;
+	if ( !bCompressed && bAIPSOrientation )
+		mappedSetPtr = mapData( sDataFilename, extentSize, dataType, aHeader->getEndianess(), 0,
+			!bHeaderRange );
 		
-	if ( dataType == DFloat32 || dataType == DFloat16 )
+	if ( bFloatData )
 	{
 		alog << LINFO << " Datatype is Float" << endl;
-		TFieldPtr aFieldSet( new TField( extentSize.size(), extentSize, 1 ) );
-		if ( bCompressed )
-  		loadData( aFieldSet, theGzFile, dataType, aHeader->getEndianess() );
+		TFieldPtr aFieldSet;
+		if ( mappedSetPtr )
+			aFieldSet = static_pointer_cast<TField>( mappedSetPtr );
 		else
-			loadData( aFieldSet, theFile, dataType, aHeader->getEndianess() );
+		{
+			aFieldSet.reset( new TField( extentSize.size(), extentSize, 1 ) );
+			if ( bCompressed )
+  			loadData( aFieldSet, theGzFile, dataType, aHeader->getEndianess() );
+			else
+				loadData( aFieldSet, theFile, dataType, aHeader->getEndianess() );
+		}
 		alog << LINFO << " Loaded" << endl;
 		switch( aHeader->getUnsignedLong( "Orientation" ) )
 		{
@@ -114,16 +139,27 @@ TDataFile CAnalyzeHandler::load( const std::string& sFilename ) const
 	else
 	{
 		alog << LINFO << " Datatype is Int" << endl;		
-		TImagePtr anImageSet( new TImage( extentSize.size(), extentSize, 1 ) );
-		if ( bCompressed )
+		TImagePtr anImageSet;
+		if ( mappedSetPtr )
 		{
-  		loadData( anImageSet, theGzFile, dataType, aHeader->getEndianess() );
-			theGzFile.close();
+			anImageSet = static_pointer_cast<TImage>( mappedSetPtr );
+			if ( bHeaderRange )
+				anImageSet->setDataRange( aHeader->getLong( "MinIntensity" ), aHeader->getLong( "MaxIntensity" ) );
+			theFile.close();
 		}
 		else
 		{
-			loadData( anImageSet, theFile, dataType, aHeader->getEndianess() );
-			theFile.close();
+			anImageSet.reset( new TImage( extentSize.size(), extentSize, 1 ) );
+			if ( bCompressed )
+			{
+  			loadData( anImageSet, theGzFile, dataType, aHeader->getEndianess() );
+				theGzFile.close();
+			}
+			else
+			{
+				loadData( anImageSet, theFile, dataType, aHeader->getEndianess() );
+				theFile.close();
+			}
 		}
 		alog << LINFO << " Loaded with ori " << aHeader->getUnsignedLong( "Orientation" ) << endl;
 		TImagePtr tmp;
@@ -248,6 +284,214 @@ void CAnalyzeHandler::save( const std::string& sFilename, const TDataFile& theDa
 	}
 }
 
+/**
+ * The extents are read from the header. Only files which need a rotation are
+ * loaded completely.
+ * \param sFilename Filename of file to load
+ * \returns the extents of the dataset as load() would return it
+ * \throws FileException if the header cannot be read
+ */
+vector<size_t> CAnalyzeHandler::loadExtents( const std::string& sFilename ) const
+	throw( FileException )
+{
+	shared_ptr<CAnalyzeHeader> aHeader = loadHeader( sFilename );
+	vector<bool> flipVec;
+	if ( !getFileFlips( *aHeader, flipVec ) )
+		return CFileHandler::loadExtents( sFilename );
+	return aHeader->getExtents();
+}
+
+/**
+ * Slabs along the last dimension of uncompressed files which don't need a rotation
+ * are read directly from the img file. All other regions are copied from the
+ * completely loaded dataset.
+ * \param sFilename Filename of file to load
+ * \param regionOriginVec first voxel of the region
+ * \param regionExtentVec extents of the region
+ * \returns a dataset holding the region
+ * \throws FileException if the file cannot be loaded or the region exceeds the dataset
+ */
+TDataSetPtr CAnalyzeHandler::loadRegion( const std::string& sFilename,
+	const std::vector<size_t>& regionOriginVec, const std::vector<size_t>& regionExtentVec ) const
+	throw( FileException )
+{
+	shared_ptr<CAnalyzeHeader> aHeader = loadHeader( sFilename );
+	vector<size_t> extentSize = aHeader->getExtents();
+	vector<bool> flipVec;
+	if ( !getFileFlips( *aHeader, flipVec ) || !isSlab( extentSize, regionOriginVec, regionExtentVec ) )
+		return CFileHandler::loadRegion( sFilename, regionOriginVec, regionExtentVec );
+
+	std::string sDataFilename( sFilename, 0, sFilename.size() - 3 );
+	sDataFilename += "img";
+	std::ifstream theFile( sDataFilename.c_str(), ios::in | ios::binary );
+	if ( !theFile.is_open() )
+		return CFileHandler::loadRegion( sFilename, regionOriginVec, regionExtentVec );
+
+	EDataType dataType = getDataType( aHeader->getVoxelType() );
+	TDataSetPtr theRegionPtr;
+	if ( dataType == DFloat32 || dataType == DFloat16 )
+		theRegionPtr.reset( new TField( regionExtentVec.size(), regionExtentVec, 1 ) );
+	else
+		theRegionPtr.reset( new TImage( regionExtentVec.size(), regionExtentVec, 1 ) );
+	try
+	{
+		loadSlab( theRegionPtr, theFile, dataType, aHeader->getEndianess(), extentSize,
+			regionOriginVec.back(), flipVec );
+	}
+	catch( NullException& e )
+	{
+		throw( FileException( SERROR( e.what() ), CException::RECOVER, ERR_FILEACCESS ) );
+	}
+	return theRegionPtr;
+}
+
+/**
+ * \returns true
+ */
+bool CAnalyzeHandler::supportsRegionSave() const throw()
+{
+	return true;
+}
+
+/**
+ * The img file is always uncompressed and sized for the complete dataset. Images
+ * are saved as Int16 and fields as Float16 (unless "ForceDataType" is given),
+ * since the data range of the complete dataset is not known yet. For the same
+ * reason the header intensity range is left empty.
+ * \param sFilename Filename of file to save to
+ * \param theData Pair of one region of the dataset and (optional) header information
+ * \param extentVec extents of the complete dataset
+ * \throws FileException if the files cannot be created
+ */
+void CAnalyzeHandler::beginRegionSave( const std::string& sFilename, const TDataFile& theData,
+	const std::vector<size_t>& extentVec ) const throw( FileException )
+{
+	if ( !theData.first )
+		throw( FileException( SERROR( "No image" ),	CException::RECOVER, ERR_FILEACCESS ) );
+	shared_ptr<CAnalyzeHeader> aHeader ( new CAnalyzeHeader() );
+	if ( theData.second.get() != NULL )
+		aHeader->append( *(theData.second) );
+	aHeader->setExtents( extentVec );
+	aHeader->setLong( "MaxIntensity", 0 );
+	aHeader->setLong( "MinIntensity", 0 );
+	if ( checkType<TImage>( *theData.first ) )
+		aHeader->setVoxelType( "Int16" );
+	else if ( checkType<TField>( *theData.first ) )
+		aHeader->setVoxelType( "Float16" );
+	else
+		throw( FileException( SERROR( "Illegal input type for ANALYZE writer" ),
+			CException::RECOVER, ERR_FILEFORMATUNSUPPORTED ) );
+	if ( aHeader->isDefined( "ForceDataType" ) )
+		aHeader->setVoxelType( aHeader->getString( "ForceDataType" ) );
+
+	std::ofstream theFile;
+	theFile.open( sFilename.c_str() );
+	if ( !theFile.is_open() )
+		throw( FileException( SERROR( "Could not create file" ), CException::RECOVER, ERR_FILEACCESS ) );
+	aHeader->saveHeader( theFile );
+	theFile.close();
+
+	EDataType dataType = getDataType( aHeader->getVoxelType() );
+	size_t dataSize = ( dataType == DFloat64 ) ? sizeof( long double ) : dataType % 10;
+	for( vector<size_t>::const_iterator it = extentVec.begin(); it != extentVec.end(); ++it )
+		dataSize *= *it;
+	string sDataFilename( sFilename, 0, sFilename.size() - 3 );
+	sDataFilename += "img";
+	theFile.open( sDataFilename.c_str(), ios::out | ios::binary | ios::trunc );
+	if ( !theFile.is_open() )
+		throw ( FileException( SERROR( "Could not create ANALYZE img file!" ),
+			CException::RECOVER, ERR_FILEACCESS ) );
+	// Extend the file to its final size, regions may be saved in any order
+	if ( dataSize > 0 )
+	{
+		theFile.seekp( dataSize - 1, ios::beg );
+		theFile.put( 0 );
+	}
+	if ( !theFile.good() )
+		throw ( FileException( SERROR( "Could not create ANALYZE img file!" ),
+			CException::RECOVER, ERR_FILEACCESS ) );
+	theFile.close();
+}
+
+/**
+ * The region must be a slab along the last dimension of the dataset.
+ * \param sFilename Filename of file to save to
+ * \param aRegionPtr the region
+ * \param regionOriginVec position of the first voxel of the region in the complete dataset
+ * \throws FileException on any file error or if the region is no slab
+ */
+void CAnalyzeHandler::saveRegion( const std::string& sFilename, TDataSetPtr aRegionPtr,
+	const std::vector<size_t>& regionOriginVec ) const throw( FileException )
+{
+	if ( !aRegionPtr )
+		throw( FileException( SERROR( "No image" ),	CException::RECOVER, ERR_FILEACCESS ) );
+	shared_ptr<CAnalyzeHeader> aHeader = loadHeader( sFilename );
+	vector<size_t> extentSize = aHeader->getExtents();
+	vector<size_t> regionExtentVec = aRegionPtr->getExtents();
+	regionExtentVec.resize( aRegionPtr->getDimension() );
+	if ( !isSlab( extentSize, regionOriginVec, regionExtentVec ) )
+		throw( FileException( SERROR( "Region is no slab of the dataset" ), CException::RECOVER, ERR_BADCOORDS ) );
+
+	// Like save(), images are stored in medical standard orientation
+	vector<bool> flipVec( extentSize.size(), false );
+	if ( checkType<TImage>( *aRegionPtr ) && flipVec.size() > 1 )
+		flipVec[1] = true;
+	string sDataFilename( sFilename, 0, sFilename.size() - 3 );
+	sDataFilename += "img";
+	std::fstream theFile( sDataFilename.c_str(), ios::in | ios::out | ios::binary );
+	if ( !theFile.is_open() )
+		throw ( FileException( SERROR( "Could not open ANALYZE img file!" ),
+			CException::RECOVER, ERR_FILEACCESS ) );
+	try
+	{
+		saveSlab( aRegionPtr, theFile, getDataType( aHeader->getVoxelType() ), false, extentSize,
+			regionOriginVec.back(), flipVec );
+	}
+	catch( NullException& e )
+	{
+		throw( FileException( SERROR( e.what() ), CException::RECOVER, ERR_FILEACCESS ) );
+	}
+	theFile.close();
+}
+
+/**
+ * \param sFilename Filename of the header
+ * \returns the header
+ * \throws FileException if the header cannot be read
+ */
+shared_ptr<CAnalyzeHeader> CAnalyzeHandler::loadHeader( const std::string& sFilename ) const
+	throw( FileException )
+{
+	std::ifstream theFile;
+	theFile.open( sFilename.c_str() );
+	if ( !theFile.is_open() )
+		throw( FileException( SERROR( "File not found" ), CException::RECOVER, ERR_FILENOTFOUND ) );
+	shared_ptr<CAnalyzeHeader> aHeader ( new CAnalyzeHeader() );
+	aHeader->loadHeader( theFile );
+	theFile.close();
+	return aHeader;
+}
+
+/**
+ * Mirrors the orientation handling of load()
+ * \param aHeader the header of the file
+ * \param flipVec set to true for each axis which is reversed in the file
+ * \returns false if load() rotates the dataset, i.e. the file can't be read in slabs
+ */
+bool CAnalyzeHandler::getFileFlips( const CAnalyzeHeader& aHeader, std::vector<bool>& flipVec ) const
+	throw()
+{
+	flipVec.assign( aHeader.getExtents().size(), false );
+	const unsigned long ulOrientation = aHeader.getUnsignedLong( "Orientation" );
+	if ( ulOrientation == 1 || ulOrientation == 2 || ulOrientation == 4 || ulOrientation == 5 )
+		return false;
+	EDataType dataType = getDataType( aHeader.getVoxelType() );
+	const bool bFloatData = ( dataType == DFloat32 || dataType == DFloat16 );
+	if ( flipVec.size() > 1 && ( ( bFloatData && ulOrientation == 3 ) || ( !bFloatData && ulOrientation == 0 ) ) )
+		flipVec[1] = true;
+	return true;
+}
+
 CAnalyzeHandler::EDataType CAnalyzeHandler::determineDataType( CDataSet* theDataSet, CImageHeader* theHeader ) const
 {
 	if ( theDataSet->getType() == typeid( TImage::TDataType ) )
@@ -313,11 +557,11 @@ shared_ptr<T> CAnalyzeHandler::flip( shared_ptr<T> original, bool bSwapX, bool b
 	cerr << "Copy " << copy->getDimension() << ": " << copy->getExtent(0) << " x "
 		<< copy->getExtent(1) << " x " << copy->getExtent(2) << " X " << copy->getDataDimension() << endl;
 	std::vector<size_t> dimensionSize = copy->getExtents();
-	ushort ay = 0; ushort ax = 0; ushort az = 0;
-	for ( uint z = 0; z < dimensionSize[2]; ++z )
+	size_t ay = 0; size_t ax = 0; size_t az = 0;
+	for ( size_t z = 0; z < dimensionSize[2]; ++z )
 	{
-    for ( uint y = 0; y < dimensionSize[1]; ++y )
-		  for ( uint x = 0; x < dimensionSize[0]; ++x )
+    for ( size_t y = 0; y < dimensionSize[1]; ++y )
+		  for ( size_t x = 0; x < dimensionSize[0]; ++x )
 	    {
      	  if ( bSwapX ) 
 					ax = dimensionSize[0] - ( x + 1 ); 
@@ -331,7 +575,7 @@ shared_ptr<T> CAnalyzeHandler::flip( shared_ptr<T> original, bool bSwapX, bool b
 					az = dimensionSize[2] - ( z + 1 ); 
 				else 
 					az = z;					
-	      for ( uint i = 0; i < original->getDataDimension(); ++i )
+	      for ( size_t i = 0; i < original->getDataDimension(); ++i )
   	     	(*copy)( ax, ay, az, i ) = (*original)( x, y, z, i );
     	}
 	}
@@ -359,12 +603,12 @@ boost::shared_ptr<T> CAnalyzeHandler::rotate( boost::shared_ptr<T> original,
 	shared_ptr<T> copy ( new T( original->getDimension(), dimensionSize, original->getDataDimension() ) );
 	copy->setDataRange( original->getDataRange() );
 	
-	for ( uint z = 0; z < dimensionSize[2]; ++z )
+	for ( size_t z = 0; z < dimensionSize[2]; ++z )
 	{
-    for ( uint y = 0; y < dimensionSize[1]; ++y )
-		  for ( uint x = 0; x < dimensionSize[0]; ++x )
+    for ( size_t y = 0; y < dimensionSize[1]; ++y )
+		  for ( size_t x = 0; x < dimensionSize[0]; ++x )
 	    {
- 	      for ( uint i = 0; i < original->getDataDimension(); ++i )
+ 	      for ( size_t i = 0; i < original->getDataDimension(); ++i )
 					if ( usNewX == 1 && usNewY == 2 && usNewZ == 0 )
   	     		(*copy)( x, y, z, i ) = (*original)( y, z, x, i );
 					else if ( usNewX == 0 && usNewY == 2 && usNewZ == 1 )
@@ -18,6 +18,8 @@
  *                   Handler now provides its own header class          *
  *          25-01-05 hist.orient field is now interpreted.              *
  *                   This feature has not been tested throrougly yet!   *
+ *          2026-10-17 Uncompressed img files are memory mapped         *
+ *                     Regions can be loaded and saved separately       *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -62,7 +64,31 @@ public:
   /// Saves the dataset to the given file. Pure virtual.
   virtual void save( const std::string& sFilename, const TDataFile& theData ) const
     throw( FileException );
+  /// Returns the extents of the dataset in the given file
+  virtual std::vector<size_t> loadExtents( const std::string& sFilename ) const
+    throw( FileException );
+  /// Loads a region of the dataset in the given file
+  virtual TDataSetPtr loadRegion( const std::string& sFilename,
+    const std::vector<size_t>& regionOriginVec, const std::vector<size_t>& regionExtentVec ) const
+    throw( FileException );
+  /// Returns true, ANALYZE files can be saved region by region
+  virtual bool supportsRegionSave() const
+    throw();
+  /// Creates the header and an empty uncompressed img file
+  virtual void beginRegionSave( const std::string& sFilename, const TDataFile& theData,
+    const std::vector<size_t>& extentVec ) const
+    throw( FileException );
+  /// Saves a region of a dataset into the img file
+  virtual void saveRegion( const std::string& sFilename, TDataSetPtr aRegionPtr,
+    const std::vector<size_t>& regionOriginVec ) const
+    throw( FileException );
 private:
+	/// Loads the header belonging to the given file
+	boost::shared_ptr<CAnalyzeHeader> loadHeader( const std::string& sFilename ) const
+		throw( FileException );
+	/// Determines the axes which are reversed in the img file
+	bool getFileFlips( const CAnalyzeHeader& aHeader, std::vector<bool>& flipVec ) const
+		throw();
 	/// Determines the data type of the dataset
 	EDataType determineDataType( CDataSet* theDataSet, CImageHeader* theHeader ) const;		
 	/// Flips the given axes
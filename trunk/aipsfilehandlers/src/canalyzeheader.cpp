@@ -220,6 +220,8 @@ DBG3( " Dataset orientation is " << (int)header.hist.orient );
 	setLong( "OMin", header.hist.omin );
 	setLong( "SMax", header.hist.smax );
 	setLong( "SMin", header.hist.smin );
+	setLong( "MaxIntensity", header.dime.glmax );
+	setLong( "MinIntensity", header.dime.glmin );
 }
 
 void CAnalyzeHeader::saveHeader( ostream& theFile ) throw( FileException )    		
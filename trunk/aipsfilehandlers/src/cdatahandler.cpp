@@ -76,20 +76,34 @@ FBEGIN;
   	    	CException::RECOVER, ERR_FILEACCESS ) );
 	  }
     TDataSetPtr aDataSet;
-    if ( dimensionSize[2] > 1 )
-      aDataSet.reset( new TImage( 3, dimensionSize ) );
-    else // For 2D images a 2D data set is sufficient
-      aDataSet.reset( new TImage( 2, dimensionSize ) );
+    // Uncompressed 2D images in native layout are mapped instead of read.
+    // Volumes are flipped below, which would copy every voxel of the mapping,
+    // so they are always read. The header holds no data range, so it is
+    // computed in one pass over the mapping
+    if ( !bCompressed && dimensionSize[2] <= 1 )
+    {
+    	vector<size_t> mappedExtentVec( dimensionSize.begin(), dimensionSize.begin() + 2 );
+    	aDataSet = mapData( sDataFilename, mappedExtentVec, voxelSize, bFileEndianess );
+    }
+    if ( aDataSet )
+    	theFile.close();
+    else
+    {
+    	if ( dimensionSize[2] > 1 )
+      	aDataSet.reset( new TImage( 3, dimensionSize ) );
+    	else // For 2D images a 2D data set is sufficient
+      	aDataSet.reset( new TImage( 2, dimensionSize ) );
 
-    if ( !bCompressed )
-		{
-			loadData( aDataSet, theFile, getDataType( aHeader->getVoxelType() ), bFileEndianess );
-			theGzFile.close();
-		}
-		else
-		{
-			loadData( aDataSet, theGzFile, getDataType( aHeader->getVoxelType() ), bFileEndianess );
-			theFile.close();
+    	if ( !bCompressed )
+			{
+				loadData( aDataSet, theFile, getDataType( aHeader->getVoxelType() ), bFileEndianess );
+				theGzFile.close();
+			}
+			else
+			{
+				loadData( aDataSet, theGzFile, getDataType( aHeader->getVoxelType() ), bFileEndianess );
+				theFile.close();
+			}
 		}
 
 		if ( dimensionSize[2] > 1 )
@@ -97,9 +111,9 @@ FBEGIN;
 			TImagePtr originalImage = static_pointer_cast<TImage>( aDataSet );
 			TImagePtr flippedImage( new TImage( originalImage->getDimension(), originalImage->getExtents() ) );
 			flippedImage->setDataRange( originalImage->getDataRange() );
-			for( ushort z = 0; z < dimensionSize[2]; ++z )
-				for( ushort y = 0; y < dimensionSize[1]; ++y )
-					for( ushort x = 0; x < dimensionSize[0]; ++x )
+			for( size_t z = 0; z < dimensionSize[2]; ++z )
+				for( size_t y = 0; y < dimensionSize[1]; ++y )
+					for( size_t x = 0; x < dimensionSize[0]; ++x )
 						(*flippedImage)( x, dimensionSize[1] - 1 - y, dimensionSize[2] - 1 - z ) = 	(*originalImage)( x, y, z );
 			DBG("Flipped");
 			FEND;
@@ -183,9 +197,9 @@ FBEGIN;
   if ( aDataSet->getDimension() == 3 )
 	{
 		TImagePtr flippedImage( new TImage( aDataSet->getDimension(), aDataSet->getExtents() ) );
-		for( ushort z = 0; z < aDataSet->getExtent(2); ++z )
-			for( ushort y = 0; y < aDataSet->getExtent(1); ++y )
-				for( ushort x = 0; x < aDataSet->getExtent(0); ++x )
+		for( size_t z = 0; z < aDataSet->getExtent(2); ++z )
+			for( size_t y = 0; y < aDataSet->getExtent(1); ++y )
+				for( size_t x = 0; x < aDataSet->getExtent(0); ++x )
 					(*flippedImage)( x, aDataSet->getExtent(1) - 1 - y, aDataSet->getExtent(2) - 1 - z ) = (*aDataSet)( x, y, z );
 		(*aDataSet) = (*flippedImage);
 	}
@@ -227,3 +241,72 @@ FBEGIN;
 	}
 FEND;	
 }
+
+/**
+ * \param sFilename Name of the volume file
+ * \returns the extents of the dataset as load() would return it
+ * \exception FileException if the header cannot be read
+ */
+vector<size_t> CDataHandler::loadExtents( const std::string& sFilename )
+  const throw( FileException )
+{
+  ifstream theFile( sFilename.c_str() );
+  if ( !theFile.is_open() )
+    throw( FileException( SERROR( "File not found" ), CException::RECOVER, ERR_FILENOTFOUND ) );
+  CDataHeader aHeader;
+  aHeader.loadHeader( theFile );
+  vector<size_t> dimensionSize = aHeader.getExtents();
+  // load() creates 2D images if the volume has only one slice
+  if ( dimensionSize.size() > 2 && dimensionSize[2] <= 1 )
+    dimensionSize.resize( 2 );
+  return dimensionSize;
+}
+
+/**
+ * Slabs along the last dimension of uncompressed files are read directly from the
+ * data file. All other regions are copied from the completely loaded dataset.
+ * \param sFilename Name of the volume file
+ * \param regionOriginVec first voxel of the region
+ * \param regionExtentVec extents of the region
+ * \returns a dataset holding the region
+ * \exception FileException on any file error or if the region exceeds the dataset
+ */
+TDataSetPtr CDataHandler::loadRegion( const std::string& sFilename,
+  const std::vector<size_t>& regionOriginVec, const std::vector<size_t>& regionExtentVec )
+  const throw( FileException )
+{
+  vector<size_t> dimensionSize = loadExtents( sFilename );
+  if ( !isSlab( dimensionSize, regionOriginVec, regionExtentVec ) )
+    return CFileHandler::loadRegion( sFilename, regionOriginVec, regionExtentVec );
+
+  ifstream theHeaderFile( sFilename.c_str() );
+  CDataHeader aHeader;
+  aHeader.loadHeader( theHeaderFile );
+  theHeaderFile.close();
+  EDataType voxelSize = getDataType( aHeader.getVoxelType() );
+  std::string sDataFilename( sFilename, 0, sFilename.size() - 4 );
+  if ( voxelSize == DUInt8 )
+    sDataFilename += "rawb";
+  else if ( voxelSize == DUInt16 )
+    sDataFilename += "raws";
+  else
+    return CFileHandler::loadRegion( sFilename, regionOriginVec, regionExtentVec );
+  ifstream theFile( sDataFilename.c_str(), ios::in | ios::binary );
+  if ( !theFile.is_open() )
+    return CFileHandler::loadRegion( sFilename, regionOriginVec, regionExtentVec );
+
+  // Volumes are stored upside down and back to front (see load())
+  vector<bool> flipVec( dimensionSize.size(), dimensionSize.size() > 2 );
+  flipVec[0] = false;
+  TDataSetPtr aDataSet( new TImage( regionExtentVec.size(), regionExtentVec ) );
+  try
+  {
+    loadSlab( aDataSet, theFile, voxelSize, aHeader.getEndianess(), dimensionSize,
+      regionOriginVec.back(), flipVec );
+  }
+  catch( NullException& e )
+  {
+    throw( FileException( SERROR( e.what() ), CException::RECOVER, ERR_FILEACCESS ) );
+  }
+  return aDataSet;
+}
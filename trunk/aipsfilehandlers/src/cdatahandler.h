@@ -20,6 +20,8 @@
  *                    Old headers are not outdated by this (s.d.)!     *
  *          27.04.04 Added the new CDataHeader                         *
  *          23.12.04 Added support for gzip data compression           *
+ *          2026-10-17 Uncompressed raw files are memory mapped        *
+ *                     Added loading of regions                        *
  ***********************************************************************/
 
 #ifndef CDATAHANDLER_H
@@ -65,6 +67,13 @@ public:
   /// Saves a data set
   virtual void save( const std::string& sFilename, const TDataFile& theData )
     const throw( FileException );
+  /// Returns the extents of the dataset in the given file
+  virtual std::vector<size_t> loadExtents( const std::string& sFilename )
+    const throw( FileException );
+  /// Loads a region of the dataset in the given file
+  virtual TDataSetPtr loadRegion( const std::string& sFilename,
+    const std::vector<size_t>& regionOriginVec, const std::vector<size_t>& regionExtentVec )
+    const throw( FileException );
 };
 
 #endif
@@ -81,9 +81,9 @@ DBG("About to flip");
 	{
 		TImagePtr flippedImage( new TImage( aDataSet->getDimension(), aDataSet->getExtents() ) );
 		flippedImage->setDataRange( aDataSet->getDataRange() );
-		for( ushort z = 0; z < dimensionSize[2]; ++z )
-			for( ushort y = 0; y < dimensionSize[1]; ++y )
-				for( ushort x = 0; x < dimensionSize[0]; ++x )
+		for( size_t z = 0; z < dimensionSize[2]; ++z )
+			for( size_t y = 0; y < dimensionSize[1]; ++y )
+				for( size_t x = 0; x < dimensionSize[0]; ++x )
 					(*flippedImage)( dimensionSize[0] - 1 -  x, dimensionSize[1] - 1 - y, dimensionSize[2] - 1 - z ) = (*aDataSet)( x, y, z );
 DBG("Flipped");
 FEND;
@@ -144,9 +144,9 @@ cerr << "F" << endl;
 	if ( aDataSet->getDimension() == 3 )
 	{
 		TImagePtr flippedImage( new TImage( aDataSet->getDimension(), aDataSet->getExtents() ) );
-		for( ushort z = 0; z < aDataSet->getExtent(2); ++z )
-			for( ushort y = 0; y < aDataSet->getExtent(1); ++y )
-				for( ushort x = 0; x < aDataSet->getExtent(0); ++x )
+		for( size_t z = 0; z < aDataSet->getExtent(2); ++z )
+			for( size_t y = 0; y < aDataSet->getExtent(1); ++y )
+				for( size_t x = 0; x < aDataSet->getExtent(0); ++x )
 					(*flippedImage)( aDataSet->getExtent(1) - 1 - x, aDataSet->getExtent(1) - 1 - y, aDataSet->getExtent(2) - 1 - z ) = (*aDataSet)( x, y, z );
 		saveData( flippedImage, theFile, dataType, aHeader.getEndianess() );
 	}
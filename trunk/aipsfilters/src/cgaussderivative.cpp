@@ -37,9 +37,13 @@ CGaussDerivative::CGaussDerivative( ulong ulID ) throw()
                    "** Output ports:\n"
                    "0: A 2D or 3D vector field which is normalized\n"
 									 "** Parameters:\n"
-									 "Sigma: Width of gaussian";
+									 "Sigma: Width of gaussian\n"
+									 "Normalize: Divide the field by its largest vector. Otherwise the field\n"
+									 " can be computed region by region (streaming)";
 
 	parameters.initDouble( "Sigma", 0.5, 0.0, 100.0 );
+	parameters.initBool( "Normalize", true );
+	enableStreaming();
 	
   inputsVec[0].portType = CPipelineItem::IOInteger;
 	inputsVec[1].portType = CPipelineItem::IOInteger;
@@ -75,6 +79,23 @@ BENCHSTOP;
 FEND;
 }
 
+/**
+ * The normalization depends on the largest gradient of the whole image
+ * \returns true if "Normalize" is off
+ */
+bool CGaussDerivative::isStreamable() const throw()
+{
+	return CFilter::isStreamable() && !parameters.getBool( "Normalize" );
+}
+
+/**
+ * \returns half the size of the derivative mask
+ */
+size_t CGaussDerivative::getStreamingMargin() const throw()
+{
+	return getMaskSize() / 2;
+}
+
 /*******************
  * Private methods *
  *******************/
@@ -86,7 +107,7 @@ FEND;
 vector<double> CGaussDerivative::computeMask( int& iMaskSize ) throw()
 {
 	double dSigma = parameters.getDouble( "Sigma" );
-	iMaskSize = static_cast<uint>( floor( 6.0 * dSigma + 0.5 ) ) + 1;
+	iMaskSize = getMaskSize();
 	double dDenominator = dSigma * dSigma;
 	vector<double> dGaussMask;
 	for( int i = -( iMaskSize / 2 ); i <= ( iMaskSize / 2 ); ++i )
@@ -98,6 +119,14 @@ vector<double> CGaussDerivative::computeMask( int& iMaskSize ) throw()
 	return dGaussMask;
 }
 
+/**
+ * \returns 6 Sigma + 1, rounded
+ */
+int CGaussDerivative::getMaskSize() const throw()
+{
+	return static_cast<uint>( floor( 6.0 * parameters.getDouble( "Sigma" ) + 0.5 ) ) + 1;
+}
+
 template<typename ImageType>
 bool CGaussDerivative::gauss2D() throw()
 {
@@ -149,7 +178,8 @@ FBEGIN;
 	for( TField2D::iterator outputIt = outputSPtr->begin(); 
 		outputIt != outputSPtr->end();	++outputIt )
 	{
-		(*outputIt) /= dMaxGradient;
+		if ( parameters.getBool( "Normalize" ) )
+			(*outputIt) /= dMaxGradient;
 		if ( norm(*outputIt) < numeric_limits<double>::epsilon() )
 			(*outputIt) = 0.0;	
 	}
@@ -213,7 +243,8 @@ bool CGaussDerivative::gauss3D() throw()
 	for( TField3D::iterator outputIt = outputSPtr->begin(); 
 		outputIt != outputSPtr->end();	++outputIt )
 	{
-		(*outputIt) /= dMaxGradient;
+		if ( parameters.getBool( "Normalize" ) )
+			(*outputIt) /= dMaxGradient;
 		if ( norm(*outputIt) < numeric_limits<double>::epsilon() )
 			(*outputIt) = 0.0;	
 	}
@@ -13,6 +13,7 @@
  *          2006-04-04 Added documentation. Overwork of source code.    *
  *                     Added type list scheme to handle all image data. *
  *          2006-05-24 Added output origin and spacing                  *
+ *          2026-10-17 Added parameter "Normalize" and streaming        *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -39,6 +40,8 @@ using namespace aips;
  * 1. A vector field (2D or 3D) normalized to a maximum vector length of 1.0
  * Parameters: 
  * 1. Sigma - Width of the Gaussian, defaults to 1.0
+ * 2. Normalize - Normalize the output field, defaults to true. Unnormalized fields
+ *    can be computed region by region (streaming)
  */
 class CGaussDerivative : public CFilter
 {
@@ -65,7 +68,14 @@ public:
   virtual void apply() 
 		throw();
   NEW_INSTANCE( CGaussDerivative );
+  /// Reimplemented from CPipelineItem
+  virtual bool isStreamable() const
+		throw();
   //}@
+protected:
+  /// Reimplemented from CPipelineItem
+  virtual size_t getStreamingMargin() const
+		throw();
 private:
 	DECLARE_CALL_MACRO( call2D );
 	DECLARE_CALL_MACRO( call3D );
@@ -82,6 +92,9 @@ private:
 	/// Compute gaussian derivative mask
 	std::vector<double> computeMask( int& iMaskSize )
 		throw();
+	/// Returns the size of the derivative mask
+	int getMaskSize() const
+		throw();
 };
 
 #endif
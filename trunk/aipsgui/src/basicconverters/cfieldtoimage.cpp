@@ -14,9 +14,47 @@
  ************************************************************************/
 #include "cfieldtoimage.h"
 
+// AIPS includes
+#include <aipsparallel.h>
+
 using namespace std;
 using namespace boost;
 
+namespace
+{
+
+/// Number of voxels converted by one work item
+const size_t chunkSize = 65536;
+
+/**
+ * Linear intensity mapping of a data array, shared by all workers.
+ * A worker processes a range of chunks of the array.
+ */
+template<typename TValue> struct SLinearMapping
+{
+	const TValue* inputPtr;
+	TImage::TDataType* outputPtr;
+	size_t arraySize;
+	double dInputOffset;
+	double dFactor;
+	double dOutputOffset;
+
+	/// Number of chunks
+	size_t itemCount() const
+	{
+		return ( arraySize + chunkSize - 1 ) / chunkSize;
+	}
+	void range( const size_t first, const size_t last ) const
+	{
+		const size_t lastIndex = std::min( arraySize, last * chunkSize );
+		for( size_t i = first * chunkSize; i < lastIndex; ++i )
+			outputPtr[i] = static_cast<TImage::TDataType>(
+				round( ( static_cast<double>( inputPtr[i] ) + dInputOffset ) * dFactor + dOutputOffset ) );
+	}
+};
+
+}
+
 /*************
  * Structors *
  *************/
@@ -62,79 +100,19 @@ BENCHSTART;
   {
 		bModuleReady = true;
   	deleteOldOutput();
-		// Get parameters
-		ulong ulMinVal = parameters.getUnsignedLong( "MinimumValue" );
-		ulong ulMaxVal = parameters.getUnsignedLong( "MaximumValue" );
-		// Determine minimum and maximum conversion
-		double dFactor = static_cast<double>( ulMaxVal - ulMinVal ) 
-			/ ( inputPtr->getDataRange().getMaximum() - inputPtr->getDataRange().getMinimum() ); 
-		double dInputOffset = inputPtr->getDataRange().getMinimum() * -1.0;
-		double dOutputOffset = ulMinVal;
-		// Create output field
-		TImagePtr outputPtr( new TImage ( inputPtr->getDimension(), inputPtr->getExtents(), 
-	 		inputPtr->getDataDimension() ) );
-
-		// Get maximum and minimum of vector field
- 		outputPtr->setMaximum( ulMaxVal );
-	 	outputPtr->setMinimum( ulMinVal );
-
- 		// Create new field
-		PROG_MAX( inputPtr->getArraySize() );
-  	ulong cnt = 0;
-	  TImage::iterator outputIterator = outputPtr->begin();
-  	for ( TField::iterator inputIt = inputPtr->begin();
-	  	inputIt != inputPtr->end(); ++inputIt, ++outputIterator )
-		{
-			cnt++;
-			if ( cnt % 20000 == 0 ) 
-				PROG_VAL( cnt );
-			double dVal = ( ( (*inputIt) + dInputOffset ) * dFactor ) + dOutputOffset;
-  	 	(*outputIterator) = static_cast<ushort>( round( dVal ) );
-  	}	
-		PROG_RESET();
-  	setOutput( outputPtr );
+		convert( *inputPtr );
   }
   else
   {
   	TImagePtr imagePtr = dynamic_pointer_cast<TImage>( getInput() );
-  	if ( !checkInput<TImage>( inputPtr ) )
+  	if ( !checkInput<TImage>( imagePtr ) )
   	{
   		alog << LWARN << "Illegal input type for CFieldToImage converter" << endl;
   		return;
   	}
   	bModuleReady = true;
   	deleteOldOutput();
-		// Get parameters
-		ulong ulMinVal = parameters.getUnsignedLong( "MinimumValue" );
-		ulong ulMaxVal = parameters.getUnsignedLong( "MaximumValue" );
-		// Determine minimum and maximum conversion
-		double dFactor = static_cast<double>( ulMaxVal - ulMinVal ) 
-			/ static_cast<double>( inputPtr->getDataRange().getMaximum() - inputPtr->getDataRange().getMinimum() ); 
-		double dInputOffset = static_cast<double>( inputPtr->getDataRange().getMinimum() ) * -1.0;
-		double dOutputOffset = ulMinVal;
-		// Create output field
-		TImagePtr outputPtr( new TImage ( imagePtr->getDimension(), imagePtr->getExtents(), 
-	 		imagePtr->getDataDimension() ) );
-
-		// Get maximum and minimum of vector field
- 		outputPtr->setMaximum( ulMaxVal );
-	 	outputPtr->setMinimum( ulMinVal );
-
- 		// Create new field
-		PROG_MAX( inputPtr->getArraySize() );
-  	ulong cnt = 0;
-	  TImage::iterator outputIterator = outputPtr->begin();
-  	for ( TImage::iterator inputIt = imagePtr->begin();
-	  	inputIt != imagePtr->end(); ++inputIt, ++outputIterator )
-		{
-			cnt++;
-			if ( cnt % 20000 == 0 ) 
-				PROG_VAL( cnt );
-			double dVal = ( ( (*inputIt) + dInputOffset ) * dFactor ) + dOutputOffset;
-  	 	(*outputIterator) = static_cast<ushort>( round( dVal ) );
-  	}	
-		PROG_RESET();
-  	setOutput( outputPtr );
+		convert( *imagePtr );
   }
 BENCHSTOP;	
 }
@@ -143,3 +121,39 @@ CPipelineItem* CFieldToImage::newInstance( ulong ulID ) const throw()
 {
   return new CFieldToImage( ulID );
 }
+
+/*******************
+ * Private methods *
+ *******************/
+
+/**
+ * The data range of the input is mapped linearly onto [MinimumValue, MaximumValue].
+ * Chunks of the data array are converted by several threads.
+ * \param anInput float or integer data set
+ */
+template<typename TInputType> void CFieldToImage::convert( const TInputType& anInput ) throw()
+{
+	// Get parameters
+	ulong ulMinVal = parameters.getUnsignedLong( "MinimumValue" );
+	ulong ulMaxVal = parameters.getUnsignedLong( "MaximumValue" );
+	// Determine minimum and maximum conversion
+	const double dInputRange = static_cast<double>( anInput.getDataRange().getMaximum() )
+		- static_cast<double>( anInput.getDataRange().getMinimum() );
+	SLinearMapping<typename TInputType::TDataType> theMapping;
+	theMapping.dFactor = ( dInputRange > 0.0 ) ?
+		( static_cast<double>( ulMaxVal ) - static_cast<double>( ulMinVal ) ) / dInputRange : 0.0;
+	theMapping.dInputOffset = static_cast<double>( anInput.getDataRange().getMinimum() ) * -1.0;
+	theMapping.dOutputOffset = ulMinVal;
+	// Create output field
+	TImagePtr outputPtr( new TImage ( anInput.getDimension(), anInput.getExtents(),
+ 		anInput.getDataDimension() ) );
+	outputPtr->setMaximum( ulMaxVal );
+ 	outputPtr->setMinimum( ulMinVal );
+
+	theMapping.inputPtr = &anInput[0];
+	theMapping.outputPtr = outputPtr->getArray();
+	theMapping.arraySize = anInput.getArraySize();
+	parallelFor( theMapping, &SLinearMapping<typename TInputType::TDataType>::range,
+		theMapping.itemCount() );
+	setOutput( outputPtr );
+}
@@ -5,11 +5,12 @@
  *                                                                      *
  * Author: Hendrik Belitz (h.belitz@fz-juelich.de)                      *
  *                                                                      *
- * Version: 0.2                                                         *
+ * Version: 0.3                                                         *
  * Status : Alpha                                                       *
  * Created: 2005-01-13                                                  *
  * Changed: 2005-11-28 Added support for integer input. Added some      *
  *                     documentation.                                   *
+ *          2026-10-17 Threaded conversion, fixed integer input         *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -18,7 +19,7 @@
  ************************************************************************/
 #ifndef CFIELDTOIMAGE_H
 #define CFIELDTOIMAGE_H
-#define CFIELDTOIMAGE_VERSION "0.2"
+#define CFIELDTOIMAGE_VERSION "0.3"
 
 // AIPS includes
 #include <cconverter.h>
@@ -36,7 +37,8 @@ using namespace aips;
  * The only input is a scalar image. If this is of integer type, it
  * is send directly to the output after adjusting the minimum and maximum
  * values. Floating point images are converted to integer images using 
- * the parameters MinimumValue and MaximumValue.
+ * the parameters MinimumValue and MaximumValue. The conversion is split
+ * into chunks processed by several threads.
  */
 class CFieldToImage : public CConverter
 {
@@ -66,6 +68,10 @@ public:
   virtual CPipelineItem* newInstance( ulong ulID = 0 ) const
     throw();
   //}@
+private:
+	/// Maps the intensities of a float or integer data set onto the output range
+	template<typename TInputType> void convert( const TInputType& anInput )
+		throw();
 };
 
 #endif
@@ -115,6 +115,52 @@ void CFileSource::apply() throw()
 	bModuleReady = true;
 }
 
+/**
+ * \param usOutputNumber output port
+ * \returns the extents of the loaded dataset or, if nothing is loaded, of the
+ *   dataset in the selected file
+ */
+std::vector<size_t> CFileSource::getOutputExtents( unsigned short usOutputNumber ) throw()
+{
+	if ( usOutputNumber >= getFanOut() || getOutput( usOutputNumber )
+		|| parameters.getString( "Filename" ).empty() )
+		return CSource::getOutputExtents( usOutputNumber );
+	try
+	{
+		return getFileServer().loadExtents( parameters.getString( "Filename" ) );
+	}
+	catch ( FileException &e )
+	{
+		alog << LWARN << "Could not read the extents of the selected file" << endl;
+		return std::vector<size_t>();
+	}
+}
+
+/**
+ * A loaded dataset is used as it is. Otherwise only the region is read from the
+ * selected file, which keeps streamed pipelines from loading the whole dataset.
+ * \param anOutputRegion requested region
+ * \param usOutputNumber output port
+ * \returns a new data set holding the region or an empty pointer if it couldn't be loaded
+ */
+TDataSetPtr CFileSource::computeRegion( const CDataSetRegion& anOutputRegion,
+	unsigned short usOutputNumber ) throw()
+{
+	if ( usOutputNumber >= getFanOut() || getOutput( usOutputNumber )
+		|| parameters.getString( "Filename" ).empty() )
+		return CSource::computeRegion( anOutputRegion, usOutputNumber );
+	try
+	{
+		return getFileServer().loadRegion( parameters.getString( "Filename" ),
+			anOutputRegion.getOrigin(), anOutputRegion.getExtents() );
+	}
+	catch ( FileException &e )
+	{
+		alog << LWARN << "No data loaded" << endl;
+		return TDataSetPtr();
+	}
+}
+
 void CFileSource::execute( shared_ptr<CEvent> anEvent )
 {
 	if ( anEvent->getType() == EFileNameChangedEvent )
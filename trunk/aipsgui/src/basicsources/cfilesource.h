@@ -18,6 +18,8 @@
  *                   Filename and path are now stored in module params  *
  *          04-05-11 Removed mirror and endianess swapping              *
  *                   (There're now seperate modules for this)           *
+ *          2026-10-17 Regions are read from the file if nothing is     *
+ *                     loaded (streaming)                               *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -60,6 +62,11 @@ public:
   CPipelineItem* newInstance( ulong ulID = 0 ) const 
 		throw();
  	virtual void apply() throw();
+	/// Reimplemented from CPipelineItem. Reads the file header if nothing is loaded
+	virtual std::vector<size_t> getOutputExtents( unsigned short usOutputNumber = 0 ) throw();
+	/// Reimplemented from CPipelineItem. Reads the region from the file if nothing is loaded
+	virtual TDataSetPtr computeRegion( const CDataSetRegion& anOutputRegion,
+		unsigned short usOutputNumber = 0 ) throw();
 public:	
   /// Opens a file dialog to allow selection of new source data
   void selectNewFile( string sFilename );
@@ -30,7 +30,10 @@ CImageWriter::CImageWriter( ulong ulID ) throw()
 									 "** Input ports:\n"
                    " 0: A scalar multi-channel 2D or 3D data set\n"
                    "** Output ports:\n"
-                   " none";
+                   " none\n"
+                   "** Parameters:\n"
+                   " SlabSize: If not 0 and the file format supports it, the pipeline is\n"
+                   "  computed and saved in slabs of this many slices";
 
   inputsVec[0].portType = IOOther;
   parameters.initString( "Filename", "" );
@@ -38,6 +41,9 @@ CImageWriter::CImageWriter( ulong ulID ) throw()
 		parameters.initString( "Path", getGlobalConfiguration().getString( "AIPS_DATA" ) );					
 	else
 		parameters.initString( "Path", "" );	
+	parameters.initUnsignedLong( "SlabSize", 0, 0, 65535 );
+	bRegionSaveFailed = false;
+	enableStreaming();
 /* HB 28-06-05 */	
 myDialog.reset( new CImageWriterDialog( this ) );
 	setModuleDialog( myDialog );
@@ -67,7 +73,17 @@ BENCHSTART;
     alog << LWARN << "Could not save file with no name" << endl;
     return;
   }
-	if ( typeid( *myInput ) == typeid( TImage ) )
+	// Streamed saving computes the pipeline slab by slab, so the complete
+	// dataset is never held in memory
+	const size_t slabSize = parameters.getUnsignedLong( "SlabSize" );
+	if ( slabSize > 0 && getFileServer().supportsRegionSave( sFilename ) )
+	{
+		bRegionSaveFailed = false;
+		updateStreamed( slabSize );
+	}
+	else if ( !myInput )
+		alog << LWARN << SERROR( "No input or wrong data type" ) << endl;
+	else if ( typeid( *myInput ) == typeid( TImage ) )
 		actualSaver<TImage>();
 	else if ( typeid( *myInput ) == typeid( TField ) )
 		actualSaver<TField>();		
@@ -135,3 +151,31 @@ void CImageWriter::apply() throw()
 {
 	myInput = getInput();
 }
+
+/**
+ * The first slab creates the files, every slab is written to its position.
+ * \param aRegion region of the complete input held by the input port
+ * \param extentVec extents of the complete input
+ */
+void CImageWriter::applyRegion( const CDataSetRegion& aRegion, const std::vector<size_t>& extentVec )
+	throw()
+{
+	TDataSetPtr regionPtr = getInput();
+	if ( !regionPtr || bRegionSaveFailed )
+	{
+		bRegionSaveFailed = true;
+		return;
+	}
+	try
+	{
+		if ( aRegion.getOrigin( aRegion.getOrigin().size() - 1 ) == 0 )
+			getFileServer().beginRegionSave( sFilename, TDataFile( regionPtr, shared_ptr<CImageHeader>() ),
+				extentVec );
+		getFileServer().saveRegion( sFilename, regionPtr, aRegion.getOrigin() );
+	}
+	catch ( FileException &e )
+	{
+		alog << LWARN << "No data saved" << e.what() << endl;
+		bRegionSaveFailed = true;
+	}
+}
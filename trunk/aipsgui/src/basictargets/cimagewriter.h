@@ -17,6 +17,7 @@
  *          2004-06-16 Updated documentation and error output           *
  *          2005-01-13 Templatized saving method to enable saving       *
  *                     of all dataset types                             *
+ *          2026-10-17 Added slab-wise saving of streamed pipelines     *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -68,6 +69,10 @@ public:
 	/// Reimplemented from CTarget
   CPipelineItem* newInstance( ulong ulID = 0 ) const
     throw();
+protected:
+	/// Reimplemented from CPipelineItem. Saves one slab of a streamed input
+	virtual void applyRegion( const CDataSetRegion& aRegion, const std::vector<size_t>& extentVec )
+		throw();
 public:	
   /// Opens a file dialog to allow selection of new source data
   void selectNewFile( string sFilename );
@@ -80,6 +85,7 @@ private:
 private:
 	template<typename T> void actualSaver() throw();
 	TDataSetPtr myInput;
+	bool bRegionSaveFailed; ///< Did saving a slab of the current file fail?
 };
 
 #endif
@@ -0,0 +1,508 @@
+/************************************************************************
+ * File: cdiffusionfilter.cpp                                           *
+ * Project: AIPS - Diffusion filter plugin library                      *
+ * Description: Base class of all explicit nonlinear diffusion filters  *
+ *                                                                      *
+ * Author: Hendrik Belitz (h.belitz@fz-juelich.de)                      *
+ *                                                                      *
+ * Created: 2026-10-17                                                  *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#include "cdiffusionfilter.h"
+
+// Standard includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// AIPS includes
+#include <aipsparallel.h>
+
+using namespace std;
+using namespace boost;
+
+namespace
+{
+
+/// Weights of face, edge and corner neighbours
+const double neighbourWeightArr[3] = { 1.0, 0.5, 0.333 };
+
+/// Smallest number of samples of the flux table for floating point data
+const size_t minimumSampleCount = 4096;
+
+/// Largest number of samples of the flux table for floating point data
+const size_t maximumSampleCount = 1 << 20;
+
+/// Table entries of smaller magnitude are set to zero, since denormal numbers are slow
+const double negligibleValue = 1.0e-12;
+
+/// Returns zero for values of negligible magnitude
+inline double flushNegligible( const double dValue )
+{
+	return ( std::abs( dValue ) < negligibleValue ) ? 0.0 : dValue;
+}
+
+/**
+ * One explicit diffusion step of one channel, shared by all workers.
+ * A worker processes a range of inner slices of a volume or inner rows of an image.
+ */
+template<typename T> struct SDiffusion
+{
+	const T* readPtr;           ///< Channel of the actual iteration
+	T* writePtr;                ///< Channel of the next iteration
+	size_t extentArr[3];        ///< Channel extents (1 for missing dimensions)
+	ptrdiff_t offsetArr[26];    ///< Neighbour offsets, sorted by face, edge and corner neighbours
+	size_t classEndArr[3];      ///< End of each neighbour class in offsetArr
+	const double* tablePtr;     ///< Integer data: lambda * flux(d) at tablePtr[d]
+	                            ///< Floating point data: lambda * flux(d) at tablePtr[|d| * dScale]
+	double dScale;              ///< Samples per unit of the flux table (floating point data)
+	size_t sampleCount;         ///< Last sample of the flux table (floating point data)
+	T minimum;                  ///< Smallest value of the input
+	T maximum;                  ///< Largest value of the input
+
+	/// Number of work items: inner slices of volumes, inner rows of images
+	size_t itemCount() const
+	{
+		return ( extentArr[2] > 1 ) ? extentArr[2] - 2 : extentArr[1] - 2;
+	}
+	/// Returns lambda * flux( dDifference ) from the table
+	inline double tableFlux( const T theNeighbour, const T theCentre ) const
+	{
+		if ( numeric_limits<T>::is_integer )
+			return tablePtr[static_cast<long>( theNeighbour ) - static_cast<long>( theCentre )];
+		const double dDifference = static_cast<double>( theNeighbour ) - static_cast<double>( theCentre );
+		const double dPosition = std::abs( dDifference ) * dScale;
+		double dFlux;
+		if ( dPosition >= static_cast<double>( sampleCount ) )
+			dFlux = tablePtr[sampleCount];
+		else
+		{
+			const size_t sample = static_cast<size_t>( dPosition );
+			dFlux = tablePtr[sample] + ( dPosition - sample ) * ( tablePtr[sample + 1] - tablePtr[sample] );
+		}
+		return ( dDifference < 0.0 ) ? -dFlux : dFlux;
+	}
+	/// Updates the inner voxels of the given slices (volumes) or rows (images)
+	void range( const size_t firstItem, const size_t lastItem ) const
+	{
+		typedef typename SDataTraits<T>::TIncreasedRangeType TInc;
+		size_t zBegin, zEnd, yBegin = 1, yEnd = extentArr[1] - 1;
+		if ( extentArr[2] > 1 )
+		{
+			zBegin = firstItem + 1;
+			zEnd = lastItem + 1;
+		}
+		else
+		{
+			zBegin = 0;
+			zEnd = 1;
+			yBegin = firstItem + 1;
+			yEnd = lastItem + 1;
+		}
+		for( size_t z = zBegin; z < zEnd; ++z )
+			for( size_t y = yBegin; y < yEnd; ++y )
+			{
+				const size_t lineStart = ( z * extentArr[1] + y ) * extentArr[0];
+				const T* linePtr = readPtr + lineStart;
+				T* outputLinePtr = writePtr + lineStart;
+				for( size_t x = 1; x < extentArr[0] - 1; ++x )
+				{
+					const T* voxelPtr = linePtr + x;
+					const T theCentre = *voxelPtr;
+					double dTotalFlux = 0.0;
+					size_t k = 0;
+					for( ushort usClass = 0; usClass < 3; ++usClass )
+					{
+						double dClassFlux = 0.0;
+						for( ; k < classEndArr[usClass]; ++k )
+							dClassFlux += tableFlux( voxelPtr[offsetArr[k]], theCentre );
+						dTotalFlux += neighbourWeightArr[usClass] * dClassFlux;
+					}
+					TInc theResult;
+					if ( numeric_limits<T>::is_integer )
+						theResult = static_cast<TInc>( theCentre ) + static_cast<TInc>( dTotalFlux );
+					else
+						theResult = static_cast<TInc>( theCentre + dTotalFlux );
+					if ( theResult > static_cast<TInc>( maximum ) )
+						theResult = maximum;
+					else if ( theResult < static_cast<TInc>( minimum ) )
+						theResult = minimum;
+					outputLinePtr[x] = static_cast<T>( theResult );
+				}
+			}
+	}
+};
+
+/**
+ * One semi-implicit step along one axis, shared by all workers. The diffusivity
+ * table is interpolated linearly. Lines along the y and z axis are solved for a
+ * whole row of x positions at once, so all memory accesses are contiguous.
+ */
+struct SSemiImplicit
+{
+	const double* valuePtr;       ///< Channel at the beginning of the step
+	double* resultPtr;            ///< Receives dWeight times the solution of each axis
+	size_t extentArr[3];          ///< Channel extents (1 for missing dimensions)
+	ushort usAxis;                ///< Axis of the tridiagonal systems
+	double dStep;                 ///< Number of axes times the time step
+	double dWeight;               ///< One by the number of axes
+	const double* diffusivityPtr; ///< g(d) at diffusivityPtr[|d| * dScale]
+	double dScale;                ///< Samples per unit of the diffusivity table
+	size_t sampleCount;           ///< Last sample of the diffusivity table
+
+	/// Number of work items: rows for the x axis, slices for the y axis, rows of a slice for the z axis
+	size_t itemCount() const
+	{
+		if ( usAxis == 0 )
+			return extentArr[1] * extentArr[2];
+		return ( usAxis == 1 ) ? extentArr[2] : extentArr[1];
+	}
+	/// Returns the diffusivity between two neighbours
+	inline double diffusivity( const double dDifference ) const
+	{
+		const double dPosition = std::abs( dDifference ) * dScale;
+		if ( dPosition >= static_cast<double>( sampleCount ) )
+			return diffusivityPtr[sampleCount];
+		const size_t sample = static_cast<size_t>( dPosition );
+		return diffusivityPtr[sample] + ( dPosition - sample )
+			* ( diffusivityPtr[sample + 1] - diffusivityPtr[sample] );
+	}
+	/**
+	 * Solves ( I - dStep A ) x = u for width neighbouring lines with the Thomas
+	 * algorithm. A has the off diagonal elements g and the row sums zero.
+	 */
+	void lines( const size_t firstItem, const size_t lastItem ) const
+	{
+		const size_t stride = ( usAxis == 0 ) ? 1 : ( usAxis == 1 ) ? extentArr[0] : extentArr[0] * extentArr[1];
+		const size_t lineSize = extentArr[usAxis];
+		const size_t width = ( usAxis == 0 ) ? 1 : extentArr[0];
+		vector<double> previousVec( width );
+		vector<double> upperVec( lineSize * width );
+		vector<double> rightVec( lineSize * width );
+		for( size_t item = firstItem; item < lastItem; ++item )
+		{
+			const size_t base = ( usAxis == 1 ) ? item * extentArr[0] * extentArr[1] : item * extentArr[0];
+			// Forward elimination
+			for( size_t i = 0; i < lineSize; ++i )
+			{
+				const double* rowPtr = valuePtr + base + i * stride;
+				double* upperPtr = &upperVec[i * width];
+				double* rightPtr = &rightVec[i * width];
+				for( size_t j = 0; j < width; ++j )
+				{
+					const double dPrevious = ( i > 0 ) ? previousVec[j] : 0.0;
+					const double dNext = ( i + 1 < lineSize ) ? diffusivity( rowPtr[j + stride] - rowPtr[j] ) : 0.0;
+					const double dLower = -dStep * dPrevious;
+					double dDiagonal = 1.0 + dStep * ( dPrevious + dNext );
+					double dRight = rowPtr[j];
+					if ( i > 0 )
+					{
+						dDiagonal -= dLower * upperVec[( i - 1 ) * width + j];
+						dRight -= dLower * rightVec[( i - 1 ) * width + j];
+					}
+					upperPtr[j] = -dStep * dNext / dDiagonal;
+					rightPtr[j] = dRight / dDiagonal;
+					previousVec[j] = dNext;
+				}
+			}
+			// Back substitution
+			for( size_t i = lineSize; i-- > 0; )
+			{
+				double* rightPtr = &rightVec[i * width];
+				double* outputPtr = resultPtr + base + i * stride;
+				for( size_t j = 0; j < width; ++j )
+				{
+					if ( i + 1 < lineSize )
+						rightPtr[j] -= upperVec[i * width + j] * rightVec[( i + 1 ) * width + j];
+					outputPtr[j] += dWeight * rightPtr[j];
+				}
+			}
+		}
+	}
+};
+
+/// Number of samples of a table over the differences [0, dRange] for the diffusion factor dK
+size_t getSampleCount( const double dRange, const double dK )
+{
+	return static_cast<size_t>( std::min( std::max( 64.0 * dRange / dK,
+		static_cast<double>( minimumSampleCount ) ), static_cast<double>( maximumSampleCount ) ) );
+}
+
+}
+
+/*************
+ * Structors *
+ *************/
+
+/**
+ * Enables streaming and initialises the parameters "Scheme" and "Time". All
+ * other parameters are initialised by the derived classes.
+ * \param ulID Module id
+ * \param sName Module name
+ */
+CDiffusionFilter::CDiffusionFilter( ulong ulID, const string& sName,
+		const ushort usNoOfInputs, const ushort usNoOfOutputs,
+		const std::string &sClassName_, const std::string &sClassVersion_,
+		const std::string &sDerivedFrom_ )
+  throw() : CFilter ( ulID, sName, usNoOfInputs, usNoOfOutputs, sClassName_, sClassVersion_, sDerivedFrom_ )
+{
+  setModuleID( sLibID );
+  parameters.initUnsignedLong( "Scheme", 0UL, 0UL, 1UL );
+  parameters.initDouble( "Time", 10.0, 0.001, 1000000.0 );
+  enableStreaming();
+  // Diffusion runs are expensive and often repeated with earlier parameters
+  memoiseResults();
+}
+
+CDiffusionFilter::~CDiffusionFilter() throw()
+{
+}
+
+/*****************
+ * Other methods *
+ *****************/
+
+void CDiffusionFilter::apply() throw()
+{
+BENCHSTART;
+	bModuleReady = false;
+  TDataSetPtr inputPtr = getInput();
+  if ( !inputPtr || inputPtr->getDimension() < 2 || inputPtr->getDimension() > 3 )
+  {
+    alog << LWARN << SERROR( "No input or wrong data type" ) << endl;
+    return;
+  }
+  if ( checkType<TImage>( *inputPtr ) )
+    diffuseImage<TImage>();
+  else if ( checkType<TField>( *inputPtr ) )
+    diffuseImage<TField>();
+  else if ( checkType<TSmallImage>( *inputPtr ) )
+    diffuseImage<TSmallImage>();
+  else
+    alog << LWARN << SERROR( "No input or wrong data type" ) << endl;
+BENCHSTOP;
+}
+
+/**
+ * The bounds keep lambda times the sum of the neighbour weights below one, so
+ * the explicit scheme is stable for influence functions with g(d) <= 1.
+ * \param usDimension dimension of the input (2 or 3)
+ * \param ulNeighbourhood value of the parameter "Neighbourhood"
+ * \returns the largest value of lambda which will be used
+ */
+double CDiffusionFilter::getMaximumLambda( const ushort usDimension, const ulong ulNeighbourhood ) const
+  throw()
+{
+  if ( usDimension == 3 )
+  {
+    if ( ulNeighbourhood == 0 )
+      return 0.142;
+    if ( ulNeighbourhood == 1 )
+      return 0.0769;
+    return 0.068;
+  }
+  if ( ulNeighbourhood > 0 )
+    return 0.142;
+  return 1.0;
+}
+
+/**
+ * Each iteration only reads the direct neighbours of a voxel
+ * \returns number of iterations plus one
+ */
+size_t CDiffusionFilter::getStreamingMargin() const throw()
+{
+  return parameters.getUnsignedLong( "Iterations" ) + 1;
+}
+
+/**
+ * Each step of the semi-implicit scheme couples all voxels of a line, so the
+ * whole input is needed for any output region.
+ * \param usInputNumber input port
+ * \param anOutputRegion requested region of the outputs
+ * \param inputExtentVec extents of the complete input
+ * \returns the input region needed to compute anOutputRegion
+ */
+CDataSetRegion CDiffusionFilter::getRequiredInputRegion( unsigned short usInputNumber,
+  const CDataSetRegion& anOutputRegion, const std::vector<size_t>& inputExtentVec ) const throw()
+{
+  if ( parameters.getUnsignedLong( "Scheme" ) == 1 )
+    return CDataSetRegion( inputExtentVec, std::vector<size_t>( inputExtentVec.size(), 0 ) );
+  return CFilter::getRequiredInputRegion( usInputNumber, anOutputRegion, inputExtentVec );
+}
+
+/**
+ * Dispatches to the semi-implicit scheme if the parameter "Scheme" is 1.
+ * Otherwise performs "Iterations" explicit steps with two alternating buffers.
+ */
+template<typename TImageType> void CDiffusionFilter::diffuseImage() throw()
+{
+  typedef typename TImageType::TDataType T;
+  shared_ptr<TImageType> readImagePtr = static_pointer_cast<TImageType>( takeInput() );
+	bModuleReady = true;
+  deleteOldOutput();
+
+  const ulong ulIterations = parameters.getUnsignedLong( "Iterations" );
+  const double dK = parameters.getDouble( "k" );
+  const ulong ulNeighbourhood = parameters.getUnsignedLong( "Neighbourhood" );
+  const double dLambda = std::min( parameters.getDouble( "lambda" ),
+    getMaximumLambda( readImagePtr->getDimension(), ulNeighbourhood ) );
+
+  SDiffusion<T> theDiffusion;
+  for( ushort d = 0; d < 3; ++d )
+    theDiffusion.extentArr[d] = ( d < readImagePtr->getDimension() ) ? readImagePtr->getExtent( d ) : 1;
+  for( ushort d = 0; d < readImagePtr->getDimension(); ++d )
+    if ( theDiffusion.extentArr[d] < 3 )
+    {
+      setOutput( readImagePtr );
+      return;
+    }
+
+  const TImageType& theInput = *readImagePtr;
+  const T* beginPtr = &theInput[0];
+  const T* endPtr = beginPtr + theInput.getArraySize();
+  theDiffusion.minimum = *std::min_element( beginPtr, endPtr );
+  theDiffusion.maximum = *std::max_element( beginPtr, endPtr );
+  if ( parameters.getUnsignedLong( "Scheme" ) == 1 )
+  {
+    diffuseSemiImplicit( *readImagePtr, theDiffusion.minimum, theDiffusion.maximum );
+    setOutput( readImagePtr );
+    return;
+  }
+  shared_ptr<TImageType> writeImagePtr( new TImageType( *readImagePtr ) );
+
+  // Neighbour offsets, sorted by the number of coordinates which differ from the centre
+  const ptrdiff_t strideArr[3] = { 1, static_cast<ptrdiff_t>( theDiffusion.extentArr[0] ),
+    static_cast<ptrdiff_t>( theDiffusion.extentArr[0] * theDiffusion.extentArr[1] ) };
+  const int iMaxDistance = ( readImagePtr->getDimension() == 3 ) ? static_cast<int>( ulNeighbourhood ) + 1
+    : ( ulNeighbourhood > 0 ? 2 : 1 );
+  const int iZRange = ( readImagePtr->getDimension() == 3 ) ? 1 : 0;
+  size_t k = 0;
+  for( int iDistance = 1; iDistance <= 3; ++iDistance )
+  {
+    if ( iDistance <= iMaxDistance )
+      for( int dz = -iZRange; dz <= iZRange; ++dz )
+        for( int dy = -1; dy <= 1; ++dy )
+          for( int dx = -1; dx <= 1; ++dx )
+            if ( std::abs( dx ) + std::abs( dy ) + std::abs( dz ) == iDistance )
+              theDiffusion.offsetArr[k++] = dx * strideArr[0] + dy * strideArr[1] + dz * strideArr[2];
+    theDiffusion.classEndArr[iDistance - 1] = k;
+  }
+
+  // Flux table over the range of possible grey value differences
+  const double dRange = std::max( static_cast<double>( theDiffusion.maximum )
+    - static_cast<double>( theDiffusion.minimum ), 1.0 );
+  vector<double> tableVec;
+  if ( numeric_limits<T>::is_integer )
+  {
+    const long lRange = static_cast<long>( dRange );
+    tableVec.resize( 2 * lRange + 1 );
+    for( long l = -lRange; l <= lRange; ++l )
+      tableVec[l + lRange] = flushNegligible( dLambda * flux( static_cast<double>( l ), dK ) );
+    theDiffusion.tablePtr = &tableVec[lRange];
+  }
+  else
+  {
+    theDiffusion.sampleCount = getSampleCount( dRange, dK );
+    theDiffusion.dScale = theDiffusion.sampleCount / dRange;
+    tableVec.resize( theDiffusion.sampleCount + 2 );
+    for( size_t i = 0; i < tableVec.size(); ++i )
+      tableVec[i] = flushNegligible( dLambda * flux( i / theDiffusion.dScale, dK ) );
+    theDiffusion.tablePtr = &tableVec[0];
+  }
+
+  const size_t channelSize = readImagePtr->getArraySize() / readImagePtr->getDataDimension();
+  PROG_MAX( ulIterations );
+  for( ulong ulIteration = 0; ulIteration < ulIterations; ++ulIteration )
+  {
+    APP_PROC();
+    for( ushort usChannel = 0; usChannel < readImagePtr->getDataDimension(); ++usChannel )
+    {
+      const TImageType& theReadImage = *readImagePtr;
+      theDiffusion.readPtr = &theReadImage[usChannel * channelSize];
+      theDiffusion.writePtr = writeImagePtr->getArray() + usChannel * channelSize;
+      parallelFor( theDiffusion, &SDiffusion<T>::range, theDiffusion.itemCount() );
+    }
+    readImagePtr.swap( writeImagePtr );
+    PROG_VAL( ulIteration + 1 );
+  }
+  PROG_RESET();
+  setOutput( readImagePtr );
+}
+
+/**
+ * Additive operator splitting (Weickert, ter Haar Romeny and Viergever 1998):
+ * \f$ u' = \frac{1}{m} \sum_{l=1}^m ( I - m \tau A_l(u) )^{-1} u \f$
+ * with one tridiagonal system per line along each of the m axes. The
+ * diffusivity between two neighbours is g(d) = flux(d) / d of their difference.
+ * The scheme is stable for any time step and keeps the values inside the input
+ * range. "Iterations" steps of size "Time" / "Iterations" are performed, the
+ * "lambda" and "Neighbourhood" parameters are ignored. All voxels are filtered,
+ * the image borders are reflecting. Each axis distributes its lines to
+ * CPipelineItem::getNumberOfThreads() threads.
+ * \param anImage image or volume to filter in place
+ * \param minimum smallest value of anImage
+ * \param maximum largest value of anImage
+ */
+template<typename TImageType> void CDiffusionFilter::diffuseSemiImplicit( TImageType& anImage,
+  const typename TImageType::TDataType minimum, const typename TImageType::TDataType maximum ) throw()
+{
+  typedef typename TImageType::TDataType T;
+  const ulong ulSteps = parameters.getUnsignedLong( "Iterations" );
+  const double dK = parameters.getDouble( "k" );
+  const double dAxes = static_cast<double>( anImage.getDimension() );
+
+  SSemiImplicit theSolver;
+  for( ushort d = 0; d < 3; ++d )
+    theSolver.extentArr[d] = ( d < anImage.getDimension() ) ? anImage.getExtent( d ) : 1;
+  theSolver.dStep = dAxes * parameters.getDouble( "Time" ) / static_cast<double>( ulSteps );
+  theSolver.dWeight = 1.0 / dAxes;
+
+  // Diffusivity table over the range of possible grey value differences
+  const double dRange = std::max( static_cast<double>( maximum ) - static_cast<double>( minimum ), 1.0 );
+  theSolver.sampleCount = getSampleCount( dRange, dK );
+  theSolver.dScale = theSolver.sampleCount / dRange;
+  vector<double> tableVec( theSolver.sampleCount + 2 );
+  for( size_t i = 0; i < tableVec.size(); ++i )
+  {
+    const double dDifference = ( i > 0 ) ? i / theSolver.dScale : 1.0e-3 / theSolver.dScale;
+    tableVec[i] = flushNegligible( flux( dDifference, dK ) / dDifference );
+  }
+  theSolver.diffusivityPtr = &tableVec[0];
+
+  const size_t channelSize = anImage.getArraySize() / anImage.getDataDimension();
+  vector<double> valueVec( channelSize );
+  vector<double> resultVec( channelSize );
+  PROG_MAX( ulSteps * anImage.getDataDimension() );
+  for( ushort usChannel = 0; usChannel < anImage.getDataDimension(); ++usChannel )
+  {
+    T* channelPtr = anImage.getArray() + usChannel * channelSize;
+    std::copy( channelPtr, channelPtr + channelSize, valueVec.begin() );
+    for( ulong ulStep = 0; ulStep < ulSteps; ++ulStep )
+    {
+      APP_PROC();
+      std::fill( resultVec.begin(), resultVec.end(), 0.0 );
+      theSolver.valuePtr = &valueVec[0];
+      theSolver.resultPtr = &resultVec[0];
+      for( theSolver.usAxis = 0; theSolver.usAxis < anImage.getDimension(); ++theSolver.usAxis )
+        parallelFor( theSolver, &SSemiImplicit::lines, theSolver.itemCount() );
+      valueVec.swap( resultVec );
+      PROG_VAL( usChannel * ulSteps + ulStep + 1 );
+    }
+    for( size_t i = 0; i < channelSize; ++i )
+    {
+      double dValue = valueVec[i];
+      if ( numeric_limits<T>::is_integer )
+        dValue = std::floor( dValue + 0.5 );
+      channelPtr[i] = static_cast<T>( std::min( std::max( dValue, static_cast<double>( minimum ) ),
+        static_cast<double>( maximum ) ) );
+    }
+  }
+  PROG_RESET();
+}
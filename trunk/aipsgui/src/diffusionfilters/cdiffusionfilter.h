@@ -0,0 +1,102 @@
+/************************************************************************
+ * File: cdiffusionfilter.h                                             *
+ * Project: AIPS - Diffusion filter plugin library                      *
+ * Description: Base class of all explicit nonlinear diffusion filters  *
+ *                                                                      *
+ * Author: Hendrik Belitz (h.belitz@fz-juelich.de)                      *
+ *                                                                      *
+ * Version: 0.2                                                         *
+ * Status : Beta                                                        *
+ * Created: 2026-10-17                                                  *
+ * Changed: 2026-10-17 Added the semi-implicit AOS scheme               *
+ ************************************************************************
+ * This program is free software; you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation; either version 2 of the License, or    *
+ * (at your option) any later version.                                  *
+ ************************************************************************/
+
+#ifndef CDIFFUSIONFILTER_H
+#define CDIFFUSIONFILTER_H
+
+// AIPS includes
+#include <cfilter.h>
+#include <aipsnumeric.h>
+#include <cglobalprogress.h>
+
+// lib includes
+#include "libid.h"
+
+using namespace aips;
+
+/**
+ * \brief Abstract base class of the explicit nonlinear diffusion filters.
+ *
+ * Each iteration computes
+ * \f$ u' = u + \lambda \sum_n w_n \psi( u_n - u ) \f$
+ * over the 4 or 8 neighbours of a pixel or the 6, 18 or 26 neighbours of a
+ * voxel. The weights w_n are 1 for face, 0.5 for edge and 0.333 for corner
+ * neighbours. Derived classes only supply the influence function
+ * \f$ \psi(d) = d \cdot g(d) \f$ by reimplementing flux().
+ *
+ * flux() is only evaluated while a lookup table is built. For integer images
+ * the table holds every possible grey value difference. For floating point
+ * images it samples the difference range and is interpolated linearly. Two
+ * buffers are used alternately and the slices of each iteration are processed
+ * by several threads. Border voxels keep their input values.
+ *
+ * If the parameter "Scheme" is 1, the semi-implicit AOS scheme is used
+ * instead (see diffuseSemiImplicit()). It only uses the face neighbours and
+ * reaches the diffusion time "Time" in "Iterations" steps of any size.
+ *
+ * The derived classes must initialise the parameters "Iterations", "k",
+ * "lambda" and "Neighbourhood".
+ */
+class CDiffusionFilter : public CFilter
+{
+private:
+  /// Standard constructor
+  CDiffusionFilter();
+  /// Copy constructor
+  CDiffusionFilter( CDiffusionFilter& );
+  /// Assignment operator
+  CDiffusionFilter& operator=( CDiffusionFilter& );
+public:
+/* Structors */
+  /// Constructor
+  CDiffusionFilter( ulong ulID, const std::string &sName = "Generic diffusion filter",
+		const ushort usNoOfInputs = 1, const ushort usNoOfOutputs = 1,
+		const std::string &sClassName_ = "CDiffusionFilter", const std::string &sClassVersion_ = "0.2",
+		const std::string &sDerivedFrom_ = "CFilter" ) throw();
+  /// Destructor
+  virtual ~CDiffusionFilter()
+    throw();
+/* Other methods */
+  /// Reimplemented from CPipelineItem
+  virtual void apply()
+    throw();
+  /// Reimplemented from CPipelineItem
+  virtual CDataSetRegion getRequiredInputRegion( unsigned short usInputNumber,
+    const CDataSetRegion& anOutputRegion, const std::vector<size_t>& inputExtentVec ) const
+    throw();
+protected:
+  /// Returns the influence function psi(d) = d * g(d) for a grey value difference
+  virtual double flux( const double dDifference, const double dK ) const
+    throw() = 0;
+  /// Returns the largest stable integration constant
+  virtual double getMaximumLambda( const ushort usDimension, const ulong ulNeighbourhood ) const
+    throw();
+  /// Reimplemented from CPipelineItem
+  virtual size_t getStreamingMargin() const
+    throw();
+private:
+  /// Diffuses an image or volume
+  template<typename TImageType> void diffuseImage()
+    throw();
+  /// Diffuses an image or volume with the semi-implicit AOS scheme
+  template<typename TImageType> void diffuseSemiImplicit( TImageType& anImage,
+    const typename TImageType::TDataType minimum, const typename TImageType::TDataType maximum )
+    throw();
+};
+
+#endif
@@ -6,28 +6,22 @@
  *              and Integration constant (lambda)                      *
  *                                                                     *
  * Author: Joaquin Castellanos                                         *                                                                     *
- * Version: 0.2                                                        *
+ * Version: 0.3                                                        *
  * Status : Beta                                                       *
  * Created: 2004-04-16                                                 *
  * Changed: 2004-04-22 New parameter definition to determine the number*
  *                      of neighbours to be considered in the operation*
  *          2004-06-16 Incorporated some corrections and optimizations *
+ *          2026-10-17 Added region streaming support                  *
+ *                     Uses the diffusion engine of                    *
+ *                     CDiffusionFilter                                *
  ***********************************************************************/
 
 #ifndef CPMAD2FILTER_H
 #define CPMAD2FILTER_H
 
-// Standard includes
-#include <algorithm>
-
 // AIPS includes
-#include <cfilter.h>
-#include <aipsnumbertraits.h>
-#include <diffusiondefs.h>
-#include <cglobalprogress.h>
-#ifdef BENCHMARK
-#include <boost/timer.hpp>
-#endif
+#include "cdiffusionfilter.h"
 
 // lib includes
 #include "libid.h"
@@ -35,7 +29,7 @@
 using namespace aips;
 
 /** A Anisotropic Diffusion filter */
-class CPMAD2Filter : public CFilter
+class CPMAD2Filter : public CDiffusionFilter
 {
 private:
   /// Standard constructor
@@ -56,11 +50,10 @@ public:
   /// Reimplemented from CPipelineItem
   virtual CPipelineItem* newInstance( ulong ulID = 0 ) const
     throw();
-  /// Reimplemented from CPipelineItem  
-  virtual void apply()
+protected:
+  /// Reimplemented from CDiffusionFilter
+  virtual double flux( const double dDifference, const double dK ) const
     throw();
-private:
-	template<typename T> void filter() throw();	
 };
 
 #endif
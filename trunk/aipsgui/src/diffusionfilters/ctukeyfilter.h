@@ -6,26 +6,20 @@
  *              and Integration constant (lambda)                      *
  *                                                                     *
  * Author: Joaquin Castellanos                                         *                                                                     *
- * Version: 0.1                                                        *
+ * Version: 0.2                                                        *
  * Status : Beta                                                       *
  * Created: 2004-04-26                                                 *
  * Changed: 2004-06-16 Incorporated some corrections and optimizations *
+ *          2026-10-17 Added region streaming support                  *
+ *                     Uses the diffusion engine of                    *
+ *                     CDiffusionFilter                                *
  ***********************************************************************/
 
 #ifndef CTUKEYFILTER_H
 #define CTUKEYFILTER_H
 
-// Standard includes
-#include <algorithm>
-
 // AIPS includes
-#include <cfilter.h>
-#include <aipsnumbertraits.h>
-#include <diffusiondefs.h>
-#include <cglobalprogress.h>
-#ifdef BENCHMARK
-#include <boost/timer.hpp>
-#endif
+#include "cdiffusionfilter.h"
 
 // lib includes
 #include "libid.h"
@@ -33,7 +27,7 @@
 using namespace aips;
 
 /** A Anisotropic Diffusion filter */
-class CTukeyFilter : public CFilter
+class CTukeyFilter : public CDiffusionFilter
 {
 private:
   /// Standard constructor
@@ -54,11 +48,10 @@ public:
   /// Reimplemented from CPipelineItem
   virtual CPipelineItem* newInstance( ulong ulID = 0 ) const
     throw();
-  /// Reimplemented from CPipelineItem  
-  virtual void apply()
+protected:
+  /// Reimplemented from CDiffusionFilter
+  virtual double flux( const double dDifference, const double dK ) const
     throw();
-private:
-	template<typename T> void filter() throw();		
 };
 
 #endif
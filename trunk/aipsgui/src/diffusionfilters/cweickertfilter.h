@@ -6,25 +6,20 @@
  *              and Integration constant (lambda)                      *
  *                                                                     *
  * Author: Joaquin Castellanos                                         *                                                                     *
- * Version: 0.1                                                        *
+ * Version: 0.2                                                        *
  * Status : Beta                                                       *
  * Created: 2004-04-27                                                 *
  * Changed: 2004-06-16 Incorporated some corrections and optimizations *
+ *          2026-10-17 Added region streaming support                  *
+ *                     Uses the diffusion engine of                    *
+ *                     CDiffusionFilter                                *
  ***********************************************************************/
 
 #ifndef CWEICKERTFILTER_H
 #define CWEICKERTFILTER_H
 
-// Standard includes
-#include <algorithm>
-
 // AIPS includes
-#include <cfilter.h>
-#include <diffusiondefs.h>
-#include <cglobalprogress.h>
-#ifdef BENCHMARK
-#include <boost/timer.hpp>
-#endif
+#include "cdiffusionfilter.h"
 
 // lib includes
 #include "libid.h"
@@ -32,7 +27,7 @@
 using namespace aips;
 
 /**  Anisotropic Diffusion filter */
-class CWeickertFilter : public CFilter
+class CWeickertFilter : public CDiffusionFilter
 {
 private:
   /// Standard constructor
@@ -56,8 +51,13 @@ public:
   /// Reimplemented from CPipelineItem  
   virtual void apply()
     throw();
+protected:
+  /// Reimplemented from CDiffusionFilter
+  virtual double flux( const double dDifference, const double dK ) const
+    throw();
 private:
-	template<typename T> void filter() throw();
+  double dCm; ///< Constant of Weickert's function
+  double dM;  ///< Exponent m of Weickert's function
 };
 
 #endif
@@ -25,8 +25,13 @@ CCentralDifference::CCentralDifference(ulong ulID_ ) throw()
                    "** Input ports:\n"
                    "0: A scalar single channel 2D or 3D data set (image data, required)\n"
                    "** Output ports:\n"
-                   "1: A 2D or 3D vector field which is normalized";
+                   "1: A 2D or 3D vector field which is normalized\n"
+                   "** Parameters:\n"
+                   "Normalize: Divide the field by its largest vector. Otherwise the field\n"
+                   " can be computed region by region (streaming)";
 
+	parameters.initBool( "Normalize", true );
+	enableStreaming();
   inputsVec[0].portType = CPipelineItem::IOInteger;
   outputsVec[0].portType = CPipelineItem::IOVector;
 }
@@ -61,10 +66,11 @@ BENCHSTART;
 			dMaxGradient = std::max( dMaxGradient, norm(vec) );
 			(*output)(x,y) = vec;
 		}
-	for( TField2D::iterator it = output->begin(); it != output->end(); ++it )
-	{
-		(*it)/=dMaxGradient;
-	}	
+	if ( parameters.getBool( "Normalize" ) )
+		for( TField2D::iterator it = output->begin(); it != output->end(); ++it )
+		{
+			(*it)/=dMaxGradient;
+		}	
 	setOutput( output );
 BENCHSTOP;		
 }
@@ -73,3 +79,20 @@ CPipelineItem* CCentralDifference::newInstance( ulong ulID ) const throw()
 {
 	return new CCentralDifference( ulID );
 }
+
+/**
+ * The normalization depends on the largest gradient of the whole image
+ * \returns true if "Normalize" is off
+ */
+bool CCentralDifference::isStreamable() const throw()
+{
+	return CFilter::isStreamable() && !parameters.getBool( "Normalize" );
+}
+
+/**
+ * \returns 1, the radius of the difference operator
+ */
+size_t CCentralDifference::getStreamingMargin() const throw()
+{
+	return 1;
+}
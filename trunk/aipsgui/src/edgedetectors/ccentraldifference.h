@@ -8,7 +8,7 @@
  * Version: 0.1                                                         *
  * Status:  Pre-Alpha                                                   *
  * Created: 2004-05-10                                                  *
- * Changed:                                                             *
+ * Changed: 2026-10-17 Added parameter "Normalize" and streaming        *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -36,6 +36,11 @@ public:
   ~CCentralDifference()throw();
 	void apply() throw();
 	virtual CPipelineItem* newInstance( ulong ulID = 0 ) const throw();  
+	/// Reimplemented from CPipelineItem. Unnormalized fields can be computed region by region
+	virtual bool isStreamable() const throw();
+protected:
+	/// Reimplemented from CPipelineItem
+	virtual size_t getStreamingMargin() const throw();
 };
 
 #endif
@@ -15,14 +15,67 @@
 #include "cfoerstner.h"
 #include <cfloat>
 
+// AIPS includes
+#include <cdatablock.h>
+#include <crecursivegaussian.h>
+
 using namespace std;
 
+namespace
+{
+
+/**
+ * \returns the rounded 2D operator output of a structure tensor or 0 if the
+ * roundness is below the threshold
+ */
+double response2D( const double gx, const double gy, const double gxgy, const double dThreshold )
+{
+	double operatorOutput = 0.0; 
+	if ( std::abs(gx) > numeric_limits<double>::epsilon() 
+		|| std::abs(gy) > numeric_limits<double>::epsilon() )
+	{
+		// Determine curvature
+		double dNumerator = ( gx * gy )  - ( gxgy * gxgy );						
+		double dDenominator = ( gx + gy ) / 2.0;				
+		// Only set output if operator response is greater or equal to specified threshold
+		if ( ( dNumerator / pow( dDenominator, 2 ) ) >= dThreshold )
+			operatorOutput = round( std::abs( dNumerator / dDenominator ) * 255.0 );
+	}
+	return operatorOutput;
+}
+
+/**
+ * \returns the rounded 3D operator output of a structure tensor or 0 if the
+ * roundness is below the threshold
+ */
+double response3D( const double gx, const double gy, const double gz, const double gxgy,
+	const double gxgz, const double gygz, const double dThreshold )
+{
+	double operatorOutput = 0.0; 
+	if ( std::abs(gx) > numeric_limits<double>::epsilon() 
+		|| std::abs(gy) > numeric_limits<double>::epsilon() 
+		|| std::abs(gz) > numeric_limits<double>::epsilon() )
+	{
+		// Determine curvature
+		double dNumerator = ( gx * gy * gz )  - ( gx * gygz * gygz ) 
+			+ ( gxgy * gygz * gxgz ) - ( gz * gxgy * gxgy )
+			+ ( gxgz * gxgy * gygz ) - ( gy * gxgz * gxgz );
+		double dDenominator = ( gx + gy + gz ) / 3.0;			
+		// Only set output if operator response is greater or equal to specified threshold
+		if ( ( dNumerator / pow( dDenominator, 3 ) ) >= dThreshold )
+			operatorOutput = round( std::abs( dNumerator / dDenominator ) * 255.0 );
+	}
+	return operatorOutput;
+}
+
+}
+
 /*************
  * Structors *
  *************/
 
 CFoerstner::CFoerstner(ulong ulID_ ) throw()
-  : CFilter(ulID_, "Foerstner-Operator", 1, 1, "CFoerstner", "0.1", "CFilter") 
+  : CFilter(ulID_, "Foerstner-Operator", 1, 1, "CFoerstner", "0.4", "CFilter") 
 {
   setModuleID( sLibID );
   
@@ -32,9 +85,11 @@ CFoerstner::CFoerstner(ulong ulID_ ) throw()
                    "** Output ports:\n"
                    "1: A scalar field of detected corners\n"
 									 "** Parameters:\n"
-									 "Significant point threshold: Threshold to exclude unsignifant points";
+									 "Significant point threshold: Threshold to exclude unsignifant points\n"
+									 "Sigma: Integration scale of the structure tensor (0 - 3x3 neighbourhood)";
 
 	parameters.initDouble( "Significant point threshold", 0.5, 0.0, 10.0 );
+	parameters.initDouble( "Sigma", 0.0, 0.0, 100.0 );
 									 
   inputsVec[0].portType = CPipelineItem::IOVector;
   outputsVec[0].portType = CPipelineItem::IOInteger;
@@ -61,9 +116,13 @@ void CFoerstner::apply() throw()
     	alog << LWARN << SERROR("Input type is no 2D or 3D image!") << endl;
     	return;
 		}
+		else if ( parameters.getDouble( "Sigma" ) > 0.0 )
+			gaussianTensor<3>( *inputPtr3D );
 		else
 			apply3D( inputPtr3D );
   }
+	else if ( parameters.getDouble( "Sigma" ) > 0.0 )
+		gaussianTensor<2>( *inputPtr );
 	else
 		apply2D( inputPtr );	
 	BENCHSTOP;	
@@ -110,17 +169,7 @@ void CFoerstner::apply2D( TField2D* inputPtr ) throw()
 				+ image(x+1,y-1)[0]*image(x+1,y-1)[1] + image(x-1,y-1)[0]*image(x-1,y-1)[1] 
 			  + image(x,y+1)[0]*image(x,y+1)[1] + image(x+1,y+1)[0]*image(x+1,y+1)[1] 
 				+ image(x-1,y+1)[0] * image(x-1,y+1)[1]	)	/ 9.0;
-			double operatorOutput = 0.0; 
-			if ( std::abs(gx) > numeric_limits<double>::epsilon() 
-				|| std::abs(gy) > numeric_limits<double>::epsilon() )
-			{
-				// Determine curvature
-				double dNumerator = ( gx * gy )  - ( gxgy * gxgy );						
-				double dDenominator = ( gx + gy ) / 2.0;				
-				// Only set output if operator response is greater or equal to specified threshold
-				if ( ( dNumerator / pow( dDenominator, 2 ) ) >= dThreshold )
-					operatorOutput = round( std::abs( dNumerator / dDenominator ) * 255.0 );
-			}
+			double operatorOutput = response2D( gx, gy, gxgy, dThreshold );
 			if ( operatorOutput < numeric_limits<ushort>::max() )
 				(*output)( x, y ) = static_cast<ushort>( operatorOutput );
 			else
@@ -247,20 +296,7 @@ void CFoerstner::apply3D( TField3D* inputPtr ) throw()
 				+ image(x+1,y-1,z+1)[2]*image(x+1,y-1,z+1)[1] + image(x-1,y-1,z+1)[2]*image(x-1,y-1,z+1)[1] 
 			  + image(x,y+1,z+1)[2]*image(x,y+1,z+1)[1] + image(x+1,y+1,z+1)[2]*image(x+1,y+1,z+1)[1] 
 				+ image(x-1,y+1,z+1)[2] * image(x-1,y+1,z+1)[1]	)	;
-			double operatorOutput = 0.0; 
-			if ( std::abs(gx) > numeric_limits<double>::epsilon() 
-				|| std::abs(gy) > numeric_limits<double>::epsilon() 
-				|| std::abs(gz) > numeric_limits<double>::epsilon() )
-			{
-				// Determine curvature
-				double dNumerator = ( gx * gy * gz )  - ( gx * gygz * gygz ) 
-					+ ( gxgy * gygz * gxgz ) - ( gz * gxgy * gxgy )
-					+ ( gxgz * gxgy * gygz ) - ( gy * gxgz * gxgz );
-				double dDenominator = ( gx + gy + gz ) / 3.0;			
-				// Only set output if operator response is greater or equal to specified threshold
-				if ( ( dNumerator / pow( dDenominator, 3 ) ) >= dThreshold )
-					operatorOutput = round( std::abs( dNumerator / dDenominator ) * 255.0 );
-			}
+			double operatorOutput = response3D( gx, gy, gz, gxgy, gxgz, gygz, dThreshold );
 			if ( operatorOutput < numeric_limits<ushort>::max() )
 				(*output)( x, y, z ) = static_cast<ushort>( operatorOutput );
 			else
@@ -271,3 +307,59 @@ void CFoerstner::apply3D( TField3D* inputPtr ) throw()
 	setOutput( output );
 	PROG_RESET();
 }
+
+/**
+ * The products of the gradient components are averaged with a recursive
+ * gaussian of width "Sigma" (see CRecursiveGaussian), which takes the same time
+ * for every integration scale. The border is handled by extending the field.
+ * \param aField a 2D or 3D gradient vector field
+ */
+template<unsigned int D, typename TFieldType> void CFoerstner::gaussianTensor( const TFieldType& aField )
+	throw()
+{
+	bModuleReady = true;
+  deleteOldOutput();	
+	boost::shared_ptr<TImage> output ( new TImage( D, aField.getExtents() ) );
+	output->setMinimum( 0 );
+	output->setMaximum( 0 );
+	double dThreshold = parameters.getDouble( "Significant point threshold" );
+
+	size_t extentArr[3] = { 1, 1, 1 };
+	for( unsigned short a = 0; a < D; ++a )
+		extentArr[a] = aField.getExtent( a );
+	const size_t voxelCount = extentArr[0] * extentArr[1] * extentArr[2];
+	// Tensor components xx, yy (, zz), xy (, xz, yz), one plane each
+	const unsigned short usComponents = D * ( D + 1 ) / 2;
+	CDataBlock<double> tensorBlock( usComponents * voxelCount, false );
+	double* tensorPtrArr[6];
+	for( unsigned short c = 0; c < usComponents; ++c )
+		tensorPtrArr[c] = tensorBlock.getData() + c * voxelCount;
+	for( size_t i = 0; i < voxelCount; ++i )
+	{
+		const typename TFieldType::TDataType& theGradient = aField[i];
+		unsigned short c = 0;
+		for( unsigned short a = 0; a < D; ++a )
+			tensorPtrArr[c++][i] = theGradient[a] * theGradient[a];
+		for( unsigned short a = 0; a < D; ++a )
+			for( unsigned short b = a + 1; b < D; ++b )
+				tensorPtrArr[c++][i] = theGradient[a] * theGradient[b];
+	}
+	const CRecursiveGaussian theGaussian( parameters.getDouble( "Sigma" ) );
+	for( unsigned short c = 0; c < usComponents; ++c )
+		theGaussian.smooth( tensorPtrArr[c], extentArr );
+
+	TImage::TDataType* outputArr = output->getArray();
+	for( size_t i = 0; i < voxelCount; ++i )
+	{
+		double operatorOutput = ( D == 2 )
+			? response2D( tensorPtrArr[0][i], tensorPtrArr[1][i], tensorPtrArr[2][i], dThreshold )
+			: response3D( tensorPtrArr[0][i], tensorPtrArr[1][i], tensorPtrArr[2][i],
+				tensorPtrArr[3][i], tensorPtrArr[4][i], tensorPtrArr[5][i], dThreshold );
+		if ( operatorOutput < numeric_limits<ushort>::max() )
+			outputArr[i] = static_cast<ushort>( operatorOutput );
+		else
+			outputArr[i] = numeric_limits<ushort>::max();
+		output->adjustDataRange( outputArr[i] );
+	}
+	setOutput( output );
+}
@@ -5,11 +5,12 @@
  *                                                                      *
  * Author: Hendrik Belitz (h.belitz@fz-juelich.de)                      *
  *                                                                      *
- * Version: 0.3                                                         *
+ * Version: 0.4                                                         *
  * Status:  Alpha                                                       *
  * Created: 2004-05-10                                                  *
  * Changed: 2004-06-18 Added support for 3D fields                      *
  *          2004-07-02 Updated documentation                            *
+ *          2026-10-17 Added gaussian integration scale                 *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -30,7 +31,9 @@ using namespace aips;
 
 /** 
  * Computes the Foerstner corner measurement for 2D and 3D fields. 
- * 3D computation is done via the generalization of the operartor by Rohr
+ * 3D computation is done via the generalization of the operartor by Rohr.
+ * If "Sigma" is greater than 0, the structure tensor is averaged with a
+ * recursive gaussian instead of the 3x3 (3x3x3) neighbourhood.
  */
 class CFoerstner : public CFilter
 {
@@ -57,6 +60,9 @@ private:
 	void apply2D( TField2D* inputPtr ) throw();
 	/// Apply filter to a 3D field
 	void apply3D( TField3D* inputPtr ) throw();
+	/// Apply filter with a gaussian weighted structure tensor
+	template<unsigned int D, typename TFieldType> void gaussianTensor( const TFieldType& aField )
+		throw();
 };
 	
 #endif
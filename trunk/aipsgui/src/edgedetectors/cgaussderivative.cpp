@@ -15,6 +15,10 @@
 
 #include "cgaussderivative.h"
 
+// AIPS includes
+#include <ccomponentplanes.h>
+#include <crecursivegaussian.h>
+
 using namespace std;
 
 /*************
@@ -25,7 +29,7 @@ using namespace std;
  * \param ulID unique module ID
  */
 CGaussDerivative::CGaussDerivative( ulong ulID ) throw()
-: CFilter( ulID, "Gauss gradient", 2, 1, "CGaussDerivative", "0.2", "CFilter" ) 
+: CFilter( ulID, "Gauss gradient", 2, 1, "CGaussDerivative", "0.3", "CFilter" ) 
 {
   setModuleID( sLibID );
   
@@ -36,9 +40,15 @@ CGaussDerivative::CGaussDerivative( ulong ulID ) throw()
                    "** Output ports:\n"
                    "0: A 2D or 3D vector field which is normalized\n"
 									 "** Parameters:\n"
-									 "Sigma: Width of gaussian";
+									 "Sigma: Width of gaussian\n"
+									 "Method: 0 - derivative mask, 1 - recursive gaussian (fast for large Sigma)\n"
+									 "Normalize: Divide the field by its largest vector. Otherwise the field\n"
+									 " can be computed region by region with method 0 (streaming)";
 
 	parameters.initDouble( "Sigma", 0.5, 0.0, 100.0 );
+	parameters.initUnsignedLong( "Method", 0, 0, 1 );
+	parameters.initBool( "Normalize", true );
+	enableStreaming();
 	
   inputsVec[0].portType = CPipelineItem::IOInteger;
 	inputsVec[1].portType = CPipelineItem::IOInteger;
@@ -57,14 +67,12 @@ void CGaussDerivative::apply() throw()
 {
 BENCHSTART;
 	bModuleReady = false;
-cerr << "A" << endl;	
   TImage* inputPtr = static_cast<TImage*>( getInput().get() );
   if ( inputPtr == NULL || inputPtr->getDimension() < 2 || inputPtr->getDimension() > 3 )
   {
     alog << LWARN << SERROR("Input type is no 2D or 3D image!") << endl;
     return;
   }
-cerr << "B" << endl;
 	bModuleReady = true;
 	bRoiSelf = false;
 	roiPtr = static_cast<TImage*>( getInput(1).get() );
@@ -72,15 +80,20 @@ cerr << "B" << endl;
 	{
 		bRoiSelf = true;
 	}
-cerr << "C" << endl;
   deleteOldOutput();	
-	if ( inputPtr->getDimension() == 2 )
+	if ( parameters.getUnsignedLong( "Method" ) == 1 )
+	{
+		if ( inputPtr->getDimension() == 2 )
+			recursiveGauss<2, TField2D>();
+		else
+			recursiveGauss<3, TField3D>();
+	}
+	else if ( inputPtr->getDimension() == 2 )
 		gauss2D();
 	else 
 	{
 		gauss3D();		
 	}
-cerr << "D" << endl;
 BENCHSTOP;		
 }
 
@@ -89,6 +102,25 @@ CPipelineItem* CGaussDerivative::newInstance( ulong ulID ) const throw()
   return new CGaussDerivative( ulID );
 }
 
+/**
+ * The normalization depends on the largest gradient of the whole image and the
+ * recursive gaussian has an infinite impulse response.
+ * \returns true if "Normalize" is off and "Method" is 0
+ */
+bool CGaussDerivative::isStreamable() const throw()
+{
+	return CFilter::isStreamable() && !parameters.getBool( "Normalize" )
+		&& parameters.getUnsignedLong( "Method" ) == 0;
+}
+
+/**
+ * \returns half the size of the derivative mask
+ */
+size_t CGaussDerivative::getStreamingMargin() const throw()
+{
+	return getMaskSize() / 2;
+}
+
 /*******************
  * Private methods *
  *******************/
@@ -100,7 +132,7 @@ CPipelineItem* CGaussDerivative::newInstance( ulong ulID ) const throw()
 vector<double> CGaussDerivative::computeMask( int& iMaskSize ) throw()
 {
 	double dSigma = parameters.getDouble( "Sigma" );
-	iMaskSize = static_cast<uint>( floor( 6.0 * dSigma + 0.5 ) ) + 1;
+	iMaskSize = getMaskSize();
 	double dDenominator = dSigma * dSigma;
 	vector<double> dGaussMask;
 	for( int i = -( iMaskSize / 2 ); i <= ( iMaskSize / 2 ); ++i )
@@ -112,9 +144,16 @@ vector<double> CGaussDerivative::computeMask( int& iMaskSize ) throw()
 	return dGaussMask;
 }
 
+/**
+ * \returns 6 Sigma + 1, rounded
+ */
+int CGaussDerivative::getMaskSize() const throw()
+{
+	return static_cast<uint>( floor( 6.0 * parameters.getDouble( "Sigma" ) + 0.5 ) ) + 1;
+}
+
 void CGaussDerivative::gauss2D() throw()
 {
-cerr << "Here" << endl;
 	TImage* inputPtr = static_cast<TImage*>( getInput().get() );
   double dMaxGradient = 0.0;
  	ushort w = inputPtr->getExtent( 0 );
@@ -153,7 +192,8 @@ cerr << "Here" << endl;
 	for( TField2D::iterator outputIt = outputPtr->begin(); 
 		outputIt != outputPtr->end();	++outputIt )
 	{
-		(*outputIt) /= dMaxGradient;
+		if ( parameters.getBool( "Normalize" ) )
+			(*outputIt) /= dMaxGradient;
 		if ( norm(*outputIt) < numeric_limits<double>::epsilon() )
 		{
 			(*outputIt) = 0.0;	
@@ -161,7 +201,6 @@ cerr << "Here" << endl;
 	}
 	PROG_RESET();
   setOutput( outputPtr );
-cerr << "Done" << endl;  
 }
 
 void CGaussDerivative::gauss3D() throw()
@@ -208,7 +247,8 @@ void CGaussDerivative::gauss3D() throw()
 	for( TField3D::iterator outputIt = outputPtr->begin(); 
 		outputIt != outputPtr->end();	++outputIt )
 	{
-		(*outputIt) /= dMaxGradient;
+		if ( parameters.getBool( "Normalize" ) )
+			(*outputIt) /= dMaxGradient;
 		if ( norm(*outputIt) < numeric_limits<double>::epsilon() )
 		{
 			(*outputIt) = 0.0;	
@@ -219,6 +259,73 @@ void CGaussDerivative::gauss3D() throw()
 	setOutput( outputPtr );
 }
 
+/**
+ * The image is smoothed along all axes with the recursive gaussian, the gradient
+ * components are the central differences of the smoothed image. Both steps are
+ * split into lines and processed by several threads. As with the derivative mask
+ * the field is normalized by its largest vector if "Normalize" is set.
+ */
+template<unsigned int D, typename TFieldType> void CGaussDerivative::recursiveGauss() throw()
+{
+	typedef typename TFieldType::TDataType TVector;
+	TImage* inputPtr = static_cast<TImage*>( getInput().get() );
+	boost::shared_ptr<TFieldType> outputPtr ( new TFieldType( D, inputPtr->getExtents(),
+		inputPtr->getDataDimension() ) );
+	TVector minimum;
+	TVector maximum;
+	for( unsigned int c = 0; c < D; ++c )
+	{
+		minimum[c] = -1.0;
+		maximum[c] = 1.0;
+	}
+	outputPtr->setMaximum( maximum );
+	outputPtr->setMinimum( minimum );
+	(*outputPtr) = TVector();
 
+	CComponentPlanes<TVector, D> gradientPlanes( inputPtr->getExtents() );
+	size_t extentArr[3];
+	for( unsigned short a = 0; a < 3; ++a )
+		extentArr[a] = gradientPlanes.getExtent( a );
+	const size_t voxelCount = gradientPlanes.getPlaneSize();
+	CDataBlock<double> smoothedBlock( voxelCount, false );
+	double* smoothedPtr = smoothedBlock.getData();
+	const TImage::TDataType* inputArr = inputPtr->getArray();
+	std::copy( inputArr, inputArr + voxelCount, smoothedPtr );
 
+	const CRecursiveGaussian theGaussian( parameters.getDouble( "Sigma" ) );
+	theGaussian.smooth( smoothedPtr, extentArr );
+	for( unsigned short c = 0; c < D; ++c )
+		CRecursiveGaussian::differentiateAxis( smoothedPtr, gradientPlanes.getPlane( c ), extentArr, c );
 
+	// Mask out voxels outside the region of interest and determine the largest gradient
+	double dMaxGradient = 0.0;
+	for( size_t i = 0; i < voxelCount; ++i )
+	{
+		if ( !bRoiSelf && (*roiPtr)[i] == 0 )
+		{
+			for( unsigned short c = 0; c < D; ++c )
+				gradientPlanes.getPlane( c )[i] = 0.0;
+			continue;
+		}
+		double dSquaredNorm = 0.0;
+		for( unsigned short c = 0; c < D; ++c )
+			dSquaredNorm += gradientPlanes.getPlane( c )[i] * gradientPlanes.getPlane( c )[i];
+		dMaxGradient = std::max( dMaxGradient, dSquaredNorm );
+	}
+	dMaxGradient = sqrt( dMaxGradient );
+
+	// Normalize field
+	if ( dMaxGradient > 0.0 && parameters.getBool( "Normalize" ) )
+		for( unsigned short c = 0; c < D; ++c )
+		{
+			double* planePtr = gradientPlanes.getPlane( c );
+			for( size_t i = 0; i < voxelCount; ++i )
+				planePtr[i] /= dMaxGradient;
+		}
+	gradientPlanes.toField( *outputPtr );
+	for( typename TFieldType::iterator outputIt = outputPtr->begin();
+		outputIt != outputPtr->end(); ++outputIt )
+		if ( norm( *outputIt ) < numeric_limits<double>::epsilon() )
+			(*outputIt) = TVector();
+	setOutput( outputPtr );
+}
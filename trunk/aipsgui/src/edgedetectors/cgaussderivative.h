@@ -5,11 +5,13 @@
  *                                                                      *
  * Author: Hendrik Belitz (h.belitz@fz-juelich.de)                      *
  *                                                                      *
- * Version: 0.1                                                         *
+ * Version: 0.3                                                         *
  * Status:  Alpha                                                       *
  * Created: 2004-06-23                                                  *
  * Changed: 2004-07-02 Added 3D version of filter                       *
  *                     Updated documentation                            *
+ *          2026-10-17 Added recursive filtering                        *
+ *                     Added parameter "Normalize" and streaming        *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -31,7 +33,17 @@
 
 using namespace aips;
   
-/** This one generates a vector field from an image using the gauss gradient operator */
+/**
+ * This one generates a vector field from an image using the gauss gradient operator.
+ *
+ * "Method" 0 applies a 1D derivative mask of size 6 Sigma + 1 along each axis and
+ * leaves a border of half the mask size empty. "Method" 1 smooths the image with
+ * a recursive gaussian (CRecursiveGaussian) and takes central differences. Its
+ * cost does not depend on Sigma and the border is extended, so the whole image
+ * is processed.
+ *
+ * Without "Normalize", "Method" 0 can be computed region by region (streaming).
+ */
 class CGaussDerivative : public CFilter
 {
 private:
@@ -56,6 +68,13 @@ public:
   /// Reimplemented from CPipelineItem  
   virtual CPipelineItem* newInstance( ulong ulID = 0 ) const 
 		throw();  
+  /// Reimplemented from CPipelineItem
+  virtual bool isStreamable() const
+		throw();
+protected:
+  /// Reimplemented from CPipelineItem
+  virtual size_t getStreamingMargin() const
+		throw();
 private:
 	TImage* roiPtr; ///< Region of interest
 	bool bRoiSelf;  ///< Is aoi generated by the filter?
@@ -65,9 +84,15 @@ private:
 	/// 3D Gauss derivative operator
 	void gauss3D()
 		throw();
+	/// Recursive gauss derivative operator
+	template<unsigned int D, typename TFieldType> void recursiveGauss()
+		throw();
 	/// Compute gaussian derivative mask
 	std::vector<double> computeMask( int& iMaskSize )
 		throw();
+	/// Returns the size of the derivative mask
+	int getMaskSize() const
+		throw();
 };
 
 #endif
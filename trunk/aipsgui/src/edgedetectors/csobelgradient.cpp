@@ -36,9 +36,13 @@ CSobelGradient::CSobelGradient( ulong ulID ) throw()
                    "** Output ports:\n"
                    "1: A 2D or 3D vector field which is normalized\n"
 									 "** Parameters:\n"
-									 "3D Method: Choose filter kernel ( see code )";
+									 "3D Method: Choose filter kernel ( see code )\n"
+									 "Normalize: Divide the field by its largest vector. Otherwise the field\n"
+									 " can be computed region by region (streaming)";
 
 	parameters.initBool( "3D Method", false );
+	parameters.initBool( "Normalize", true );
+	enableStreaming();
   inputsVec[0].portType = CPipelineItem::IOInteger;
 	inputsVec[1].portType = CPipelineItem::IOInteger;
   outputsVec[0].portType = CPipelineItem::IOVector;
@@ -92,6 +96,23 @@ CPipelineItem* CSobelGradient::newInstance( ulong ulID ) const throw()
   return new CSobelGradient( ulID );
 }
 
+/**
+ * The normalization depends on the largest gradient of the whole image
+ * \returns true if "Normalize" is off
+ */
+bool CSobelGradient::isStreamable() const throw()
+{
+	return CFilter::isStreamable() && !parameters.getBool( "Normalize" );
+}
+
+/**
+ * \returns 1, the radius of the sobel operator
+ */
+size_t CSobelGradient::getStreamingMargin() const throw()
+{
+	return 1;
+}
+
 /* Private methods */
 
 void CSobelGradient::sobel2D() throw()
@@ -137,11 +158,12 @@ PROG_MAX( h - 1 );
 		}
 	}
 APP_PROC();	
-	for( TField2D::iterator outputIt = outputPtr->begin(); outputIt != outputPtr->end();
-		++outputIt )
-	{
-		(*outputIt) /= dMaxGradient;
-	}
+	if ( parameters.getBool( "Normalize" ) )
+		for( TField2D::iterator outputIt = outputPtr->begin(); outputIt != outputPtr->end();
+			++outputIt )
+		{
+			(*outputIt) /= dMaxGradient;
+		}
 PROG_RESET();
   setOutput( outputPtr );
   static_cast<TField2D*>( getOutput().get() );
@@ -296,11 +318,12 @@ PROG_MAX( d - 1 );
 			}
 		} /* end WHILE */	
 			
-	for( TField3D::iterator outputIt = outputPtr->begin(); outputIt != outputPtr->end();
-		++outputIt )
-	{
-		(*outputIt) /= dMaxGradient;
-	}
+	if ( parameters.getBool( "Normalize" ) )
+		for( TField3D::iterator outputIt = outputPtr->begin(); outputIt != outputPtr->end();
+			++outputIt )
+		{
+			(*outputIt) /= dMaxGradient;
+		}
 	PROG_RESET();	
 	
 	setOutput( outputPtr );
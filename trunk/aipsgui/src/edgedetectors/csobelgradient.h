@@ -14,6 +14,7 @@
  *          2004-05-05 Sobel filter now uses TImage::iterator           *
  *          2004-06-21 Corrected an error which resulted in false 3D    *
  *                      operator values                                 * 
+ *          2026-10-17 Added parameter "Normalize" and streaming        *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -59,6 +60,13 @@ public:
   /// Reimplemented from CPipelineItem  
   virtual CPipelineItem* newInstance( ulong ulID = 0 ) const 
 		throw();  
+  /// Reimplemented from CPipelineItem. Unnormalized fields can be computed region by region
+  virtual bool isStreamable() const
+		throw();
+protected:
+  /// Reimplemented from CPipelineItem
+  virtual size_t getStreamingMargin() const
+		throw();
 private:
 	TImage* roiPtr; ///< Region of interest
 	bool bRoiSelf; ///< Is aoi generated by the filter?
@@ -15,18 +15,77 @@
 
 #include "cdivergence.h"
 
+// Standard includes
+#include <algorithm>
+#include <vector>
+
+// AIPS includes
+#include <aipsparallel.h>
+#include <ccomponentplanes.h>
+
 using namespace std;
 using namespace boost;
 
+namespace
+{
+
+/**
+ * Central difference divergence on component planes, shared by all workers.
+ * A worker processes a range of inner slices of a volume or inner rows of an image.
+ */
+template<unsigned int D> struct SDivergence
+{
+	const double* planePtrArr[D]; ///< Components of the field
+	short* outputPtr;             ///< Output image
+	size_t extentArr[3];          ///< Field extents (1 for missing dimensions)
+	double dScale;                ///< Grey value change per unit of the summed differences
+	double dMaximum;              ///< Largest grey value
+
+	/// Number of work items: inner slices of volumes, inner rows of images
+	size_t itemCount() const
+	{
+		return ( D == 3 ) ? extentArr[2] - 2 : extentArr[1] - 2;
+	}
+	void range( const size_t first, const size_t last ) const
+	{
+		const size_t width = extentArr[0];
+		const size_t strideArr[3] = { 1, extentArr[0], extentArr[0] * extentArr[1] };
+		std::vector<double> sumVec( width );
+		for( size_t item = first; item < last; ++item )
+		{
+			const size_t z = ( D == 3 ) ? item + 1 : 0;
+			const size_t yFirst = ( D == 3 ) ? 1 : item + 1;
+			const size_t yLast = ( D == 3 ) ? extentArr[1] - 1 : item + 2;
+			for( size_t y = yFirst; y < yLast; ++y )
+			{
+				const size_t rowOffset = z * strideArr[2] + y * width;
+				for( size_t x = 1; x < width - 1; ++x )
+					sumVec[x] = planePtrArr[0][rowOffset + x + 1] - planePtrArr[0][rowOffset + x - 1];
+				for( unsigned int c = 1; c < D; ++c )
+				{
+					const double* planePtr = planePtrArr[c] + rowOffset;
+					for( size_t x = 1; x < width - 1; ++x )
+						sumVec[x] += planePtr[x + strideArr[c]] - planePtr[x - strideArr[c]];
+				}
+				for( size_t x = 1; x < width - 1; ++x )
+					outputPtr[rowOffset + x] = static_cast<short>( std::max( 0.0, std::min( dMaximum,
+						128.0 + floor( sumVec[x] * dScale + 0.5 ) ) ) );
+			}
+		}
+	}
+};
+
+}
+
 CDivergence::CDivergence( ulong ulID ) throw()
-  : CFilter ( ulID, "Divergence operator", 1, 1, "CDivergence", "0.1", "CFilter" )
+  : CFilter ( ulID, "Divergence operator", 1, 1, "CDivergence", "0.2", "CFilter" )
 {
   setModuleID( sLibID );
   sDocumentation = "Creates a scalar divergence field from the input vector field\n"
                    "** Input ports:\n"
-                   "0: A 2D vector field\n"
+                   "0: A 2D or 3D vector field\n"
                    "** Output ports:\n"
-                   "1: A 2D single channel image"
+                   "1: A 2D or 3D single channel image\n"
                    "** Parameters:\n"
                    "Intensity Range: Intensity range of resulting scalar image";
 
@@ -46,33 +105,25 @@ void CDivergence::apply() throw()
 {
 BENCHSTART;
 	bModuleReady = false;
-  shared_ptr<TField2D> inputPtr = static_pointer_cast<TField2D>( getInput() );
-  if ( inputPtr == NULL || inputPtr->getDimension() != 2 )
+  shared_ptr<TField2D> inputPtr = dynamic_pointer_cast<TField2D>( getInput() );
+  if ( inputPtr && inputPtr->getDimension() == 2 )
   {
-    alog << LWARN << "Input type is no 2D field!" << endl;
-    return;
+		bModuleReady = true;
+	  deleteOldOutput();
+		divergence<2>( *inputPtr );
   }
-	bModuleReady = true;
-  deleteOldOutput();
-  shared_ptr<TImage> outputPtr ( new TImage( 2, inputPtr->getExtents() ) );
-  outputPtr->setMinimum( 0 );
-  outputPtr->setMaximum( parameters.getUnsignedLong( "Intensity Range" ) );
-  
-  ushort usWidth = inputPtr->getExtent(0);
-  ushort usHeight = inputPtr->getExtent(1);
-	double dIntensityRange = parameters.getDouble("Intensity Range");
-  
-	for ( ushort x = 1; x < usWidth - 1; x++ )
-    for ( ushort y = 1; y < usHeight - 1; y++ )
-    {
-      (*outputPtr)( x, y ) = static_cast<ushort>( 128 + round(
-          ( (*inputPtr)( x + 1, y )[0] + (*inputPtr)( x - 1, y )[0] )
-        * ( ( dIntensityRange - 1.0 ) * 0.25 )
-        + ( (*inputPtr)( x ,y + 1 )[1] + (*inputPtr)( x, y - 1 )[1] )
-        * ( ( dIntensityRange - 1.0 ) * 0.25 ) ) );
-    }
-
-  setOutput( outputPtr );
+	else
+	{
+	  shared_ptr<TField3D> inputPtr = dynamic_pointer_cast<TField3D>( getInput() );
+		if ( !inputPtr || inputPtr->getDimension() != 3 )
+	  {
+  	  alog << LWARN << "Input type is no 2D or 3D field!" << endl;
+    	return;
+	  }
+		bModuleReady = true;
+	  deleteOldOutput();
+		divergence<3>( *inputPtr );
+	}
 BENCHSTOP;	
 }
 
@@ -81,3 +132,36 @@ CPipelineItem* CDivergence::newInstance( ulong ulID ) const throw()
 {
   return new CDivergence( ulID );
 }
+
+/*******************
+ * Private methods *
+ *******************/
+
+/**
+ * The field is copied into component planes and the inner slices or rows are
+ * processed by several threads. The output is 128 for a divergence free field,
+ * border pixels are set to 0.
+ * \param aField vector field
+ */
+template<unsigned int D, typename TFieldType> void CDivergence::divergence( const TFieldType& aField )
+  throw()
+{
+	const ulong ulIntensityRange = parameters.getUnsignedLong( "Intensity Range" );
+  shared_ptr<TImage> outputPtr ( new TImage( D, aField.getExtents() ) );
+  outputPtr->setMinimum( 0 );
+  outputPtr->setMaximum( ulIntensityRange );
+
+	const CComponentPlanes<typename TFieldType::TDataType, D> fieldPlanes( aField );
+	SDivergence<D> theDivergence;
+	for( unsigned int c = 0; c < D; ++c )
+		theDivergence.planePtrArr[c] = fieldPlanes.getPlane( c );
+	theDivergence.outputPtr = outputPtr->getArray();
+	for( unsigned int a = 0; a < 3; ++a )
+		theDivergence.extentArr[a] = fieldPlanes.getExtent( a );
+	theDivergence.dScale = ( static_cast<double>( ulIntensityRange ) - 1.0 ) * 0.25;
+	theDivergence.dMaximum = static_cast<double>( ulIntensityRange );
+	if ( *std::min_element( theDivergence.extentArr, theDivergence.extentArr + D ) >= 3 )
+		parallelFor( theDivergence, &SDivergence<D>::range, theDivergence.itemCount() );
+
+  setOutput( outputPtr );
+}
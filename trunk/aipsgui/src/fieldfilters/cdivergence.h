@@ -5,10 +5,10 @@
  *                                                                      *
  * Author: Hendrik Belitz (h.belitz@fz-juelich.de)                      *
  *                                                                      *
- * Version: 0.1                                                         *
+ * Version: 0.2                                                         *
  * Status : Alpha                                                       *
  * Created: 03.02.04                                                    *
- * Changed:                                                             *
+ * Changed: 2026-10-17 Works on threaded component planes, supports 3D  *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -32,7 +32,8 @@
 
 using namespace aips;
 /**
- * Generates a scalar divergence field from a vector field
+ * Generates a scalar divergence field from a vector field.
+ * The central differences are computed on component planes of the field.
  */
 class CDivergence : public CFilter
 {
@@ -58,6 +59,10 @@ public:
   /// Reimplemented from CPipelineItem
   virtual CPipelineItem* newInstance( ulong ulID = 0 ) const
     throw();  
+private:
+  /// Computes the divergence of a 2D or 3D field
+  template<unsigned int D, typename TFieldType> void divergence( const TFieldType& aField )
+    throw();
 };
 
 #endif
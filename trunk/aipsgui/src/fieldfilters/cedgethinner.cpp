@@ -14,26 +14,93 @@
  * (at your option) any later version.                                  *
  ************************************************************************/
 #include "cedgethinner.h"
+#include <algorithm>
 #include <cfloat>
 
+// AIPS includes
+#include <aipsparallel.h>
+#include <ccomponentplanes.h>
+
 using namespace std;
 using namespace boost;
 
-double interpolatedVoxelValue2D( int x, int y, const TVector2D& direction, TField2DPtr image )
+namespace
 {
-	double xpos = static_cast<double>( x ) + (direction[0]*sqrt(2.0) );
-	double ypos = static_cast<double>( y ) + (direction[1]*sqrt(2.0) );
-	return norm( (*image)( static_cast<uint>( round( xpos ) ), 
-		static_cast<uint>( round( ypos ) ) ) );
-}
 
-double interpolatedVoxelValue3D( int x, int y, int z, const TVector3D& direction, TField3DPtr image )
+/**
+ * Non-maximum suppression on component planes, shared by all workers.
+ * A worker processes a range of slices of a volume or rows of an image.
+ */
+template<unsigned int D, typename TVector> struct SEdgeThinning
 {
-	double xpos = static_cast<double>( x ) + ( direction[0] * sqrt( 3.0 ) );
-	double ypos = static_cast<double>( y ) + ( direction[1] * sqrt( 3.0 ) );
-	double zpos = static_cast<double>( z ) + ( direction[2] * sqrt( 3.0 ) );
-	return norm( (*image)( static_cast<uint>( round( xpos ) ), 
-		static_cast<uint>( round( ypos ) ), static_cast<uint>( round( zpos ) ) ) );
+	const double* planePtrArr[D]; ///< Components of the field
+	double* magnitudePtr;         ///< Vector lengths of the field
+	const TVector* inputPtr;      ///< Input field
+	TVector* outputPtr;           ///< Output field
+	size_t extentArr[3];          ///< Field extents (1 for missing dimensions)
+
+	/// Number of rows of an image or slices of a volume
+	size_t itemCount() const
+	{
+		return extentArr[D - 1];
+	}
+	/// Computes the vector lengths
+	void magnitudeRange( const size_t first, const size_t last ) const
+	{
+		const size_t itemSize = ( D == 3 ) ? extentArr[0] * extentArr[1] : extentArr[0];
+		for( size_t i = first * itemSize; i < last * itemSize; ++i )
+		{
+			double dSum = planePtrArr[0][i] * planePtrArr[0][i];
+			for( unsigned int c = 1; c < D; ++c )
+				dSum += planePtrArr[c][i] * planePtrArr[c][i];
+			magnitudePtr[i] = sqrt( dSum );
+		}
+	}
+	/**
+	 * Keeps the vectors whose length is not smaller than the lengths of both neighbours
+	 * along the vector direction. Border voxels are skipped.
+	 */
+	void thinRange( const size_t first, const size_t last ) const
+	{
+		const size_t width = extentArr[0];
+		const size_t strideArr[3] = { 1, extentArr[0], extentArr[0] * extentArr[1] };
+		const double dScale = sqrt( static_cast<double>( D ) );
+		for( size_t item = first; item < last; ++item )
+		{
+			if ( item == 0 || item == extentArr[D - 1] - 1 )
+				continue;
+			const size_t z = ( D == 3 ) ? item : 0;
+			const size_t yFirst = ( D == 3 ) ? 1 : item;
+			const size_t yLast = ( D == 3 ) ? extentArr[1] - 1 : item + 1;
+			for( size_t y = yFirst; y < yLast; ++y )
+			{
+				const size_t rowOffset = z * strideArr[2] + y * width;
+				for( size_t x = 1; x < width - 1; ++x )
+				{
+					const size_t i = rowOffset + x;
+					const double dIntensity = magnitudePtr[i];
+					if ( dIntensity <= DBL_EPSILON )
+						continue;
+					const double coordinateArr[3] = { static_cast<double>( x ), static_cast<double>( y ),
+						static_cast<double>( z ) };
+					ptrdiff_t neighbourOffset = 0;
+					for( unsigned int c = 0; c < D; ++c )
+					{
+						// Round the position along the direction and stay inside the 3^D neighbourhood
+						const double dPosition = coordinateArr[c] + planePtrArr[c][i] / dIntensity * dScale;
+						const ptrdiff_t step = std::max<ptrdiff_t>( -1, std::min<ptrdiff_t>( 1,
+							static_cast<ptrdiff_t>( round( dPosition ) ) - static_cast<ptrdiff_t>( coordinateArr[c] ) ) );
+						neighbourOffset += step * static_cast<ptrdiff_t>( strideArr[c] );
+					}
+					if ( dIntensity >= magnitudePtr[i + neighbourOffset]
+						&& dIntensity >= magnitudePtr[i - neighbourOffset] )
+						outputPtr[i] = inputPtr[i];
+				}
+			}
+		}
+	}
+};
+
 }
 
 /**
@@ -41,7 +108,7 @@ double interpolatedVoxelValue3D( int x, int y, int z, const TVector3D& direction
  * \param ulID unique module ID
  */
 CEdgeThinner::CEdgeThinner( ulong ulID ) throw()
-  : CFilter ( ulID, "Edge thinner", 1, 1, "CEdgeThinner", "0.2", "CFilter" )
+  : CFilter ( ulID, "Edge thinner", 1, 1, "CEdgeThinner", "0.3", "CFilter" )
 {
   setModuleID( sLibID );
   sDocumentation = "Tries to generate a useful partition of a vector field\n"
@@ -69,58 +136,21 @@ void CEdgeThinner::apply() throw()
 {
 BENCHSTART;	
 	bModuleReady = false;
-  shared_ptr<TField2D> inputPtr = static_pointer_cast<TField2D>( getInput() );
+  shared_ptr<TField2D> inputPtr = dynamic_pointer_cast<TField2D>( getInput() );
   if ( inputPtr && inputPtr->getDimension() == 2 )
   {
 		bModuleReady = true;
   	deleteOldOutput();
-	  shared_ptr<TField2D> outputPtr ( new TField2D( 2, inputPtr->getExtents() ) );
-		(*outputPtr) = VEC_ZERO2D;
-		outputPtr->setMaximum( TVector2D( 1.0, 1.0 ) );
-		outputPtr->setMinimum( VEC_ZERO2D );
-		for( ushort y = 1; y < (outputPtr->getExtent(1)-1); ++y )
-			for( ushort x = 1; x < (outputPtr->getExtent(0)-1); ++x )
-			{
-				if ( norm( (*inputPtr)(x,y) ) > DBL_EPSILON )
-				{
-					TVector2D dir = (*inputPtr)(x,y) / norm( (*inputPtr)(x,y) );
-					double intensity = norm( (*inputPtr)(x,y) );
-					double l = interpolatedVoxelValue2D( x, y, dir, inputPtr );
-					dir *= -1.0;
-					double r = interpolatedVoxelValue2D( x, y, dir, inputPtr );
-					if ( intensity >= l && intensity >= r )
-						(*outputPtr)(x,y) = (*inputPtr)(x,y);
-				}
-			}	
- 		setOutput( outputPtr );
+		thinField<2>( *inputPtr );
   }
   else
   {
-  	shared_ptr<TField3D> inputPtr = static_pointer_cast<TField3D>( getInput() );
+  	shared_ptr<TField3D> inputPtr = dynamic_pointer_cast<TField3D>( getInput() );
   	if ( inputPtr && inputPtr->getDimension() == 3 )
 	  {
 			bModuleReady = true;
   		deleteOldOutput();
-		  shared_ptr<TField3D> outputPtr ( new TField3D( 3, inputPtr->getExtents() ) );
-			(*outputPtr) = VEC_ZERO3D;
-			outputPtr->setMaximum( TVector3D( 1.0, 1.0, 1.0 ) );
-			outputPtr->setMinimum( VEC_ZERO3D );
-			for( ushort z = 1; z < (outputPtr->getExtent(2)-1); ++z )
-			for( ushort y = 1; y < (outputPtr->getExtent(1)-1); ++y )
-				for( ushort x = 1; x < (outputPtr->getExtent(0)-1); ++x )
-				{
-					if ( norm( (*inputPtr)(x,y,z ) ) > DBL_EPSILON )
-					{
-						TVector3D dir = (*inputPtr)(x,y,z ) / norm( (*inputPtr)(x,y,z) );
-						double intensity = norm( (*inputPtr)(x,y,z) );
-						double l = interpolatedVoxelValue3D( x, y, z,dir, inputPtr );
-						dir *= -1.0;
-						double r = interpolatedVoxelValue3D( x, y, z,dir, inputPtr );
-						if ( intensity >= l && intensity >= r )
-							(*outputPtr)(x,y,z) = (*inputPtr)(x,y,z);
-					}
-				}	
- 			setOutput( outputPtr );
+			thinField<3>( *inputPtr );
  		}
 	  else
   	{
@@ -163,3 +193,42 @@ CPipelineItem* CEdgeThinner::newInstance( ulong ulID ) const throw()
   return new CEdgeThinner( ulID );
 }
 
+/*******************
+ * Private methods *
+ *******************/
+
+/**
+ * The vector lengths are computed once from the component planes of the field.
+ * Afterwards the slices or rows are thinned by several threads. Each vector is
+ * compared with the two neighbours in and against its direction, rounded to
+ * the 3x3 (3x3x3) neighbourhood.
+ * \param aField vector field
+ */
+template<unsigned int D, typename TFieldType> void CEdgeThinner::thinField( const TFieldType& aField )
+	throw()
+{
+	typedef typename TFieldType::TDataType TVector;
+	shared_ptr<TFieldType> outputPtr ( new TFieldType( D, aField.getExtents() ) );
+	(*outputPtr) = TVector();
+	TVector maximum;
+	for( unsigned int c = 0; c < D; ++c )
+		maximum[c] = 1.0;
+	outputPtr->setMaximum( maximum );
+	outputPtr->setMinimum( TVector() );
+
+	const CComponentPlanes<TVector, D> fieldPlanes( aField );
+	CDataBlock<double> magnitudeBlock( fieldPlanes.getPlaneSize(), false );
+	SEdgeThinning<D, TVector> theThinning;
+	for( unsigned int c = 0; c < D; ++c )
+		theThinning.planePtrArr[c] = fieldPlanes.getPlane( c );
+	theThinning.magnitudePtr = magnitudeBlock.getData();
+	theThinning.inputPtr = &aField[0];
+	theThinning.outputPtr = outputPtr->getArray();
+	for( unsigned int a = 0; a < 3; ++a )
+		theThinning.extentArr[a] = fieldPlanes.getExtent( a );
+	parallelFor( theThinning, &SEdgeThinning<D, TVector>::magnitudeRange, theThinning.itemCount() );
+	if ( *std::min_element( theThinning.extentArr, theThinning.extentArr + D ) >= 3 )
+		parallelFor( theThinning, &SEdgeThinning<D, TVector>::thinRange, theThinning.itemCount() );
+
+	setOutput( outputPtr );
+}
@@ -6,10 +6,11 @@
  *                                                                      *
  * Author: Hendrik Belitz (h.belitz@fz-juelich.de)                      *
  *                                                                      *
- * Version: 0.1                                                         *
+ * Version: 0.3                                                         *
  * Status:  Pre-Alpha                                                   *
  * Created: 04-05-18                                                    *
- * Changed:                                                             *
+ * Changed: 2026-10-17 Works on threaded component planes, neighbours   *
+ *          are clamped to the 3x3x3 neighbourhood                      *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -32,6 +33,9 @@
 
 using namespace aips;
 
+/**
+ * Thins out a vector field by non-maximum suppression along the vector directions.
+ */
 class CEdgeThinner : public CFilter
 {
 private:
@@ -60,6 +64,9 @@ private:
 	/// Return the sector ( 0..7 ) of the given vector
 	/// Each sector has an angle width of PI/4
 	ushort sector( TVector2D aVector ) throw();
+	/// Non-maximum suppression of a 2D or 3D field
+	template<unsigned int D, typename TFieldType> void thinField( const TFieldType& aField )
+		throw();
 };
 
 #endif
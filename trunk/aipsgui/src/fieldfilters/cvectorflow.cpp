@@ -10,15 +10,508 @@
  
 #include "cvectorflow.h"
 
+// Standard includes
+#include <algorithm>
+#include <vector>
+
+// AIPS includes
+#include <aipsparallel.h>
+#include <ccomponentplanes.h>
+
 using namespace std;
 using namespace boost;
 
+namespace
+{
+
+/// Red-black sweeps before and after each coarse grid correction
+const unsigned int smoothingSweeps = 2;
+
+/// Red-black sweeps used to solve the coarsest multigrid level
+const unsigned int coarsestSweeps = 32;
+
+/// Grids are coarsened until no extent is larger than this
+const size_t coarsestExtent = 4;
+
+/// Computes the weight a of the Laplacian and the weight r of the data term for a gradient vector
+template<unsigned int D, typename TVector> inline void flowWeights( const TVector& aVector,
+	const bool bGeneralized, const double dMu, const double dKappa, double& dDiffusion, double& dReaction )
+{
+	double dSquareNorm = 0.0;
+	for( unsigned int c = 0; c < D; ++c )
+		dSquareNorm += static_cast<double>( aVector[c] ) * aVector[c];
+	if ( bGeneralized )
+	{
+		const double g = exp( -1.0 * sqrt( dSquareNorm ) / dKappa );
+		dDiffusion = dMu * g;
+		dReaction = 1.0 - g;
+	}
+	else
+	{
+		dDiffusion = dMu;
+		dReaction = dSquareNorm;
+	}
+}
+
+/**
+ * One explicit time step \f$ v' = ( 1 - \Delta t r ) v + \Delta t a ( \sum_n v_n - n v ) + \Delta t r f \f$
+ * on component planes, shared by all workers. A worker processes a range of
+ * slices of a volume or rows of an image. The neighbour sums of a row are
+ * collected in a row buffer first, so all inner loops run over contiguous arrays.
+ */
+template<unsigned int D> struct SFlowStep
+{
+	const double* readPtrArr[D];   ///< Components of the actual iteration
+	double* writePtrArr[D];        ///< Components of the next iteration
+	const double* sourcePtrArr[D]; ///< Components of dt * r * f
+	const double* diffusionPtr;    ///< dt * a
+	const double* retentionPtr;    ///< 1 - dt * r
+	size_t extentArr[3];           ///< Field extents (1 for missing dimensions)
+
+	/// Number of work items: slices of volumes, rows of images
+	size_t itemCount() const
+	{
+		return ( extentArr[2] > 1 ) ? extentArr[2] : extentArr[1];
+	}
+	void range( const size_t first, const size_t last ) const
+	{
+		const size_t width = extentArr[0];
+		const size_t sliceSize = extentArr[0] * extentArr[1];
+		std::vector<double> sumVec( width );
+		double* sumPtr = &sumVec[0];
+		for( size_t item = first; item < last; ++item )
+		{
+			const size_t z = ( extentArr[2] > 1 ) ? item : 0;
+			const size_t yFirst = ( extentArr[2] > 1 ) ? 0 : item;
+			const size_t yLast = ( extentArr[2] > 1 ) ? extentArr[1] : item + 1;
+			for( size_t y = yFirst; y < yLast; ++y )
+			{
+				const size_t rowOffset = z * sliceSize + y * width;
+				// Offsets of the neighbouring rows inside the field
+				ptrdiff_t neighbourRowArr[4];
+				unsigned int uiNeighbourRows = 0;
+				if ( y > 0 )
+					neighbourRowArr[uiNeighbourRows++] = -static_cast<ptrdiff_t>( width );
+				if ( y + 1 < extentArr[1] )
+					neighbourRowArr[uiNeighbourRows++] = width;
+				if ( z > 0 )
+					neighbourRowArr[uiNeighbourRows++] = -static_cast<ptrdiff_t>( sliceSize );
+				if ( z + 1 < extentArr[2] )
+					neighbourRowArr[uiNeighbourRows++] = sliceSize;
+				const double* aPtr = diffusionPtr + rowOffset;
+				const double* betaPtr = retentionPtr + rowOffset;
+				for( unsigned int c = 0; c < D; ++c )
+				{
+					const double* uPtr = readPtrArr[c] + rowOffset;
+					const double* sourcePtr = sourcePtrArr[c] + rowOffset;
+					double* outPtr = writePtrArr[c] + rowOffset;
+					if ( width == 1 )
+						sumPtr[0] = 0.0;
+					else
+					{
+						sumPtr[0] = uPtr[1];
+						for( size_t x = 1; x < width - 1; ++x )
+							sumPtr[x] = uPtr[x - 1] + uPtr[x + 1];
+						sumPtr[width - 1] = uPtr[width - 2];
+					}
+					for( unsigned int k = 0; k < uiNeighbourRows; ++k )
+					{
+						const double* neighbourPtr = uPtr + neighbourRowArr[k];
+						for( size_t x = 0; x < width; ++x )
+							sumPtr[x] += neighbourPtr[x];
+					}
+					const double dCount = uiNeighbourRows + 2.0;
+					for( size_t x = 0; x < width; ++x )
+						outPtr[x] = betaPtr[x] * uPtr[x] + aPtr[x] * ( sumPtr[x] - dCount * uPtr[x] ) + sourcePtr[x];
+					// The first and the last voxel of a row have one x neighbour less
+					const double dBorderCount = ( width == 1 ) ? uiNeighbourRows : uiNeighbourRows + 1.0;
+					outPtr[0] = betaPtr[0] * uPtr[0] + aPtr[0] * ( sumPtr[0] - dBorderCount * uPtr[0] ) + sourcePtr[0];
+					outPtr[width - 1] = betaPtr[width - 1] * uPtr[width - 1]
+						+ aPtr[width - 1] * ( sumPtr[width - 1] - dBorderCount * uPtr[width - 1] ) + sourcePtr[width - 1];
+				}
+			}
+		}
+	}
+};
+
+/// Indices and weights of the two coarse grid voxels interpolated to a fine grid voxel along one axis
+struct SInterpolation
+{
+	size_t indexArr[2];
+	double dWeightArr[2];
+};
+
+/**
+ * One grid of the multigrid hierarchy. Each voxel holds the linear equation
+ * \f$ a \sum_n c_n ( v - v_n ) + r v = b \f$
+ * over its face neighbours inside the grid. Cells of coarse grids cover two
+ * cells of the finer grid along each axis, except for the last cell of an odd
+ * extent. The coupling weights c_n are the finite volume weights of these
+ * cells, measured in voxels of the finest grid. The D components of v, b and
+ * of the residual are stored interleaved.
+ */
+struct SLevel
+{
+	size_t extentArr[3];              ///< Grid extents (1 for missing dimensions)
+	std::vector<double> widthVec[3];  ///< Cell widths along each axis
+	std::vector<double> couplingVec[3][2]; ///< Coupling weights of the lower and upper neighbour along each axis
+	std::vector<SInterpolation> interpolationVec[3]; ///< Coarser grid voxels interpolated along each axis
+	std::vector<double> diffusionVec; ///< Weight a of the Laplacian
+	std::vector<double> reactionVec;  ///< Weight r of the data term
+	std::vector<double> solutionVec;  ///< Solution v
+	std::vector<double> rightSideVec; ///< Right hand side b
+	std::vector<double> residualVec;  ///< Residual b - A v
+
+	/// Number of voxels
+	size_t voxelCount() const
+	{
+		return extentArr[0] * extentArr[1] * extentArr[2];
+	}
+	/// Number of work items: slices of volumes, rows of images
+	size_t itemCount() const
+	{
+		return ( extentArr[2] > 1 ) ? extentArr[2] : extentArr[1];
+	}
+	/// Returns the slice and the rows [yFirst, yLast) of a work item
+	void itemRows( const size_t item, size_t& z, size_t& yFirst, size_t& yLast ) const
+	{
+		if ( extentArr[2] > 1 )
+		{
+			z = item; yFirst = 0; yLast = extentArr[1];
+		}
+		else
+		{
+			z = 0; yFirst = item; yLast = item + 1;
+		}
+	}
+	/// Allocates all arrays for the given extents and computes the coupling weights from the cell widths
+	void allocate( const unsigned int uiComponents )
+	{
+		const size_t count = voxelCount();
+		diffusionVec.resize( count );
+		reactionVec.resize( count );
+		solutionVec.resize( count * uiComponents );
+		rightSideVec.resize( count * uiComponents );
+		residualVec.resize( count * uiComponents );
+		for( unsigned int a = 0; a < 3; ++a )
+		{
+			const std::vector<double>& theWidthVec = widthVec[a];
+			couplingVec[a][0].assign( extentArr[a], 0.0 );
+			couplingVec[a][1].assign( extentArr[a], 0.0 );
+			for( size_t i = 1; i < extentArr[a]; ++i )
+			{
+				// Flux over the face divided by the cell width, with the distance of the cell centres
+				const double dDistance = 0.5 * ( theWidthVec[i - 1] + theWidthVec[i] );
+				couplingVec[a][0][i] = 1.0 / ( dDistance * theWidthVec[i] );
+				couplingVec[a][1][i - 1] = 1.0 / ( dDistance * theWidthVec[i - 1] );
+			}
+		}
+	}
+};
+
+/// Returns the fine grid voxels [first, last) covered by a coarse grid voxel along one axis
+inline void childRange( const size_t coarse, const size_t fineExtent, size_t& first, size_t& last )
+{
+	first = 2 * coarse;
+	last = std::min( first + 2, fineExtent );
+}
+
+/**
+ * Operations on one grid and the next coarser grid, shared by all workers.
+ * Red-black ordering makes the Gauss-Seidel sweeps independent of the number of threads.
+ */
+template<unsigned int D> struct SLevelOperation
+{
+	SLevel* levelPtr;     ///< Grid to work on
+	SLevel* coarsePtr;    ///< Next coarser grid (restriction and prolongation only)
+	size_t colour;        ///< Voxels updated by smoothRange(): 0 = red, 1 = black
+	double* squareSumPtr; ///< Squared residual of each work item (residualRange() only)
+
+	/// Adds the weighted neighbours of a voxel to sumArr and returns the sum of the weights
+	inline double addNeighbours( const size_t x, const size_t y, const size_t z, const size_t i,
+		double* sumArr ) const
+	{
+		const size_t* extentPtr = levelPtr->extentArr;
+		const double* solutionPtr = &levelPtr->solutionVec[i * D];
+		const size_t positionArr[3] = { x, y, z };
+		const size_t strideArr[3] = { D, D * extentPtr[0], D * extentPtr[0] * extentPtr[1] };
+		double dWeightSum = 0.0;
+		for( unsigned int c = 0; c < D; ++c )
+			sumArr[c] = 0.0;
+		for( unsigned int a = 0; a < 3; ++a )
+		{
+			if ( positionArr[a] > 0 )
+			{
+				const double dWeight = levelPtr->couplingVec[a][0][positionArr[a]];
+				dWeightSum += dWeight;
+				for( unsigned int c = 0; c < D; ++c )
+					sumArr[c] += dWeight * *( solutionPtr - strideArr[a] + c );
+			}
+			if ( positionArr[a] + 1 < extentPtr[a] )
+			{
+				const double dWeight = levelPtr->couplingVec[a][1][positionArr[a]];
+				dWeightSum += dWeight;
+				for( unsigned int c = 0; c < D; ++c )
+					sumArr[c] += dWeight * solutionPtr[strideArr[a] + c];
+			}
+		}
+		return dWeightSum;
+	}
+	/// Gauss-Seidel update of all voxels of one colour
+	void smoothRange( const size_t first, const size_t last ) const
+	{
+		const size_t* extentPtr = levelPtr->extentArr;
+		double sumArr[D];
+		for( size_t item = first; item < last; ++item )
+		{
+			size_t z, yFirst, yLast;
+			levelPtr->itemRows( item, z, yFirst, yLast );
+			for( size_t y = yFirst; y < yLast; ++y )
+				for( size_t x = ( colour + y + z ) % 2; x < extentPtr[0]; x += 2 )
+				{
+					const size_t i = ( z * extentPtr[1] + y ) * extentPtr[0] + x;
+					const double dDiffusion = levelPtr->diffusionVec[i];
+					const double dDiagonal = dDiffusion * addNeighbours( x, y, z, i, sumArr )
+						+ levelPtr->reactionVec[i];
+					if ( dDiagonal <= 0.0 )
+						continue;
+					for( unsigned int c = 0; c < D; ++c )
+						levelPtr->solutionVec[i * D + c] =
+							( dDiffusion * sumArr[c] + levelPtr->rightSideVec[i * D + c] ) / dDiagonal;
+				}
+		}
+	}
+	/// Computes the residual and its squared norm for each work item
+	void residualRange( const size_t first, const size_t last ) const
+	{
+		const size_t* extentPtr = levelPtr->extentArr;
+		double sumArr[D];
+		for( size_t item = first; item < last; ++item )
+		{
+			size_t z, yFirst, yLast;
+			levelPtr->itemRows( item, z, yFirst, yLast );
+			double dSquareSum = 0.0;
+			for( size_t y = yFirst; y < yLast; ++y )
+				for( size_t x = 0; x < extentPtr[0]; ++x )
+				{
+					const size_t i = ( z * extentPtr[1] + y ) * extentPtr[0] + x;
+					const double dDiffusion = levelPtr->diffusionVec[i];
+					const double dDiagonal = dDiffusion * addNeighbours( x, y, z, i, sumArr )
+						+ levelPtr->reactionVec[i];
+					for( unsigned int c = 0; c < D; ++c )
+					{
+						const double dResidual = levelPtr->rightSideVec[i * D + c]
+							- dDiagonal * levelPtr->solutionVec[i * D + c] + dDiffusion * sumArr[c];
+						levelPtr->residualVec[i * D + c] = dResidual;
+						dSquareSum += dResidual * dResidual;
+					}
+				}
+			squareSumPtr[item] = dSquareSum;
+		}
+	}
+	/// Averages the residual into the right hand side of the coarser grid (coarse work items)
+	void restrictRange( const size_t first, const size_t last ) const
+	{
+		const size_t* fineExtentPtr = levelPtr->extentArr;
+		const size_t* extentPtr = coarsePtr->extentArr;
+		for( size_t item = first; item < last; ++item )
+		{
+			size_t z, yFirst, yLast;
+			coarsePtr->itemRows( item, z, yFirst, yLast );
+			for( size_t y = yFirst; y < yLast; ++y )
+				for( size_t x = 0; x < extentPtr[0]; ++x )
+				{
+					const size_t i = ( z * extentPtr[1] + y ) * extentPtr[0] + x;
+					double sumArr[D];
+					for( unsigned int c = 0; c < D; ++c )
+						sumArr[c] = 0.0;
+					size_t xFirst, xLast, yFineFirst, yFineLast, zFirst, zLast;
+					childRange( x, fineExtentPtr[0], xFirst, xLast );
+					childRange( y, fineExtentPtr[1], yFineFirst, yFineLast );
+					childRange( z, fineExtentPtr[2], zFirst, zLast );
+					for( size_t fz = zFirst; fz < zLast; ++fz )
+						for( size_t fy = yFineFirst; fy < yFineLast; ++fy )
+							for( size_t fx = xFirst; fx < xLast; ++fx )
+							{
+								const size_t j = ( fz * fineExtentPtr[1] + fy ) * fineExtentPtr[0] + fx;
+								const double dVolume = levelPtr->widthVec[0][fx] * levelPtr->widthVec[1][fy]
+									* levelPtr->widthVec[2][fz];
+								for( unsigned int c = 0; c < D; ++c )
+									sumArr[c] += dVolume * levelPtr->residualVec[j * D + c];
+							}
+					const double dVolume = coarsePtr->widthVec[0][x] * coarsePtr->widthVec[1][y]
+						* coarsePtr->widthVec[2][z];
+					for( unsigned int c = 0; c < D; ++c )
+					{
+						coarsePtr->rightSideVec[i * D + c] = sumArr[c] / dVolume;
+						coarsePtr->solutionVec[i * D + c] = 0.0;
+					}
+				}
+		}
+	}
+	/// Adds the interpolated correction of the coarser grid to the solution
+	void prolongateRange( const size_t first, const size_t last ) const
+	{
+		const size_t* extentPtr = levelPtr->extentArr;
+		const size_t* coarseExtentPtr = coarsePtr->extentArr;
+		for( size_t item = first; item < last; ++item )
+		{
+			size_t z, yFirst, yLast;
+			levelPtr->itemRows( item, z, yFirst, yLast );
+			const SInterpolation& zInterpolation = levelPtr->interpolationVec[2][z];
+			for( size_t y = yFirst; y < yLast; ++y )
+			{
+				const SInterpolation& yInterpolation = levelPtr->interpolationVec[1][y];
+				for( size_t x = 0; x < extentPtr[0]; ++x )
+				{
+					const SInterpolation& xInterpolation = levelPtr->interpolationVec[0][x];
+					const size_t i = ( z * extentPtr[1] + y ) * extentPtr[0] + x;
+					for( unsigned int kz = 0; kz < 2; ++kz )
+						for( unsigned int ky = 0; ky < 2; ++ky )
+							for( unsigned int kx = 0; kx < 2; ++kx )
+							{
+								const double dWeight = zInterpolation.dWeightArr[kz]
+									* yInterpolation.dWeightArr[ky] * xInterpolation.dWeightArr[kx];
+								if ( dWeight == 0.0 )
+									continue;
+								const size_t j = ( zInterpolation.indexArr[kz] * coarseExtentPtr[1]
+									+ yInterpolation.indexArr[ky] ) * coarseExtentPtr[0] + xInterpolation.indexArr[kx];
+								for( unsigned int c = 0; c < D; ++c )
+									levelPtr->solutionVec[i * D + c] += dWeight * coarsePtr->solutionVec[j * D + c];
+							}
+				}
+			}
+		}
+	}
+};
+
+/**
+ * Creates the coarser grid, averages the coefficients of the finer grid into it
+ * and computes the linear interpolation from the coarser to the finer grid.
+ */
+void coarsenLevel( SLevel& fineLevel, SLevel& coarseLevel, const unsigned int uiComponents )
+{
+	const size_t* fineExtentPtr = fineLevel.extentArr;
+	for( unsigned int a = 0; a < 3; ++a )
+	{
+		coarseLevel.extentArr[a] = ( fineExtentPtr[a] + 1 ) / 2;
+		coarseLevel.widthVec[a].assign( coarseLevel.extentArr[a], 0.0 );
+		for( size_t i = 0; i < fineExtentPtr[a]; ++i )
+			coarseLevel.widthVec[a][i / 2] += fineLevel.widthVec[a][i];
+		// Interpolate between the cell centres
+		std::vector<double> fineCentreVec( fineExtentPtr[a] );
+		std::vector<double> coarseCentreVec( coarseLevel.extentArr[a] );
+		double dPosition = 0.0;
+		for( size_t i = 0; i < fineExtentPtr[a]; ++i )
+		{
+			fineCentreVec[i] = dPosition + 0.5 * fineLevel.widthVec[a][i];
+			dPosition += fineLevel.widthVec[a][i];
+		}
+		dPosition = 0.0;
+		for( size_t i = 0; i < coarseLevel.extentArr[a]; ++i )
+		{
+			coarseCentreVec[i] = dPosition + 0.5 * coarseLevel.widthVec[a][i];
+			dPosition += coarseLevel.widthVec[a][i];
+		}
+		fineLevel.interpolationVec[a].resize( fineExtentPtr[a] );
+		for( size_t i = 0; i < fineExtentPtr[a]; ++i )
+		{
+			SInterpolation& theInterpolation = fineLevel.interpolationVec[a][i];
+			const size_t parent = i / 2;
+			size_t neighbour = parent;
+			if ( fineCentreVec[i] < coarseCentreVec[parent] && parent > 0 )
+				neighbour = parent - 1;
+			else if ( fineCentreVec[i] > coarseCentreVec[parent] && parent + 1 < coarseLevel.extentArr[a] )
+				neighbour = parent + 1;
+			theInterpolation.indexArr[0] = parent;
+			theInterpolation.indexArr[1] = neighbour;
+			theInterpolation.dWeightArr[1] = ( neighbour == parent ) ? 0.0
+				: std::abs( fineCentreVec[i] - coarseCentreVec[parent] )
+				/ std::abs( coarseCentreVec[neighbour] - coarseCentreVec[parent] );
+			theInterpolation.dWeightArr[0] = 1.0 - theInterpolation.dWeightArr[1];
+		}
+	}
+	coarseLevel.allocate( uiComponents );
+	size_t i = 0;
+	for( size_t z = 0; z < coarseLevel.extentArr[2]; ++z )
+		for( size_t y = 0; y < coarseLevel.extentArr[1]; ++y )
+			for( size_t x = 0; x < coarseLevel.extentArr[0]; ++x, ++i )
+			{
+				size_t xFirst, xLast, yFirst, yLast, zFirst, zLast;
+				childRange( x, fineExtentPtr[0], xFirst, xLast );
+				childRange( y, fineExtentPtr[1], yFirst, yLast );
+				childRange( z, fineExtentPtr[2], zFirst, zLast );
+				double dDiffusion = 0.0;
+				double dReaction = 0.0;
+				for( size_t fz = zFirst; fz < zLast; ++fz )
+					for( size_t fy = yFirst; fy < yLast; ++fy )
+						for( size_t fx = xFirst; fx < xLast; ++fx )
+						{
+							const size_t j = ( fz * fineExtentPtr[1] + fy ) * fineExtentPtr[0] + fx;
+							const double dVolume = fineLevel.widthVec[0][fx] * fineLevel.widthVec[1][fy]
+								* fineLevel.widthVec[2][fz];
+							dDiffusion += dVolume * fineLevel.diffusionVec[j];
+							dReaction += dVolume * fineLevel.reactionVec[j];
+						}
+				const double dVolume = coarseLevel.widthVec[0][x] * coarseLevel.widthVec[1][y]
+					* coarseLevel.widthVec[2][z];
+				coarseLevel.diffusionVec[i] = dDiffusion / dVolume;
+				coarseLevel.reactionVec[i] = dReaction / dVolume;
+			}
+}
+
+/// Performs one red-black Gauss-Seidel sweep
+template<unsigned int D> void smoothLevel( SLevel& aLevel )
+{
+	SLevelOperation<D> theOperation = { &aLevel, NULL, 0, NULL };
+	parallelFor( theOperation, &SLevelOperation<D>::smoothRange, aLevel.itemCount() );
+	theOperation.colour = 1;
+	parallelFor( theOperation, &SLevelOperation<D>::smoothRange, aLevel.itemCount() );
+}
+
+/// Computes the residual of a grid and returns its squared norm
+template<unsigned int D> double computeResidual( SLevel& aLevel )
+{
+	std::vector<double> squareSumVec( aLevel.itemCount() );
+	SLevelOperation<D> theOperation = { &aLevel, NULL, 0, &squareSumVec[0] };
+	parallelFor( theOperation, &SLevelOperation<D>::residualRange, aLevel.itemCount() );
+	double dSquareSum = 0.0;
+	for( size_t item = 0; item < squareSumVec.size(); ++item )
+		dSquareSum += squareSumVec[item];
+	return dSquareSum;
+}
+
+/// Performs one V-cycle on the given grid and all coarser grids
+template<unsigned int D> void multigridCycle( std::vector<SLevel>& levelVec, const size_t level )
+{
+	SLevel& theLevel = levelVec[level];
+	if ( level + 1 == levelVec.size() )
+	{
+		for( unsigned int i = 0; i < coarsestSweeps; ++i )
+			smoothLevel<D>( theLevel );
+		return;
+	}
+	SLevel& theCoarseLevel = levelVec[level + 1];
+	for( unsigned int i = 0; i < smoothingSweeps; ++i )
+		smoothLevel<D>( theLevel );
+	computeResidual<D>( theLevel );
+	SLevelOperation<D> theOperation = { &theLevel, &theCoarseLevel, 0, NULL };
+	parallelFor( theOperation, &SLevelOperation<D>::restrictRange, theCoarseLevel.itemCount() );
+	multigridCycle<D>( levelVec, level + 1 );
+	parallelFor( theOperation, &SLevelOperation<D>::prolongateRange, theLevel.itemCount() );
+	for( unsigned int i = 0; i < smoothingSweeps; ++i )
+		smoothLevel<D>( theLevel );
+}
+
+}
+
 /************* 
  * Structors *
  *************/
 
 CVectorFlow::CVectorFlow( ulong ulID ) throw()
-  : CFilter ( ulID, "Gradient vector flow", 2, 1, "CVectorFlow", "0.7", "CFilter" )
+  : CFilter ( ulID, "Gradient vector flow", 2, 1, "CVectorFlow", "0.9", "CFilter" ),
+	ulUsedIterations( 0 ), dResidual( 0.0 )
 {
   setModuleID( sLibID );
 
@@ -29,18 +522,25 @@ CVectorFlow::CVectorFlow( ulong ulID ) throw()
                    "** Output ports:\n"
                    "1: A 2D or 3D single channel vector field \n"
 									 "** Parameters:\n"
-									 "Iterations: Number of iterations of the finite difference scheme\n"
+									 "Iterations: Number of iterations of the finite difference scheme,\n"
+									 "  maximum number of sweeps or V-cycles of the iterative solvers\n"
 									 "Method: 0 - GVF, 1 - GGVF, 2 - GGVF with blitz++\n"
-									 "DeltaT: time step\n"
+									 "Solver: 0 - Explicit finite difference scheme,\n"
+									 "  1 - Red-black Gauss-Seidel, 2 - Multigrid V-cycles\n"
+									 "  (the iterative solvers compute the steady state directly)\n"
+									 "Tolerance: Relative residual at which the iterative solvers stop\n"
+									 "DeltaT: time step (explicit scheme only)\n"
 									 "Mu:\n"
 									 "Kappa: Smoothing parameter\n";
 
-  parameters.initUnsignedLong( "Iterations", 10UL, 1UL, 10000UL );
+  parameters.initUnsignedLong( "Iterations", 10UL, 1UL, 1000000UL );
 #ifdef USE_BLITZ
   parameters.initUnsignedLong( "Method", 2UL, 0UL, 2UL );
 #else
   parameters.initUnsignedLong( "Method", 1UL, 0UL, 1UL );
 #endif
+  parameters.initUnsignedLong( "Solver", 0UL, 0UL, 2UL );
+  parameters.initDouble( "Tolerance", 1.0E-4, 0.0, 1.0 );
   parameters.initDouble( "DeltaT", 0.125, 0.000001, 1.0 );
   parameters.initDouble( "Mu", 1.0, 0.0, 10.0 );
   parameters.initDouble( "Kappa", 0.25, 0.0, 10.0 );
@@ -48,6 +548,8 @@ CVectorFlow::CVectorFlow( ulong ulID ) throw()
   inputsVec[0].portType = CPipelineItem::IOVector;
 	inputsVec[1].portType = CPipelineItem::IOInteger;
   outputsVec[0].portType = CPipelineItem::IOVector;
+  // GVF runs are expensive and often repeated with earlier parameters
+  memoiseResults();
 }
 
 CVectorFlow::~CVectorFlow() throw()
@@ -90,10 +592,10 @@ BENCHSTART;
 			bRoiSelf = true;
 		}		
 	  deleteOldOutput();		
-		if ( parameters.getUnsignedLong( "Method" ) == 0 )
-			gvf2D( gradp );
-		else if ( parameters.getUnsignedLong( "Method" ) == 1 )
-			ggvf2D( gradp );
+		if ( parameters.getUnsignedLong( "Solver" ) > 0 )
+			solveFlow<2>( *gradp );
+		else if ( parameters.getUnsignedLong( "Method" ) <= 1 )
+			explicitFlow<2>( *gradp );
 #ifdef USE_BLITZ
 		else if ( parameters.getUnsignedLong( "Method" ) == 2 )
 			gvf2Dblitz( gradp );
@@ -115,10 +617,10 @@ BENCHSTART;
 			bRoiSelf = true;
 		}		
 	  deleteOldOutput();
-		if ( parameters.getUnsignedLong( "Method" ) == 0 )
-			gvf3D( gradp );
-		else if ( parameters.getUnsignedLong( "Method" ) == 1 )
-			ggvf3D( gradp );
+		if ( parameters.getUnsignedLong( "Solver" ) > 0 )
+			solveFlow<3>( *gradp );
+		else if ( parameters.getUnsignedLong( "Method" ) <= 1 )
+			explicitFlow<3>( *gradp );
 #ifdef USE_BLITZ
 		else if ( parameters.getUnsignedLong( "Method" ) == 2 )
 			gvf3Dblitz( gradp );
@@ -133,297 +635,193 @@ CPipelineItem* CVectorFlow::newInstance( ulong ulID_ ) const throw()
   return new CVectorFlow( ulID_ );
 }
 
+/*************
+ * Accessors *
+ *************/
+
+/** \returns the number of Gauss-Seidel sweeps or V-cycles of the last run */
+ulong CVectorFlow::getUsedIterations() const throw()
+{
+	return ulUsedIterations;
+}
+
+/** \returns the relative residual |b - Av| / |b| after the last run of an iterative solver */
+double CVectorFlow::getResidual() const throw()
+{
+	return dResidual;
+}
+
 /******************* 
  * Private methods *
  *******************/
 
-void CVectorFlow::gvf2D( shared_ptr<TField2D> gradientFieldPtr ) throw()
+/**
+ * Runs "Iterations" explicit time steps of GVF or GGVF on component planes.
+ * The slices or rows of each step are processed by several threads. Borders
+ * are reflecting and voxels outside of the area of interest keep the input vector.
+ * \param gradientField Gradient vector field
+ */
+template<unsigned int D, typename TFieldType> void CVectorFlow::explicitFlow( const TFieldType& gradientField )
+	throw()
 {
-  shared_ptr<TField2D> outputPtr ( new TField2D( 2, gradientFieldPtr->getExtents() ) );
+	typedef typename TFieldType::TDataType TVector;
+	const bool bGeneralized = ( parameters.getUnsignedLong( "Method" ) != 0 );
+	const double dDeltaT = parameters.getDouble( "DeltaT" );
+	const double dMu = parameters.getDouble( "Mu" );
+	const double dKappa = parameters.getDouble( "Kappa" );
+	const ulong ulIterations = parameters.getUnsignedLong( "Iterations" );
 
-	// Get the parameters
-	double dDeltaT = parameters.getDouble( "DeltaT" );
-	double dMu = parameters.getDouble( "Mu" );
-	ulong ulIterations = parameters.getUnsignedLong( "Iterations" );
-	
-  // Generate some reference to make reading the code easier
-  TField2D& grad = ( *gradientFieldPtr );
-  ushort w = gradientFieldPtr->getExtent(0);
-  ushort h = gradientFieldPtr->getExtent(1);
-  
-	TField2D& flowt = *outputPtr;
-  TField2D flowdt( 2, grad.getExtents() );
-    
-  CTypedData<double> b ( 2, grad.getExtents() );
-  CTypedData<double> c1 ( 2, grad.getExtents() );
-  CTypedData<double> c2 ( 2, grad.getExtents() );        
-	flowt = grad;
-  
-	for ( int y = 0; y < h; ++y )
-		for ( int x = 0; x < w; ++x )    
-    {
-      b(x,y) = ( flowt(x,y)[0] * flowt(x,y)[0] ) + ( flowt(x,y)[1] * flowt(x,y)[1] );
-      c1(x,y) = flowt(x,y)[0] * b(x,y);
-      c2(x,y) = flowt(x,y)[1] * b(x,y);
-    }
-		
-  ushort time = 0; ushort maxtime = ulIterations;
-	PROG_MAX( maxtime );
-  while ( time <= maxtime )
-  {
-		ushort x = 1; ushort y = 1;
-		TField2D::iterator it = flowt.begin() + w + 1;
-		TField2D::iterator itdt = flowdt.begin() + w + 1;
-		while( y < h )
-    {
-			TVector2D neigh = *(it+1) + *(it-1) + *(it+w) + *(it-w) - ( 4 * (*it) );
-      (*itdt)[0] = ( 1.0 - dDeltaT * b(x,y) ) * (*it)[0] 
-				+ dMu * dDeltaT * neigh[0] + c1(x,y) * dDeltaT;
-      (*itdt)[1] = ( 1.0 - dDeltaT * b(x,y) ) * (*it)[1] 
-				+ dMu	* dDeltaT * neigh[1] + c2(x,y) * dDeltaT;
-			++it; ++itdt; ++x;
-			if ( x == w )
-			{
-				y++; x = 1; it+=2; itdt+=2;
-			}			
-    }
-		flowt.swap( flowdt );
-    time++;      
-		if ( time % 10 == 0 )
+	CComponentPlanes<TVector, D> flowPlanes( gradientField );
+	shared_ptr<TFieldType> outputPtr;
+	{
+		const size_t voxelCount = flowPlanes.getPlaneSize();
+		CComponentPlanes<TVector, D> nextPlanes( gradientField.getExtents() );
+		CComponentPlanes<TVector, D> sourcePlanes( gradientField.getExtents() );
+		std::vector<double> diffusionVec( voxelCount );
+		std::vector<double> retentionVec( voxelCount );
+		const bool bUseRoi = ( !bRoiSelf && roiPtr->getArraySize() == voxelCount );
+		for( size_t i = 0; i < voxelCount; ++i )
 		{
-			PROG_VAL( time );
-	  	if ( time % 50 == 0 )
+			double dDiffusion = 0.0;
+			double dReaction = 0.0;
+			if ( !bUseRoi || (*roiPtr)[i] == 1 )
+				flowWeights<D>( gradientField[i], bGeneralized, dMu, dKappa, dDiffusion, dReaction );
+			diffusionVec[i] = dDeltaT * dDiffusion;
+			retentionVec[i] = 1.0 - dDeltaT * dReaction;
+			for( unsigned int c = 0; c < D; ++c )
+				sourcePlanes.getPlane( c )[i] = dDeltaT * dReaction * flowPlanes.getPlane( c )[i];
+		}
+
+		SFlowStep<D> theStep;
+		for( unsigned int c = 0; c < D; ++c )
+			theStep.sourcePtrArr[c] = sourcePlanes.getPlane( c );
+		theStep.diffusionPtr = &diffusionVec[0];
+		theStep.retentionPtr = &retentionVec[0];
+		for( unsigned int a = 0; a < 3; ++a )
+			theStep.extentArr[a] = flowPlanes.getExtent( a );
+		PROG_MAX( ulIterations );
+		for( ulong ulTime = 0; ulTime < ulIterations; ++ulTime )
+		{
+			for( unsigned int c = 0; c < D; ++c )
+			{
+				theStep.readPtrArr[c] = flowPlanes.getPlane( c );
+				theStep.writePtrArr[c] = nextPlanes.getPlane( c );
+			}
+			parallelFor( theStep, &SFlowStep<D>::range, theStep.itemCount() );
+			flowPlanes.swap( nextPlanes );
+			if ( ulTime % 10 == 0 )
+			{
+				PROG_VAL( ulTime );
 				APP_PROC();
+			}
 		}
-  }
-  PROG_RESET();
-	outputPtr->setMinimum( TVector2D( -1.0, -1.0 ) );
-	outputPtr->setMaximum( TVector2D( 1.0, 1.0 ) );	
-  setOutput( outputPtr );
+		PROG_RESET();
+	}
+	// The work planes are released before the output is allocated
+	outputPtr.reset( new TFieldType( D, gradientField.getExtents() ) );
+	flowPlanes.toField( *outputPtr );
+	TVector minimumVector;
+	TVector maximumVector;
+	for( unsigned int c = 0; c < D; ++c )
+	{
+		minimumVector[c] = -1.0;
+		maximumVector[c] = 1.0;
+	}
+	outputPtr->setMinimum( minimumVector );
+	outputPtr->setMaximum( maximumVector );
+	setOutput( outputPtr );
 }
 
 /**
- * GGVF 2d case
- * \param gradientFieldPtr Gradient vector field 
+ * Computes the steady state of GVF or GGVF by solving the linear system
+ * \f$ a ( n v - \sum_n v_n ) + r v = r f \f$ for each component of the flow v,
+ * with a = Mu, r = |f|^2 for GVF and a = Mu * g, r = 1 - g for GGVF.
+ * The solver iterates until the relative residual is below "Tolerance" or
+ * "Iterations" sweeps or V-cycles are done. Voxels outside of the area of
+ * interest keep the input vector.
+ * \param gradientField Gradient vector field
  */
-void CVectorFlow::ggvf2D( shared_ptr<TField2D> gradientFieldPtr ) throw()
+template<unsigned int D, typename TFieldType> void CVectorFlow::solveFlow( const TFieldType& gradientField )
+	throw()
 {
-  shared_ptr<TField2D> outputPtr ( new TField2D( 2, gradientFieldPtr->getExtents() ) );
+	const bool bGeneralized = ( parameters.getUnsignedLong( "Method" ) != 0 );
+	const bool bMultigrid = ( parameters.getUnsignedLong( "Solver" ) == 2 );
+	const double dMu = parameters.getDouble( "Mu" );
+	const double dKappa = parameters.getDouble( "Kappa" );
+	const double dTolerance = parameters.getDouble( "Tolerance" );
+	const ulong ulIterations = parameters.getUnsignedLong( "Iterations" );
 
-	// Get the parameters
-	double dDeltaT = parameters.getDouble( "DeltaT" );
-	double dMu = parameters.getDouble( "Mu" );
-	double dKappa = parameters.getDouble( "Kappa" );
-	ulong ulIterations = parameters.getUnsignedLong( "Iterations" );
-
-  // Generate some reference to make reading the code easier
-  TField2D& grad = (*gradientFieldPtr);
-  ushort w = grad.getExtent(0);
-  ushort h = grad.getExtent(1);
-  TField2D& flowt = *outputPtr;
-  TField2D flowdt( 2, grad.getExtents() ); 
-  CTypedData<double> g ( 2, grad.getExtents() );
-  CTypedData<double> hf ( 2, grad.getExtents() );
-
-  for ( int y = 0; y < h; ++y )
-    for ( int x = 0; x < w; ++x )
-    {
-      // Define the time-invariant weighting functions
-      g(x,y) = exp ( -1.0 * norm( grad(x,y) ) / dKappa );
-      hf(x,y) = 1.0 - g(x,y);
-    }
-
-  flowt = grad;
-  // Time loop
-  ushort time = 0; ushort maxtime = ulIterations;
-	PROG_MAX( maxtime );
-  while ( time <= maxtime )
-  {
-    if ( time % 10 == 0 )
+	std::vector<SLevel> levelVec( 1 );
+	SLevel& theFinestLevel = levelVec[0];
+	for( unsigned int a = 0; a < 3; ++a )
+		theFinestLevel.extentArr[a] = ( a < D ) ? gradientField.getExtent( a ) : 1;
+	const size_t voxelCount = theFinestLevel.voxelCount();
+	for( unsigned int a = 0; a < 3; ++a )
+		theFinestLevel.widthVec[a].assign( theFinestLevel.extentArr[a], 1.0 );
+	theFinestLevel.allocate( D );
+	const bool bUseRoi = ( !bRoiSelf && roiPtr->getArraySize() == voxelCount );
+	double dRightSideNorm = 0.0;
+	for( size_t i = 0; i < voxelCount; ++i )
+	{
+		const typename TFieldType::TDataType& theVector = gradientField[i];
+		if ( bUseRoi && (*roiPtr)[i] != 1 )
 		{
-			PROG_VAL( time );
-			if ( time % 50 == 0 )
-      	APP_PROC();
+			theFinestLevel.diffusionVec[i] = 0.0;
+			theFinestLevel.reactionVec[i] = 1.0;
 		}
-		for( ushort y = 0; y < h; y++ )
-			for( ushort x = 0; x < w; x++ )
-			{
-        //Determine u(x,y,t)
-				if ( bRoiSelf || (*roiPtr)( x, y ) == 1 )
-				{
-	       // Determine u(x,y,t)
-  	      TVector2D neigh ( 0.0, 0.0 );
-    	   // Value of discrete Laplacian operator
-	        ushort times = 0;
-  	      if ( x < w-1 ) { neigh += flowt( x+1,y  ); times++; }
-    	    if ( x > 0 )   { neigh += flowt( x-1,y  ); times++; }
-      	  if ( y < h-1 ) { neigh += flowt( x  ,y+1); times++; }
-        	if ( y > 0 )   { neigh += flowt( x  ,y-1); times++; }
-        neigh -= static_cast<double>( times ) * flowt(x,y);
-        //Determine u(x,y,t+1)
-        flowdt(x,y)[0] = ( 1.0 - dDeltaT * hf(x,y) ) 
-					* flowt(x,y)[0] + dMu * dDeltaT * neigh[0] * g(x,y) 
-					+ grad(x,y)[0] * hf(x,y) * dDeltaT;
-        //Do the same thing for v(x,y,t)
-        flowdt(x,y)[1] = ( 1.0 - dDeltaT * hf(x,y) ) 
-					* flowt(x,y)[1] + dMu * dDeltaT * neigh[1] * g(x,y) 
-					+ grad(x,y)[1] * hf(x,y) * dDeltaT;
-				}
-     }
-      
-		flowt.swap( flowdt );  
-    time++;     		
-  }
-	outputPtr->setMinimum( TVector2D( -1.0, -1.0 ) );
-	outputPtr->setMaximum( TVector2D( 1.0, 1.0 ) );
-	PROG_RESET();
-	setOutput( outputPtr );
-}
-
-void CVectorFlow::gvf3D( shared_ptr<TField3D> gradientFieldPtr ) throw()
-{
-	shared_ptr<TField3D> outputPtr ( new TField3D( 3, gradientFieldPtr->getExtents() ) );
+		else
+			flowWeights<D>( theVector, bGeneralized, dMu, dKappa, theFinestLevel.diffusionVec[i],
+				theFinestLevel.reactionVec[i] );
+		for( unsigned int c = 0; c < D; ++c )
+		{
+			theFinestLevel.solutionVec[i * D + c] = theVector[c];
+			theFinestLevel.rightSideVec[i * D + c] = theFinestLevel.reactionVec[i] * theVector[c];
+			dRightSideNorm += theFinestLevel.rightSideVec[i * D + c] * theFinestLevel.rightSideVec[i * D + c];
+		}
+	}
+	dRightSideNorm = sqrt( dRightSideNorm );
+	if ( dRightSideNorm == 0.0 )
+		dRightSideNorm = 1.0;
 
-  TVector3D maxVec; maxVec[0] = 1.0; maxVec[1] = 1.0;
-  outputPtr->setMaximum( maxVec );
-	
-	// Get the parameters
-	double dDeltaT = parameters.getDouble( "DeltaT" );
-	double dMu = parameters.getDouble( "Mu" );
-	double dKappa = parameters.getDouble( "Kappa" );
-	ulong ulIterations = parameters.getUnsignedLong( "Iterations" );
+	while( bMultigrid && *std::max_element( levelVec.back().extentArr, levelVec.back().extentArr + 3 )
+		> coarsestExtent )
+	{
+		levelVec.push_back( SLevel() );
+		coarsenLevel( levelVec[levelVec.size() - 2], levelVec.back(), D );
+	}
 
-  // Generate some reference to make reading the code easier
-  TField3D& grad = (*gradientFieldPtr);
-  ushort w = grad.getExtent(0);
-  ushort h = grad.getExtent(1);
-	ushort d = grad.getExtent(2);
-  TField3D& flowt = *outputPtr;
-  TField3D flowdt( 3, grad.getExtents() ); 	
-  flowt = grad;
-  // Time loop
-  ushort time = 0; ushort maxtime = ulIterations;;
-	PROG_MAX( maxtime );
-  while ( time <= maxtime )
-  {
-    APP_PROC();
-		for ( ushort z = 0; z < d; ++z )
-    	for ( ushort y = 0; y < h; ++y )
-      	for ( ushort x = 0; x < w; ++x )
-	      {
-  	      // Determine u(x,y,t)
-    	    TVector3D neigh( 0.0, 0.0, 0.0 ); // Value of discrete Laplacian operator
-      	  ushort times = 0;
-	        if ( x < w-1) { neigh+=flowt(x+1,y,z); times++; }
-  	      if ( x > 0) { neigh+=flowt(x-1,y,z); times++; }
-      	  if ( y < h-1) { neigh+=flowt(x,y+1,z); times++; }
-	        if ( y > 0) { neigh+=flowt(x,y-1,z); times++; }
-  	      if ( z < d-1) { neigh+=flowt(x,y,z+1); times++; }
-        	if ( z > 0) { neigh+=flowt(x,y,z-1); times++; }
-     	   	neigh -= static_cast<double>( times ) * flowt(x,y,z);
-	        // Determine u(x,y,t+1)
-	      	double g = exp ( -1.0 * norm( grad(x,y,z) ) / dKappa );
-    	  	double hf = 1.0 - g;					
-  	      flowdt(x,y,z)[0] = ( 1.0 - dDeltaT * hf ) 
-						* flowt(x,y,z)[0] + dMu * dDeltaT * neigh[0] * g
-						+ grad(x,y,z)[0] * hf * dDeltaT;
-		      // Do the same thing for v(x,y,t)
-    	    flowdt(x,y,z)[1] = ( 1.0 - dDeltaT * hf ) 
-						* flowt(x,y,z)[1] + dMu * dDeltaT * neigh[1] * g
-						+ grad(x,y,z)[1] * hf * dDeltaT;
-		      // Do the same thing for v(x,y,t)
-    	    flowdt(x,y,z)[2] = ( 1.0 - dDeltaT * hf ) 
-						* flowt(x,y,z)[2] + dMu * dDeltaT * neigh[2] * g
-						+ grad(x,y,z)[2] * hf * dDeltaT;
-	      }      
-		flowt.swap( flowdt );  
-    time++;     
-		PROG_VAL( time );
-  }  
-	outputPtr->setMinimum( TVector3D( -1.0, -1.0, -1.0 ) );
-	outputPtr->setMaximum( TVector3D( 1.0, 1.0, 1.0 ) );
+	ulUsedIterations = 0;
+	dResidual = sqrt( computeResidual<D>( levelVec[0] ) ) / dRightSideNorm;
+	PROG_MAX( ulIterations );
+	while( ulUsedIterations < ulIterations && dResidual > dTolerance )
+	{
+		if ( bMultigrid )
+			multigridCycle<D>( levelVec, 0 );
+		else
+			smoothLevel<D>( levelVec[0] );
+		++ulUsedIterations;
+		dResidual = sqrt( computeResidual<D>( levelVec[0] ) ) / dRightSideNorm;
+		PROG_VAL( ulUsedIterations );
+		APP_PROC();
+	}
 	PROG_RESET();
-	setOutput( outputPtr );  
-}
+	alog << LINFO << ( bMultigrid ? "Multigrid" : "Gauss-Seidel" ) << " solver used " << ulUsedIterations
+		<< " iterations, relative residual " << dResidual << endl;
 
-void CVectorFlow::ggvf3D( shared_ptr<TField3D> gradientFieldPtr ) throw()
-{
-  shared_ptr<TField3D> outputPtr ( new TField3D( 3, gradientFieldPtr->getExtents() ) );
-
-  TVector3D maxVec; maxVec[0] = 1.0; maxVec[1] = 1.0;
-  outputPtr->setMaximum( maxVec );
-
-	// Get the parameters
-	double dDeltaT = parameters.getDouble( "DeltaT" );
-	double dMu = parameters.getDouble( "Mu" );
-	double dKappa = parameters.getDouble( "Kappa" );
-	ulong ulIterations = parameters.getUnsignedLong( "Iterations" );
-
-  // Generate some reference to make reading the code easier
-  TField3D& grad = (*gradientFieldPtr);
-  ushort w = grad.getExtent(0);
-  ushort h = grad.getExtent(1);
-	ushort d = grad.getExtent(2);
-  TField3D& flowt = *outputPtr;
-  TField3D flowdt( 3, grad.getExtents() ); 
-  CTypedData<double> g ( 3, grad.getExtents() );
-  CTypedData<double> hf ( 3, grad.getExtents() );
-	PROG_MAX( d );
-	for ( int z = 0; z < d; ++z )
+	shared_ptr<TFieldType> outputPtr( new TFieldType( D, gradientField.getExtents() ) );
+	typename TFieldType::TDataType* outputArr = outputPtr->getArray();
+	typename TFieldType::TDataType minimumVector;
+	typename TFieldType::TDataType maximumVector;
+	for( unsigned int c = 0; c < D; ++c )
 	{
-		PROG_VAL( z );
-  	for ( int y = 0; y < h; ++y )
-    	for ( int x = 0; x < w; ++x )
-    	{
-      	// Define the time-invariant weighting functions
-	      g(x,y,z) = exp ( -1.0 * norm( grad(x,y,z) )  / dKappa );
-    	  hf(x,y,z) = 1.0 - g(x,y,z);
-    	}
+		minimumVector[c] = -1.0;
+		maximumVector[c] = 1.0;
 	}
-	
-	PROG_RESET();
-  flowt = grad;
-  // Time loop
-  ushort time = 0; ushort maxtime = ulIterations;;
-	PROG_MAX( maxtime );
-  while ( time <= maxtime )
-  {
-  	cerr << "GGVF iteration " << time << endl;
-    APP_PROC();
-		for ( ushort z = 0; z < d; ++z )
-    	for ( ushort y = 0; y < h; ++y )
-      	for ( ushort x = 0; x < w; ++x )
-	      {
-  	      // Determine u(x,y,t)
-    	    TVector3D neigh( 0.0, 0.0, 0.0 ); // Value of discrete Laplacian operator
-      	  ushort times = 0;
-	        if ( x < w-1) { neigh+=flowt(x+1,y,z); times++; }
-  	      if ( x > 0) { neigh+=flowt(x-1,y,z); times++; }
-      	  if ( y < h-1) { neigh+=flowt(x,y+1,z); times++; }
-	        if ( y > 0) { neigh+=flowt(x,y-1,z); times++; }
-  	      if ( z < d-1) { neigh+=flowt(x,y,z+1); times++; }
-        	if ( z > 0) { neigh+=flowt(x,y,z-1); times++; }
-     	   	neigh -= static_cast<double>( times ) * flowt(x,y,z);
-	        // Determine u(x,y,t+1)
-  	      flowdt(x,y,z)[0] = ( 1.0 - dDeltaT * hf(x,y,z) ) 
-						* flowt(x,y,z)[0] + dMu * dDeltaT * neigh[0] * g(x,y,z) 
-						+ grad(x,y,z)[0] * hf(x,y,z) * dDeltaT;
- 		      // Do the same thing for v(x,y,t)
-    	    flowdt(x,y,z)[1] = ( 1.0 - dDeltaT * hf(x,y,z) ) 
-						* flowt(x,y,z)[1] + dMu * dDeltaT * neigh[1] * g(x,y,z) 
-						+ grad(x,y,z)[1] * hf(x,y,z) * dDeltaT;
- 		      // Do the same thing for w(x,y,t)
-    	    flowdt(x,y,z)[2] = ( 1.0 - dDeltaT * hf(x,y,z) ) 
-						* flowt(x,y,z)[2] + dMu * dDeltaT * neigh[2] * g(x,y,z) 
-						+ grad(x,y,z)[2] * hf(x,y,z) * dDeltaT;
-	      }      
-		flowt = flowdt;  
-    time++;      
-		PROG_VAL( time );
-  }  
-	outputPtr->setMinimum( TVector3D( -1.0, -1.0, -1.0 ) );
-	outputPtr->setMaximum( TVector3D( 1.0, 1.0, 1.0 ) );	
-	PROG_RESET();
+	for( size_t i = 0; i < voxelCount; ++i )
+		for( unsigned int c = 0; c < D; ++c )
+			outputArr[i][c] = levelVec[0].solutionVec[i * D + c];
+	outputPtr->setMinimum( minimumVector );
+	outputPtr->setMaximum( maximumVector );
 	setOutput( outputPtr );
 }
 
@@ -464,7 +862,7 @@ void CVectorFlow::gvf2Dblitz( shared_ptr<TField2D> gradientFieldPtr ) throw()
      }
   bhf = 1.0 - bg;
   // Time loop
-  ushort time = 0; ushort maxtime = ulIterations;;    
+  ulong time = 0; ulong maxtime = ulIterations;    
 	PROG_MAX( maxtime );
   while ( time <= maxtime )
   {
@@ -559,7 +957,7 @@ void CVectorFlow::gvf3Dblitz( shared_ptr<TField3D> gradientFieldPtr ) throw()
 	
 	PROG_RESET();  
   // Time loop
-  ushort time = 0; ushort maxtime = ulIterations;
+  ulong time = 0; ulong maxtime = ulIterations;
 	PROG_MAX( maxtime );
   while ( time <= maxtime )
   {
@@ -5,7 +5,7 @@
  *                                                                      *
  * Author: Hendrik Belitz                                               *
  *                                                                      *
- * Version: 0.7                                                         *
+ * Version: 0.9                                                         *
  * Status : Alpha                                                       *
  * Created: 01.09.03                                                    *
  * Changed: 04.09.03 Implementation of generalized model                *
@@ -20,6 +20,9 @@
  *                   Simplified and clarified code                      *
  *          07.05.04 Corrected an error ( min/max of output were not    *
  *                   set, so some modules failes on using the output )  *
+ *          2026-10-17 Added multigrid and Gauss-Seidel solvers with    *
+ *                   a residual based stopping criterion                *
+ *                   Explicit scheme works on threaded component planes *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -55,6 +58,10 @@ using namespace aips;
 
 /**
  * Class to compute the GVF field from a given vector field
+ *
+ * Besides the explicit finite difference scheme the steady state of GVF and GGVF
+ * can be computed directly with red-black Gauss-Seidel sweeps or multigrid V-cycles.
+ * These solvers stop as soon as the relative residual drops below "Tolerance".
  */
 class CVectorFlow : public CFilter
 {
@@ -80,18 +87,25 @@ public:
   /// Reimplemented from CPipelineItem
 	virtual void apply()
     throw();
+/* Accessors */
+	/// Returns the number of iterations or V-cycles used by the last run of an iterative solver
+	ulong getUsedIterations() const
+		throw();
+	/// Returns the relative residual reached by the last run of an iterative solver
+	double getResidual() const
+		throw();
 private:
 	boost::shared_ptr<TImage> roiPtr;
 	bool bRoiSelf;
+	ulong ulUsedIterations; ///< Iterations used by the last run of an iterative solver
+	double dResidual;       ///< Relative residual reached by the last run of an iterative solver
 /* Implementation of the different algorithms */
-	/// 2D GVF algorithm
-	void gvf2D( boost::shared_ptr<TField2D> gradientFieldPtr ) throw();
-	/// 2D GGVF algorithm
-	void ggvf2D( boost::shared_ptr<TField2D> gradientFieldPtr ) throw();
-	/// 3D GVF algorithm
-	void gvf3D( boost::shared_ptr<TField3D> gradientFieldPtr ) throw();
-	/// 3D GGVF algorithm
-	void ggvf3D( boost::shared_ptr<TField3D> gradientFieldPtr ) throw();
+	/// GVF and GGVF with the explicit finite difference scheme
+	template<unsigned int D, typename TFieldType> void explicitFlow( const TFieldType& gradientField )
+		throw();
+	/// GVF and GGVF with the Gauss-Seidel or multigrid solver
+	template<unsigned int D, typename TFieldType> void solveFlow( const TFieldType& gradientField )
+		throw();
 #ifdef USE_BLITZ	
 	/// 2D GGVF algorithm with blitz support
 	void gvf2Dblitz( boost::shared_ptr<TField2D> gradientFieldPtr ) throw();
@@ -1,7 +1,7 @@
 /************************************************************************
- * File: $FILE                                                          *
+ * File: cbinarymorphology.cpp                                          *
  * Project: AIPS                                                        *
- * Description:                                                         *
+ * Description: Morphological operations on binary images               *
  *                                                                      *
  * Author: Hendrik Belitz (h.belitz@fz-juelich.de)                      *
  *                                                                      *
@@ -22,7 +22,7 @@ using namespace boost;
  *************/
  
 CBinaryMorphology::CBinaryMorphology( ulong ulID ) throw()
-: CFilter ( ulID, "Binary morphology operator", 2, 1, "CBinaryMorphology", "0.1", "CFilter" )
+: CFilter ( ulID, "Binary morphology operator", 2, 1, "CBinaryMorphology", "0.2", "CFilter" )
 {
   setModuleID( sLibID );
   sDocumentation = "A simple morphological operator\n"
@@ -31,10 +31,15 @@ CBinaryMorphology::CBinaryMorphology( ulong ulID ) throw()
                    "** Output ports:\n"
                    "1: A singlechannel image\n"
                    "** Parameters:\n"
-                   "Type: 0 : Dilation, 1 : Erosion\n"
-									 "Iterations: Number of filter steps\n"
-									 "Kernel height: Strength of structural element\n"
-									 "Only Background: Work only on voxels with background neighbourhood\n";
+                   "Operation: 0 : Iterated 3x3 steps selected by Type, 1 : Erosion, "
+                   "2 : Dilation, 3 : Opening, 4 : Closing\n"
+                   "Type: 0 : Erosion, 1 : Dilation (Operation 0 only)\n"
+									 "Iterations: Number of filter steps (Operation 0 only)\n"
+									 "Kernel height: Strength of structural element (Operation 0 only)\n"
+									 "Only Background: Work only on voxels with background neighbourhood "
+									 "(Operation 0 only)\n"
+                   "Radius X, Radius Y, Radius Z: Half size of the box (Operations 1-4). "
+                   "A single radius greater than 0 gives a line element\n";
 
   parameters.initBool( "Type", false );
   parameters.initUnsignedLong( "Iterations", 1UL, 1UL, 1000UL );
@@ -42,6 +47,10 @@ CBinaryMorphology::CBinaryMorphology( ulong ulID ) throw()
 	parameters.initBool( "Only background", false );
 	parameters.initUnsignedLong( "What", 1UL, -32767UL, 32767UL );
 	parameters.initUnsignedLong( "From", 0UL, -32767UL, 32767UL );
+  parameters.initUnsignedLong( "Operation", 0UL, 0UL, 4UL );
+  parameters.initUnsignedLong( "Radius X", 1UL, 0UL, 1000UL );
+  parameters.initUnsignedLong( "Radius Y", 1UL, 0UL, 1000UL );
+  parameters.initUnsignedLong( "Radius Z", 1UL, 0UL, 1000UL );
 
   inputsVec[0].portType = CPipelineItem::IOInteger;
 	inputsVec[1].portType = CPipelineItem::IOInteger;
@@ -66,6 +75,17 @@ BENCHSTART;
     alog << LWARN << SERROR("Input type is no image!") << endl;
     return;
   }
+	if ( inputPtr->getDimension() > 3 )
+  {
+    alog << LWARN << SERROR("Input type is no 2D or 3D image!") << endl;
+    return;
+  }
+	if ( parameters.getUnsignedLong( "Operation" ) > 0 )
+	{
+		morphMask( *inputPtr );
+BENCHSTOP;
+		return;
+	}
 
   size_t kernelSize[] = { 3, 3, 3 };
   TImage kernel( inputPtr->getDimension(), kernelSize );
@@ -286,3 +306,47 @@ void CBinaryMorphology::morph3D( const TImage& input, const TImage& kernel ) thr
   setOutput( outputPtr );
 	PROG_RESET();
 }
+
+/**
+ * Only the first channel is filtered. Voxels outside the region of interest
+ * keep their input values.
+ * \param input image to filter
+ */
+void CBinaryMorphology::morphMask( const TImage& input ) throw()
+{
+	bModuleReady = true;
+  deleteOldOutput();
+
+	const ulong ulOperation = parameters.getUnsignedLong( "Operation" );
+	const size_t radiusArr[] = { parameters.getUnsignedLong( "Radius X" ),
+		parameters.getUnsignedLong( "Radius Y" ), parameters.getUnsignedLong( "Radius Z" ) };
+	vector<size_t> extentVec( input.getExtents() );
+	extentVec.resize( input.getDimension() );
+	CBitMask mask( extentVec );
+	mask.fromArray( &input[0] );
+	// Opening erodes first, closing dilates first
+	if ( ulOperation == 1 || ulOperation == 3 )
+		mask.erode( radiusArr );
+	else
+		mask.dilate( radiusArr );
+	if ( ulOperation == 3 )
+		mask.dilate( radiusArr );
+	else if ( ulOperation == 4 )
+		mask.erode( radiusArr );
+
+	TImagePtr outputPtr ( new TImage( input.getDimension(), input.getExtents(), 1 ) );
+	mask.toArray<TImage::TDataType>( &( *outputPtr )[0], 0, 1 );
+	outputPtr->setDataRange( 0, 1 );
+	TImagePtr roiPtr = static_pointer_cast<TImage>( getInput( 1 ) );
+	if ( roiPtr.get() != NULL )
+	{
+		const TImage::TDataType* roiArr = &( *roiPtr )[0];
+		for ( size_t i = 0; i < mask.getExtent( 0 ) * mask.getExtent( 1 ) * mask.getExtent( 2 ); ++i )
+			if ( roiArr[i] <= 0 )
+			{
+				( *outputPtr )[i] = input[i];
+				outputPtr->adjustDataRange( input[i] );
+			}
+	}
+  setOutput( outputPtr );
+}
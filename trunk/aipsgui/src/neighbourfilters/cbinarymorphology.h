@@ -1,14 +1,14 @@
 /************************************************************************
- * File: $FILE                                                          *
+ * File: cbinarymorphology.h                                            *
  * Project: AIPS                                                        *
- * Description:                                                         *
+ * Description: Morphological operations on binary images               *
  *                                                                      *
  * Author: Hendrik Belitz (h.belitz@fz-juelich.de)                      *
  *                                                                      *
- * Version: 0.1                                                         *
+ * Version: 0.2                                                         *
  * Status:  Pre-Alpha                                                   *
  * Created: $DATE                                                       *
- * Changed:                                                             *
+ * Changed: 2026-10-17 Added bit packed box operations of any radius    *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -21,13 +21,18 @@
 #include <cfilter.h>
 #include <aipsnumeric.h>
 #include <cglobalprogress.h>
+#include <cbitmask.h>
 
 #include "libid.h"
 
 using namespace aips;
  
 /**
- * A class for simple morphological operations
+ * A class for simple morphological operations on binary images.
+ *
+ * Operation 0 iterates the classic 3x3 step. All other operations treat
+ * voxels different from 0 as foreground and work on a CBitMask with a box of
+ * the given radii. The output then holds 0 and 1.
  */
 class CBinaryMorphology : public CFilter
 {
@@ -59,6 +64,9 @@ private:
 	/// Actual implementation for 3D
 	void morph3D( const TImage& input, const TImage& kernel ) 
 		throw();
+	/// Erosion, dilation, opening or closing with a box on a bit mask
+	void morphMask( const TImage& input )
+		throw();
 };
 
 #endif
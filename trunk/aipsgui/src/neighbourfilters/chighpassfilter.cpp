@@ -52,7 +52,7 @@ CHighPassFilter::~CHighPassFilter() throw()
 void CHighPassFilter::apply() throw()
 {
 	bModuleReady = false;
-  TImagePtr inputPtr = static_pointer_cast<TImage>( getInput() );
+  TDataSetPtr inputPtr = getInput();
   if ( inputPtr.get() == NULL || inputPtr->getDimension() < 2 || inputPtr->getDimension() > 3 )
   {
     alog << LWARN << SERROR("Input type is no 2D or 3D image!") << endl;
@@ -61,43 +61,25 @@ void CHighPassFilter::apply() throw()
 	bModuleReady = true;
   deleteOldOutput();
 	
-#ifdef USE_BLITZ
-	TImagePtr outputPtr; outputPtr.reset();
-  if ( inputPtr->getDimension() == 2 )
-  {
-    Array<double, 2> kernel( 3, 3 );
-    kernel = -1.0 / 9.0;
-    kernel( 1, 1 ) = ( 9.0 * parameters.getDouble( "Unsharp mask" ) - 1.0 ) / 9.0;
-    outputPtr = applyKernel( inputPtr, kernel );
-  }
-  else
-  {
-    Array<double, 3> kernel( 3, 3, 3 );
-    kernel = -1.0 / 27.0;
-    kernel( 1, 1, 1 ) = ( 27.0 * parameters.getDouble( "Unsharp mask" ) - 1.0 ) / 27.0;
-    outputPtr = applyKernel( inputPtr, kernel );
-  }
-#else
   size_t dims[] = { 3, 3, 3 };
   CTypedData<double> kernel( inputPtr->getDimension(), dims );
   if ( inputPtr->getDimension() == 2 )
   {
     kernel = -1.0/ 9.0;
-    kernel( 1, 1 ) = ( 9.0 * parameters.getDouble( "Unsharp mask" ) - 1.0 ) / 9.0;
+    kernel( 1, 1 ) = ( 9.0 * parameters.getDouble( "UnsharpMask" ) - 1.0 ) / 9.0;
   }
   else
   {
     kernel = -1.0 / 27.0;
-    kernel( 1, 1, 1 ) = ( 27.0 * parameters.getDouble( "Unsharp mask" ) - 1.0 ) / 27.0;
+    kernel( 1, 1, 1 ) = ( 27.0 * parameters.getDouble( "UnsharpMask" ) - 1.0 ) / 27.0;
   }
-  TImagePtr outputPtr = applyKernel( inputPtr, kernel );
-#endif /* USE_STANDALONE */
+  // Like the original implementation, store the magnitude of the response
+  TDataSetPtr outputPtr = convolve( inputPtr, kernel, true );
   if ( outputPtr.get() == NULL )
   {
     alog << LWARN << SERROR( "invalid input data" ) << endl;
     return;
   }
-  outputPtr->setDataRange( inputPtr->getDataRange() );
   setOutput( outputPtr );
 FEND;
 }
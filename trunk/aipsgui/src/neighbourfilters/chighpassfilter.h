@@ -16,6 +16,8 @@
  *          12.11.03 Filter now inherits from CKernelFilter            *
  *          18.12.03 Class now holds Blitz and Standalone versions     *
  *          29.01.04 Clarified and documented source code              *
+ *        2026-10-17 Accepts all types of imageTL. Fixed the name of   *
+ *                    the parameter "UnsharpMask"                      *
  ***********************************************************************/
 
 #ifndef CHIGHPASSFILTER_H
@@ -29,7 +31,8 @@
 using namespace aips;
 
 /**
- * An unsharp mask high pass filter in image space.
+ * An unsharp mask high pass filter in image space. The output holds the
+ * absolute values of the filter response (truncated for integer types).
  */
 class CHighPassFilter : public CKernelFilter
 {
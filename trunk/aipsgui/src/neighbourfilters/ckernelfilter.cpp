@@ -15,12 +15,241 @@
 
 #include "ckernelfilter.h"
 
+// Standard includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// AIPS includes
+#include <aipsparallel.h>
+
 using namespace std;
 using namespace boost;
 #ifdef USE_BLITZ
 using namespace blitz;
 #endif
 
+namespace
+{
+
+/**
+ * Accumulator type of the convolution. Integer images are accumulated in float,
+ * which is exact enough for their range and twice as fast in vectorised loops.
+ */
+template<typename T> struct SAccumulator
+{
+	typedef float TType;
+};
+template<> struct SAccumulator<double>
+{
+	typedef double TType;
+};
+
+/**
+ * Converts an accumulated value to the data type. Integer types are rounded and clamped.
+ * If bAbsolute is set, the absolute value is used instead and integer types truncate it,
+ * like the original applyKernel() implementations did.
+ */
+template<typename T, typename A> inline T toValue( A theValue, const bool bAbsolute )
+{
+	if ( bAbsolute )
+		theValue = std::fabs( theValue );
+	if ( numeric_limits<T>::is_integer )
+	{
+		theValue = bAbsolute ? std::floor( theValue ) : std::floor( theValue + static_cast<A>( 0.5 ) );
+		if ( theValue < static_cast<A>( numeric_limits<T>::min() ) )
+			return numeric_limits<T>::min();
+		if ( theValue > static_cast<A>( numeric_limits<T>::max() ) )
+			return numeric_limits<T>::max();
+	}
+	return static_cast<T>( theValue );
+}
+
+/**
+ * Correlates one line with a 1D kernel. Zero padding of the line buffer replaces
+ * all border checks.
+ * \param paddedPtr line with tapCount - 1 padding elements around it
+ * \param outputPtr output line (overwritten)
+ */
+template<typename A> inline void correlateLine( const A* paddedPtr, A* outputPtr, const size_t lineSize,
+	const A* tapPtr, const size_t tapCount )
+{
+	std::fill( outputPtr, outputPtr + lineSize, static_cast<A>( 0 ) );
+	for( size_t k = 0; k < tapCount; ++k )
+	{
+		const A theTap = tapPtr[k];
+		if ( theTap == static_cast<A>( 0 ) )
+			continue;
+		const A* inPtr = paddedPtr + k;
+		for( size_t x = 0; x < lineSize; ++x )
+			outputPtr[x] += theTap * inPtr[x];
+	}
+}
+
+/**
+ * Correlates along an axis whose neighbours are blockSize elements apart
+ * (a row of a slice or a slice of a volume). Only the taps inside the data are
+ * summed up, so border blocks simply use fewer taps.
+ * \param inputPtr first block of the input
+ * \param outputPtr output block (overwritten)
+ * \param position position of the output block along the axis
+ * \param extent number of blocks along the axis
+ */
+template<typename A> inline void correlateBlocks( const A* inputPtr, A* outputPtr, const size_t blockSize,
+	const size_t position, const size_t extent, const vector<A>& tapVec, const size_t tapOffset )
+{
+	std::fill( outputPtr, outputPtr + blockSize, static_cast<A>( 0 ) );
+	const size_t firstTap = ( position < tapOffset ) ? tapOffset - position : 0;
+	const size_t lastTap = std::min( tapVec.size(), extent + tapOffset - position );
+	for( size_t k = firstTap; k < lastTap; ++k )
+	{
+		const A theTap = tapVec[k];
+		if ( theTap == static_cast<A>( 0 ) )
+			continue;
+		const A* inPtr = inputPtr + ( position + k - tapOffset ) * blockSize;
+		for( size_t i = 0; i < blockSize; ++i )
+			outputPtr[i] += theTap * inPtr[i];
+	}
+}
+
+/// Copies a line into the middle of a zero padded buffer
+template<typename T, typename A> inline void padLine( const T* linePtr, const size_t lineSize,
+	const size_t tapOffset, vector<A>& paddedVec )
+{
+	std::fill( paddedVec.begin(), paddedVec.end(), static_cast<A>( 0 ) );
+	for( size_t x = 0; x < lineSize; ++x )
+		paddedVec[tapOffset + x] = static_cast<A>( linePtr[x] );
+}
+
+/// Geometry and kernel shared by all workers of one channel
+template<typename T, typename A> struct SConvolution
+{
+	size_t extentArr[3];          ///< Image extents (z extent 1 for images)
+	size_t tapCountArr[3];        ///< Kernel extents
+	size_t tapOffsetArr[3];       ///< Kernel centre
+	vector<A> tapVecArr[3];       ///< Factors of a separable kernel
+	vector<A> kernelVec;          ///< Full kernel
+	const T* inputPtr;            ///< Input channel
+	T* outputPtr;                 ///< Output channel
+	A* intermediatePtr;           ///< Result of the x and y passes if a z pass follows, else NULL
+	bool bAbsolute;               ///< Store the absolute values of the results?
+
+	/**
+	 * x and y pass of a separable kernel. The result is converted to the output or
+	 * stored in the intermediate buffer if a z pass follows.
+	 */
+	void separableXY( const size_t zBegin, const size_t zEnd ) const
+	{
+		const size_t lineSize = extentArr[0];
+		const size_t sliceSize = extentArr[0] * extentArr[1];
+		vector<A> paddedVec( lineSize + tapCountArr[0] - 1 );
+		vector<A> rowsVec( sliceSize );
+		vector<A> sliceVec( sliceSize );
+		for( size_t z = zBegin; z < zEnd; ++z )
+		{
+			for( size_t y = 0; y < extentArr[1]; ++y )
+			{
+				padLine( inputPtr + z * sliceSize + y * lineSize, lineSize, tapOffsetArr[0], paddedVec );
+				correlateLine( &paddedVec[0], &rowsVec[y * lineSize], lineSize, &tapVecArr[0][0],
+					tapCountArr[0] );
+			}
+			A* targetPtr = ( intermediatePtr == NULL ) ? &sliceVec[0] : intermediatePtr + z * sliceSize;
+			for( size_t y = 0; y < extentArr[1]; ++y )
+				correlateBlocks( &rowsVec[0], targetPtr + y * lineSize, lineSize, y, extentArr[1],
+					tapVecArr[1], tapOffsetArr[1] );
+			if ( intermediatePtr == NULL )
+				for( size_t i = 0; i < sliceSize; ++i )
+					outputPtr[z * sliceSize + i] = toValue<T>( sliceVec[i], bAbsolute );
+		}
+	}
+	/// z pass of a separable kernel
+	void separableZ( const size_t zBegin, const size_t zEnd ) const
+	{
+		const size_t sliceSize = extentArr[0] * extentArr[1];
+		vector<A> sliceVec( sliceSize );
+		for( size_t z = zBegin; z < zEnd; ++z )
+		{
+			correlateBlocks( intermediatePtr, &sliceVec[0], sliceSize, z, extentArr[2],
+				tapVecArr[2], tapOffsetArr[2] );
+			for( size_t i = 0; i < sliceSize; ++i )
+				outputPtr[z * sliceSize + i] = toValue<T>( sliceVec[i], bAbsolute );
+		}
+	}
+	/// Direct correlation with a non separable kernel
+	void full( const size_t zBegin, const size_t zEnd ) const
+	{
+		const size_t lineSize = extentArr[0];
+		const size_t sliceSize = extentArr[0] * extentArr[1];
+		vector<A> paddedVec( lineSize + tapCountArr[0] - 1 );
+		vector<A> lineVec( lineSize );
+		vector<A> sumVec( lineSize );
+		for( size_t z = zBegin; z < zEnd; ++z )
+			for( size_t y = 0; y < extentArr[1]; ++y )
+			{
+				std::fill( sumVec.begin(), sumVec.end(), static_cast<A>( 0 ) );
+				for( size_t kz = 0; kz < tapCountArr[2]; ++kz )
+				{
+					if ( z + kz < tapOffsetArr[2] || z + kz - tapOffsetArr[2] >= extentArr[2] )
+						continue;
+					for( size_t ky = 0; ky < tapCountArr[1]; ++ky )
+					{
+						if ( y + ky < tapOffsetArr[1] || y + ky - tapOffsetArr[1] >= extentArr[1] )
+							continue;
+						padLine( inputPtr + ( z + kz - tapOffsetArr[2] ) * sliceSize
+							+ ( y + ky - tapOffsetArr[1] ) * lineSize, lineSize, tapOffsetArr[0], paddedVec );
+						correlateLine( &paddedVec[0], &lineVec[0], lineSize,
+							&kernelVec[( kz * tapCountArr[1] + ky ) * tapCountArr[0]], tapCountArr[0] );
+						for( size_t x = 0; x < lineSize; ++x )
+							sumVec[x] += lineVec[x];
+					}
+				}
+				for( size_t x = 0; x < lineSize; ++x )
+					outputPtr[z * sliceSize + y * lineSize + x] = toValue<T>( sumVec[x], bAbsolute );
+			}
+	}
+};
+
+/**
+ * Tests whether a kernel is the outer product of three 1D kernels.
+ * \param kernelVec kernel elements, x running fastest
+ * \param tapCountArr kernel extents
+ * \param factorVecArr receives the 1D kernels if the kernel is separable
+ * \returns true if the kernel is separable
+ */
+bool separateKernel( const vector<double>& kernelVec, const size_t* tapCountArr, vector<double>* factorVecArr )
+{
+	// Use the largest element as pivot
+	size_t pivot = 0;
+	for( size_t i = 1; i < kernelVec.size(); ++i )
+		if ( std::fabs( kernelVec[i] ) > std::fabs( kernelVec[pivot] ) )
+			pivot = i;
+	const double dPivot = kernelVec[pivot];
+	if ( dPivot == 0.0 )
+		return false;
+	size_t pivotArr[3] = { pivot % tapCountArr[0], ( pivot / tapCountArr[0] ) % tapCountArr[1],
+		pivot / ( tapCountArr[0] * tapCountArr[1] ) };
+	size_t strideArr[3] = { 1, tapCountArr[0], tapCountArr[0] * tapCountArr[1] };
+	for( int d = 0; d < 3; ++d )
+	{
+		// The first factor keeps the magnitude, the others are normalised by the pivot
+		const size_t lineStart = pivot - pivotArr[d] * strideArr[d];
+		factorVecArr[d].resize( tapCountArr[d] );
+		for( size_t k = 0; k < tapCountArr[d]; ++k )
+			factorVecArr[d][k] = kernelVec[lineStart + k * strideArr[d]] / ( d == 0 ? 1.0 : dPivot );
+	}
+	const double dTolerance = 1.0e-9 * std::fabs( dPivot );
+	for( size_t z = 0; z < tapCountArr[2]; ++z )
+		for( size_t y = 0; y < tapCountArr[1]; ++y )
+			for( size_t x = 0; x < tapCountArr[0]; ++x )
+				if ( std::fabs( factorVecArr[0][x] * factorVecArr[1][y] * factorVecArr[2][z]
+					- kernelVec[x + y * strideArr[1] + z * strideArr[2]] ) > dTolerance )
+					return false;
+	return true;
+}
+
+}
+
 /*************
  * Structors *
  *************/
@@ -56,205 +285,142 @@ CKernelFilter::~CKernelFilter() throw()
  */
 TImagePtr CKernelFilter::applyKernel( TImagePtr dataPtr, Array<double, 3>& kernel ) throw()
 {
-BENCHSTART;
-
-  size_t usDims[] = { dataPtr->getExtent(0), dataPtr->getExtent(1), 
-		dataPtr->getExtent(2) };
-  TImagePtr outputPtr ( new TImage( 3, dataPtr->getExtents(), 
-		dataPtr->getDataDimension() ) );
-	outputPtr->setDataRange( dataPtr->getDataRange() );
-
-  ushort usRadius = ( kernel.cols() - 1 ) / 2; // Filter kernel size
-
-DBG2("Starting filter BLITZ++");
-	PROG_MAX( dataPtr->getDataDimension() );
-
-  for ( ushort usChannels = 0; usChannels < dataPtr->getDataDimension(); 
-		++usChannels )
-  {
-		PROG_VAL( usChannels + 1 );	
-    Array<short, 3> work ( dataPtr->getArray( usChannels ),
-      shape(usDims[0], usDims[1], usDims[2]), neverDeleteData, AIPSArray<3>() );
-
-    Array<short, 3> output ( outputPtr->getArray( usChannels ),
-      shape(usDims[0], usDims[1], usDims[2]), neverDeleteData, AIPSArray<3>() );
-
-    for ( Array<short, 3>::iterator it = work.begin(); it != work.end(); ++it )
-    {
-      TinyVector<int, 3> position = it.position();
-      double dTmp = 0;
-      for ( int k = position[0] - usRadius; k < ( position[0] + usRadius + 1 ); ++k )
-        for ( int l = position[1] - usRadius; l < ( position[1] + usRadius + 1 ); ++l )
-          for ( int m = position[2] - usRadius; m < ( position[2] + usRadius + 1 ); ++m )
-      {
-        int i = k + usRadius - position[0];
-        int j = l + usRadius - position[1];
-        int n = m + usRadius - position[2];
-        if ( k < work.rows() && k > -1 && l < work.cols()
-          && l > -1 && m < work.depth() && m > -1 )
-          dTmp += work( k, l, m ) * kernel( i, j, n );
-      }
-      output( position ) = static_cast<ushort>( std::abs( static_cast<long>( dTmp ) ) );
-      outputPtr->adjustDataRange( output( position ) );
-    }
-  }
-	PROG_RESET();	
-BENCHSTOP;
-  return outputPtr;
+  size_t dims[] = { kernel.rows(), kernel.cols(), kernel.depth() };
+  CTypedData<double> theKernel( 3, dims );
+  for( size_t z = 0; z < dims[2]; ++z )
+    for( size_t y = 0; y < dims[1]; ++y )
+      for( size_t x = 0; x < dims[0]; ++x )
+        theKernel( x, y, z ) = kernel( x, y, z );
+  return applyKernel( dataPtr, theKernel );
 }
 
 /**
  * This method will NOT check the type and dimension of the data field!
  * \param dataPtr A given data set ( Scalar image )
- * \param theKernel Filter kernel
+ * \param kernel Filter kernel
  */
 TImagePtr CKernelFilter::applyKernel( TImagePtr dataPtr, Array<double, 2>& kernel ) throw()
 {
-BENCHSTART;
-
-	size_t usDims[] = { dataPtr->getExtent(0), dataPtr->getExtent(1) };
-
-	TImagePtr outputPtr ( new TImage( 2, dataPtr->getExtents(), dataPtr->getDataDimension() ) );
-	outputPtr->setDataRange( dataPtr->getDataRange() );
-
-  ushort usRadius = ( kernel.cols() - 1 ) / 2; // Filter kernel size
-	PROG_MAX( dataPtr->getDataDimension() );
-  for ( ushort usChannels = 0; usChannels < dataPtr->getDataDimension(); ++usChannels )
-  {		
-		PROG_VAL( usChannels + 1 );
-    Array<short,2> work ( dataPtr->getArray( usChannels ),
-      shape(usDims[0], usDims[1]), neverDeleteData, AIPSArray<2>() );
-
-    Array<short,2> output ( outputPtr->getArray( usChannels ),
-      shape(usDims[0], usDims[1]), neverDeleteData, AIPSArray<2>() );
-
-		Array<short, 2>::iterator oit = output.begin();
-    for ( Array<short, 2>::iterator it = work.begin(); it != work.end(); ++it, ++oit )
-    {
-      TinyVector<int, 2> position = it.position();
-      double dTmp = 0;
-      for ( int k = position(0) - usRadius; k < ( position(0) + usRadius + 1 ); ++k )
-        for ( int l = position(1) - usRadius; l < ( position(1) + usRadius + 1 ); ++l )
-      {
-        int i = k + usRadius - position(0);
-        int j = l + usRadius - position(1);
-        if ( k < work.rows() && k > -1 && l < work.cols() && l > -1 )
-          dTmp += static_cast<double>( work( k, l ) ) * kernel( i, j );
-      }
-      (*oit) = static_cast<ushort>( std::abs( static_cast<long>( dTmp ) ) );
-      outputPtr->adjustDataRange( *oit );
-    }
-  }
-PROG_RESET();	
-BENCHSTOP;
-  return outputPtr;
+  size_t dims[] = { kernel.rows(), kernel.cols() };
+  CTypedData<double> theKernel( 2, dims );
+  for( size_t y = 0; y < dims[1]; ++y )
+    for( size_t x = 0; x < dims[0]; ++x )
+      theKernel( x, y ) = kernel( x, y );
+  return applyKernel( dataPtr, theKernel );
 }
 
 #endif /* USE_BLITZ */
 
 /**
  * This method will NOT check the type and dimension of the data field!
+ * The output holds the absolute values of the filter response.
  * \param dataPtr A given data set ( Scalar image )
- * \param theKernel Filter kernel
+ * \param kernel Filter kernel
  */
 TImagePtr CKernelFilter::applyKernel ( TImagePtr dataPtr, CTypedData<double>& kernel ) throw()
+{
+  if ( !dataPtr )
+    return TImagePtr();
+  return convolveImage( *dataPtr, kernel, true );
+}
+
+/**
+ * The kernel must have the same dimension as the data set. Borders are zero padded.
+ * \param dataPtr image or volume of a type of imageTL
+ * \param kernel filter kernel
+ * \param bAbsolute store the absolute values of the response (truncated for integer
+ *   types) instead of the rounded and clamped signed values
+ * \returns the filtered data set, NULL if the input type is not supported
+ */
+TDataSetPtr CKernelFilter::convolve( TDataSetPtr dataPtr, const CTypedData<double>& kernel,
+  const bool bAbsolute ) throw()
+{
+  if ( !dataPtr || dataPtr->getDimension() < 2 || dataPtr->getDimension() > 3
+    || kernel.getDimension() != dataPtr->getDimension() )
+    return TDataSetPtr();
+  if ( checkType<TImage>( *dataPtr ) )
+    return convolveImage( static_cast<const TImage&>( *dataPtr ), kernel, bAbsolute );
+  if ( checkType<TField>( *dataPtr ) )
+    return convolveImage( static_cast<const TField&>( *dataPtr ), kernel, bAbsolute );
+  if ( checkType<TSmallImage>( *dataPtr ) )
+    return convolveImage( static_cast<const TSmallImage&>( *dataPtr ), kernel, bAbsolute );
+  return TDataSetPtr();
+}
+
+/**
+ * Separable kernels (e.g. uniform or gaussian ones) are detected and applied one
+ * axis at a time, which reduces the work per voxel from r^3 to 3r multiplications.
+ * Volumes with a separable kernel need an intermediate buffer of the accumulator
+ * type. Each pass distributes the slices to CPipelineItem::getNumberOfThreads()
+ * threads. Borders are zero padded.
+ * \param anImage a 2D image or 3D volume
+ * \param kernel filter kernel of the same dimension
+ * \param bAbsolute store the absolute values of the response
+ * \returns the filtered image
+ */
+template<typename TImageType> boost::shared_ptr<TImageType> CKernelFilter::convolveImage(
+  const TImageType& anImage, const CTypedData<double>& kernel, const bool bAbsolute ) throw()
 {
 BENCHSTART;
-  size_t usDims[3];
-  usDims[0] = dataPtr->getExtent(0);
-  usDims[1] = dataPtr->getExtent(1);
-  if ( dataPtr->getDimension() == 3 )
-    usDims[2] = dataPtr->getExtent(2);
+  typedef typename TImageType::TDataType T;
+  typedef typename SAccumulator<T>::TType A;
+  boost::shared_ptr<TImageType> outputPtr( new TImageType( anImage.getDimension(),
+    anImage.getExtents(), anImage.getDataDimension(), TImageType::DataInitNone ) );
+  outputPtr->setBaseElementDimensions( anImage.getBaseElementDimensions() );
+  outputPtr->setOrigin( anImage.getOrigin() );
+
+  SConvolution<T, A> theConvolution;
+  theConvolution.intermediatePtr = NULL;
+  theConvolution.bAbsolute = bAbsolute;
+  vector<A> intermediateVec;
+  vector<double> kernelVec( kernel.getArraySize() );
+  for( size_t i = 0; i < kernelVec.size(); ++i )
+    kernelVec[i] = kernel[i];
+  for( ushort d = 0; d < 3; ++d )
+  {
+    theConvolution.extentArr[d] = ( d < anImage.getDimension() ) ? anImage.getExtent( d ) : 1;
+    theConvolution.tapCountArr[d] = ( d < kernel.getDimension() ) ? kernel.getExtent( d ) : 1;
+    theConvolution.tapOffsetArr[d] = ( theConvolution.tapCountArr[d] - 1 ) / 2;
+  }
+  vector<double> factorVecArr[3];
+  const bool bSeparable = separateKernel( kernelVec, theConvolution.tapCountArr, factorVecArr );
+  if ( bSeparable )
+  {
+    for( ushort d = 0; d < 3; ++d )
+      theConvolution.tapVecArr[d].assign( factorVecArr[d].begin(), factorVecArr[d].end() );
+    if ( theConvolution.tapCountArr[2] > 1 )
+    {
+      intermediateVec.resize( anImage.getArraySize() / anImage.getDataDimension() );
+      theConvolution.intermediatePtr = &intermediateVec[0];
+    }
+  }
   else
-    usDims[2] = 1;
-  TImagePtr outputPtr ( new TImage( dataPtr->getDimension(), 
-		dataPtr->getExtents(), dataPtr->getDataDimension() ) );
-	outputPtr->setDataRange( dataPtr->getDataRange() );
-	(*outputPtr) = 0;
-  ushort usRadius[3] ={ ( kernel.getExtent(0) - 1 ) / 2,
-		( kernel.getExtent(1) - 1 ) / 2 }; // Filter kernel size
-	if ( kernel.getDimension() == 3 )
-		usRadius[2] = ( kernel.getExtent(2) - 1 ) / 2;
-	else
-		usRadius[2] = 0;
-	ulong lineSize = ( dataPtr->getExtent(0) );
-	ulong sliceSize = ( dataPtr->getExtent(0) *  dataPtr->getExtent(1) );
-	short x = 0;
-	short y = 0;
-	short z = 0;
-	ushort posVecSize = kernel.getExtent(0) * kernel.getExtent(1);
-	if ( dataPtr->getDimension() > 2 )
-		posVecSize *= kernel.getExtent(2);
-	vector<ptrdiff_t> kernelPositionsVec( posVecSize );	
-	long lKernelWidth = static_cast<long>( kernel.getExtent(0) );
-	long lKernelHeight = static_cast<long>( kernel.getExtent(1) );	
-	if ( usRadius[2] == 0 )
-	while( y < lKernelHeight )
-	{
-		kernelPositionsVec[ x + y * lKernelWidth
-			+ z * lKernelWidth * lKernelHeight ] = 
-			  x - usRadius[0] 
-			+ ( y - usRadius[1] ) * usDims[0] 
-			+	( z - usRadius[2] ) * usDims[0] * usDims[1];
-		++x;
-		if ( x == lKernelWidth )
-		{
-			x = 0; ++y;
-		}
-	}
-	else
-	{
-		long lKernelDepth = static_cast<long>( kernel.getExtent(2) );
-		while( z < lKernelDepth )
-		{
-			kernelPositionsVec[ x + y * lKernelWidth 
-				+ z * lKernelWidth * lKernelHeight ] = 
-				x - usRadius[0] 
-				+ ( y - usRadius[1] ) * usDims[0] 
-				+	( z - usRadius[2] ) * usDims[0] * usDims[1];
-			++x;
-			if ( x == lKernelWidth )
-			{
-				x = 0; ++y;
-			}
-			if ( y == lKernelHeight )
-			{
-				y = 0; ++z;
-			}
-		}
-	}
-	PROG_MAX( usDims[2] * dataPtr->getDataDimension() );
-  for ( ushort usChannels = 0; usChannels < dataPtr->getDataDimension(); ++usChannels )
+    theConvolution.kernelVec.assign( kernelVec.begin(), kernelVec.end() );
+DBG2( "Convolution with " << ( bSeparable ? "separable" : "full" ) << " kernel" );
+
+  const size_t channelSize = anImage.getArraySize() / anImage.getDataDimension();
+  const size_t sliceCount = theConvolution.extentArr[2];
+  PROG_MAX( anImage.getDataDimension() );
+  for( size_t usChannel = 0; usChannel < anImage.getDataDimension(); ++usChannel )
   {
-		x = usRadius[0]; y = usRadius[1]; z = usRadius[2];
-		TImage::iterator outputIt = outputPtr->begin() + usRadius[0] + usRadius[1] * lineSize
-			+ usRadius[2] * sliceSize;
-		TImage::iterator inputIt = dataPtr->begin()	+ usRadius[0] + usRadius[1] * lineSize
-			+ usRadius[2] * sliceSize;
-		while( z < static_cast<long>( usDims[2] - usRadius[2] ) )
-		{
-			vector<ptrdiff_t>::const_iterator it = kernelPositionsVec.begin();
-			for( CTypedData<double>::iterator kernelIt = kernel.begin(); 
-				kernelIt != kernel.end(); ++kernelIt, ++it )
-			{
-				(*outputIt) += static_cast<ushort>( 
-					static_cast<double>(*(inputIt+*it)) * (*kernelIt) );
-			}
-			++outputIt; ++inputIt; ++x;
-			if ( x == static_cast<long>( usDims[0] - usRadius[0] ) )
-			{
-				x = usRadius[0]; ++y; outputIt += 2 * usRadius[0]; inputIt += 2 * usRadius[0];
-			}
-			if ( y == static_cast<long>( usDims[1] - usRadius[1] ) )
-			{
-				y = usRadius[1]; ++z; 
-				outputIt += 2 * usRadius[1] * lineSize; inputIt += 2 * usRadius[1] * lineSize;
-PROG_VAL( z * ( usChannels + 1 ) );		
-APP_PROC();		
-			}	
-		}
-  }    
-PROG_RESET();
+    theConvolution.inputPtr = &anImage[usChannel * channelSize];
+    theConvolution.outputPtr = &( *outputPtr )[usChannel * channelSize];
+    if ( !bSeparable )
+      parallelFor( theConvolution, &SConvolution<T, A>::full, sliceCount );
+    else
+    {
+      parallelFor( theConvolution, &SConvolution<T, A>::separableXY, sliceCount );
+      if ( theConvolution.intermediatePtr != NULL )
+        parallelFor( theConvolution, &SConvolution<T, A>::separableZ, sliceCount );
+    }
+    PROG_VAL( usChannel + 1 );
+  }
+  PROG_RESET();
+
+  outputPtr->setDataRange( anImage.getDataRange() );
+  const TImageType& theOutput = *outputPtr;
+  for( size_t i = 0; i < theOutput.getArraySize(); ++i )
+    outputPtr->adjustDataRange( theOutput[i] );
 BENCHSTOP;
   return outputPtr;
 }
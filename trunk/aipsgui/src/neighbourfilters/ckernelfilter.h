@@ -5,7 +5,7 @@
  *                                                                      *
  * Author: Hendrik Belitz (h.belitz@fz-juelich.de)                      *
  *                                                                      *
- * Version: 0.4                                                         *
+ * Version: 0.5                                                         *
  * Status : Beta                                                        *
  * Created: 2003-11-13                                                  *
  * Changed: 2003-12-16 Filter adapted for multi-channel data            *
@@ -15,6 +15,11 @@
  *          2004-05-05 Updated code for standalone filtering. This code *
  *                     looks quite crazy, but is as fast as the blitz++ *
  *                     version                                          *
+ *          2026-10-17 New convolution engine: separable kernels are    *
+ *                     applied axis by axis, interior and border loops  *
+ *                     are separated, slices are processed by several   *
+ *                     threads. All types of imageTL are supported      *
+ *                     applyKernel() keeps storing absolute responses   *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -53,7 +58,7 @@ public:
   /// Constructor
   CKernelFilter( ulong ulID, const std::string &sName = "Generic filter kernel",
 		const ushort usNoOfInputs = 1, const ushort usNoOfOutputs = 1,
-		const std::string &sClassName_ = "CKernelFilter", const std::string &sClassVersion_ = "0.4", 
+		const std::string &sClassName_ = "CKernelFilter", const std::string &sClassVersion_ = "0.5", 
 		const std::string &sDerivedFrom_ = "CFilter" ) throw();
   /// Destructor
   virtual ~CKernelFilter()
@@ -71,5 +76,13 @@ protected:
   /// Applies a given filter kernel to a volume
   TImagePtr applyKernel ( TImagePtr dataPtr, CTypedData<double>& kernel )
     throw();
+  /// Applies a given filter kernel to an image or volume of any type of imageTL
+  TDataSetPtr convolve( TDataSetPtr dataPtr, const CTypedData<double>& kernel,
+    const bool bAbsolute = false )
+    throw();
+private:
+  /// Applies a given filter kernel to an image or volume
+  template<typename TImageType> boost::shared_ptr<TImageType> convolveImage(
+    const TImageType& anImage, const CTypedData<double>& kernel, const bool bAbsolute ) throw();
 };
 #endif
@@ -67,7 +67,8 @@ BENCHSTART;
   dimensionSize[2] = ( inputPtr->getDimension() == 3 ) ? inputPtr->getExtent(2) : 1;
   
   TImagePtr outputPtr ( new TImage( inputPtr->getDimension(),
-    inputPtr->getExtents(), inputPtr->getDataDimension() ) );
+    inputPtr->getExtents(), inputPtr->getDataDimension(),
+    TImage::DataInitNone ) );
   (*outputPtr) = (*inputPtr);
   outputPtr->setDataRange( inputPtr->getDataRange() );
 
@@ -45,9 +45,9 @@ CLowPassFilter::~CLowPassFilter() throw()
 /** Reimplemented from CPipelineItem */
 void CLowPassFilter::apply() throw()
 {
-  ushort usRadius = 1 + 2 * parameters.getUnsignedLong("Radius"); // Determine filter radius
+  size_t kernelSize = 1 + 2 * parameters.getUnsignedLong("Radius"); // Determine filter size
 	bModuleReady = false;
-  TImagePtr inputPtr = static_pointer_cast<TImage>( getInput() );
+  TDataSetPtr inputPtr = getInput();
   if ( inputPtr.get() == NULL || inputPtr->getDimension() < 2 || inputPtr->getDimension() > 3 )
   {
     alog << LWARN << SERROR("Input type is no 2D image or 3D volume!") << endl;
@@ -55,29 +55,14 @@ void CLowPassFilter::apply() throw()
   }
 	bModuleReady = true;
   deleteOldOutput();
-	TImagePtr outputPtr; outputPtr.reset();
-#ifdef USE_BLITZ
-  if ( getInput()->getDimension() == 2 ) // Got 2D image
-  {
-    Array<double, 2> kernel( usRadius, usRadius );
-    kernel = 1.0 / ( usRadius * usRadius );
-    outputPtr = applyKernel( inputPtr, kernel );
-  }
-  else if ( getInput()->getDimension() == 3 )
-  {
-    Array<double, 3> kernel( usRadius, usRadius, usRadius );
-    kernel = 1.0 / ( usRadius * usRadius * usRadius );
-    outputPtr = applyKernel( inputPtr, kernel );
-  }
-#else /* USE_STANDALONE */
-  size_t dims[] = { usRadius, usRadius, usRadius };
+  // The uniform kernel is separable, so it is applied axis by axis
+  size_t dims[] = { kernelSize, kernelSize, kernelSize };
   CTypedData<double> kernel( inputPtr->getDimension(), dims );
   if ( inputPtr->getDimension() == 2 )
-    kernel = 1.0 / ( usRadius * usRadius );
+    kernel = 1.0 / ( kernelSize * kernelSize );
   else
-    kernel = 1.0 / ( usRadius * usRadius * usRadius );
-  outputPtr = applyKernel( inputPtr, kernel );
-#endif /* USE_STANDALONE */
+    kernel = 1.0 / ( kernelSize * kernelSize * kernelSize );
+  TDataSetPtr outputPtr = convolve( inputPtr, kernel );
   if ( outputPtr == NULL )
   {
     alog << LWARN << SERROR("invalid input data") << endl;
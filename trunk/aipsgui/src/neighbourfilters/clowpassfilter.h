@@ -15,6 +15,8 @@
  *          2003-11-10 Filter now uses CKernelFilter and works also on *
  *                      volume data                                    *
  *          2004-01-29 Clarified and documented source code            *
+ *          2026-10-17 Uses the separable convolution engine and       *
+ *                      accepts all types of imageTL                   *
  ***********************************************************************/
 
 #ifndef CLOWPASSFILTER_H
@@ -10,9 +10,239 @@
 
 #include "cmedianfilter.h"
 
+// Standard includes
+#include <limits>
+#include <vector>
+
+// AIPS includes
+#include <aipsparallel.h>
+
 using namespace std;
 using namespace boost;
 
+namespace
+{
+
+/// Number of histogram bins summarised by one coarse bin
+const size_t coarseShift = 5;
+
+/**
+ * Histogram of the filter window for integer data. The median is tracked
+ * incrementally: lessCount is the number of window values below the bin
+ * median. After values were added or removed, update() moves the median bin
+ * towards the new median. Empty stretches of the histogram are skipped with
+ * the help of a coarse histogram, so the median moves cheaply even on data
+ * with a wide value range.
+ */
+struct SHistogram
+{
+	vector<unsigned int> fineVec;   ///< Count of each value
+	vector<unsigned int> coarseVec; ///< Count of each block of 2^coarseShift values
+	size_t median;                  ///< Bin of the actual median
+	size_t lessCount;               ///< Number of values in the bins below median
+	size_t rank;                    ///< Rank of the median in the window (window size / 2)
+	SHistogram( const size_t binCount, const size_t rank_ )
+		: fineVec( ( ( binCount >> coarseShift ) + 1 ) << coarseShift ),
+		coarseVec( ( binCount >> coarseShift ) + 1 ), median( 0 ), lessCount( 0 ), rank( rank_ )
+	{
+	}
+	void clear()
+	{
+		std::fill( fineVec.begin(), fineVec.end(), 0 );
+		std::fill( coarseVec.begin(), coarseVec.end(), 0 );
+		median = lessCount = 0;
+	}
+	inline void add( const size_t bin )
+	{
+		++fineVec[bin];
+		++coarseVec[bin >> coarseShift];
+		if ( bin < median )
+			++lessCount;
+	}
+	inline void remove( const size_t bin )
+	{
+		--fineVec[bin];
+		--coarseVec[bin >> coarseShift];
+		if ( bin < median )
+			--lessCount;
+	}
+	/// Moves median to the bin holding the value of the given rank
+	inline void update()
+	{
+		const size_t blockSize = 1 << coarseShift;
+		while ( lessCount > rank )
+		{
+			size_t block = median >> coarseShift;
+			if ( ( median & ( blockSize - 1 ) ) == 0 && lessCount - coarseVec[block - 1] > rank )
+			{
+				lessCount -= coarseVec[block - 1];
+				median -= blockSize;
+			}
+			else
+			{
+				--median;
+				lessCount -= fineVec[median];
+			}
+		}
+		while ( lessCount + fineVec[median] <= rank )
+		{
+			size_t block = median >> coarseShift;
+			if ( ( median & ( blockSize - 1 ) ) == 0 && lessCount + coarseVec[block] <= rank )
+			{
+				lessCount += coarseVec[block];
+				median += blockSize;
+			}
+			else
+			{
+				lessCount += fineVec[median];
+				++median;
+			}
+		}
+	}
+};
+
+/**
+ * Geometry and data of one channel, shared by all workers. Only voxels whose
+ * window lies completely inside the image are filtered. A worker processes a
+ * range of slices of a volume or a range of rows of an image.
+ */
+template<typename T> struct SMedian
+{
+	const T* inputPtr;    ///< Input channel
+	T* outputPtr;         ///< Output channel
+	size_t extentArr[3];  ///< Channel extents (1 for missing dimensions)
+	size_t radiusArr[3];  ///< Window radius along each axis (0 for missing dimensions)
+	T minimum;            ///< Smallest value of the channel (histogram bin 0)
+	size_t binCount;      ///< Number of histogram bins
+
+	/// Number of work items: slices of volumes, rows of images
+	size_t itemCount() const
+	{
+		const size_t axis = ( extentArr[2] > 1 ) ? 2 : 1;
+		return extentArr[axis] - 2 * radiusArr[axis];
+	}
+	/// Window size
+	size_t windowSize() const
+	{
+		return ( 2 * radiusArr[0] + 1 ) * ( 2 * radiusArr[1] + 1 ) * ( 2 * radiusArr[2] + 1 );
+	}
+	/**
+	 * Converts an item into a slice and a row range. Images consist of a single
+	 * item covering the rows [item, lastItem).
+	 */
+	void itemRange( const size_t item, const size_t lastItem, size_t& z, size_t& yBegin, size_t& yEnd ) const
+	{
+		if ( extentArr[2] > 1 )
+		{
+			z = radiusArr[2] + item;
+			yBegin = radiusArr[1];
+			yEnd = extentArr[1] - radiusArr[1];
+		}
+		else
+		{
+			z = 0;
+			yBegin = radiusArr[1] + item;
+			yEnd = radiusArr[1] + lastItem;
+		}
+	}
+	/// Adds (iSign = 1) or removes (iSign = -1) the window box [x0,x1]x[y0,y1]x[z0,z1]
+	inline void changeBox( SHistogram& theHistogram, const int iSign, const size_t x0, const size_t x1,
+		const size_t y0, const size_t y1, const size_t z0, const size_t z1 ) const
+	{
+		for( size_t z = z0; z <= z1; ++z )
+			for( size_t y = y0; y <= y1; ++y )
+			{
+				const T* linePtr = inputPtr + ( z * extentArr[1] + y ) * extentArr[0];
+				for( size_t x = x0; x <= x1; ++x )
+				{
+					if ( iSign > 0 )
+						theHistogram.add( static_cast<size_t>( linePtr[x] - minimum ) );
+					else
+						theHistogram.remove( static_cast<size_t>( linePtr[x] - minimum ) );
+				}
+			}
+	}
+	/**
+	 * Huang's sliding histogram, extended to 3D. The window snakes through the
+	 * rows of a slice, so each step only exchanges one plane of the window.
+	 */
+	void histogramRange( const size_t firstItem, const size_t lastItem ) const
+	{
+		const size_t rx = radiusArr[0], ry = radiusArr[1], rz = radiusArr[2];
+		const size_t xBegin = rx, xEnd = extentArr[0] - rx;
+		SHistogram theHistogram( binCount, windowSize() / 2 );
+		size_t z, yBegin, yEnd;
+		for( size_t item = firstItem; item < lastItem; ++item )
+		{
+			itemRange( item, lastItem, z, yBegin, yEnd );
+			theHistogram.clear();
+			changeBox( theHistogram, 1, 0, 2 * rx, yBegin - ry, yBegin + ry, z - rz, z + rz );
+			size_t x = xBegin;
+			for( size_t y = yBegin; y < yEnd; ++y )
+			{
+				const bool bForward = ( ( y - yBegin ) % 2 == 0 );
+				T* lineOutputPtr = outputPtr + ( z * extentArr[1] + y ) * extentArr[0];
+				while( true )
+				{
+					theHistogram.update();
+					lineOutputPtr[x] = static_cast<T>( minimum + static_cast<T>( theHistogram.median ) );
+					if ( bForward && x + 1 < xEnd )
+					{
+						changeBox( theHistogram, -1, x - rx, x - rx, y - ry, y + ry, z - rz, z + rz );
+						changeBox( theHistogram, 1, x + rx + 1, x + rx + 1, y - ry, y + ry, z - rz, z + rz );
+						++x;
+					}
+					else if ( !bForward && x > xBegin )
+					{
+						changeBox( theHistogram, -1, x + rx, x + rx, y - ry, y + ry, z - rz, z + rz );
+						changeBox( theHistogram, 1, x - rx - 1, x - rx - 1, y - ry, y + ry, z - rz, z + rz );
+						--x;
+					}
+					else
+						break;
+				}
+				if ( y + 1 < yEnd )
+				{
+					changeBox( theHistogram, -1, x - rx, x + rx, y - ry, y - ry, z - rz, z + rz );
+					changeBox( theHistogram, 1, x - rx, x + rx, y + ry + 1, y + ry + 1, z - rz, z + rz );
+				}
+			}
+			// Images consist of a single item range
+			if ( extentArr[2] == 1 )
+				break;
+		}
+	}
+	/// Copies each window and selects its median. Used for floating point data
+	void selectionRange( const size_t firstItem, const size_t lastItem ) const
+	{
+		const size_t rx = radiusArr[0], ry = radiusArr[1], rz = radiusArr[2];
+		vector<T> windowVec( windowSize() );
+		const size_t rank = windowVec.size() / 2;
+		size_t z, yBegin, yEnd;
+		for( size_t item = firstItem; item < lastItem; ++item )
+		{
+			itemRange( item, lastItem, z, yBegin, yEnd );
+			for( size_t y = yBegin; y < yEnd; ++y )
+				for( size_t x = rx; x < extentArr[0] - rx; ++x )
+				{
+					typename vector<T>::iterator it = windowVec.begin();
+					for( size_t m = z - rz; m <= z + rz; ++m )
+						for( size_t l = y - ry; l <= y + ry; ++l )
+						{
+							const T* linePtr = inputPtr + ( m * extentArr[1] + l ) * extentArr[0];
+							it = std::copy( linePtr + x - rx, linePtr + x + rx + 1, it );
+						}
+					std::nth_element( windowVec.begin(), windowVec.begin() + rank, windowVec.end() );
+					outputPtr[( z * extentArr[1] + y ) * extentArr[0] + x] = windowVec[rank];
+				}
+			if ( extentArr[2] == 1 )
+				break;
+		}
+	}
+};
+
+}
+
 /*************
  * Structors *
  *************/
@@ -21,7 +251,7 @@ using namespace boost;
  * \param ulID unique module ID
  */
 CMedianFilter::CMedianFilter( ulong ulID ) throw()
-  : CFilter ( ulID, "Median filter", 1, 1, "CMedianFilter", "0.4", "CFilter" )
+  : CFilter ( ulID, "Median filter", 1, 1, "CMedianFilter", "0.5", "CFilter" )
 {
   setModuleID( sLibID );
 
@@ -43,83 +273,84 @@ CMedianFilter::~CMedianFilter() throw()
 /*****************
  * Other methods *
  *****************/
- 
+
 void CMedianFilter::apply() throw()
 {
-BENCHSTART;
 	bModuleReady = false;
-  TImagePtr inputPtr = static_pointer_cast<TImage>( getInput() );
+  TDataSetPtr inputPtr = getInput();
   if ( inputPtr.get() == NULL || inputPtr->getDimension() < 2 || inputPtr->getDimension() > 3 )
+  {
+    alog << LWARN << "Input type is no 2D or 3D image!" << endl;
+    return;
+  }
+  const size_t radius = parameters.getUnsignedLong("Radius");
+  TDataSetPtr outputPtr;
+  if ( checkType<TImage>( *inputPtr ) )
+    outputPtr = filterImage( static_cast<const TImage&>( *inputPtr ), radius );
+  else if ( checkType<TField>( *inputPtr ) )
+    outputPtr = filterImage( static_cast<const TField&>( *inputPtr ), radius );
+  else if ( checkType<TSmallImage>( *inputPtr ) )
+    outputPtr = filterImage( static_cast<const TSmallImage&>( *inputPtr ), radius );
+  else
   {
     alog << LWARN << "Input type is no 2D or 3D image!" << endl;
     return;
   }
 	bModuleReady = true;
   deleteOldOutput();
+  setOutput( outputPtr );
+}
 
-  size_t dimensionSize[3];
-  dimensionSize[0] = inputPtr->getExtent(0);
-  dimensionSize[1] = inputPtr->getExtent(1);
-  dimensionSize[2] = ( inputPtr->getDimension() == 3 ) ? inputPtr->getExtent(2) : 1;
-  
-  TImagePtr outputPtr ( new TImage( inputPtr->getDimension(),
-    inputPtr->getExtents(), inputPtr->getDataDimension() ) );
-  (*outputPtr) = (*inputPtr);
-
-  uint uiMaskSize = static_cast<uint>( ( 2 * parameters.getUnsignedLong("Radius") ) + 1 );  
-  vector<ushort> usMask( uiMaskSize * uiMaskSize * uiMaskSize );
-
-  ulong ulRadius =  parameters.getUnsignedLong("Radius");
-  PROG_MAX( inputPtr->getDataDimension() * dimensionSize[2] );
-  for ( ushort usChannel = 0; usChannel < inputPtr->getDataDimension(); ++usChannel )
-  if ( inputPtr->getDimension() == 3 )
-  {	
-    for ( ushort z = ulRadius; z < ( dimensionSize[2] - ulRadius ); ++z )
+/**
+ * Integer images use a sliding histogram whose cost per voxel grows with r^2
+ * instead of r^3 log r. Floating point images copy each window and select the
+ * median in linear time. Voxels closer than radius to the border keep their
+ * input values. Each channel distributes its slices (rows for 2D images) to
+ * CPipelineItem::getNumberOfThreads() threads.
+ * \param anImage a 2D image or 3D volume
+ * \param radius radius of the cubic filter window
+ * \returns the filtered image
+ */
+template<typename TImageType> boost::shared_ptr<TImageType> CMedianFilter::filterImage(
+  const TImageType& anImage, const size_t radius ) throw()
+{
+BENCHSTART;
+  typedef typename TImageType::TDataType T;
+  boost::shared_ptr<TImageType> outputPtr( new TImageType( anImage ) );
+
+  SMedian<T> theMedian;
+  for( ushort d = 0; d < 3; ++d )
+  {
+    theMedian.extentArr[d] = ( d < anImage.getDimension() ) ? anImage.getExtent( d ) : 1;
+    theMedian.radiusArr[d] = ( d < anImage.getDimension() ) ? radius : 0;
+    if ( theMedian.extentArr[d] < 2 * theMedian.radiusArr[d] + 1 )
     {
-      APP_PROC();
-			PROG_VAL( z * ( usChannel + 1 ) );
-      for ( ushort y = ulRadius; y < ( dimensionSize[1] - ulRadius ); ++y )
-        for ( ushort x = ulRadius; x < ( dimensionSize[0] - ulRadius ); ++x )
-        {
-          ushort usMaxIndex = 0;
-          for ( ushort k =  x - ulRadius; k < ( x + ulRadius + 1 ); ++k )
-            for ( ushort l =  y - ulRadius; l < ( y + ulRadius + 1 ); ++l )
-              for ( ushort m =  z - ulRadius; m < ( z + ulRadius + 1 ); ++m )
-              {
-                usMask[usMaxIndex] = (*inputPtr)( k, l, m, usChannel );
-                usMaxIndex++;
-              }
-          vector<ushort>::iterator it = usMask.begin() + usMaxIndex + 1;
-          sort( usMask.begin(), it );
-          (*outputPtr)( x, y, z, usChannel ) = usMask[usMaxIndex / 2 + 1];
-        }
+      alog << LWARN << "Filter window is larger than the image" << endl;
+      return outputPtr;
     }
   }
-  else
+
+  const size_t channelSize = anImage.getArraySize() / anImage.getDataDimension();
+  PROG_MAX( anImage.getDataDimension() );
+  for( size_t usChannel = 0; usChannel < anImage.getDataDimension(); ++usChannel )
   {
-    for ( ushort usChannel = 0; usChannel < inputPtr->getDataDimension(); ++usChannel )
+    theMedian.inputPtr = &anImage[usChannel * channelSize];
+    theMedian.outputPtr = &( *outputPtr )[usChannel * channelSize];
+    if ( numeric_limits<T>::is_integer )
     {
-      APP_PROC();
-			PROG_VAL( usChannel + 1 );
-      for ( ushort y = ulRadius; y < ( dimensionSize[1] - ulRadius ); ++y )
-        for ( ushort x = ulRadius; x < ( dimensionSize[0] - ulRadius ); ++x )
-          {
-            ushort usMaxIndex = 0;
-            for ( ushort k =  x - ulRadius; k < ( x + ulRadius + 1 ); ++k )
-              for ( ushort l =  y - ulRadius; l < ( y + ulRadius + 1 ); ++l )
-                {
-                  usMask[usMaxIndex] = (*inputPtr)( k, l, usChannel );
-                  usMaxIndex++;
-                }                    
-            vector<ushort>::iterator it = usMask.begin() + usMaxIndex + 1;
-            sort( usMask.begin(), it );
-            (*outputPtr)( x, y, usChannel ) = usMask[usMaxIndex / 2 + 1];
-          }
+      const T* beginPtr = theMedian.inputPtr;
+      theMedian.minimum = *std::min_element( beginPtr, beginPtr + channelSize );
+      theMedian.binCount = static_cast<size_t>( *std::max_element( beginPtr, beginPtr + channelSize )
+        - theMedian.minimum ) + 1;
+      parallelFor( theMedian, &SMedian<T>::histogramRange, theMedian.itemCount() );
     }
+    else
+      parallelFor( theMedian, &SMedian<T>::selectionRange, theMedian.itemCount() );
+    PROG_VAL( usChannel + 1 );
   }
-	PROG_RESET();
-  setOutput( outputPtr );
+  PROG_RESET();
 BENCHSTOP;
+  return outputPtr;
 }
 
 CPipelineItem* CMedianFilter::newInstance( ulong ulID ) const throw()
@@ -5,7 +5,7 @@
  *                                                                     *
  * Author: Hendrik Belitz                                              *
  *                                                                     *
- * Version: 0.4                                                        *
+ * Version: 0.5                                                        *
  * Status : Beta                                                       *
  * Created: 2003-08-26                                                 *
  * Changed: 2003-09-02 Corrected allocation error                      *
@@ -19,6 +19,10 @@
  *                      pivoting                                       *
  *          2004-02-03 Removed a bug on 3D images                      *
  *          2004-05-06 Added progress bar and event handler            *
+ *          2026-10-17 Sliding histogram median for integer images,    *
+ *                     selection median for floating point images,     *
+ *                     slices are processed by several threads. All    *
+ *                     types of imageTL are supported                  *
  ***********************************************************************/
 
 #ifndef CMEDIANFILTER_H
@@ -62,6 +66,10 @@ public:
   /// Reimplemented from CPipelineItem  
   virtual void apply()
     throw();
+private:
+  /// Filters an image or volume
+  template<typename TImageType> boost::shared_ptr<TImageType> filterImage(
+    const TImageType& anImage, const size_t radius ) throw();
 };
 
 #endif
@@ -23,7 +23,7 @@ using namespace boost;
  *************/
  
 CMorphology::CMorphology( ulong ulID ) throw()
-: CFilter ( ulID, "Simple morphology operator", 2, 1, "CMorphology", "0.1", "CFilter" )
+: CFilter ( ulID, "Simple morphology operator", 2, 1, "CMorphology", "0.3", "CFilter" )
 {
   setModuleID( sLibID );
   sDocumentation = "A simple morphological operator\n"
@@ -32,15 +32,24 @@ CMorphology::CMorphology( ulong ulID ) throw()
                    "** Output ports:\n"
                    "1: A singlechannel image\n"
                    "** Parameters:\n"
-                   "Type: 0 : Dilation, 1 : Erosion\n"
-									 "Iterations: Number of filter steps\n"
-									 "Kernel height: Strength of structural element\n"
-									 "Only Background: Work only on voxels with background neighbourhood\n";
+                   "Operation: 0 : Iterated 3x3(x3) steps selected by Type, 1 : Erosion, "
+                   "2 : Dilation, 3 : Opening, 4 : Closing\n"
+                   "Type: 0 : Erosion, 1 : Dilation (Operation 0 only)\n"
+									 "Iterations: Number of filter steps (Operation 0 only)\n"
+									 "Kernel height: Strength of structural element (Operation 0 only)\n"
+									 "Only Background: Work only on voxels with background neighbourhood "
+									 "(Operation 0 only)\n"
+                   "Radius X, Radius Y, Radius Z: Half size of the flat box (Operations 1-4). "
+                   "A single radius greater than 0 gives a line element\n";
 
   parameters.initBool( "Type", false );
   parameters.initUnsignedLong( "Iterations", 1UL, 1UL, 1000UL );
   parameters.initUnsignedLong( "Kernel height", 1UL, 1UL, 255UL );
 	parameters.initBool( "Only background", false );
+  parameters.initUnsignedLong( "Operation", 0UL, 0UL, 4UL );
+  parameters.initUnsignedLong( "Radius X", 1UL, 0UL, 1000UL );
+  parameters.initUnsignedLong( "Radius Y", 1UL, 0UL, 1000UL );
+  parameters.initUnsignedLong( "Radius Z", 1UL, 0UL, 1000UL );
 
   inputsVec[0].portType = CPipelineItem::IOInteger;
 	inputsVec[1].portType = CPipelineItem::IOInteger;
@@ -65,6 +74,17 @@ BENCHSTART;
     alog << LWARN << SERROR("Input type is no image!") << endl;
     return;
   }
+	if ( inputPtr->getDimension() > 3 )
+  {
+    alog << LWARN << SERROR("Input type is no 2D or 3D image!") << endl;
+    return;
+  }
+	if ( parameters.getUnsignedLong( "Operation" ) > 0 )
+	{
+		morphFlat( *inputPtr );
+BENCHSTOP;
+		return;
+	}
 
   size_t kernelSize[] = { 3, 3, 3 };
   TImage kernel( inputPtr->getDimension(), kernelSize );
@@ -199,91 +219,130 @@ void CMorphology::morph3D( const TImage& input, const TImage& kernel ) throw()
 	bModuleReady = true;
   deleteOldOutput();
 
-	TImagePtr outputPtr ( new TImage( input.getDimension(), input.getExtents(), 1 ) );
-  TImage work( input );
+	TImagePtr outputPtr ( new TImage( input.getDimension(), input.getExtents(),
+		input.getDataDimension() ) );
+	outputPtr->setDataRange( input.getDataRange() );
+	// Work on bricked copies, so each 3x3x3 neighbourhood is read from at most eight bricks
+	CBrickedData<TImage::TDataType> work( input );
+	CBrickedData<TImage::TDataType> result( work );
 	
 	TImagePtr roiPtr = static_pointer_cast<TImage>( getInput( 1 ) );
-	TImage valid ( input );
 	bool roiSelf = false;
 	if ( roiPtr == NULL )
 		roiSelf = true;
   
 	bool bSearchFor = parameters.getBool( "Type" );
 	ulong ulMaxIterations = parameters.getUnsignedLong( "Iterations" );	
-	PROG_MAX( input.getExtent( 2 ) * ulMaxIterations );
 	bool bOnlyBG = parameters.getBool( "Only background" );
-  for ( ushort usIterations = 0; usIterations < ulMaxIterations;	++usIterations )
+
+	// Kernel in the order of CBrickedData::getNeighbourhood()
+	long kernelArr[27];
+	for ( short u = -1; u < 2; ++u )
+		for ( short t = -1; t < 2; ++t )
+			for ( short s = -1; s < 2; ++s )
+				kernelArr[( u + 1 ) * 9 + ( t + 1 ) * 3 + s + 1] = kernel( s + 1, t + 1, u + 1 );
+	const size_t bricksPerLayer = work.getBrickCount( 0 ) * work.getBrickCount( 1 );
+	PROG_MAX( work.getBrickCount( 2 ) * ulMaxIterations );
+	TImage::TDataType neighbourArr[27];
+  for ( ulong ulIterations = 0; ulIterations < ulMaxIterations; ++ulIterations )
   {	
-		if( bOnlyBG )
+		result = work;
+		size_t lastLayer = bricksPerLayer;
+		CBrickedData<TImage::TDataType>::iterator resultIt = result.begin();
+		for ( CBrickedData<TImage::TDataType>::iterator it = work.begin();
+			it != work.end() && it.getChannel() == 0; ++it, ++resultIt )
 		{
-			for ( ushort z = 1; z < work.getExtent( 2 )-1; ++z )
-				for ( ushort y = 1; y < work.getExtent( 1 )-1; ++y )
-   	    	for ( ushort x = 1; x < work.getExtent( 0 )-1; ++x )
-					{
-						ushort usNeighbors = 0;
-						if ( work(x-1,y,z) == 0 ) usNeighbors++;
-						if ( work(x+1,y,z) == 0 ) usNeighbors++;
-						if ( work(x,y-1,z) == 0 ) usNeighbors++;
-						if ( work(x,y+1,z) == 0 ) usNeighbors++;
-						if ( work(x,y,z-1) == 0 ) usNeighbors++;
-						if ( work(x,y,z+1) == 0 ) usNeighbors++;
-						if ( usNeighbors > 0 )
-							valid(x,y,z) = 1;
-						else
-							valid(x,y,z) = 0;
-					}			
+			if ( it.getBrick() / bricksPerLayer != lastLayer )
+			{
+				lastLayer = it.getBrick() / bricksPerLayer;
+				PROG_VAL( ulIterations * work.getBrickCount( 2 ) + lastLayer + 1 );
+				APP_PROC();
+			}
+			size_t x, y, z;
+			it.getPos( x, y, z );
+			if ( x == 0 || y == 0 || z == 0 || x + 1 == work.getExtent( 0 )
+				|| y + 1 == work.getExtent( 1 ) || z + 1 == work.getExtent( 2 ) )
+				continue;
+			if ( !roiSelf && (*roiPtr)( x, y, z ) <= 0 )
+				continue;
+			it.getNeighbourhood( neighbourArr );
+			// Only background: at least one of the six direct neighbours has to be zero
+			if ( bOnlyBG && neighbourArr[4] != 0 && neighbourArr[10] != 0 && neighbourArr[12] != 0
+				&& neighbourArr[14] != 0 && neighbourArr[16] != 0 && neighbourArr[22] != 0 )
+				continue;
+			for ( ushort k = 0; k < 27; ++k )
+			{
+				long lValue;
+				if ( bSearchFor )
+				{
+					// The structural element is mirrored at the center
+					lValue = neighbourArr[26 - k] + kernelArr[k];
+					if ( lValue > 65535 ) lValue = 65535;
+				}
+				else
+				{
+					lValue = neighbourArr[k] - kernelArr[k];
+					if ( lValue < 0 ) lValue = 0;
+					else if ( lValue > 65535 ) lValue = 65535;
+				}
+				outputPtr->adjustDataRange( lValue );
+				if ( lValue > (*resultIt) )
+					(*resultIt) = static_cast<ushort>( lValue );
+			}
 		}
-			
-    (*outputPtr) = work;    
-    for ( ushort z = 1; z < input.getExtent( 2 )-1; ++z )
+    work = result;
+  }
+	result.toLinear( *outputPtr );
+  setOutput( outputPtr );
+	PROG_RESET();
+}
+
+/**
+ * Voxels outside the region of interest keep their input values.
+ * \param input image to filter
+ */
+void CMorphology::morphFlat( const TImage& input ) throw()
+{
+	bModuleReady = true;
+  deleteOldOutput();
+
+	const ulong ulOperation = parameters.getUnsignedLong( "Operation" );
+	vector<size_t> radiusVec( 3 );
+	radiusVec[0] = parameters.getUnsignedLong( "Radius X" );
+	radiusVec[1] = parameters.getUnsignedLong( "Radius Y" );
+	radiusVec[2] = parameters.getUnsignedLong( "Radius Z" );
+	CFlatMorphology<TImage::TDataType> morphology( radiusVec );
+	size_t extentArr[] = { 1, 1, 1 };
+	for ( ushort i = 0; i < input.getDimension(); ++i )
+		extentArr[i] = input.getExtent( i );
+	const size_t channelSize = extentArr[0] * extentArr[1] * extentArr[2];
+
+	TImagePtr outputPtr ( new TImage( input ) );
+	TImagePtr roiPtr = static_pointer_cast<TImage>( getInput( 1 ) );
+	PROG_MAX( input.getDataDimension() );
+	for ( ushort usChannel = 0; usChannel < input.getDataDimension(); ++usChannel )
+	{
+		TImage::TDataType* dataPtr = outputPtr->getArray( usChannel );
+		// Opening erodes first, closing dilates first
+		if ( ulOperation == 1 || ulOperation == 3 )
+			morphology.erode( dataPtr, extentArr );
+		else
+			morphology.dilate( dataPtr, extentArr );
+		if ( ulOperation == 3 )
+			morphology.dilate( dataPtr, extentArr );
+		else if ( ulOperation == 4 )
+			morphology.erode( dataPtr, extentArr );
+		if ( roiPtr.get() != NULL )
 		{
-			PROG_VAL( ( usIterations + 1 ) * z );
-			APP_PROC();
-      for ( ushort y = 1; y < work.getExtent( 1 )-1; ++y )
-        for ( ushort x = 1; x < work.getExtent( 0 )-1; ++x )
-        {
-					if ( ( !bOnlyBG || valid(x,y,z) ) && ( roiSelf || (*roiPtr)(x,y,z)>0 ) )
-					{
-	          if ( bSearchFor )
-  	        {
-							for ( short u = -1; u < 2; ++u )
-  	  	      for ( short t = -1; t < 2; ++t )
-  	  	      for ( short s = -1; s < 2; ++s )
-        	      if ( static_cast<short>(x) - s >= 0
-          	      && static_cast<short>(y) - t >= 0
-            	    && static_cast<short>(x) - s < static_cast<short>(work.getExtent(0))
-              	  && static_cast<short>(y) - t < static_cast<short>(work.getExtent(1)) )
-                	{
-	                  long lValue = work( x - s, y - t, z - u ) + kernel( s + 1, t + 1, u + 1 );
-										if ( lValue > 65535 ) lValue = 65535;
-										outputPtr->adjustDataRange( lValue );
-      	            if ( lValue > (*outputPtr)( x, y, z ) )
-        		           (*outputPtr)( x, y, z ) = static_cast<ushort>( lValue );
-            	    }
-          	}
-	          else 
-  	        {
-							for ( short u = -1; u < 2; ++u )
-    	      	for ( short t = -1; t < 2; ++t )
-      	      for ( short s = -1; s < 2; ++s )
-        	      if ( static_cast<short>(x) + s >= 0
-          	      && static_cast<short>(y) + t >= 0
-            	    && static_cast<short>(x) + s < static_cast<short>(work.getExtent(0))
-              	  && static_cast<short>(y) + t < static_cast<short>(work.getExtent(1)) )
-                	{
-                  	long lValue = work( x + s, y + t, z + u ) - kernel( s + 1, t + 1, u + 1 );
-										if ( lValue < 0 ) lValue = 0;
-										else if ( lValue > 65535 ) lValue = 65535;
-										outputPtr->adjustDataRange( lValue );
-      	            if ( lValue > (*outputPtr)( x, y, z ) )
-        		           (*outputPtr)( x, y, z ) = static_cast<ushort>( lValue );
-      	          }
-        	  }
-					}
-        }
+			const TImage::TDataType* inputPtr = &input[usChannel * channelSize];
+			const TImage::TDataType* roiArr = &( *roiPtr )[0];
+			for ( size_t i = 0; i < channelSize; ++i )
+				if ( roiArr[i] <= 0 )
+					dataPtr[i] = inputPtr[i];
 		}
-    work = (*outputPtr);
-  }
+		PROG_VAL( usChannel + 1 );
+		APP_PROC();
+	}
   setOutput( outputPtr );
 	PROG_RESET();
 }
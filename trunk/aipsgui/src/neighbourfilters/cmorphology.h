@@ -5,12 +5,14 @@
  *                                                                      *
  * Author: Hendrik Belitz (h.belitz@fz-juelich.de)                      *
  *                                                                      *
- * Version: 0.2                                                         *
+ * Version: 0.3                                                         *
  * Status : Beta                                                        *
  * Created: 2004-02-11                                                  *
  * Changed: 2004-05-06 Demangled and documented source code             *
  *          2004-07-09 Added parameter to filter only pixels with       *
  *                      background neighbourhood                        *
+ *          2026-10-17 morph3D() works on a bricked copy of the volume  *
+ *          2026-10-17 Added flat box operations of any radius          *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -23,6 +25,8 @@
 
 #include <cfilter.h>
 #include <aipsnumeric.h>
+#include <cbrickeddata.h>
+#include <cflatmorphology.h>
 #include <cglobalprogress.h>
 
 #include "libid.h"
@@ -30,7 +34,11 @@
 using namespace aips;
  
 /**
- * A class for simple morphological operations
+ * A class for simple morphological operations.
+ *
+ * Operation 0 iterates the classic 3x3(x3) grey value step. All other
+ * operations use a flat box with the given radii, computed by
+ * CFlatMorphology in a time independent of the radius.
  */
 class CMorphology : public CFilter
 {
@@ -62,6 +70,9 @@ private:
 	/// Actual implementation for 3D
 	void morph3D( const TImage& input, const TImage& kernel ) 
 		throw();
+	/// Erosion, dilation, opening or closing with a flat box
+	void morphFlat( const TImage& input )
+		throw();
 };
 
 #endif
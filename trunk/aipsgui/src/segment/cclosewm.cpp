@@ -70,7 +70,7 @@ BENCHSTART;
   dimensionSize[0] = inputPtr->getExtent(0);
   dimensionSize[1] = inputPtr->getExtent(1);
   
-  TImagePtr outputPtr ( new TImage( 2, inputPtr->getExtents() ) );
+  TImagePtr outputPtr ( new TImage( 2, inputPtr->getExtents(), 1, TImage::DataInitNone ) );
 	
   (*outputPtr) = (*inputPtr);
 
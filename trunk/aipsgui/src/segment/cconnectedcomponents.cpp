@@ -0,0 +1,418 @@
+/***************************************************************************
+ *   Copyright (C) 2004 by Hendrik Belitz                                  *
+ *   h.belitz@fz-juelich.de                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#include "cconnectedcomponents.h"
+
+// Standard includes
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+// AIPS includes
+#include <aipsparallel.h>
+
+using namespace std;
+using namespace boost;
+
+namespace
+{
+
+/// A run of foreground voxels along x
+struct SRun
+{
+	size_t x0; ///< First voxel
+	size_t x1; ///< Last voxel
+	size_t y;  ///< Row
+};
+
+/// The runs of one slice, sorted by row and x
+struct SSlice
+{
+	vector<SRun> runVec;
+	vector<size_t> rowStartVec; ///< Index of the first run of each row, plus the end
+};
+
+/// Statistics of one component
+struct SComponent
+{
+	size_t root;         ///< Root run of the component
+	size_t size;         ///< Number of voxels
+	size_t minArr[3];    ///< Lower corner of the bounding box
+	size_t maxArr[3];    ///< Upper corner of the bounding box
+	double sumArr[3];    ///< Sum of all voxel positions
+	bool operator>( const SComponent& other ) const
+	{
+		return size > other.size;
+	}
+};
+
+/// Returns the root of a run, halving the path on the way
+inline size_t findRoot( vector<size_t>& parentVec, size_t i )
+{
+	while( parentVec[i] != i )
+	{
+		parentVec[i] = parentVec[parentVec[i]];
+		i = parentVec[i];
+	}
+	return i;
+}
+
+/// Joins the sets of two runs. The larger root is linked to the smaller one
+inline void unite( vector<size_t>& parentVec, const size_t a, const size_t b )
+{
+	const size_t aRoot = findRoot( parentVec, a );
+	const size_t bRoot = findRoot( parentVec, b );
+	if ( aRoot < bRoot )
+		parentVec[bRoot] = aRoot;
+	else if ( bRoot < aRoot )
+		parentVec[aRoot] = bRoot;
+}
+
+/**
+ * Extraction of the runs of a range of slices, shared by all workers.
+ */
+struct SRunExtraction
+{
+	const TImage::TDataType* dataPtr;
+	size_t extentArr[3];
+	TImage::TDataType lower;
+	TImage::TDataType upper;
+	vector<SSlice>* sliceVecPtr;
+
+	void range( const size_t first, const size_t last ) const
+	{
+		for( size_t z = first; z < last; ++z )
+		{
+			SSlice& theSlice = ( *sliceVecPtr )[z];
+			theSlice.rowStartVec.resize( extentArr[1] + 1 );
+			for( size_t y = 0; y < extentArr[1]; ++y )
+			{
+				theSlice.rowStartVec[y] = theSlice.runVec.size();
+				const TImage::TDataType* rowPtr = dataPtr + ( z * extentArr[1] + y ) * extentArr[0];
+				size_t x = 0;
+				while( x < extentArr[0] )
+				{
+					if ( rowPtr[x] < lower || rowPtr[x] > upper )
+					{
+						++x;
+						continue;
+					}
+					SRun aRun;
+					aRun.x0 = x;
+					aRun.y = y;
+					while( x < extentArr[0] && rowPtr[x] >= lower && rowPtr[x] <= upper )
+						++x;
+					aRun.x1 = x - 1;
+					theSlice.runVec.push_back( aRun );
+				}
+			}
+			theSlice.rowStartVec[extentArr[1]] = theSlice.runVec.size();
+		}
+	}
+};
+
+/**
+ * Merging of the runs of a range of slices, shared by all workers. Only
+ * runs of the given range are joined, so the workers touch disjoint parts
+ * of the union-find. The first slice of each range is marked as not linked
+ * to its predecessor.
+ */
+struct SRunMerging
+{
+	const vector<SSlice>* sliceVecPtr;
+	const vector<size_t>* firstIdVecPtr;   ///< Id of the first run of each slice
+	vector<size_t>* parentVecPtr;
+	vector<char>* linkedVecPtr;            ///< True if a slice was merged with its predecessor
+	size_t height;
+	unsigned short usConnectivity;
+
+	/// Joins the overlapping runs of two rows. Runs may be apart by tolerance voxels
+	void mergeRows( const size_t aSlice, const size_t aRow, const size_t bSlice, const size_t bRow,
+		const size_t tolerance ) const
+	{
+		const SSlice& aSliceRef = ( *sliceVecPtr )[aSlice];
+		const SSlice& bSliceRef = ( *sliceVecPtr )[bSlice];
+		size_t a = aSliceRef.rowStartVec[aRow];
+		size_t b = bSliceRef.rowStartVec[bRow];
+		const size_t aEnd = aSliceRef.rowStartVec[aRow + 1];
+		const size_t bEnd = bSliceRef.rowStartVec[bRow + 1];
+		while( a < aEnd && b < bEnd )
+		{
+			const SRun& aRun = aSliceRef.runVec[a];
+			const SRun& bRun = bSliceRef.runVec[b];
+			if ( aRun.x0 <= bRun.x1 + tolerance && bRun.x0 <= aRun.x1 + tolerance )
+				unite( *parentVecPtr, ( *firstIdVecPtr )[aSlice] + a, ( *firstIdVecPtr )[bSlice] + b );
+			if ( aRun.x1 < bRun.x1 )
+				++a;
+			else
+				++b;
+		}
+	}
+	/// Joins the runs of a slice with the rows before them in the same slice
+	void mergeWithin( const size_t z ) const
+	{
+		const size_t tolerance = ( usConnectivity > 6 ) ? 1 : 0;
+		for( size_t y = 1; y < height; ++y )
+			mergeRows( z, y, z, y - 1, tolerance );
+	}
+	/// Joins the runs of a slice with the previous slice
+	void mergePrevious( const size_t z ) const
+	{
+		for( size_t y = 0; y < height; ++y )
+		{
+			mergeRows( z, y, z - 1, y, ( usConnectivity > 6 ) ? 1 : 0 );
+			if ( usConnectivity == 6 )
+				continue;
+			const size_t tolerance = ( usConnectivity == 26 ) ? 1 : 0;
+			if ( y > 0 )
+				mergeRows( z, y, z - 1, y - 1, tolerance );
+			if ( y + 1 < height )
+				mergeRows( z, y, z - 1, y + 1, tolerance );
+		}
+	}
+	void range( const size_t first, const size_t last ) const
+	{
+		for( size_t z = first; z < last; ++z )
+		{
+			mergeWithin( z );
+			if ( z > first )
+				mergePrevious( z );
+			( *linkedVecPtr )[z] = ( z > first );
+		}
+	}
+};
+
+/**
+ * Writing of the final labels of a range of slices, shared by all workers.
+ */
+struct SLabelWriting
+{
+	const vector<SSlice>* sliceVecPtr;
+	const vector<size_t>* firstIdVecPtr;
+	const vector<TImage::TDataType>* labelVecPtr; ///< Label of each run, 0 if it was removed
+	TImage::TDataType* outputPtr;
+	size_t extentArr[3];
+
+	void range( const size_t first, const size_t last ) const
+	{
+		for( size_t z = first; z < last; ++z )
+		{
+			const SSlice& theSlice = ( *sliceVecPtr )[z];
+			for( size_t r = 0; r < theSlice.runVec.size(); ++r )
+			{
+				const SRun& aRun = theSlice.runVec[r];
+				TImage::TDataType* rowPtr = outputPtr + ( z * extentArr[1] + aRun.y ) * extentArr[0];
+				std::fill( rowPtr + aRun.x0, rowPtr + aRun.x1 + 1, ( *labelVecPtr )[( *firstIdVecPtr )[z] + r] );
+			}
+		}
+	}
+};
+
+}
+
+CConnectedComponents::CConnectedComponents( ulong ulID ) throw()
+  : CFilter( ulID, "Connected components", 1, 5, "CConnectedComponents", "0.1", "CFilter" )
+{
+  sModuleID = getClassName() + "/" + getClassVersion() + "/" + sLibID;
+  sDocumentation = "Labels the connected components of a thresholded image\n"
+                   "** Input ports:\n"
+                   "0: A singlechannel 2D or 3D image\n"
+                   "** Output ports:\n"
+                   "0: Label image. Label 1 is the largest component, 0 the background\n"
+                   "1: Number of voxels of each label\n"
+                   "2: Centroid of each label\n"
+                   "3: Lower corner of the bounding box of each label\n"
+                   "4: Upper corner of the bounding box of each label\n"
+                   "** Parameters:\n"
+                   "Lower threshold, Upper threshold: Range of foreground values\n"
+                   "Connectivity: 6, 18 or 26. 2D images use 4 for 6 and 8 otherwise\n"
+                   "Minimum size: Smaller components are removed\n"
+                   "Components: Number of largest components to keep, 0 keeps all\n";
+
+  parameters.initLong( "Lower threshold", 1L, -32768L, 32767L );
+  parameters.initLong( "Upper threshold", 32767L, -32768L, 32767L );
+  parameters.initUnsignedLong( "Connectivity", 26UL, 6UL, 26UL );
+  parameters.initUnsignedLong( "Minimum size", 1UL, 1UL, 4294967295UL );
+  parameters.initUnsignedLong( "Components", 0UL, 0UL, 32767UL );
+
+  inputsVec[0].portType = IOInteger;
+  outputsVec[0].portType = IOInteger;
+  outputsVec[1].portType = IO1DFloat;
+  outputsVec[2].portType = IO1DVector;
+  outputsVec[3].portType = IO1DVector;
+  outputsVec[4].portType = IO1DVector;
+}
+
+CConnectedComponents::~CConnectedComponents() throw()
+{
+}
+
+CPipelineItem* CConnectedComponents::newInstance( ulong ulID ) const throw()
+{
+  return new CConnectedComponents( ulID );
+}
+
+void CConnectedComponents::apply() throw()
+{
+FBEGIN;
+	bModuleReady = false;
+  TImagePtr inputPtr = static_pointer_cast<TImage>( getInput() );
+  if ( !checkInput<TImage>( inputPtr, 2, 3, 1, 1 ) )
+    return;
+	bModuleReady = true;
+
+	size_t extentArr[] = { 1, 1, 1 };
+	for( ushort i = 0; i < inputPtr->getDimension(); ++i )
+		extentArr[i] = inputPtr->getExtent( i );
+	const ulong ulConnectivity = parameters.getUnsignedLong( "Connectivity" );
+	const ushort usConnectivity = ( ulConnectivity < 18 ) ? 6 : ( ( ulConnectivity < 26 ) ? 18 : 26 );
+
+	// First pass: collect the runs of each slice
+	vector<SSlice> sliceVec( extentArr[2] );
+	SRunExtraction theExtraction;
+	theExtraction.dataPtr = &( *inputPtr )[0];
+	for( ushort i = 0; i < 3; ++i )
+		theExtraction.extentArr[i] = extentArr[i];
+	theExtraction.lower = static_cast<TImage::TDataType>( parameters.getLong( "Lower threshold" ) );
+	theExtraction.upper = static_cast<TImage::TDataType>( parameters.getLong( "Upper threshold" ) );
+	theExtraction.sliceVecPtr = &sliceVec;
+	parallelFor( theExtraction, &SRunExtraction::range, extentArr[2] );
+
+	vector<size_t> firstIdVec( extentArr[2] + 1, 0 );
+	for( size_t z = 0; z < extentArr[2]; ++z )
+		firstIdVec[z + 1] = firstIdVec[z] + sliceVec[z].runVec.size();
+	const size_t runCount = firstIdVec[extentArr[2]];
+
+	// Join the runs of blocks of slices in parallel, then the seams between the blocks
+	vector<size_t> parentVec( runCount );
+	for( size_t i = 0; i < runCount; ++i )
+		parentVec[i] = i;
+	vector<char> linkedVec( extentArr[2] );
+	SRunMerging theMerging;
+	theMerging.sliceVecPtr = &sliceVec;
+	theMerging.firstIdVecPtr = &firstIdVec;
+	theMerging.parentVecPtr = &parentVec;
+	theMerging.linkedVecPtr = &linkedVec;
+	theMerging.height = extentArr[1];
+	theMerging.usConnectivity = usConnectivity;
+	parallelFor( theMerging, &SRunMerging::range, extentArr[2] );
+	for( size_t z = 1; z < extentArr[2]; ++z )
+		if ( !linkedVec[z] )
+			theMerging.mergePrevious( z );
+
+	// Roots are always smaller than their children, so one pass resolves all of them
+	vector<size_t> componentVec( runCount );
+	vector<SComponent> statisticsVec;
+	for( size_t i = 0; i < runCount; ++i )
+	{
+		parentVec[i] = parentVec[parentVec[i]];
+		if ( parentVec[i] == i )
+		{
+			SComponent aComponent;
+			aComponent.root = i;
+			aComponent.size = 0;
+			for( ushort d = 0; d < 3; ++d )
+			{
+				aComponent.minArr[d] = numeric_limits<size_t>::max();
+				aComponent.maxArr[d] = 0;
+				aComponent.sumArr[d] = 0.0;
+			}
+			componentVec[i] = statisticsVec.size();
+			statisticsVec.push_back( aComponent );
+		}
+		else
+			componentVec[i] = componentVec[parentVec[i]];
+	}
+	for( size_t z = 0; z < extentArr[2]; ++z )
+		for( size_t r = 0; r < sliceVec[z].runVec.size(); ++r )
+		{
+			const SRun& aRun = sliceVec[z].runVec[r];
+			SComponent& aComponent = statisticsVec[componentVec[firstIdVec[z] + r]];
+			const size_t length = aRun.x1 - aRun.x0 + 1;
+			aComponent.size += length;
+			aComponent.minArr[0] = std::min( aComponent.minArr[0], aRun.x0 );
+			aComponent.maxArr[0] = std::max( aComponent.maxArr[0], aRun.x1 );
+			aComponent.minArr[1] = std::min( aComponent.minArr[1], aRun.y );
+			aComponent.maxArr[1] = std::max( aComponent.maxArr[1], aRun.y );
+			aComponent.minArr[2] = std::min( aComponent.minArr[2], z );
+			aComponent.maxArr[2] = std::max( aComponent.maxArr[2], z );
+			aComponent.sumArr[0] += 0.5 * static_cast<double>( aRun.x0 + aRun.x1 ) * length;
+			aComponent.sumArr[1] += static_cast<double>( aRun.y ) * length;
+			aComponent.sumArr[2] += static_cast<double>( z ) * length;
+		}
+
+	// Number the components by decreasing size and drop the unwanted ones
+	std::stable_sort( statisticsVec.begin(), statisticsVec.end(), std::greater<SComponent>() );
+	size_t labelCount = statisticsVec.size();
+	const ulong ulMinimumSize = parameters.getUnsignedLong( "Minimum size" );
+	while( labelCount > 0 && statisticsVec[labelCount - 1].size < ulMinimumSize )
+		--labelCount;
+	const ulong ulComponents = parameters.getUnsignedLong( "Components" );
+	if ( ulComponents > 0 && labelCount > ulComponents )
+		labelCount = ulComponents;
+	const size_t maxLabel = static_cast<size_t>( numeric_limits<TImage::TDataType>::max() );
+	if ( labelCount > maxLabel )
+	{
+		alog << LWARN << "Only the " << maxLabel << " largest of " << labelCount
+			<< " components are labelled" << endl;
+		labelCount = maxLabel;
+	}
+	vector<TImage::TDataType> rootLabelVec( runCount, 0 );
+	for( size_t c = 0; c < labelCount; ++c )
+		rootLabelVec[statisticsVec[c].root] = static_cast<TImage::TDataType>( c + 1 );
+	for( size_t i = 0; i < runCount; ++i )
+		rootLabelVec[i] = rootLabelVec[parentVec[i]];
+
+	// Second pass: write the labels
+  TImagePtr outputPtr( new TImage( inputPtr->getDimension(), inputPtr->getExtents() ) );
+	(*outputPtr) = 0;
+	SLabelWriting theWriting;
+	theWriting.sliceVecPtr = &sliceVec;
+	theWriting.firstIdVecPtr = &firstIdVec;
+	theWriting.labelVecPtr = &rootLabelVec;
+	theWriting.outputPtr = &( *outputPtr )[0];
+	for( ushort i = 0; i < 3; ++i )
+		theWriting.extentArr[i] = extentArr[i];
+	parallelFor( theWriting, &SLabelWriting::range, extentArr[2] );
+	outputPtr->setMinimum( 0 );
+	outputPtr->setMaximum( static_cast<TImage::TDataType>( labelCount ) );
+
+	size_t tableSize[] = { labelCount };
+	TFieldPtr sizePtr( new TField( 1, tableSize ) );
+	TField3DPtr centroidPtr( new TField3D( 1, tableSize ) );
+	TField3DPtr lowerPtr( new TField3D( 1, tableSize ) );
+	TField3DPtr upperPtr( new TField3D( 1, tableSize ) );
+	for( size_t c = 0; c < labelCount; ++c )
+	{
+		const SComponent& aComponent = statisticsVec[c];
+		(*sizePtr)( c ) = static_cast<double>( aComponent.size );
+		for( ushort d = 0; d < 3; ++d )
+		{
+			(*centroidPtr)( c )[d] = aComponent.sumArr[d] / static_cast<double>( aComponent.size );
+			(*lowerPtr)( c )[d] = static_cast<double>( aComponent.minArr[d] );
+			(*upperPtr)( c )[d] = static_cast<double>( aComponent.maxArr[d] );
+		}
+	}
+  setOutput( outputPtr );
+	setOutput( sizePtr, 1 );
+	setOutput( centroidPtr, 2 );
+	setOutput( lowerPtr, 3 );
+	setOutput( upperPtr, 4 );
+FEND;
+}
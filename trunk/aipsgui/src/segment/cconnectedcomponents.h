@@ -0,0 +1,67 @@
+/***************************************************************************
+ *   Copyright (C) 2004 by Hendrik Belitz                                  *
+ *   h.belitz@fz-juelich.de                                                *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef CCONNECTEDCOMPONENTS_H
+#define CCONNECTEDCOMPONENTS_H
+
+// AIPS includes
+#include <cfilter.h>
+#include <aipsnumeric.h>
+
+// lib includes
+#include "libid.h"
+
+using namespace aips;
+
+/**
+ * Labels the connected components of a thresholded image.
+ *
+ * Voxels between the lower and upper threshold are foreground. Runs of
+ * foreground voxels along x are labelled in two passes. Blocks of slices are
+ * labelled in parallel with a union-find over the runs, afterwards the seams
+ * between the blocks are merged. Components are numbered by decreasing size,
+ * so label 1 is always the largest one.
+ */
+class CConnectedComponents : public CFilter
+{
+private:
+  /// Standard constructor
+  CConnectedComponents();
+  /// Copy constructor
+  CConnectedComponents( CConnectedComponents& );
+  /// Assignment operator
+  CConnectedComponents& operator=( CConnectedComponents& );
+public:
+/* Structors */
+  /// Constructor
+  CConnectedComponents( ulong ulID )
+    throw();
+  /// Destructor
+  virtual ~CConnectedComponents()
+    throw();
+/* Other methods */
+  /// Reimplemented from CPipelineItem
+  virtual CPipelineItem* newInstance( ulong ulID = 0 ) const
+    throw();
+  /// Reimplemented from CPipelineItem
+  virtual void apply()
+    throw();
+};
+
+#endif
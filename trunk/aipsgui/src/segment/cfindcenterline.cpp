@@ -19,6 +19,9 @@
  ***************************************************************************/
 #include "cfindcenterline.h"
 
+// AIPS includes
+#include <crecursivegaussian.h>
+
 using namespace std;
 using namespace boost;
 
@@ -30,7 +33,7 @@ using namespace boost;
  * \param ulID unique module ID
  */
 CFindCenterLine::CFindCenterLine( ulong ulID ) throw()
-  : CFilter ( ulID, "Centerline", 1, 2, "CFindCenterLine", "0.1", "CFilter" )
+  : CFilter ( ulID, "Centerline", 1, 2, "CFindCenterLine", "0.2", "CFilter" )
 {
   setModuleID( sLibID );
 
@@ -78,37 +81,13 @@ BENCHSTART;
 		profile[x] = noPixs;
 	}	
 	// Smooth profile
-	// Do a gaussian smoothing on the histogram
-	// Compute gaussian mask
-	double dSigma = 3.0;
-	int iMaskSize = static_cast<uint>( floor( 6.0 * dSigma + 0.5 ) );
-	vector<double> dGaussMask;
-	for( int i = -( iMaskSize / 2 ); i <= ( iMaskSize / 2 ); ++i )
-	{
-		double dExponential = (1.0/sqrt(dSigma*dSigma*2.0*M_PI))*exp( static_cast<double>(-i*i) / ( 2.0 * ( dSigma * dSigma ) ) );
-		dGaussMask.push_back( dExponential );
-	}
-
-	// Shift histogram to attend smoothing
-	vector<uint> shiftedHisto;
-	for( int i = 0; i < iMaskSize/2; ++i )
-		shiftedHisto.push_back(0);
-	for( uint i = 1; i < profile.size(); ++i )
-	{
-		shiftedHisto.push_back( profile[i] );
-	}
-	for( int i = 0; i <= iMaskSize/2; ++i )
-		shiftedHisto.push_back(0);
+	// Do a gaussian smoothing on the histogram, the profile is extended by its border values
+	vector<double> smoothedVec( profile.begin(), profile.end() );
+	const CRecursiveGaussian theGaussian( 3.0 );
+	theGaussian.smoothLines( &smoothedVec[0], smoothedVec.size(), 1 );
 	vector<uint> smoothedHisto( profile.size() );
-	for( int i = iMaskSize/2+1; i < static_cast<long>(shiftedHisto.size() - iMaskSize/2); ++i )
-	{
-		double smoothed = 0.0;
-		for( int j = -iMaskSize/2; j <= iMaskSize/2; ++j )
-		{
-			smoothed += shiftedHisto[i+j]*dGaussMask[j+(iMaskSize/2)];
-		}
-		smoothedHisto[i-(iMaskSize/2+1)] = static_cast<uint>(smoothed);
-	}
+	for( uint i = 0; i < smoothedHisto.size(); ++i )
+		smoothedHisto[i] = static_cast<uint>( smoothedVec[i] );
 
 	// Determine number of maxima
 	vector<uint> maxima;
@@ -17,11 +17,31 @@
 #include "libid.h"
 #include <cmath>
 #include <cfloat>
+#include <algorithm>
 
 using namespace blitz;
 using namespace std;
 using namespace boost;
 
+namespace
+{
+
+/// Returns the cell of a coordinate in a uniform grid
+long gridCell( const double dCoordinate, const double dCellSize )
+{
+	if ( isnan( dCoordinate ) )
+		return 0;
+	return static_cast<long>( floor( dCoordinate / dCellSize ) );
+}
+
+/// Returns the hash bucket of a grid cell, bucketCount is a power of two
+size_t cellBucket( const long x, const long y, const size_t bucketCount )
+{
+	return ( static_cast<size_t>( x ) * 73856093UL ^ static_cast<size_t>( y ) * 19349663UL ) & ( bucketCount - 1 );
+}
+
+}
+
 /*************
  * Structors *
  *************/
@@ -133,11 +153,11 @@ void CParticleSnake::displaySnake()
 	QPainter p( &theBuffer );
 	p.scale(2.0,2.0);
   p.drawImage( 0, 0, theImage );
-  p.moveTo( static_cast<int>( round( (*vertexList.begin()).position[0] ) ), 
-		static_cast<int>( iHeight - 1 - round( (*vertexList.begin()).position[1] ) ) );
+  p.moveTo( static_cast<int>( round( (*vertexVec.begin()).position[0] ) ), 
+		static_cast<int>( iHeight - 1 - round( (*vertexVec.begin()).position[1] ) ) );
 	p.setPen(Qt::red);	
-	TPartIterator listEnd = vertexList.end();
-  for ( TPartIterator actv = vertexList.begin(); 
+	TPartIterator listEnd = vertexVec.end();
+  for ( TPartIterator actv = vertexVec.begin(); 
 		actv != listEnd; ++actv )
   {
     p.lineTo( static_cast<int>( round( (*actv).position[0]) ), 
@@ -154,8 +174,8 @@ void CParticleSnake::displaySnake()
 		p.moveTo( static_cast<int>( round( (*actv).position[0] ) ), 
 			iHeight - 1 - static_cast<int>( round( (*actv).position[1] ) ) );
 	}
-  p.lineTo( static_cast<int>( round( (*vertexList.begin() ).position[0] ) ),
-		iHeight - 1 - static_cast<int>( round( (*vertexList.begin() ).position[1] ) ) );
+  p.lineTo( static_cast<int>( round( (*vertexVec.begin() ).position[0] ) ),
+		iHeight - 1 - static_cast<int>( round( (*vertexVec.begin() ).position[1] ) ) );
   p.flush();		
   p.end();	
 	theDialog->setPixmap( theBuffer );
@@ -236,20 +256,14 @@ DS( "-- Multiscale loop" );
 PROG_VAL( t );	
 	    remesh();		
 			checkProximity();
-			calculateNormals();
-			computeInternalForces();
-			computeExternalForces();
-			if ( dBalloonWeight > 0.0 )
-				computeBalloonForces();
-			if ( dTemplateWeight > 0.0 )
-				computeTemplateForces();
+			computeForces();
 			checkStability();		
 			updateSnake();
 			//if ( t % fr == 0 ) 
 			displaySnake();
 APP_PROC();			
 	    t++;	
-			if ( ulStableNodes == vertexList.size() ) 
+			if ( ulStableNodes == vertexVec.size() ) 
 			{
 				bStop = true;	
 				ulTotalIterations += t;
@@ -262,7 +276,7 @@ APP_PROC();
 			dMeanDistance /= 2.0;
 			//dInternalWeight *= 4.0;
 			//dBalloonWeight /= 2.0;
-			generateNewContour( vertexList );
+			generateNewContour( vertexVec );
 			bStop = false;			
 			t = 0;
 			bStable = false;
@@ -271,7 +285,7 @@ APP_PROC();
 	}
 	
 		
-	alog << LINFO << "Particle snake finished. Resulting polygon has " << vertexList.size() << " vertices" << endl;
+	alog << LINFO << "Particle snake finished. Resulting polygon has " << vertexVec.size() << " vertices" << endl;
 	alog << "-- Algorithm took " << ulTotalIterations << " iterations " << endl;
 
 	// Draw output contour	
@@ -282,19 +296,19 @@ APP_PROC();
   QPixmap pic( inputImagePtr->getExtent(0), inputImagePtr->getExtent(1) );
 	pic.fill( Qt::black );
   QPainter p(&pic);
-  QPointArray pa( vertexList.size() * 2 );
+  QPointArray pa( vertexVec.size() * 2 );
   p.setPen( Qt::red );
   p.setBrush( Qt::red );
   int index = 0;
-	TPartIterator listEnd = vertexList.end();
-  for ( TPartIterator actv = vertexList.begin(); actv != listEnd; ++actv )
+	TPartIterator listEnd = vertexVec.end();
+  for ( TPartIterator actv = vertexVec.begin(); actv != listEnd; ++actv )
   {
     pa.setPoint( index, static_cast<int>( round( (*actv).position[0] ) ),
 			static_cast<int>( round( (*actv).position[1] ) ) );
     ++index;
   }
-	listEnd = vertexList.end();
-  for ( TPartIterator actv = vertexList.begin(); actv != listEnd; ++actv )
+	listEnd = vertexVec.end();
+  for ( TPartIterator actv = vertexVec.begin(); actv != listEnd; ++actv )
   {
     pa.setPoint( index, static_cast<int>( round( (*actv).position[0] ) ),
 			static_cast<int>( round( (*actv).position[1] ) ) );
@@ -307,7 +321,7 @@ APP_PROC();
   for ( ushort y = 0; y < outputPtr->getExtent(1); ++y )
     for ( ushort x = 0; x < outputPtr->getExtent(0); ++x )
       (*outputPtr)( x, y ) = qRed( i.pixel( x, y ) );
-  vertexList.clear();
+  vertexVec.clear();
   setOutput( outputPtr );
 PROG_RESET();		
 FEND;
@@ -315,229 +329,290 @@ FEND;
 
 void CParticleSnake::remesh()
 {
-  for ( TPartIterator it = vertexList.begin();	it != vertexList.end(); ++it )
-  {
-    TPartIterator next = it; 
-		++next;    
-    if ( next == vertexList.end() )
-    {
-			next = vertexList.begin();
-    }
-		TVector2D particleDistance = next->position - it->position;
+	const size_t n = vertexVec.size();
+	if ( n < 3 )
+		return;
+	TPartList remeshedVec;
+	remeshedVec.reserve( n + n / 4 + 1 );
+	for ( size_t i = 0; i < n; ++i )
+	{
+		SParticle& actv = vertexVec[i];
+		// The successor of the last particle is the first one of the new polygon
+		SParticle& successor = ( i + 1 < n ) ? vertexVec[i + 1] : remeshedVec.front();
+		TVector2D particleDistance = successor.position - actv.position;
     double dLength = norm( particleDistance );
 		// Check if edge is too large. In this case, insert another vertex
     if ( dLength > dMeanDistance * 2.0 ) 
     {
       SParticle newVertex;
-      newVertex.position = it->position + ( 0.5 * particleDistance );
+      newVertex.position = actv.position + ( 0.5 * particleDistance );
+			newVertex.oldpos = 0.0;
+			newVertex.force = 0.0;
 			newVertex.stability = 0;
 			newVertex.isReference = false;
-			newVertex.reference = NULL;
-      vertexList.insert( next, newVertex );
-      ++it;
+			newVertex.reference = -1;
+			newVertex.angle = 0.0;
+			keepParticle( actv, remeshedVec );
+			remeshedVec.push_back( newVertex );
     }
-		// Now check if one of the adjacent edges is too small. In this case, try to erase the
-		// current vertex. If the current vertex is a ref vertex, erase its successor instead.
-		// If this is also not possible ( next is also a ref vertex), do nothing and pray nothing
-		// goes wrong ;-)
-    else if ( dLength < ( dMeanDistance * 0.5 ) )
+		// Now check if the edge is too small. In this case, merge the current vertex into its
+		// successor, whose own edge is not checked in this pass. Ref vertices are never erased.
+    else if ( dLength < ( dMeanDistance * 0.5 ) && !actv.isReference )
 		{
-			if  ( !it->isReference )
-			// Edge is too small
-  	  {
-	      next->position = it->position + ( 0.5 * particleDistance );						
-  	    vertexList.erase( it );
-    	  it = next;
-	    }		
-/*			else if ( next->stability > -1 )
+			successor.position = actv.position + ( 0.5 * particleDistance );
+			if ( i + 1 < n )
 			{
- FIXME 
-				DBG("Yuk!");
-	      //it->position = next->position - ( 0.5 * difference );						
-  	    vertexList.erase( next );
-			}*/
-		}		
-  }   
+				keepParticle( successor, remeshedVec );
+				++i;
+			}
+		}
+		else
+			keepParticle( actv, remeshedVec );
+  }
+	vertexVec.swap( remeshedVec );
 }
 
+/**
+ * \param aParticle particle to append
+ * \param remeshedVec new polygon
+ */
+void CParticleSnake::keepParticle( const SParticle& aParticle, std::vector<SParticle>& remeshedVec )
+{
+	if ( aParticle.reference >= 0 )
+		templateVec[aParticle.reference].reference = remeshedVec.size();
+	remeshedVec.push_back( aParticle );
+}
+
+/**
+ * Edges closer than half the mean distance push each other apart. Edge i
+ * connects particles i and i + 1. The plane is divided into square cells of
+ * the mean particle distance, and each edge is listed in all cells covered by
+ * its bounding box. The cells are hashed into about twice as many buckets as
+ * there are edges. Only edges found in the buckets of the cells covered by the
+ * grown bounding box of an edge are compared to it.
+ */
 void CParticleSnake::checkProximity()
 {
-	TPartIterator listEnd = vertexList.end();
-	for ( TPartIterator actv = vertexList.begin(); actv != listEnd; ++actv )
+	const size_t n = vertexVec.size();
+	if ( n < 4 )
+		return;
+	const double dMinimalDistance = dMeanDistance * 0.5;
+	size_t bucketCount = 1;
+	while ( bucketCount < 2 * n )
+		bucketCount *= 2;
+	
+	// Cell ranges of all edges: x0, y0, x1, y1
+	vector<long> rangeVec( 4 * n );
+	for ( size_t i = 0; i < n; ++i )
 	{
-    TPartIterator successor = actv;
-    ++successor;
-    if ( successor == listEnd ) 
-			successor = vertexList.begin();
-    for ( TPartIterator partner = successor; partner != listEnd; ++partner )
-		{					
-			list<SParticle>::iterator partnersSuccessor = partner;
-	    partnersSuccessor++;
-  	  if ( partnersSuccessor  == listEnd ) 
-				partnersSuccessor = vertexList.begin();
-			if ( partner != actv && partnersSuccessor != actv 
-				&& partner != successor && partnersSuccessor != successor )
+		const TVector2D& p = vertexVec[i].position;
+		const TVector2D& q = vertexVec[( i + 1 ) % n].position;
+		rangeVec[4 * i] = gridCell( std::min( p[0], q[0] ), dMeanDistance );
+		rangeVec[4 * i + 1] = gridCell( std::min( p[1], q[1] ), dMeanDistance );
+		rangeVec[4 * i + 2] = gridCell( std::max( p[0], q[0] ), dMeanDistance );
+		rangeVec[4 * i + 3] = gridCell( std::max( p[1], q[1] ), dMeanDistance );
+	}
+	// Counting sort of the edges into the buckets
+	vector<size_t> bucketStartVec( bucketCount + 1, 0 );
+	for ( size_t i = 0; i < n; ++i )
+		for ( long y = rangeVec[4 * i + 1]; y <= rangeVec[4 * i + 3]; ++y )
+			for ( long x = rangeVec[4 * i]; x <= rangeVec[4 * i + 2]; ++x )
+				++bucketStartVec[cellBucket( x, y, bucketCount ) + 1];
+	for ( size_t b = 1; b <= bucketCount; ++b )
+		bucketStartVec[b] += bucketStartVec[b - 1];
+	vector<size_t> bucketEdgeVec( bucketStartVec.back() );
+	vector<size_t> bucketEndVec( bucketStartVec.begin(), bucketStartVec.end() - 1 );
+	for ( size_t i = 0; i < n; ++i )
+		for ( long y = rangeVec[4 * i + 1]; y <= rangeVec[4 * i + 3]; ++y )
+			for ( long x = rangeVec[4 * i]; x <= rangeVec[4 * i + 2]; ++x )
+				bucketEdgeVec[bucketEndVec[cellBucket( x, y, bucketCount )]++] = i;
+
+	// Compare each pair of non adjacent edges once
+	vector<size_t> lastVisitVec( n, 0 );
+	for ( size_t i = 0; i < n; ++i )
+	{
+		SParticle& actv = vertexVec[i];
+		SParticle& successor = vertexVec[( i + 1 ) % n];
+		const long x0 = gridCell( std::min( actv.position[0], successor.position[0] ) - dMinimalDistance,
+			dMeanDistance );
+		const long y0 = gridCell( std::min( actv.position[1], successor.position[1] ) - dMinimalDistance,
+			dMeanDistance );
+		const long x1 = gridCell( std::max( actv.position[0], successor.position[0] ) + dMinimalDistance,
+			dMeanDistance );
+		const long y1 = gridCell( std::max( actv.position[1], successor.position[1] ) + dMinimalDistance,
+			dMeanDistance );
+		for ( long y = y0; y <= y1; ++y )
+			for ( long x = x0; x <= x1; ++x )
 			{
-				TVector2D particleDistance = edgeDistance( actv->position, successor->position, 
-					partner->position, partnersSuccessor->position );
-				double dMinimalDistance = dMeanDistance * 0.5;
-				double dDistance = norm( particleDistance );
-				if ( trueIn( dDistance, numeric_limits<double>::epsilon(), dMinimalDistance ) )
+				const size_t b = cellBucket( x, y, bucketCount );
+				for ( size_t k = bucketStartVec[b]; k < bucketStartVec[b + 1]; ++k )
 				{
-					double dFactor = ( dMinimalDistance - dDistance ) / ( 10.0 * dDistance );
-					actv->force += particleDistance * dFactor;
-					successor->force += particleDistance * dFactor;
-					partner->force += -particleDistance * dFactor;
-					partnersSuccessor->force += -particleDistance * dFactor;
+					const size_t j = bucketEdgeVec[k];
+					if ( j <= i + 1 || lastVisitVec[j] == i + 1 || ( i == 0 && j == n - 1 ) )
+						continue;
+					lastVisitVec[j] = i + 1;
+					SParticle& partner = vertexVec[j];
+					SParticle& partnersSuccessor = vertexVec[( j + 1 ) % n];
+					TVector2D particleDistance = edgeDistance( actv.position, successor.position, 
+						partner.position, partnersSuccessor.position );
+					double dDistance = norm( particleDistance );
+					if ( trueIn( dDistance, numeric_limits<double>::epsilon(), dMinimalDistance ) )
+					{
+						double dFactor = ( dMinimalDistance - dDistance ) / ( 10.0 * dDistance );
+						actv.force += particleDistance * dFactor;
+						successor.force += particleDistance * dFactor;
+						partner.force += -particleDistance * dFactor;
+						partnersSuccessor.force += -particleDistance * dFactor;
+					}
 				}
 			}
-		}		
 	}
 }
 
-void CParticleSnake::calculateNormals()
-{
-	TPartIterator listEnd = vertexList.end();
-	for ( TPartIterator actv = vertexList.begin(); actv != listEnd; ++actv )
-  {		
-    TPartIterator successor = actv;
-    successor++;
-    if ( successor == listEnd ) successor = vertexList.begin();
-    TPartIterator predecessor = actv;
-    if ( predecessor == vertexList.begin() ) predecessor = listEnd;
-    predecessor--;
-		
-		TVector2D d1 = predecessor->position / 2.0;
-		TVector2D d2 = successor->position / 2.0;
-		actv->curvature = d1 + d2 - actv->position;
-		TVector2D m1 ( predecessor->position[1] - actv->position[1], actv->position[0] - predecessor->position[0] ); 
-		TVector2D m2 ( actv->position[1] - successor->position[1], successor->position[0] - actv->position[0] );
-		actv->normal = m1 + m2; 
-		actv->normal /= norm( actv->normal );
-		if ( isnan( actv->normal[0] ) || isnan( actv->normal[1] ) )
-		{
-			DBG( "Extreme curvature alert!" );
-			// This means pre- and successor are on equal positions. We need to define the normal manually
-			actv->normal = actv->position - predecessor->position;
-			actv->normal /= norm( actv->normal );
-		}
-	}
-}
-
-void CParticleSnake::computeInternalForces()
+/**
+ * Normals, curvatures, internal, external, balloon and template forces of
+ * a particle only depend on the particle itself and the positions of the
+ * others, so they are computed in a single pass over the particles.
+ */
+void CParticleSnake::computeForces()
 {
-	TPartIterator listEnd = vertexList.end();
-	for ( TPartIterator actv = vertexList.begin(); actv != listEnd; ++actv )
-  {
-    TPartIterator successor = actv;
-    successor++;
-    if ( successor == listEnd ) successor = vertexList.begin();
-    TPartIterator predecessor = actv;
-    if ( predecessor == vertexList.begin() ) predecessor = listEnd;
-    predecessor--;
-		TVector2D innerForce = 0.0;
-		
-		if ( dInternalWeight > numeric_limits<double>::epsilon() 
-			&& norm(actv->curvature) > numeric_limits<double>::epsilon() )
-		{
-			innerForce = actv->curvature; 
-			double dForceStrength = dot( actv->curvature, actv->normal );
-			double dSpatialDiscretisation = ( norm( predecessor->position - actv->position ) +
-				norm( successor->position - actv->position ) ) / 2.0;
-		  dSpatialDiscretisation *= dSpatialDiscretisation;
-			innerForce *= dForceStrength;
-			TVector2D d1 = predecessor->position / 2.0;
-			TVector2D d2 = successor->position / 2.0;
-			innerForce *= -dInternalWeight;
-			actv->curvature = d1 + d2 - ( actv->position + innerForce );
-			TVector2D unshrinkForce = actv->curvature;
-			dForceStrength = dot( actv->curvature, actv->normal );
-			unshrinkForce *= dForceStrength;
-			unshrinkForce *= ( dInternalWeight * 1.1 );
-			innerForce += unshrinkForce;
-			innerForce /= dSpatialDiscretisation;
-			// If force is too high, this can lead to problems. So we set the maximum norm of the force to 1.0
-/*			if ( norm( innerForce ) > 1.0 ) 
-				innerForce /= norm( innerForce );*/
-				
-			// Again, we may have problems if the force does not converge
-			if ( isnan( innerForce[0] ) || isnan( innerForce[1] ) )
-			{
-				DBG("Inner force is NaN");
-				innerForce = 0.0;
-			}
-	  }
-		if ( norm( innerForce ) > numeric_limits<double>::epsilon() )
-			actv->force += innerForce;
+	const size_t n = vertexVec.size();
+	const bool bInternal = ( dInternalWeight > numeric_limits<double>::epsilon() );
+	for ( size_t i = 0; i < n; ++i )
+	{
+		SParticle& actv = vertexVec[i];
+		const SParticle& predecessor = vertexVec[( i + n - 1 ) % n];
+		const SParticle& successor = vertexVec[( i + 1 ) % n];
+		calculateNormal( actv, predecessor, successor );
+		if ( bInternal )
+			actv.force += internalForce( actv, predecessor, successor );
+		actv.force += externalForce( actv );
+		if ( dBalloonWeight > 0.0 )
+			actv.force += actv.normal * dBalloonWeight;
+		if ( dTemplateWeight > 0.0 && actv.reference >= 0 )
+			actv.force += templateForce( actv );
 	}
 }
 
-void CParticleSnake::computeExternalForces()
+/**
+ * \param actv particle to compute normal and curvature for
+ * \param predecessor preceding particle
+ * \param successor succeeding particle
+ */
+void CParticleSnake::calculateNormal( SParticle& actv, const SParticle& predecessor,
+	const SParticle& successor )
 {
-	TPartIterator listEnd = vertexList.end();
-	for ( TPartIterator actv = vertexList.begin(); actv != listEnd; ++actv )
-  {
-		const TVector2D& pos = actv->position;
-		TVector2D ro, ru, lo, lu;
-  	double rol, rul, lol, lul;
-	  ro[0] = static_cast<int>( ceil( pos[0] ) );  ro[1] = static_cast<int>( floor( pos[1] ) );
-  	ru[0] = static_cast<int>( ceil( pos[0] ) );  ru[1] = static_cast<int>( ceil( pos[1] ) );
-	  lo[0] = static_cast<int>( floor( pos[0] ) ); lo[1] = static_cast<int>( floor( pos[1] ) );
-  	lu[0] = static_cast<int>( floor( pos[0] ) ); lu[1] = static_cast<int>( ceil( pos[1] ) );
-	  rul = sqrt(2.0) - norm( ru - pos );
-  	rol = sqrt(2.0) - norm( ro - pos );
-	  lul = sqrt(2.0) - norm( lu - pos );
-  	lol = sqrt(2.0) - norm( lo - pos );
-	  double sum = rol + rul + lul + lol;
-  	TVector2D eforce =
-    	( rol /sum ) * (*externalForceFieldPtr)( static_cast<ushort>( ro[0] ), static_cast<ushort>( ro[1] ) )
-	    + ( rul /sum ) * (*externalForceFieldPtr)( static_cast<ushort>( ru[0] ), static_cast<ushort>( ru[1] ) )
-  	  + ( lol /sum ) * (*externalForceFieldPtr)( static_cast<ushort>( lo[0] ), static_cast<ushort>( lo[1] ) )
-    	+ ( lul /sum ) * (*externalForceFieldPtr)( static_cast<ushort>( lu[0] ), static_cast<ushort>( lu[1] ) );
-    if ( bNormalize )
-    	eforce /= norm(eforce);
-    eforce = dot(actv->normal,eforce) * actv->normal;
-  	actv->force += eforce;
+	TVector2D d1 = predecessor.position / 2.0;
+	TVector2D d2 = successor.position / 2.0;
+	actv.curvature = d1 + d2 - actv.position;
+	TVector2D m1 ( predecessor.position[1] - actv.position[1], actv.position[0] - predecessor.position[0] ); 
+	TVector2D m2 ( actv.position[1] - successor.position[1], successor.position[0] - actv.position[0] );
+	actv.normal = m1 + m2; 
+	actv.normal /= norm( actv.normal );
+	if ( isnan( actv.normal[0] ) || isnan( actv.normal[1] ) )
+	{
+		DBG( "Extreme curvature alert!" );
+		// This means pre- and successor are on equal positions. We need to define the normal manually
+		actv.normal = actv.position - predecessor.position;
+		actv.normal /= norm( actv.normal );
 	}
 }
 
-void CParticleSnake::computeTemplateForces()
+/**
+ * \param actv particle to compute the force for. Its curvature is updated
+ * \param predecessor preceding particle
+ * \param successor succeeding particle
+ * \returns internal force
+ */
+TVector2D CParticleSnake::internalForce( SParticle& actv, const SParticle& predecessor,
+	const SParticle& successor ) const
 {
-	for( TPartIterator it = templateList.begin(); it != templateList.end(); ++it )
+	TVector2D innerForce = 0.0;
+	if ( norm( actv.curvature ) > numeric_limits<double>::epsilon() )
 	{
-		TPartIterator next;	next = it; ++next;
-		TPartIterator last;	
-		if ( it == templateList.begin() )
-		{
-			last = templateList.end();
-			--last;
-		}
-		else
-		{			
-			last = it; 
-			--last;
-		}
+		innerForce = actv.curvature; 
+		double dForceStrength = dot( actv.curvature, actv.normal );
+		double dSpatialDiscretisation = ( norm( predecessor.position - actv.position ) +
+			norm( successor.position - actv.position ) ) / 2.0;
+	  dSpatialDiscretisation *= dSpatialDiscretisation;
+		innerForce *= dForceStrength;
+		TVector2D d1 = predecessor.position / 2.0;
+		TVector2D d2 = successor.position / 2.0;
+		innerForce *= -dInternalWeight;
+		actv.curvature = d1 + d2 - ( actv.position + innerForce );
+		TVector2D unshrinkForce = actv.curvature;
+		dForceStrength = dot( actv.curvature, actv.normal );
+		unshrinkForce *= dForceStrength;
+		unshrinkForce *= ( dInternalWeight * 1.1 );
+		innerForce += unshrinkForce;
+		innerForce /= dSpatialDiscretisation;
+		// If force is too high, this can lead to problems. So we set the maximum norm of the force to 1.0
+/*		if ( norm( innerForce ) > 1.0 ) 
+			innerForce /= norm( innerForce );*/
 			
-		if ( next == templateList.end() )
+		// Again, we may have problems if the force does not converge
+		if ( isnan( innerForce[0] ) || isnan( innerForce[1] ) )
 		{
-			next = templateList.begin();	
+			DBG("Inner force is NaN");
+			innerForce = 0.0;
 		}
-			
-		TVector2D a = it->reference->position - last->reference->position;
-		TVector2D b = next->reference->position - it->reference->position;
-		TVector2D n1( -a[1], a[0] ); 
-		TVector2D n2( -b[1], b[0] ); 
-		TVector2D vertexNormal( n1 + n2 );
-		vertexNormal /= norm( vertexNormal );			
-		it->reference->angle = 2 * M_PI - acos( dot( a * - 1.0, vertexNormal ) / norm( a ) )
-			- acos( dot(b,vertexNormal) / norm(b) );
-		double dFactor = it->reference->angle / it->angle;
-		if ( dFactor < 1.0 )
-			dFactor = - 1.0 * it->angle / it->reference->angle;
-		dFactor *= dTemplateWeight;
-		it->reference->force += it->reference->normal * dFactor;
-//alog << "Template force strength is " << factor << endl;
-	}
+  }
+	if ( norm( innerForce ) > numeric_limits<double>::epsilon() )
+		return innerForce;
+	return TVector2D( 0.0 );
+}
+
+/**
+ * \param actv particle to compute the force for
+ * \returns interpolated external force in normal direction
+ */
+TVector2D CParticleSnake::externalForce( const SParticle& actv ) const
+{
+	const TVector2D& pos = actv.position;
+	TVector2D ro, ru, lo, lu;
+	double rol, rul, lol, lul;
+  ro[0] = static_cast<int>( ceil( pos[0] ) );  ro[1] = static_cast<int>( floor( pos[1] ) );
+	ru[0] = static_cast<int>( ceil( pos[0] ) );  ru[1] = static_cast<int>( ceil( pos[1] ) );
+  lo[0] = static_cast<int>( floor( pos[0] ) ); lo[1] = static_cast<int>( floor( pos[1] ) );
+	lu[0] = static_cast<int>( floor( pos[0] ) ); lu[1] = static_cast<int>( ceil( pos[1] ) );
+  rul = sqrt(2.0) - norm( ru - pos );
+	rol = sqrt(2.0) - norm( ro - pos );
+  lul = sqrt(2.0) - norm( lu - pos );
+	lol = sqrt(2.0) - norm( lo - pos );
+  double sum = rol + rul + lul + lol;
+	TVector2D eforce =
+  	( rol /sum ) * (*externalForceFieldPtr)( static_cast<ushort>( ro[0] ), static_cast<ushort>( ro[1] ) )
+    + ( rul /sum ) * (*externalForceFieldPtr)( static_cast<ushort>( ru[0] ), static_cast<ushort>( ru[1] ) )
+	  + ( lol /sum ) * (*externalForceFieldPtr)( static_cast<ushort>( lo[0] ), static_cast<ushort>( lo[1] ) )
+  	+ ( lul /sum ) * (*externalForceFieldPtr)( static_cast<ushort>( lu[0] ), static_cast<ushort>( lu[1] ) );
+  if ( bNormalize )
+  	eforce /= norm(eforce);
+  return dot(actv.normal,eforce) * actv.normal;
+}
+
+/**
+ * \param actv reference particle to compute the force for. Its angle is updated
+ * \returns template force
+ */
+TVector2D CParticleSnake::templateForce( SParticle& actv ) const
+{
+	const size_t t = actv.reference;
+	const size_t templateCount = templateVec.size();
+	const SParticle& last = vertexVec[templateVec[( t + templateCount - 1 ) % templateCount].reference];
+	const SParticle& next = vertexVec[templateVec[( t + 1 ) % templateCount].reference];
+	TVector2D a = actv.position - last.position;
+	TVector2D b = next.position - actv.position;
+	TVector2D n1( -a[1], a[0] ); 
+	TVector2D n2( -b[1], b[0] ); 
+	TVector2D vertexNormal( n1 + n2 );
+	vertexNormal /= norm( vertexNormal );			
+	actv.angle = 2 * M_PI - acos( dot( a * - 1.0, vertexNormal ) / norm( a ) )
+		- acos( dot(b,vertexNormal) / norm(b) );
+	double dFactor = actv.angle / templateVec[t].angle;
+	if ( dFactor < 1.0 )
+		dFactor = - 1.0 * templateVec[t].angle / actv.angle;
+	dFactor *= dTemplateWeight;
+	return actv.normal * dFactor;
 }
 
 void CParticleSnake::checkStability()
@@ -548,9 +623,9 @@ void CParticleSnake::updateSnake()
 {
 	ulStableNodes = 0;
 	dMeanForce = 0.0;
-	TPartIterator listEnd = vertexList.end();
+	TPartIterator listEnd = vertexVec.end();
 	double actForce = 0.0;
-	for ( TPartIterator actv = vertexList.begin(); actv != listEnd; ++actv )
+	for ( TPartIterator actv = vertexVec.begin(); actv != listEnd; ++actv )
 	{
 		//cerr << norm( actv->force ) << " - " << actForce << endl;
 		if ( actv->stability != -1 && norm( actv->force ) > actForce )
@@ -558,7 +633,7 @@ void CParticleSnake::updateSnake()
 	}
 	if ( actForce < 0.00001 ) actForce = 1.0;
 	cerr << "Localized timestep is " << 1.0/actForce << endl;
-	for ( TPartIterator actv = vertexList.begin(); actv != listEnd; ++actv )
+	for ( TPartIterator actv = vertexVec.begin(); actv != listEnd; ++actv )
 	{
 		if ( actv->stability != -1 )
 		{
@@ -602,7 +677,7 @@ void CParticleSnake::updateSnake()
 		}		
 		actv->force = 0.0;
 	}
-	if ( ( dMeanForce / static_cast<double>( vertexList.size() ) ) > 0.075 ) 
+	if ( ( dMeanForce / static_cast<double>( vertexVec.size() ) ) > 0.075 ) 
 		bStable = false;
 	else 
 		bStable = true;
@@ -610,59 +685,47 @@ void CParticleSnake::updateSnake()
 
 void CParticleSnake::generateInitialContour( TField2DPtr polygon )
 {
-	vertexList.clear();
-	templateList.clear();
+	vertexVec.clear();
+	templateVec.clear();
 	TField2D& initialField = (*polygon);
+	vertexVec.reserve( initialField.getArraySize() );
   for ( TField2D::iterator it = initialField.begin(); it != initialField.end(); ++it )
   {		
 //cerr << *it << endl;
     SParticle newVertex;
     newVertex.position = *it;
 		newVertex.oldpos = 0.0;
-		if ( dTemplateWeight > 0.0 )
-			newVertex.isReference = true;
+		newVertex.isReference = ( dTemplateWeight > 0.0 );
+		newVertex.reference = -1;
+		newVertex.angle = 0.0;
 		newVertex.stability = 0;
 		newVertex.force = 0.0;
-		vertexList.push_back( newVertex );
+		vertexVec.push_back( newVertex );
 		if ( dTemplateWeight > 0.0 )
 		{
-			templateList.push_back( newVertex );
-			vertexList.back().reference = &templateList.back();
-			templateList.back().reference = &vertexList.back();
+			newVertex.reference = vertexVec.size() - 1;
+			templateVec.push_back( newVertex );
+			vertexVec.back().reference = templateVec.size() - 1;
 		}
 	}
 	if ( dTemplateWeight > 0.0 )
 	{
-		for( TPartIterator it = templateList.begin(); it != templateList.end(); ++it )
+		const size_t templateCount = templateVec.size();
+		for( size_t i = 0; i < templateCount; ++i )
 		{
-			TPartIterator next;	next = it; ++next;
-			TPartIterator last;	
-			if ( it == templateList.begin() )
-			{
-				last = templateList.end();
-				--last;
-			}
-			else
-			{			
-				last = it; 
-				--last;
-			}
-			
-			if ( next == templateList.end() )
-			{
-				next = templateList.begin();	
-			}
-			
-			TVector2D a = it->position - last->position;
-			TVector2D b = next->position - it->position;
+			SParticle& actv = templateVec[i];
+			const SParticle& last = templateVec[( i + templateCount - 1 ) % templateCount];
+			const SParticle& next = templateVec[( i + 1 ) % templateCount];
+			TVector2D a = actv.position - last.position;
+			TVector2D b = next.position - actv.position;
 			TVector2D n1( -a[1], a[0] ); 
 			TVector2D n2( -b[1], b[0] ); 
 			TVector2D vertexNormal( n1 + n2 );
 			vertexNormal /= norm( vertexNormal );			
-			it->angle = 2 * M_PI - acos( dot ( a * - 1.0, vertexNormal ) / norm( a ) )
+			actv.angle = 2 * M_PI - acos( dot ( a * - 1.0, vertexNormal ) / norm( a ) )
 				- acos( dot( b, vertexNormal ) / norm( b ) );						
 		}
-		for( TPartIterator it = templateList.begin(); it != templateList.end(); ++it )
+		for( TPartIterator it = templateVec.begin(); it != templateVec.end(); ++it )
 		{
 			alog << it->position << " --- " << it->angle << endl;
 		}
@@ -670,7 +733,7 @@ void CParticleSnake::generateInitialContour( TField2DPtr polygon )
 }
 
 /** \param polygon old model polygon to be refined */
-void CParticleSnake::generateNewContour( std::list<SParticle>& polygon )
+void CParticleSnake::generateNewContour( std::vector<SParticle>& polygon )
 {
 	TPartIterator listEnd = polygon.end();
 	for ( TPartIterator actv = polygon.begin();	actv != listEnd; ++actv )
@@ -681,15 +744,6 @@ void CParticleSnake::generateNewContour( std::list<SParticle>& polygon )
 	}
 }
 
-void CParticleSnake::computeBalloonForces()
-{	
-	TPartIterator listEnd = vertexList.end();
-	for ( TPartIterator actv = vertexList.begin(); actv != listEnd; ++actv )
-	{
-		actv->force += actv->normal * dBalloonWeight;
-	}
-}
-
 /**  
  * \param p0 Starting point of first edge
  * \param p1 End point of first edge
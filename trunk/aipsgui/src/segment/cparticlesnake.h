@@ -5,12 +5,13 @@
  *                                                                      *
  * Author: Hendrik Belitz (h.belitz@fz-juelich.de)                      *
  *                                                                      *
- * Version: 0.4                                                         *
+ * Version: 0.5                                                         *
  * Status:  Alpha                                                       *
  * Created: 2004-11-15                                                  *
  * Changed: 2004-12-08 Added balloon forces and intersection solver     *
  *          2004-12-15 Remade representation of internal forces         *
  *          2005-01-20 Added optional mask parameter                    *
+ *          2026-10-17 Particle vector, grid based proximity check      *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -20,6 +21,7 @@
 #ifndef CPARTICLESNAKE_H
 #define CPARTICLESNAKE_H
 
+#include <vector>
 #include <cfilter.h>
 #include <aipsnumeric.h>
  #include <csnakedialog.h>
@@ -39,9 +41,9 @@ struct SParticle
 	TVector2D force;     ///< Force to apply in actual timestep
 	TVector2D oldpos;    ///< Position in last timestep
 	int stability;       ///< Stability counter
-	bool isReference;
-	SParticle* reference;
-	double angle;
+	bool isReference;    ///< Particle is tied to a template vertex and never removed
+	long reference;      ///< Index of the corresponding particle in the other polygon, -1 if none
+	double angle;        ///< Inner angle of the polygon at the particle
 };
 
 /**
@@ -70,18 +72,21 @@ private:
 	void generateInitialContour( TField2DPtr poly );
 	/// Adaptive remeshing scheme
 	void remesh();		
+	/// Appends a particle to the remeshed polygon
+	void keepParticle( const SParticle& aParticle, std::vector<SParticle>& remeshedVec );
 	/// Heuristic for intersection avoidance
 	void checkProximity();
-	/// Calculate all contour normals
-	void calculateNormals();
-	/// Computes the internal forces
-	void computeInternalForces();
-	/// Interpolation of external forces
-	void computeExternalForces();		
-	/// Computation of balloon forces
-	void computeBalloonForces();
-	/// Computation of template forces
-	void computeTemplateForces();
+	/// Computes normals and all forces except intersection avoidance
+	void computeForces();
+	/// Calculate contour normal and curvature of a particle
+	void calculateNormal( SParticle& actv, const SParticle& predecessor, const SParticle& successor );
+	/// Computes the internal force of a particle
+	TVector2D internalForce( SParticle& actv, const SParticle& predecessor,
+		const SParticle& successor ) const;
+	/// Interpolation of the external force of a particle
+	TVector2D externalForce( const SParticle& actv ) const;
+	/// Computation of the template force of a reference particle
+	TVector2D templateForce( SParticle& actv ) const;
 	/// Checks for particle stability
 	void checkStability();		
 	/// Updates the whole model
@@ -89,7 +94,7 @@ private:
 	/// Display the actual state of the model
 	void displaySnake();
 	/// Generates a new contour model for the next multiscale step
-	void generateNewContour( std::list<SParticle>& polygon );
+	void generateNewContour( std::vector<SParticle>& polygon );
 	/// Computes the minimal distance of two edges
 	TVector2D edgeDistance( const TVector2D& p0, const TVector2D& p1, 
 		const TVector2D& q0, const TVector2D& q1 );	
@@ -100,10 +105,10 @@ private:
 	int iHeight;                               ///< Input image height
 	boost::shared_ptr<CSnakeDialog> theDialog; ///< Associated model dialog
 	
-	typedef std::list<SParticle> TPartList;
-	typedef std::list<SParticle>::iterator TPartIterator;
-	TPartList vertexList;   ///< List of all model particles
-	TPartList templateList;   ///< List of all template polygon vertices
+	typedef std::vector<SParticle> TPartList;
+	typedef std::vector<SParticle>::iterator TPartIterator;
+	TPartList vertexVec;    ///< All model particles in polygon order
+	TPartList templateVec;  ///< All template polygon vertices
 	TField2DPtr externalForceFieldPtr; ///< Pointer to external forcefield
 	TImagePtr maskPtr;                 ///< Pointer to image mask
 	bool bStop;                        ///< Use to signal a computation stop
@@ -46,7 +46,6 @@ CPipelineItem* CRegionGrowing::newInstance( ulong ulID ) const throw()
 void CRegionGrowing::apply() throw()
 {
 FBEGIN;
-cerr << "Begin CRegionGrowing" << endl;
 	bModuleReady = false;
   TImagePtr inputPtr = static_pointer_cast<TImage>( getInput() );
   if ( !checkInput<TImage>(inputPtr, 2, 3, 1, 1 ) )
@@ -58,7 +57,6 @@ cerr << "Begin CRegionGrowing" << endl;
   TField3DPtr seedPointsPtr3D;
   if ( getInput(1).get() )
   {
-  	cerr << getInput(1)->getType().name() << endl;
   if ( getInput(1)->getType() == typeid( TVector2D ) )
   	seedPointsPtr = static_pointer_cast<TField2D>( getInput(1) );
   else if ( inputPtr->getDimension() == 3 )
@@ -81,6 +79,11 @@ cerr << "Begin CRegionGrowing" << endl;
 		(*seedPointsPtr)(0)[0] = 0;//inputPtr->getExtent(0)/2;
 		(*seedPointsPtr)(0)[1] = 0;//inputPtr->getExtent(1)/2;
 	}
+	if ( seedPointsPtr.get() == NULL && seedPointsPtr3D.get() == NULL )
+	{
+		alog << LWARN << "Seed points do not match the image dimension" << endl;
+		return;
+	}
 	
 	bModuleReady = true;
   // Initialize fields
@@ -89,104 +92,42 @@ cerr << "Begin CRegionGrowing" << endl;
   	dims.push_back( inputPtr->getExtent(i) );
   	
   TImagePtr outputPtr ( new TImage( dims.size(), dims ) );
-  (*outputPtr) = 0;
-cerr << " Setting seed points" << endl;
-  // Set the seedPointsPtr points
+
+  // Collect the seed points as linear indices. 3D seeds are given with the y axis flipped
+	const size_t width = inputPtr->getExtent( 0 );
+	const size_t height = inputPtr->getExtent( 1 );
+	const size_t depth = ( inputPtr->getDimension() == 3 ) ? inputPtr->getExtent( 2 ) : 1;
+	vector<size_t> seedVec;
   if ( seedPointsPtr.get() )
 	  for ( TField2D::iterator it = seedPointsPtr->begin(); it != seedPointsPtr->end(); ++it )
 		{
-			TPoint3D p( static_cast<short>((*it)[0]), static_cast<short>((*it)[1]), 0 );
-			(*outputPtr)( p[0], p[1] ) = 1;
-			work.push(p);
+			const long x = static_cast<long>( (*it)[0] );
+			const long y = static_cast<long>( (*it)[1] );
+			if ( x >= 0 && y >= 0 && x < static_cast<long>( width ) && y < static_cast<long>( height ) )
+				seedVec.push_back( y * width + x );
 		}
 	else
 	  for ( TField3D::iterator it = seedPointsPtr3D->begin(); it != seedPointsPtr3D->end(); ++it )
 		{
-			TPoint3D p( static_cast<short>((*it)[0]), inputPtr->getExtent(1)-1-static_cast<short>((*it)[1]), static_cast<short>((*it)[2]) );
-			(*outputPtr)( p[0], inputPtr->getExtent(1)-1-p[1], p[2] ) = 1;
-			work.push(p);
+			const long x = static_cast<long>( (*it)[0] );
+			const long y = static_cast<long>( height ) - 1 - static_cast<long>( (*it)[1] );
+			const long z = static_cast<long>( (*it)[2] );
+			if ( x >= 0 && y >= 0 && z >= 0 && x < static_cast<long>( width )
+				&& y < static_cast<long>( height ) && z < static_cast<long>( depth ) )
+				seedVec.push_back( ( z * height + y ) * width + x );
 		}
+	if ( seedVec.size() < ( seedPointsPtr.get() ? seedPointsPtr->getArraySize() : seedPointsPtr3D->getArraySize() ) )
+		alog << LWARN << "Seed points outside of the image were ignored" << endl;
 
 	ulRegionThreshold = parameters.getUnsignedLong( "RegionThreshold" );
-//  ulong ulTimestep = 0; 
-cerr << " Computing area" << endl;
-  // Computation loop  
-  while( !work.empty() )
-  {
-    TPoint3D p = work.front(); work.pop();
-		if ( inputPtr->getDimension() == 2 )
-		{
-			if ( ( p[0] > 0 )
-			  && ( (*outputPtr)( p[0]-1, p[1] ) == 0 )
-				&& ( static_cast<ulong>(std::abs((*inputPtr)( p[0]-1, p[1])-(*inputPtr)( p[0], p[1])))<=ulRegionThreshold ) )
-				{
-					work.push( TPoint3D( p[0]-1, p[1], 0 ) ); (*outputPtr)( p[0]-1, p[1] ) = 1;
-				}
-			if ( ( p[0] < static_cast<long>(inputPtr->getExtent(0)-1) )
-			  && ( (*outputPtr)( p[0]+1, p[1] ) == 0 )
-				&& ( static_cast<ulong>(std::abs((*inputPtr)( p[0]+1, p[1])-(*inputPtr)( p[0], p[1])))<=ulRegionThreshold ) )
-				{
-					work.push( TPoint3D( p[0]+1, p[1], 0 ) ); (*outputPtr)( p[0]+1, p[1] ) = 1;
-				}
-			if ( ( p[1] > 0 )
-		  	&& ( (*outputPtr)( p[0], p[1]-1 ) == 0 )
-				&& ( static_cast<ulong>(std::abs((*inputPtr)( p[0], p[1]-1)-(*inputPtr)( p[0], p[1])))<=ulRegionThreshold ) )
-				{
-					work.push( TPoint3D( p[0], p[1]-1, 0 ) ); (*outputPtr)( p[0], p[1]-1 ) = 1;
-				}
-			if ( ( p[1] < static_cast<long>(inputPtr->getExtent(1)-1) )
-			  && ( (*outputPtr)( p[0], p[1]+1 ) == 0 )
-				&& ( static_cast<ulong>(std::abs((*inputPtr)( p[0], p[1]+1)-(*inputPtr)( p[0], p[1])))<=ulRegionThreshold ) )
-				{
-					work.push( TPoint3D( p[0], p[1]+1, 0 ) ); (*outputPtr)( p[0], p[1]+1 ) = 1;
-				}
-		}
-		else
-		{
-			if ( ( p[0] > 0 )
-			  && ( (*outputPtr)( p[0]-1, p[1], p[2] ) == 0 )
-				&& ( static_cast<ulong>( std::abs( (*inputPtr)( p[0]-1, p[1], p[2])
-					- (*inputPtr)( p[0], p[1], p[2]) ) ) <= ulRegionThreshold ) )
-				{
-					work.push( TPoint3D( p[0]-1, p[1], p[2] ) ); (*outputPtr)( p[0]-1, p[1], p[2] ) = 1;
-				}
-			if ( ( p[0] < static_cast<long>(inputPtr->getExtent(0)-1) )
-			  && ( (*outputPtr)( p[0]+1, p[1], p[2] ) == 0 )
-				&& ( static_cast<ulong>( std::abs((*inputPtr)( p[0]+1, p[1], p[2])-(*inputPtr)( p[0], p[1], p[2])))<=ulRegionThreshold ) )
-				{
-					work.push( TPoint3D( p[0]+1, p[1], p[2] ) ); (*outputPtr)( p[0]+1, p[1], p[2] ) = 1;
-				}
-			if ( ( p[1] > 0 )
-			  && ( (*outputPtr)( p[0], p[1]-1, p[2] ) == 0 )
-				&& ( static_cast<ulong>(std::abs((*inputPtr)( p[0], p[1]-1, p[2])-(*inputPtr)( p[0], p[1], p[2])))<=ulRegionThreshold ) )
-				{
-					work.push( TPoint3D( p[0], p[1]-1, p[2] ) ); (*outputPtr)( p[0], p[1]-1, p[2] ) = 1;
-				}
-			if ( ( p[1] < static_cast<long>(inputPtr->getExtent(1)-1) )
-			  && ( (*outputPtr)( p[0], p[1]+1, p[2] ) == 0 )
-				&& ( static_cast<ulong>(std::abs((*inputPtr)( p[0], p[1]+1, p[2])-(*inputPtr)( p[0], p[1], p[2])))<=ulRegionThreshold ) )
-				{
-					work.push( TPoint3D( p[0], p[1]+1, p[2] ) ); (*outputPtr)( p[0], p[1]+1, p[2] ) = 1;
-				}
-			if ( ( p[2] > 0 )
-			  && ( (*outputPtr)( p[0], p[1], p[2]-1 ) == 0 )
-				&& ( static_cast<ulong>(std::abs((*inputPtr)( p[0], p[1], p[2]-1 ) - (*inputPtr)( p[0], p[1], p[2])))<=ulRegionThreshold ) )
-				{
-					work.push( TPoint3D( p[0], p[1], p[2]-1 ) ); (*outputPtr)( p[0], p[1], p[2]-1 ) = 1;
-				}
-			if ( ( p[2] < static_cast<long>(inputPtr->getExtent(2)-1) )
-			  && ( (*outputPtr)( p[0], p[1], p[2]+1 ) == 0 )
-				&& ( static_cast<ulong>(std::abs((*inputPtr)( p[0], p[1], p[2]+1 ) - (*inputPtr)( p[0], p[1], p[2])))<=ulRegionThreshold ) )
-				{
-					work.push( TPoint3D( p[0], p[1], p[2]+1 ) ); (*outputPtr)( p[0], p[1], p[2]+1 ) = 1;
-				}
-		}
- 	}
+	CScanlineFill<TImage::TDataType> theFill( &(*inputPtr)[0], dims,
+		static_cast<double>( ulRegionThreshold ) );
+	CBitMask region( dims );
+	theFill.fill( seedVec, region );
+	region.toArray<TImage::TDataType>( &(*outputPtr)[0], 0, 1 );
+
 	outputPtr->setMinimum( 0 );
   outputPtr->setMaximum( 1 );
   setOutput( outputPtr );
-cerr << "End CRegionGrowing" << endl;	
 FEND;
 }
-
-
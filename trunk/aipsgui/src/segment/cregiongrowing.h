@@ -21,18 +21,21 @@
 #ifndef CREGIONGROWING_H
 #define CREGIONGROWING_H
 
-#include <queue>
-
 // AIPS includes
 #include <cfilter.h>
 #include <aipsnumeric.h>
+#include <cscanlinefill.h>
 
 // lib includes
 #include "libid.h"
 
 using namespace aips;
 
-/** A region growing algorithm with a randomized component */
+/**
+ * A region growing algorithm. Neighbouring voxels whose values differ by at
+ * most RegionThreshold are joined. All seeds are grown at once by
+ * CScanlineFill.
+ */
 class CRegionGrowing : public CFilter
 {
 private:
@@ -59,7 +62,6 @@ public:
     throw();
 private:
 	ulong ulRegionThreshold;	
-	std::queue<TPoint3D> work;
 };
 
 #endif
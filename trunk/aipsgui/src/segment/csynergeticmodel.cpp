@@ -15,11 +15,327 @@
 
 #include "csynergeticmodel.h"
 
+// Standard includes
+#include <algorithm>
+#include <vector>
+
+// Boost includes
+#include <boost/cstdint.hpp>
+
+// AIPS includes
+#include <aipsparallel.h>
+
 using namespace std;
 using namespace boost;
 
+namespace
+{
+
+/// State of region cells
+const short stableState = 255;
+/// Number of slices of a slab
+const size_t slabThickness = 8;
+
+/**
+ * Data of one slab during a sweep. Only the worker sweeping the slab
+ * modifies it.
+ */
+struct SSlab
+{
+	size_t firstSlice;            ///< First slice of the slab
+	size_t lastSlice;             ///< Slice behind the slab
+	vector<size_t> touchedVec;    ///< Cells whose next state was written in this sweep
+	ulong ulChangedCells;         ///< Cells that became region cells
+	ulong ulChaoticCells;         ///< Cells that grew or stayed chaotic
+	boost::uint64_t randomState;  ///< State of the random number generator
+
+	/// Returns a uniformly distributed random number in (0,1] (Park and Miller)
+	double random()
+	{
+		randomState = ( randomState * 48271ULL ) % 2147483647ULL;
+		return static_cast<double>( randomState ) / 2147483647.0;
+	}
+};
+
+/**
+ * The cellular automaton. Cells are 0 (empty), stableState (region),
+ * deadState (chaotic cells whose time to live ran out) or lie in between
+ * (chaotic cells).
+ *
+ * A sweep visits the active cells of each slab in the order of their
+ * indices and writes the next states into nextVec, remembering the written
+ * cells in the write log of the slab. Cells becoming region cells are
+ * changed at once, as in the classic full sweep. After the sweep the logs
+ * are applied to the lattice. Cells that are known to stay unchanged are
+ * never visited:
+ * - empty cells, which only change through their neighbours
+ * - region cells whose neighbours are region cells or cells they cannot
+ *   grow into
+ * - dead cells whose neighbourhood did not gain region cells since their
+ *   last visit
+ */
+struct SAutomaton
+{
+	const short* inputPtr;      ///< Image intensities
+	short* currentPtr;          ///< Actual cell states
+	vector<short> nextVec;      ///< Next cell states, 0 if not written in this sweep
+	vector<char> activeVec;     ///< Cells to visit in this sweep
+	vector<char> activeNextVec; ///< Cells to visit in the next sweep
+	vector<char> rowVec;        ///< Rows holding cells to visit in this sweep
+	vector<char> rowNextVec;    ///< Rows holding cells to visit in the next sweep
+	vector<SSlab> slabVec;      ///< Slabs of the lattice
+	size_t extentArr[3];        ///< Lattice extents, 1 for missing dimensions
+	bool b3D;                   ///< Use 6-neighbourhoods and cubic windows
+	short deadState;            ///< State of dead cells
+	long lRegionThreshold;      ///< Largest intensity difference for static growth
+	double dGrowChance;         ///< Chance of chaotic growth
+	double dStableLimit;        ///< Chaotic cells with more region cells nearby become stable
+	double dReactivationLimit;  ///< Dead cells with at least this many region cells nearby become stable
+
+	/// Marks a cell to be visited in the next sweep
+	void markNext( const size_t c )
+	{
+		activeNextVec[c] = 1;
+		rowNextVec[c / extentArr[0]] = 1;
+	}
+	/// Marks a cell to be visited as soon as possible
+	void markLater( const SSlab& aSlab, const size_t current, const size_t c )
+	{
+		if ( c > current && c / ( extentArr[0] * extentArr[1] ) < aSlab.lastSlice )
+		{
+			activeVec[c] = 1;
+			rowVec[c / extentArr[0]] = 1;
+		}
+		else
+			markNext( c );
+	}
+	/// Writes the next state of a cell
+	void write( SSlab& aSlab, const size_t c, const short state )
+	{
+		if ( nextVec[c] == 0 )
+			aSlab.touchedVec.push_back( c );
+		nextVec[c] = state;
+	}
+	/// Returns the face neighbours of a cell in the order -x, +x, -y, +y, -z, +z
+	size_t getNeighbours( const size_t c, size_t* neighbourArr ) const
+	{
+		const size_t sliceSize = extentArr[0] * extentArr[1];
+		const size_t x = c % extentArr[0];
+		const size_t y = ( c / extentArr[0] ) % extentArr[1];
+		const size_t z = c / sliceSize;
+		size_t count = 0;
+		if ( x > 0 ) neighbourArr[count++] = c - 1;
+		if ( x + 1 < extentArr[0] ) neighbourArr[count++] = c + 1;
+		if ( y > 0 ) neighbourArr[count++] = c - extentArr[0];
+		if ( y + 1 < extentArr[1] ) neighbourArr[count++] = c + extentArr[0];
+		if ( z > 0 ) neighbourArr[count++] = c - sliceSize;
+		if ( z + 1 < extentArr[2] ) neighbourArr[count++] = c + sliceSize;
+		return count;
+	}
+	/// Returns the window of the given radius around a cell, clipped to the lattice
+	void getWindow( const size_t c, const size_t radius, size_t* lowerArr, size_t* upperArr ) const
+	{
+		const size_t positionArr[] = { c % extentArr[0], ( c / extentArr[0] ) % extentArr[1],
+			c / ( extentArr[0] * extentArr[1] ) };
+		for( unsigned short d = 0; d < 3; ++d )
+		{
+			const size_t r = ( d < 2 || b3D ) ? radius : 0;
+			lowerArr[d] = ( positionArr[d] > r ) ? positionArr[d] - r : 0;
+			upperArr[d] = std::min( positionArr[d] + r, extentArr[d] - 1 );
+		}
+	}
+	/// Returns the number of region cells around a cell, minus one
+	size_t countStable( const size_t c, const size_t radius ) const
+	{
+		size_t lowerArr[3], upperArr[3];
+		getWindow( c, radius, lowerArr, upperArr );
+		size_t count = 0;
+		for( size_t z = lowerArr[2]; z <= upperArr[2]; ++z )
+			for( size_t y = lowerArr[1]; y <= upperArr[1]; ++y )
+			{
+				const short* rowPtr = currentPtr + ( z * extentArr[1] + y ) * extentArr[0];
+				for( size_t x = lowerArr[0]; x <= upperArr[0]; ++x )
+					if ( rowPtr[x] == stableState )
+						++count;
+			}
+		return ( count > 0 ) ? count - 1 : 0;
+	}
+	/// Schedules the dead cells near a cell which just became a region cell
+	void wakeDeadCells( SSlab* slabPtr, const size_t c )
+	{
+		size_t lowerArr[3], upperArr[3];
+		getWindow( c, 2, lowerArr, upperArr );
+		for( size_t z = lowerArr[2]; z <= upperArr[2]; ++z )
+			for( size_t y = lowerArr[1]; y <= upperArr[1]; ++y )
+				for( size_t x = lowerArr[0]; x <= upperArr[0]; ++x )
+				{
+					const size_t w = ( z * extentArr[1] + y ) * extentArr[0] + x;
+					if ( currentPtr[w] != deadState )
+						continue;
+					if ( slabPtr != NULL )
+						markLater( *slabPtr, c, w );
+					else
+						markNext( w );
+				}
+	}
+	/// Lets an empty cell grow chaotically with the given chance
+	void chaoticGrowth( SSlab& aSlab, const size_t c, const short state )
+	{
+		if ( nextVec[c] != 0 )
+			return;
+		if ( aSlab.random() <= dGrowChance )
+		{
+			write( aSlab, c, std::max( state, deadState ) );
+			++aSlab.ulChaoticCells;
+		}
+	}
+	/// Computes the next state of a cell
+	void updateCell( SSlab& aSlab, const size_t c )
+	{
+		short& state = currentPtr[c];
+		size_t neighbourArr[6];
+		const size_t neighbourCount = getNeighbours( c, neighbourArr );
+		if ( state == stableState )
+		{
+			// Grow into homogenous neighbours, chaotically into the other empty ones
+			bool bActive = false;
+			for( size_t i = 0; i < neighbourCount; ++i )
+			{
+				const size_t n = neighbourArr[i];
+				if ( currentPtr[n] == stableState )
+					continue;
+				if ( inputPtr[n] >= inputPtr[c] - lRegionThreshold && inputPtr[n] <= inputPtr[c] + lRegionThreshold )
+				{
+					write( aSlab, n, stableState );
+					++aSlab.ulChangedCells;
+					bActive = true;
+				}
+				else if ( currentPtr[n] == 0 )
+				{
+					chaoticGrowth( aSlab, n, stableState - 1 );
+					bActive = true;
+				}
+			}
+			if ( bActive )
+				markNext( c );
+		}
+		else if ( state > deadState )
+		{
+			// Chaotic cell: become stable or grow further and lose time to live
+			if ( static_cast<double>( countStable( c, 1 ) ) > dStableLimit )
+			{
+				write( aSlab, c, stableState );
+				state = stableState;
+				++aSlab.ulChangedCells;
+				markNext( c );
+				wakeDeadCells( &aSlab, c );
+			}
+			const short growState = state - 1;
+			for( size_t i = 0; i < neighbourCount; ++i )
+				if ( currentPtr[neighbourArr[i]] == 0 )
+					chaoticGrowth( aSlab, neighbourArr[i], growState );
+			if ( state != stableState )
+			{
+				write( aSlab, c, state - 1 );
+				++aSlab.ulChaoticCells;
+			}
+		}
+		else if ( state == deadState && nextVec[c] != 0 )
+		{
+			// Already reactivated by a neighbour, which may leave it dead
+			markNext( c );
+		}
+		else if ( state == deadState )
+		{
+			// Dead cell: reactivate it and its dead neighbours if the region is near
+			write( aSlab, c, state );
+			if ( static_cast<double>( countStable( c, 2 ) ) >= dReactivationLimit )
+			{
+				write( aSlab, c, stableState );
+				state = stableState;
+				for( size_t i = 0; i < neighbourCount; ++i )
+					if ( currentPtr[neighbourArr[i]] == deadState )
+						write( aSlab, neighbourArr[i], stableState - 1 );
+				++aSlab.ulChangedCells;
+				markNext( c );
+				wakeDeadCells( &aSlab, c );
+			}
+		}
+	}
+	/// Visits the active cells of a slab
+	void sweepSlab( SSlab& aSlab )
+	{
+		for( size_t r = aSlab.firstSlice * extentArr[1]; r < aSlab.lastSlice * extentArr[1]; ++r )
+		{
+			if ( !rowVec[r] )
+				continue;
+			for( size_t c = r * extentArr[0]; c < ( r + 1 ) * extentArr[0]; ++c )
+				if ( activeVec[c] )
+				{
+					activeVec[c] = 0;
+					updateCell( aSlab, c );
+				}
+			rowVec[r] = 0;
+		}
+	}
+	/**
+	 * Applies the write logs and schedules the next sweep.
+	 * \param ulChangedCells receives the number of cells that became region cells
+	 * \param ulChaoticCells receives the number of chaotic cells
+	 */
+	void finishSweep( ulong& ulChangedCells, ulong& ulChaoticCells )
+	{
+		ulChangedCells = ulChaoticCells = 0;
+		vector<size_t> stabilizedVec;
+		for( vector<SSlab>::iterator it = slabVec.begin(); it != slabVec.end(); ++it )
+		{
+			for( vector<size_t>::const_iterator cit = it->touchedVec.begin(); cit != it->touchedVec.end(); ++cit )
+			{
+				const short oldState = currentPtr[*cit];
+				const short newState = nextVec[*cit];
+				currentPtr[*cit] = newState;
+				nextVec[*cit] = 0;
+				if ( newState == stableState && oldState != stableState )
+				{
+					markNext( *cit );
+					stabilizedVec.push_back( *cit );
+				}
+				else if ( newState != stableState && ( newState > deadState || oldState != deadState ) )
+					markNext( *cit );
+			}
+			it->touchedVec.clear();
+			ulChangedCells += it->ulChangedCells;
+			ulChaoticCells += it->ulChaoticCells;
+			it->ulChangedCells = it->ulChaoticCells = 0;
+		}
+		for( vector<size_t>::const_iterator it = stabilizedVec.begin(); it != stabilizedVec.end(); ++it )
+			wakeDeadCells( NULL, *it );
+		activeVec.swap( activeNextVec );
+		rowVec.swap( rowNextVec );
+	}
+};
+
+/**
+ * Sweep of either the even or the odd slabs, shared by all workers. Slabs
+ * are at least eight slices thick, so slabs of the same parity never touch
+ * the same cells.
+ */
+struct SSweep
+{
+	SAutomaton* automatonPtr;
+	size_t parity;
+
+	void range( const size_t first, const size_t last ) const
+	{
+		for( size_t i = first; i < last; ++i )
+			automatonPtr->sweepSlab( automatonPtr->slabVec[2 * i + parity] );
+	}
+};
+
+}
+
 CSynergeticModel::CSynergeticModel( ulong ulID ) throw()
-  : CFilter( ulID, "Synergetic region growing", 2, 1, "CSynergeticModel", "0.2", "CFilter" )
+  : CFilter( ulID, "Synergetic region growing", 2, 1, "CSynergeticModel", "0.3", "CFilter" )
 {
   sModuleID = getClassName() + "/" + getClassVersion() + "/" + sLibID;
   
@@ -29,10 +345,11 @@ CSynergeticModel::CSynergeticModel( ulong ulID ) throw()
   parameters.initUnsignedLong( "TimeToLive", 1, 1, 254 );
   parameters.initDouble( "ReactivationStability", 1.5, 0.0, 10.0 );
 	parameters.initUnsignedLong( "ShowEveryIteration", 0, 0, 1000 );
+	parameters.initUnsignedLong( "RandomSeed", 0, 0, 2147483646 );
 
-  inputsVec[0].portType = IO2DInteger;
+  inputsVec[0].portType = IOInteger;
   inputsVec[1].portType = IO1DVector;
-  outputsVec[0].portType = IO2DInteger;
+  outputsVec[0].portType = IOInteger;
 
 /* HB 28-06-05 */
 /*theDialog.reset( new CSynergeticModelDialog );
@@ -48,49 +365,113 @@ CPipelineItem* CSynergeticModel::newInstance( ulong ulID ) const throw()
   return new CSynergeticModel( ulID );
 }
 
+/** \returns false if the random number generator is seeded from the clock */
+bool CSynergeticModel::isDeterministic() const throw()
+{
+	return parameters.getUnsignedLong( "RandomSeed" ) != 0;
+}
+
+/**
+ * Stability and ReactivationStability refer to the 8 and 24 neighbours of
+ * the 3x3 and 5x5 windows of images. For volumes they are scaled to the 26
+ * and 124 neighbours of the cubic windows. A RandomSeed of 0 seeds the
+ * chaotic growth from the clock.
+ */
 void CSynergeticModel::apply() throw()
 {
 
 FBEGIN;
-  srand( time( NULL ) );
 	bModuleReady = false;
   TImagePtr inputPtr = static_pointer_cast<TImage>( getInput() );
-  if ( !checkInput<TImage>(inputPtr, 2, 2, 1, 1 ) )
+  if ( !checkInput<TImage>(inputPtr, 2, 3, 1, 1 ) )
 	{
     return;
 	}
-  TField2DPtr seedPointsPtr = static_pointer_cast<TField2D>( getInput(1) );
-  if ( seedPointsPtr.get() == NULL )//|| seedPointsPtr->getDimension() > 1 )
+	const bool b3D = ( inputPtr->getDimension() == 3 );
+	size_t dims[] = { inputPtr->getExtent(0), inputPtr->getExtent(1), b3D ? inputPtr->getExtent(2) : 1 };
+
+	// Collect the seed points
+	vector<size_t> seedVec;
+	if ( getInput(1).get() != NULL && !b3D && getInput(1)->getType() == typeid( TVector2D ) )
+	{
+		TField2DPtr seedPointsPtr = static_pointer_cast<TField2D>( getInput(1) );
+		for ( TField2D::iterator it = seedPointsPtr->begin(); it != seedPointsPtr->end(); ++it )
+			if ( (*it)[0] >= 0.0 && (*it)[1] >= 0.0 && (*it)[0] < dims[0] && (*it)[1] < dims[1] )
+				seedVec.push_back( static_cast<size_t>( (*it)[1] ) * dims[0] + static_cast<size_t>( (*it)[0] ) );
+	}
+	else if ( getInput(1).get() != NULL && b3D && getInput(1)->getType() == typeid( TVector3D ) )
+	{
+		// 3D seeds are given with the y axis flipped
+		TField3DPtr seedPointsPtr = static_pointer_cast<TField3D>( getInput(1) );
+		for ( TField3D::iterator it = seedPointsPtr->begin(); it != seedPointsPtr->end(); ++it )
+			if ( (*it)[0] >= 0.0 && (*it)[1] >= 0.0 && (*it)[2] >= 0.0
+				&& (*it)[0] < dims[0] && (*it)[1] < dims[1] && (*it)[2] < dims[2] )
+				seedVec.push_back( ( static_cast<size_t>( (*it)[2] ) * dims[1] + dims[1] - 1
+					- static_cast<size_t>( (*it)[1] ) ) * dims[0] + static_cast<size_t>( (*it)[0] ) );
+	}
+	else
 	{
 		alog << LWARN << "No legal seed list" << endl;
     return;
 	}
 	bModuleReady = true;
   // Initialize fields
-  size_t dims[] = { inputPtr->getExtent(0), inputPtr->getExtent(1) };
-  theDialog->initImage( dims[0], dims[1] );
+	if ( theDialog.get() != NULL && !b3D )
+  	theDialog->initImage( dims[0], dims[1] );
   
-  TImagePtr outputPtr ( new TImage( 2, dims ) );
+  TImagePtr outputPtr ( new TImage( inputPtr->getDimension(), dims ) );
   (*outputPtr) = 0;
-  TImage next( 2, dims );
-  next.setMaximum( 255 );
-  next.setMinimum( 0 );
 
-  // Set the seedPointsPtr points
-  for ( TField2D::iterator it = seedPointsPtr->begin(); it != seedPointsPtr->end(); ++it )
-    (*outputPtr)( static_cast<ushort>( (*it)[0] ), static_cast<ushort>( (*it)[1] ) ) = 255;
+	const size_t cellCount = dims[0] * dims[1] * dims[2];
+	const long lTTL = parameters.getUnsignedLong( "TimeToLive" );
+	const ulong ulStability = parameters.getUnsignedLong( "Stability" );
+	SAutomaton theAutomaton;
+	theAutomaton.inputPtr = &(*inputPtr)[0];
+	theAutomaton.currentPtr = &(*outputPtr)[0];
+	theAutomaton.nextVec.resize( cellCount, 0 );
+	theAutomaton.activeVec.resize( cellCount, 0 );
+	theAutomaton.activeNextVec.resize( cellCount, 0 );
+	theAutomaton.rowVec.resize( dims[1] * dims[2], 0 );
+	theAutomaton.rowNextVec.resize( dims[1] * dims[2], 0 );
+	for ( ushort i = 0; i < 3; ++i )
+		theAutomaton.extentArr[i] = dims[i];
+	theAutomaton.b3D = b3D;
+	theAutomaton.deadState = static_cast<short>( stableState - lTTL );
+	theAutomaton.lRegionThreshold = parameters.getUnsignedLong( "RegionThreshold" );
+	theAutomaton.dGrowChance = parameters.getDouble( "ChaoticGrowChance" );
+	theAutomaton.dStableLimit = static_cast<double>( ulStability ) * ( b3D ? 26.0 / 8.0 : 1.0 );
+	theAutomaton.dReactivationLimit = static_cast<double>( ulStability )
+		* parameters.getDouble( "ReactivationStability" ) * ( b3D ? 124.0 / 24.0 : 1.0 );
+
+	// Set the seed points
+	for ( vector<size_t>::const_iterator it = seedVec.begin(); it != seedVec.end(); ++it )
+	{
+		theAutomaton.currentPtr[*it] = stableState;
+		theAutomaton.activeVec[*it] = 1;
+		theAutomaton.rowVec[*it / dims[0]] = 1;
+	}
+
+	// Slabs of at least slabThickness slices, each with its own random numbers
+	ulong ulRandomSeed = parameters.getUnsignedLong( "RandomSeed" );
+	if ( ulRandomSeed == 0 )
+		ulRandomSeed = static_cast<ulong>( time( NULL ) );
+	const size_t slabCount = std::max<size_t>( 1, dims[2] / slabThickness );
+	theAutomaton.slabVec.resize( slabCount );
+	for ( size_t i = 0; i < slabCount; ++i )
+	{
+		SSlab& aSlab = theAutomaton.slabVec[i];
+		aSlab.firstSlice = i * dims[2] / slabCount;
+		aSlab.lastSlice = ( i + 1 ) * dims[2] / slabCount;
+		aSlab.ulChangedCells = aSlab.ulChaoticCells = 0;
+		aSlab.randomState = ( ulRandomSeed + 7919ULL * i ) % 2147483646ULL + 1;
+	}
 
-  dGrowChance = parameters.getDouble( "ChaoticGrowChance" );
-	dInitialGrowChance = parameters.getDouble( "ChaoticGrowChance" );
-	dReactivationStability = parameters.getDouble( "ReactivationStability" );
-	ulong ulStability = parameters.getUnsignedLong( "Stability" );
- 	lTTL = parameters.getUnsignedLong( "TimeToLive" );	
-	ulRegionThreshold = parameters.getUnsignedLong( "RegionThreshold" );
 	ulong showEvery = parameters.getUnsignedLong( "ShowEveryIteration" );
   ulong ulTimestep = 0; 
 	bool bFinished = false;
   ulong ulNoOfIterations = 0;
-//  ulong ulNoOfPixels = 1; double dHomogenity = 0.0;
+	ulong ulChangedCells = 0;
+	ulong ulChaoticCells = 0;
 
   // Computation loop
   while( !bFinished )
@@ -98,70 +479,15 @@ FBEGIN;
     ulNoOfIterations++;
     if ( ulNoOfIterations % 10 == 0 )
       APP_PROC();
-    ulChangedCells = 0;
-    ulChaoticCells = 0;
-    for ( uint y = 0; y < dims[1]; y++ )
-      for ( uint x = 0; x < dims[0]; x ++ )
-      {
-        // 1st case: Cell belongs to region and is stable
-        if ( (*outputPtr)( x, y ) == 255 )
-        {
-          next( x, y ) = 255; // Cell will stay stable in the next step
-          // Add all homogenous neighbors that have cell state zero or initiate dendritic growing
-          addHomogenousNeighbors( x, y, outputPtr, inputPtr, &next );
-        }
-        // 2nd case: Chaotic growing
-        else if ( (*outputPtr)( x, y ) > (255 - lTTL ) )
-        {
-          ushort val = validNeigh(x,y,1,outputPtr,255);
-
-          if ( val > ulStability )
-          {
-            next( x, y ) = 255;
-            (*outputPtr)( x, y ) = 255;
-            ulChangedCells++;
-          }
-
-          addChaoticNeighbors( x, y, outputPtr, inputPtr, &next );
-
-          // If still unstable decrease time to live
-          if ( (*outputPtr)( x, y ) != 255
-            && (*outputPtr)(x,y) > (255 - lTTL ) )
-          {
-            next( x, y ) = (*outputPtr)( x, y ) - 1;
-            ulChaoticCells++;
-          }
-        }
-        // 4th case: Simply copy the cell input
-        else if ( (*outputPtr)( x, y ) == (255 - lTTL)
-          && next(x,y) == 0 )
-        {
-          next( x, y ) = (*outputPtr)( x, y );
-          // Check for stability
-          ulong stable = validNeigh( x, y, 2, outputPtr, 255 );
-          if ( stable >= ulStability * dReactivationStability )
-          {
-            next( x, y ) = 255;
-            (*outputPtr)( x, y ) = 255;
-            // Reactivate all dead neighbors
-            if ( x > 0 && (*outputPtr)( x - 1, y ) == (255 -lTTL) )
-              next( x - 1, y ) = 254;
-            if ( x+1 < dims[0] && (*outputPtr)( x + 1, y ) == (255 -lTTL)
-)
-              next( x + 1, y ) = 254;
-            if ( y > 0 && (*outputPtr)( x, y - 1 ) == (255 -lTTL) )
-              next( x, y - 1 ) = 254;
-            if ( y+1 < dims[1] && (*outputPtr)( x, y + 1 ) == (255 -lTTL)
-)
-              next( x, y + 1 ) = 254;
-            ulChangedCells++;
-          }
-        }
-      }
-    // View actual lattice and clear for next timestep
-    (*outputPtr) = next;
-    next = 0;
-		if ( showEvery > 0 && ( ulNoOfIterations % showEvery ) == 0 )
+		for ( size_t parity = 0; parity < 2; ++parity )
+		{
+			SSweep theSweep;
+			theSweep.automatonPtr = &theAutomaton;
+			theSweep.parity = parity;
+			parallelFor( theSweep, &SSweep::range, ( slabCount + 1 - parity ) / 2 );
+		}
+		theAutomaton.finishSweep( ulChangedCells, ulChaoticCells );
+		if ( theDialog.get() != NULL && !b3D && showEvery > 0 && ( ulNoOfIterations % showEvery ) == 0 )
     	theDialog->setImage( inputPtr, outputPtr, lTTL );
     // Test for convergence
     if ( ulChangedCells == 0 )
@@ -180,113 +506,9 @@ FBEGIN;
 
   }
   outputPtr->setMaximum( 1 );
-  for ( uint y = 0; y < dims[1]; ++y )
-    for ( uint x = 0; x < dims[0]; ++x )
-      if ( (*outputPtr)( x, y ) == 255 )
-        (*outputPtr)( x, y ) = 1;
-      else
-        (*outputPtr)( x, y ) = 0;
+	for ( TImage::iterator it = outputPtr->begin(); it != outputPtr->end(); ++it )
+		(*it) = ( (*it) == stableState ) ? 1 : 0;
   setOutput( outputPtr );
 FEND;
 
 }
-
-bool CSynergeticModel::staticGrowth( short src, short tgt, short &tgtnext, short& ) throw()
-{
-  if ( isInRange( src, tgt, ulRegionThreshold ) )
-  {
-    tgtnext = 255;
-    ulChangedCells++;
-    return true;
-  }
-  return false;
-}
-
-void CSynergeticModel::chaoticGrowth( short source, short target, short &tgtnext,
-  short amount ) throw()
-{
-  if ( tgtnext == 0 )
-  {
-    dGrowChance = static_cast<float>( 255 - ( source - target ) ) / 255.0
-      * dGrowChance;
-    float r = (static_cast<float>(rand())/static_cast<float>(RAND_MAX));
-    if (  r <= dInitialGrowChance )
-    {
-      if ( amount < (255 - lTTL) )
-        amount = (255 - lTTL);
-      tgtnext = amount;
-      ulChaoticCells++;
-    }
-  }
-}
-
-ushort CSynergeticModel::validNeigh( short x, short y, short radius, TImagePtr inputPtr,
-  ushort value )
-{
-  short ax = max( x-radius, 0 );
-  short ex = min( x+radius, inputPtr->getExtent(0)-1 );
-  short ay = max( y-radius, 0 );
-  short ey = min( y+radius, inputPtr->getExtent(1)-1 );
-  ushort val = 0; ushort z = 0;
-  for ( int i = ax; i <= ex; i++ )
-    for ( int j = ay; j <= ey; j++ )
-    {
-      if ( (*inputPtr)(i,j) == value ) val++;
-      z++;
-    }
-  if (val>0) val--;
-  return val;
-}
-
-void CSynergeticModel::addHomogenousNeighbors( ushort x, ushort y, TImagePtr outputPtr,
-TImagePtr inputPtr, TImage* next )
-{
-  if ( x > 0  && (*outputPtr)( x - 1, y ) != 255 )
-    if ( !staticGrowth( (*inputPtr)( x - 1, y ), (*inputPtr)( x, y ),
-      (*next)( x - 1, y ), (*outputPtr)( x - 1, y ) )
-      && (*outputPtr)( x - 1, y ) == 0 && (*next)( x - 1, y ) == 0 )
-      chaoticGrowth( 255, (*inputPtr)( x - 1, y ), (*next)( x - 1, y ), 254 );
-  if ( ( x < inputPtr->getExtent(0) - 1 )
-    && ( (*outputPtr)( x + 1, y ) != static_cast<ushort>(255) ) )
-    if ( !staticGrowth( (*inputPtr)( x + 1, y ), (*inputPtr)( x, y ),
-      (*next)( x + 1, y ), (*outputPtr)( x + 1, y ) )
-      && (*outputPtr)( x + 1, y ) == 0 && (*next)( x + 1, y ) == 0 )
-      chaoticGrowth( 255, (*inputPtr)( x + 1, y ), (*next)( x + 1, y ), 254 );
-  if ( y > 0 && (*outputPtr)( x, y - 1 ) != 255 )
-    if ( !staticGrowth( (*inputPtr)( x, y - 1 ), (*inputPtr)( x, y ),
-      (*next)( x, y - 1 ), (*outputPtr)( x, y - 1 ) )
-      && (*outputPtr)( x, y - 1 ) == 0 && (*next)( x, y - 1 ) == 0 )
-      chaoticGrowth( 255, (*inputPtr)( x, y - 1 ), (*next)( x, y - 1 ), 254 );
-  if ( ( y < inputPtr->getExtent(1) - 1 )
-    && (*outputPtr)( x, y + 1 ) != static_cast<ushort>(255) )
-    if ( !staticGrowth( (*inputPtr)( x, y + 1 ), (*inputPtr)( x, y ),
-      (*next)( x, y + 1 ), (*outputPtr)( x, y + 1 ) )
-      && (*outputPtr)( x, y + 1 ) == 0 && (*next)( x, y + 1 ) == 0 )
-      chaoticGrowth( 255, (*inputPtr)( x, y + 1 ), (*next)( x, y + 1 ), 254 );
-}
-
-void CSynergeticModel::addChaoticNeighbors( ushort x, ushort y, TImagePtr outputPtr,
-TImagePtr inputPtr, TImage* next )
-{
-  if ( x > 0 && (*outputPtr)( x - 1, y ) == 0 && (*next)( x - 1, y ) == 0 )
-    chaoticGrowth( (*inputPtr)( x, y ), (*inputPtr)( x - 1, y ), (*next)( x - 1, y ),
-      (*outputPtr)( x, y ) - 1 );
-  if ( ( x < inputPtr->getExtent(0) - 1 )
-    && (*outputPtr)( x + 1, y ) == 0
-    && (*next)( x + 1, y ) == 0 )
-    chaoticGrowth( (*inputPtr)( x, y ), (*inputPtr)( x + 1, y ), (*next)( x + 1, y ),
-      (*outputPtr)( x, y ) - 1 );
-  if ( y > 0 && (*outputPtr)( x, y - 1 ) == 0 && (*next)( x, y - 1 ) == 0 )
-    chaoticGrowth( (*inputPtr)( x, y ), (*inputPtr)( x, y - 1 ), (*next)( x, y - 1 ),
-      (*outputPtr)( x, y ) - 1 );
-  if ( ( y < inputPtr->getExtent(1) - 1 )
-    && (*outputPtr)( x, y + 1 ) == 0
-    && (*next)( x, y + 1 ) == 0 )
-    chaoticGrowth( (*inputPtr)( x, y ), (*inputPtr)( x, y + 1 ), (*next)( x, y + 1 ),
-      (*outputPtr)( x, y ) - 1 );
-}
-
-bool CSynergeticModel::isInRange( short intensity, short target, short range ) const throw()
-{
-  return ( ( intensity >= ( target - range ) ) && ( intensity <= ( target + range ) ) );
-}
@@ -5,9 +5,11 @@
  *                                                                      *
  * Author: Hendrik Belitz (h.belitz@fz-juelich.de)                      *
  *                                                                      *
- * Version: 0.2                                                         *
+ * Version: 0.3                                                         *
  * Created: 05.11.03                                                    *
  * Changed: 12.02.04 Module now produces correct output                 *
+ *          2026-10-17 Only active cells are updated, added 3D support  *
+ *                     Results are not cached for clock based seeds     *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -36,7 +38,16 @@
 
 using namespace aips;
 
-/** A region growing algorithm with a randomized component */
+/**
+ * A region growing algorithm with a randomized component.
+ *
+ * The region is a cellular automaton. Each sweep visits only the active
+ * cells: chaotic cells, region cells next to cells they may still grow
+ * into, and dead cells whose neighbourhood gained region cells. Their next
+ * states are recorded in a write log, which is applied after the sweep.
+ * Volumes are split into slabs of eight slices. The even slabs are swept in
+ * parallel, then the odd ones.
+ */
 class CSynergeticModel : public CFilter
 {
 private:
@@ -61,25 +72,11 @@ public:
   /// Reimplemented from CPipelineItem
   virtual void apply()
     throw();
+  /// Reimplemented from CPipelineItem
+  virtual bool isDeterministic() const
+    throw();
 private:
 	boost::shared_ptr<CSynergeticModelDialog> theDialog;
-  ulong ulChangedCells;
-  ulong ulChaoticCells;
-	ulong ulRegionThreshold;	
-	long lTTL;
-  double dGrowChance;
-	double dInitialGrowChance;
-	double dReactivationStability;
-  bool isInRange( short intensity, short target, short range ) const throw();
-  bool staticGrowth( short src, short tgt, short &tgtnext, short &act ) throw();
-  void chaoticGrowth( short source, short target, short &tgtnext, short amount ) throw();
-  ushort validNeigh( short x, short y, short radius, TImagePtr tmp, ushort value );
-  short min( short a, short b ) { if (a<b) return a; else return b; }
-  short max( short a, short b ) { if (a>b) return a; else return b; }
-  void addHomogenousNeighbors( ushort x, ushort y, TImagePtr theOutput,
-    TImagePtr tmp, TImage* next );
-  void addChaoticNeighbors( ushort x, ushort y, TImagePtr theOutput,
-    TImagePtr tmp, TImage* next );
 };
 
 #endif
@@ -34,6 +34,7 @@
 #include "cpointlistfrommask.h"
 #include "cdeletenarrows.h"
 #include "ccompletevt.h"
+#include "cconnectedcomponents.h"
 using namespace std;
 using namespace boost;
 using namespace aips;
@@ -97,6 +98,9 @@ void initFactory()
 	workPtr.reset( new CCompleteVT( 0 ) );
 	factoryMap["CCompleteVT"] = workPtr;
 	classNames.push_back("CCompleteVT");
+	workPtr.reset( new CConnectedComponents( 0 ) );
+	factoryMap["CConnectedComponents"] = workPtr;
+	classNames.push_back("CConnectedComponents");
 }
 
 void unloadFactory()
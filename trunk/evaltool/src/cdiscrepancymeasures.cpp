@@ -11,9 +11,138 @@
 //
 #include "cdiscrepancymeasures.h"
 
+// Standard includes
+#include <algorithm>
+#include <limits>
+#include <set>
+
+// AIPS includes
+#include <cdistancetransform.h>
+
 using namespace std;
 using namespace boost;
 
+namespace
+{
+
+/// Bounding box of the surface voxels of one label in both images
+struct SBoundingBox
+{
+	size_t lowerArr[3];
+	size_t upperArr[3]; ///< Last voxel plus one
+	SBoundingBox()
+	{
+		for( unsigned short i = 0; i < 3; ++i )
+		{
+			lowerArr[i] = numeric_limits<size_t>::max();
+			upperArr[i] = 0;
+		}
+	}
+	void add( const size_t x, const size_t y, const size_t z )
+	{
+		lowerArr[0] = std::min( lowerArr[0], x ); upperArr[0] = std::max( upperArr[0], x + 1 );
+		lowerArr[1] = std::min( lowerArr[1], y ); upperArr[1] = std::max( upperArr[1], y + 1 );
+		lowerArr[2] = std::min( lowerArr[2], z ); upperArr[2] = std::max( upperArr[2], z + 1 );
+	}
+};
+
+/**
+ * Maps voxel values to label indices. Returns 0 for values which are not
+ * evaluated, otherwise the position in the sorted label vector plus one. The
+ * last value is cached since label images consist of long runs.
+ */
+template<typename TLabel> class CLabelIndex
+{
+public:
+	explicit CLabelIndex( const vector<TLabel>& theLabelsVec_ )
+		: theLabelsVec( theLabelsVec_ ), lastValue( 0 ), usLastIndex( lookup( 0 ) )
+	{
+	}
+	unsigned short operator()( const TLabel value )
+	{
+		if ( !( value == lastValue ) )
+		{
+			lastValue = value;
+			usLastIndex = lookup( value );
+		}
+		return usLastIndex;
+	}
+private:
+	unsigned short lookup( const TLabel value ) const
+	{
+		typename vector<TLabel>::const_iterator it =
+			std::lower_bound( theLabelsVec.begin(), theLabelsVec.end(), value );
+		if ( it == theLabelsVec.end() || !( *it == value ) )
+			return 0;
+		return static_cast<unsigned short>( it - theLabelsVec.begin() + 1 );
+	}
+	const vector<TLabel>& theLabelsVec;
+	TLabel lastValue;
+	unsigned short usLastIndex;
+};
+
+/**
+ * Marks all labelled voxels which are on the image border or have a direct
+ * (4- or 6-) neighbour with another label, and extends the bounding box of
+ * their label
+ * \param indexPtr label indices, 0 is not evaluated
+ * \param surfacePtr array to mark the surface voxels in
+ * \param extentVec image extents (2D or 3D)
+ * \param theBoxesVec bounding boxes of all label indices
+ */
+void markSurface( const unsigned short* indexPtr, unsigned char* surfacePtr,
+	const vector<size_t>& extentVec, vector<SBoundingBox>& theBoxesVec )
+{
+	const size_t dimX = extentVec[0];
+	const size_t dimY = extentVec[1];
+	const size_t dimZ = ( extentVec.size() > 2 ) ? extentVec[2] : 1;
+	const size_t sliceSize = dimX * dimY;
+	size_t i = 0;
+	for( size_t z = 0; z < dimZ; ++z )
+		for( size_t y = 0; y < dimY; ++y )
+			for( size_t x = 0; x < dimX; ++x, ++i )
+			{
+				surfacePtr[i] = 0;
+				const unsigned short usIndex = indexPtr[i];
+				if ( usIndex == 0 )
+					continue;
+				if ( x == 0 || x + 1 == dimX || y == 0 || y + 1 == dimY
+					|| indexPtr[i - 1] != usIndex || indexPtr[i + 1] != usIndex
+					|| indexPtr[i - dimX] != usIndex || indexPtr[i + dimX] != usIndex
+					|| ( dimZ > 1 && ( z == 0 || z + 1 == dimZ
+					|| indexPtr[i - sliceSize] != usIndex || indexPtr[i + sliceSize] != usIndex ) ) )
+				{
+					surfacePtr[i] = 1;
+					theBoxesVec[usIndex].add( x, y, z );
+				}
+			}
+}
+
+/**
+ * Copies the surface voxels of one label inside a bounding box into a mask
+ * \returns the number of surface voxels
+ */
+ulong extractSurface( const unsigned short* indexPtr, const unsigned char* surfacePtr,
+	const unsigned short usIndex, const vector<size_t>& extentVec, const SBoundingBox& theBox,
+	vector<unsigned char>& maskVec )
+{
+	ulong ulSurface = 0;
+	vector<unsigned char>::iterator maskIt = maskVec.begin();
+	for( size_t z = theBox.lowerArr[2]; z < theBox.upperArr[2]; ++z )
+		for( size_t y = theBox.lowerArr[1]; y < theBox.upperArr[1]; ++y )
+		{
+			size_t i = theBox.lowerArr[0] + extentVec[0] * ( y + extentVec[1] * z );
+			for( size_t x = theBox.lowerArr[0]; x < theBox.upperArr[0]; ++x, ++i, ++maskIt )
+			{
+				*maskIt = ( surfacePtr[i] && indexPtr[i] == usIndex );
+				ulSurface += *maskIt;
+			}
+		}
+	return ulSurface;
+}
+
+}
+
 /** \param ulID Unique item ID */
 CDiscrepancyMeasures::CDiscrepancyMeasures( ulong ulID )
  throw()
@@ -32,9 +161,11 @@ CDiscrepancyMeasures::CDiscrepancyMeasures( ulong ulID )
 									 "Sigma: Width of gaussian";
 
   parameters.initUnsignedLong( "Label", 1, 0, 10000000 );
+  parameters.setBool( "AllLabels", false );
 	parameters.initDouble( "DiceCoefficient", 0.5, 0.0, 100000.0 );
 	parameters.initDouble( "TanimotoCoefficient", 0.5, 0.0, 100000.0 );
 	parameters.initDouble( "HausdorffDistance", 0.5, 0.0, 100000.0 );
+	parameters.initDouble( "HausdorffDistance95", 0.5, 0.0, 100000.0 );
 	parameters.initDouble( "MeanDistance", 0.5, 0.0, 100000.0 );
 	parameters.initUnsignedLong( "InputRegionSize", 0, 0, 10000000 );
 	parameters.initUnsignedLong( "ReferenceRegionSize", 0, 0, 10000000 );
@@ -57,6 +188,7 @@ void CDiscrepancyMeasures::apply() throw()
 FBEGIN;
 	// Set Module inactive, since no valid input is given yet
   bModuleReady = false;
+  theMeasuresVec.clear();
   // Check if input present. Call specific function for all possible types
   if ( getInput() && getInput(1) )
     call<Length<imageTL>::value - 1>();
@@ -69,6 +201,13 @@ FBEGIN;
 FEND; 
 }
 
+/** \returns the measures of all evaluated labels, sorted by label */
+const std::vector<CDiscrepancyMeasures::SLabelMeasures>& CDiscrepancyMeasures::getLabelMeasures() const
+	throw()
+{
+	return theMeasuresVec;
+}
+
 /** \returns true if computation was successful, false if image type was wrong */
 template<typename ImageType> bool CDiscrepancyMeasures::compute() throw()
 {
@@ -85,172 +224,157 @@ FBEGIN;
   // We can start computation now, inputs are valid
   bModuleReady = true;
   
-	// Initialize all coefficients
-  double dDiceCoefficient = 0.0;
-  double dTanimotoCoefficient = 0.0;
-  std::list<TPoint3D> anInputList; // List of surface voxels for input image
-  std::list<TPoint3D> aReferenceList; // List of surface voxels for reference image
-  ulong ulInputRegionSize = 0;
-  ulong ulReferenceRegionSize = 0;
-  ulong ulSharedRegionSize = 0;
-  ulong ulInputSurface = 0;
-  ulong ulReferenceSurface = 0;
-  ulong ulCombinedArea = 0;
-  ulong ulFalsePositives = 0;
-  ulong ulFalseNegatives = 0;
-  // What's the label we should look out for
-  typename ImageType::TDataType theLabel =
-    static_cast<typename ImageType::TDataType>( parameters.getUnsignedLong( "Label" ) );
-DBG3( "Computing area sizes." );
-  // Compute region sizes and dice coefficient. Also mark boundary voxels for later
-  // distance computation
-  typename ImageType::iterator inputIt = inputSPtr->begin();
-  typename ImageType::iterator referenceIt = referenceSPtr->begin();
-  // For all voxels, check if the voxel is a surface voxel. In that case, save it to the
-  // appropiate list and increase individual surface area.
-  // For all object voxels, increase the individual volume counts.
-  // For all voxels belonging to both objects, increase the combined volume count.
-  // Additionally, record the number of false positives and false negatives
-  while( inputIt != inputSPtr->end() )
+  typedef typename ImageType::TDataType TLabel;
+  const size_t voxelCount = inputSPtr->getSize();
+  const TLabel* inputArr = inputSPtr->getArray();
+  const TLabel* referenceArr = referenceSPtr->getArray();
+
+  // Determine the labels to evaluate. These are either all labels other than 0 found in
+  // any of the images or only the selected label
+  vector<TLabel> theLabelsVec;
+  if ( parameters.getBool( "AllLabels" ) )
   {
-  	if ( (*inputIt) == theLabel )
+  	std::set<TLabel> theLabelsSet;
+  	TLabel lastValue = 0;
+  	for( size_t i = 0; i < voxelCount; ++i )
   	{
-  		ulInputRegionSize++;
-      TPoint3D p;
-      referenceIt.getPos( p );
-      if ( inputSPtr->getDimension() == 3
-  			&& !( ( p[0] < inputSPtr->getExtent(0) && (*inputSPtr)( p[0]+1, p[1], p[2] ) ) == theLabel
-  			&& ( p[0] > 0 && (*inputSPtr)( p[0]-1, p[1], p[2] ) ) == theLabel
-  			&& ( p[1] < inputSPtr->getExtent(1) && (*inputSPtr)( p[0], p[1]+1, p[2] ) ) == theLabel
-  			&& ( p[1] > 0 && (*inputSPtr)( p[0], p[1]-1, p[2] ) ) == theLabel
-  			&& ( p[2] < inputSPtr->getExtent(2) && (*inputSPtr)( p[0], p[1], p[2]+1 ) ) == theLabel
-  			&& ( p[2] > 0 && (*inputSPtr)( p[0], p[1], p[2]-1 ) ) == theLabel ) )
-  		{
-  			anInputList.push_back( p );
-  			ulInputSurface++;
-  		}
-  		else if ( inputSPtr->getDimension() == 2
-  			&& !( ( p[0] < inputSPtr->getExtent(0) && (*inputSPtr)( p[0]+1, p[1], p[2] ) ) == theLabel
-  			&& ( p[0] > 0 && (*inputSPtr)( p[0]-1, p[1], p[2] ) == theLabel
-  			&& ( p[1] < inputSPtr->getExtent(1) && (*inputSPtr)( p[0], p[1]+1, p[2] ) ) == theLabel
-  			&& ( p[1] > 0 && (*inputSPtr)( p[0], p[1]-1, p[2] ) == theLabel ) ) ) )
-  		{
-  			anInputList.push_back( p );
-  			ulInputSurface++;
-  		}
-  		ulCombinedArea++;
+  		if ( !( inputArr[i] == lastValue ) )
+  			theLabelsSet.insert( lastValue = inputArr[i] );
+  		if ( !( referenceArr[i] == lastValue ) )
+  			theLabelsSet.insert( lastValue = referenceArr[i] );
   	}
-  	if ( (*referenceIt) == theLabel )
-  	{
-  		ulReferenceRegionSize++;
-  		TPoint3D p;
-  		referenceIt.getPos( p );
-  		if ( inputSPtr->getDimension() == 3
-  			&& !( ( p[0] < inputSPtr->getExtent(0) && (*referenceSPtr)( p[0]+1, p[1], p[2] ) ) == theLabel
-  			&& ( p[0] > 0 && (*referenceSPtr)( p[0]-1, p[1], p[2] ) ) == theLabel
-  			&& ( p[1] < inputSPtr->getExtent(1) && (*referenceSPtr)( p[0], p[1]+1, p[2] ) ) == theLabel
-  			&& ( p[1] > 0 && (*referenceSPtr)( p[0], p[1]-1, p[2] ) ) == theLabel
-  			&& ( p[2] < inputSPtr->getExtent(2) && (*referenceSPtr)( p[0], p[1], p[2]+1 ) ) == theLabel
-  			&& ( p[2] > 0 && (*referenceSPtr)( p[0], p[1], p[2]-1 ) ) == theLabel ) ) 
-  		{
-  			aReferenceList.push_back( p );
-  			ulReferenceSurface++;
-  		}
-  		else if ( inputSPtr->getDimension() == 2
-  			&& !( ( p[0] < inputSPtr->getExtent(0) && (*referenceSPtr)( p[0]+1, p[1], p[2] ) ) == theLabel
-  			&& ( p[0] > 0 && (*referenceSPtr)( p[0]-1, p[1], p[2] ) == theLabel
-  			&& ( p[1] < inputSPtr->getExtent(1) && (*referenceSPtr)( p[0], p[1]+1, p[2] ) ) == theLabel
-  			&& ( p[1] > 0 && (*referenceSPtr)( p[0], p[1]-1, p[2] ) == theLabel ) ) ) )
-  		{
-  			aReferenceList.push_back( p );
-  			ulReferenceSurface++;
-  		}  		
-  		if ( !( (*inputIt) == theLabel ) )
-  			ulCombinedArea++;
-  	}
-  	if ( (*inputIt) == theLabel && (*referenceIt) == theLabel ) ulSharedRegionSize++;
-  	if ( (*inputIt) == theLabel && !(*referenceIt) == theLabel ) ulFalsePositives++;
-  	if ( !(*inputIt) == theLabel && (*referenceIt) == theLabel ) ulFalseNegatives++;
-  	++inputIt;
-  	++referenceIt;
+  	theLabelsSet.erase( 0 );
+  	theLabelsVec.assign( theLabelsSet.begin(), theLabelsSet.end() );
   }
-DBG3( "Found " << anInputList.size() << " segmentation and " << aReferenceList.size()
- << " reference voxels." );
+  else
+    theLabelsVec.push_back( static_cast<TLabel>( parameters.getUnsignedLong( "Label" ) ) );
+  if ( theLabelsVec.size() >= numeric_limits<unsigned short>::max() )
+  {
+  	alog << LWARN << SERROR( "Too many labels to evaluate" ) << endl;
+  	bModuleReady = false;
+  	return true;
+  }
+DBG3( "Computing area sizes of " << theLabelsVec.size() << " labels." );
+
+  // Map all voxels to label indices and count the input, reference and shared voxels of
+  // each label in a single pass
+  const size_t labelCount = theLabelsVec.size() + 1;
+  vector<ulong> theInputSizesVec( labelCount, 0 );
+  vector<ulong> theReferenceSizesVec( labelCount, 0 );
+  vector<ulong> theSharedSizesVec( labelCount, 0 );
+  vector<unsigned short> anInputIndexVec( voxelCount );
+  vector<unsigned short> aReferenceIndexVec( voxelCount );
+  CLabelIndex<TLabel> theInputIndex( theLabelsVec );
+  CLabelIndex<TLabel> theReferenceIndex( theLabelsVec );
+  for( size_t i = 0; i < voxelCount; ++i )
+  {
+  	anInputIndexVec[i] = theInputIndex( inputArr[i] );
+  	aReferenceIndexVec[i] = theReferenceIndex( referenceArr[i] );
+  	++theInputSizesVec[anInputIndexVec[i]];
+  	++theReferenceSizesVec[aReferenceIndexVec[i]];
+  	if ( anInputIndexVec[i] == aReferenceIndexVec[i] )
+  		++theSharedSizesVec[anInputIndexVec[i]];
+  }
+
+  // Mark the surfaces of all labels and get the region which contains both surfaces of
+  // each label. The nearest surface voxel always lies within this region, so the distance
+  // transforms only need to cover it
+  vector<size_t> extentVec = inputSPtr->getExtents();
+  extentVec.resize( inputSPtr->getDimension() );
+  const vector<double> spacingVec = inputSPtr->getBaseElementDimensions();
+  vector<unsigned char> anInputSurfaceVec( voxelCount );
+  vector<unsigned char> aReferenceSurfaceVec( voxelCount );
+  vector<SBoundingBox> theBoxesVec( labelCount );
+  markSurface( &anInputIndexVec[0], &anInputSurfaceVec[0], extentVec, theBoxesVec );
+  markSurface( &aReferenceIndexVec[0], &aReferenceSurfaceVec[0], extentVec, theBoxesVec );
 DBG3( "Computing coefficients." );
 
-  /* Compute Dice and Tanimoto coefficient */
-	dDiceCoefficient = static_cast<double>( 2 * ulSharedRegionSize )
-		/ static_cast<double>( ulInputRegionSize + ulReferenceRegionSize );
-	dTanimotoCoefficient = static_cast<double>( ulSharedRegionSize )
-		/ static_cast<double>( ulCombinedArea );
-  
-  /* Compute distance measures between the two surfaces */
+  theMeasuresVec.reserve( theLabelsVec.size() );
+  vector<unsigned char> anInputMaskVec;
+  vector<unsigned char> aReferenceMaskVec;
+  vector<double> aDistanceVec;
+  for( unsigned short usIndex = 1; usIndex < labelCount; ++usIndex )
+  {
+  	SLabelMeasures theMeasures;
+  	theMeasures.ulLabel = static_cast<ulong>( theLabelsVec[usIndex - 1] );
 
-  // Initilize all variables
-  std::list<TPoint3D>::iterator it;
-  std::list<TPoint3D>::iterator jt;
-  double dMinDist = inputSPtr->getSize();
-  double dSumDist = 0.0;
-  double dMaxMin = 0.0;
+  	/* Region sizes, Dice and Tanimoto coefficient */
+  	theMeasures.ulInputRegionSize = theInputSizesVec[usIndex];
+  	theMeasures.ulReferenceRegionSize = theReferenceSizesVec[usIndex];
+  	theMeasures.ulSharedRegionSize = theSharedSizesVec[usIndex];
+  	theMeasures.ulCombinedArea = theMeasures.ulInputRegionSize + theMeasures.ulReferenceRegionSize
+  		- theMeasures.ulSharedRegionSize;
+  	theMeasures.ulFalsePositives = theMeasures.ulInputRegionSize - theMeasures.ulSharedRegionSize;
+  	theMeasures.ulFalseNegatives = theMeasures.ulReferenceRegionSize - theMeasures.ulSharedRegionSize;
+  	theMeasures.dDiceCoefficient = static_cast<double>( 2 * theMeasures.ulSharedRegionSize )
+  		/ static_cast<double>( theMeasures.ulInputRegionSize + theMeasures.ulReferenceRegionSize );
+  	theMeasures.dTanimotoCoefficient = static_cast<double>( theMeasures.ulSharedRegionSize )
+  		/ static_cast<double>( theMeasures.ulCombinedArea );
 
-  // Loop over all input surface voxels
-  for( it = anInputList.begin(); it != anInputList.end(); ++it )
-  {  	
-  	dMinDist = inputSPtr->getSize();
-  	// For each input surface voxel, loop over all reference surface voxels
-		for( jt = aReferenceList.begin(); jt != aReferenceList.end(); ++jt )
-		{
-			// Compute distance and update minimum distance
-			double dDistance = sqrt( ((*it)[0]-(*jt)[0])*((*it)[0]-(*jt)[0])
-				+	((*it)[1]-(*jt)[1])*((*it)[1]-(*jt)[1])
-				+ ((*it)[2]-(*jt)[2])*((*it)[2]-(*jt)[2]) );
-			dMinDist = std::min( dMinDist, dDistance );
-		}
-		// Sum of distances
-		dSumDist += dMinDist;
-		// Maximum of minimum distances
-		dMaxMin = std::max( dMaxMin, dMinDist );
+  	/* Compute distance measures between the two surfaces */
+
+  	// The distances of each surface voxel to the other surface are read from the euclidean
+  	// distance transform of the other surface. If the other surface is empty, the image size
+  	// is used as distance
+  	const SBoundingBox& theBox = theBoxesVec[usIndex];
+  	vector<size_t> boxExtentVec( extentVec.size() );
+  	size_t boxSize = 1;
+  	for( size_t i = 0; i < extentVec.size(); ++i )
+  	{
+  		boxExtentVec[i] = ( theBox.upperArr[i] > theBox.lowerArr[i] )
+  			? theBox.upperArr[i] - theBox.lowerArr[i] : 0;
+  		boxSize *= boxExtentVec[i];
+  	}
+  	anInputMaskVec.resize( boxSize );
+  	aReferenceMaskVec.resize( boxSize );
+  	theMeasures.ulInputSurface = extractSurface( &anInputIndexVec[0], &anInputSurfaceVec[0], usIndex,
+  		extentVec, theBox, anInputMaskVec );
+  	theMeasures.ulReferenceSurface = extractSurface( &aReferenceIndexVec[0], &aReferenceSurfaceVec[0],
+  		usIndex, extentVec, theBox, aReferenceMaskVec );
+  	aDistanceVec.clear();
+  	if ( boxSize > 0 )
+  	{
+  		CDistanceTransform theTransform( boxExtentVec, spacingVec );
+  		theTransform.collectDistances( &anInputMaskVec[0], &aReferenceMaskVec[0], aDistanceVec );
+  		theTransform.collectDistances( &aReferenceMaskVec[0], &anInputMaskVec[0], aDistanceVec );
+  	}
+  	double dSumDist = 0.0;
+  	double dMaxMin = 0.0;
+  	for( vector<double>::iterator it = aDistanceVec.begin(); it != aDistanceVec.end(); ++it )
+  	{
+  		if ( (*it) == numeric_limits<double>::infinity() )
+  			(*it) = static_cast<double>( voxelCount );
+  		dSumDist += (*it);
+  		dMaxMin = std::max( dMaxMin, (*it) );
+  	}
+
+  	// Compute Hausdorff distance, its 95th percentile and mean surface distance
+  	theMeasures.dHausdorffDistance = dMaxMin;
+  	theMeasures.dHausdorffDistance95 = CDistanceTransform::percentile( aDistanceVec, 95.0 );
+  	theMeasures.dMeanDistance = dSumDist
+  		/ ( theMeasures.ulReferenceRegionSize + theMeasures.ulInputRegionSize );
+  	theMeasuresVec.push_back( theMeasures );
   }
-  double dSumDistA = dSumDist;
-  double dHDA = dMaxMin;
-  dSumDist = 0.0;
-  dMaxMin = 0.0;
 
-  // Do the same in the other direction
-  for( jt = aReferenceList.begin(); jt != aReferenceList.end(); ++jt )
+  // Put all computed metrics of the selected label into parameter list
+  for( vector<SLabelMeasures>::const_iterator it = theMeasuresVec.begin(); it != theMeasuresVec.end(); ++it )
   {
-  	dMinDist = inputSPtr->getSize();
-		for( it = anInputList.begin(); it != anInputList.end(); ++it )
-		{
-			double dDistance = sqrt( static_cast<double>( ((*it)[0]-(*jt)[0])*((*it)[0]-(*jt)[0])
-				+	((*it)[1]-(*jt)[1])*((*it)[1]-(*jt)[1])
-				+ ((*it)[2]-(*jt)[2])*((*it)[2]-(*jt)[2]) ) );
-			if ( dMinDist > dDistance )
-				dMinDist = dDistance;
-		}
-		dSumDist += dMinDist;
-		dMaxMin = std::max( dMaxMin, dMinDist );
+  	if ( it->ulLabel != parameters.getUnsignedLong( "Label" ) )
+  		continue;
+  	parameters.setDouble( "DiceCoefficient", it->dDiceCoefficient );
+  	parameters.setDouble( "TanimotoCoefficient", it->dTanimotoCoefficient );
+  	parameters.setDouble( "HausdorffDistance", it->dHausdorffDistance );
+  	parameters.setDouble( "HausdorffDistance95", it->dHausdorffDistance95 );
+  	parameters.setDouble( "MeanDistance", it->dMeanDistance );
+  	parameters.setUnsignedLong( "InputRegionSize", it->ulInputRegionSize );
+  	parameters.setUnsignedLong( "ReferenceRegionSize", it->ulReferenceRegionSize );
+  	parameters.setUnsignedLong( "SharedRegionSize", it->ulSharedRegionSize );
+  	parameters.setUnsignedLong( "InputSurface", it->ulInputSurface );
+  	parameters.setUnsignedLong( "ReferenceSurface", it->ulReferenceSurface );
+  	parameters.setUnsignedLong( "CombinedArea", it->ulCombinedArea );
+  	parameters.setUnsignedLong( "FalsePositives", it->ulFalsePositives );
+  	parameters.setUnsignedLong( "FalseNegatives", it->ulFalseNegatives );
   }
-  double dSumDistB = dSumDist;
-  double dHDB = dMaxMin;
-
-  // Compute Hausdorff distance and mean surface distance
-  double dHausdorffDistance = std::max( dHDA, dHDB );
-  double dMeanDistance = ( dSumDistA + dSumDistB ) / ( ulReferenceRegionSize + ulInputRegionSize );
-  
-  // Put all computed metrics into parameter list
-	parameters.setDouble( "DiceCoefficient", dDiceCoefficient );
-	parameters.setDouble( "TanimotoCoefficient", dTanimotoCoefficient );
-	parameters.setDouble( "HausdorffDistance", dHausdorffDistance );
-	parameters.setDouble( "MeanDistance", dMeanDistance );
-	parameters.setUnsignedLong( "InputRegionSize", ulInputRegionSize );
-	parameters.setUnsignedLong( "ReferenceRegionSize", ulReferenceRegionSize );
-	parameters.setUnsignedLong( "SharedRegionSize", ulSharedRegionSize );
-	parameters.setUnsignedLong( "InputSurface", ulInputSurface );
-	parameters.setUnsignedLong( "ReferenceSurface", ulReferenceSurface );
-	parameters.setUnsignedLong( "CombinedArea", ulCombinedArea );
-	parameters.setUnsignedLong( "FalsePositives", ulFalsePositives );
-	parameters.setUnsignedLong( "FalseNegatives", ulFalseNegatives );
 FEND;  
   return true;
 }
@@ -11,7 +11,10 @@
 //
 #ifndef CDISCREPANCYMEASURES_H
 #define CDISCREPANCYMEASURES_H
-#define CDISCREPANCYMEASURES_VERSION "0.3"
+#define CDISCREPANCYMEASURES_VERSION "0.5"
+
+// Standard includes
+#include <vector>
 
 // AIPS includes
 #include <cfilter.h>
@@ -26,18 +29,45 @@ using namespace aips;
  * 	-# Done using parameters, see Parameters.
  * - Parameters:
  * 	-# Label: Label to evaluate (Input)
+ * 	-# AllLabels: Evaluate all labels other than 0 found in any of the images (Input)
  * 	-# SegmentationVolume: Volume of segmentation (in voxels) (Output)
  * 	-# ReferenceVolume: Volume of reference (in voxels) (Output)
  * 	-# DistanceHD: Hausdorff distance (Output)
+ * 	-# HausdorffDistance95: 95th percentile of the surface distances of both directions (Output)
  * 	-# DistanceMS: Mean surface distance (Output)
  * 	-# CoeffDice: Dice Coefficient (Output)
  * 	-# NoFP: Number of false positives (not normalized) (Output)
  * 	-# NoFN: Number of false negatives (not normalized) (Output)
  *
+ * All labels are evaluated together: a single pass over both images counts the input,
+ * reference and shared voxels of every label, which yields the region sizes and
+ * coefficients. The measures of all evaluated labels are available from getLabelMeasures(),
+ * the parameters hold the measures of the label given by "Label".
+ *
+ * Surface distances are read from the euclidean distance transform (CDistanceTransform) of
+ * the other surface and are given in the units of the base element dimensions.
  */
 class CDiscrepancyMeasures : public CFilter
 {
 public:
+  /// Measures of a single label
+  struct SLabelMeasures
+  {
+    ulong ulLabel;
+    double dDiceCoefficient;
+    double dTanimotoCoefficient;
+    double dHausdorffDistance;
+    double dHausdorffDistance95;
+    double dMeanDistance;
+    ulong ulInputRegionSize;
+    ulong ulReferenceRegionSize;
+    ulong ulSharedRegionSize;
+    ulong ulInputSurface;
+    ulong ulReferenceSurface;
+    ulong ulCombinedArea;
+    ulong ulFalsePositives;
+    ulong ulFalseNegatives;
+  };
 /** \name Structors */
   //@{
   /// Constructor
@@ -47,6 +77,12 @@ public:
   virtual ~CDiscrepancyMeasures()
     throw();
   //@}
+/** \name Accessors */
+  //@{
+  /// Returns the measures of all evaluated labels
+  const std::vector<SLabelMeasures>& getLabelMeasures() const
+    throw();
+  //@}
 /** \name Other methods */
   //@{
   /// Reimplemented from CPipelineItem  
@@ -59,6 +95,7 @@ private:
   /// Actual computation for specific image types
   template<typename ImageType> bool compute()
     throw();
+  std::vector<SLabelMeasures> theMeasuresVec; ///< Measures of the last evaluation
 };
 /** 
  * \example evaltool.cpp
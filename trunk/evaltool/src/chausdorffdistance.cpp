@@ -13,6 +13,7 @@
  * (at your option) any later version.                                  *
  ************************************************************************/
 #include "chausdorffdistance.h"
+#include <cdistancetransform.h>
 
 using namespace std;
 using namespace boost;
@@ -31,9 +32,12 @@ CHausdorffDistance::CHausdorffDistance( ulong ulID ) throw()
                    "0: A scalar 2D or 3D singlechannel data set\n"
 									 "1: A scalar 2D or 3D singlechannel data set\n"
                    "**Output ports:\n"
-                   "0: A single scalar floating point value";
+                   "0: A single scalar floating point value\n"
+                   "** Parameters:\n"
+                   "Percentile: 100 gives the hausdorff distance, 95 the HD95";
 
 	parameters.initDouble("Result",0,0,1000);
+	parameters.initDouble("Percentile",100.0,0.0,100.0);
 
   inputsVec[0].portType = IOInteger;
   inputsVec[1].portType = IOInteger;
@@ -66,65 +70,40 @@ BENCHSTART;
     return;
   }
 
+	if ( inputPtr1->getExtents() != inputPtr2->getExtents() )
+	{
+		alog << LWARN << "Input images differ in size!" << endl;
+		return;
+	}
+
 	deleteOldOutput();
-	
-	double dHausdorffDistance = 0.0;
-	CTypedData<double> work ( inputPtr1->getDimension(), inputPtr1->getExtents() );
-	ushort usDimZ = 1;
-	if ( inputPtr1->getDimension() > 2 )
-		usDimZ = inputPtr1->getExtent(2);
-	
-	for( ushort z = 0; z < usDimZ; ++z )	
-		for( ushort y = 0; y < work.getExtent(1); ++y )
-			for( ushort x = 0; x < work.getExtent(0); ++x )
-			{
-				if ( (*inputPtr1)( x, y, z ) == 0 )
-				{
-					work( x, y, z ) = 0.0;
-					continue;
-				}
-				work( x, y, z ) = 1000000.0;
-				for( ushort w = 0; w < usDimZ; ++w )	
-					for( ushort v = 0; v < work.getExtent(1); ++v )
-						for( ushort u = 0; u < work.getExtent(0); ++u )
-							if ( (*inputPtr2)( u, v, w ) > 0 )
-								work( x, y, z ) = std::min( work( x, y, z ), sqrt( 
-									static_cast<double>( ( x - u ) * ( x - u ) ) 
-									+ static_cast<double>( ( y - v ) * ( y - v ) ) 
-									+ static_cast<double>( ( z - w ) * ( z - w ) ) ) );
-			}
-			
-	for( ushort z = 0; z < usDimZ; ++z )	
-		for( ushort y = 0; y < work.getExtent(1); ++y )
-			for( ushort x = 0; x < work.getExtent(0); ++x )
-				if ( work( x, y, z ) > dHausdorffDistance )
-					dHausdorffDistance = work( x, y, z );
-					
-	for( ushort z = 0; z < usDimZ; ++z )		
-		for( ushort y = 0; y < work.getExtent(1); ++y )
-			for( ushort x = 0; x < work.getExtent(0); ++x )
-			{
-				if ( (*inputPtr2)( x, y, z ) == 0 )
-				{
-					work( x, y, z )=0.0;
-					continue;
-				}
-				work( x, y, z ) = 1000000.0;
-				for( ushort w = 0; w < usDimZ; ++w )	
-					for( ushort v = 0; v < work.getExtent(1); ++v )
-						for( ushort u = 0; u < work.getExtent(0); ++u )
-							if ( (*inputPtr1)( u, v, w ) > 0 )
-								work( x, y, z ) = std::min( work( x, y, z ), sqrt( 
-									static_cast<double>( ( x - u ) * ( x - u ) ) 
-									+ static_cast<double>( ( y - v ) * ( y - v ) ) 
-									+ static_cast<double>( ( z - w ) * ( z - w ) ) ) );
-			}	
-	
-	for( ushort z = 0; z < usDimZ; ++z )		
-		for( ushort y = 0; y < work.getExtent(1); ++y )
-			for( ushort x = 0; x < work.getExtent(0); ++x )
-				if ( work( x, y, z ) > dHausdorffDistance )
-					dHausdorffDistance = work( x, y, z );
+
+	// Foreground masks of both images
+	const size_t voxelCount = inputPtr1->getSize();
+	vector<unsigned char> firstMaskVec( voxelCount );
+	vector<unsigned char> secondMaskVec( voxelCount );
+	bool bFirstEmpty = true;
+	bool bSecondEmpty = true;
+	for( size_t i = 0; i < voxelCount; ++i )
+	{
+		firstMaskVec[i] = ( (*inputPtr1)[i] > 0 );
+		secondMaskVec[i] = ( (*inputPtr2)[i] > 0 );
+		bFirstEmpty = bFirstEmpty && !firstMaskVec[i];
+		bSecondEmpty = bSecondEmpty && !secondMaskVec[i];
+	}
+	if ( bFirstEmpty || bSecondEmpty )
+	{
+		alog << LWARN << "One of the input images has no foreground voxels!" << endl;
+		return;
+	}
+
+	// Distances of each mask to the other one in physical units
+	CDistanceTransform theTransform( inputPtr1->getExtents(), inputPtr1->getBaseElementDimensions() );
+	vector<double> distanceVec;
+	theTransform.collectDistances( &firstMaskVec[0], &secondMaskVec[0], distanceVec );
+	theTransform.collectDistances( &secondMaskVec[0], &firstMaskVec[0], distanceVec );
+	double dHausdorffDistance = CDistanceTransform::percentile( distanceVec,
+		parameters.getDouble( "Percentile" ) );
 	parameters.setDouble( "Result", dHausdorffDistance );
 	
 DS( "*** Hausdorff distance coefficient is: " << dHausdorffDistance );
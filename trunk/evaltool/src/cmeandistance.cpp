@@ -13,6 +13,7 @@
  * (at your option) any later version.                                  *
  ************************************************************************/
 #include "cmeandistance.h"
+#include <cdistancetransform.h>
 
 using namespace std;
 using namespace boost;
@@ -64,40 +65,41 @@ BENCHSTART;
     alog << LWARN << "Input type is no single-channel 2D or 3D image!" << endl;
     return;
   }
+	if ( inputPtr1->getExtents() != inputPtr2->getExtents() )
+	{
+		alog << LWARN << "Input images differ in size!" << endl;
+		return;
+	}
 	deleteOldOutput();
-	double dDistanceSum1 = 0.0; double dDistanceSum2 = 0.0; 
-	ulong ulAreaImage1 = 0; 
-	ulong ulAreaImage2 = 0;	
-		for( ushort y = 0; y < inputPtr1->getExtent(1); ++y )
-			for( ushort x = 0; x < inputPtr1->getExtent(0); ++x )
-			{
-				if ( (*inputPtr1)( x, y ) == 0 )
-					continue;
-				ulAreaImage1++;			
-				double dLocalMinimum = 100000.0;
-					for( ushort v = 0; v < inputPtr1->getExtent(1); ++v )
-						for( ushort u = 0; u < inputPtr1->getExtent(0); ++u )
-							if ( (*inputPtr2)( u, v ) > 0 )
-								dLocalMinimum = std::min( dLocalMinimum, sqrt( static_cast<double>( ( x - u ) * ( x - u ) ) 
-									+ static_cast<double>( ( y - v ) * ( y - v ) )  ) );
-				dDistanceSum1 += dLocalMinimum;
-			}
-		for( ushort y = 0; y < inputPtr1->getExtent(1); ++y )
-			for( ushort x = 0; x < inputPtr1->getExtent(0); ++x )
-			{
-				if ( (*inputPtr2)( x, y ) == 0 )
-					continue;
-				ulAreaImage2++;
-				double dLocalMinimum = 100000.0;
-					for( ushort v = 0; v < inputPtr1->getExtent(1); ++v )
-						for( ushort u = 0; u < inputPtr1->getExtent(0); ++u )
-							if ( (*inputPtr1)( u, v ) > 0 )
-								dLocalMinimum = std::min( dLocalMinimum, sqrt( static_cast<double>( ( x - u ) * ( x - u ) ) 
-									+ static_cast<double>( ( y - v ) * ( y - v ) ) ) );
-				dDistanceSum2 += dLocalMinimum;
-			}
-	double dMeanDistance = ( dDistanceSum1 + dDistanceSum2 ) /
-		static_cast<double>( ulAreaImage1 + ulAreaImage2 );
+
+	// Foreground masks of both images
+	const size_t voxelCount = inputPtr1->getSize();
+	vector<unsigned char> firstMaskVec( voxelCount );
+	vector<unsigned char> secondMaskVec( voxelCount );
+	ulong ulAreaImage1 = 0;
+	ulong ulAreaImage2 = 0;
+	for( size_t i = 0; i < voxelCount; ++i )
+	{
+		firstMaskVec[i] = ( (*inputPtr1)[i] > 0 );
+		secondMaskVec[i] = ( (*inputPtr2)[i] > 0 );
+		ulAreaImage1 += firstMaskVec[i];
+		ulAreaImage2 += secondMaskVec[i];
+	}
+	if ( ulAreaImage1 == 0 || ulAreaImage2 == 0 )
+	{
+		alog << LWARN << "One of the input images has no foreground voxels!" << endl;
+		return;
+	}
+
+	// Distances of each mask to the other one in physical units
+	CDistanceTransform theTransform( inputPtr1->getExtents(), inputPtr1->getBaseElementDimensions() );
+	vector<double> distanceVec;
+	theTransform.collectDistances( &firstMaskVec[0], &secondMaskVec[0], distanceVec );
+	theTransform.collectDistances( &secondMaskVec[0], &firstMaskVec[0], distanceVec );
+	double dDistanceSum = 0.0;
+	for( vector<double>::const_iterator it = distanceVec.begin(); it != distanceVec.end(); ++it )
+		dDistanceSum += *it;
+	double dMeanDistance = dDistanceSum / static_cast<double>( ulAreaImage1 + ulAreaImage2 );
 	parameters.setDouble( "Result", dMeanDistance );
 	
 DS( "*** Mean distance coefficient is: " << dMeanDistance );
@@ -5,10 +5,11 @@
  *                                                                      *
  * Author: Hendrik Belitz (h.belitz@fz-juelich.de)                      *
  *                                                                      *
- * Version: 0.1                                                         *
+ * Version: 0.2                                                         *
  * Status:  Pre-Alpha                                                   *
  * Created: 2004-06-07                                                  *
- * Changed:                                                             *
+ * Changed: 2026-10-17 Uses the euclidean distance transform, works on  *
+ *                     3D images                                        *
  ************************************************************************
  * This program is free software; you can redistribute it and/or modify *
  * it under the terms of the GNU General Public License as published by *
@@ -27,7 +28,10 @@
 using namespace aips;
 
 /**
- * Adds or subtracts the intensities of the given input images
+ * Computes the mean distance of the foreground voxels of two images, i.e. the
+ * distances of all voxels to the other image averaged over both images. The
+ * distances are taken from CDistanceTransform and given in the units of the
+ * base element dimensions.
  */
 class CMeanDistance : public CFilter
 {
@@ -10,12 +10,22 @@
  *
  * Evaltool is directly called from the command prompt:
  *
- * <code>evaltool <i>file1 file2</i> [-o outfile] [-a] [-l labelvalue] [-h]</code>
+ * <code>evaltool <i>file1 file2</i> [-o outfile] [-a] [-l labelvalue] [-L] [-h]</code>
+ *
+ * <code>evaltool -b <i>listfile</i> [-o outfile] [-a] [-l labelvalue] [-L] [-j jobs]</code>
  *
  * You must call evaltool with two image file names. The output file is optional and
  * defaults to stdout. With [-a], you tell evaltool to append to an existing file instead
  * of overwriting it. [-l] defines the label of the objects to compare and defaults to 1.
+ * [-L] evaluates all labels other than 0 instead, in a single pass over the images.
  * [-h] displays a help message.
+ *
+ * In batch mode [-b], the image pairs are read from a list file with one pair of file
+ * names per line (empty lines and lines starting with # are ignored). Each pair is loaded
+ * once and the pairs are evaluated in parallel by [-j] jobs (defaults to one per core).
+ * All results are written to one CSV table, one row per image pair and label.
+ * Batch mode and [-L] add the columns "Hausdorff distance 95" and "Label" to the
+ * table, so do not append their results to tables of single pair runs.
  */
  
 // Standard library includes
@@ -25,10 +35,14 @@
 #include <string>
 #include <cstdlib>
 #include <cstring>
+#include <sstream>
 
 // Boost standard library includes
 #include <boost/shared_ptr.hpp>
 #include <boost/program_options.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
 
 // AIPS includes
 #include <cdatafileserver.h>
@@ -37,6 +51,7 @@
 #include <csimpledathandler.h>
 #include <cdatahandler.h>
 #include <ctypedmap.h>
+#include <cthreadpool.h>
 
 // Local includes
 #include "cdiscrepancymeasures.h"
@@ -51,6 +66,9 @@ bool bAppendToOutput; ///< Append to old output or create a new one
 uint uiLabel; ///< Intensity label to analyze
 string sOutputFile; ///< File name of output
 vector<string> theInputFileNamesVec; ///< Input file names
+string sBatchFile; ///< File name of the list of image pairs
+bool bAllLabels; ///< Evaluate all labels instead of uiLabel
+uint uiJobs; ///< Number of image pairs to evaluate in parallel
 
 void license()
 {
@@ -101,6 +119,11 @@ bool parseCommandLine( int argc, char *argv[] )
       boost::program_options::value<string>(), "text file to write results to" )
     ( "append,a", "append results to output file" )
     ( "label,l", boost::program_options::value<uint>( &uiLabel )->default_value(1), "label to evaluate (defaults to 1)" )
+    ( "alllabels,L", "evaluate all labels other than 0" )
+    ( "batch,b",
+      boost::program_options::value<string>(), "text file listing image pairs to evaluate, one pair per line" )
+    ( "jobs,j", boost::program_options::value<uint>( &uiJobs )->default_value(0),
+      "number of image pairs to evaluate in parallel (defaults to one per core)" )
   ;
 
   boost::program_options::positional_options_description thePositionalOptions;
@@ -123,6 +146,8 @@ bool parseCommandLine( int argc, char *argv[] )
   if ( vm.count( "append" ) )
     bAppendToOutput = true;
 
+  bAllLabels = ( vm.count( "alllabels" ) > 0 );
+
   if ( vm.count( "outputfile" ) )
     sOutputFile = vm["outputfile"].as<string>();
   else
@@ -131,6 +156,12 @@ bool parseCommandLine( int argc, char *argv[] )
     sOutputFile = "";    
   }
 
+  if ( vm.count( "batch" ) )
+  {
+    sBatchFile = vm["batch"].as<string>();
+    return true;
+  }
+
   if ( vm.count( "inputfile" ) )
   {
     theInputFileNamesVec = vm["inputfile"].as<vector<string> >();
@@ -145,6 +176,153 @@ bool parseCommandLine( int argc, char *argv[] )
   return true;
 }
 
+/// Evaluation of one image pair
+struct SEvaluation
+{
+  string sInputFile; ///< Segmentation to evaluate
+  string sReferenceFile; ///< Reference segmentation
+  bool bDone; ///< Evaluation was successful
+  vector<CDiscrepancyMeasures::SLabelMeasures> theMeasuresVec; ///< Measures of all evaluated labels
+};
+
+/// Evaluates a list of image pairs in parallel
+class CBatchEvaluation
+{
+public:
+  /// Constructor
+  CBatchEvaluation( vector<SEvaluation>& theEvaluationsVec_ )
+    : theEvaluationsVec( theEvaluationsVec_ ), nextEvaluation( 0 )
+  {
+  }
+  /// Evaluates image pairs until all are done. Called by each job
+  void run()
+  {
+    CDiscrepancyMeasures eval(0);
+    CTypedMap* parameters = eval.getParameters();
+    parameters->setUnsignedLong( "Label", uiLabel );
+    parameters->setBool( "AllLabels", bAllLabels );
+    while( true )
+    {
+      size_t index;
+      TDataSetPtr image;
+      TDataSetPtr reference;
+      {
+        // File handlers are shared, so only one job may load at a time
+        boost::mutex::scoped_lock lock( theMutex );
+        if ( nextEvaluation == theEvaluationsVec.size() )
+          return;
+        index = nextEvaluation++;
+        try
+        {
+          image = getFileServer().loadDataSet( theEvaluationsVec[index].sInputFile ).first;
+          reference = getFileServer().loadDataSet( theEvaluationsVec[index].sReferenceFile ).first;
+        }
+        catch( FileException& e )
+        {
+          cerr << "Cannot load " << theEvaluationsVec[index].sInputFile << " or "
+            << theEvaluationsVec[index].sReferenceFile << ": " << e.what() << endl;
+          continue;
+        }
+      }
+      eval.setInput( image );
+      eval.setInput( reference, 1 );
+      eval.apply();
+      theEvaluationsVec[index].theMeasuresVec = eval.getLabelMeasures();
+      theEvaluationsVec[index].bDone = eval.isReady();
+      // Release the images before loading the next pair
+      image.reset();
+      reference.reset();
+      eval.setInput( image );
+      eval.setInput( reference, 1 );
+    }
+  }
+private:
+  vector<SEvaluation>& theEvaluationsVec; ///< All image pairs
+  size_t nextEvaluation; ///< Next image pair to evaluate
+  boost::mutex theMutex; ///< Guards nextEvaluation and the file server
+};
+
+/**
+ * Reads the image pairs to evaluate
+ * \param theEvaluationsVec vector to append the pairs to
+ * \returns false if the list file could not be read
+ */
+bool readBatchFile( vector<SEvaluation>& theEvaluationsVec )
+{
+  ifstream theBatchFile( sBatchFile.c_str() );
+  if ( !theBatchFile )
+  {
+    cout << "Cannot read " << sBatchFile << ", aborting..." << endl;
+    return false;
+  }
+  string sLine;
+  while( getline( theBatchFile, sLine ) )
+  {
+    istringstream is( sLine );
+    SEvaluation anEvaluation;
+    if ( !( is >> anEvaluation.sInputFile ) || anEvaluation.sInputFile[0] == '#' )
+      continue;
+    if ( !( is >> anEvaluation.sReferenceFile ) )
+    {
+      cout << "Ignoring incomplete line \"" << sLine << "\"" << endl;
+      continue;
+    }
+    anEvaluation.bDone = false;
+    theEvaluationsVec.push_back( anEvaluation );
+  }
+  return true;
+}
+
+/**
+ * Writes the table header
+ * \param theOutput stream to write to
+ * \param bExtendedColumns also write the columns of batch and multi-label mode
+ */
+void writeHeader( ostream& theOutput, const bool bExtendedColumns )
+{
+  theOutput << "Input image,Reference image,Dice coefficient,Tanimoto coefficient,"
+            << "Hausdorff distance,Mean distance,"
+            << "Input region size,Reference region size,Shared region size,"
+            << "Input surface,Reference surface,Combined area,"
+            << "False positives,False negatives";
+  if ( bExtendedColumns )
+    theOutput << ",Hausdorff distance 95,Label";
+  theOutput << endl;
+}
+
+/**
+ * Writes one table row for each evaluated label of an image pair
+ * \param theOutput stream to write to
+ * \param anEvaluation evaluated image pair
+ * \param bExtendedColumns also write the columns of batch and multi-label mode
+ */
+void writeRows( ostream& theOutput, const SEvaluation& anEvaluation, const bool bExtendedColumns )
+{
+  for( vector<CDiscrepancyMeasures::SLabelMeasures>::const_iterator it = anEvaluation.theMeasuresVec.begin();
+    it != anEvaluation.theMeasuresVec.end(); ++it )
+  {
+    theOutput << anEvaluation.sInputFile << "," << anEvaluation.sReferenceFile << ",";
+    theOutput << it->dDiceCoefficient << ",";
+    theOutput << it->dTanimotoCoefficient << ",";
+    theOutput << it->dHausdorffDistance << ",";
+    theOutput << it->dMeanDistance << ",";
+    theOutput << it->ulInputRegionSize << ",";
+    theOutput << it->ulReferenceRegionSize << ",";
+    theOutput << it->ulSharedRegionSize << ",";
+    theOutput << it->ulInputSurface << ",";
+    theOutput << it->ulReferenceSurface << ",";
+    theOutput << it->ulCombinedArea << ",";
+    theOutput << it->ulFalsePositives << ",";
+    theOutput << it->ulFalseNegatives;
+    if ( bExtendedColumns )
+    {
+      theOutput << "," << it->dHausdorffDistance95;
+      theOutput << "," << it->ulLabel;
+    }
+    theOutput << endl;
+  }
+}
+
 int main(int argc, char *argv[])
 {
 	// Check license
@@ -165,64 +343,81 @@ int main(int argc, char *argv[])
 	getFileServer().addHandler( h3 );
 	getFileServer().addHandler( h4 );
 
-	// Initialize computation
-	CDiscrepancyMeasures eval(0);
-  CTypedMap* parameters = eval.getParameters();
+	// Collect the image pairs to evaluate
+	vector<SEvaluation> theEvaluationsVec;
+	if ( sBatchFile != "" )
+	{
+		if ( !readBatchFile( theEvaluationsVec ) )
+			return EXIT_FAILURE;
+	}
+	else
+	{
+		SEvaluation anEvaluation;
+		anEvaluation.sInputFile = theInputFileNamesVec[0];
+		anEvaluation.sReferenceFile = theInputFileNamesVec[1];
+		anEvaluation.bDone = false;
+		theEvaluationsVec.push_back( anEvaluation );
+	}
 
-  // Set parameters and input data, start computation  
-  parameters->setUnsignedLong( "Label", uiLabel );
-  TDataSetPtr image = getFileServer().loadDataSet( theInputFileNamesVec[0] ).first;
-  TDataSetPtr reference = getFileServer().loadDataSet( theInputFileNamesVec[1] ).first;
-	eval.setInput( image );
-	eval.setInput( reference, 1 );
-	eval.apply();
+	// Evaluate the pairs in parallel. The jobs run on the global thread pool, so
+	// the computations inside each job only use threads no other job is busy with
+	unsigned int uiCores = CPipelineItem::getNumberOfThreads();
+	size_t jobCount = ( uiJobs > 0 ) ? uiJobs : uiCores;
+	jobCount = std::max<size_t>( 1, std::min( jobCount, theEvaluationsVec.size() ) );
+	if ( jobCount > uiCores )
+		CPipelineItem::setNumberOfThreads( jobCount );
+	CBatchEvaluation theBatch( theEvaluationsVec );
+	getThreadPool().runRanges( boost::bind( &CBatchEvaluation::run, &theBatch ), jobCount, jobCount );
 
-  // No output file given, output to stdout
-  if ( sOutputFile == "" )
+  // No output file given, output the selected label of a single pair to stdout
+  if ( sOutputFile == "" && sBatchFile == "" && !bAllLabels )
   {
-  	cout << "DiceCoefficient     " << parameters->getDouble( "DiceCoefficient" ) << endl;
-	  cout << "TanimotoCoefficient " << parameters->getDouble( "TanimotoCoefficient" ) << endl;
-  	cout << "HausdorffDistance   " << parameters->getDouble( "HausdorffDistance" ) << endl;
-	  cout << "MeanDistance        " << parameters->getDouble( "MeanDistance" ) << endl;
-    cout << "InputRegionSize     " << parameters->getUnsignedLong( "InputRegionSize" ) << endl;
-    cout << "ReferenceRegionSize " << parameters->getUnsignedLong( "ReferenceRegionSize" ) << endl;
-    cout << "SharedRegionSize    " << parameters->getUnsignedLong( "SharedRegionSize" ) << endl;
-    cout << "InputSurface        " << parameters->getUnsignedLong( "InputSurface" ) << endl;
-    cout << "ReferenceSurface    " << parameters->getUnsignedLong( "ReferenceSurface" ) << endl;
-    cout << "CombinedArea        " << parameters->getUnsignedLong( "CombinedArea"  ) << endl;
-    cout << "FalsePositives      " << parameters->getUnsignedLong( "FalsePositives" ) << endl;
-    cout << "FalseNegatives      " << parameters->getUnsignedLong( "FalseNegatives" ) << endl;
+  	if ( theEvaluationsVec[0].theMeasuresVec.empty() )
+  		return EXIT_FAILURE;
+  	const CDiscrepancyMeasures::SLabelMeasures& theMeasures = theEvaluationsVec[0].theMeasuresVec[0];
+  	cout << "DiceCoefficient     " << theMeasures.dDiceCoefficient << endl;
+	  cout << "TanimotoCoefficient " << theMeasures.dTanimotoCoefficient << endl;
+  	cout << "HausdorffDistance   " << theMeasures.dHausdorffDistance << endl;
+  	cout << "HausdorffDistance95 " << theMeasures.dHausdorffDistance95 << endl;
+	  cout << "MeanDistance        " << theMeasures.dMeanDistance << endl;
+    cout << "InputRegionSize     " << theMeasures.ulInputRegionSize << endl;
+    cout << "ReferenceRegionSize " << theMeasures.ulReferenceRegionSize << endl;
+    cout << "SharedRegionSize    " << theMeasures.ulSharedRegionSize << endl;
+    cout << "InputSurface        " << theMeasures.ulInputSurface << endl;
+    cout << "ReferenceSurface    " << theMeasures.ulReferenceSurface << endl;
+    cout << "CombinedArea        " << theMeasures.ulCombinedArea << endl;
+    cout << "FalsePositives      " << theMeasures.ulFalsePositives << endl;
+    cout << "FalseNegatives      " << theMeasures.ulFalseNegatives << endl;
     return EXIT_SUCCESS;
   }
 
-  // Output to file
+  // Output all results as one table, either to stdout or to the output file. A
+  // single pair keeps the columns of older versions, so results can still be
+  // appended to existing tables
+  const bool bExtendedColumns = ( sBatchFile != "" || bAllLabels );
   auto_ptr<ofstream> theOutputFile;
-  if ( bAppendToOutput )
-    theOutputFile.reset( new ofstream( sOutputFile.c_str(), ios_base::out ) );
-  else
+  ostream* theOutputPtr = &cout;
+  if ( sOutputFile != "" )
   {
-    theOutputFile.reset( new ofstream( sOutputFile.c_str() ) );
-    (*theOutputFile) << "Input image,Reference image,Dice coefficient,Tanimoto coefficient,"
-    								 << "Hausdorff distance,Mean distance,"
-    								 << "Input region size,Reference region size,Shared region size,"
-    								 << "Input surface,Reference surface,Combined area,"
-    								 << "False positives,False negatives" << endl;
+    theOutputFile.reset( new ofstream( sOutputFile.c_str(),
+      bAppendToOutput ? ios_base::app : ios_base::out ) );
+    theOutputPtr = theOutputFile.get();
   }
-    
-  (*theOutputFile) << theInputFileNamesVec[0] << "," << theInputFileNamesVec[1] << ",";
-  (*theOutputFile) << parameters->getDouble( "DiceCoefficient" ) << ",";
-  (*theOutputFile) << parameters->getDouble( "TanimotoCoefficient" ) << ",";
-  (*theOutputFile) << parameters->getDouble( "HausdorffDistance" ) << ",";
-  (*theOutputFile) << parameters->getDouble( "MeanDistance" ) << ",";
-  (*theOutputFile) << parameters->getUnsignedLong( "InputRegionSize" ) << ",";
-  (*theOutputFile) << parameters->getUnsignedLong( "ReferenceRegionSize" ) << ",";
-  (*theOutputFile) << parameters->getUnsignedLong( "SharedRegionSize" ) << ",";
-  (*theOutputFile) << parameters->getUnsignedLong( "InputSurface" ) << ",";
-  (*theOutputFile) << parameters->getUnsignedLong( "ReferenceSurface" ) << ",";
-  (*theOutputFile) << parameters->getUnsignedLong( "CombinedArea" ) << ",";
-  (*theOutputFile) << parameters->getUnsignedLong( "FalsePositives" ) << ",";
-  (*theOutputFile) << parameters->getUnsignedLong( "FalseNegatives" ) << endl;
-  theOutputFile->close();
-  
-  return EXIT_SUCCESS;
+  if ( !bAppendToOutput || sOutputFile == "" )
+    writeHeader( *theOutputPtr, bExtendedColumns );
+
+  int iResult = EXIT_SUCCESS;
+  for( vector<SEvaluation>::const_iterator it = theEvaluationsVec.begin(); it != theEvaluationsVec.end(); ++it )
+  {
+    if ( !it->bDone )
+    {
+      cerr << "Evaluation of " << it->sInputFile << " and " << it->sReferenceFile << " failed" << endl;
+      iResult = EXIT_FAILURE;
+    }
+    writeRows( *theOutputPtr, *it, bExtendedColumns );
+  }
+  if ( theOutputFile.get() )
+    theOutputFile->close();
+
+  return iResult;
 }
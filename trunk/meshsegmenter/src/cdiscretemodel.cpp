@@ -230,47 +230,53 @@ else
 				mesh->subdivide( 1.5*disc );
 				mesh->edgeMelt( 0.5*disc );
  			}
-			for( list<SVertex*>::iterator vit = mesh->vList.begin(); vit != mesh->vList.end(); ++vit )
-				(*vit)->theForce = 0.0;
+			for( TIndex v = 0; v < mesh->getVertexCapacity(); ++v )
+				mesh->forceVec[v] = 0.0;
 			mesh->computeBins( !((i%2)==0), disc*0.5 );
 			mesh->computeNormals();
-			for( list<SVertex*>::iterator vit = mesh->vList.begin(); vit != mesh->vList.end(); ++vit )
+			for( TIndex v = 0; v < mesh->getVertexCapacity(); ++v )
 			{
-				if (!(*vit)->isStable)
+				if ( !mesh->isVertex( v ) )
+					continue;
+				TVector3D& thePosition = mesh->positionVec[v];
+				TVector3D& theForce = mesh->forceVec[v];
+				const TVector3D& theNormal = mesh->normalVec[v];
+				SStability& theStability = mesh->stabilityVec[v];
+				if (!theStability.isStable)
 				{					
 					// Bending force, Find neighbors
-					SEdge* startEdgePtr = (*vit)->anEdgePtr;
-					SEdge* actEdgePtr = startEdgePtr;
+					TIndex startEdge = mesh->getVertexEdge( v );
+					TIndex actEdge = startEdge;
 					// Find COG				
 					TVector3D cog = 0.0;
 					uint uiNeighbours = 0;
 					do
 					{
-						cog += actEdgePtr->endPointPtr->thePosition;
-						actEdgePtr = actEdgePtr->opposingEdgePtr->nextEdgePtr;
+						cog += mesh->positionVec[mesh->getEndPoint( actEdge )];
+						actEdge = mesh->getNext( mesh->getOpposing( actEdge ) );
 						uiNeighbours++;
 					}
-					while( actEdgePtr != startEdgePtr );
+					while( actEdge != startEdge );
 					cog /= static_cast<double>( uiNeighbours );
 					// Mark transition and update force
-					TVector3D curvature = cog - (*vit)->thePosition;
-					double dForceStrength = dot( curvature, (*vit)->theNormal ); 
+					TVector3D curvature = cog - thePosition;
+					double dForceStrength = dot( curvature, theNormal ); 
 					TVector3D force1 = curvature * dForceStrength * 1.0 / norm(curvature);
-					curvature = cog - ( (*vit)->thePosition + force1 );
-					dForceStrength = dot( curvature, (*vit)->theNormal ); 
+					curvature = cog - ( thePosition + force1 );
+					dForceStrength = dot( curvature, theNormal ); 
 					TVector3D force2 = curvature * dForceStrength * -1.1 / norm(curvature);
 					TVector3D inner = ( force1 + force2 ) * internal;
 					if ( norm(inner) > 1.0 )
 						inner /=	norm(inner);
-					(*vit)->theForce += inner;
+					theForce += inner;
 					// Add balloon force
-					//(*vit)->theForce += (*vit)->theNormal * -0.001;
+					//theForce += theNormal * -0.001;
 					// Add external force		
-					if ( (*vit)->thePosition[0] > 0.0 && (*vit)->thePosition[0] < static_cast<double>(extents[0])
-						&& (*vit)->thePosition[1] > 0.0 && (*vit)->thePosition[1] < static_cast<double>(extents[1])
-						&& (*vit)->thePosition[2] > 0.0 && (*vit)->thePosition[2] < static_cast<double>(extents[2]) )
+					if ( thePosition[0] > 0.0 && thePosition[0] < static_cast<double>(extents[0])
+						&& thePosition[1] > 0.0 && thePosition[1] < static_cast<double>(extents[1])
+						&& thePosition[2] > 0.0 && thePosition[2] < static_cast<double>(extents[2]) )
 					{
-						const TVector3D& pos = (*vit)->thePosition;
+						const TVector3D& pos = thePosition;
 /*						TVector3D nb[8];
   					double vals[8];
 	  				nb[0][0] = static_cast<int>( ceil( pos[0] ) );  nb[0][1] = static_cast<int>( floor( pos[1] ) ); nb[0][2] = static_cast<int>( floor( pos[2] ) );
@@ -293,49 +299,46 @@ else
   							static_cast<ushort>( nb[i][1] ), static_cast<ushort>( nb[i][2] ) ) );*/
   					TVector3D eforce = (*field)( static_cast<ushort>( round( pos[0] ) ),
   							static_cast<ushort>( round( pos[1] ) ), static_cast<ushort>( round( pos[2] ) ) ) ;
-						eforce = dot((*vit)->theNormal,eforce) * (*vit)->theNormal;
+						eforce = dot(theNormal,eforce) * theNormal;
 //cerr << norm(eforce) << endl;
 						if ( norm(eforce) < 0.1 && norm(eforce) > 0.0 )
 							eforce = eforce / norm(eforce) * 0.1;
-						(*vit)->theForce += eforce;
+						theForce += eforce;
 					}
 else
 {
-	cerr << (*vit)->thePosition << " <> " << static_cast<double>(extents[0]) << "," << static_cast<double>(extents[1])
+	cerr << thePosition << " <> " << static_cast<double>(extents[0]) << "," << static_cast<double>(extents[1])
 		<< "," << static_cast<double>(extents[2]) << endl ;
 }
-					double forceNorm = norm ( (*vit)->theForce );
+					double forceNorm = norm ( theForce );
 					if ( forceNorm > 0.01 )
 					{
 						if ( forceNorm > 1.0 )
-							(*vit)->theForce /= forceNorm;					
-						(*vit)->lastPositions.push_back((*vit)->thePosition);
-						(*vit)->thePosition += (0.5*(*vit)->theForce);
+							theForce /= forceNorm;					
+						theStability.push_back(thePosition);
+						thePosition += (0.5*theForce);
 						if( i > 8 ) 
 						{
-							size_t size = (*vit)->lastPositions.size();
-							TVector3D mean = 0.0;						
-							for( deque<TVector3D>::iterator vi = (*vit)->lastPositions.begin(); vi != (*vit)->lastPositions.end(); ++vi )
-								mean += (*vi);
-							mean /= static_cast<double>(size);
-							if ( i > 50 && norm( (*vit)->thePosition - mean ) < divisor ) (*vit)->stability++;
-							if ( size > 10 ) (*vit)->lastPositions.pop_front();
+							size_t size = theStability.size();
+							TVector3D mean = theStability.mean();
+							if ( i > 50 && norm( thePosition - mean ) < divisor ) theStability.stability++;
+							if ( size > 10 ) theStability.pop_front();
 						}
 					}
 					else
 					{
-						(*vit)->stability++;
+						theStability.stability++;
 					}
-					if( (*vit)->stability > 100 )
-						(*vit)->isStable = true;					
+					if( theStability.stability > 100 )
+						theStability.isStable = true;					
 				}
 				else
 				{
 					stableNodes++;
-					(*vit)->theForce[0] = 1.0;
+					theForce[0] = 1.0;
 				}
 			}
-			if ( static_cast<double>(stableNodes) > ( threshold * static_cast<double>(mesh->vList.size())) )
+			if ( static_cast<double>(stableNodes) > ( threshold * static_cast<double>(mesh->getNumberOfVertices())) )
 			{
 				threshold += 0.05;
 				divisor += 0.025;
@@ -351,22 +354,18 @@ else
 				notify( e );
 			}
 			++show;
-			if ( static_cast<double>(stableNodes) > ( 0.95 * static_cast<double>(mesh->vList.size())) )
+			if ( static_cast<double>(stableNodes) > ( 0.95 * static_cast<double>(mesh->getNumberOfVertices())) )
 			{
 				cerr << "Stability reached after " << i << " iterations" << endl;
 				i=1000;
 			}			
 		} // FOR iterations
-		cerr << "Mesh consists of " << mesh->vList.size() << " vertices" << endl;
+		cerr << "Mesh consists of " << mesh->getNumberOfVertices() << " vertices" << endl;
 		disc /= 2.0;
 		internal *= 10.0;
 		cerr << "Reinitialize mesh .. ";
-		for( list<SVertex*>::iterator vit = mesh->vList.begin(); vit != mesh->vList.end(); ++vit )
-		{
-			(*vit)->isStable = false;
-			(*vit)->stability = 0;
-			(*vit)->lastPositions.clear();
-		}
+		for( TIndex v = 0; v < mesh->getVertexCapacity(); ++v )
+			mesh->stabilityVec[v].clear();
 		cerr << "done" << endl;
 		double timetaken = t.elapsed();		
 		cerr << "Iteration with dr = " << disc*2.0 << " took " << timetaken << " secs ( " << timetaken/500.0 << " pI ) " << endl;
@@ -375,11 +374,6 @@ else
 	cerr << endl;
 	// Now save the mesh to a file
 	cerr << "Saving mesh to mousebrain.mesh" << endl;
-	ulong id = 0;
-	for( list<SVertex*>::iterator vit = mesh->vList.begin(); vit != mesh->vList.end(); ++vit, ++id )
-	{
-		(*vit)->ulID = id;
-	}
 
 /*	ofstream file( "mousebrain.mesh" );
 	file << id << endl;
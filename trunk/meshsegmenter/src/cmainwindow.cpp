@@ -18,6 +18,7 @@
 #include <vtkMarchingCubes.h>
 //#include <vtkGenericContourFilter.h>
 #include <fstream>
+#include <list>
 #include <string>
 #include <cisosurface.h>
 #include <clowpassfilter.h>
@@ -34,7 +35,7 @@ struct Pair
 {
 	int ulID1; // id of Point 1
 	int ulID2; // id of Point 2
-	SEdge* anEdgePtr;
+	TIndex anEdge;
 };
 
 bool pairLess( Pair& a, Pair& b ) 
@@ -312,35 +313,41 @@ void CMainWindow::transformBackMesh()
  	vtkCellArray *meshpolys = vtkCellArray::New();
 	vtkPoints *meshpts = vtkPoints::New();
 	
-	ulong i = 0;
-	for( list<SVertex*>::iterator it = work.vList.begin(); it != work.vList.end(); ++it, ++i )
+	// Number the vertices consecutively, skipping the holes of the mesh arrays
+	vector<vtkIdType> idVec( work.getVertexCapacity(), 0 );
+	vtkIdType i = 0;
+	for( TIndex v = 0; v < work.getVertexCapacity(); ++v )
 	{
-		(*it)->ulID = i;
+		if ( work.isVertex( v ) )
+			idVec[v] = i++;
 	}
 	vtkDoubleArray* pointForces = vtkDoubleArray::New();
 	
 	meshpts->SetNumberOfPoints( i );
-	for( list<SVertex*>::iterator it = work.vList.begin(); it != work.vList.end(); ++it )
+	for( TIndex v = 0; v < work.getVertexCapacity(); ++v )
 	{
-		double v[3];
-		v[0] = (*it)->thePosition[0];
-		v[1] = (*it)->thePosition[1];
-		v[2] = (*it)->thePosition[2];
-		meshpts->SetPoint( (*it)->ulID, v );
-		pointForces->InsertTuple1( (*it)->ulID, norm((*it)->theForce)*255.0 );
+		if ( !work.isVertex( v ) )
+			continue;
+		double p[3];
+		p[0] = work.positionVec[v][0];
+		p[1] = work.positionVec[v][1];
+		p[2] = work.positionVec[v][2];
+		meshpts->SetPoint( idVec[v], p );
+		pointForces->InsertTuple1( idVec[v], norm(work.forceVec[v])*255.0 );
 	}
 	
-	list<SFace*>::iterator ot = work.fList.begin();
 	vtkIdType pa[100];
 	vtkIdType* p = pa;
 	
 
-	for( uint i = 0; i < work.fList.size(); ++i )
+	for( TIndex f = 0; f < work.getFaceCapacity(); ++f )
 	{
-		p[0] = (*ot)->anEdgePtr->endPointPtr->ulID;
-		p[2] = (*ot)->anEdgePtr->nextEdgePtr->endPointPtr->ulID;
-		p[1] = (*ot)->anEdgePtr->nextEdgePtr->nextEdgePtr->endPointPtr->ulID;
-		++ot;
+		if ( !work.isFace( f ) )
+			continue;
+		TIndex e = work.getFaceEdge( f );
+		p[0] = idVec[work.getEndPoint( e )];
+		p[2] = idVec[work.getEndPoint( work.getNext( e ) )];
+		p[1] = idVec[work.getEndPoint( work.getNext( work.getNext( e ) ) )];
 		meshpolys->InsertNextCell( 3, p );
 	}	
 	outputMesh->SetPolys( meshpolys );
@@ -683,65 +690,40 @@ void CMainWindow::generateMeshFromVTK( bool flip )
 		}
 	}
 	// All data was read. Now build the vertex lists
-	vector<SVertex*> vVector;	
-	int ctn = 0; cerr << endl;
-	for( vector<TVIn>::iterator it = VV.begin(); it != VV.end(); ++it )
-	{
-			SVertex* v = new SVertex( it->thePosition );
-			if ( it->del == false ) 
-			{
-				v->ulID = vid; ++vid;
-				work.vList.push_back( v );
-			}
-			vVector.push_back( v );
-			switch( ctn )
-			{
-				case 0: fprintf(stderr, "-\b"); break;
-				case 1: fprintf(stderr, "/\b"); break;
-				case 2: fprintf(stderr, "|\b"); break;
-				case 3: fprintf(stderr, "\\\b"); break;
-			}
-			ctn++; if (ctn == 4) ctn = 0;
-	}
+	// Vertices are added to the mesh together with the first face using them
+	vector<TIndex> vVector( VV.size(), NO_INDEX );
 	cerr << " " << endl << "Generated vertex lists" << endl;
 	// Generate triangles
 	list<Pair> pairList;
 	for( list<TFIn>::iterator it = FL.begin(); it != FL.end(); ++it )
 	{
-		SFace* f = new SFace;
-		SVertex* p1 = vVector[ vertexMap[it->vts[0]] ];
-		SVertex* p2 = vVector[ vertexMap[it->vts[1]] ];
-		SVertex* p3 = vVector[ vertexMap[it->vts[2]] ];
-		SEdge* e1 = new SEdge( p2, f );
-		SEdge* e2 = new SEdge( p3, f );
-		SEdge* e3 = new SEdge( p1, f );
-		e1->nextEdgePtr = e2;
-		e2->nextEdgePtr = e3;
-		e3->nextEdgePtr = e1;
-
-		work.eList.push_back( e1 );
-		work.eList.push_back( e2 );
-		work.eList.push_back( e3 );
-		p1->anEdgePtr = e1;
-		p2->anEdgePtr = e2;
-		p3->anEdgePtr = e3;
-		f->anEdgePtr = e1;
-		work.fList.push_back(f);
+		TIndex corners[3];
+		for( int j = 0; j < 3; ++j )
+		{
+			ulong k = vertexMap[it->vts[j]];
+			if ( vVector[k] == NO_INDEX )
+				vVector[k] = work.addVertex( VV[k].thePosition );
+			corners[j] = vVector[k];
+		}
+		TIndex f = work.addFace( corners[0], corners[1], corners[2] );
+		TIndex e1 = work.getFaceEdge( f );
+		TIndex e2 = work.getNext( e1 );
+		TIndex e3 = work.getNext( e2 );
 		Pair p;
 		p.ulID1 = vertexMap[it->vts[0]];
 		p.ulID2 = vertexMap[it->vts[1]];
 		if ( p.ulID2 < p.ulID1 ) swap( p.ulID1, p.ulID2 );
-		p.anEdgePtr = e1;
+		p.anEdge = e1;
 		pairList.push_back( p );
 		p.ulID1 = vertexMap[it->vts[1]];
 		p.ulID2 = vertexMap[it->vts[2]];
 		if ( p.ulID2 < p.ulID1 ) swap( p.ulID1, p.ulID2 );
-		p.anEdgePtr = e2;
+		p.anEdge = e2;
 		pairList.push_back( p );
 		p.ulID1 = vertexMap[it->vts[2]];
 		p.ulID2 = vertexMap[it->vts[0]];
 		if ( p.ulID2 < p.ulID1 ) swap( p.ulID1, p.ulID2 );
-		p.anEdgePtr = e3;
+		p.anEdge = e3;
 		pairList.push_back( p );		
 	}
 	pairList.sort( pairLess );
@@ -752,9 +734,8 @@ void CMainWindow::generateMeshFromVTK( bool flip )
 		Pair p = *it; ++it;
 		if ( it->ulID1 == p.ulID1 && it->ulID2 == p.ulID2 )
 		{
-			p.anEdgePtr->opposingEdgePtr = it->anEdgePtr;
-			it->anEdgePtr->opposingEdgePtr = p.anEdgePtr;
-			if ( p.anEdgePtr->opposingEdgePtr->theFacePtr == it->anEdgePtr->opposingEdgePtr->theFacePtr )
+			work.setOpposing( p.anEdge, it->anEdge );
+			if ( work.getFace( p.anEdge ) == work.getFace( it->anEdge ) )
 			{
 				cerr << "Faces are identical!" << endl;
 				exit(-1);
@@ -765,10 +746,10 @@ void CMainWindow::generateMeshFromVTK( bool flip )
 		{
 			cout << "WARN: Pair " << p.ulID1 << "/" << p.ulID2 << " has no partner" << endl;
 			cout << "Next is " << it->ulID1 << "/" << it->ulID2 << endl;
-			p.anEdgePtr->opposingEdgePtr = p.anEdgePtr;
+			work.setOpposing( p.anEdge, p.anEdge );
 		}
 	}	
-	cerr << "Resulting mesh consists of " << work.fList.size() << " faces and " << work.vList.size() << " vertices" << endl;
+	cerr << "Resulting mesh consists of " << work.getNumberOfFaces() << " faces and " << work.getNumberOfVertices() << " vertices" << endl;
 }
 
 void CMainWindow::generateSimpleMesh()
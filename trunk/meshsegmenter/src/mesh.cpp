@@ -1,5 +1,8 @@
 
 #include "mesh.h"
+#include <algorithm>
+#include <limits>
+#include <queue>
  
 // void checkTopology( TMesh& mesh ) {}
 // void subdivide( TMesh& mesh, double length){}
@@ -41,17 +44,6 @@
 #define PR(s)
 #endif
 
-bool edgeLengthComp( SEdge* a, SEdge* b )
-{
-	SVertex* vv3 = a->endPointPtr;
-	SVertex* vv1 = a->nextEdgePtr->nextEdgePtr->endPointPtr;
-	double lengthA = norm( vv3->thePosition - vv1->thePosition );
-	vv3 = b->endPointPtr;
-	vv1 = b->nextEdgePtr->nextEdgePtr->endPointPtr;
-	double lengthB = norm( vv3->thePosition - vv1->thePosition );
-	return ( lengthA < lengthB );
-}
-
 bool veq( const TVector3D& a, const TVector3D& b, const double small = 0.00001 )
 {
 	bool equal = (fabs(b[0] - a[0])<=small) 
@@ -74,111 +66,237 @@ void progress()
 }
 
 
-CMesh::~CMesh()
+namespace
 {
-	reset();
-}
 
-void CMesh::reset()
+/// Guard against corrupt topology when walking around a vertex
+const int maxValence = 50;
+
+/// A half-edge together with its squared length, the shortest one is on top of the queue
+struct SEdgeLength
 {
-	for( list<SFace*>::iterator it = fList.begin(); it != fList.end(); ++it )
+	double length;
+	TIndex edge;
+	bool operator<( const SEdgeLength& other ) const
 	{
-		delete(*it);
+		return ( length > other.length || ( length == other.length && edge > other.edge ) );
 	}
-	for( list<SVertex*>::iterator it = vList.begin(); it != vList.end(); ++it )
+};
+
+/// Orders vertex indices by position
+struct SPositionLess
+{
+	const vector<TVector3D>* positionVecPtr;
+	bool operator()( TIndex a, TIndex b ) const
 	{
-		delete(*it);
+		const TVector3D& pa = (*positionVecPtr)[a];
+		const TVector3D& pb = (*positionVecPtr)[b];
+		if ( pa[0] != pb[0] ) return ( pa[0] < pb[0] );
+		if ( pa[1] != pb[1] ) return ( pa[1] < pb[1] );
+		return ( pa[2] < pb[2] );
 	}
-	for( list<SEdge*>::iterator it = eList.begin(); it != eList.end(); ++it )
+};
+
+/// Corners of a face, rotated so that the smallest index comes first
+struct SFaceKey
+{
+	TIndex v[3];
+	TIndex face;
+	bool operator<( const SFaceKey& other ) const
 	{
-		delete(*it);
+		for( int i = 0; i < 3; ++i )
+			if ( v[i] != other.v[i] )
+				return ( v[i] < other.v[i] );
+		return ( face < other.face );
 	}
-	for( deque<SFace*>::iterator it = facePool.begin(); it != facePool.end(); ++it )
+	bool sameCorners( const SFaceKey& other ) const
 	{
-		delete(*it);
+		return ( v[0] == other.v[0] && v[1] == other.v[1] && v[2] == other.v[2] );
 	}
-	for( deque<SVertex*>::iterator it = vertexPool.begin(); it != vertexPool.end(); ++it )
+};
+
+}
+
+CMesh::CMesh()
+{
+}
+
+CMesh::~CMesh()
+{
+}
+
+void CMesh::reset()
+{
+	positionVec.clear();
+	normalVec.clear();
+	forceVec.clear();
+	stabilityVec.clear();
+	vertexEdgeVec.clear();
+	edgeVec.clear();
+	faceEdgeVec.clear();
+	faceNormalVec.clear();
+	freeVertexVec.clear();
+	freeEdgeVec.clear();
+	freeFaceVec.clear();
+}
+
+/** \param thePosition position of the new vertex */
+TIndex CMesh::addVertex( const TVector3D& thePosition )
+{
+	TIndex v = newVertex();
+	positionVec[v] = thePosition;
+	return v;
+}
+
+/**
+ * The new half-edges run from v0 to v1, v1 to v2 and v2 to v0. Their
+ * opposing half-edges have to be set by setOpposing().
+ * \returns index of the new face. getFaceEdge() returns the half-edge from v0 to v1
+ */
+TIndex CMesh::addFace( TIndex v0, TIndex v1, TIndex v2 )
+{
+	TIndex f = newFace();
+	TIndex e0 = newEdge();
+	TIndex e1 = newEdge();
+	TIndex e2 = newEdge();
+	edgeVec[e0].set( v1, f, e1 );
+	edgeVec[e1].set( v2, f, e2 );
+	edgeVec[e2].set( v0, f, e0 );
+	vertexEdgeVec[v0] = e0;
+	vertexEdgeVec[v1] = e1;
+	vertexEdgeVec[v2] = e2;
+	faceEdgeVec[f] = e0;
+	return f;
+}
+
+/** Passing the same half-edge twice marks it as a border */
+void CMesh::setOpposing( TIndex e0, TIndex e1 )
+{
+	edgeVec[e0].opposing = e1;
+	edgeVec[e1].opposing = e0;
+}
+
+TIndex CMesh::newVertex()
+{
+	if ( !freeVertexVec.empty() )
 	{
-		delete(*it);
+		TIndex v = freeVertexVec.back();
+		freeVertexVec.pop_back();
+		return v;
 	}
-	for( deque<SEdge*>::iterator it = edgePool.begin(); it != edgePool.end(); ++it )
+	positionVec.push_back( TVector3D( 0.0 ) );
+	normalVec.push_back( TVector3D( 0.0 ) );
+	forceVec.push_back( TVector3D( 0.0 ) );
+	stabilityVec.push_back( SStability() );
+	vertexEdgeVec.push_back( NO_INDEX );
+	return vertexEdgeVec.size() - 1;
+}
+
+TIndex CMesh::newEdge()
+{
+	if ( !freeEdgeVec.empty() )
 	{
-		delete(*it);
+		TIndex e = freeEdgeVec.back();
+		freeEdgeVec.pop_back();
+		return e;
 	}
-	fList.clear();
-	vList.clear();
-	eList.clear();
-	vertexPool.clear();
-	facePool.clear();
-	edgePool.clear();
+	edgeVec.push_back( SHalfEdge() );
+	return edgeVec.size() - 1;
 }
 
-void CMesh::printFace( SFace* face )
+TIndex CMesh::newFace()
 {
-	printEdge( face->anEdgePtr );
-	printEdge( face->anEdgePtr->nextEdgePtr );
-	printEdge( face->anEdgePtr->nextEdgePtr->nextEdgePtr );
+	if ( !freeFaceVec.empty() )
+	{
+		TIndex f = freeFaceVec.back();
+		freeFaceVec.pop_back();
+		return f;
+	}
+	faceEdgeVec.push_back( NO_INDEX );
+	faceNormalVec.push_back( TVector3D( 0.0 ) );
+	return faceEdgeVec.size() - 1;
 }
 
-void CMesh::printVertex( SVertex* vertex )
+void CMesh::deleteVertex( TIndex v )
 {
-	cerr << vertex->thePosition << endl;
+	positionVec[v] = 0.0;
+	normalVec[v] = 0.0;
+	forceVec[v] = 0.0;
+	stabilityVec[v].clear();
+	vertexEdgeVec[v] = NO_INDEX;
+	freeVertexVec.push_back( v );
 }
 
-void CMesh::printEdge( SEdge* edge )
+void CMesh::deleteEdge( TIndex e )
 {
-	//cerr << "ID: " << edge->lID << ", nextEdgePtr: " << edge->nextEdgePtr->lID << ", face: " << edge->theFacePtr->anEdgePtr->lID;
-	cerr << ",opposingEdgePtr: ";
-/*	if ( edge->opposingEdgePtr )
-		cerr << edge->opposingEdgePtr->lID;
-	else
-		cerr << "NULL";*/
-	cerr << endl << ", endpoint: "; printVertex( edge->endPointPtr );
+	edgeVec[e] = SHalfEdge();
+	freeEdgeVec.push_back( e );
 }
 
-void CMesh::printMesh()
+void CMesh::deleteFace( TIndex f )
 {
-	cout << "Faces" << endl << "--------" << endl;
- 	for( list<SFace*>::iterator it = fList.begin(); it != fList.end(); ++it )
-	{ 
-		printFace( *it ); 
-		cerr << "---" << endl; 
-	}
- 	cout << "Vertices" << endl << "---------------" << endl;
- 	for( list<SVertex*>::iterator it = vList.begin(); it != vList.end(); ++it )
-		printVertex( *it );
-	cout << "Edges" << endl << "--------" << endl;
-	for( list<SEdge*>::iterator it = eList.begin(); it != eList.end(); ++it )
-		printEdge( *it );
+	faceEdgeVec[f] = NO_INDEX;
+	faceNormalVec[f] = 0.0;
+	freeFaceVec.push_back( f );
 }
 
-struct RegPair
+/** The start point of a half-edge is the end point of its predecessor in the triangle */
+double CMesh::squaredLength( TIndex e ) const
 {
-	SEdge* anEdgePtr; // The half edge that should be splitted
-	SVertex* nV; //the Vertex to insert
-};
+	const SHalfEdge& he = edgeVec[e];
+	TVector3D diff = positionVec[he.endPoint] - positionVec[edgeVec[edgeVec[he.next].next].endPoint];
+	return dot( diff, diff );
+}
 
-struct Rebuild
+void CMesh::printFace( TIndex f )
 {
-	SEdge* oldEdge; // The half edge that should be splitted
-	SEdge* newEdge1; //the Vertex to insert
-	SEdge* newEdge2; //the Vertex to insert
-	bool operator==( const Rebuild& r )
-	{
-		return( oldEdge == r.oldEdge && newEdge1 == r.newEdge1 && newEdge2 == r.newEdge2 );
-	}
-};
+	TIndex e = faceEdgeVec[f];
+	printEdge( e );
+	printEdge( edgeVec[e].next );
+	printEdge( edgeVec[edgeVec[e].next].next );
+}
+
+void CMesh::printVertex( TIndex v )
+{
+	cerr << positionVec[v][0] << " " << positionVec[v][1] << " " << positionVec[v][2] << endl;
+}
+
+void CMesh::printEdge( TIndex e )
+{
+	cerr << "ID: " << e << ", nextEdge: " << edgeVec[e].next << ", face: " << edgeVec[e].face
+		<< ", opposingEdge: " << edgeVec[e].opposing;
+	cerr << endl << ", endpoint: "; printVertex( edgeVec[e].endPoint );
+}
+
+void CMesh::printMesh()
+{
+	cout << "Faces" << endl << "--------" << endl;
+	for( TIndex f = 0; f < getFaceCapacity(); ++f )
+		if ( isFace( f ) )
+		{
+			printFace( f );
+			cerr << "---" << endl;
+		}
+	cout << "Vertices" << endl << "---------------" << endl;
+	for( TIndex v = 0; v < getVertexCapacity(); ++v )
+		if ( isVertex( v ) )
+			printVertex( v );
+	cout << "Edges" << endl << "--------" << endl;
+	for( TIndex e = 0; e < getEdgeCapacity(); ++e )
+		if ( isEdge( e ) )
+			printEdge( e );
+}
 
 void CMesh::triangleMelt( double minLength )
 {
-	for( list<SFace*>::iterator fit = fList.begin(); fit != fList.end(); ++fit )
+	for( TIndex f = 0; f < getFaceCapacity(); ++f )
 	{
-		TVector3D a( (*fit)->anEdgePtr->endPointPtr->thePosition[0], 
-			(*fit)->anEdgePtr->endPointPtr->thePosition[1], (*fit)->anEdgePtr->endPointPtr->thePosition[2] );
-		TVector3D b( (*fit)->anEdgePtr->nextEdgePtr->endPointPtr->thePosition[0], 
-			(*fit)->anEdgePtr->nextEdgePtr->endPointPtr->thePosition[1], (*fit)->anEdgePtr->nextEdgePtr->endPointPtr->thePosition[2] );
-		TVector3D c( (*fit)->anEdgePtr->nextEdgePtr->nextEdgePtr->endPointPtr->thePosition[0], 
-			(*fit)->anEdgePtr->nextEdgePtr->nextEdgePtr->endPointPtr->thePosition[1], (*fit)->anEdgePtr->nextEdgePtr->nextEdgePtr->endPointPtr->thePosition[2] );
+		if ( !isFace( f ) )
+			continue;
+		TIndex e = faceEdgeVec[f];
+		const TVector3D& a = positionVec[edgeVec[e].endPoint];
+		const TVector3D& b = positionVec[edgeVec[edgeVec[e].next].endPoint];
+		const TVector3D& c = positionVec[edgeVec[edgeVec[edgeVec[e].next].next].endPoint];
 		TVector3D v0 = a - b;
 		TVector3D v1 = b - c;
 		TVector3D v2 = c - a;
@@ -189,720 +307,643 @@ void CMesh::triangleMelt( double minLength )
 	}
 }
 
+/**
+ * Collapses all edges shorter than minLength, shortest first. The candidates
+ * are kept in a priority queue. After each collapse the edges around the
+ * remaining vertex are queued again with their new lengths, outdated entries
+ * are skipped when they come up. Edges whose collapse would make the mesh
+ * non-manifold are left alone.
+ */
 void CMesh::edgeMelt( double minLength )
 {
 PR("Edge melting... ")
-eList.sort( edgeLengthComp );	
-	list<SEdge*>::iterator global = eList.begin();
-	while( global != eList.end() )
+	const double minSquared = minLength * minLength;
+	priority_queue<SEdgeLength> candidates;
+	for( TIndex e = 0; e < getEdgeCapacity(); ++e )
+	{
+		if ( !isEdge( e ) )
+			continue;
+		SEdgeLength c;
+		c.length = squaredLength( e );
+		c.edge = e;
+		if ( c.length < minSquared )
+			candidates.push( c );
+	}
+	while( !candidates.empty() )
 	{
-		//cerr << ".";
-		// Check if actual edge is too large
-		SVertex* vv3 = (*global)->endPointPtr;
-		SVertex* vv1 = (*global)->nextEdgePtr->nextEdgePtr->endPointPtr;		
-		double length = norm( vv3->thePosition - vv1->thePosition );
-		if ( length < minLength )
+		SEdgeLength c = candidates.top();
+		candidates.pop();
+		if ( !isEdge( c.edge ) || squaredLength( c.edge ) != c.length )
+			continue;
+		TIndex e1 = c.edge;
+		TIndex e2 = edgeVec[e1].next;
+		TIndex e0 = edgeVec[e2].next;
+		TIndex e5 = edgeVec[e1].opposing;
+		TIndex e3 = edgeVec[e5].next;
+		TIndex e4 = edgeVec[e3].next;
+		TIndex v1 = edgeVec[e0].endPoint;
+		TIndex v2 = edgeVec[e1].endPoint;
+		if ( edgeVec[e4].next != e5 || edgeVec[e0].next != e1 )
+			cerr << "Triangle is corrupt" << endl;
+		if ( v1 != edgeVec[e5].endPoint || v2 != edgeVec[e4].endPoint )
 		{
-			progress();	
-			SEdge* e1 = *global;
-			SEdge* e2 = e1->nextEdgePtr;
-			SEdge* e0 = e2->nextEdgePtr;
-			SEdge* e5 = e1->opposingEdgePtr;
-			SEdge* e3 = e5->nextEdgePtr;
-			SEdge* e4 = e3->nextEdgePtr;
-			SVertex* v1 = e0->endPointPtr;
-			SVertex* v2 = e1->endPointPtr;
-			if ( e4->nextEdgePtr != e5 || e0->nextEdgePtr != e1 )
-				cerr << "Triangle is corrupt" << endl;
-			if ( v1 == e5->endPointPtr && v2 == e4->endPointPtr )
-			{					
-				SVertex* v0 = e2->endPointPtr;
-				SVertex* v3 = e3->endPointPtr;
-				SFace* f0 = e1->theFacePtr;
-				SFace* f1 = e5->theFacePtr;
-				// Find all edges which end up in our vertex v2 and update them to use v1
-				SEdge* startEdge = e4->opposingEdgePtr;
-				SEdge* actEdge = startEdge;
-				int i = 0;
-				do
-				{
-					if ( actEdge->endPointPtr == v2 )
-						actEdge->endPointPtr = v1;
-					else if ( actEdge->opposingEdgePtr->endPointPtr == v2 )
-						actEdge->opposingEdgePtr->endPointPtr = v1;
-					actEdge = actEdge->opposingEdgePtr->nextEdgePtr;
-//					cerr << actEdge << endl;
-					++i; if ( i > 50 ) { cerr << "Error" << endl; break;}
-				}
-				while( actEdge != startEdge );
-				//cerr << endl;
-				// Melt the edge and reset				
-				e0->opposingEdgePtr->opposingEdgePtr = e2->opposingEdgePtr;				
-				e2->opposingEdgePtr->opposingEdgePtr = e0->opposingEdgePtr;
-				e3->opposingEdgePtr->opposingEdgePtr = e4->opposingEdgePtr;
-				e4->opposingEdgePtr->opposingEdgePtr = e3->opposingEdgePtr;
-				v0->anEdgePtr = e2->opposingEdgePtr;
-				v1->anEdgePtr = e0->opposingEdgePtr;
-				v3->anEdgePtr = e3->opposingEdgePtr;
-				v1->thePosition = v1->thePosition + 0.5 * ( v2->thePosition - v1->thePosition );
-/*				cerr << e0->opposingEdgePtr->theFacePtr << endl;
-				cerr << e2->opposingEdgePtr->theFacePtr << endl;
-				cerr << e3->opposingEdgePtr->theFacePtr << endl;
-				cerr << e4->opposingEdgePtr->theFacePtr << endl;
-				cerr << endl;*/
-				eList.remove(e0); delete e0;//edgePool.push_back( e0 );
-				eList.remove(e1); delete e1;//edgePool.push_back( e1 );
-				eList.remove(e2); delete e2;//edgePool.push_back( e2 );
-				eList.remove(e3); delete e3;//edgePool.push_back( e3 );
-				eList.remove(e4); delete e4;//edgePool.push_back( e4 );
-				eList.remove(e5); delete e5;//edgePool.push_back( e5 );
-				vList.remove(v2);
-				v2->clear();
-				vertexPool.push_back( v2 );
-				fList.remove(f0); delete f0;//facePool.push_back( f0 );
-				fList.remove(f1); delete f1;//facePool.push_back( f1 );
-				eList.sort( edgeLengthComp );
-				global = eList.begin();
-			}
-			else
+			if ( v1 == edgeVec[e4].endPoint ) cerr << "V1->e4" << endl;
+			if ( v1 == edgeVec[e5].endPoint ) cerr << "V1->e5" << endl;
+			if ( v1 == edgeVec[e3].endPoint ) cerr << "V1->e3" << endl;
+			if ( v2 == edgeVec[e4].endPoint ) cerr << "V2->e4" << endl;
+			if ( v2 == edgeVec[e5].endPoint ) cerr << "V2->e5" << endl;
+			if ( v2 == edgeVec[e3].endPoint ) cerr << "V2->e3" << endl;
+			continue;
+		}
+		TIndex v0 = edgeVec[e2].endPoint;
+		TIndex v3 = edgeVec[e3].endPoint;
+		if ( !isCollapseAllowed( e1 ) )
+			continue;
+		progress();
+		TIndex f0 = edgeVec[e1].face;
+		TIndex f1 = edgeVec[e5].face;
+		// Find all edges which end up in our vertex v2 and update them to use v1
+		TIndex startEdge = edgeVec[e4].opposing;
+		TIndex actEdge = startEdge;
+		int i = 0;
+		do
+		{
+			if ( edgeVec[actEdge].endPoint == v2 )
+				edgeVec[actEdge].endPoint = v1;
+			else if ( edgeVec[edgeVec[actEdge].opposing].endPoint == v2 )
+				edgeVec[edgeVec[actEdge].opposing].endPoint = v1;
+			actEdge = edgeVec[edgeVec[actEdge].opposing].next;
+			++i; if ( i > maxValence ) { cerr << "Error" << endl; break;}
+		}
+		while( actEdge != startEdge );
+		// Melt the edge and reset
+		setOpposing( edgeVec[e0].opposing, edgeVec[e2].opposing );
+		setOpposing( edgeVec[e3].opposing, edgeVec[e4].opposing );
+		vertexEdgeVec[v0] = edgeVec[e2].opposing;
+		vertexEdgeVec[v1] = edgeVec[e0].opposing;
+		vertexEdgeVec[v3] = edgeVec[e3].opposing;
+		positionVec[v1] = positionVec[v1] + 0.5 * ( positionVec[v2] - positionVec[v1] );
+		deleteEdge( e0 );
+		deleteEdge( e1 );
+		deleteEdge( e2 );
+		deleteEdge( e3 );
+		deleteEdge( e4 );
+		deleteEdge( e5 );
+		deleteVertex( v2 );
+		deleteFace( f0 );
+		deleteFace( f1 );
+		// All edges touching v1 changed their length
+		startEdge = vertexEdgeVec[v1];
+		actEdge = startEdge;
+		i = 0;
+		do
+		{
+			TIndex edgePair[2] = { actEdge, edgeVec[actEdge].opposing };
+			for( int j = 0; j < 2; ++j )
 			{
-				if ( v1 == e4->endPointPtr ) cerr << "V1->e4" << endl;
-				if ( v1 == e5->endPointPtr ) cerr << "V1->e5" << endl;
-				if ( v1 == e3->endPointPtr ) cerr << "V1->e3" << endl;
-				if ( v2 == e4->endPointPtr ) cerr << "V2->e4" << endl;
-				if ( v2 == e5->endPointPtr ) cerr << "V2->e5" << endl;
-				if ( v2 == e3->endPointPtr ) cerr << "V2->e3" << endl;
-				++global;
+				c.length = squaredLength( edgePair[j] );
+				c.edge = edgePair[j];
+				if ( c.length < minSquared )
+					candidates.push( c );
 			}
+			actEdge = edgeVec[edgeVec[actEdge].opposing].next;
+			++i; if ( i > maxValence ) break;
 		}
-		else
-		{
-			++global;
-			progress();
- 		}
+		while( actEdge != startEdge );
 	}
-	//cerr << endl;
-PR("done\nMesh consists of " << vList.size() << " vertices and " << fList.size() << " faces." << endl)
+PR("done\nMesh consists of " << getNumberOfVertices() << " vertices and " << getNumberOfFaces() << " faces." << endl)
 }
 
+/**
+ * A collapse keeps the mesh manifold if the end points of the half-edge
+ * share no neighbours but the two opposite corners of its triangles.
+ */
+bool CMesh::isCollapseAllowed( TIndex e ) const
+{
+	TIndex v1 = edgeVec[e].endPoint;
+	TIndex v2 = edgeVec[edgeVec[e].opposing].endPoint;
+	TIndex neighbourArr[maxValence + 1];
+	int neighbours = 0;
+	TIndex startEdge = vertexEdgeVec[v1];
+	TIndex actEdge = startEdge;
+	do
+	{
+		if ( neighbours > maxValence )
+			return false;
+		neighbourArr[neighbours++] = edgeVec[actEdge].endPoint;
+		actEdge = edgeVec[edgeVec[actEdge].opposing].next;
+	}
+	while( actEdge != startEdge );
+	int shared = 0;
+	int i = 0;
+	startEdge = vertexEdgeVec[v2];
+	actEdge = startEdge;
+	do
+	{
+		if ( ++i > maxValence + 1 )
+			return false;
+		if ( find( neighbourArr, neighbourArr + neighbours, edgeVec[actEdge].endPoint )
+			!= neighbourArr + neighbours )
+			++shared;
+		actEdge = edgeVec[edgeVec[actEdge].opposing].next;
+	}
+	while( actEdge != startEdge );
+	return ( shared == 2 );
+}
+
+/**
+ * Flips edges longer than maxLength if the other diagonal of the two
+ * adjacent triangles is shorter. Edges at vertices with only three
+ * neighbours or whose flipped version already exists are left alone.
+ */
 void CMesh::edgeFlip( double maxLength )
 {
-	for( list<SEdge*>::iterator global = eList.begin(); global != eList.end(); ++global )
+	const double maxSquared = maxLength * maxLength;
+	for( TIndex e = 0; e < getEdgeCapacity(); ++e )
 	{
-		SVertex* v3 = (*global)->endPointPtr;
-		SVertex* v1 = (*global)->nextEdgePtr->nextEdgePtr->endPointPtr;		
-		double length = sqrt( (v3->thePosition[0]-v1->thePosition[0]) * (v3->thePosition[0]-v1->thePosition[0]) +
-			(v3->thePosition[1]-v1->thePosition[1]) * (v3->thePosition[1]-v1->thePosition[1]) +
-			(v3->thePosition[2]-v1->thePosition[2]) * (v3->thePosition[2]-v1->thePosition[2]) );
-		if ( length > maxLength )
+		if ( !isEdge( e ) )
+			continue;
+		TIndex o = edgeVec[e].opposing;
+		if ( o <= e )
+			continue;
+		double length = squaredLength( e );
+		if ( length <= maxSquared )
+			continue;
+		TIndex en = edgeVec[e].next;
+		TIndex ep = edgeVec[en].next;
+		TIndex on = edgeVec[o].next;
+		TIndex op = edgeVec[on].next;
+		TIndex a = edgeVec[o].endPoint;
+		TIndex b = edgeVec[e].endPoint;
+		TIndex c = edgeVec[en].endPoint;
+		TIndex d = edgeVec[on].endPoint;
+		TVector3D diagonal = positionVec[c] - positionVec[d];
+		if ( c == d || dot( diagonal, diagonal ) >= length )
+			continue;
+		// Count neighbours of a and b, look for an existing edge from c to d
+		uint valence[2] = { 0, 0 };
+		TIndex endPoints[2] = { a, b };
+		for( int j = 0; j < 2; ++j )
+		{
+			TIndex startEdge = vertexEdgeVec[endPoints[j]];
+			TIndex actEdge = startEdge;
+			do
+			{
+				++valence[j];
+				actEdge = edgeVec[edgeVec[actEdge].opposing].next;
+			}
+			while( actEdge != startEdge && valence[j] <= maxValence );
+		}
+		if ( valence[0] <= 3 || valence[1] <= 3 )
+			continue;
+		bool connected = false;
+		TIndex startEdge = vertexEdgeVec[c];
+		TIndex actEdge = startEdge;
+		int i = 0;
+		do
 		{
-			// Test			
+			connected = connected || ( edgeVec[actEdge].endPoint == d );
+			actEdge = edgeVec[edgeVec[actEdge].opposing].next;
+			++i;
 		}
+		while( actEdge != startEdge && i <= maxValence );
+		if ( connected )
+			continue;
+		// Triangles (a,b,c) and (b,a,d) become (d,c,a) and (c,d,b)
+		TIndex f0 = edgeVec[e].face;
+		TIndex f1 = edgeVec[o].face;
+		edgeVec[e].set( c, f0, ep, o );
+		edgeVec[ep].update( f0, on );
+		edgeVec[on].update( f0, e );
+		edgeVec[o].set( d, f1, op, e );
+		edgeVec[op].update( f1, en );
+		edgeVec[en].update( f1, o );
+		faceEdgeVec[f0] = e;
+		faceEdgeVec[f1] = o;
+		vertexEdgeVec[a] = on;
+		vertexEdgeVec[b] = en;
 	}
 }
 
+/**
+ * Splits all edges not shorter than maxLength at their midpoints and
+ * replaces each affected triangle by two, three or four new ones. This is
+ * repeated until no edge is too long.
+ * \returns number of edges split
+ */
 ulong CMesh::subdivide( double maxLength )
 {
 PR("Starting sd with ml " << maxLength << endl)
 	int sd=0;
-	uint last = vList.size();
-PR("Looking for edges to be subdivided ... ")
+	const double maxSquared = maxLength * maxLength;
+	vector<TIndex> splitVec;  // Midpoint vertex of each half-edge to split
+	vector<TIndex> firstVec;  // New half-edge replacing the first half of a split half-edge
+	vector<TIndex> secondVec; // New half-edge replacing the second half of a split half-edge
+	vector<TIndex> splitEdgeVec;
 	bool rego = true;
 	while( rego )
 	{
-		list<RegPair> local;
-		list<SFace*> newFaces;
 		rego = false;
-		for( list<SEdge*>::iterator global = eList.begin(); global != eList.end(); ++global )
-		{		
-			progress();
-			if ( (*global)->bDelete == false )
-			{
-			// Look at local
-			// Determine edge length
-			SVertex* v3 = (*global)->endPointPtr;
-			SVertex* v2 = (*global)->nextEdgePtr->endPointPtr;
-			SVertex* v1 = (*global)->nextEdgePtr->nextEdgePtr->endPointPtr;
-			TVector3D diff = v3->thePosition - v1->thePosition;
-			TVector3D diff2 = v2->thePosition - v1->thePosition;
-			double length = norm(diff);
-			// This triangle is too large, we need to subdivide all edges
-/*			if ( !rego && (length*length2)>(maxLength*maxLength) )
+PR("Looking for edges to be subdivided ... ")
+		const TIndex edgeCount = getEdgeCapacity();
+		splitVec.assign( edgeCount, NO_INDEX );
+		firstVec.assign( edgeCount, NO_INDEX );
+		secondVec.assign( edgeCount, NO_INDEX );
+		splitEdgeVec.clear();
+		for( TIndex e = 0; e < edgeCount; ++e )
+		{
+			if ( !isEdge( e ) || splitVec[e] != NO_INDEX || squaredLength( e ) < maxSquared )
+				continue;
+			rego = true;
+			++sd;
+			TIndex o = edgeVec[e].opposing;
+			TIndex v3 = edgeVec[e].endPoint;
+			TIndex v1 = edgeVec[edgeVec[edgeVec[e].next].next].endPoint;
+			TIndex v = newVertex();
+			positionVec[v] = positionVec[v1] + ( positionVec[v3] - positionVec[v1] ) * 0.5;
+			splitVec[e] = v;
+			splitEdgeVec.push_back( e );
+			if ( o != e )
 			{
-				rego = true; // cerr << "~";
-			}*/
-			if ( length >= maxLength )
+				splitVec[o] = v;
+				splitEdgeVec.push_back( o );
+			}
+		}
+		if ( !rego )
+			break;
+PR("done" << endl << "Subdividing faces... ")
+		const TIndex faceCount = getFaceCapacity();
+		for( TIndex f = 0; f < faceCount; ++f )
+		{
+			if ( !isFace( f ) )
+				continue;
+			TIndex h[3];
+			h[0] = faceEdgeVec[f];
+			h[1] = edgeVec[h[0]].next;
+			h[2] = edgeVec[h[1]].next;
+			// Faces created in this pass may contain half-edges beyond edgeCount
+			int found = 0;
+			TIndex split = NO_INDEX;
+			TIndex unsplit = NO_INDEX;
+			for( int i = 0; i < 3; ++i )
 			{
-				if (!rego) {rego=true;}//cerr << "~";}
-				++sd;
-				(*global)->opposingEdgePtr->bDelete = true;
-				(*global)->bDelete= true;
-				RegPair rp;
-				SVertex* v;
-/*				if ( !vertexPool.empty() )
-				{
-					v = vertexPool.front();
-					vertexPool.pop_front();
-				}
-				else*/
-					v = new SVertex;
-				//v->bOld = false;
-				//v->id = vid; ++vid;
-				v->thePosition = v1->thePosition + ( v3->thePosition - v1->thePosition ) * 0.5;
-				rp.anEdgePtr = (*global);
-				list<SVertex*>::iterator vit = vList.begin();
-				while( vit != vList.end() )
+				if ( h[i] < edgeCount && splitVec[h[i]] != NO_INDEX )
 				{
-					if ( veq( (*vit)->thePosition, v->thePosition ) )
-					{
-						cerr << "A " << (*vit)->thePosition[0] << " " << (*vit)->thePosition[1] << " " << (*vit)->thePosition[2] << " " << endl;
-						cerr << "B " << v->thePosition[0] << " " << v->thePosition[1] << " " << v->thePosition[2] << " " << endl;
-						rp.nV = (*vit);
-						break;
-						//exit(1);
-					}
-					++vit;
-				}
-				if ( vit == vList.end() )
-				{
-					rp.nV = v;
-					vList.push_back( v );
+					++found;
+					split = h[i];
 				}
 				else
-				{
-					delete v;
-					//v->clear();
-					//vertexPool.push_back( v );
-				}
-				local.push_back( rp );
-				rp.anEdgePtr = (*global)->opposingEdgePtr;
-				local.push_back( rp );
+					unsplit = h[i];
 			}
-		}		
-	}
-PR("done" << endl << "Marking all faces to be subdivided... ")
-	list<Rebuild> reb;
-	
-	for( list<SFace*>::iterator fit = fList.begin(); fit != fList.end(); ++fit )
-	{
-		progress();
-		SEdge* e0 = (*fit)->anEdgePtr;
-		SEdge* e1 = (*fit)->anEdgePtr->nextEdgePtr;
-		SEdge* e2 = (*fit)->anEdgePtr->nextEdgePtr->nextEdgePtr;
-		int found = 0;
-		RegPair reg[3];
-		for( list<RegPair>::iterator rit = local.begin(); rit != local.end(); ++rit )
-		{			
-			if ( ((*rit).anEdgePtr == e0 ) || ((*rit).anEdgePtr == e1 ) || ((*rit).anEdgePtr == e2 ))
-			{
-				reg[found] = (*rit); found++;
-			}
-			if ( found == 3 ) break;
-		}
-		if ( found > 0 )
-		{
-			if ( found == 3 && ( reg[1].anEdgePtr->nextEdgePtr == reg[0].anEdgePtr || reg[2].anEdgePtr->nextEdgePtr == reg[1].anEdgePtr 
-						|| reg[0].anEdgePtr->nextEdgePtr == reg[2].anEdgePtr ) )
-				swap( reg[2], reg[0] );
-			else if ( found == 2 && reg[1].anEdgePtr->nextEdgePtr == reg[0].anEdgePtr )
-				swap( reg[1], reg[0] );						
-// 			cout << "Need to subdivide " << found << " edges on face " << (*fit)->anEdgePtr->id << endl;
 			if ( found == 1 )
 			{
-//  				cerr << "Found 1 " << endl;
-				SVertex* w = reg[0].nV; 
-				SVertex* v1 = reg[0].anEdgePtr->endPointPtr;
-				SVertex* v2 = reg[0].anEdgePtr->nextEdgePtr->endPointPtr;				
-				SVertex* v0 = reg[0].anEdgePtr->nextEdgePtr->nextEdgePtr->endPointPtr;
-				SEdge* e0 = reg[0].anEdgePtr;
-				SEdge* e1 = reg[0].anEdgePtr->nextEdgePtr;
-				SEdge* e2 = reg[0].anEdgePtr->nextEdgePtr->nextEdgePtr;
-				SFace* f = reg[0].anEdgePtr->nextEdgePtr->theFacePtr;
-// 				cerr << "Old face is "; printFace(f);
-				SFace* fa;
-/*				if ( !facePool.empty() )
-				{
-					fa = facePool.front();
-					facePool.pop_front();
-				}
-				else*/
-					fa = new SFace;
-				fa->iTag=0;
-				SEdge* d[4];
+				// Split edge runs from v0 to v1
+				TIndex e0 = split;
+				TIndex w = splitVec[e0];
+				TIndex e1 = edgeVec[e0].next;
+				TIndex e2 = edgeVec[e1].next;
+				TIndex v1 = edgeVec[e0].endPoint;
+				TIndex v2 = edgeVec[e1].endPoint;
+				TIndex v0 = edgeVec[e2].endPoint;
+				TIndex fa = newFace();
+				TIndex d[4];
 				for ( int i = 0; i < 4; ++i )
-				{
-/*					if ( !edgePool.empty() )
-					{
-						d[i] = edgePool.front();
-						edgePool.pop_front();
-					}
-					else*/
-						d[i] = new SEdge;
-				}
-				f->anEdgePtr = d[0];
-				fa->anEdgePtr = d[1];
-				d[0]->set( v1, f, e1 );
-				w->anEdgePtr = d[0];
-				e1->update( f, d[3] );
-				d[3]->set(  w, f, d[0], d[2] );
-				
-				
-				d[1]->set(  w, fa, d[2] );
-				v0->anEdgePtr = d[1];
-				d[2]->set( v2, fa, e2, d[3] );
-				e2->update( fa, d[1] );
-								
-				newFaces.push_back( fa );
-				eList.remove( e0 );
-				e0->bOld = true;
-				Rebuild r;
-				r.oldEdge = e0; r.newEdge1 = d[1]; r.newEdge2 = d[0]; 
-				reb.push_back( r );
-				for( int i = 0; i < 4; ++i )
-					eList.push_back( d[i] );
+					d[i] = newEdge();
+				faceEdgeVec[f] = d[0];
+				faceEdgeVec[fa] = d[1];
+				edgeVec[d[0]].set( v1, f, e1 );
+				vertexEdgeVec[w] = d[0];
+				edgeVec[e1].update( f, d[3] );
+				edgeVec[d[3]].set(  w, f, d[0], d[2] );
+
+				edgeVec[d[1]].set(  w, fa, d[2] );
+				vertexEdgeVec[v0] = d[1];
+				edgeVec[d[2]].set( v2, fa, e2, d[3] );
+				edgeVec[e2].update( fa, d[1] );
+				firstVec[e0] = d[1]; secondVec[e0] = d[0];
 			}
 			else if ( found == 2 )
 			{
-				SVertex* w = reg[0].nV; 
-				SVertex* x = reg[1].nV; 
-				SVertex* v1 = reg[0].anEdgePtr->endPointPtr;
-				SVertex* v2 = reg[0].anEdgePtr->nextEdgePtr->endPointPtr;				
-				SVertex* v0 = reg[0].anEdgePtr->nextEdgePtr->nextEdgePtr->endPointPtr;
-				SFace* f = reg[0].anEdgePtr->theFacePtr;
-				SEdge* e0 = reg[0].anEdgePtr;
-				SEdge* e1 = reg[0].anEdgePtr->nextEdgePtr;
-				SEdge* e2 = reg[0].anEdgePtr->nextEdgePtr->nextEdgePtr;
-				
-				SFace* fa;
-				SFace* fb;
-/*				if ( !facePool.empty() )
-				{
-					fa = facePool.front();
-					facePool.pop_front();
-				}
-				else*/
-					fa = new SFace;
-/*				if ( !facePool.empty() )
-				{
-					fb = facePool.front();
-					facePool.pop_front();
-				}
-				else*/
-					fb = new SFace;
-				fa->iTag = 0;
-				fb->iTag = 0;
-
-				SEdge* d[8];
+				// Split edges run from v0 to v1 and from v1 to v2
+				TIndex e0 = edgeVec[unsplit].next;
+				TIndex e1 = edgeVec[e0].next;
+				TIndex e2 = unsplit;
+				TIndex w = splitVec[e0];
+				TIndex x = splitVec[e1];
+				TIndex v1 = edgeVec[e0].endPoint;
+				TIndex v2 = edgeVec[e1].endPoint;
+				TIndex v0 = edgeVec[e2].endPoint;
+				TIndex fa = newFace();
+				TIndex fb = newFace();
+				TIndex d[8];
 				for ( int i = 0; i < 8; ++i )
-				{
-/*					if ( !edgePool.empty() )
-					{
-						d[i] = edgePool.front();
-						edgePool.pop_front();
-					}
-					else*/
-						d[i] = new SEdge;
-				}
-				
-				f->anEdgePtr = d[0];
-				fa->anEdgePtr = d[3];
-				fb->anEdgePtr = d[1];
-				
-				d[0]->set(  w, f, d[4] );
-				v0->anEdgePtr = d[0] ;
-				d[4]->set( v2, f, e2, d[5] );
-				e2->update( f, d[0] );
-
-				d[1]->set( v1, fb, d[2] );
-				d[2]->set(  x, fb, d[7] );
-				d[7]->set(  w, fb, d[1], d[6] );
-				w->anEdgePtr=d[1];
-				x->anEdgePtr=d[7];
-				v1->anEdgePtr=d[2];
-
-				d[3]->set( v2, fa, d[5] );
-				d[5]->set(  w, fa, d[6], d[4] );
-				d[6]->set(  x, fa, d[3], d[7] );
-								
- 				newFaces.push_back( fa );
- 				newFaces.push_back( fb );
-				eList.remove( e0 );
-				eList.remove( e1 );
-				e0->bOld = true;
-				e1->bOld = true;
-				Rebuild r;
-				r.oldEdge = e0; r.newEdge1 = d[0]; r.newEdge2 = d[1]; reb.push_back( r );
-				r.oldEdge = e1; r.newEdge1 = d[2]; r.newEdge2 = d[3]; reb.push_back( r );
-				for( int i = 0; i < 8; ++i )
-					eList.push_back( d[i] );
+					d[i] = newEdge();
+
+				faceEdgeVec[f] = d[0];
+				faceEdgeVec[fa] = d[3];
+				faceEdgeVec[fb] = d[1];
+
+				edgeVec[d[0]].set(  w, f, d[4] );
+				vertexEdgeVec[v0] = d[0];
+				edgeVec[d[4]].set( v2, f, e2, d[5] );
+				edgeVec[e2].update( f, d[0] );
+
+				edgeVec[d[1]].set( v1, fb, d[2] );
+				edgeVec[d[2]].set(  x, fb, d[7] );
+				edgeVec[d[7]].set(  w, fb, d[1], d[6] );
+				vertexEdgeVec[w] = d[1];
+				vertexEdgeVec[x] = d[7];
+				vertexEdgeVec[v1] = d[2];
+
+				edgeVec[d[3]].set( v2, fa, d[5] );
+				edgeVec[d[5]].set(  w, fa, d[6], d[4] );
+				edgeVec[d[6]].set(  x, fa, d[3], d[7] );
+				firstVec[e0] = d[0]; secondVec[e0] = d[1];
+				firstVec[e1] = d[2]; secondVec[e1] = d[3];
 			}
-		  if ( found == 3 )
+			else if ( found == 3 )
 			{
-// 				cerr << "Found 3 " << endl;
-				SVertex* w = reg[2].nV; 
-				SVertex* y = reg[1].nV; 
-				SVertex* x = reg[0].nV; 
-				SVertex* v2 = reg[1].anEdgePtr->endPointPtr;
-				SVertex* v1 = reg[0].anEdgePtr->endPointPtr;
-				SVertex* v0 = reg[2].anEdgePtr->endPointPtr;												
-				SEdge* e0 = reg[0].anEdgePtr;
-				SEdge* e1 = reg[1].anEdgePtr;
-				SEdge* e2 = reg[2].anEdgePtr;
-				
-				if( e0->nextEdgePtr == e2 )
-				{
-					cerr << "SWAP" << endl;					
-					exit(1);
-				}						
-						
-				SFace* f = reg[0].anEdgePtr->theFacePtr;
-				SFace* fa;
-				SFace* fb;
-				SFace* fc;
-/*				if ( !facePool.empty() )
-				{
-					fa = facePool.front();
-					facePool.pop_front();
-				}
-				else*/
-					fa = new SFace;
-/*				if ( !facePool.empty() )
-				{
-					fb = facePool.front();
-					facePool.pop_front();
-				}
-				else*/
-					fb = new SFace;
-/*				if ( !facePool.empty() )
-				{
-					fc = facePool.front();
-					facePool.pop_front();
-				}
-				else*/
-					fc = new SFace;
-				SEdge* d[12];
+				TIndex e0 = h[0];
+				TIndex e1 = h[1];
+				TIndex e2 = h[2];
+				TIndex x = splitVec[e0];
+				TIndex y = splitVec[e1];
+				TIndex w = splitVec[e2];
+				TIndex v1 = edgeVec[e0].endPoint;
+				TIndex v2 = edgeVec[e1].endPoint;
+				TIndex v0 = edgeVec[e2].endPoint;
+				TIndex fa = newFace();
+				TIndex fb = newFace();
+				TIndex fc = newFace();
+				TIndex d[12];
 				for ( int i = 0; i < 12; ++i )
-				{
-/*					if ( !edgePool.empty() )
-					{
-						d[i] = edgePool.front();
-						edgePool.pop_front();
-					}
-					else*/
-						d[i] = new SEdge;
-				}
-								
-				f->anEdgePtr = d[0];
-				fa->anEdgePtr = d[1];
-				fb->anEdgePtr = d[3];
-				fc->anEdgePtr = d[7];
-				newFaces.push_back( fa );
-				newFaces.push_back( fb );
-				newFaces.push_back( fc );
-				
-				d[0]->set(  x, f, d[6] );
-				v0->anEdgePtr= d[0] ;
-				d[6]->set(  w, f, d[5], d[7] );
-				x->anEdgePtr= d[6] ;
-				d[5]->set( v0, f, d[0] );
-				w->anEdgePtr=d[5];
-
-				d[1]->set( v1, fa, d[2] );				
-				d[2]->set(  y, fa, d[8] );
-				v1->anEdgePtr= d[2] ;				
-				d[8]->set(  x, fa, d[1], d[9] );								
-				y->anEdgePtr=d[8] ;
-
-				d[3]->set( v2, fb, d[4] );
-				d[4]->set(  w, fb, d[10] );
-				v2->anEdgePtr=d[4];
-				d[10]->set( y, fb, d[3], d[11] );				
-
-				d[7]->set( x, fc, d[9], d[6] );
-				d[9]->set( y, fc, d[11], d[8] );
-				d[11]->set( w, fc, d[7], d[10] );				
-					
-				eList.remove( e0 );
-				eList.remove( e1 );
-				eList.remove( e2 );
-				e0->bOld = true;
-				e1->bOld = true;
-				e2->bOld = true;
-				Rebuild r;
-				r.oldEdge = e0; r.newEdge1 = d[0]; r.newEdge2 = d[1]; reb.push_back( r );
-				r.oldEdge = e1; r.newEdge1 = d[2]; r.newEdge2 = d[3]; reb.push_back( r );
-				r.oldEdge = e2; r.newEdge1 = d[4]; r.newEdge2 = d[5]; reb.push_back( r );
-				for( int i = 0; i < 12; ++i )
-					eList.push_back( d[i] );
+					d[i] = newEdge();
+
+				faceEdgeVec[f] = d[0];
+				faceEdgeVec[fa] = d[1];
+				faceEdgeVec[fb] = d[3];
+				faceEdgeVec[fc] = d[7];
+
+				edgeVec[d[0]].set(  x, f, d[6] );
+				vertexEdgeVec[v0] = d[0];
+				edgeVec[d[6]].set(  w, f, d[5], d[7] );
+				vertexEdgeVec[x] = d[6];
+				edgeVec[d[5]].set( v0, f, d[0] );
+				vertexEdgeVec[w] = d[5];
+
+				edgeVec[d[1]].set( v1, fa, d[2] );
+				edgeVec[d[2]].set(  y, fa, d[8] );
+				vertexEdgeVec[v1] = d[2];
+				edgeVec[d[8]].set(  x, fa, d[1], d[9] );
+				vertexEdgeVec[y] = d[8];
+
+				edgeVec[d[3]].set( v2, fb, d[4] );
+				edgeVec[d[4]].set(  w, fb, d[10] );
+				vertexEdgeVec[v2] = d[4];
+				edgeVec[d[10]].set( y, fb, d[3], d[11] );
+
+				edgeVec[d[7]].set( x, fc, d[9], d[6] );
+				edgeVec[d[9]].set( y, fc, d[11], d[8] );
+				edgeVec[d[11]].set( w, fc, d[7], d[10] );
+				firstVec[e0] = d[0]; secondVec[e0] = d[1];
+				firstVec[e1] = d[2]; secondVec[e1] = d[3];
+				firstVec[e2] = d[4]; secondVec[e2] = d[5];
 			}
 		}
-	}
-	// Rebuild topology
-PR("Done" << endl << "Rebuilding topology ... ")
-	bool changed = true;
-	while( !reb.empty() && changed )
-	{
-		progress();
-		changed = false;
-		Rebuild r = *(reb.begin());
-		for( list<Rebuild>::iterator rit = reb.begin(); rit != reb.end(); ++rit )
-		{			
-			if ( rit->oldEdge->opposingEdgePtr == r.oldEdge )
+		// Rebuild topology
+PR("done" << endl << "Rebuilding topology ... ")
+		for( vector<TIndex>::iterator it = splitEdgeVec.begin(); it != splitEdgeVec.end(); ++it )
+		{
+			TIndex e = *it;
+			TIndex o = edgeVec[e].opposing;
+			if ( o == e )
 			{
-				r.newEdge1->opposingEdgePtr = rit->newEdge2;
-				r.newEdge2->opposingEdgePtr = rit->newEdge1;
-				rit->newEdge1->opposingEdgePtr = r.newEdge2;
-				rit->newEdge2->opposingEdgePtr = r.newEdge1;
-/*				cout << "Reb " << rit->oldEdge->id << " / " << r.oldEdge->id 
-					<< " to " << rit->newEdge2->id << " / " << r.newEdge1->id << " and " << rit->newEdge1->id
-					<< " / " << r.newEdge2->id << endl;				*/
-				SEdge* a = rit->oldEdge;
-				SEdge* b = r.oldEdge;					
-				reb.remove( *rit );
-				reb.remove( r );
-				//edgePool.push_back( a );
-				//edgePool.push_back( b );
-				delete a;
-				delete b;
-				changed = true;
-				break;
+				setOpposing( firstVec[e], firstVec[e] );
+				setOpposing( secondVec[e], secondVec[e] );
+			}
+			else if ( e < o )
+			{
+				setOpposing( firstVec[e], secondVec[o] );
+				setOpposing( secondVec[e], firstVec[o] );
 			}
 		}
-	}
-	fList.insert( fList.end(), newFaces.begin(), newFaces.end() );
-PR("done" << endl << "Mesh size is " << fList.size() << " faces" << endl)
-	if ( vList.size() == last ) rego = false;
+		for( vector<TIndex>::iterator it = splitEdgeVec.begin(); it != splitEdgeVec.end(); ++it )
+			deleteEdge( *it );
+PR("done" << endl << "Mesh size is " << getNumberOfFaces() << " faces" << endl)
 	}
 	return sd;
 }
 
 void CMesh::computeNormals()
 {
-// 	cerr << "Computing face normals... ";
-	for( list<SFace*>::iterator it = fList.begin(); it != fList.end(); ++it )
+	for( TIndex f = 0; f < getFaceCapacity(); ++f )
 	{
-		TVector3D p1 = (*it)->anEdgePtr->endPointPtr->thePosition;
-		TVector3D p2 = (*it)->anEdgePtr->nextEdgePtr->endPointPtr->thePosition;
-		TVector3D p3 = (*it)->anEdgePtr->nextEdgePtr->nextEdgePtr->endPointPtr->thePosition;
+		if ( !isFace( f ) )
+			continue;
+		TIndex e = faceEdgeVec[f];
+		const TVector3D& p1 = positionVec[edgeVec[e].endPoint];
+		const TVector3D& p2 = positionVec[edgeVec[edgeVec[e].next].endPoint];
+		const TVector3D& p3 = positionVec[edgeVec[edgeVec[edgeVec[e].next].next].endPoint];
 		TVector3D d1 = p2 - p1;
-		TVector3D d2 = p3 - p1; 
+		TVector3D d2 = p3 - p1;
 		if ( norm(d1) > 0.00001 && norm(d2) > 0.00001 )
 		{
-			d1 = d1 * (1.0/norm(d1));			
+			d1 = d1 * (1.0/norm(d1));
 			d2 = d2 * (1.0/norm(d2));
-			TVector3D normal = cross(d1,d2);		
-			(*it)->theNormal = normal;
+			faceNormalVec[f] = cross(d1,d2);
 		}
 		else
 		{
-			(*it)->theNormal = (*it)->anEdgePtr->endPointPtr->thePosition;
-			(*it)->theNormal /= norm( (*it)->theNormal );
+			faceNormalVec[f] = p1;
+			faceNormalVec[f] /= norm( p1 );
 		}
 	}
-// 	cerr << "done" << endl << "Computing vertex normals... ";
-	for( list<SVertex*>::iterator vit = vList.begin(); vit != vList.end(); ++vit )
+	for( TIndex v = 0; v < getVertexCapacity(); ++v )
 	{
-		if ((*vit) != NULL)
+		if ( !isVertex( v ) )
+			continue;
+		TIndex startEdge = vertexEdgeVec[v];
+		TIndex actEdge = startEdge;
+		TVector3D normal = 0.0;
+		uint uiNoOfFaces = 0;
+		do
 		{
-			SEdge* startEdge = (*vit)->anEdgePtr;
-			SEdge* actEdge = startEdge;
-			TVector3D normal = 0.0;
-			uint uiNoOfFaces = 0;
-			do
-			{
-					normal += actEdge->theFacePtr->theNormal;
-				uiNoOfFaces++;
-				actEdge = actEdge->opposingEdgePtr->nextEdgePtr;
-			}
-			while( actEdge != startEdge );
-			if ( uiNoOfFaces == 0 )
-				exit(-1);
-			normal /= uiNoOfFaces;
-			(*vit)->theNormal = normal;
-		 }
-		 else
-		 {
-		 	cerr << "Current vertex is NULL" << endl;
-		 }
+			normal += faceNormalVec[edgeVec[actEdge].face];
+			uiNoOfFaces++;
+			actEdge = edgeVec[edgeVec[actEdge].opposing].next;
+		}
+		while( actEdge != startEdge );
+		normal /= uiNoOfFaces;
+		normalVec[v] = normal;
 	}
-// 	cerr << "done" << endl;
 }
 
+/**
+ * Reports the triangle orientation and merges vertices closer than 0.1 as
+ * well as triangles sharing all corners. Candidates are found by sorting, so
+ * only neighbours in lexicographic order of position are merged.
+ */
 void CMesh::checkTopology()
 {
 	ulong cw = 0;
 	ulong ccw = 0;
 	computeNormals();
 PR("Checking triangle orientation... ")
-	for( list<SFace*>::iterator it = fList.begin(); it != fList.end(); ++it )
-	{		
-		progress();
-		TVector3D v0 = (*it)->anEdgePtr->endPointPtr->thePosition;
-		TVector3D v1 = (*it)->anEdgePtr->endPointPtr->thePosition;
-		TVector3D v2 = (*it)->anEdgePtr->endPointPtr->thePosition;
+	for( TIndex f = 0; f < getFaceCapacity(); ++f )
+	{
+		if ( !isFace( f ) )
+			continue;
+		TIndex e = faceEdgeVec[f];
+		const TVector3D& v0 = positionVec[edgeVec[e].endPoint];
+		const TVector3D& v1 = positionVec[edgeVec[edgeVec[e].next].endPoint];
+		const TVector3D& v2 = positionVec[edgeVec[edgeVec[edgeVec[e].next].next].endPoint];
 		TVector3D n0 = cross( v0, v1 );
 		TVector3D n1 = cross( v1, v2 );
 		TVector3D n2 = cross( v2, v0 );
-		double area = dot( (*it)->theNormal, n0+n1+n2);
+		double area = dot( faceNormalVec[f], n0+n1+n2);
 		if ( area > 0 ) ccw++;
 		else cw++;
 	}
 PR(ccw << " CCW and " << cw << " CW triangles" << endl << "Checking for doubled vertices... ")
-	list<SVertex*> localVList = vList;
-	localVList.sort();
+	SPositionLess positionLess;
+	positionLess.positionVecPtr = &positionVec;
+	vector<TIndex> sortedVec;
+	sortedVec.reserve( getNumberOfVertices() );
+	for( TIndex v = 0; v < getVertexCapacity(); ++v )
+		if ( isVertex( v ) )
+			sortedVec.push_back( v );
+	sort( sortedVec.begin(), sortedVec.end(), positionLess );
 	ulong dv = 0;
-	for( list<SVertex*>::iterator it = localVList.begin(); it != localVList.end(); ++it )
-	{		
-		list<SVertex*>::iterator su = it; ++su;
-		if ( su != localVList.end() && veq( (*su)->thePosition,(*it)->thePosition, 0.1 ) )
+	for( size_t i = 1; i < sortedVec.size(); ++i )
+		if ( veq( positionVec[sortedVec[i]], positionVec[sortedVec[i-1]], 0.1 ) )
 			dv++;
-	}
 PR("found " << dv << " illegal pairs" << endl << "Correcting doubled vertices... ")
-	
-	localVList = vList;
-	localVList.sort();
-	dv = 0;
-	for( list<SVertex*>::iterator it = localVList.begin(); it != localVList.end(); ++it )
-	{		
-		progress();
-		list<SVertex*>::iterator su = it; ++su;
-		if ( su != localVList.end() && veq( (*su)->thePosition, (*it)->thePosition, 0.1) )
-		{
-			// Find these points in the original list and update all edges which contain these points
-			// Find first occurence
-			list<SVertex*>::iterator fo = vList.begin();
-			while( fo != vList.end() ) 
-			{
-				if ( veq((*fo)->thePosition , (*it)->thePosition, 0.1 ) )
-					break;
-				else
-					++fo;
-			}
-			// Find second occurence
-			list<SVertex*>::iterator so = fo; ++so;
-			while( so != vList.end() ) 
-			{
-				if ( veq((*so)->thePosition , (*it)->thePosition, 0.1 ) )
-					break;
-				else
-					++so;
-			}
-			SVertex* tod = *so;
-			// Update edges
-			for ( list<SEdge*>::iterator ei = eList.begin(); ei != eList.end(); ++ei )
-				if ( (*ei)->endPointPtr == (*so) )
-					(*ei)->endPointPtr = (*fo);
-			
-			// Remove second occurence
-			vList.remove( tod );			
-			delete tod;
-/*			tod->clear();
-			vertexPool.push_back( tod );*/
-			// Reset iterators
-			localVList = vList;
-			localVList.sort();
-			it = localVList.begin();
-		}
+	vector<TIndex> mergeVec( getVertexCapacity(), NO_INDEX );
+	TIndex survivor = NO_INDEX;
+	for( size_t i = 0; i < sortedVec.size(); ++i )
+	{
+		TIndex v = sortedVec[i];
+		if ( survivor != NO_INDEX && veq( positionVec[v], positionVec[survivor], 0.1 ) )
+			mergeVec[v] = survivor;
+		else
+			survivor = v;
 	}
+	for( TIndex e = 0; e < getEdgeCapacity(); ++e )
+		if ( isEdge( e ) && mergeVec[edgeVec[e].endPoint] != NO_INDEX )
+			edgeVec[e].endPoint = mergeVec[edgeVec[e].endPoint];
+	for( size_t i = 0; i < sortedVec.size(); ++i )
+		if ( mergeVec[sortedVec[i]] != NO_INDEX )
+			deleteVertex( sortedVec[i] );
 PR("done" << endl << "Checking for doubled vertices... ")
-	localVList = vList;
-	localVList.sort();
+	sortedVec.clear();
+	for( TIndex v = 0; v < getVertexCapacity(); ++v )
+		if ( isVertex( v ) )
+			sortedVec.push_back( v );
+	sort( sortedVec.begin(), sortedVec.end(), positionLess );
 	dv = 0;
-	for( list<SVertex*>::iterator it = localVList.begin(); it != localVList.end(); ++it )
-	{		
-		list<SVertex*>::iterator su = it; ++su;
-		if ( su != localVList.end() && veq( (*su)->thePosition , (*it)->thePosition, 0.01 ))
+	for( size_t i = 1; i < sortedVec.size(); ++i )
+		if ( veq( positionVec[sortedVec[i]], positionVec[sortedVec[i-1]], 0.01 ) )
 			dv++;
-	}
 PR("found " << dv << " illegal pairs" << endl << "Checking for doubled triangles... ")
-	ulong df = 0; 
-	for( list<SFace*>::iterator it = fList.begin(); it != fList.end(); ++it )
-	{		
-		for( list<SFace*>::iterator ut = it; ut != fList.end(); ++ut )
-		{
-			if ( ut != it )
-			{
-				TVector3D si[3];
-				TVector3D ti[3];
-				si[0] = (*ut)->anEdgePtr->endPointPtr->thePosition;
-				si[1] = (*ut)->anEdgePtr->nextEdgePtr->endPointPtr->thePosition;
-				si[2] = (*ut)->anEdgePtr->nextEdgePtr->nextEdgePtr->endPointPtr->thePosition;
-				ti[0] = (*it)->anEdgePtr->endPointPtr->thePosition;
-				ti[1] = (*it)->anEdgePtr->nextEdgePtr->endPointPtr->thePosition;
-				ti[2] = (*it)->anEdgePtr->nextEdgePtr->nextEdgePtr->endPointPtr->thePosition;
-				if ( ( veq(si[0], ti[0]) && veq(si[1] ,ti[1]) && veq(si[2], ti[2]) )
-					|| ( veq(si[0], ti[1]) && veq(si[1] ,ti[2]) && veq(si[2], ti[0]) )
-					|| ( veq(si[0], ti[2]) && veq(si[1] ,ti[0]) && veq(si[2], ti[1]) ) )
-				{		
-					// We should erase the actual triangle			
-					SFace* f = (*ut); ++ut;
-					SFace* g = (*it);
-					for ( list<SEdge*>::iterator ei = eList.begin(); ei != eList.end(); ++ei )
-						if ( (*ei)->theFacePtr == f )
-							(*ei)->theFacePtr = g;
-					fList.remove(f);
-					//facePool.push_back( f );
-					delete f;
-					df++; --ut;
-					cerr << fList.size() << endl;
-				}					
-			}
-		}			
+	vector<SFaceKey> keyVec;
+	keyVec.reserve( getNumberOfFaces() );
+	for( TIndex f = 0; f < getFaceCapacity(); ++f )
+	{
+		if ( !isFace( f ) )
+			continue;
+		SFaceKey k;
+		TIndex e = faceEdgeVec[f];
+		TIndex corners[3] = { edgeVec[e].endPoint, edgeVec[edgeVec[e].next].endPoint,
+			edgeVec[edgeVec[edgeVec[e].next].next].endPoint };
+		int first = 0;
+		for( int i = 1; i < 3; ++i )
+			if ( corners[i] < corners[first] )
+				first = i;
+		for( int i = 0; i < 3; ++i )
+			k.v[i] = corners[( first + i ) % 3];
+		k.face = f;
+		keyVec.push_back( k );
+	}
+	sort( keyVec.begin(), keyVec.end() );
+	ulong df = 0;
+	for( size_t i = 1; i < keyVec.size(); ++i )
+	{
+		if ( !keyVec[i].sameCorners( keyVec[i-1] ) )
+			continue;
+		// We should erase the actual triangle
+		TIndex f = keyVec[i].face;
+		TIndex g = keyVec[i-1].face;
+		TIndex e = faceEdgeVec[f];
+		for( int j = 0; j < 3; ++j, e = edgeVec[e].next )
+			edgeVec[e].face = g;
+		deleteFace( f );
+		keyVec[i].face = g;
+		df++;
+		cerr << getNumberOfFaces() << endl;
 	}
 PR("found " << df << " illegal triangles" << endl)
 }
 
-/** Do a binning for all vertices and compute repulsion forces */
+/**
+ * Do a binning for all vertices and compute repulsion forces. The bins are
+ * filled by a counting sort into one array, so no memory is allocated after
+ * the first call.
+ */
 void CMesh::computeBins( bool odd, double minDist )
 {
+	const TIndex binCount = 8+8*36+8*256;
+	const double offset = odd ? 8.0 : 0.0;
+	const TIndex vertexCount = getVertexCapacity();
 	// Fill the bins
-	if ( !odd )
+	binStartVec.assign( binCount + 1, 0 );
+	binVertexVec.resize( getNumberOfVertices() );
+	for( int pass = 0; pass < 2; ++pass )
 	{
-		for( list<SVertex*>::iterator it = vList.begin(); it != vList.end(); ++it )
+		for( TIndex v = 0; v < vertexCount; ++v )
 		{
-			int x = static_cast<int>( round( (*it)->thePosition[0] ) ) / 16;
-			int y = static_cast<int>( round( (*it)->thePosition[1] ) ) / 16;
-			int z = static_cast<int>( round( (*it)->thePosition[2] ) ) / 16;
-			if ( x > 8 ) x = 8;
-			if ( y > 8 ) y = 8;
-			if ( z > 8 ) z = 8;
-			bins[x+y*8+z*256].push_back( *it );
-		}
-	}
-	else
-	{
-		for( list<SVertex*>::iterator it = vList.begin(); it != vList.end(); ++it )
-		{
-			int x = static_cast<int>( round( (*it)->thePosition[0] + 8.0 ) ) / 16;
-			int y = static_cast<int>( round( (*it)->thePosition[1] + 8.0 ) ) / 16;
-			int z = static_cast<int>( round( (*it)->thePosition[2] + 8.0 ) ) / 16;
-			if ( x > 8 ) x = 8;
-			if ( y > 8 ) y = 8;
-			if ( z > 8 ) z = 8;
-			bins[x+y*8+z*256].push_back( *it );
+			if ( !isVertex( v ) )
+				continue;
+			int coordinate[3];
+			for( int i = 0; i < 3; ++i )
+			{
+				coordinate[i] = static_cast<int>( round( positionVec[v][i] + offset ) ) / 16;
+				if ( coordinate[i] > 8 ) coordinate[i] = 8;
+				if ( coordinate[i] < 0 ) coordinate[i] = 0;
+			}
+			TIndex bin = coordinate[0] + coordinate[1] * 8 + coordinate[2] * 256;
+			if ( pass == 0 )
+				++binStartVec[bin + 1];
+			else
+				binVertexVec[binStartVec[bin]++] = v;
 		}
+		if ( pass == 0 )
+			for( TIndex bin = 0; bin < binCount; ++bin )
+				binStartVec[bin + 1] += binStartVec[bin];
 	}
+	// The fill pass moved each start to the start of the next bin
+	for( TIndex bin = binCount; bin > 0; --bin )
+		binStartVec[bin] = binStartVec[bin - 1];
+	binStartVec[0] = 0;
+	if ( minDist <= numeric_limits<double>::epsilon() )
+		return;
 	// Check all canditates of each bin against each other
-	for( int i = 0; i < (8+36*8+256*8); ++i )
+	for( TIndex bin = 0; bin < binCount; ++bin )
 	{
-		//cerr << bins[i].size() << " vertices in bin " << i << endl;
-		if ( !bins[i].empty() )
-		for( list<SVertex*>::iterator it = bins[i].begin(); it != bins[i].end(); ++it )
+		for( TIndex i = binStartVec[bin]; i < binStartVec[bin + 1]; ++i )
 		{
-			list<SVertex*>::iterator successor = it; ++successor;
-			for( list<SVertex*>::iterator jt = successor; jt != bins[i].end(); ++jt )
+			TIndex a = binVertexVec[i];
+			for( TIndex j = i + 1; j < binStartVec[bin + 1]; ++j )
 			{
-				TVector3D conn = (*it)->thePosition - (*jt)->thePosition;
+				TIndex b = binVertexVec[j];
+				TVector3D conn = positionVec[a] - positionVec[b];
 				double dDistance = norm( conn );
-				if ( minDist > numeric_limits<double>::epsilon() && dDistance < minDist )
+				if ( dDistance < minDist )
 				{
 					double dFactor = ( minDist - dDistance ) / dDistance;
-					(*it)->theForce += conn * dFactor;
-					(*jt)->theForce += -conn * dFactor;
+					forceVec[a] += conn * dFactor;
+					forceVec[b] -= conn * dFactor;
 				}
 			}
-			
 		}
-		bins[i].clear();
 	}
 }
@@ -20,8 +20,7 @@
 #ifndef MESH_H
 #define MESH_H
 #include <iostream>
-#include <list>
-#include <deque>
+#include <vector>
 #include <meshcomponents.h>
 
 using namespace std;
@@ -31,26 +30,117 @@ using namespace std;
 // void edgeMelt( TMesh& mesh, double length);
 // void computeBins( TMesh& mesh, bool odd = false, double minDist = 1.0 );
 
- typedef list<SFace*> TFList;
- typedef list<SEdge*> TEList;
- typedef list<SVertex*> TVList;
-
+/**
+ * Triangle mesh in half-edge representation. Vertices, half-edges and faces
+ * are addressed by indices into flat arrays, and the vertex attributes are
+ * stored as separate planes indexed by vertex. Deleted elements are put on
+ * free lists and reused by later insertions, so the arrays may contain
+ * holes. Use isVertex(), isEdge() and isFace() to skip them while iterating
+ * up to the respective capacity.
+ *
+ * A vertex stays part of the mesh as long as it has an outgoing half-edge,
+ * so vertices are added together with the first face using them.
+ */
 class CMesh
 {
 public:
-	list<SFace*> fList;
-	list<SVertex*> vList;
-	list<SEdge*> eList;
-	vector<list<SVertex*> > bins;
-	CMesh() : bins(8+8*36+8*256) {}
+	/// Vertex positions
+	vector<TVector3D> positionVec;
+	/// Vertex normals (averaged face normals of adjacent faces)
+	vector<TVector3D> normalVec;
+	/// Actual forces on the vertices
+	vector<TVector3D> forceVec;
+	/// Stability history of the vertices
+	vector<SStability> stabilityVec;
+	CMesh();
 	~CMesh();
+	/// Adds a vertex without any faces
+	TIndex addVertex( const TVector3D& thePosition );
+	/// Adds a face with counter clockwise corners v0, v1, v2
+	TIndex addFace( TIndex v0, TIndex v1, TIndex v2 );
+	/// Makes two half-edges opposing each other
+	void setOpposing( TIndex e0, TIndex e1 );
+	/// Returns the end vertex of a half-edge
+	TIndex getEndPoint( TIndex e ) const
+	{
+		return edgeVec[e].endPoint;
+	}
+	/// Returns the opposing half-edge
+	TIndex getOpposing( TIndex e ) const
+	{
+		return edgeVec[e].opposing;
+	}
+	/// Returns the next half-edge around the face
+	TIndex getNext( TIndex e ) const
+	{
+		return edgeVec[e].next;
+	}
+	/// Returns the face bordered by a half-edge
+	TIndex getFace( TIndex e ) const
+	{
+		return edgeVec[e].face;
+	}
+	/// Returns one of the half-edges emanating from a vertex
+	TIndex getVertexEdge( TIndex v ) const
+	{
+		return vertexEdgeVec[v];
+	}
+	/// Returns one of the half-edges bordering a face
+	TIndex getFaceEdge( TIndex f ) const
+	{
+		return faceEdgeVec[f];
+	}
+	/// Returns the normal of a face
+	const TVector3D& getFaceNormal( TIndex f ) const
+	{
+		return faceNormalVec[f];
+	}
+	bool isVertex( TIndex v ) const
+	{
+		return vertexEdgeVec[v] != NO_INDEX;
+	}
+	bool isEdge( TIndex e ) const
+	{
+		return edgeVec[e].endPoint != NO_INDEX;
+	}
+	bool isFace( TIndex f ) const
+	{
+		return faceEdgeVec[f] != NO_INDEX;
+	}
+	/// Returns the size of the vertex arrays, including holes
+	TIndex getVertexCapacity() const
+	{
+		return vertexEdgeVec.size();
+	}
+	/// Returns the size of the half-edge array, including holes
+	TIndex getEdgeCapacity() const
+	{
+		return edgeVec.size();
+	}
+	/// Returns the size of the face arrays, including holes
+	TIndex getFaceCapacity() const
+	{
+		return faceEdgeVec.size();
+	}
+	ulong getNumberOfVertices() const
+	{
+		return vertexEdgeVec.size() - freeVertexVec.size();
+	}
+	ulong getNumberOfEdges() const
+	{
+		return edgeVec.size() - freeEdgeVec.size();
+	}
+	ulong getNumberOfFaces() const
+	{
+		return faceEdgeVec.size() - freeFaceVec.size();
+	}
 	ulong subdivide(double maxLength );
 	void edgeMelt( double minLength );
 	void edgeFlip( double maxLength );
 	void triangleMelt( double minLength );
-	void printFace( SFace* face );
-	void printVertex( SVertex* vertex );
-	void printEdge( SEdge* edge );
+	void printFace( TIndex f );
+	void printVertex( TIndex v );
+	void printEdge( TIndex e );
 	void printMesh();
 	void computeNormals();
 	void checkTopology();
@@ -59,9 +149,25 @@ public:
 private:	
 	CMesh( const CMesh& aMesh );
 	CMesh& operator=( const CMesh& aMesh );
-	deque<SFace*> facePool;
-	deque<SVertex*> vertexPool;
-	deque<SEdge*> edgePool;
+	TIndex newVertex();
+	TIndex newEdge();
+	TIndex newFace();
+	void deleteVertex( TIndex v );
+	void deleteEdge( TIndex e );
+	void deleteFace( TIndex f );
+	/// Returns the squared length of a half-edge
+	double squaredLength( TIndex e ) const;
+	/// Checks whether collapsing a half-edge keeps the mesh manifold
+	bool isCollapseAllowed( TIndex e ) const;
+	vector<TIndex> vertexEdgeVec;    ///< Outgoing half-edge of each vertex
+	vector<SHalfEdge> edgeVec;       ///< Half-edge connectivity
+	vector<TIndex> faceEdgeVec;      ///< A bordering half-edge of each face
+	vector<TVector3D> faceNormalVec; ///< Face normals
+	vector<TIndex> freeVertexVec;    ///< Deleted vertices
+	vector<TIndex> freeEdgeVec;      ///< Deleted half-edges
+	vector<TIndex> freeFaceVec;      ///< Deleted faces
+	vector<TIndex> binStartVec;      ///< First entry of each bin in binVertexVec
+	vector<TIndex> binVertexVec;     ///< Vertices sorted by bin
 };
 
 #endif
@@ -21,7 +21,6 @@
 #ifndef MESHCOMPONENTS_H
 #define MESHCOMPONENTS_H
 #include <aipsnumeric.h>
-#include <deque>
 
 /*#include <OpenMesh/Core/Mesh/Types/TriMesh_ArrayKernelT.hh>*/
 
@@ -61,90 +60,86 @@ using namespace std;
 // 
 // typedef OpenMesh::TriMesh_ArrayKernelT<TMeshTraits> TMesh;
 
-struct SVertex;
-struct SFace;
+/// Index of a vertex, half-edge or face inside a CMesh
+typedef uint TIndex;
+/// Marks a missing vertex, half-edge or face
+const TIndex NO_INDEX = static_cast<TIndex>( -1 );
 
-struct SEdge
+/** Connectivity of a half-edge. All references are indices into the arrays of the owning mesh */
+struct SHalfEdge
 {
-	SVertex* endPointPtr; // Vertex at the end of the half edge
-	SEdge* opposingEdgePtr; // Adjacent half-edge
-	SFace* theFacePtr; // Face the half-edge borders
-	SEdge* nextEdgePtr; // Next half-edge around the face
-	bool bDelete; // Mark for deletion
-	bool bOld; // Mark that this is an old edge
-	SEdge() 
-		: endPointPtr( NULL ), opposingEdgePtr( NULL ), theFacePtr( NULL ), nextEdgePtr( NULL ),
-			bDelete( false ), bOld( false )
+	TIndex endPoint; ///< Vertex at the end of the half-edge
+	TIndex opposing; ///< Adjacent half-edge
+	TIndex face;     ///< Face the half-edge borders
+	TIndex next;     ///< Next half-edge around the face
+	SHalfEdge()
+		: endPoint( NO_INDEX ), opposing( NO_INDEX ), face( NO_INDEX ), next( NO_INDEX )
 	{
 	}
-	SEdge( SVertex* endPointPtr_, SFace* theFacePtr_, SEdge* nextEdgePtr_ = NULL, SEdge* opposingEdgePtr_ = NULL ) 
-		: endPointPtr( endPointPtr_ ), opposingEdgePtr( opposingEdgePtr_ ), theFacePtr( theFacePtr_ ), 
-			nextEdgePtr( nextEdgePtr_ ), bDelete( false ), bOld( false )
+	void set( TIndex endPoint_, TIndex face_, TIndex next_, TIndex opposing_ = NO_INDEX )
 	{
+		endPoint = endPoint_;
+		face = face_;
+		next = next_;
+		opposing = opposing_;
 	}
-	void set( SVertex* endPointPtr_, SFace* theFacePtr_, SEdge* nextEdgePtr_, SEdge* opposingEdgePtr_ = NULL )
+	void update( TIndex face_, TIndex next_ )
 	{
-		endPointPtr = endPointPtr_; 
-		theFacePtr = theFacePtr_; 
-		nextEdgePtr = nextEdgePtr_; 
-		opposingEdgePtr = opposingEdgePtr_;
-	}
-	void update( SFace* theFacePtr_, SEdge* nextEdgePtr_ )
-	{
-		theFacePtr = theFacePtr_; 
-		nextEdgePtr = nextEdgePtr_;
+		face = face_;
+		next = next_;
 	}
 };
 
-/** A structure to save a surface vertex into */
-struct SVertex
+/**
+ * Stability bookkeeping of a vertex during deformation. The last positions
+ * are kept in a ring buffer of fixed size, so no memory is allocated while
+ * the model iterates.
+ */
+struct SStability
 {
-	TVector3D thePosition; ///< Spatial position of vertex
-	SEdge* anEdgePtr;      ///< One of the half-edges emantating from the vertex
-	ulong ulID; ///< ID number (for backconversion into external formats)
-	TVector3D theForce; ///< Actual force on the vertex
-	TVector3D theNormal; ///< Vertex normal (calculated out of the face normals of adjacent faces)
-	deque<TVector3D> lastPositions;
+	static const uint historySize = 11; ///< Maximum number of positions kept
+	TVector3D positionArr[historySize]; ///< Last positions, oldest at uiFirst
+	uint uiFirst; ///< Slot of the oldest position
+	uint uiSize;  ///< Number of positions kept
 	uint stability;
 	bool isStable;
-	/// Constructor to set the vertex explicitly
-  explicit SVertex( const TVector3D& thePosition_ = 0.0 );
-  void clear()
-  {
-  	isStable = false;
-  	stability = 0;
-  	lastPositions.clear();
-  	theForce = 0.0;
-  	theNormal = 0.0;
-  	anEdgePtr = NULL;
-  	thePosition = 0.0;
-  }
-};
-
-struct SFace
-{
-	SEdge* anEdgePtr; ///< One of the half-edges bordering the face
-	int iTag; ///< A tag for various purposes
-	TVector3D theNormal; ///< Face normal vector
-	/// Constructor to set an half-edge of the face explicitly
-	explicit SFace( SEdge* anEdgePtr_ = NULL );
+	SStability()
+		: uiFirst( 0 ), uiSize( 0 ), stability( 0 ), isStable( false )
+	{
+	}
+	void clear()
+	{
+		uiFirst = 0;
+		uiSize = 0;
+		stability = 0;
+		isStable = false;
+	}
+	uint size() const
+	{
+		return uiSize;
+	}
+	/// Appends a position, dropping the oldest one if the buffer is full
+	void push_back( const TVector3D& aPosition )
+	{
+		if ( uiSize == historySize )
+			pop_front();
+		positionArr[( uiFirst + uiSize ) % historySize] = aPosition;
+		++uiSize;
+	}
+	void pop_front()
+	{
+		uiFirst = ( uiFirst + 1 ) % historySize;
+		--uiSize;
+	}
+	/// Mean of all positions kept, oldest first
+	TVector3D mean() const
+	{
+		TVector3D theMean = 0.0;
+		for( uint i = 0; i < uiSize; ++i )
+			theMean += positionArr[( uiFirst + i ) % historySize];
+		theMean /= static_cast<double>( uiSize );
+		return theMean;
+	}
 };
 
-/* Implementation of inline functions */
-
-/* SVertex */
-
-/** \param position_ starting position of the vertex */
-inline SVertex::SVertex( const TVector3D& thePosition_ ) 
-		: thePosition( thePosition_ ), anEdgePtr( NULL ), ulID( 0 ), theForce ( 0.0 ), theNormal ( 0.0 ), stability(0), isStable(false)
-{
-}
-
-/* SFace */
-
-/** \param anEdge_ one of the half-edges bordering the face */
-inline SFace::SFace( SEdge* anEdgePtr_ ) 
-		: anEdgePtr( anEdgePtr_ ), iTag ( 0 ), theNormal( 0.0 )
-{
-}
 #endif